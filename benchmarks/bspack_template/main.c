@@ -0,0 +1,629 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures how many Clients a
+ * Bootstrap Server bootstraps per second when
+ * their Bootstrap-Packs share the same profile.
+ * It compares the encoding of each Bootstrap-Pack
+ * from scratch with the splicing of the
+ * per-device values in a template.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_server.h"
+#include "iowa_prv_coap_internals.h"
+#include "iowa_prv_data.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_CLIENTS    1000
+#define BENCH_DATAGRAM_SIZE      512
+#define BENCH_PEER_ID_LENGTH     4
+#define BENCH_KEY_LENGTH         16
+
+#define STR_VALUE(S) .value.asBuffer = { sizeof(S) - 1, (uint8_t *)(S) }
+
+// Profile shared by all the devices. The values of the slots are replaced by the per-device ones.
+static iowa_lwm2m_data_t s_profile[] =
+{
+    {0, 0, 0,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING,  STR_VALUE("coaps://lwm2m.example.com:5684")},
+    {0, 0, 1,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_BOOLEAN, .value.asBoolean = false},
+    {0, 0, 2,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 0},
+    {0, 0, 3,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_OPAQUE,  STR_VALUE("")},
+    {0, 0, 5,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_OPAQUE,  STR_VALUE("")},
+    {0, 0, 10, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 1},
+    {0, 0, 11, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 0},
+    {0, 0, 12, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 60},
+    {1, 0, 0,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 1},
+    {1, 0, 1,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 86400},
+    {1, 0, 2,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 300},
+    {1, 0, 3,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 3600},
+    {1, 0, 6,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_BOOLEAN, .value.asBoolean = true},
+    {1, 0, 7,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING,  STR_VALUE("U")},
+};
+
+#define PROFILE_COUNT (sizeof(s_profile) / sizeof(iowa_lwm2m_data_t))
+
+// Indexes in s_profile of the per-device values: PSK identity, PSK and Registration lifetime
+static const size_t s_slotIndexes[] = {3, 4, 9};
+
+#define SLOT_COUNT (sizeof(s_slotIndexes) / sizeof(size_t))
+
+typedef enum
+{
+    MODE_ENCODE,
+    MODE_TEMPLATE
+} bench_mode_t;
+
+typedef struct _datagram_t
+{
+    struct _datagram_t *nextP;
+    size_t              length;
+    uint8_t             buffer[BENCH_DATAGRAM_SIZE];
+} datagram_t;
+
+// A simulated Client
+typedef struct
+{
+    uint32_t    index;
+    uint8_t     peerId[BENCH_PEER_ID_LENGTH];
+    datagram_t *pendingP;      // datagram sent to the Server and not yet read by IOWA
+    uint16_t    messageId;
+    uint8_t     token;
+    char        identity[32];
+    uint8_t     key[BENCH_KEY_LENGTH];
+    bool        isOpen;
+    bool        isFinished;
+} peer_t;
+
+static peer_t *s_peerArray;
+static uint32_t s_peerCount;
+static uint32_t s_finishedCount;
+static uint32_t s_errorCount;
+static bench_mode_t s_mode;
+static iowa_bspack_template_t s_template;
+static uint32_t s_randomState = 0x9E3779B9u;
+
+/*************************************************************************************
+** Helpers
+*************************************************************************************/
+
+static void prv_peerInit(peer_t *peerP,
+                         uint32_t index)
+{
+    uint32_t address;
+    size_t i;
+
+    memset(peerP, 0, sizeof(peer_t));
+    peerP->index = index;
+    peerP->messageId = (uint16_t)(index * 7919);
+    // An IPv4 address in 10.0.0.0/8
+    address = 0x0A000000 + index + 1;
+    peerP->peerId[0] = (uint8_t)(address >> 24);
+    peerP->peerId[1] = (uint8_t)(address >> 16);
+    peerP->peerId[2] = (uint8_t)(address >> 8);
+    peerP->peerId[3] = (uint8_t)address;
+    snprintf(peerP->identity, sizeof(peerP->identity), "urn:imei:35%013u", index);
+    for (i = 0; i < BENCH_KEY_LENGTH; i++)
+    {
+        peerP->key[i] = (uint8_t)(index * 31 + i);
+    }
+}
+
+// Fill the per-device values of a Client, in the order of s_slotIndexes
+static void prv_peerGetValues(peer_t *peerP,
+                              iowa_lwm2m_data_t *valueArray)
+{
+    memset(valueArray, 0, SLOT_COUNT * sizeof(iowa_lwm2m_data_t));
+
+    valueArray[0].type = IOWA_LWM2M_TYPE_OPAQUE;
+    valueArray[0].value.asBuffer.buffer = (uint8_t *)peerP->identity;
+    valueArray[0].value.asBuffer.length = strlen(peerP->identity);
+    valueArray[1].type = IOWA_LWM2M_TYPE_OPAQUE;
+    valueArray[1].value.asBuffer.buffer = peerP->key;
+    valueArray[1].value.asBuffer.length = BENCH_KEY_LENGTH;
+    // Spread the Registration Updates of the devices
+    valueArray[2].type = IOWA_LWM2M_TYPE_INTEGER;
+    valueArray[2].value.asInteger = 86400 + (int64_t)(peerP->index % 3600);
+}
+
+// The whole Bootstrap-Pack of a Client
+static void prv_peerGetData(peer_t *peerP,
+                            iowa_lwm2m_data_t *dataArray)
+{
+    iowa_lwm2m_data_t valueArray[SLOT_COUNT];
+    size_t i;
+
+    prv_peerGetValues(peerP, valueArray);
+
+    memcpy(dataArray, s_profile, sizeof(s_profile));
+    for (i = 0; i < SLOT_COUNT; i++)
+    {
+        dataArray[s_slotIndexes[i]].value = valueArray[i].value;
+    }
+}
+
+/*************************************************************************************
+** Simulated Clients
+*************************************************************************************/
+
+// Send a datagram from a peer to the Server
+static void prv_peerSend(peer_t *peerP,
+                         iowa_coap_message_t *messageP)
+{
+    uint8_t *bufferP;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0
+        || length > BENCH_DATAGRAM_SIZE
+        || peerP->pendingP != NULL)
+    {
+        iowa_system_free(bufferP);
+        s_errorCount++;
+        return;
+    }
+
+    peerP->pendingP = (datagram_t *)malloc(sizeof(datagram_t));
+    peerP->pendingP->length = length;
+    memcpy(peerP->pendingP->buffer, bufferP, length);
+    iowa_system_free(bufferP);
+}
+
+static void prv_peerRequestPack(peer_t *peerP)
+{
+    iowa_coap_message_t *messageP;
+    char query[32];
+
+    snprintf(query, sizeof(query), "ep=bench-%u", peerP->index);
+
+    peerP->token++;
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, 1, &peerP->token);
+    messageP->id = peerP->messageId++;
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, "bspack", '/'));
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, query, '&'));
+
+    prv_peerSend(peerP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+// Check the Bootstrap-Pack against the one encoded from scratch
+static bool prv_peerCheckPack(peer_t *peerP,
+                              iowa_coap_message_t *messageP)
+{
+    iowa_lwm2m_data_t dataArray[PROFILE_COUNT];
+    iowa_content_format_t format;
+    uint8_t *bufferP;
+    size_t length;
+    bool result;
+
+    prv_peerGetData(peerP, dataArray);
+    format = IOWA_CONTENT_FORMAT_SENML_CBOR;
+    if (dataLwm2mSerialize(NULL, dataArray, PROFILE_COUNT, &format, &bufferP, &length) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+
+    result = (messageP->tokenLength == 1
+              && messageP->token[0] == peerP->token
+              && messageP->payload.length == length
+              && memcmp(messageP->payload.data, bufferP, length) == 0);
+
+    iowa_system_free(bufferP);
+
+    return result;
+}
+
+// Handle a datagram sent by the Server to a peer
+static void prv_peerReceive(peer_t *peerP,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_message_t *ackP;
+
+    if (messageDatagramParse(buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        s_errorCount++;
+        return;
+    }
+
+    switch (messageP->code)
+    {
+    case IOWA_COAP_CODE_EMPTY:
+        // Acknowledgement of the Bootstrap-Pack-Request, the Bootstrap-Pack follows
+        break;
+
+    case IOWA_COAP_205_CONTENT:
+        if (prv_peerCheckPack(peerP, messageP) == false)
+        {
+            s_errorCount++;
+        }
+        if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+        {
+            ackP = iowa_coap_message_new(IOWA_COAP_TYPE_ACKNOWLEDGEMENT, IOWA_COAP_CODE_EMPTY, 0, NULL);
+            ackP->id = messageP->id;
+            prv_peerSend(peerP, ackP);
+            iowa_coap_message_free(ackP);
+        }
+        break;
+
+    default:
+        s_errorCount++;
+        break;
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    (void)type;
+    (void)hostname;
+    (void)port;
+    (void)userData;
+
+    // The Bootstrap Server only uses incoming connections
+    return NULL;
+}
+
+// The Server sends to a simulated Client
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)userData;
+
+    prv_peerReceive((peer_t *)connP, buffer, length);
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    peer_t *peerP;
+    datagram_t *datagramP;
+    int result;
+
+    (void)userData;
+
+    peerP = (peer_t *)connP;
+    datagramP = peerP->pendingP;
+    if (datagramP == NULL)
+    {
+        return 0;
+    }
+    peerP->pendingP = NULL;
+
+    if (datagramP->length > length)
+    {
+        result = -1;
+    }
+    else
+    {
+        memcpy(buffer, datagramP->buffer, datagramP->length);
+        result = (int)datagramP->length;
+    }
+    free(datagramP);
+
+    return result;
+}
+
+// The datagrams are already in memory so this function does not block.
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    size_t i;
+    int result;
+
+    (void)timeout;
+    (void)userData;
+
+    result = 0;
+    for (i = 0; i < connCount; i++)
+    {
+        if (((peer_t *)connArray[i])->pendingP == NULL)
+        {
+            connArray[i] = NULL;
+        }
+        else
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    (void)userData;
+
+    ((peer_t *)connP)->isOpen = false;
+}
+
+size_t iowa_system_connection_get_peer_identifier(void *connP,
+                                                  uint8_t *addrP,
+                                                  size_t length,
+                                                  void *userData)
+{
+    (void)userData;
+
+    if (length < BENCH_PEER_ID_LENGTH)
+    {
+        return 0;
+    }
+    memcpy(addrP, ((peer_t *)connP)->peerId, BENCH_PEER_ID_LENGTH);
+
+    return BENCH_PEER_ID_LENGTH;
+}
+
+// xorshift32 generator
+int iowa_system_random_vector_generator(uint8_t *randomBuffer,
+                                        size_t size,
+                                        void *userData)
+{
+    size_t i;
+
+    (void)userData;
+
+    for (i = 0; i < size; i++)
+    {
+        s_randomState ^= s_randomState << 13;
+        s_randomState ^= s_randomState >> 17;
+        s_randomState ^= s_randomState << 5;
+        randomBuffer[i] = (uint8_t)s_randomState;
+    }
+
+    return 0;
+}
+
+/*************************************************************************************
+** Bootstrap Server callbacks
+*************************************************************************************/
+
+static void prv_monitorCallback(const iowa_client_t *clientP,
+                                iowa_state_t state,
+                                void *userData,
+                                iowa_context_t contextP)
+{
+    peer_t *peerP;
+    unsigned int index;
+    iowa_status_t result;
+
+    (void)userData;
+
+    if (sscanf(clientP->name, "bench-%u", &index) != 1
+        || index >= s_peerCount)
+    {
+        s_errorCount++;
+        return;
+    }
+    peerP = s_peerArray + index;
+
+    switch (state)
+    {
+    case IOWA_STATE_BOOTSTRAP_PACK_REQUIRED:
+        if (s_mode == MODE_TEMPLATE)
+        {
+            iowa_lwm2m_data_t valueArray[SLOT_COUNT];
+
+            prv_peerGetValues(peerP, valueArray);
+            result = iowa_bootstrap_server_send_bspack_template(contextP, clientP->id, s_template, SLOT_COUNT, valueArray);
+        }
+        else
+        {
+            iowa_lwm2m_data_t dataArray[PROFILE_COUNT];
+
+            prv_peerGetData(peerP, dataArray);
+            result = iowa_bootstrap_server_send_bspack(contextP, clientP->id, PROFILE_COUNT, dataArray);
+        }
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            s_errorCount++;
+        }
+        break;
+
+    case IOWA_STATE_BOOTSTRAP_FINISHED:
+        peerP->isFinished = true;
+        s_finishedCount++;
+        break;
+
+    default:
+        s_errorCount++;
+        break;
+    }
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+static const char * prv_modeName(bench_mode_t mode)
+{
+    return (mode == MODE_TEMPLATE) ? "Template" : "Encode";
+}
+
+// Mean time in nanoseconds to build a Bootstrap-Pack payload, without the exchanges
+static double prv_measurePayload(bench_mode_t mode,
+                                 size_t *lengthP)
+{
+    iowa_lwm2m_data_t dataArray[PROFILE_COUNT];
+    iowa_lwm2m_data_t valueArray[SLOT_COUNT];
+    data_template_t *templateP;
+    uint64_t start;
+    uint32_t i;
+
+    // The template content is private, this benchmark uses the same internal functions as the API
+    templateP = (data_template_t *)s_template;
+
+    start = bench_now_ns();
+    for (i = 0; i < s_peerCount; i++)
+    {
+        iowa_content_format_t format;
+        uint8_t *bufferP;
+        size_t length;
+
+        if (mode == MODE_TEMPLATE)
+        {
+            prv_peerGetValues(s_peerArray + i, valueArray);
+            (void)dataTemplateSerialize(templateP, valueArray, &bufferP, &length);
+        }
+        else
+        {
+            prv_peerGetData(s_peerArray + i, dataArray);
+            format = IOWA_CONTENT_FORMAT_SENML_CBOR;
+            (void)dataLwm2mSerialize(NULL, dataArray, PROFILE_COUNT, &format, &bufferP, &length);
+        }
+        *lengthP = length;
+        iowa_system_free(bufferP);
+    }
+
+    return (double)(bench_now_ns() - start) / (double)s_peerCount;
+}
+
+// Bootstrap all the Clients through full Bootstrap-Pack-Request exchanges
+static int prv_run(bench_mode_t mode)
+{
+    iowa_context_t contextP;
+    uint64_t start;
+    double elapsedNs;
+    double payloadNs;
+    size_t payloadLength;
+    uint32_t i;
+
+    s_mode = mode;
+    s_finishedCount = 0;
+    s_errorCount = 0;
+    for (i = 0; i < s_peerCount; i++)
+    {
+        prv_peerInit(s_peerArray + i, i);
+    }
+
+    contextP = iowa_init(NULL);
+    if (contextP == NULL
+        || iowa_bootstrap_server_configure(contextP, prv_monitorCallback, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create the Bootstrap Server.\r\n");
+        return -1;
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < s_peerCount; i++)
+    {
+        peer_t *peerP;
+
+        peerP = s_peerArray + i;
+        peerP->isOpen = true;
+        if (iowa_bootstrap_server_new_incoming_connection(contextP, IOWA_CONN_DATAGRAM, peerP, false) != IOWA_COAP_NO_ERROR)
+        {
+            s_errorCount++;
+            continue;
+        }
+        prv_peerRequestPack(peerP);
+
+        // Request, Bootstrap-Pack, acknowledgement and release of the Client
+        while (peerP->isOpen == true
+               && s_errorCount == 0)
+        {
+            if (iowa_step(contextP, 0) != IOWA_COAP_NO_ERROR)
+            {
+                s_errorCount++;
+            }
+        }
+    }
+    elapsedNs = (double)(bench_now_ns() - start);
+
+    iowa_close(contextP);
+
+    payloadNs = prv_measurePayload(mode, &payloadLength);
+
+    fprintf(stdout, "%-10s %8zu %14.1f %16.0f\r\n", prv_modeName(mode), payloadLength, payloadNs, (double)s_finishedCount * 1000000000.0 / elapsedNs);
+
+    if (s_finishedCount != s_peerCount
+        || s_errorCount != 0)
+    {
+        fprintf(stderr, "%s: %u Clients bootstrapped out of %u, %u errors.\r\n", prv_modeName(mode), s_finishedCount, s_peerCount, s_errorCount);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    iowa_lwm2m_uri_t uriArray[SLOT_COUNT];
+    size_t i;
+    int result;
+
+    s_peerCount = BENCH_DEFAULT_CLIENTS;
+    if (argc > 1)
+    {
+        s_peerCount = (uint32_t)bench_get_iterations(argc, argv);
+    }
+    s_peerArray = (peer_t *)calloc(s_peerCount, sizeof(peer_t));
+
+    for (i = 0; i < SLOT_COUNT; i++)
+    {
+        uriArray[i].objectId = s_profile[s_slotIndexes[i]].objectID;
+        uriArray[i].instanceId = s_profile[s_slotIndexes[i]].instanceID;
+        uriArray[i].resourceId = s_profile[s_slotIndexes[i]].resourceID;
+        uriArray[i].resInstanceId = s_profile[s_slotIndexes[i]].resInstanceID;
+    }
+    if (iowa_bootstrap_server_create_bspack_template(PROFILE_COUNT, s_profile, SLOT_COUNT, uriArray, &s_template) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create the Bootstrap-Pack template.\r\n");
+        return 1;
+    }
+
+    fprintf(stdout, "%u Clients, %u Resources per Bootstrap-Pack, %u per-device values.\r\n\n", s_peerCount, (unsigned int)PROFILE_COUNT, (unsigned int)SLOT_COUNT);
+    fprintf(stdout, "%-10s %8s %14s %16s\r\n", "Mode", "Bytes", "Payload (ns)", "Bootstraps/s");
+
+    result = 0;
+    if (prv_run(MODE_ENCODE) != 0)
+    {
+        result = 1;
+    }
+    if (prv_run(MODE_TEMPLATE) != 0)
+    {
+        result = 1;
+    }
+
+    iowa_bootstrap_server_free_bspack_template(s_template);
+    free(s_peerArray);
+
+    return result;
+}
@@ -0,0 +1,1238 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark runs LwM2M Clients built like the
+ * IPSO client sample against a stand-in LwM2M
+ * Server over loopback UDP, without security or
+ * over DTLS with the Mbed TLS 3 security layer of
+ * the secure client sample. It measures the
+ * registration time, the round-trip time of Read
+ * and Write requests, and the throughput and the
+ * CPU time of the notifications of the observed
+ * IPSO Generic Sensors.
+ *
+ * The Clients and the Server run in the same
+ * thread: the program steps the Clients and polls
+ * the Server socket in turn.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+#include "iowa_prv_coap_internals.h"
+
+#ifdef BENCH_DTLS
+// Mbed TLS headers
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/error.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cookie.h"
+#include "mbedtls/timing.h"
+#endif
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#define BENCH_DEFAULT_CLIENTS     100
+#define BENCH_MAX_CLIENTS         500   // the sockets of the samples are monitored with select()
+#define BENCH_DEFAULT_SENSORS     4
+#define BENCH_MAX_SENSORS         16
+#define BENCH_REQUEST_ROUNDS      10
+#define BENCH_NOTIFICATION_ROUNDS 50
+#define BENCH_SERVER_ID           1
+#define BENCH_LIFETIME            300
+#define BENCH_ENDPOINT_PREFIX     "client_e2e_"
+#define BENCH_DATAGRAM_SIZE       2048
+#define BENCH_SOCKET_BUFFER_SIZE  (4 * 1024 * 1024)
+#define BENCH_TIMEOUT_NS          (10 * 1000000000ULL)
+
+#ifdef BENCH_DTLS
+#define BENCH_URI_SCHEME    "coaps"
+#define BENCH_SECURITY_MODE IOWA_SEC_PRE_SHARED_KEY
+#define BENCH_SECURITY_NAME "DTLS with pre-shared key"
+#else
+#define BENCH_URI_SCHEME    "coap"
+#define BENCH_SECURITY_MODE IOWA_SEC_NONE
+#define BENCH_SECURITY_NAME "no security"
+#endif
+
+// The requests of the Server. The token holds the request, the Client index and the sensor index.
+typedef enum
+{
+    REQUEST_OBSERVE = 1,
+    REQUEST_READ,
+    REQUEST_WRITE
+} request_t;
+
+typedef struct _peer_t peer_t;
+
+typedef struct
+{
+    iowa_context_t contextP;
+    iowa_sensor_t  sensorArray[BENCH_MAX_SENSORS];
+    uint32_t       sensorCount;
+    uint32_t       index;
+    peer_t        *peerP;               // the Server side of the connection, known after the Registration
+    uint64_t       startTime;
+    uint64_t       registrationDuration;
+    size_t         isRegistered;        // a counter for prv_runUntil()
+} client_t;
+
+struct _peer_t
+{
+    struct sockaddr_in address;
+    client_t          *clientP;
+#ifdef BENCH_DTLS
+    mbedtls_ssl_context          ssl;
+    mbedtls_timing_delay_context timer;
+    bool                         isConnected;
+    const uint8_t               *inBuffer;      // the datagram being processed
+    size_t                       inLength;
+#endif
+};
+
+typedef struct
+{
+    int      sock;
+    char     uri[48];
+    peer_t  *peerArray;
+    size_t   peerCount;
+    size_t   peerMax;
+    uint16_t messageId;
+    uint64_t requestTime;
+    uint64_t lastRtt;
+    uint8_t  lastCode;
+    size_t   responseCount;
+    size_t   observationCount;
+    size_t   notificationCount;
+    size_t   errorCount;
+#ifdef BENCH_DTLS
+    mbedtls_ssl_config       conf;
+    mbedtls_ssl_cookie_ctx   cookie;
+    mbedtls_entropy_context  entropy;
+    mbedtls_ctr_drbg_context drbg;
+#endif
+} server_t;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+} stats_t;
+
+static server_t s_server;
+static uint16_t s_peerIndex[65536];     // peer index + 1 by source port, all the Clients are on the loopback address
+static client_t *s_clientArray;
+static uint32_t s_clientCount;
+
+#ifdef BENCH_DTLS
+static const unsigned char s_pskKey[] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+static const char s_pskIdentity[] = "IOWA benchmark";
+#endif
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+int32_t iowa_system_gettime(void)
+{
+    return (int32_t)(bench_now_ns() / 1000000000ULL);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+#ifdef BENCH_DTLS
+// Like in the secure client sample, this is not a proper random generator
+int iowa_system_random_vector_generator(uint8_t *randomBuffer,
+                                        size_t size,
+                                        void *userData)
+{
+    size_t i;
+
+    (void)userData;
+
+    for (i = 0; i < size; i++)
+    {
+        randomBuffer[i] = (uint8_t)(rand() % 256);
+    }
+
+    return 0;
+}
+
+// All the Clients share the pre-shared key of the Server. The security layer copies it.
+iowa_status_t iowa_system_security_data(const uint8_t *peerIdentity,
+                                        size_t peerIdentityLen,
+                                        iowa_security_operation_t securityOp,
+                                        iowa_security_data_t *securityDataP,
+                                        void *userDataP)
+{
+    (void)peerIdentity;
+    (void)peerIdentityLen;
+    (void)userDataP;
+
+    if (securityDataP->securityMode != IOWA_SEC_PRE_SHARED_KEY)
+    {
+        return IOWA_COAP_501_NOT_IMPLEMENTED;
+    }
+
+    if (securityOp == IOWA_SEC_READ)
+    {
+        securityDataP->protocol.pskData.identity = (uint8_t *)s_pskIdentity;
+        securityDataP->protocol.pskData.identityLen = sizeof(s_pskIdentity) - 1;
+        securityDataP->protocol.pskData.privateKey = (uint8_t *)s_pskKey;
+        securityDataP->protocol.pskData.privateKeyLen = sizeof(s_pskKey);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
+/*************************************************************************************
+** Stand-in LwM2M Server transport
+*************************************************************************************/
+
+static void prv_serverHandleDatagram(peer_t *peerP,
+                                     uint8_t *buffer,
+                                     size_t length);
+
+static void prv_closeSocket(int sock)
+{
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+static void prv_sendTo(peer_t *peerP,
+                       const uint8_t *buffer,
+                       size_t length)
+{
+    if (sendto(s_server.sock, (const char *)buffer, (int)length, 0, (struct sockaddr *)&(peerP->address), sizeof(peerP->address)) != (int)length)
+    {
+        s_server.errorCount++;
+    }
+}
+
+#ifdef BENCH_DTLS
+static void prv_printError(const char *functionName,
+                           int res)
+{
+    char buffer[128];
+
+    mbedtls_strerror(res, buffer, sizeof(buffer));
+    fprintf(stderr, "%s() failed: -0x%04X (%s).\r\n", functionName, (unsigned int)-res, buffer);
+}
+
+static int prv_peerSend(void *userDataP,
+                        const unsigned char *buffer,
+                        size_t length)
+{
+    prv_sendTo((peer_t *)userDataP, buffer, length);
+
+    return (int)length;
+}
+
+// Provide the datagram being processed, like a non-blocking socket
+static int prv_peerRecv(void *userDataP,
+                        unsigned char *buffer,
+                        size_t length)
+{
+    peer_t *peerP;
+
+    peerP = (peer_t *)userDataP;
+
+    if (peerP->inBuffer == NULL)
+    {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    // Like a datagram socket, an excess data is discarded
+    if (peerP->inLength < length)
+    {
+        length = peerP->inLength;
+    }
+    memcpy(buffer, peerP->inBuffer, length);
+    peerP->inBuffer = NULL;
+    peerP->inLength = 0;
+
+    return (int)length;
+}
+
+// Restart the handshake as a DTLS server does after a HelloVerifyRequest
+static int prv_peerReset(peer_t *peerP)
+{
+    int res;
+
+    res = mbedtls_ssl_session_reset(&(peerP->ssl));
+    if (res == 0)
+    {
+        res = mbedtls_ssl_set_client_transport_id(&(peerP->ssl), (const unsigned char *)&(peerP->address), sizeof(peerP->address));
+    }
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_session_reset", res);
+    }
+
+    return res;
+}
+
+static bool prv_peerInit(peer_t *peerP)
+{
+    int res;
+
+    mbedtls_ssl_init(&(peerP->ssl));
+
+    res = mbedtls_ssl_setup(&(peerP->ssl), &(s_server.conf));
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_setup", res);
+        return false;
+    }
+    mbedtls_ssl_set_bio(&(peerP->ssl), peerP, prv_peerSend, prv_peerRecv, NULL);
+    mbedtls_ssl_set_timer_cb(&(peerP->ssl), &(peerP->timer), mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+
+    return prv_peerReset(peerP) == 0;
+}
+
+static void prv_peerClose(peer_t *peerP)
+{
+    mbedtls_ssl_free(&(peerP->ssl));
+}
+
+static bool prv_serverSecurityInit(void)
+{
+    int res;
+
+    mbedtls_ssl_config_init(&(s_server.conf));
+    mbedtls_ssl_cookie_init(&(s_server.cookie));
+    mbedtls_entropy_init(&(s_server.entropy));
+    mbedtls_ctr_drbg_init(&(s_server.drbg));
+
+    res = mbedtls_ctr_drbg_seed(&(s_server.drbg), mbedtls_entropy_func, &(s_server.entropy), (const unsigned char *)"client_e2e", 10);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ctr_drbg_seed", res);
+        return false;
+    }
+
+    res = mbedtls_ssl_config_defaults(&(s_server.conf), MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_config_defaults", res);
+        return false;
+    }
+    mbedtls_ssl_conf_rng(&(s_server.conf), mbedtls_ctr_drbg_random, &(s_server.drbg));
+
+    res = mbedtls_ssl_conf_psk(&(s_server.conf), s_pskKey, sizeof(s_pskKey), (const unsigned char *)s_pskIdentity, sizeof(s_pskIdentity) - 1);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_conf_psk", res);
+        return false;
+    }
+
+    // Like a LwM2M Server, check the return routability of the Clients with cookies
+    res = mbedtls_ssl_cookie_setup(&(s_server.cookie), mbedtls_ctr_drbg_random, &(s_server.drbg));
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_cookie_setup", res);
+        return false;
+    }
+    mbedtls_ssl_conf_dtls_cookies(&(s_server.conf), mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check, &(s_server.cookie));
+
+    return true;
+}
+
+static void prv_serverSecurityClose(void)
+{
+    mbedtls_ssl_cookie_free(&(s_server.cookie));
+    mbedtls_ssl_config_free(&(s_server.conf));
+    mbedtls_ctr_drbg_free(&(s_server.drbg));
+    mbedtls_entropy_free(&(s_server.entropy));
+}
+#endif
+
+static peer_t * prv_serverGetPeer(const struct sockaddr_in *addressP)
+{
+    uint16_t port;
+    peer_t *peerP;
+
+    port = ntohs(addressP->sin_port);
+    if (s_peerIndex[port] != 0)
+    {
+        return s_server.peerArray + s_peerIndex[port] - 1;
+    }
+
+    if (s_server.peerCount == s_server.peerMax)
+    {
+        return NULL;
+    }
+
+    peerP = s_server.peerArray + s_server.peerCount;
+    memset(peerP, 0, sizeof(peer_t));
+    peerP->address = *addressP;
+#ifdef BENCH_DTLS
+    if (prv_peerInit(peerP) == false)
+    {
+        prv_peerClose(peerP);
+        return NULL;
+    }
+#endif
+    s_server.peerCount++;
+    s_peerIndex[port] = (uint16_t)s_server.peerCount;
+
+    return peerP;
+}
+
+static void prv_serverSendBuffer(peer_t *peerP,
+                                 const uint8_t *buffer,
+                                 size_t length)
+{
+#ifdef BENCH_DTLS
+    int res;
+
+    do
+    {
+        res = mbedtls_ssl_write(&(peerP->ssl), buffer, length);
+    } while (res == MBEDTLS_ERR_SSL_WANT_WRITE);
+    if (res != (int)length)
+    {
+        s_server.errorCount++;
+    }
+#else
+    prv_sendTo(peerP, buffer, length);
+#endif
+}
+
+static void prv_serverReceive(peer_t *peerP,
+                              uint8_t *buffer,
+                              size_t length)
+{
+#ifdef BENCH_DTLS
+    uint8_t plainBuffer[BENCH_DATAGRAM_SIZE];
+    int res;
+
+    peerP->inBuffer = buffer;
+    peerP->inLength = length;
+
+    if (peerP->isConnected == false)
+    {
+        res = mbedtls_ssl_handshake(&(peerP->ssl));
+        if (res == 0)
+        {
+            peerP->isConnected = true;
+        }
+        else if (res == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED)
+        {
+            // The HelloVerifyRequest is sent, the Client restarts with the cookie
+            (void)prv_peerReset(peerP);
+        }
+        else if (res != MBEDTLS_ERR_SSL_WANT_READ
+                 && res != MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            prv_printError("mbedtls_ssl_handshake", res);
+            s_server.errorCount++;
+            (void)prv_peerReset(peerP);
+        }
+    }
+    else
+    {
+        // A datagram may carry several records
+        do
+        {
+            res = mbedtls_ssl_read(&(peerP->ssl), plainBuffer, sizeof(plainBuffer));
+            if (res > 0)
+            {
+                prv_serverHandleDatagram(peerP, plainBuffer, (size_t)res);
+            }
+        } while (res > 0);
+    }
+
+    peerP->inBuffer = NULL;
+    peerP->inLength = 0;
+#else
+    prv_serverHandleDatagram(peerP, buffer, length);
+#endif
+}
+
+// Process all the datagrams waiting on the Server socket
+static void prv_serverPoll(void)
+{
+    uint8_t buffer[BENCH_DATAGRAM_SIZE];
+
+    while (true)
+    {
+        struct timeval tv;
+        fd_set readfds;
+        struct sockaddr_in address;
+        socklen_t addressLength;
+        int length;
+        peer_t *peerP;
+
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+        FD_ZERO(&readfds);
+        FD_SET(s_server.sock, &readfds);
+
+        if (select(s_server.sock + 1, &readfds, NULL, NULL, &tv) <= 0)
+        {
+            return;
+        }
+
+        addressLength = sizeof(address);
+        length = recvfrom(s_server.sock, (char *)buffer, sizeof(buffer), 0, (struct sockaddr *)&address, &addressLength);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        peerP = prv_serverGetPeer(&address);
+        if (peerP == NULL)
+        {
+            s_server.errorCount++;
+            continue;
+        }
+
+        prv_serverReceive(peerP, buffer, (size_t)length);
+    }
+}
+
+static bool prv_serverOpen(size_t peerMax)
+{
+    struct sockaddr_in address;
+    socklen_t addressLength;
+    int size;
+#ifdef _WIN32
+    WSADATA wsaData;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        return false;
+    }
+#endif
+
+    memset(&s_server, 0, sizeof(server_t));
+    memset(s_peerIndex, 0, sizeof(s_peerIndex));
+    s_server.messageId = 1;
+
+    s_server.peerArray = (peer_t *)malloc(peerMax * sizeof(peer_t));
+    if (s_server.peerArray == NULL)
+    {
+        return false;
+    }
+    s_server.peerMax = peerMax;
+
+#ifdef BENCH_DTLS
+    if (prv_serverSecurityInit() == false)
+    {
+        return false;
+    }
+#endif
+
+    s_server.sock = (int)socket(AF_INET, SOCK_DGRAM, 0);
+    if (s_server.sock < 0)
+    {
+        return false;
+    }
+
+    // Absorb the notifications sent by a Client between two polls
+    size = BENCH_SOCKET_BUFFER_SIZE;
+    (void)setsockopt(s_server.sock, SOL_SOCKET, SO_RCVBUF, (const char *)&size, sizeof(size));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    addressLength = sizeof(address);
+
+    if (bind(s_server.sock, (struct sockaddr *)&address, sizeof(address)) != 0
+        || getsockname(s_server.sock, (struct sockaddr *)&address, &addressLength) != 0)
+    {
+        return false;
+    }
+
+    snprintf(s_server.uri, sizeof(s_server.uri), BENCH_URI_SCHEME "://127.0.0.1:%u", ntohs(address.sin_port));
+
+    return true;
+}
+
+static void prv_serverClose(void)
+{
+#ifdef BENCH_DTLS
+    size_t i;
+
+    for (i = 0; i < s_server.peerCount; i++)
+    {
+        prv_peerClose(s_server.peerArray + i);
+    }
+    prv_serverSecurityClose();
+#endif
+
+    if (s_server.sock > 0)
+    {
+        prv_closeSocket(s_server.sock);
+    }
+    free(s_server.peerArray);
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+static void prv_serverSend(peer_t *peerP,
+                           iowa_coap_message_t *messageP)
+{
+    uint8_t *bufferP;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0)
+    {
+        s_server.errorCount++;
+        return;
+    }
+    prv_serverSendBuffer(peerP, bufferP, length);
+    iowa_system_free(bufferP);
+}
+
+// The sensors are the instances 0 to M-1 of the IPSO Generic Sensor Object
+static void prv_serverRequest(client_t *clientP,
+                              request_t request,
+                              uint32_t sensorIndex)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint8_t token[4];
+    char path[32];
+    char value[32];
+
+    token[0] = (uint8_t)request;
+    token[1] = (uint8_t)(clientP->index >> 8);
+    token[2] = (uint8_t)clientP->index;
+    token[3] = (uint8_t)sensorIndex;
+
+    switch (request)
+    {
+    case REQUEST_OBSERVE:
+        messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, sizeof(token), token);
+        optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+        optionP->value.asInteger = 0;
+        iowa_coap_message_add_option(messageP, optionP);
+        snprintf(path, sizeof(path), "3300/%u/5700", sensorIndex);
+        break;
+
+    case REQUEST_READ:
+        messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, sizeof(token), token);
+        snprintf(path, sizeof(path), "3300/%u/5700", sensorIndex);
+        break;
+
+    default:
+        messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_PUT, sizeof(token), token);
+        snprintf(path, sizeof(path), "3300/%u/5750", sensorIndex);
+        break;
+    }
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, path, '/'));
+
+    if (request == REQUEST_WRITE)
+    {
+        // A new Application Type
+        optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+        optionP->value.asInteger = IOWA_CONTENT_FORMAT_TEXT;
+        iowa_coap_message_add_option(messageP, optionP);
+        messageP->payload.length = (size_t)snprintf(value, sizeof(value), "Room %u", s_server.messageId);
+        messageP->payload.data = (uint8_t *)value;
+    }
+    messageP->id = s_server.messageId++;
+
+    s_server.requestTime = bench_now_ns();
+    prv_serverSend(clientP->peerP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+// Registrations and Registration Updates
+static void prv_serverHandleRequest(peer_t *peerP,
+                                    iowa_coap_message_t *requestP)
+{
+    iowa_coap_message_t *responseP;
+    iowa_coap_option_t *optionP;
+    size_t pathCount;
+    char location[16];
+
+    pathCount = 0;
+    for (optionP = requestP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        if (optionP->number == IOWA_COAP_OPTION_URI_PATH)
+        {
+            pathCount++;
+        }
+        else if (optionP->number == IOWA_COAP_OPTION_URI_QUERY
+                 && optionP->length > 3 + sizeof(BENCH_ENDPOINT_PREFIX) - 1
+                 && memcmp(optionP->value.asBuffer, "ep=" BENCH_ENDPOINT_PREFIX, 3 + sizeof(BENCH_ENDPOINT_PREFIX) - 1) == 0)
+        {
+            char name[16];
+            size_t length;
+            unsigned long index;
+
+            length = optionP->length - (3 + sizeof(BENCH_ENDPOINT_PREFIX) - 1);
+            if (length >= sizeof(name))
+            {
+                length = sizeof(name) - 1;
+            }
+            memcpy(name, optionP->value.asBuffer + 3 + sizeof(BENCH_ENDPOINT_PREFIX) - 1, length);
+            name[length] = 0;
+
+            index = strtoul(name, NULL, 10);
+            if (index < s_clientCount)
+            {
+                peerP->clientP = s_clientArray + index;
+                peerP->clientP->peerP = peerP;
+            }
+        }
+    }
+    if (requestP->code != IOWA_COAP_CODE_POST
+        || pathCount == 0
+        || pathCount > 2
+        || peerP->clientP == NULL)
+    {
+        s_server.errorCount++;
+        return;
+    }
+
+    if (pathCount == 1)
+    {
+        responseP = iowa_coap_message_prepare_response(requestP, IOWA_COAP_201_CREATED);
+        snprintf(location, sizeof(location), "rd/%u", peerP->clientP->index);
+        iowa_coap_message_add_option(responseP, iowa_coap_path_to_option(IOWA_COAP_OPTION_LOCATION_PATH, location, '/'));
+    }
+    else
+    {
+        responseP = iowa_coap_message_prepare_response(requestP, IOWA_COAP_204_CHANGED);
+    }
+    prv_serverSend(peerP, responseP);
+    iowa_coap_message_free(responseP);
+}
+
+static void prv_serverHandleDatagram(peer_t *peerP,
+                                     uint8_t *buffer,
+                                     size_t length)
+{
+    iowa_coap_message_t *messageP;
+
+    if (messageDatagramParse(buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        s_server.errorCount++;
+        return;
+    }
+
+    if (messageP->code < IOWA_COAP_201_CREATED)
+    {
+        if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+        {
+            prv_serverHandleRequest(peerP, messageP);
+        }
+        else
+        {
+            s_server.errorCount++;
+        }
+    }
+    else if (messageP->tokenLength != 4)
+    {
+        s_server.errorCount++;
+    }
+    else
+    {
+        switch ((request_t)messageP->token[0])
+        {
+        case REQUEST_OBSERVE:
+            if (messageP->type == IOWA_COAP_TYPE_ACKNOWLEDGEMENT)
+            {
+                // The response to the Observe request
+                if (messageP->code == IOWA_COAP_205_CONTENT)
+                {
+                    s_server.observationCount++;
+                }
+                else
+                {
+                    s_server.errorCount++;
+                }
+            }
+            else
+            {
+                if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+                {
+                    iowa_coap_message_t *ackP;
+
+                    ackP = iowa_coap_message_new(IOWA_COAP_TYPE_ACKNOWLEDGEMENT, IOWA_COAP_CODE_EMPTY, 0, NULL);
+                    ackP->id = messageP->id;
+                    prv_serverSend(peerP, ackP);
+                    iowa_coap_message_free(ackP);
+                }
+                s_server.notificationCount++;
+            }
+            break;
+
+        case REQUEST_READ:
+        case REQUEST_WRITE:
+            s_server.lastRtt = bench_now_ns() - s_server.requestTime;
+            s_server.lastCode = messageP->code;
+            s_server.responseCount++;
+            break;
+
+        default:
+            s_server.errorCount++;
+            break;
+        }
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+/*************************************************************************************
+** IPSO Clients
+*************************************************************************************/
+
+static void prv_eventCallback(iowa_event_t *eventP,
+                              void *userData,
+                              iowa_context_t contextP)
+{
+    client_t *clientP;
+
+    (void)contextP;
+
+    clientP = (client_t *)userData;
+
+    if (eventP->eventType == IOWA_EVENT_REG_REGISTERED
+        && clientP->isRegistered == 0)
+    {
+        clientP->registrationDuration = bench_now_ns() - clientP->startTime;
+        clientP->isRegistered = 1;
+    }
+}
+
+// Same configuration as the IPSO client sample, with Generic Sensors since the
+// Temperature Object has no writable resource
+static bool prv_clientCreate(client_t *clientP,
+                             uint32_t index,
+                             uint32_t sensorCount)
+{
+    iowa_device_info_t devInfo;
+    char name[32];
+
+    clientP->index = index;
+    snprintf(name, sizeof(name), BENCH_ENDPOINT_PREFIX "%u", index);
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "https://ioterop.com";
+    devInfo.modelNumber = "IPSO_client";
+
+    clientP->contextP = iowa_init(clientP);
+    if (clientP->contextP == NULL
+        || iowa_client_configure(clientP->contextP, name, &devInfo, prv_eventCallback) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+
+    for (clientP->sensorCount = 0; clientP->sensorCount < sensorCount; clientP->sensorCount++)
+    {
+        if (iowa_client_IPSO_add_sensor(clientP->contextP, IOWA_IPSO_GENERIC, 20, "Cel", "Test Temperature", -20.0, 50.0, clientP->sensorArray + clientP->sensorCount) != IOWA_COAP_NO_ERROR)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void prv_clientClose(client_t *clientP)
+{
+    uint32_t i;
+
+    if (clientP->contextP == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < clientP->sensorCount; i++)
+    {
+        (void)iowa_client_IPSO_remove_sensor(clientP->contextP, clientP->sensorArray[i]);
+    }
+    (void)iowa_client_remove_server(clientP->contextP, BENCH_SERVER_ID);
+    iowa_close(clientP->contextP);
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+// Step one Client, or all of them when clientP is NULL, and the Server until the counter reaches the target
+static bool prv_runUntil(client_t *clientP,
+                         const size_t *counterP,
+                         size_t target)
+{
+    uint64_t start;
+    uint32_t i;
+
+    start = bench_now_ns();
+    while (*counterP < target)
+    {
+        if (bench_now_ns() - start > BENCH_TIMEOUT_NS)
+        {
+            return false;
+        }
+
+        if (clientP != NULL)
+        {
+            (void)iowa_step(clientP->contextP, 0);
+        }
+        else
+        {
+            for (i = 0; i < s_clientCount; i++)
+            {
+                (void)iowa_step(s_clientArray[i].contextP, 0);
+            }
+        }
+        prv_serverPoll();
+    }
+
+    return true;
+}
+
+static int prv_compare(const void *aP,
+                       const void *bP)
+{
+    uint64_t a;
+    uint64_t b;
+
+    a = *(const uint64_t *)aP;
+    b = *(const uint64_t *)bP;
+
+    return (a > b) - (a < b);
+}
+
+static void prv_computeStats(uint64_t *valueArray,
+                             size_t count,
+                             stats_t *statsP)
+{
+    uint64_t sum;
+    size_t i;
+
+    memset(statsP, 0, sizeof(stats_t));
+    if (count == 0)
+    {
+        return;
+    }
+
+    qsort(valueArray, count, sizeof(uint64_t), prv_compare);
+
+    sum = 0;
+    for (i = 0; i < count; i++)
+    {
+        sum += valueArray[i];
+    }
+
+    statsP->count = count;
+    statsP->mean = sum / count;
+    statsP->p50 = valueArray[(count - 1) * 50 / 100];
+    statsP->p90 = valueArray[(count - 1) * 90 / 100];
+    statsP->p99 = valueArray[(count - 1) * 99 / 100];
+    statsP->max = valueArray[count - 1];
+}
+
+static void prv_printStats(const char *name,
+                           const stats_t *statsP)
+{
+    fprintf(stdout, "%-18s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\r\n",
+            name,
+            (unsigned long long)statsP->count,
+            (double)statsP->mean / 1000.0,
+            (double)statsP->p50 / 1000.0,
+            (double)statsP->p90 / 1000.0,
+            (double)statsP->p99 / 1000.0,
+            (double)statsP->max / 1000.0);
+}
+
+static bool prv_register(uint64_t *durationArray)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_clientCount; i++)
+    {
+        client_t *clientP;
+
+        clientP = s_clientArray + i;
+        clientP->startTime = bench_now_ns();
+        if (iowa_client_add_server(clientP->contextP, BENCH_SERVER_ID, s_server.uri, BENCH_LIFETIME, 0, BENCH_SECURITY_MODE) != IOWA_COAP_NO_ERROR
+            || prv_runUntil(clientP, &(clientP->isRegistered), 1) == false
+            || clientP->peerP == NULL)
+        {
+            fprintf(stderr, "Client %u failed to register.\r\n", i);
+            return false;
+        }
+        durationArray[i] = clientP->registrationDuration;
+    }
+
+    return true;
+}
+
+static bool prv_observe(uint32_t sensorCount)
+{
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < s_clientCount; i++)
+    {
+        for (j = 0; j < sensorCount; j++)
+        {
+            prv_serverRequest(s_clientArray + i, REQUEST_OBSERVE, j);
+        }
+    }
+
+    if (prv_runUntil(NULL, &(s_server.observationCount), (size_t)s_clientCount * sensorCount) == false)
+    {
+        fprintf(stderr, "%u observations out of %u started.\r\n", (unsigned int)s_server.observationCount, s_clientCount * sensorCount);
+        return false;
+    }
+
+    return true;
+}
+
+// The requests are sent one at a time
+static bool prv_request(request_t request,
+                        uint8_t expectedCode,
+                        uint32_t sensorCount,
+                        uint64_t *rttArray)
+{
+    uint32_t round;
+    uint32_t i;
+
+    for (round = 0; round < BENCH_REQUEST_ROUNDS; round++)
+    {
+        for (i = 0; i < s_clientCount; i++)
+        {
+            client_t *clientP;
+
+            clientP = s_clientArray + i;
+            prv_serverRequest(clientP, request, round % sensorCount);
+            if (prv_runUntil(clientP, &(s_server.responseCount), s_server.responseCount + 1) == false
+                || s_server.lastCode != expectedCode)
+            {
+                fprintf(stderr, "Client %u failed to answer a %s request (code %u.%02u).\r\n", i, request == REQUEST_READ ? "Read" : "Write", s_server.lastCode >> 5, s_server.lastCode & 0x1F);
+                return false;
+            }
+            rttArray[round * s_clientCount + i] = s_server.lastRtt;
+        }
+    }
+
+    return true;
+}
+
+// All the sensors change at each round, starting from their initial value of 20
+static bool prv_notify(uint32_t sensorCount,
+                       uint64_t *wallNsP,
+                       uint64_t *cpuNsP)
+{
+    uint64_t wallStart;
+    uint64_t cpuStart;
+    size_t expectedCount;
+    uint32_t round;
+    uint32_t i;
+    uint32_t j;
+
+    expectedCount = (size_t)s_clientCount * sensorCount * BENCH_NOTIFICATION_ROUNDS;
+    s_server.notificationCount = 0;
+
+    wallStart = bench_now_ns();
+    cpuStart = bench_cpu_ns();
+
+    for (round = 0; round < BENCH_NOTIFICATION_ROUNDS; round++)
+    {
+        for (i = 0; i < s_clientCount; i++)
+        {
+            client_t *clientP;
+
+            clientP = s_clientArray + i;
+            for (j = 0; j < sensorCount; j++)
+            {
+                (void)iowa_client_IPSO_update_value(clientP->contextP, clientP->sensorArray[j], (float)(21 + (round + j) % 10));
+            }
+            (void)iowa_step(clientP->contextP, 0);
+            prv_serverPoll();
+        }
+    }
+
+    if (prv_runUntil(NULL, &(s_server.notificationCount), expectedCount) == false)
+    {
+        fprintf(stderr, "%u notifications received out of %u.\r\n", (unsigned int)s_server.notificationCount, (unsigned int)expectedCount);
+        return false;
+    }
+
+    *wallNsP = bench_now_ns() - wallStart;
+    *cpuNsP = bench_cpu_ns() - cpuStart;
+
+    return true;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    int result;
+    uint32_t sensorCount;
+    uint32_t i;
+    uint64_t *valueArray;
+    stats_t stats;
+    uint64_t wallNs;
+    uint64_t cpuNs;
+
+    s_clientCount = BENCH_DEFAULT_CLIENTS;
+    if (argc > 1)
+    {
+        s_clientCount = (uint32_t)bench_get_iterations(argc, argv);
+    }
+    sensorCount = BENCH_DEFAULT_SENSORS;
+    if (argc > 2)
+    {
+        sensorCount = (uint32_t)strtoul(argv[2], NULL, 10);
+    }
+    if (s_clientCount > BENCH_MAX_CLIENTS
+        || sensorCount == 0
+        || sensorCount > BENCH_MAX_SENSORS)
+    {
+        fprintf(stderr, "Usage: %s [clients (1-%u)] [sensors (1-%u)]\r\n", argv[0], BENCH_MAX_CLIENTS, BENCH_MAX_SENSORS);
+        return 1;
+    }
+
+    result = 1;
+    valueArray = (uint64_t *)malloc((size_t)s_clientCount * BENCH_REQUEST_ROUNDS * sizeof(uint64_t));
+    s_clientArray = (client_t *)calloc(s_clientCount, sizeof(client_t));
+    if (valueArray == NULL
+        || s_clientArray == NULL
+        || prv_serverOpen(s_clientCount) == false)
+    {
+        fprintf(stderr, "Failed to start the Server.\r\n");
+        goto exit;
+    }
+
+    for (i = 0; i < s_clientCount; i++)
+    {
+        if (prv_clientCreate(s_clientArray + i, i, sensorCount) == false)
+        {
+            fprintf(stderr, "Failed to create Client %u.\r\n", i);
+            goto exit;
+        }
+    }
+
+    fprintf(stdout, "%u Clients with %u IPSO Generic sensors each, %s, Server at %s.\r\n\n", s_clientCount, sensorCount, BENCH_SECURITY_NAME, s_server.uri);
+    fprintf(stdout, "%-18s %8s %10s %10s %10s %10s %10s\r\n", "Time (us)", "Count", "Mean", "p50", "p90", "p99", "Max");
+
+    if (prv_register(valueArray) == false)
+    {
+        goto exit;
+    }
+    prv_computeStats(valueArray, s_clientCount, &stats);
+    prv_printStats("Registration", &stats);
+
+    if (prv_observe(sensorCount) == false)
+    {
+        goto exit;
+    }
+
+    if (prv_request(REQUEST_READ, IOWA_COAP_205_CONTENT, sensorCount, valueArray) == false)
+    {
+        goto exit;
+    }
+    prv_computeStats(valueArray, (size_t)s_clientCount * BENCH_REQUEST_ROUNDS, &stats);
+    prv_printStats("Read RTT", &stats);
+
+    if (prv_request(REQUEST_WRITE, IOWA_COAP_204_CHANGED, sensorCount, valueArray) == false)
+    {
+        goto exit;
+    }
+    prv_computeStats(valueArray, (size_t)s_clientCount * BENCH_REQUEST_ROUNDS, &stats);
+    prv_printStats("Write RTT", &stats);
+
+    if (prv_notify(sensorCount, &wallNs, &cpuNs) == false)
+    {
+        goto exit;
+    }
+    fprintf(stdout, "\r\n%u notifications in %.3f s: %.0f notifications/s, %.2f us of CPU per notification.\r\n",
+            (unsigned int)s_server.notificationCount,
+            (double)wallNs / 1e9,
+            (double)s_server.notificationCount * 1e9 / (double)wallNs,
+            (double)cpuNs / 1000.0 / (double)s_server.notificationCount);
+
+    if (s_server.errorCount != 0)
+    {
+        fprintf(stderr, "%u unexpected messages or transmission errors.\r\n", (unsigned int)s_server.errorCount);
+        goto exit;
+    }
+
+    result = 0;
+
+exit:
+    if (s_clientArray != NULL)
+    {
+        for (i = 0; i < s_clientCount; i++)
+        {
+            prv_clientClose(s_clientArray + i);
+        }
+        free(s_clientArray);
+    }
+    prv_serverClose();
+    free(valueArray);
+
+    return result;
+}
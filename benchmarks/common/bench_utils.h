@@ -0,0 +1,93 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Helpers shared by the benchmark programs.
+ *
+ **************************************************/
+
+#ifndef _BENCH_UTILS_INCLUDE_
+#define _BENCH_UTILS_INCLUDE_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 100000
+
+// Monotonic clock in nanoseconds
+static inline uint64_t bench_now_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// CPU time consumed by the process in nanoseconds
+static inline uint64_t bench_cpu_ns(void)
+{
+#ifdef _WIN32
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+
+    // FILETIME is in 100 ns units
+    return ((((uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime)
+            + (((uint64_t)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime)) * 100;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// Parse the optional iteration count from the command line
+static inline unsigned long bench_get_iterations(int argc, char *argv[])
+{
+    if (argc > 1)
+    {
+        unsigned long iterations;
+
+        iterations = strtoul(argv[1], NULL, 10);
+        if (iterations != 0)
+        {
+            return iterations;
+        }
+    }
+
+    return BENCH_DEFAULT_ITERATIONS;
+}
+
+#endif // _BENCH_UTILS_INCLUDE_
@@ -0,0 +1,661 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+// IOWA headers
+#include "iowa_platform.h"
+
+// Loopback header
+#include "loopback.h"
+
+// Platform specific headers
+#include <stdlib.h>
+#include <string.h>
+
+// A stand-in peer. The ones created by loopback_connect() have no hostname and are not reachable by iowa_system_connection_open().
+typedef struct _listener_t
+{
+    struct _listener_t          *nextP;
+    char                        *hostname;
+    char                        *port;
+    loopback_receive_callback_t  callback;
+    void                        *userDataP;
+} listener_t;
+
+typedef struct _datagram_t
+{
+    struct _datagram_t  *nextP;
+    uint64_t             deliveryTime;
+    uint64_t             sequence;       // orders the datagrams due at the same time
+    struct _conn_t      *connP;
+    bool                 toListener;
+    size_t               length;
+    uint8_t              buffer[];
+} datagram_t;
+
+// A connection between an IOWA context and a stand-in peer. It is kept until loopback_close() so that the listeners can hold it.
+typedef struct _conn_t
+{
+    struct _conn_t  *nextP;
+    struct _conn_t  *readyNextP;
+    listener_t      *listenerP;
+    void            *userData;
+    bool             isOpen;
+    bool             isReady;
+    datagram_t      *inboxHeadP;     // delivered datagrams not yet read by IOWA
+    datagram_t      *inboxTailP;
+} conn_t;
+
+static uint64_t s_now;
+static uint32_t s_randomState;
+static loopback_link_t s_link;
+static loopback_stats_t s_stats;
+static listener_t *s_listenerList;
+static conn_t *s_connList;
+static conn_t *s_readyHeadP;
+static conn_t *s_readyTailP;
+static datagram_t **s_flightArray;   // datagrams in flight, a binary heap on the delivery time
+static size_t s_flightCount;
+static size_t s_flightSize;
+static uint64_t s_sequence;
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static void prv_freeDatagramList(datagram_t *datagramP)
+{
+    while (datagramP != NULL)
+    {
+        datagram_t *nextP;
+
+        nextP = datagramP->nextP;
+        free(datagramP);
+        datagramP = nextP;
+    }
+}
+
+static char * prv_copyString(const char *string)
+{
+    char *copyP;
+    size_t length;
+
+    length = strlen(string) + 1;
+    copyP = (char *)malloc(length);
+    if (copyP != NULL)
+    {
+        memcpy(copyP, string, length);
+    }
+
+    return copyP;
+}
+
+static bool prv_isBefore(datagram_t *firstP,
+                         datagram_t *secondP)
+{
+    if (firstP->deliveryTime != secondP->deliveryTime)
+    {
+        return firstP->deliveryTime < secondP->deliveryTime;
+    }
+
+    return firstP->sequence < secondP->sequence;
+}
+
+static bool prv_flightPush(datagram_t *datagramP)
+{
+    size_t index;
+
+    if (s_flightCount == s_flightSize)
+    {
+        datagram_t **arrayP;
+        size_t size;
+
+        size = s_flightSize == 0 ? 256 : 2 * s_flightSize;
+        arrayP = (datagram_t **)realloc(s_flightArray, size * sizeof(datagram_t *));
+        if (arrayP == NULL)
+        {
+            return false;
+        }
+        s_flightArray = arrayP;
+        s_flightSize = size;
+    }
+
+    index = s_flightCount;
+    s_flightCount++;
+    while (index > 0
+           && prv_isBefore(datagramP, s_flightArray[(index - 1) / 2]) == true)
+    {
+        s_flightArray[index] = s_flightArray[(index - 1) / 2];
+        index = (index - 1) / 2;
+    }
+    s_flightArray[index] = datagramP;
+
+    return true;
+}
+
+static datagram_t * prv_flightPop(void)
+{
+    datagram_t *resultP;
+    datagram_t *lastP;
+    size_t index;
+
+    resultP = s_flightArray[0];
+    s_flightCount--;
+    lastP = s_flightArray[s_flightCount];
+
+    index = 0;
+    while (2 * index + 1 < s_flightCount)
+    {
+        size_t child;
+
+        child = 2 * index + 1;
+        if (child + 1 < s_flightCount
+            && prv_isBefore(s_flightArray[child + 1], s_flightArray[child]) == true)
+        {
+            child++;
+        }
+        if (prv_isBefore(s_flightArray[child], lastP) == false)
+        {
+            break;
+        }
+        s_flightArray[index] = s_flightArray[child];
+        index = child;
+    }
+    s_flightArray[index] = lastP;
+
+    return resultP;
+}
+
+static void prv_setReady(conn_t *connP)
+{
+    if (connP->isReady == true)
+    {
+        return;
+    }
+
+    connP->isReady = true;
+    connP->readyNextP = NULL;
+    if (s_readyTailP == NULL)
+    {
+        s_readyHeadP = connP;
+    }
+    else
+    {
+        s_readyTailP->readyNextP = connP;
+    }
+    s_readyTailP = connP;
+}
+
+// Apply the link conditions and put the datagram in flight
+static void prv_send(conn_t *connP,
+                     bool toListener,
+                     const uint8_t *buffer,
+                     size_t length)
+{
+    datagram_t *datagramP;
+    uint64_t delay;
+
+    s_stats.sentCount++;
+
+    if (loopback_random() % 100 < s_link.lossPercent)
+    {
+        s_stats.droppedCount++;
+        return;
+    }
+
+    delay = s_link.minDelayUs;
+    if (s_link.maxDelayUs > s_link.minDelayUs)
+    {
+        delay += loopback_random() % (s_link.maxDelayUs - s_link.minDelayUs + 1);
+    }
+    if (loopback_random() % 100 < s_link.reorderPercent)
+    {
+        s_stats.reorderedCount++;
+        delay += s_link.reorderDelayUs;
+    }
+
+    datagramP = (datagram_t *)malloc(sizeof(datagram_t) + length);
+    if (datagramP == NULL)
+    {
+        s_stats.droppedCount++;
+        return;
+    }
+    datagramP->deliveryTime = s_now + delay;
+    datagramP->sequence = s_sequence++;
+    datagramP->connP = connP;
+    datagramP->toListener = toListener;
+    datagramP->length = length;
+    memcpy(datagramP->buffer, buffer, length);
+
+    if (prv_flightPush(datagramP) == false)
+    {
+        s_stats.droppedCount++;
+        free(datagramP);
+    }
+}
+
+static void prv_deliver(datagram_t *datagramP)
+{
+    conn_t *connP;
+
+    connP = datagramP->connP;
+
+    if (connP->isOpen == false)
+    {
+        s_stats.droppedCount++;
+        free(datagramP);
+        return;
+    }
+
+    s_stats.deliveredCount++;
+
+    if (datagramP->toListener == true)
+    {
+        connP->listenerP->callback(connP, datagramP->buffer, datagramP->length, connP->listenerP->userDataP);
+        free(datagramP);
+    }
+    else
+    {
+        datagramP->nextP = NULL;
+        if (connP->inboxTailP == NULL)
+        {
+            connP->inboxHeadP = datagramP;
+        }
+        else
+        {
+            connP->inboxTailP->nextP = datagramP;
+        }
+        connP->inboxTailP = datagramP;
+        prv_setReady(connP);
+    }
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+void loopback_init(uint32_t seed,
+                   const loopback_link_t *linkP)
+{
+    loopback_close();
+
+    s_now = LOOPBACK_EPOCH_US;
+    s_randomState = seed;
+    s_link = *linkP;
+    memset(&s_stats, 0, sizeof(loopback_stats_t));
+}
+
+void loopback_close(void)
+{
+    while (s_listenerList != NULL)
+    {
+        listener_t *listenerP;
+
+        listenerP = s_listenerList;
+        s_listenerList = listenerP->nextP;
+        free(listenerP->hostname);
+        free(listenerP->port);
+        free(listenerP);
+    }
+
+    while (s_connList != NULL)
+    {
+        conn_t *connP;
+
+        connP = s_connList;
+        s_connList = connP->nextP;
+        prv_freeDatagramList(connP->inboxHeadP);
+        free(connP);
+    }
+
+    while (s_flightCount > 0)
+    {
+        s_flightCount--;
+        free(s_flightArray[s_flightCount]);
+    }
+    free(s_flightArray);
+    s_flightArray = NULL;
+    s_flightSize = 0;
+    s_sequence = 0;
+    s_readyHeadP = NULL;
+    s_readyTailP = NULL;
+}
+
+bool loopback_listen(const char *hostname,
+                     const char *port,
+                     loopback_receive_callback_t callback,
+                     void *userDataP)
+{
+    listener_t *listenerP;
+
+    listenerP = (listener_t *)calloc(1, sizeof(listener_t));
+    if (listenerP == NULL)
+    {
+        return false;
+    }
+    listenerP->hostname = prv_copyString(hostname);
+    listenerP->port = prv_copyString(port);
+    if (listenerP->hostname == NULL
+        || listenerP->port == NULL)
+    {
+        free(listenerP->hostname);
+        free(listenerP->port);
+        free(listenerP);
+        return false;
+    }
+    listenerP->callback = callback;
+    listenerP->userDataP = userDataP;
+
+    listenerP->nextP = s_listenerList;
+    s_listenerList = listenerP;
+
+    return true;
+}
+
+void * loopback_connect(void *userData,
+                        loopback_receive_callback_t callback,
+                        void *userDataP)
+{
+    listener_t *listenerP;
+    conn_t *connP;
+
+    listenerP = (listener_t *)calloc(1, sizeof(listener_t));
+    if (listenerP == NULL)
+    {
+        return NULL;
+    }
+    connP = (conn_t *)calloc(1, sizeof(conn_t));
+    if (connP == NULL)
+    {
+        free(listenerP);
+        return NULL;
+    }
+
+    listenerP->callback = callback;
+    listenerP->userDataP = userDataP;
+    listenerP->nextP = s_listenerList;
+    s_listenerList = listenerP;
+
+    connP->listenerP = listenerP;
+    connP->userData = userData;
+    connP->isOpen = true;
+    connP->nextP = s_connList;
+    s_connList = connP;
+
+    return connP;
+}
+
+bool loopback_is_open(void *connP)
+{
+    return ((conn_t *)connP)->isOpen;
+}
+
+void loopback_reply(void *connP,
+                    const uint8_t *buffer,
+                    size_t length)
+{
+    prv_send((conn_t *)connP, false, buffer, length);
+}
+
+void * loopback_get_user_data(void *connP)
+{
+    return ((conn_t *)connP)->userData;
+}
+
+uint64_t loopback_now_us(void)
+{
+    return s_now;
+}
+
+uint64_t loopback_next_delivery_us(void)
+{
+    if (s_flightCount == 0)
+    {
+        return UINT64_MAX;
+    }
+
+    return s_flightArray[0]->deliveryTime;
+}
+
+void loopback_advance(uint64_t timeUs)
+{
+    if (timeUs > s_now)
+    {
+        s_now = timeUs;
+    }
+
+    while (s_flightCount > 0
+           && s_flightArray[0]->deliveryTime <= s_now)
+    {
+        prv_deliver(prv_flightPop());
+    }
+}
+
+void * loopback_take_ready(void)
+{
+    conn_t *connP;
+
+    connP = s_readyHeadP;
+    if (connP == NULL)
+    {
+        return NULL;
+    }
+
+    s_readyHeadP = connP->readyNextP;
+    if (s_readyHeadP == NULL)
+    {
+        s_readyTailP = NULL;
+    }
+    connP->isReady = false;
+
+    return connP->userData;
+}
+
+// xorshift32 generator
+uint32_t loopback_random(void)
+{
+    s_randomState ^= s_randomState << 13;
+    s_randomState ^= s_randomState >> 17;
+    s_randomState ^= s_randomState << 5;
+
+    return s_randomState;
+}
+
+void loopback_get_stats(loopback_stats_t *statsP)
+{
+    *statsP = s_stats;
+}
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+int32_t iowa_system_gettime(void)
+{
+    return (int32_t)(s_now / 1000000);
+}
+
+uint64_t iowa_system_gettime_us(void)
+{
+    return s_now;
+}
+
+int iowa_system_random_vector_generator(uint8_t *randomBuffer,
+                                        size_t size,
+                                        void *userData)
+{
+    size_t i;
+
+    (void)userData;
+
+    for (i = 0; i < size; i++)
+    {
+        randomBuffer[i] = (uint8_t)loopback_random();
+    }
+
+    return 0;
+}
+
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    listener_t *listenerP;
+    conn_t *connP;
+
+    if (type != IOWA_CONN_DATAGRAM)
+    {
+        return NULL;
+    }
+
+    listenerP = s_listenerList;
+    while (listenerP != NULL
+           && (listenerP->hostname == NULL
+               || strcmp(listenerP->hostname, hostname) != 0
+               || strcmp(listenerP->port, port) != 0))
+    {
+        listenerP = listenerP->nextP;
+    }
+    if (listenerP == NULL)
+    {
+        return NULL;
+    }
+
+    connP = (conn_t *)calloc(1, sizeof(conn_t));
+    if (connP == NULL)
+    {
+        return NULL;
+    }
+    connP->listenerP = listenerP;
+    connP->userData = userData;
+    connP->isOpen = true;
+
+    connP->nextP = s_connList;
+    s_connList = connP;
+
+    return connP;
+}
+
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)userData;
+
+    prv_send((conn_t *)connP, true, buffer, length);
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    conn_t *loopConnP;
+    datagram_t *datagramP;
+    int result;
+
+    (void)userData;
+
+    loopConnP = (conn_t *)connP;
+
+    datagramP = loopConnP->inboxHeadP;
+    if (datagramP == NULL)
+    {
+        return 0;
+    }
+    loopConnP->inboxHeadP = datagramP->nextP;
+    if (loopConnP->inboxHeadP == NULL)
+    {
+        loopConnP->inboxTailP = NULL;
+    }
+    else
+    {
+        // Let the program step the context again for the next datagram
+        prv_setReady(loopConnP);
+    }
+
+    if (datagramP->length > length)
+    {
+        result = -1;
+    }
+    else
+    {
+        memcpy(buffer, datagramP->buffer, datagramP->length);
+        result = (int)datagramP->length;
+    }
+    free(datagramP);
+
+    return result;
+}
+
+// The address of the connection identifies the peer.
+size_t iowa_system_connection_get_peer_identifier(void *connP,
+                                                  uint8_t *addrP,
+                                                  size_t length,
+                                                  void *userData)
+{
+    (void)userData;
+
+    if (length < sizeof(connP))
+    {
+        return 0;
+    }
+    memcpy(addrP, &connP, sizeof(connP));
+
+    return sizeof(connP);
+}
+
+// The virtual clock only moves in loopback_advance() so this function never blocks.
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    size_t i;
+    int result;
+
+    (void)timeout;
+    (void)userData;
+
+    result = 0;
+    for (i = 0; i < connCount; i++)
+    {
+        if (((conn_t *)connArray[i])->inboxHeadP == NULL)
+        {
+            connArray[i] = NULL;
+        }
+        else
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    conn_t *loopConnP;
+
+    (void)userData;
+
+    loopConnP = (conn_t *)connP;
+
+    loopConnP->isOpen = false;
+    prv_freeDatagramList(loopConnP->inboxHeadP);
+    loopConnP->inboxHeadP = NULL;
+    loopConnP->inboxTailP = NULL;
+}
@@ -0,0 +1,146 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * In-process implementation of the IOWA connection
+ * functions with a virtual clock.
+ *
+ * The IOWA contexts and the stand-in peers of a
+ * benchmark exchange their datagrams through
+ * memory. The datagrams are delivered when the
+ * program moves the clock forward, after a delay
+ * and possibly lost or reordered according to the
+ * link conditions. The same seed and the same
+ * calls lead to the same exchanges.
+ *
+ * loopback.c implements iowa_system_gettime(),
+ * iowa_system_gettime_us(),
+ * iowa_system_random_vector_generator() and the
+ * iowa_system_connection_*() functions. The
+ * benchmark implements the other platform
+ * functions.
+ *
+ * The connections are opened by the IOWA contexts
+ * with iowa_system_connection_open(), or by the
+ * stand-in peers with loopback_connect() for the
+ * contexts accepting incoming connections.
+ *
+ **************************************************/
+
+#ifndef _LOOPBACK_INCLUDE_
+#define _LOOPBACK_INCLUDE_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The virtual clock value when loopback_init() is called
+#define LOOPBACK_EPOCH_US 1000000ULL
+
+// Conditions applied to each datagram
+typedef struct
+{
+    uint32_t lossPercent;       // probability to drop the datagram
+    uint32_t minDelayUs;        // the one-way delay is drawn between minDelayUs and maxDelayUs
+    uint32_t maxDelayUs;
+    uint32_t reorderPercent;    // probability to hold the datagram back by reorderDelayUs
+    uint32_t reorderDelayUs;
+} loopback_link_t;
+
+typedef struct
+{
+    uint64_t sentCount;
+    uint64_t droppedCount;
+    uint64_t reorderedCount;
+    uint64_t deliveredCount;
+} loopback_stats_t;
+
+// Called when a datagram reaches a listening peer.
+// Parameters:
+// - connP: the connection opened by an IOWA context. Pass it to loopback_reply() to answer.
+// - buffer, length: the datagram.
+// - userDataP: the loopback_listen() parameter.
+typedef void(*loopback_receive_callback_t)(void *connP,
+                                           const uint8_t *buffer,
+                                           size_t length,
+                                           void *userDataP);
+
+// Reset the clock to LOOPBACK_EPOCH_US and drop all the connections and datagrams.
+// Parameters:
+// - seed: seed of the random generator, must not be zero.
+// - linkP: the conditions of the link.
+void loopback_init(uint32_t seed,
+                   const loopback_link_t *linkP);
+
+// Release all the connections and datagrams.
+void loopback_close(void);
+
+// Declare a stand-in peer. The IOWA contexts opening a connection to this hostname and port reach it.
+// Returned value: true in case of success.
+// Parameters:
+// - hostname, port: the address of the peer.
+// - callback: called for each datagram reaching the peer.
+// - userDataP: passed to the callback.
+bool loopback_listen(const char *hostname,
+                     const char *port,
+                     loopback_receive_callback_t callback,
+                     void *userDataP);
+
+// Open a connection from a stand-in peer to an IOWA context, like a peer reaching a listening socket.
+// The program hands the connection to the context, e.g. with iowa_server_new_incoming_connection(), once a
+// datagram sent with loopback_reply() is delivered.
+// Returned value: the connection, or NULL in case of error.
+// Parameters:
+// - userData: the userData given to iowa_init() by the context.
+// - callback: called for each datagram the context sends on this connection.
+// - userDataP: passed to the callback.
+void * loopback_connect(void *userData,
+                        loopback_receive_callback_t callback,
+                        void *userDataP);
+
+// Returned value: false if the IOWA context closed the connection.
+bool loopback_is_open(void *connP);
+
+// Send a datagram from a stand-in peer to an IOWA context.
+// Parameters:
+// - connP: the connection received by the loopback_receive_callback_t.
+// - buffer, length: the datagram.
+void loopback_reply(void *connP,
+                    const uint8_t *buffer,
+                    size_t length);
+
+// Returned value: the userData given to iowa_init() by the context owning the connection.
+void * loopback_get_user_data(void *connP);
+
+// Returned value: the current time of the virtual clock in microseconds.
+uint64_t loopback_now_us(void);
+
+// Returned value: the delivery time of the next datagram in flight, or UINT64_MAX if there is none.
+uint64_t loopback_next_delivery_us(void);
+
+// Move the virtual clock forward and deliver the datagrams due at this time.
+// Datagrams sent by the receive callbacks are delivered too if they are due.
+// Parameters:
+// - timeUs: the new time. Ignored if in the past.
+void loopback_advance(uint64_t timeUs);
+
+// Retrieve a context which has received datagrams since it last read its connections.
+// Returned value: the userData given to iowa_init() by the context, or NULL if there is none.
+void * loopback_take_ready(void);
+
+// Returned value: a pseudo-random number from the seeded generator.
+uint32_t loopback_random(void);
+
+void loopback_get_stats(loopback_stats_t *statsP);
+
+#endif // _LOOPBACK_INCLUDE_
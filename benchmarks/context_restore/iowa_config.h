@@ -0,0 +1,80 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/*********************************************
+*
+* In this file, you can define the compilation
+* flags instead of specifying them on the
+* compiler command-line.
+*
+**********************************************/
+
+#ifndef _IOWA_CONFIG_INCLUDE_
+#define _IOWA_CONFIG_INCLUDE_
+
+/**********************************************
+*
+* Platform configuration.
+*
+**********************************************/
+
+/**********************************************
+* To specify the endianness of your platform.
+* One and only one must be defined.
+*/
+// #define LWM2M_BIG_ENDIAN
+#define LWM2M_LITTLE_ENDIAN
+
+/***********************************************
+* Size of the buffer used to build and receive
+* the CoAP messages.
+*/
+#define IOWA_BUFFER_SIZE 1024
+
+/**********************************************
+* Support of transports.
+*/
+#define IOWA_UDP_SUPPORT
+
+/**********************************************
+*
+* IOWA Logs.
+*
+**********************************************/
+
+/**********************************************
+* Logs are disabled to not disturb the measures.
+*/
+#define IOWA_LOG_LEVEL IOWA_LOG_LEVEL_NONE
+
+/**********************************************
+*
+* LwM2M Stack configuration.
+*
+**********************************************/
+
+/************************************************
+* To specify the role of the LwM2M stack.
+*/
+#define LWM2M_CLIENT_MODE
+
+/**********************************************
+* The context is saved and loaded, from a mapped
+* region when the platform provides one, with the
+* journal of the changes since the snapshot.
+*/
+#define IOWA_STORAGE_CONTEXT_SUPPORT
+#define IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+#define IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+#define IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS 64
+
+#endif
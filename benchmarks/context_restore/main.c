@@ -0,0 +1,608 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the startup time of a
+ * LwM2M Client restoring a context with many
+ * observations. It compares the load of a copy
+ * of the stored context with the load of a
+ * region mapped by the platform, and with the
+ * replay of a context journal. It also checks
+ * that a journal torn by a power loss does not
+ * lose the records appended after it.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_prv_core_internals.h"
+#include "iowa_prv_lwm2m_internals.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_OBSERVATIONS 1000
+#define BENCH_LOAD_COUNT           20
+#define BENCH_SERVER_ID            1
+#define BENCH_SERVER_URI           "coap://lwm2m.example.com:5683"
+#define BENCH_LOCATION             "/rd/5a3f"
+#define BENCH_JOURNAL_RECORDS      (IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS - 1)
+#define BENCH_SNAPSHOT_SESSION     "session of the snapshot"
+#define BENCH_JOURNAL_SESSION      "session of the journal"
+
+typedef enum
+{
+    MODE_COPY,
+    MODE_MAPPED,
+    MODE_JOURNAL
+} bench_mode_t;
+
+static bench_mode_t s_mode;
+static uint8_t *s_storeBuffer;
+static size_t s_storeLength;
+static uint8_t *s_journalBuffer;
+static size_t s_journalLength;
+static uint32_t s_observationCount;
+static uint32_t s_journalFirstIndex;    // the observations from this index have a journaled counter update
+static uint32_t s_tornIndex;            // the observation whose journal record is torn
+static uint32_t s_storeCount;
+static uint32_t s_mapCount;
+static uint32_t s_unmapCount;
+static uint64_t s_allocCount;
+static uint64_t s_allocBytes;
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    s_allocCount++;
+    s_allocBytes += size;
+
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+int32_t iowa_system_gettime(void)
+{
+    return (int32_t)(bench_now_ns() / 1000000000ULL);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+// The benchmark never reaches the Server
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    (void)type;
+    (void)hostname;
+    (void)port;
+    (void)userData;
+
+    return NULL;
+}
+
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)connP;
+    (void)buffer;
+    (void)userData;
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)connP;
+    (void)buffer;
+    (void)length;
+    (void)userData;
+
+    return 0;
+}
+
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    (void)connArray;
+    (void)connCount;
+    (void)timeout;
+    (void)userData;
+
+    return 0;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    (void)connP;
+    (void)userData;
+}
+
+size_t iowa_system_store_context(uint8_t *bufferP,
+                                 size_t length,
+                                 void *userData)
+{
+    (void)userData;
+
+    free(s_storeBuffer);
+    s_storeBuffer = (uint8_t *)malloc(length);
+    if (s_storeBuffer == NULL)
+    {
+        return 0;
+    }
+    memcpy(s_storeBuffer, bufferP, length);
+    s_storeLength = length;
+    s_storeCount++;
+
+    // The journal belongs to the previous context
+    s_journalLength = 0;
+
+    return length;
+}
+
+// Like a read from a file: the stored context is copied in a new buffer
+size_t iowa_system_retrieve_context(uint8_t **bufferP,
+                                    void *userData)
+{
+    (void)userData;
+
+    *bufferP = (uint8_t *)iowa_system_malloc(s_storeLength);
+    if (*bufferP == NULL)
+    {
+        return 0;
+    }
+    memcpy(*bufferP, s_storeBuffer, s_storeLength);
+
+    return s_storeLength;
+}
+
+size_t iowa_system_append_context(uint8_t *bufferP,
+                                  size_t length,
+                                  void *userData)
+{
+    uint8_t *newBufferP;
+
+    (void)userData;
+
+    newBufferP = (uint8_t *)realloc(s_journalBuffer, s_journalLength + length);
+    if (newBufferP == NULL)
+    {
+        return 0;
+    }
+    s_journalBuffer = newBufferP;
+    memcpy(s_journalBuffer + s_journalLength, bufferP, length);
+    s_journalLength += length;
+
+    return length;
+}
+
+// Only the Journal mode replays the journal on top of the stored context
+size_t iowa_system_retrieve_context_journal(uint8_t **bufferP,
+                                            void *userData)
+{
+    (void)userData;
+
+    if (s_mode != MODE_JOURNAL
+        || s_journalLength == 0)
+    {
+        return 0;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(s_journalLength);
+    if (*bufferP == NULL)
+    {
+        return 0;
+    }
+    memcpy(*bufferP, s_journalBuffer, s_journalLength);
+
+    return s_journalLength;
+}
+
+// The stored context is already in memory, like a memory-mapped file or a flash partition
+size_t iowa_system_map_context(const uint8_t **bufferP,
+                               void *userData)
+{
+    (void)userData;
+
+    if (s_mode != MODE_MAPPED)
+    {
+        return 0;
+    }
+
+    s_mapCount++;
+    *bufferP = s_storeBuffer;
+
+    return s_storeLength;
+}
+
+void iowa_system_unmap_context(const uint8_t *bufferP,
+                               size_t length,
+                               void *userData)
+{
+    (void)bufferP;
+    (void)length;
+    (void)userData;
+
+    s_unmapCount++;
+}
+
+/*************************************************************************************
+** Context
+*************************************************************************************/
+
+static iowa_context_t prv_newClient(void)
+{
+    iowa_context_t contextP;
+    iowa_device_info_t devInfo;
+
+    contextP = iowa_init(NULL);
+    if (contextP == NULL)
+    {
+        return NULL;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IoTerop";
+    devInfo.modelNumber = "Benchmark";
+    if (iowa_client_configure(contextP, "urn:uuid:17200d69-ec9b-43b3-9051-73df2207907c", &devInfo, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        iowa_close(contextP);
+        return NULL;
+    }
+
+    return contextP;
+}
+
+// Store the context of a Client registered to a Server observing s_observationCount temperatures.
+// The observations are the ones a Server creates on Observe requests, built in place to not depend on the exchanges.
+// Then journal the notifications of the last observations, as the observe code does.
+static int prv_storeContext(void)
+{
+    iowa_context_t contextP;
+    lwm2m_server_t *serverP;
+    lwm2m_observed_t *observedP;
+    uint32_t i;
+    int result;
+
+    contextP = prv_newClient();
+    if (contextP == NULL
+        || iowa_client_add_server(contextP, BENCH_SERVER_ID, BENCH_SERVER_URI, 86400, 0, IOWA_SEC_NONE) != IOWA_COAP_NO_ERROR)
+    {
+        return -1;
+    }
+
+    serverP = contextP->lwm2mContextP->serverList;
+    serverP->runtime.status = STATE_REG_REGISTERED;
+    serverP->runtime.location = utilsStrdup(BENCH_LOCATION);
+
+    for (i = 0; i < s_observationCount; i++)
+    {
+        observedP = (lwm2m_observed_t *)iowa_system_malloc(sizeof(lwm2m_observed_t));
+        memset(observedP, 0, sizeof(lwm2m_observed_t));
+        observedP->uriInfoP = (lwm2m_observed_uri_info_t *)iowa_system_malloc(sizeof(lwm2m_observed_uri_info_t));
+        memset(observedP->uriInfoP, 0, sizeof(lwm2m_observed_uri_info_t));
+        observedP->uriCount = 1;
+        observedP->uriInfoP[0].uri.objectId = IOWA_IPSO_TEMPERATURE;
+        observedP->uriInfoP[0].uri.instanceId = (uint16_t)i;
+        observedP->uriInfoP[0].uri.resourceId = IOWA_LWM2M_ID_ALL;
+        observedP->uriInfoP[0].uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+        observedP->format = IOWA_CONTENT_FORMAT_SENML_CBOR;
+        observedP->tokenLen = 4;
+        observedP->token[0] = (uint8_t)(i >> 24);
+        observedP->token[1] = (uint8_t)(i >> 16);
+        observedP->token[2] = (uint8_t)(i >> 8);
+        observedP->token[3] = (uint8_t)i;
+        observedP->lastTime = contextP->currentTime - (int32_t)(i % 60);
+        observedP->counter = i * 3;
+
+        observedP->next = serverP->runtime.observedList;
+        serverP->runtime.observedList = observedP;
+    }
+
+    // The DTLS session data the security layer keeps to resume the session with the Server
+    (void)securityResumptionSet(contextP, BENCH_SERVER_URI, (const uint8_t *)BENCH_SNAPSHOT_SESSION, strlen(BENCH_SNAPSHOT_SESSION));
+
+    result = (iowa_save_context_snapshot(contextP) == IOWA_COAP_NO_ERROR) ? 0 : -1;
+
+    // A new session was negotiated after the snapshot
+    (void)securityResumptionSet(contextP, BENCH_SERVER_URI, (const uint8_t *)BENCH_JOURNAL_SESSION, strlen(BENCH_JOURNAL_SESSION));
+
+    // The list starts with the last observation
+    s_journalFirstIndex = s_observationCount;
+    for (observedP = serverP->runtime.observedList; observedP != NULL && s_journalFirstIndex + BENCH_JOURNAL_RECORDS > s_observationCount; observedP = observedP->next)
+    {
+        observedP->counter++;
+        coreContextJournalObservationCounter(contextP, serverP, observedP);
+        s_journalFirstIndex--;
+    }
+
+    iowa_close(contextP);
+
+    return result;
+}
+
+static uint32_t prv_getExpectedCounter(uint32_t index,
+                                       bench_mode_t mode)
+{
+    if (mode == MODE_JOURNAL
+        && index >= s_journalFirstIndex
+        && index != s_tornIndex)
+    {
+        return index * 3 + 1;
+    }
+
+    return index * 3;
+}
+
+// Check the restored context against the stored one
+static bool prv_checkContext(iowa_context_t contextP,
+                             bench_mode_t mode)
+{
+    lwm2m_server_t *serverP;
+    lwm2m_observed_t *observedP;
+    uint32_t count;
+    const char *sessionP;
+    const uint8_t *dataP;
+
+    sessionP = (mode == MODE_JOURNAL) ? BENCH_JOURNAL_SESSION : BENCH_SNAPSHOT_SESSION;
+    if (securityResumptionGet(contextP, BENCH_SERVER_URI, &dataP) != strlen(sessionP)
+        || memcmp(dataP, sessionP, strlen(sessionP)) != 0)
+    {
+        return false;
+    }
+
+    serverP = contextP->lwm2mContextP->serverList;
+    if (serverP == NULL
+        || serverP->next != NULL
+        || strcmp(serverP->uri, BENCH_SERVER_URI) != 0
+        || coreContextIsMapped(contextP, serverP->uri) != (mode == MODE_MAPPED)
+        || serverP->runtime.status != STATE_REG_REGISTERED
+        || serverP->runtime.location == NULL
+        || strcmp(serverP->runtime.location, BENCH_LOCATION) != 0)
+    {
+        return false;
+    }
+
+    count = 0;
+    for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+    {
+        uint32_t index;
+
+        index = ((uint32_t)observedP->token[0] << 24) | ((uint32_t)observedP->token[1] << 16) | ((uint32_t)observedP->token[2] << 8) | observedP->token[3];
+        if (observedP->uriCount != 1
+            || observedP->uriInfoP[0].uri.instanceId != (uint16_t)index
+            || observedP->counter != prv_getExpectedCounter(index, mode))
+        {
+            return false;
+        }
+        count++;
+    }
+
+    return (count == s_observationCount);
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+static const char * prv_modeName(bench_mode_t mode)
+{
+    switch (mode)
+    {
+    case MODE_MAPPED:
+        return "Mapped";
+
+    case MODE_JOURNAL:
+        return "Journal";
+
+    default:
+        return "Copy";
+    }
+}
+
+static int prv_run(bench_mode_t mode)
+{
+    uint64_t elapsedNs;
+    uint64_t allocCount;
+    uint64_t allocBytes;
+    uint32_t errorCount;
+    uint32_t i;
+
+    s_mode = mode;
+    s_mapCount = 0;
+    s_unmapCount = 0;
+    elapsedNs = 0;
+    allocCount = 0;
+    allocBytes = 0;
+    errorCount = 0;
+
+    for (i = 0; i < BENCH_LOAD_COUNT; i++)
+    {
+        iowa_context_t contextP;
+        uint64_t start;
+        iowa_status_t result;
+
+        contextP = prv_newClient();
+        if (contextP == NULL)
+        {
+            errorCount++;
+            continue;
+        }
+
+        s_allocCount = 0;
+        s_allocBytes = 0;
+        start = bench_now_ns();
+        result = iowa_load_context(contextP);
+        elapsedNs += bench_now_ns() - start;
+        allocCount += s_allocCount;
+        allocBytes += s_allocBytes;
+
+        if (result != IOWA_COAP_NO_ERROR
+            || prv_checkContext(contextP, mode) == false)
+        {
+            errorCount++;
+        }
+
+        iowa_close(contextP);
+    }
+
+    fprintf(stdout, "%-8s %12.1f %12.1f %14.0f %16.0f\r\n",
+            prv_modeName(mode),
+            (double)elapsedNs / BENCH_LOAD_COUNT / 1000.0,
+            (double)allocCount / BENCH_LOAD_COUNT,
+            (double)allocBytes / BENCH_LOAD_COUNT,
+            (double)s_observationCount * BENCH_LOAD_COUNT * 1000000000.0 / (double)elapsedNs);
+
+    if (errorCount != 0
+        || s_mapCount != s_unmapCount)
+    {
+        fprintf(stderr, "%s: %u failed loads, %u mappings and %u unmappings.\r\n", prv_modeName(mode), errorCount, s_mapCount, s_unmapCount);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Load a journal whose last record was cut by a power loss, append a record, then load again
+static int prv_checkTornJournal(void)
+{
+    iowa_context_t contextP;
+    lwm2m_server_t *serverP;
+    lwm2m_observed_t *observedP;
+    uint32_t storeCount;
+    bool isValid;
+
+    s_mode = MODE_JOURNAL;
+    s_journalLength -= 2;
+    s_tornIndex = s_journalFirstIndex;
+    storeCount = s_storeCount;
+
+    contextP = prv_newClient();
+    if (contextP == NULL)
+    {
+        return -1;
+    }
+
+    isValid = (iowa_load_context(contextP) == IOWA_COAP_NO_ERROR
+               && prv_checkContext(contextP, MODE_JOURNAL) == true
+               && s_storeCount == storeCount + 1
+               && s_journalLength == 0);
+
+    // The notification of the observation whose record was lost, as the observe code journals it
+    serverP = contextP->lwm2mContextP->serverList;
+    for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+    {
+        if (observedP->counter == s_tornIndex * 3)
+        {
+            observedP->counter++;
+            coreContextJournalObservationCounter(contextP, serverP, observedP);
+        }
+    }
+    iowa_close(contextP);
+
+    s_tornIndex = UINT32_MAX;
+
+    contextP = prv_newClient();
+    if (contextP == NULL)
+    {
+        return -1;
+    }
+
+    isValid = (isValid == true
+               && iowa_load_context(contextP) == IOWA_COAP_NO_ERROR
+               && prv_checkContext(contextP, MODE_JOURNAL) == true);
+    iowa_close(contextP);
+
+    if (isValid == false)
+    {
+        fprintf(stderr, "The record appended after a torn journal was lost.\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    int result;
+
+    s_observationCount = BENCH_DEFAULT_OBSERVATIONS;
+    if (argc > 1)
+    {
+        s_observationCount = (uint32_t)bench_get_iterations(argc, argv);
+    }
+    s_tornIndex = UINT32_MAX;
+
+    if (prv_storeContext() != 0)
+    {
+        fprintf(stderr, "Failed to store the context.\r\n");
+        return 1;
+    }
+
+    fprintf(stdout, "%u observations, context of %zu bytes, journal of %u records and %zu bytes, %u loads per mode.\r\n\n", s_observationCount, s_storeLength, s_observationCount - s_journalFirstIndex + 1, s_journalLength, BENCH_LOAD_COUNT);
+    fprintf(stdout, "%-8s %12s %12s %14s %16s\r\n", "Mode", "Load (us)", "Allocations", "Alloc. bytes", "Observations/s");
+
+    result = 0;
+    if (prv_run(MODE_COPY) != 0)
+    {
+        result = 1;
+    }
+    if (prv_run(MODE_MAPPED) != 0)
+    {
+        result = 1;
+    }
+    if (prv_run(MODE_JOURNAL) != 0)
+    {
+        result = 1;
+    }
+    if (prv_checkTornJournal() != 0)
+    {
+        result = 1;
+    }
+
+    free(s_storeBuffer);
+    free(s_journalBuffer);
+
+    return result;
+}
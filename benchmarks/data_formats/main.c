@@ -0,0 +1,277 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark compares the LwM2M content
+ * formats on a Device object and on IPSO
+ * Temperature sensors: encoded size, encoding
+ * time and decoding time.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_prv_data.h"
+#include "iowa_prv_lwm2m_internals.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <string.h>
+
+#define STR_VALUE(S) .value.asBuffer = { sizeof(S) - 1, (uint8_t *)(S) }
+
+typedef struct
+{
+    const char *name;
+    iowa_lwm2m_uri_t baseUri;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+} payload_t;
+
+typedef struct
+{
+    const char *name;
+    iowa_content_format_t format;
+} format_t;
+
+static iowa_lwm2m_data_t s_deviceData[] =
+{
+    {3, 0, 0,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("IoTerop")},
+    {3, 0, 1,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("IOWA Benchmark")},
+    {3, 0, 2,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("0123456789")},
+    {3, 0, 3,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("1.0.2")},
+    {3, 0, 6,  0,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 1},
+    {3, 0, 6,  1,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 5},
+    {3, 0, 7,  0,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 3800},
+    {3, 0, 7,  1,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 5000},
+    {3, 0, 9,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 87},
+    {3, 0, 10, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 15},
+    {3, 0, 11, 0,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 0},
+    {3, 0, 13, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_TIME, .value.asInteger = 1600000000},
+    {3, 0, 14, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("+01:00")},
+    {3, 0, 15, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("Europe/Paris")},
+    {3, 0, 16, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("U")},
+    {3, 0, 17, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("Sensor")},
+    {3, 0, 21, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 128}
+};
+
+#define IPSO_SENSOR_DATA(I, V)                                                                  \
+    {3303, I, 5700, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = (V)},            \
+    {3303, I, 5601, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = (V) - 2.25},     \
+    {3303, I, 5602, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = (V) + 3.5},      \
+    {3303, I, 5603, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = -40.0},          \
+    {3303, I, 5604, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = 85.0},           \
+    {3303, I, 5701, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("Cel")}
+
+static iowa_lwm2m_data_t s_ipsoData[] =
+{
+    IPSO_SENSOR_DATA(0, 21.37),
+    IPSO_SENSOR_DATA(1, 19.5),
+    IPSO_SENSOR_DATA(2, 23.918),
+    IPSO_SENSOR_DATA(3, -4.125)
+};
+
+static payload_t s_payloads[] =
+{
+    {"Device", {3, 0, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL}, s_deviceData, sizeof(s_deviceData) / sizeof(iowa_lwm2m_data_t)},
+    {"IPSO Temperature x4", {3303, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL}, s_ipsoData, sizeof(s_ipsoData) / sizeof(iowa_lwm2m_data_t)}
+};
+
+static format_t s_formats[] =
+{
+    {"TLV", IOWA_CONTENT_FORMAT_TLV},
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    {"SenML JSON", IOWA_CONTENT_FORMAT_SENML_JSON},
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    {"SenML CBOR", IOWA_CONTENT_FORMAT_SENML_CBOR},
+#endif
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    {"LwM2M CBOR", IOWA_CONTENT_FORMAT_LWM2M_CBOR},
+#endif
+};
+
+// The resource type callback: the expected type is the one of the original data
+static iowa_lwm2m_data_type_t prv_getResourceType(uint16_t objectID,
+                                                  uint16_t resourceID,
+                                                  void *userDataP)
+{
+    payload_t *payloadP;
+    size_t i;
+
+    payloadP = (payload_t *)userDataP;
+
+    for (i = 0; i < payloadP->dataCount; i++)
+    {
+        if (payloadP->dataP[i].objectID == objectID
+            && payloadP->dataP[i].resourceID == resourceID)
+        {
+            return payloadP->dataP[i].type;
+        }
+    }
+
+    return IOWA_LWM2M_TYPE_UNDEFINED;
+}
+
+// Check the decoded data are the original ones
+static int prv_checkData(payload_t *payloadP,
+                         iowa_lwm2m_data_t *dataP,
+                         size_t dataCount)
+{
+    size_t i;
+
+    if (dataCount != payloadP->dataCount)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < dataCount; i++)
+    {
+        iowa_lwm2m_data_t *originalP;
+        size_t j;
+
+        // Some formats reorder the data by URI
+        for (j = 0; j < payloadP->dataCount; j++)
+        {
+            originalP = payloadP->dataP + j;
+            if (dataP[i].objectID == originalP->objectID
+                && dataP[i].instanceID == originalP->instanceID
+                && dataP[i].resourceID == originalP->resourceID
+                && dataP[i].resInstanceID == originalP->resInstanceID)
+            {
+                break;
+            }
+        }
+        if (j == payloadP->dataCount
+            || dataP[i].type != originalP->type)
+        {
+            return -1;
+        }
+
+        switch (originalP->type)
+        {
+        case IOWA_LWM2M_TYPE_STRING:
+            if (dataP[i].value.asBuffer.length != originalP->value.asBuffer.length
+                || memcmp(dataP[i].value.asBuffer.buffer, originalP->value.asBuffer.buffer, originalP->value.asBuffer.length) != 0)
+            {
+                return -1;
+            }
+            break;
+
+        case IOWA_LWM2M_TYPE_FLOAT:
+            // TLV encodes the floating point values in single precision
+            if ((float)dataP[i].value.asFloat != (float)originalP->value.asFloat)
+            {
+                return -1;
+            }
+            break;
+
+        default:
+            if (dataP[i].value.asInteger != originalP->value.asInteger)
+            {
+                return -1;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static int prv_runBenchmark(payload_t *payloadP,
+                            format_t *formatP,
+                            unsigned long iterations)
+{
+    iowa_content_format_t format;
+    uint8_t *bufferP;
+    size_t bufferLength;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    unsigned long i;
+    uint64_t start;
+    double serializeTime;
+    double deserializeTime;
+
+    // Check the format round trip once
+    format = formatP->format;
+    if (dataLwm2mSerialize(&payloadP->baseUri, payloadP->dataP, payloadP->dataCount, &format, &bufferP, &bufferLength) != IOWA_COAP_NO_ERROR
+        || format != formatP->format)
+    {
+        fprintf(stderr, "%s: %s serialization failed.\r\n", payloadP->name, formatP->name);
+        return -1;
+    }
+    if (dataLwm2mDeserialize(&payloadP->baseUri, bufferP, bufferLength, format, &dataP, &dataCount, prv_getResourceType, payloadP) != IOWA_COAP_NO_ERROR
+        || prv_checkData(payloadP, dataP, dataCount) != 0)
+    {
+        fprintf(stderr, "%s: %s round trip failed.\r\n", payloadP->name, formatP->name);
+        iowa_system_free(bufferP);
+        return -1;
+    }
+    dataLwm2mFree(dataCount, dataP);
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        uint8_t *tmpBufferP;
+        size_t tmpBufferLength;
+
+        format = formatP->format;
+        (void)dataLwm2mSerialize(&payloadP->baseUri, payloadP->dataP, payloadP->dataCount, &format, &tmpBufferP, &tmpBufferLength);
+        iowa_system_free(tmpBufferP);
+    }
+    serializeTime = (double)(bench_now_ns() - start) / (double)iterations;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        (void)dataLwm2mDeserialize(&payloadP->baseUri, bufferP, bufferLength, format, &dataP, &dataCount, prv_getResourceType, payloadP);
+        dataLwm2mFree(dataCount, dataP);
+    }
+    deserializeTime = (double)(bench_now_ns() - start) / (double)iterations;
+
+    fprintf(stdout, "%-20s %-12s %8zu %14.1f %14.1f\r\n", payloadP->name, formatP->name, bufferLength, serializeTime, deserializeTime);
+
+    iowa_system_free(bufferP);
+
+    return 0;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    unsigned long iterations;
+    size_t payloadIndex;
+    size_t formatIndex;
+    int result;
+
+    iterations = bench_get_iterations(argc, argv);
+
+    fprintf(stdout, "%lu iterations per measure.\r\n\n", iterations);
+    fprintf(stdout, "%-20s %-12s %8s %14s %14s\r\n", "Payload", "Format", "Bytes", "Encode (ns)", "Decode (ns)");
+
+    result = 0;
+    for (payloadIndex = 0; payloadIndex < sizeof(s_payloads) / sizeof(payload_t); payloadIndex++)
+    {
+        for (formatIndex = 0; formatIndex < sizeof(s_formats) / sizeof(format_t); formatIndex++)
+        {
+            if (prv_runBenchmark(s_payloads + payloadIndex, s_formats + formatIndex, iterations) != 0)
+            {
+                result = 1;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,641 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark compares a full DTLS handshake
+ * with an abbreviated one resuming a previous
+ * session, either by Session ID or by Session
+ * Ticket. The Client saves and restores its
+ * session like the security layer of the secure
+ * client sample does on reconnection.
+ *
+ * The Client and the Server run in the same
+ * process and exchange their datagrams through
+ * memory queues.
+ *
+ **************************************************/
+
+// Mbed TLS headers
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/error.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_cookie.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/timing.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DTLS_DEFAULT_ITERATIONS 200
+
+#define DATAGRAM_MAX_SIZE     4096
+#define QUEUE_SIZE            16
+#define HANDSHAKE_MAX_LOOPS   64
+#define SESSION_MAX_SIZE      2048
+
+#define CLIENT_TRANSPORT_ID   "127.0.0.1:56830"
+
+typedef enum
+{
+    HANDSHAKE_FULL = 0,
+    HANDSHAKE_SESSION_ID,
+    HANDSHAKE_SESSION_TICKET
+} handshake_mode_t;
+
+typedef struct
+{
+    size_t        length;
+    unsigned char data[DATAGRAM_MAX_SIZE];
+} datagram_t;
+
+typedef struct
+{
+    datagram_t datagrams[QUEUE_SIZE];
+    size_t     head;
+    size_t     count;
+} queue_t;
+
+typedef struct
+{
+    queue_t *inQueueP;
+    queue_t *outQueueP;
+    int      id;
+} endpoint_t;
+
+typedef struct
+{
+    int    lastSender;
+    size_t flights;
+    size_t datagrams;
+    size_t bytes;
+} link_stats_t;
+
+typedef struct
+{
+    const char      *name;
+    const int       *ciphersuites;
+    handshake_mode_t mode;
+} scenario_t;
+
+static const int s_pskCiphersuites[] =
+{
+    MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,
+    0
+};
+
+static const int s_ecdhePskCiphersuites[] =
+{
+    MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256,
+    0
+};
+
+static const scenario_t s_scenarios[] =
+{
+    {"PSK-AES128-CCM8",        s_pskCiphersuites,      HANDSHAKE_FULL},
+    {"PSK-AES128-CCM8",        s_pskCiphersuites,      HANDSHAKE_SESSION_ID},
+    {"PSK-AES128-CCM8",        s_pskCiphersuites,      HANDSHAKE_SESSION_TICKET},
+    {"ECDHE-PSK-AES128-SHA256", s_ecdhePskCiphersuites, HANDSHAKE_FULL},
+    {"ECDHE-PSK-AES128-SHA256", s_ecdhePskCiphersuites, HANDSHAKE_SESSION_ID},
+    {"ECDHE-PSK-AES128-SHA256", s_ecdhePskCiphersuites, HANDSHAKE_SESSION_TICKET}
+};
+
+static const unsigned char s_pskKey[] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+static const char s_pskIdentity[] = "IOWA benchmark";
+
+static mbedtls_entropy_context s_entropy;
+static mbedtls_ctr_drbg_context s_drbg;
+
+static queue_t s_clientToServer;
+static queue_t s_serverToClient;
+static link_stats_t s_stats;
+static unsigned long s_resumedCount;
+
+static const char *prv_modeToString(handshake_mode_t mode)
+{
+    switch (mode)
+    {
+    case HANDSHAKE_SESSION_ID:
+        return "Session ID";
+
+    case HANDSHAKE_SESSION_TICKET:
+        return "Ticket";
+
+    default:
+        return "Full";
+    }
+}
+
+static void prv_printError(const char *functionName,
+                           int res)
+{
+    char buffer[128];
+
+    mbedtls_strerror(res, buffer, sizeof(buffer));
+    fprintf(stderr, "%s() failed: -0x%04X (%s).\r\n", functionName, (unsigned int)-res, buffer);
+}
+
+static int prv_send(void *userDataP,
+                    const unsigned char *buffer,
+                    size_t length)
+{
+    endpoint_t *endpointP;
+    datagram_t *datagramP;
+
+    endpointP = (endpoint_t *)userDataP;
+
+    if (length > DATAGRAM_MAX_SIZE
+        || endpointP->outQueueP->count == QUEUE_SIZE)
+    {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+
+    datagramP = endpointP->outQueueP->datagrams + (endpointP->outQueueP->head + endpointP->outQueueP->count) % QUEUE_SIZE;
+    memcpy(datagramP->data, buffer, length);
+    datagramP->length = length;
+    endpointP->outQueueP->count++;
+
+    if (s_stats.lastSender != endpointP->id)
+    {
+        s_stats.flights++;
+        s_stats.lastSender = endpointP->id;
+    }
+    s_stats.datagrams++;
+    s_stats.bytes += length;
+
+    return (int)length;
+}
+
+static int prv_recv(void *userDataP,
+                    unsigned char *buffer,
+                    size_t length)
+{
+    endpoint_t *endpointP;
+    datagram_t *datagramP;
+
+    endpointP = (endpoint_t *)userDataP;
+
+    if (endpointP->inQueueP->count == 0)
+    {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    datagramP = endpointP->inQueueP->datagrams + endpointP->inQueueP->head;
+    endpointP->inQueueP->head = (endpointP->inQueueP->head + 1) % QUEUE_SIZE;
+    endpointP->inQueueP->count--;
+
+    // Like a datagram socket, an excess data is discarded
+    if (datagramP->length < length)
+    {
+        length = datagramP->length;
+    }
+    memcpy(buffer, datagramP->data, length);
+
+    return (int)length;
+}
+
+// Server session cache counting the resumed sessions
+static int prv_cacheGet(void *data,
+                        unsigned char const *sessionId,
+                        size_t sessionIdLength,
+                        mbedtls_ssl_session *sessionP)
+{
+    int res;
+
+    res = mbedtls_ssl_cache_get(data, sessionId, sessionIdLength, sessionP);
+    if (res == 0)
+    {
+        s_resumedCount++;
+    }
+
+    return res;
+}
+
+// Server session ticket parser counting the resumed sessions
+static int prv_ticketParse(void *ticketP,
+                           mbedtls_ssl_session *sessionP,
+                           unsigned char *buffer,
+                           size_t length)
+{
+    int res;
+
+    res = mbedtls_ssl_ticket_parse(ticketP, sessionP, buffer, length);
+    if (res == 0)
+    {
+        s_resumedCount++;
+    }
+
+    return res;
+}
+
+static int prv_setupConfig(mbedtls_ssl_config *confP,
+                           int endpoint,
+                           const int *ciphersuites)
+{
+    int res;
+
+    res = mbedtls_ssl_config_defaults(confP, endpoint, MBEDTLS_SSL_TRANSPORT_DATAGRAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_config_defaults", res);
+        return res;
+    }
+
+    mbedtls_ssl_conf_rng(confP, mbedtls_ctr_drbg_random, &s_drbg);
+    mbedtls_ssl_conf_ciphersuites(confP, ciphersuites);
+
+    res = mbedtls_ssl_conf_psk(confP, s_pskKey, sizeof(s_pskKey), (const unsigned char *)s_pskIdentity, sizeof(s_pskIdentity) - 1);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_conf_psk", res);
+    }
+
+    return res;
+}
+
+// Restart the server side as a DTLS server does for each new client
+static int prv_resetServer(mbedtls_ssl_context *serverP)
+{
+    int res;
+
+    res = mbedtls_ssl_session_reset(serverP);
+    if (res == 0)
+    {
+        res = mbedtls_ssl_set_client_transport_id(serverP, (const unsigned char *)CLIENT_TRANSPORT_ID, sizeof(CLIENT_TRANSPORT_ID) - 1);
+    }
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_session_reset", res);
+    }
+
+    return res;
+}
+
+static int prv_handshake(mbedtls_ssl_context *clientP,
+                         mbedtls_ssl_context *serverP,
+                         uint64_t *clientTimeP,
+                         uint64_t *serverTimeP)
+{
+    bool clientDone;
+    bool serverDone;
+    int loop;
+
+    clientDone = false;
+    serverDone = false;
+
+    for (loop = 0; loop < HANDSHAKE_MAX_LOOPS && (clientDone == false || serverDone == false); loop++)
+    {
+        uint64_t start;
+        int res;
+
+        if (clientDone == false)
+        {
+            start = bench_now_ns();
+            res = mbedtls_ssl_handshake(clientP);
+            *clientTimeP += bench_now_ns() - start;
+
+            if (res == 0)
+            {
+                clientDone = true;
+            }
+            else if (res != MBEDTLS_ERR_SSL_WANT_READ
+                     && res != MBEDTLS_ERR_SSL_WANT_WRITE)
+            {
+                prv_printError("mbedtls_ssl_handshake (client)", res);
+                return -1;
+            }
+        }
+
+        if (serverDone == false)
+        {
+            start = bench_now_ns();
+            res = mbedtls_ssl_handshake(serverP);
+            if (res == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED)
+            {
+                res = prv_resetServer(serverP);
+                if (res == 0)
+                {
+                    res = MBEDTLS_ERR_SSL_WANT_READ;
+                }
+            }
+            *serverTimeP += bench_now_ns() - start;
+
+            if (res == 0)
+            {
+                serverDone = true;
+            }
+            else if (res != MBEDTLS_ERR_SSL_WANT_READ
+                     && res != MBEDTLS_ERR_SSL_WANT_WRITE)
+            {
+                prv_printError("mbedtls_ssl_handshake (server)", res);
+                return -1;
+            }
+        }
+    }
+
+    if (clientDone == false
+        || serverDone == false)
+    {
+        fprintf(stderr, "Handshake did not complete.\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// Same operations as the security layer once the handshake is over
+static int prv_saveSession(mbedtls_ssl_context *clientP,
+                           unsigned char *buffer,
+                           size_t *lengthP)
+{
+    mbedtls_ssl_session session;
+    int res;
+
+    mbedtls_ssl_session_init(&session);
+
+    res = mbedtls_ssl_get_session(clientP, &session);
+    if (res == 0)
+    {
+        res = mbedtls_ssl_session_save(&session, buffer, SESSION_MAX_SIZE, lengthP);
+    }
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_session_save", res);
+    }
+
+    mbedtls_ssl_session_free(&session);
+
+    return res;
+}
+
+// Same operations as the security layer before starting the handshake
+static int prv_loadSession(mbedtls_ssl_context *clientP,
+                           const unsigned char *buffer,
+                           size_t length)
+{
+    mbedtls_ssl_session session;
+    int res;
+
+    mbedtls_ssl_session_init(&session);
+
+    res = mbedtls_ssl_session_load(&session, buffer, length);
+    if (res == 0)
+    {
+        res = mbedtls_ssl_set_session(clientP, &session);
+    }
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_set_session", res);
+    }
+
+    mbedtls_ssl_session_free(&session);
+
+    return res;
+}
+
+static int prv_runBenchmark(const scenario_t *scenarioP,
+                            unsigned long iterations)
+{
+    mbedtls_ssl_config clientConf;
+    mbedtls_ssl_config serverConf;
+    mbedtls_ssl_context client;
+    mbedtls_ssl_context server;
+    mbedtls_timing_delay_context clientTimer;
+    mbedtls_timing_delay_context serverTimer;
+    mbedtls_ssl_cookie_ctx cookie;
+    mbedtls_ssl_cache_context cache;
+    mbedtls_ssl_ticket_context ticket;
+    endpoint_t clientEndpoint;
+    endpoint_t serverEndpoint;
+    unsigned char sessionData[SESSION_MAX_SIZE];
+    size_t sessionLength;
+    uint64_t clientTime;
+    uint64_t serverTime;
+    uint64_t wallStart;
+    uint64_t cpuStart;
+    double wallTime;
+    double cpuTime;
+    unsigned long i;
+    int result;
+    int res;
+
+    result = -1;
+
+    mbedtls_ssl_config_init(&clientConf);
+    mbedtls_ssl_config_init(&serverConf);
+    mbedtls_ssl_init(&client);
+    mbedtls_ssl_init(&server);
+    mbedtls_ssl_cookie_init(&cookie);
+    mbedtls_ssl_cache_init(&cache);
+    mbedtls_ssl_ticket_init(&ticket);
+
+    memset(&s_clientToServer, 0, sizeof(queue_t));
+    memset(&s_serverToClient, 0, sizeof(queue_t));
+    clientEndpoint.inQueueP = &s_serverToClient;
+    clientEndpoint.outQueueP = &s_clientToServer;
+    clientEndpoint.id = 0;
+    serverEndpoint.inQueueP = &s_clientToServer;
+    serverEndpoint.outQueueP = &s_serverToClient;
+    serverEndpoint.id = 1;
+
+    if (prv_setupConfig(&clientConf, MBEDTLS_SSL_IS_CLIENT, scenarioP->ciphersuites) != 0
+        || prv_setupConfig(&serverConf, MBEDTLS_SSL_IS_SERVER, scenarioP->ciphersuites) != 0)
+    {
+        goto exit;
+    }
+
+    res = mbedtls_ssl_cookie_setup(&cookie, mbedtls_ctr_drbg_random, &s_drbg);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_cookie_setup", res);
+        goto exit;
+    }
+    mbedtls_ssl_conf_dtls_cookies(&serverConf, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check, &cookie);
+
+    switch (scenarioP->mode)
+    {
+    case HANDSHAKE_SESSION_ID:
+        mbedtls_ssl_conf_session_tickets(&clientConf, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+        mbedtls_ssl_conf_session_cache(&serverConf, &cache, prv_cacheGet, mbedtls_ssl_cache_set);
+        break;
+
+    case HANDSHAKE_SESSION_TICKET:
+        res = mbedtls_ssl_ticket_setup(&ticket, mbedtls_ctr_drbg_random, &s_drbg, MBEDTLS_CIPHER_AES_128_GCM, 86400);
+        if (res != 0)
+        {
+            prv_printError("mbedtls_ssl_ticket_setup", res);
+            goto exit;
+        }
+        mbedtls_ssl_conf_session_tickets(&clientConf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+        mbedtls_ssl_conf_session_tickets_cb(&serverConf, mbedtls_ssl_ticket_write, prv_ticketParse, &ticket);
+        break;
+
+    default:
+        mbedtls_ssl_conf_session_tickets(&clientConf, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+        break;
+    }
+
+    res = mbedtls_ssl_setup(&client, &clientConf);
+    if (res == 0)
+    {
+        res = mbedtls_ssl_setup(&server, &serverConf);
+    }
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ssl_setup", res);
+        goto exit;
+    }
+
+    mbedtls_ssl_set_bio(&client, &clientEndpoint, prv_send, prv_recv, NULL);
+    mbedtls_ssl_set_bio(&server, &serverEndpoint, prv_send, prv_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&client, &clientTimer, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+    mbedtls_ssl_set_timer_cb(&server, &serverTimer, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+
+    // The first connection is always a full handshake providing the session to resume
+    clientTime = 0;
+    serverTime = 0;
+    if (prv_resetServer(&server) != 0
+        || prv_handshake(&client, &server, &clientTime, &serverTime) != 0
+        || prv_saveSession(&client, sessionData, &sessionLength) != 0)
+    {
+        goto exit;
+    }
+
+    clientTime = 0;
+    serverTime = 0;
+    s_resumedCount = 0;
+    wallStart = bench_now_ns();
+    cpuStart = bench_cpu_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        uint64_t start;
+
+        memset(&s_stats, 0, sizeof(link_stats_t));
+        s_stats.lastSender = -1;
+        s_clientToServer.count = 0;
+        s_serverToClient.count = 0;
+
+        start = bench_now_ns();
+        res = mbedtls_ssl_session_reset(&client);
+        if (res == 0
+            && scenarioP->mode != HANDSHAKE_FULL)
+        {
+            res = prv_loadSession(&client, sessionData, sessionLength);
+        }
+        clientTime += bench_now_ns() - start;
+        if (res != 0
+            || prv_resetServer(&server) != 0)
+        {
+            goto exit;
+        }
+
+        if (prv_handshake(&client, &server, &clientTime, &serverTime) != 0)
+        {
+            goto exit;
+        }
+
+        start = bench_now_ns();
+        res = prv_saveSession(&client, sessionData, &sessionLength);
+        clientTime += bench_now_ns() - start;
+        if (res != 0)
+        {
+            goto exit;
+        }
+    }
+    wallTime = (double)(bench_now_ns() - wallStart) / (double)iterations / 1000.0;
+    cpuTime = (double)(bench_cpu_ns() - cpuStart) / (double)iterations / 1000.0;
+
+    fprintf(stdout, "%-24s %-11s %7zu %9zu %6zu %7.0f%% %11.1f %11.1f %11.1f %11.1f\r\n",
+            scenarioP->name, prv_modeToString(scenarioP->mode),
+            s_stats.flights, s_stats.datagrams, s_stats.bytes,
+            100.0 * (double)s_resumedCount / (double)iterations,
+            (double)clientTime / (double)iterations / 1000.0,
+            (double)serverTime / (double)iterations / 1000.0,
+            wallTime, cpuTime);
+
+    result = 0;
+    if (scenarioP->mode != HANDSHAKE_FULL
+        && s_resumedCount != iterations)
+    {
+        fprintf(stderr, "%s: %lu of %lu handshakes were not abbreviated.\r\n", scenarioP->name, iterations - s_resumedCount, iterations);
+        result = -1;
+    }
+
+exit:
+    mbedtls_ssl_free(&client);
+    mbedtls_ssl_free(&server);
+    mbedtls_ssl_config_free(&clientConf);
+    mbedtls_ssl_config_free(&serverConf);
+    mbedtls_ssl_cookie_free(&cookie);
+    mbedtls_ssl_cache_free(&cache);
+    mbedtls_ssl_ticket_free(&ticket);
+
+    if (result != 0)
+    {
+        fprintf(stderr, "%s %s: benchmark failed.\r\n", scenarioP->name, prv_modeToString(scenarioP->mode));
+    }
+
+    return result;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    unsigned long iterations;
+    size_t scenarioIndex;
+    int result;
+    int res;
+
+    if (argc > 1)
+    {
+        iterations = bench_get_iterations(argc, argv);
+    }
+    else
+    {
+        iterations = DTLS_DEFAULT_ITERATIONS;
+    }
+
+    mbedtls_entropy_init(&s_entropy);
+    mbedtls_ctr_drbg_init(&s_drbg);
+
+    res = mbedtls_ctr_drbg_seed(&s_drbg, mbedtls_entropy_func, &s_entropy, (const unsigned char *)"dtls_resumption", 15);
+    if (res != 0)
+    {
+        prv_printError("mbedtls_ctr_drbg_seed", res);
+        return 1;
+    }
+
+    fprintf(stdout, "%lu reconnections per measure. Times are per reconnection.\r\n\n", iterations);
+    fprintf(stdout, "%-24s %-11s %7s %9s %6s %8s %11s %11s %11s %11s\r\n",
+            "Ciphersuite", "Handshake", "Flights", "Datagrams", "Bytes", "Resumed", "Client (us)", "Server (us)", "Wall (us)", "CPU (us)");
+
+    result = 0;
+    for (scenarioIndex = 0; scenarioIndex < sizeof(s_scenarios) / sizeof(scenario_t); scenarioIndex++)
+    {
+        if (prv_runBenchmark(s_scenarios + scenarioIndex, iterations) != 0)
+        {
+            result = 1;
+        }
+    }
+
+    mbedtls_ctr_drbg_free(&s_drbg);
+    mbedtls_entropy_free(&s_entropy);
+
+    return result;
+}
@@ -0,0 +1,316 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark checks and measures the float
+ * to text conversions used by the text and JSON
+ * content formats, on random doubles:
+ * - the text reads back to the same double,
+ * - the text is parsed like the C library does,
+ * - the text is as short as possible,
+ * and compares their speed with the C library.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_prv_data.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEXT_SIZE           DATA_FLOAT_STRING_MAX_LENGTH
+#define LONG_TEXT_SIZE      1200
+#define SAMPLE_COUNT        4096
+#define MAX_DIGIT_COUNT     17
+
+typedef enum
+{
+    SAMPLE_RANDOM_BITS = 0,
+    SAMPLE_SENSOR_VALUES
+} sample_kind_t;
+
+static uint64_t s_randomState = 88172645463325252ULL;
+
+// xorshift64: reproducible across platforms
+static uint64_t prv_random(void)
+{
+    s_randomState ^= s_randomState << 13;
+    s_randomState ^= s_randomState >> 7;
+    s_randomState ^= s_randomState << 17;
+
+    return s_randomState;
+}
+
+static double prv_bitsToDouble(uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static uint64_t prv_doubleToBits(double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+// A random finite double
+static double prv_randomDouble(sample_kind_t kind)
+{
+    if (kind == SAMPLE_SENSOR_VALUES)
+    {
+        // Values with up to three decimals, as reported by most sensors
+        return (double)((int64_t)(prv_random() % 2000001) - 1000000) / 1000.0;
+    }
+
+    return prv_bitsToDouble(prv_random() & 0xFFEFFFFFFFFFFFFFULL);
+}
+
+// Number of significant digits of the shortest text reading back to value
+static int prv_getShortestDigitCount(double value)
+{
+    char text[TEXT_SIZE];
+    int precision;
+
+    for (precision = 1; precision < MAX_DIGIT_COUNT; precision++)
+    {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, NULL) == value)
+        {
+            return precision;
+        }
+    }
+
+    return MAX_DIGIT_COUNT;
+}
+
+// Number of significant digits of a text, trailing zeros excluded
+static int prv_getDigitCount(const char *text)
+{
+    int count;
+    int lastNonZero;
+
+    count = 0;
+    lastNonZero = 0;
+    while (*text != 0
+           && *text != 'e')
+    {
+        if (*text >= '1' && *text <= '9')
+        {
+            count++;
+            lastNonZero = count;
+        }
+        else if (*text == '0' && count != 0)
+        {
+            count++;
+        }
+        text++;
+    }
+
+    return lastNonZero;
+}
+
+// Check the conversions on random values
+// Returned value: the number of errors.
+static unsigned long prv_checkConversions(sample_kind_t kind,
+                                          unsigned long iterations,
+                                          unsigned long *notShortestP)
+{
+    unsigned long errors;
+    unsigned long i;
+
+    errors = 0;
+    for (i = 0; i < iterations; i++)
+    {
+        double value;
+        double result;
+        uint8_t text[TEXT_SIZE + 1];
+        size_t length;
+        bool withExponent;
+        char reference[TEXT_SIZE];
+
+        value = prv_randomDouble(kind);
+        withExponent = (i % 2 == 0);
+
+        // Formatting
+        length = dataUtilsFloatToBuffer(value, text, TEXT_SIZE, withExponent);
+        if (length == 0
+            || length != dataUtilsFloatToBufferLength(value, withExponent))
+        {
+            fprintf(stderr, "Length mismatch for %.17g.\r\n", value);
+            errors++;
+            continue;
+        }
+        text[length] = 0;
+
+        if (dataUtilsBufferToFloat(text, length, &result) != 1
+            || prv_doubleToBits(result) != prv_doubleToBits(value)
+            || strtod((char *)text, NULL) != value)
+        {
+            fprintf(stderr, "Round trip failed for %.17g: \"%s\".\r\n", value, text);
+            errors++;
+        }
+
+        if (prv_getDigitCount((char *)text) > prv_getShortestDigitCount(value))
+        {
+            fprintf(stderr, "Text \"%s\" is not the shortest one for %.17g.\r\n", text, value);
+            *notShortestP += 1;
+            errors++;
+        }
+
+        // Parsing of a text with a random precision. The values rounded beyond the double range are rejected.
+        snprintf(reference, sizeof(reference), "%.*e", (int)(prv_random() % 25), prv_randomDouble(kind));
+        value = strtod(reference, NULL);
+        if (value > DBL_MAX
+            || value < -DBL_MAX)
+        {
+            if (dataUtilsBufferToFloat((uint8_t *)reference, strlen(reference), &result) != 0)
+            {
+                fprintf(stderr, "Parsing of \"%s\" did not fail.\r\n", reference);
+                errors++;
+            }
+        }
+        else if (dataUtilsBufferToFloat((uint8_t *)reference, strlen(reference), &result) != 1
+                 || prv_doubleToBits(result) != prv_doubleToBits(value))
+        {
+            fprintf(stderr, "Parsing of \"%s\" failed.\r\n", reference);
+            errors++;
+        }
+
+#if LDBL_MANT_DIG >= 64
+        // Parsing of the exact decimal expansion of a halfway point between two doubles
+        if (i % 64 == 0)
+        {
+            char halfWay[LONG_TEXT_SIZE];
+            double next;
+
+            value = prv_randomDouble(kind);
+            if (value < 0)
+            {
+                value = -value;
+            }
+            next = prv_bitsToDouble(prv_doubleToBits(value) + 1);
+            snprintf(halfWay, sizeof(halfWay), "%.800Le", ((long double)value + (long double)next) / 2);
+            if (dataUtilsBufferToFloat((uint8_t *)halfWay, strlen(halfWay), &result) != 1
+                || prv_doubleToBits(result) != prv_doubleToBits(strtod(halfWay, NULL)))
+            {
+                fprintf(stderr, "Parsing of the halfway point after %.17g failed.\r\n", value);
+                errors++;
+            }
+        }
+#endif
+    }
+
+    return errors;
+}
+
+// Measure the mean time of the conversions
+static void prv_measureConversions(const char *name,
+                                   sample_kind_t kind,
+                                   unsigned long iterations)
+{
+    static double values[SAMPLE_COUNT];
+    static char texts[SAMPLE_COUNT][TEXT_SIZE];
+    static size_t lengths[SAMPLE_COUNT];
+    unsigned long i;
+    uint64_t start;
+    double formatTime;
+    double referenceFormatTime;
+    double parseTime;
+    double referenceParseTime;
+    volatile size_t sink;
+    volatile double valueSink;
+
+    for (i = 0; i < SAMPLE_COUNT; i++)
+    {
+        values[i] = prv_randomDouble(kind);
+        lengths[i] = dataUtilsFloatToBuffer(values[i], (uint8_t *)texts[i], TEXT_SIZE - 1, false);
+        texts[i][lengths[i]] = 0;
+    }
+
+    sink = 0;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        uint8_t text[TEXT_SIZE];
+
+        sink += dataUtilsFloatToBuffer(values[i % SAMPLE_COUNT], text, TEXT_SIZE, false);
+    }
+    formatTime = (double)(bench_now_ns() - start) / (double)iterations;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        char text[TEXT_SIZE];
+
+        sink += (size_t)snprintf(text, sizeof(text), "%.17g", values[i % SAMPLE_COUNT]);
+    }
+    referenceFormatTime = (double)(bench_now_ns() - start) / (double)iterations;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        double value;
+
+        sink += dataUtilsBufferToFloat((uint8_t *)texts[i % SAMPLE_COUNT], lengths[i % SAMPLE_COUNT], &value);
+        valueSink = value;
+    }
+    parseTime = (double)(bench_now_ns() - start) / (double)iterations;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        valueSink = strtod(texts[i % SAMPLE_COUNT], NULL);
+    }
+    referenceParseTime = (double)(bench_now_ns() - start) / (double)iterations;
+
+    (void)sink;
+    (void)valueSink;
+
+    fprintf(stdout, "%-16s %14.1f %14.1f %14.1f %14.1f\r\n", name, formatTime, referenceFormatTime, parseTime, referenceParseTime);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    unsigned long iterations;
+    unsigned long errors;
+    unsigned long notShortest;
+    unsigned long checkCount;
+
+    iterations = bench_get_iterations(argc, argv);
+    checkCount = iterations;
+
+    notShortest = 0;
+    errors = prv_checkConversions(SAMPLE_RANDOM_BITS, checkCount, &notShortest);
+    errors += prv_checkConversions(SAMPLE_SENSOR_VALUES, checkCount, &notShortest);
+
+    fprintf(stdout, "%lu random values checked: %lu errors, %lu texts longer than the shortest one.\r\n\n", 2 * checkCount, errors, notShortest);
+
+    fprintf(stdout, "%lu iterations per measure.\r\n\n", iterations);
+    fprintf(stdout, "%-16s %14s %14s %14s %14s\r\n", "Values", "Format (ns)", "snprintf (ns)", "Parse (ns)", "strtod (ns)");
+    prv_measureConversions("Random bits", SAMPLE_RANDOM_BITS, iterations);
+    prv_measureConversions("Sensor values", SAMPLE_SENSOR_VALUES, iterations);
+
+    return (errors == 0) ? 0 : 1;
+}
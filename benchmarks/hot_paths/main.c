@@ -0,0 +1,722 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the functions on the
+ * path of every LwM2M message: CoAP datagram and
+ * option parsing and serialization, TLV and text
+ * encoding, float formatting, URI decoding and
+ * Object reading. Each function is called on
+ * representative payloads and the time and the
+ * allocations per call are reported in JSON to
+ * be compared between builds.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+#include "iowa_prv_coap_internals.h"
+#include "iowa_prv_data_internals.h"
+#include "iowa_prv_lwm2m_internals.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#define BENCH_SENSOR_COUNT 10
+
+#define STR_VALUE(S) .value.asBuffer = { sizeof(S) - 1, (uint8_t *)(S) }
+
+// A measured operation. Each call releases what it produced.
+// Returned value: true in case of success.
+typedef bool(*bench_op_t)(void *argP);
+
+typedef struct
+{
+    uint8_t *buffer;
+    size_t length;
+    iowa_coap_message_t *messageP;
+} coap_arg_t;
+
+typedef struct
+{
+    iowa_coap_option_t *optionList;
+    uint8_t *buffer;
+    size_t length;
+} option_arg_t;
+
+typedef struct
+{
+    iowa_lwm2m_uri_t baseUri;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    uint8_t *buffer;
+    size_t length;
+} data_arg_t;
+
+typedef struct
+{
+    double value;
+    bool withExponent;
+} float_arg_t;
+
+typedef struct
+{
+    iowa_context_t contextP;
+    iowa_lwm2m_uri_t uri;
+} read_arg_t;
+
+static uint64_t s_allocCount;
+static uint64_t s_allocBytes;
+static bool s_isFirstResult;
+static iowa_sensor_t s_sensorArray[BENCH_SENSOR_COUNT];
+static size_t s_sensorCount;
+
+static const char s_registrationQuery[] = "ep=urn:imei:358240051111110&lt=300&lwm2m=1.1&b=U";
+static const char s_registrationLinks[] = "</>;rt=\"oma.lwm2m\";ct=11543,</1/0>,</3/0>,</3303/0>,</3303/1>,</3303/2>,</3303/3>,"
+                                          "</3303/4>,</3303/5>,</3303/6>,</3303/7>,</3303/8>,</3303/9>";
+static uint8_t s_token[] = { 0x5A, 0x3F, 0x10, 0xC2, 0x77, 0x08, 0x91, 0xE4 };
+
+static iowa_lwm2m_data_t s_deviceData[] =
+{
+    {3, 0, 0,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("IoTerop")},
+    {3, 0, 1,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("IOWA Benchmark")},
+    {3, 0, 2,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("0123456789")},
+    {3, 0, 3,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("1.0.2")},
+    {3, 0, 6,  0,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 1},
+    {3, 0, 6,  1,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 5},
+    {3, 0, 7,  0,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 3800},
+    {3, 0, 7,  1,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 5000},
+    {3, 0, 9,  IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 87},
+    {3, 0, 10, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 15},
+    {3, 0, 11, 0,                 IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 0},
+    {3, 0, 13, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_TIME, .value.asInteger = 1600000000},
+    {3, 0, 14, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("+01:00")},
+    {3, 0, 15, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("Europe/Paris")},
+    {3, 0, 16, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("U")},
+    {3, 0, 17, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("Sensor")},
+    {3, 0, 21, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, .value.asInteger = 128}
+};
+
+#define IPSO_SENSOR_DATA(I, V)                                                                  \
+    {3303, I, 5700, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = (V)},            \
+    {3303, I, 5601, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = (V) - 2.25},     \
+    {3303, I, 5602, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = (V) + 3.5},      \
+    {3303, I, 5603, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = -40.0},          \
+    {3303, I, 5604, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = 85.0},           \
+    {3303, I, 5701, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING, STR_VALUE("Cel")}
+
+static iowa_lwm2m_data_t s_ipsoData[] =
+{
+    IPSO_SENSOR_DATA(0, 21.37),
+    IPSO_SENSOR_DATA(1, 19.5),
+    IPSO_SENSOR_DATA(2, 23.918),
+    IPSO_SENSOR_DATA(3, -4.125)
+};
+
+// The payload of a notification of the Sensor Value
+static iowa_lwm2m_data_t s_sensorValue = {3303, 0, 5700, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT, .value.asFloat = 21.37};
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    s_allocCount++;
+    s_allocBytes += size;
+
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+int32_t iowa_system_gettime(void)
+{
+    return (int32_t)(bench_now_ns() / 1000000000ULL);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+// The benchmark never reaches a Server
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    (void)type;
+    (void)hostname;
+    (void)port;
+    (void)userData;
+
+    return NULL;
+}
+
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)connP;
+    (void)buffer;
+    (void)userData;
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)connP;
+    (void)buffer;
+    (void)length;
+    (void)userData;
+
+    return 0;
+}
+
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    (void)connArray;
+    (void)connCount;
+    (void)timeout;
+    (void)userData;
+
+    return 0;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    (void)connP;
+    (void)userData;
+}
+
+/*************************************************************************************
+** Measured operations
+*************************************************************************************/
+
+static bool prv_datagramParse(void *argP)
+{
+    coap_arg_t *coapP;
+    iowa_coap_message_t *messageP;
+
+    coapP = (coap_arg_t *)argP;
+
+    if (messageDatagramParse(coapP->buffer, coapP->length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+    iowa_coap_message_free(messageP);
+
+    return true;
+}
+
+static bool prv_datagramSerialize(void *argP)
+{
+    coap_arg_t *coapP;
+    uint8_t *buffer;
+    size_t length;
+
+    coapP = (coap_arg_t *)argP;
+
+    length = coapMessageSerializeDatagram(coapP->messageP, &buffer);
+    if (length != coapP->length)
+    {
+        return false;
+    }
+    iowa_system_free(buffer);
+
+    return true;
+}
+
+static bool prv_optionParse(void *argP)
+{
+    option_arg_t *optionArgP;
+    iowa_coap_option_t *optionList;
+    size_t length;
+
+    optionArgP = (option_arg_t *)argP;
+    optionList = NULL;
+
+    if (option_parse(optionArgP->buffer, optionArgP->length, &optionList, &length, iowa_coap_option_is_integer) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+    iowa_coap_option_free(optionList);
+
+    return length == optionArgP->length;
+}
+
+static bool prv_optionSerialize(void *argP)
+{
+    option_arg_t *optionArgP;
+    uint8_t buffer[IOWA_BUFFER_SIZE];
+
+    optionArgP = (option_arg_t *)argP;
+
+    return option_serialize(optionArgP->optionList, buffer, iowa_coap_option_is_integer) == optionArgP->length;
+}
+
+static bool prv_tlvSerialize(void *argP)
+{
+    data_arg_t *dataArgP;
+    uint8_t *buffer;
+    size_t length;
+
+    dataArgP = (data_arg_t *)argP;
+
+    if (tlvSerialize(&(dataArgP->baseUri), dataArgP->dataP, dataArgP->dataCount, &buffer, &length) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+    iowa_system_free(buffer);
+
+    return length == dataArgP->length;
+}
+
+static bool prv_tlvDeserialize(void *argP)
+{
+    data_arg_t *dataArgP;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+
+    dataArgP = (data_arg_t *)argP;
+
+    if (tlvDeserialize(&(dataArgP->baseUri), dataArgP->buffer, dataArgP->length, &dataP, &dataCount) != IOWA_COAP_NO_ERROR)
+    {
+        if (dataP != NULL)
+        {
+            dataLwm2mFree(dataCount, dataP);
+        }
+        return false;
+    }
+    dataLwm2mFree(dataCount, dataP);
+
+    return dataCount == dataArgP->dataCount;
+}
+
+static bool prv_textSerialize(void *argP)
+{
+    data_arg_t *dataArgP;
+    uint8_t *buffer;
+    size_t length;
+
+    dataArgP = (data_arg_t *)argP;
+
+    if (textSerialize(dataArgP->dataP, &buffer, &length) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+    iowa_system_free(buffer);
+
+    return length == dataArgP->length;
+}
+
+static bool prv_floatToBuffer(void *argP)
+{
+    float_arg_t *floatArgP;
+    uint8_t buffer[DATA_FLOAT_STRING_MAX_LENGTH];
+
+    floatArgP = (float_arg_t *)argP;
+
+    return dataUtilsFloatToBuffer(floatArgP->value, buffer, sizeof(buffer), floatArgP->withExponent) != 0;
+}
+
+static bool prv_uriDecode(void *argP)
+{
+    coap_arg_t *coapP;
+    iowa_lwm2m_uri_t uri;
+
+    coapP = (coap_arg_t *)argP;
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    return uri_decode(NULL, coapP->messageP, IOWA_COAP_OPTION_URI_PATH, &uri) != LWM2M_URI_TYPE_UNKNOWN;
+#else
+    return uri_decode(coapP->messageP, IOWA_COAP_OPTION_URI_PATH, &uri) != LWM2M_URI_TYPE_UNKNOWN;
+#endif
+}
+
+static bool prv_objectRead(void *argP)
+{
+    read_arg_t *readArgP;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+
+    readArgP = (read_arg_t *)argP;
+    dataP = NULL;
+    dataCount = 0;
+
+    if (object_read(readArgP->contextP, &(readArgP->uri), 1, &dataCount, &dataP) != IOWA_COAP_205_CONTENT)
+    {
+        return false;
+    }
+    object_free(readArgP->contextP, dataCount, dataP);
+    iowa_system_free(dataP);
+
+    return dataCount != 0;
+}
+
+/*************************************************************************************
+** Payloads
+*************************************************************************************/
+
+// A Register request
+static iowa_coap_message_t * prv_buildRegistration(void)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, sizeof(s_token), s_token);
+    if (messageP == NULL)
+    {
+        return NULL;
+    }
+    messageP->id = 0x1234;
+
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, "rd", '/'));
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    if (optionP != NULL)
+    {
+        optionP->value.asInteger = IOWA_CONTENT_FORMAT_CORE_LINK;
+        iowa_coap_message_add_option(messageP, optionP);
+    }
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, s_registrationQuery, '&'));
+
+    messageP->payload.data = (uint8_t *)s_registrationLinks;
+    messageP->payload.length = sizeof(s_registrationLinks) - 1;
+
+    return messageP;
+}
+
+// A notification of the Sensor Value of an IPSO Temperature
+static iowa_coap_message_t * prv_buildNotification(uint8_t *payload,
+                                                   size_t payloadLength)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_205_CONTENT, sizeof(s_token), s_token);
+    if (messageP == NULL)
+    {
+        return NULL;
+    }
+    messageP->id = 0x1235;
+
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+    if (optionP != NULL)
+    {
+        optionP->value.asInteger = 1042;
+        iowa_coap_message_add_option(messageP, optionP);
+    }
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    if (optionP != NULL)
+    {
+        optionP->value.asInteger = IOWA_CONTENT_FORMAT_TLV;
+        iowa_coap_message_add_option(messageP, optionP);
+    }
+
+    messageP->payload.data = payload;
+    messageP->payload.length = payloadLength;
+
+    return messageP;
+}
+
+// A request on an URI with the Uri-Path option
+static iowa_coap_message_t * prv_buildRequest(const char *path)
+{
+    iowa_coap_message_t *messageP;
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, sizeof(s_token), s_token);
+    if (messageP == NULL)
+    {
+        return NULL;
+    }
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, path, '/'));
+
+    return messageP;
+}
+
+// Fill the datagram from the message, and the options from the datagram
+static bool prv_initCoap(iowa_coap_message_t *messageP,
+                         coap_arg_t *coapP,
+                         option_arg_t *optionArgP)
+{
+    size_t index;
+
+    if (messageP == NULL)
+    {
+        return false;
+    }
+    coapP->messageP = messageP;
+    coapP->length = coapMessageSerializeDatagram(messageP, &(coapP->buffer));
+    if (coapP->length == 0)
+    {
+        return false;
+    }
+
+    // The options lie between the four bytes of header and the token, and the payload marker
+    index = 4 + (size_t)messageP->tokenLength;
+    optionArgP->optionList = messageP->optionList;
+    optionArgP->buffer = coapP->buffer + index;
+    optionArgP->length = coapP->length - index;
+    if (messageP->payload.length != 0)
+    {
+        optionArgP->length -= messageP->payload.length + 1;
+    }
+
+    return true;
+}
+
+static bool prv_initData(iowa_lwm2m_uri_t *baseUriP,
+                         iowa_lwm2m_data_t *dataP,
+                         size_t dataCount,
+                         data_arg_t *dataArgP)
+{
+    dataArgP->baseUri = *baseUriP;
+    dataArgP->dataP = dataP;
+    dataArgP->dataCount = dataCount;
+
+    return tlvSerialize(baseUriP, dataP, dataCount, &(dataArgP->buffer), &(dataArgP->length)) == IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+// Call the operation once to check it and to warm the caches, then time it
+static int prv_measure(const char *function,
+                       const char *payload,
+                       size_t payloadSize,
+                       bench_op_t op,
+                       void *argP,
+                       unsigned long iterations)
+{
+    unsigned long i;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t allocCount;
+    uint64_t allocBytes;
+
+    if (op(argP) == false)
+    {
+        fprintf(stderr, "%s failed on %s.\r\n", function, payload);
+        return -1;
+    }
+
+    allocCount = s_allocCount;
+    allocBytes = s_allocBytes;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        (void)op(argP);
+    }
+    duration = bench_now_ns() - start;
+    allocCount = s_allocCount - allocCount;
+    allocBytes = s_allocBytes - allocBytes;
+
+    fprintf(stdout, "%s\n    {\"function\": \"%s\", \"payload\": \"%s\", \"payload_bytes\": %zu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"alloc_bytes_per_op\": %.1f}",
+            s_isFirstResult ? "" : ",",
+            function, payload, payloadSize,
+            (double)duration / (double)iterations,
+            (double)allocCount / (double)iterations,
+            (double)allocBytes / (double)iterations);
+    s_isFirstResult = false;
+
+    return 0;
+}
+
+static void prv_closeContext(iowa_context_t contextP)
+{
+    size_t i;
+
+    for (i = 0; i < s_sensorCount; i++)
+    {
+        (void)iowa_client_IPSO_remove_sensor(contextP, s_sensorArray[i]);
+    }
+    iowa_close(contextP);
+}
+
+static iowa_context_t prv_createContext(void)
+{
+    iowa_context_t contextP;
+    iowa_device_info_t devInfo;
+
+    contextP = iowa_init(NULL);
+    if (contextP == NULL)
+    {
+        return NULL;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IoTerop";
+    devInfo.modelNumber = "IOWA Benchmark";
+    devInfo.serialNumber = "0123456789";
+    devInfo.firmwareVersion = "1.0.2";
+
+    if (iowa_client_configure(contextP, "urn:imei:358240051111110", &devInfo, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        iowa_close(contextP);
+        return NULL;
+    }
+
+    for (s_sensorCount = 0; s_sensorCount < BENCH_SENSOR_COUNT; s_sensorCount++)
+    {
+        if (iowa_client_IPSO_add_sensor(contextP, IOWA_IPSO_TEMPERATURE, 20.0 + (double)s_sensorCount, "Cel", "Temperature", -40.0, 85.0, s_sensorArray + s_sensorCount) != IOWA_COAP_NO_ERROR)
+        {
+            prv_closeContext(contextP);
+            return NULL;
+        }
+    }
+
+    return contextP;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    int result;
+    unsigned long iterations;
+    iowa_lwm2m_uri_t deviceUri = {3, 0, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL};
+    iowa_lwm2m_uri_t ipsoUri = {3303, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_ID_ALL};
+    iowa_lwm2m_uri_t valueUri = {3303, 0, 5700, IOWA_LWM2M_ID_ALL};
+    coap_arg_t registration;
+    coap_arg_t notification;
+    coap_arg_t resourceRequest;
+    coap_arg_t objectRequest;
+    option_arg_t registrationOptions;
+    option_arg_t notificationOptions;
+    option_arg_t unusedOptions;
+    data_arg_t deviceData;
+    data_arg_t ipsoData;
+    data_arg_t valueData;
+    data_arg_t valueText;
+    float_arg_t shortFloat = {21.37, false};
+    float_arg_t longFloat = {1.0 / 3.0, false};
+    float_arg_t exponentFloat = {6.02214076e23, true};
+    read_arg_t deviceRead;
+    read_arg_t ipsoRead;
+
+    iterations = bench_get_iterations(argc, argv);
+
+    memset(&registration, 0, sizeof(coap_arg_t));
+    memset(&notification, 0, sizeof(coap_arg_t));
+    memset(&resourceRequest, 0, sizeof(coap_arg_t));
+    memset(&objectRequest, 0, sizeof(coap_arg_t));
+    memset(&deviceData, 0, sizeof(data_arg_t));
+    memset(&ipsoData, 0, sizeof(data_arg_t));
+    memset(&valueData, 0, sizeof(data_arg_t));
+    memset(&valueText, 0, sizeof(data_arg_t));
+
+    result = 1;
+    deviceRead.contextP = prv_createContext();
+    deviceRead.uri = deviceUri;
+    ipsoRead.contextP = deviceRead.contextP;
+    ipsoRead.uri = ipsoUri;
+
+    if (deviceRead.contextP == NULL
+        || prv_initData(&deviceUri, s_deviceData, sizeof(s_deviceData) / sizeof(iowa_lwm2m_data_t), &deviceData) == false
+        || prv_initData(&ipsoUri, s_ipsoData, sizeof(s_ipsoData) / sizeof(iowa_lwm2m_data_t), &ipsoData) == false
+        || prv_initData(&valueUri, &s_sensorValue, 1, &valueData) == false
+        || prv_initCoap(prv_buildRegistration(), &registration, &registrationOptions) == false
+        || prv_initCoap(prv_buildNotification(valueData.buffer, valueData.length), &notification, &notificationOptions) == false
+        || prv_initCoap(prv_buildRequest("3303/0/5700"), &resourceRequest, &unusedOptions) == false
+        || prv_initCoap(prv_buildRequest("3/0"), &objectRequest, &unusedOptions) == false)
+    {
+        fprintf(stderr, "Failed to prepare the payloads.\r\n");
+        goto exit;
+    }
+
+    valueText.dataP = &s_sensorValue;
+    valueText.dataCount = 1;
+    if (textSerialize(&s_sensorValue, &(valueText.buffer), &(valueText.length)) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to prepare the payloads.\r\n");
+        goto exit;
+    }
+
+    s_isFirstResult = true;
+    fprintf(stdout, "{\n  \"benchmark\": \"hot_paths\",\n  \"iterations\": %lu,\n  \"results\": [", iterations);
+
+    if (prv_measure("messageDatagramParse", "Register", registration.length, prv_datagramParse, &registration, iterations) != 0
+        || prv_measure("messageDatagramParse", "Notification", notification.length, prv_datagramParse, &notification, iterations) != 0
+        || prv_measure("coapMessageSerializeDatagram", "Register", registration.length, prv_datagramSerialize, &registration, iterations) != 0
+        || prv_measure("coapMessageSerializeDatagram", "Notification", notification.length, prv_datagramSerialize, &notification, iterations) != 0
+        || prv_measure("option_parse", "Register", registrationOptions.length, prv_optionParse, &registrationOptions, iterations) != 0
+        || prv_measure("option_parse", "Notification", notificationOptions.length, prv_optionParse, &notificationOptions, iterations) != 0
+        || prv_measure("option_serialize", "Register", registrationOptions.length, prv_optionSerialize, &registrationOptions, iterations) != 0
+        || prv_measure("option_serialize", "Notification", notificationOptions.length, prv_optionSerialize, &notificationOptions, iterations) != 0
+        || prv_measure("tlvSerialize", "Device", deviceData.length, prv_tlvSerialize, &deviceData, iterations) != 0
+        || prv_measure("tlvSerialize", "IPSO Temperature x4", ipsoData.length, prv_tlvSerialize, &ipsoData, iterations) != 0
+        || prv_measure("tlvSerialize", "Sensor Value", valueData.length, prv_tlvSerialize, &valueData, iterations) != 0
+        || prv_measure("tlvDeserialize", "Device", deviceData.length, prv_tlvDeserialize, &deviceData, iterations) != 0
+        || prv_measure("tlvDeserialize", "IPSO Temperature x4", ipsoData.length, prv_tlvDeserialize, &ipsoData, iterations) != 0
+        || prv_measure("tlvDeserialize", "Sensor Value", valueData.length, prv_tlvDeserialize, &valueData, iterations) != 0
+        || prv_measure("textSerialize", "Sensor Value", valueText.length, prv_textSerialize, &valueText, iterations) != 0
+        || prv_measure("dataUtilsFloatToBuffer", "21.37", sizeof(double), prv_floatToBuffer, &shortFloat, iterations) != 0
+        || prv_measure("dataUtilsFloatToBuffer", "1/3", sizeof(double), prv_floatToBuffer, &longFloat, iterations) != 0
+        || prv_measure("dataUtilsFloatToBuffer", "6.02214076e23", sizeof(double), prv_floatToBuffer, &exponentFloat, iterations) != 0
+        || prv_measure("uri_decode", "/3303/0/5700", resourceRequest.length, prv_uriDecode, &resourceRequest, iterations) != 0
+        || prv_measure("uri_decode", "/3/0", objectRequest.length, prv_uriDecode, &objectRequest, iterations) != 0
+        || prv_measure("object_read", "/3/0", 0, prv_objectRead, &deviceRead, iterations) != 0
+        || prv_measure("object_read", "/3303", 0, prv_objectRead, &ipsoRead, iterations) != 0)
+    {
+        fprintf(stdout, "\n  ]\n}\n");
+        goto exit;
+    }
+
+    fprintf(stdout, "\n  ]\n}\n");
+    result = 0;
+
+exit:
+    iowa_system_free(registration.buffer);
+    iowa_system_free(notification.buffer);
+    iowa_system_free(resourceRequest.buffer);
+    iowa_system_free(objectRequest.buffer);
+    iowa_coap_message_free(registration.messageP);
+    iowa_coap_message_free(notification.messageP);
+    iowa_coap_message_free(resourceRequest.messageP);
+    iowa_coap_message_free(objectRequest.messageP);
+    iowa_system_free(deviceData.buffer);
+    iowa_system_free(ipsoData.buffer);
+    iowa_system_free(valueData.buffer);
+    iowa_system_free(valueText.buffer);
+    if (deviceRead.contextP != NULL)
+    {
+        prv_closeContext(deviceRead.contextP);
+    }
+
+    return result;
+}
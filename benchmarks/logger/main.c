@@ -0,0 +1,247 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures the time spent in the
+ * IOWA log calls made by the stack. Built with
+ * IOWA_LOG_BINARY_SUPPORT, it also measures the
+ * formatting of the records by the drain.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_prv_logger.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+// Number of log calls between two drains, half of the ring buffer
+#define BENCH_BATCH_SIZE 512
+
+typedef enum
+{
+    LOG_MESSAGE,
+    LOG_ARGUMENTS,
+    LOG_STRING,
+    LOG_BUFFER
+} bench_log_t;
+
+// Output of the logs, like the buffer of a serial line driver
+static char s_sink[4096];
+static uint64_t s_sinkBytes;
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    int length;
+
+    length = vsnprintf(s_sink, sizeof(s_sink), format, varArgs);
+    if (length > 0)
+    {
+        s_sinkBytes += (uint64_t)length;
+    }
+}
+
+// Called for each log: read the coarse clock, updated at each tick, which avoids reading the clock source
+uint64_t iowa_system_log_timestamp(void)
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#else
+    return bench_now_ns();
+#endif
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+static const char * prv_logName(bench_log_t log)
+{
+    switch (log)
+    {
+    case LOG_MESSAGE:
+        return "Message";
+    case LOG_ARGUMENTS:
+        return "Arguments";
+    case LOG_STRING:
+        return "String";
+    default:
+        return "Buffer";
+    }
+}
+
+// Typical logs of the stack
+static void prv_log(bench_log_t log,
+                    uint32_t i,
+                    const uint8_t *buffer)
+{
+    switch (log)
+    {
+    case LOG_MESSAGE:
+        IOWA_LOG_INFO(IOWA_PART_COAP, "Exchange found.");
+        break;
+
+    case LOG_ARGUMENTS:
+        IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Notifying /%u/%u/%u with counter %u.", 3303, i & 0xFF, 5700, i);
+        break;
+
+    case LOG_STRING:
+        IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Opening connection to \"%s\" on port \"%s\".", "lwm2m.example.com", "5684");
+        break;
+
+    default:
+        IOWA_LOG_ARG_BUFFER_INFO(IOWA_PART_COMM, "Sending %u bytes to peer %p.", buffer, 48, 48, (void *)buffer);
+        break;
+    }
+}
+
+#ifdef IOWA_LOG_BINARY_SUPPORT
+// Mean time of iowa_system_log_timestamp(), included in the time of each binary log call
+static double prv_timestampNs(uint32_t iterations)
+{
+    uint64_t start;
+    volatile uint64_t timestamp;
+    uint32_t i;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+    {
+        timestamp = iowa_system_log_timestamp();
+    }
+    (void)timestamp;
+
+    return (double)(bench_now_ns() - start) / iterations;
+}
+#endif
+
+static int prv_run(bench_log_t log,
+                   uint32_t iterations)
+{
+    uint8_t buffer[48];
+    uint64_t logNs;
+    uint64_t drainNs;
+    uint64_t sinkBytes;
+    size_t drainCount;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = (uint8_t)i;
+    }
+
+    logNs = 0;
+    drainNs = 0;
+    drainCount = 0;
+    sinkBytes = s_sinkBytes;
+
+    i = 0;
+    while (i < iterations)
+    {
+        uint64_t start;
+        uint32_t end;
+
+        end = i + BENCH_BATCH_SIZE;
+        if (end > iterations)
+        {
+            end = iterations;
+        }
+
+        start = bench_now_ns();
+        for (; i < end; i++)
+        {
+            prv_log(log, i, buffer);
+        }
+        logNs += bench_now_ns() - start;
+
+#ifdef IOWA_LOG_BINARY_SUPPORT
+        start = bench_now_ns();
+        drainCount += iowa_log_binary_drain(0);
+        drainNs += bench_now_ns() - start;
+#endif
+    }
+
+    sinkBytes = s_sinkBytes - sinkBytes;
+
+#ifdef IOWA_LOG_BINARY_SUPPORT
+    fprintf(stdout, "%-10s %14.1f %18.1f %14.1f\r\n",
+            prv_logName(log),
+            (double)logNs / iterations,
+            (double)drainNs / iterations,
+            (double)sinkBytes / iterations);
+
+    if (drainCount != iterations)
+    {
+        fprintf(stderr, "%s: %u logs but %zu records drained.\r\n", prv_logName(log), iterations, drainCount);
+        return -1;
+    }
+#else
+    (void)drainNs;
+    (void)drainCount;
+
+    fprintf(stdout, "%-10s %14.1f %18s %14.1f\r\n",
+            prv_logName(log),
+            (double)logNs / iterations,
+            "-",
+            (double)sinkBytes / iterations);
+#endif
+
+    if (sinkBytes == 0)
+    {
+        fprintf(stderr, "%s: nothing was output.\r\n", prv_logName(log));
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    uint32_t iterations;
+    int result;
+    bench_log_t log;
+
+    iterations = (uint32_t)bench_get_iterations(argc, argv);
+
+#ifdef IOWA_LOG_BINARY_SUPPORT
+    fprintf(stdout, "Binary logs, %u calls per log, %.1f ns per timestamp.\r\n\n", iterations, prv_timestampNs(iterations));
+#else
+    fprintf(stdout, "Text logs, %u calls per log.\r\n\n", iterations);
+#endif
+    fprintf(stdout, "%-10s %14s %18s %14s\r\n", "Log", "Call (ns)", "Drain (ns/record)", "Output bytes");
+
+    result = 0;
+    for (log = LOG_MESSAGE; log <= LOG_BUFFER; log++)
+    {
+        if (prv_run(log, iterations) != 0)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,745 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark simulates a fleet of LwM2M
+ * Clients talking to a stand-in LwM2M Server over
+ * the in-process loopback transport. The virtual
+ * clock runs faster than real time and the link
+ * drops, delays and reorders the datagrams, so the
+ * retransmissions, the notification periods and
+ * the registration lifetime are exercised
+ * deterministically.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+#include "iowa_prv_coap_internals.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+#include "loopback.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_CLIENTS    1000
+#define BENCH_SERVER_ID          1
+#define BENCH_SERVER_HOST        "lwm2m.sim"
+#define BENCH_SERVER_PORT        "5683"
+#define BENCH_SERVER_URI         "coap://" BENCH_SERVER_HOST ":" BENCH_SERVER_PORT
+#define BENCH_LIFETIME           300
+#define BENCH_MIN_PERIOD         10
+#define BENCH_MAX_PERIOD         60
+#define BENCH_DURATION           1800                  // simulated seconds
+#define BENCH_OBSERVED_PATH      "3303/0/5700"
+#define BENCH_REQUEST_TIMEOUT    4000000ULL            // the stand-in Server resends its requests after 4 s
+#define BENCH_SEED               0x2545F491
+#define BENCH_SECOND             1000000ULL
+
+typedef enum
+{
+    REQUEST_NONE,
+    REQUEST_ATTRIBUTES,
+    REQUEST_OBSERVE
+} request_t;
+
+typedef struct
+{
+    const char      *name;
+    loopback_link_t  link;
+} profile_t;
+
+typedef struct
+{
+    uint32_t        index;
+    iowa_context_t  contextP;
+    iowa_sensor_t   sensorId;
+    bool            isActive;                   // the sensor value changes every second
+    // Seen by the Client
+    uint64_t        registrationTime;           // when the first Registration succeeded, 0 before
+    uint64_t        lastNotificationTime;       // 0 when not observed
+    // Seen by the stand-in Server
+    void           *connP;                      // the connection of the last datagram received
+    uint16_t        messageId;
+    bool            hasRequest;
+    uint16_t        lastRequestId;              // the last Registration or Registration Update
+    uint64_t        lastRequestTime;
+    request_t       pendingRequest;
+    uint16_t        pendingId;
+    uint64_t        pendingTime;
+    bool            hasNotification;
+    uint32_t        lastObserveNumber;
+} node_t;
+
+typedef struct
+{
+    uint32_t         registeredCount;
+    uint64_t         registrationSum;           // in microseconds of virtual time
+    uint64_t         registrationMax;
+    uint64_t         updateCount;
+    uint64_t         expiredCount;
+    uint64_t         notificationSentCount;
+    uint64_t         notificationReceivedCount;
+    uint64_t         minPeriodErrorCount;
+    uint64_t         maxPeriodErrorCount;
+    uint64_t         errorCount;
+    uint64_t         retransmissionCount;
+    uint64_t         failureCount;
+    uint64_t         traceHash;                 // hash of the datagrams received by the stand-in Server and of their time
+    loopback_stats_t link;
+    uint64_t         wallNs;
+} result_t;
+
+static const profile_t s_profileArray[] =
+{
+    // name        loss  min delay  max delay  reorder  reorder delay
+    { "Ideal",   {  0,   20000,     20000,     0,       0 } },
+    { "Lossy",   {  5,   20000,     200000,    10,      500000 } },
+    { "Hostile", { 20,   50000,     1000000,   20,      2000000 } }
+};
+
+static node_t *s_nodeArray;
+static result_t *s_resultP;
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+static void prv_serverSend(node_t *nodeP,
+                           iowa_coap_message_t *messageP)
+{
+    uint8_t *bufferP;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0)
+    {
+        s_resultP->errorCount++;
+        return;
+    }
+    loopback_reply(nodeP->connP, bufferP, length);
+    iowa_system_free(bufferP);
+}
+
+// Send the pending request: the Write-Attributes setting the notification periods, then the Observe
+static void prv_serverSendRequest(node_t *nodeP)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint8_t token[4];
+    char query[32];
+
+    token[0] = (uint8_t)(nodeP->index >> 24);
+    token[1] = (uint8_t)(nodeP->index >> 16);
+    token[2] = (uint8_t)(nodeP->index >> 8);
+    token[3] = (uint8_t)nodeP->index;
+
+    if (nodeP->pendingRequest == REQUEST_ATTRIBUTES)
+    {
+        messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_PUT, sizeof(token), token);
+        iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, BENCH_OBSERVED_PATH, '/'));
+        snprintf(query, sizeof(query), "pmin=%u&pmax=%u", BENCH_MIN_PERIOD, BENCH_MAX_PERIOD);
+        iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, query, '&'));
+    }
+    else
+    {
+        messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, sizeof(token), token);
+        optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+        optionP->value.asInteger = 0;
+        iowa_coap_message_add_option(messageP, optionP);
+        iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, BENCH_OBSERVED_PATH, '/'));
+    }
+    messageP->id = nodeP->pendingId;
+
+    prv_serverSend(nodeP, messageP);
+    nodeP->pendingTime = loopback_now_us();
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_serverNewRequest(node_t *nodeP,
+                                 request_t request)
+{
+    nodeP->pendingRequest = request;
+    nodeP->pendingId = nodeP->messageId++;
+    prv_serverSendRequest(nodeP);
+}
+
+// Registrations and Registration Updates
+static void prv_serverHandleRequest(node_t *nodeP,
+                                    iowa_coap_message_t *requestP)
+{
+    iowa_coap_message_t *responseP;
+    iowa_coap_option_t *optionP;
+    size_t pathCount;
+    bool isRegistration;
+    bool isNew;
+    char location[16];
+
+    pathCount = 0;
+    for (optionP = requestP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        if (optionP->number == IOWA_COAP_OPTION_URI_PATH)
+        {
+            pathCount++;
+        }
+    }
+    if (requestP->code != IOWA_COAP_CODE_POST
+        || pathCount == 0
+        || pathCount > 2)
+    {
+        s_resultP->errorCount++;
+        return;
+    }
+    isRegistration = (pathCount == 1);
+
+    // A retransmitted request gets the same response
+    isNew = (nodeP->hasRequest == false || nodeP->lastRequestId != requestP->id);
+    if (isNew == true)
+    {
+        if (nodeP->hasRequest == true
+            && loopback_now_us() - nodeP->lastRequestTime > BENCH_LIFETIME * BENCH_SECOND)
+        {
+            s_resultP->expiredCount++;
+        }
+        nodeP->hasRequest = true;
+        nodeP->lastRequestId = requestP->id;
+        nodeP->lastRequestTime = loopback_now_us();
+
+        if (isRegistration == false)
+        {
+            s_resultP->updateCount++;
+        }
+    }
+
+    if (isRegistration == true)
+    {
+        responseP = iowa_coap_message_prepare_response(requestP, IOWA_COAP_201_CREATED);
+        snprintf(location, sizeof(location), "rd/%u", nodeP->index);
+        iowa_coap_message_add_option(responseP, iowa_coap_path_to_option(IOWA_COAP_OPTION_LOCATION_PATH, location, '/'));
+    }
+    else
+    {
+        responseP = iowa_coap_message_prepare_response(requestP, IOWA_COAP_204_CHANGED);
+    }
+    prv_serverSend(nodeP, responseP);
+    iowa_coap_message_free(responseP);
+
+    // A new Registration cancels the observations
+    if (isRegistration == true
+        && isNew == true)
+    {
+        nodeP->hasNotification = false;
+        prv_serverNewRequest(nodeP, REQUEST_ATTRIBUTES);
+    }
+}
+
+static void prv_serverReceive(void *connP,
+                              const uint8_t *buffer,
+                              size_t length,
+                              void *userDataP)
+{
+    node_t *nodeP;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint32_t observeNumber;
+    uint64_t now;
+    size_t i;
+
+    (void)userDataP;
+
+    nodeP = (node_t *)loopback_get_user_data(connP);
+    nodeP->connP = connP;
+    now = loopback_now_us();
+
+    // FNV-1a of the time and of the datagram. The tokens of the Client derive from memory addresses and are skipped.
+    for (i = 0; i < sizeof(now); i++)
+    {
+        s_resultP->traceHash = (s_resultP->traceHash ^ (uint8_t)(now >> (8 * i))) * 0x100000001B3ULL;
+    }
+    for (i = 0; i < length; i++)
+    {
+        if (i < 4
+            || i >= 4 + (size_t)(buffer[0] & 0x0F))
+        {
+            s_resultP->traceHash = (s_resultP->traceHash ^ buffer[i]) * 0x100000001B3ULL;
+        }
+    }
+
+    if (messageDatagramParse((uint8_t *)buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        s_resultP->errorCount++;
+        return;
+    }
+
+    switch (messageP->type)
+    {
+    case IOWA_COAP_TYPE_ACKNOWLEDGEMENT:
+    case IOWA_COAP_TYPE_RESET:
+        if (nodeP->pendingRequest != REQUEST_NONE
+            && messageP->id == nodeP->pendingId)
+        {
+            if (nodeP->pendingRequest == REQUEST_ATTRIBUTES
+                && messageP->code == IOWA_COAP_204_CHANGED)
+            {
+                prv_serverNewRequest(nodeP, REQUEST_OBSERVE);
+            }
+            else if (nodeP->pendingRequest == REQUEST_OBSERVE
+                     && messageP->code == IOWA_COAP_205_CONTENT)
+            {
+                nodeP->pendingRequest = REQUEST_NONE;
+            }
+            else
+            {
+                // The Client refused the request, for instance because it was reordered before the Registration
+                nodeP->pendingId = nodeP->messageId++;
+                nodeP->pendingTime = 0;
+            }
+        }
+        break;
+
+    default:
+        if (messageP->code == IOWA_COAP_205_CONTENT)
+        {
+            // A notification
+            if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+            {
+                iowa_coap_message_t *ackP;
+
+                ackP = iowa_coap_message_new(IOWA_COAP_TYPE_ACKNOWLEDGEMENT, IOWA_COAP_CODE_EMPTY, 0, NULL);
+                ackP->id = messageP->id;
+                prv_serverSend(nodeP, ackP);
+                iowa_coap_message_free(ackP);
+            }
+            // Retransmitted and reordered notifications carry an older Observe number
+            observeNumber = 0;
+            for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+            {
+                if (optionP->number == IOWA_COAP_OPTION_OBSERVE)
+                {
+                    observeNumber = optionP->value.asInteger;
+                }
+            }
+            if (nodeP->hasNotification == false
+                || observeNumber > nodeP->lastObserveNumber)
+            {
+                nodeP->hasNotification = true;
+                nodeP->lastObserveNumber = observeNumber;
+                s_resultP->notificationReceivedCount++;
+            }
+        }
+        else if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+        {
+            prv_serverHandleRequest(nodeP, messageP);
+        }
+        else
+        {
+            s_resultP->errorCount++;
+        }
+        break;
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_serverStep(node_t *nodeP)
+{
+    if (nodeP->pendingRequest != REQUEST_NONE
+        && loopback_now_us() - nodeP->pendingTime >= BENCH_REQUEST_TIMEOUT)
+    {
+        prv_serverSendRequest(nodeP);
+    }
+}
+
+/*************************************************************************************
+** Simulated Clients
+*************************************************************************************/
+
+static void prv_eventCallback(iowa_event_t *eventP,
+                              void *userData,
+                              iowa_context_t contextP)
+{
+    node_t *nodeP;
+    uint64_t now;
+
+    (void)contextP;
+
+    nodeP = (node_t *)userData;
+    now = loopback_now_us();
+
+    switch (eventP->eventType)
+    {
+    case IOWA_EVENT_REG_REGISTERED:
+        if (nodeP->registrationTime == 0)
+        {
+            nodeP->registrationTime = now;
+        }
+        break;
+
+    case IOWA_EVENT_REG_REGISTERING:
+    case IOWA_EVENT_OBSERVATION_CANCELED:
+        nodeP->lastNotificationTime = 0;
+        break;
+
+    case IOWA_EVENT_OBSERVATION_STARTED:
+        nodeP->lastNotificationTime = now;
+        break;
+
+    case IOWA_EVENT_OBSERVATION_NOTIFICATION:
+        s_resultP->notificationSentCount++;
+        if (nodeP->lastNotificationTime != 0)
+        {
+            uint64_t period;
+
+            // The Client clock has a resolution of one second
+            period = now - nodeP->lastNotificationTime;
+            if (nodeP->isActive == true
+                && period + BENCH_SECOND < BENCH_MIN_PERIOD * BENCH_SECOND)
+            {
+                s_resultP->minPeriodErrorCount++;
+            }
+            else if (nodeP->isActive == false
+                     && period > (BENCH_MAX_PERIOD + 1) * BENCH_SECOND)
+            {
+                s_resultP->maxPeriodErrorCount++;
+            }
+        }
+        nodeP->lastNotificationTime = now;
+        break;
+
+    default:
+        break;
+    }
+}
+
+static bool prv_nodeStart(node_t *nodeP,
+                          uint32_t index)
+{
+    iowa_device_info_t devInfo;
+    char name[32];
+
+    memset(nodeP, 0, sizeof(node_t));
+    nodeP->index = index;
+    nodeP->isActive = (index % 2 == 0);
+    nodeP->messageId = (uint16_t)(index * 7919);
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IOWA";
+    devInfo.modelNumber = "Simulation";
+
+    snprintf(name, sizeof(name), "sim-%u", index);
+
+    nodeP->contextP = iowa_init(nodeP);
+    if (nodeP->contextP == NULL
+        || iowa_client_configure(nodeP->contextP, name, &devInfo, prv_eventCallback) != IOWA_COAP_NO_ERROR
+        || iowa_client_IPSO_add_sensor(nodeP->contextP, IOWA_IPSO_TEMPERATURE, 20, "Cel", "Simulated Temperature", -20.0, 50.0, &nodeP->sensorId) != IOWA_COAP_NO_ERROR
+        || iowa_client_add_server(nodeP->contextP, BENCH_SERVER_ID, BENCH_SERVER_URI, BENCH_LIFETIME, 0, IOWA_SEC_NONE) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create Client %u.\r\n", index);
+        return false;
+    }
+
+    return true;
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+// Step the Clients which received datagrams
+static void prv_stepReady(void)
+{
+    node_t *nodeP;
+
+    while ((nodeP = (node_t *)loopback_take_ready()) != NULL)
+    {
+        (void)iowa_step(nodeP->contextP, 0);
+    }
+}
+
+static bool prv_run(const profile_t *profileP,
+                    uint32_t clientCount,
+                    result_t *resultP)
+{
+    uint64_t startTime;
+    uint64_t tickTime;
+    uint64_t endTime;
+    uint64_t wallStart;
+    uint32_t second;
+    uint32_t i;
+    bool result;
+
+    memset(resultP, 0, sizeof(result_t));
+    resultP->traceHash = 0xCBF29CE484222325ULL;
+    s_resultP = resultP;
+
+    loopback_init(BENCH_SEED, &profileP->link);
+    if (loopback_listen(BENCH_SERVER_HOST, BENCH_SERVER_PORT, prv_serverReceive, NULL) == false)
+    {
+        return false;
+    }
+
+    result = true;
+    s_nodeArray = (node_t *)calloc(clientCount, sizeof(node_t));
+    for (i = 0; i < clientCount && result == true; i++)
+    {
+        result = prv_nodeStart(s_nodeArray + i, i);
+    }
+
+    startTime = loopback_now_us();
+    endTime = startTime + BENCH_DURATION * BENCH_SECOND;
+    tickTime = startTime;
+    second = 0;
+
+    wallStart = bench_now_ns();
+    while (result == true
+           && tickTime < endTime)
+    {
+        uint64_t deliveryTime;
+
+        deliveryTime = loopback_next_delivery_us();
+        if (deliveryTime < tickTime)
+        {
+            loopback_advance(deliveryTime);
+            prv_stepReady();
+        }
+        else
+        {
+            // The IOWA timers have a resolution of one second: step all the Clients every second
+            loopback_advance(tickTime);
+            prv_stepReady();
+            for (i = 0; i < clientCount; i++)
+            {
+                node_t *nodeP;
+
+                nodeP = s_nodeArray + i;
+                prv_serverStep(nodeP);
+                if (nodeP->isActive == true)
+                {
+                    (void)iowa_client_IPSO_update_value(nodeP->contextP, nodeP->sensorId, (float)(20 + (second + i) % 10));
+                }
+                (void)iowa_step(nodeP->contextP, 0);
+            }
+            tickTime += BENCH_SECOND;
+            second++;
+        }
+    }
+    resultP->wallNs = bench_now_ns() - wallStart;
+
+    for (i = 0; i < clientCount; i++)
+    {
+        node_t *nodeP;
+
+        nodeP = s_nodeArray + i;
+        if (nodeP->contextP == NULL)
+        {
+            continue;
+        }
+
+        if (nodeP->registrationTime != 0)
+        {
+            uint64_t duration;
+
+            duration = nodeP->registrationTime - startTime;
+            resultP->registeredCount++;
+            resultP->registrationSum += duration;
+            if (duration > resultP->registrationMax)
+            {
+                resultP->registrationMax = duration;
+            }
+        }
+        if (nodeP->hasRequest == true
+            && loopback_now_us() - nodeP->lastRequestTime > BENCH_LIFETIME * BENCH_SECOND)
+        {
+            resultP->expiredCount++;
+        }
+
+        {
+            iowa_metrics_t metrics;
+
+            if (iowa_get_metrics(nodeP->contextP, &metrics) == IOWA_COAP_NO_ERROR)
+            {
+                resultP->retransmissionCount += metrics.retransmissionCount;
+                resultP->failureCount += metrics.registrationFailureCount;
+            }
+        }
+
+        iowa_client_IPSO_remove_sensor(nodeP->contextP, nodeP->sensorId);
+        iowa_close(nodeP->contextP);
+    }
+    free(s_nodeArray);
+    s_nodeArray = NULL;
+
+    loopback_get_stats(&resultP->link);
+    loopback_close();
+
+    return result;
+}
+
+static bool prv_check(const profile_t *profileP,
+                      uint32_t clientCount,
+                      const result_t *resultP)
+{
+    bool result;
+
+    result = true;
+
+    if (resultP->registeredCount != clientCount)
+    {
+        fprintf(stderr, "%s: %u Clients out of %u registered.\r\n", profileP->name, resultP->registeredCount, clientCount);
+        result = false;
+    }
+    if (resultP->errorCount != 0)
+    {
+        fprintf(stderr, "%s: %llu unexpected messages.\r\n", profileP->name, (unsigned long long)resultP->errorCount);
+        result = false;
+    }
+    if (resultP->minPeriodErrorCount != 0)
+    {
+        fprintf(stderr, "%s: %llu notifications sent before the minimum period.\r\n", profileP->name, (unsigned long long)resultP->minPeriodErrorCount);
+        result = false;
+    }
+
+    // Without losses, the Clients must keep their registration and respect the maximum period
+    if (profileP->link.lossPercent == 0)
+    {
+        if (resultP->expiredCount != 0)
+        {
+            fprintf(stderr, "%s: %llu registrations expired.\r\n", profileP->name, (unsigned long long)resultP->expiredCount);
+            result = false;
+        }
+        if (resultP->maxPeriodErrorCount != 0)
+        {
+            fprintf(stderr, "%s: %llu notifications sent after the maximum period.\r\n", profileP->name, (unsigned long long)resultP->maxPeriodErrorCount);
+            result = false;
+        }
+        if (resultP->retransmissionCount != 0)
+        {
+            fprintf(stderr, "%s: %llu retransmissions.\r\n", profileP->name, (unsigned long long)resultP->retransmissionCount);
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    uint32_t clientCount;
+    bool hasReplayed;
+    size_t i;
+    int status;
+
+    clientCount = BENCH_DEFAULT_CLIENTS;
+    if (argc > 1)
+    {
+        clientCount = (uint32_t)strtoul(argv[1], NULL, 10);
+        if (clientCount == 0)
+        {
+            clientCount = BENCH_DEFAULT_CLIENTS;
+        }
+    }
+
+    printf("%u Clients simulated for %u s. Lifetime: %u s, notification periods: %u s to %u s, half of the sensors change every second.\r\n\n",
+           clientCount, BENCH_DURATION, BENCH_LIFETIME, BENCH_MIN_PERIOD, BENCH_MAX_PERIOD);
+    printf("%-8s | %-6s | %-11s | %-7s | %-17s | %-7s | %-7s | %-15s | %-8s | %-8s | %-8s | %s\r\n",
+           "Profile", "Loss", "Delay (ms)", "Reorder", "Registration (ms)", "Updates", "Expired", "Notifications", "Received", "Retrans.", "Failures", "Speedup");
+    printf("---------+--------+-------------+---------+-------------------+---------+---------+-----------------+----------+----------+----------+--------\r\n");
+
+    status = 0;
+    hasReplayed = false;
+    for (i = 0; i < sizeof(s_profileArray) / sizeof(profile_t); i++)
+    {
+        const profile_t *profileP;
+        result_t result;
+        result_t replay;
+
+        profileP = s_profileArray + i;
+
+        if (prv_run(profileP, clientCount, &result) == false)
+        {
+            return 1;
+        }
+
+        printf("%-8s | %5u%% | %4u - %-4u | %6u%% | %7.0f / %-7.0f | %7.2f | %7llu | %15llu | %7.1f%% | %8llu | %8llu | %6.0fx\r\n",
+               profileP->name,
+               profileP->link.lossPercent,
+               profileP->link.minDelayUs / 1000,
+               profileP->link.maxDelayUs / 1000,
+               profileP->link.reorderPercent,
+               result.registeredCount != 0 ? (double)result.registrationSum / result.registeredCount / 1000 : 0.0,
+               (double)result.registrationMax / 1000,
+               (double)result.updateCount / clientCount,
+               (unsigned long long)result.expiredCount,
+               (unsigned long long)result.notificationSentCount,
+               result.notificationSentCount != 0 ? 100.0 * result.notificationReceivedCount / result.notificationSentCount : 0.0,
+               (unsigned long long)result.retransmissionCount,
+               (unsigned long long)result.failureCount,
+               (double)BENCH_DURATION * 1e9 / result.wallNs);
+
+        if (prv_check(profileP, clientCount, &result) == false)
+        {
+            status = 1;
+        }
+
+        // The same seed must lead to the same exchanges, even on a lossy link
+        if (hasReplayed == false
+            && profileP->link.lossPercent != 0)
+        {
+            hasReplayed = true;
+            if (prv_run(profileP, clientCount, &replay) == false)
+            {
+                return 1;
+            }
+            if (replay.traceHash != result.traceHash
+                || replay.link.sentCount != result.link.sentCount)
+            {
+                fprintf(stderr, "%s: the replay differs from the first run.\r\n", profileP->name);
+                status = 1;
+            }
+        }
+    }
+
+    return status;
+}
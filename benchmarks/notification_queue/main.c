@@ -0,0 +1,502 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This program checks the notification queue of a
+ * LwM2M Server read by another thread.
+ *
+ * The main thread runs iowa_step() and a stand-in
+ * LwM2M Client sending notifications in bursts
+ * over the in-process loopback transport. A reader
+ * thread retrieves them with
+ * iowa_server_get_notifications() at the same
+ * time. The IOWA mutex is an error checking POSIX
+ * mutex: a recursive lock aborts the program.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_server.h"
+#include "iowa_prv_coap_internals.h"
+
+// Benchmark helpers
+#include "loopback.h"
+
+// Platform specific headers
+#include <pthread.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SEED                   0x1F123BB5
+#define TEST_QUEUE_CAPACITY         8
+#define TEST_BATCH_SIZE             3
+#define TEST_BURST_COUNT            400
+#define TEST_BURST_SIZE             10
+#define TEST_NOTIFICATION_COUNT     (TEST_BURST_COUNT * TEST_BURST_SIZE)
+
+// The stand-in LwM2M Client
+typedef struct
+{
+    void       *connP;
+    uint16_t    messageId;
+    uint8_t     token[8];
+    size_t      tokenLength;
+    bool        isRegistered;
+    bool        isObserved;
+    uint32_t    otherCount;
+} client_t;
+
+// The thread reading the queue
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    bool            isSignaled;
+    bool            isStopped;
+    uint32_t        signalCount;
+    uint32_t        readCount;
+    uint32_t        lastNumber;
+    uint32_t        errorCount;
+} reader_t;
+
+static pthread_mutex_t s_iowaMutex;
+static iowa_context_t s_contextP;
+static uint32_t s_clientId;
+static reader_t s_reader;
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+// The loopback select does not block
+void iowa_system_connection_interrupt_select(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_mutex_lock(void *userData)
+{
+    if (pthread_mutex_lock((pthread_mutex_t *)userData) != 0)
+    {
+        fprintf(stderr, "The IOWA mutex is already locked by this thread.\r\n");
+        abort();
+    }
+}
+
+void iowa_system_mutex_unlock(void *userData)
+{
+    if (pthread_mutex_unlock((pthread_mutex_t *)userData) != 0)
+    {
+        fprintf(stderr, "The IOWA mutex is not locked by this thread.\r\n");
+        abort();
+    }
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Client
+*************************************************************************************/
+
+static void prv_clientSend(client_t *clientP,
+                           iowa_coap_message_t *messageP)
+{
+    uint8_t *bufferP;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0)
+    {
+        clientP->otherCount++;
+        return;
+    }
+    loopback_reply(clientP->connP, bufferP, length);
+    iowa_system_free(bufferP);
+}
+
+// Send a notification of the value of /3/0/9, equal to its Observe number
+static void prv_clientNotify(client_t *clientP,
+                             iowa_coap_message_t *messageP,
+                             uint32_t number)
+{
+    iowa_coap_option_t *optionP;
+    char payload[48];
+
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+    optionP->value.asInteger = number;
+    iowa_coap_message_add_option(messageP, optionP);
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    optionP->value.asInteger = IOWA_CONTENT_FORMAT_SENML_JSON;
+    iowa_coap_message_add_option(messageP, optionP);
+    snprintf(payload, sizeof(payload), "[{\"bn\":\"/3/0/9\",\"v\":%u}]", number);
+    messageP->payload.data = (uint8_t *)payload;
+    messageP->payload.length = strlen(payload);
+
+    prv_clientSend(clientP, messageP);
+}
+
+static void prv_clientReceive(void *connP,
+                              const uint8_t *buffer,
+                              size_t length,
+                              void *userDataP)
+{
+    client_t *clientP;
+    iowa_coap_message_t *messageP;
+    iowa_coap_message_t *responseP;
+
+    (void)connP;
+
+    clientP = (client_t *)userDataP;
+
+    if (messageDatagramParse((uint8_t *)buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        clientP->otherCount++;
+        return;
+    }
+
+    if (messageP->code == IOWA_COAP_201_CREATED)
+    {
+        clientP->isRegistered = true;
+    }
+    else if (messageP->code == IOWA_COAP_CODE_GET
+             && clientP->isObserved == false
+             && messageP->tokenLength <= sizeof(clientP->token))
+    {
+        // The first notification is the response to the Observe request
+        memcpy(clientP->token, messageP->token, messageP->tokenLength);
+        clientP->tokenLength = messageP->tokenLength;
+        clientP->isObserved = true;
+
+        responseP = iowa_coap_message_prepare_response(messageP, IOWA_COAP_205_CONTENT);
+        prv_clientNotify(clientP, responseP, 0);
+        iowa_coap_message_free(responseP);
+    }
+    else
+    {
+        clientP->otherCount++;
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_clientRegister(client_t *clientP)
+{
+    static const char *payload = "</3/0>";
+    static uint8_t token = 1;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, 1, &token);
+    messageP->id = clientP->messageId++;
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, "rd", '/'));
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, "ep=client&lt=3600&lwm2m=1.1&b=U", '&'));
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    optionP->value.asInteger = IOWA_CONTENT_FORMAT_CORE_LINK;
+    iowa_coap_message_add_option(messageP, optionP);
+    messageP->payload.data = (uint8_t *)payload;
+    messageP->payload.length = strlen(payload);
+
+    prv_clientSend(clientP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_clientSendBurst(client_t *clientP,
+                                uint32_t firstNumber)
+{
+    iowa_coap_message_t *messageP;
+    uint32_t i;
+
+    for (i = 0; i < TEST_BURST_SIZE; i++)
+    {
+        messageP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_205_CONTENT, clientP->tokenLength, clientP->token);
+        messageP->id = clientP->messageId++;
+        prv_clientNotify(clientP, messageP, firstNumber + i);
+        iowa_coap_message_free(messageP);
+    }
+}
+
+/*************************************************************************************
+** Reader thread
+*************************************************************************************/
+
+// Called by the thread running iowa_step() when a notification is added to the empty queue
+static void prv_signalCallback(void *callbackUserData,
+                               iowa_context_t contextP)
+{
+    reader_t *readerP;
+
+    (void)contextP;
+
+    readerP = (reader_t *)callbackUserData;
+
+    pthread_mutex_lock(&readerP->mutex);
+    readerP->isSignaled = true;
+    readerP->signalCount++;
+    pthread_cond_signal(&readerP->cond);
+    pthread_mutex_unlock(&readerP->mutex);
+}
+
+// Read the queue until it is empty. The notifications must come in order, with their value.
+static void prv_readerDrain(reader_t *readerP)
+{
+    iowa_notification_t notificationArray[TEST_BATCH_SIZE];
+    size_t count;
+    size_t i;
+
+    do
+    {
+        count = iowa_server_get_notifications(s_contextP, notificationArray, TEST_BATCH_SIZE);
+        for (i = 0; i < count; i++)
+        {
+            iowa_response_content_t *contentP;
+
+            contentP = &(notificationArray[i].content);
+            if (notificationArray[i].clientId != s_clientId
+                || notificationArray[i].status != IOWA_COAP_205_CONTENT
+                || contentP->details.observe.dataCount != 1
+                || contentP->details.observe.dataP[0].value.asInteger != (int64_t)contentP->details.observe.notificationNumber
+                || (readerP->readCount != 0
+                    && contentP->details.observe.notificationNumber <= readerP->lastNumber))
+            {
+                readerP->errorCount++;
+            }
+            readerP->lastNumber = contentP->details.observe.notificationNumber;
+            readerP->readCount++;
+        }
+        iowa_server_free_notifications(notificationArray, count);
+    } while (count != 0);
+}
+
+static void * prv_readerThread(void *arg)
+{
+    reader_t *readerP;
+    bool isStopped;
+
+    readerP = (reader_t *)arg;
+
+    do
+    {
+        pthread_mutex_lock(&readerP->mutex);
+        while (readerP->isSignaled == false
+               && readerP->isStopped == false)
+        {
+            pthread_cond_wait(&readerP->cond, &readerP->mutex);
+        }
+        readerP->isSignaled = false;
+        isStopped = readerP->isStopped;
+        pthread_mutex_unlock(&readerP->mutex);
+
+        prv_readerDrain(readerP);
+    } while (isStopped == false);
+
+    return NULL;
+}
+
+/*************************************************************************************
+** Server
+*************************************************************************************/
+
+static void prv_monitorCallback(const iowa_client_t *clientP,
+                                iowa_state_t state,
+                                void *userData,
+                                iowa_context_t contextP)
+{
+    (void)userData;
+    (void)contextP;
+
+    if (state == IOWA_STATE_REGISTERED)
+    {
+        s_clientId = clientP->id;
+    }
+}
+
+static void prv_observeCallback(uint32_t clientId,
+                                iowa_dm_operation_t operation,
+                                iowa_status_t status,
+                                iowa_response_content_t *contentP,
+                                void *userData,
+                                iowa_context_t contextP)
+{
+    (void)clientId;
+    (void)operation;
+    (void)status;
+    (void)contentP;
+    (void)userData;
+    (void)contextP;
+
+    // With the queue enabled, the notifications are not given to this callback
+    s_reader.errorCount++;
+}
+
+// Deliver the datagrams in flight and let the Server handle them
+static void prv_exchange(void)
+{
+    // Handles the datagram read by iowa_server_new_incoming_connection()
+    (void)iowa_step(s_contextP, 0);
+
+    while (loopback_next_delivery_us() != UINT64_MAX)
+    {
+        loopback_advance(loopback_next_delivery_us());
+        while (loopback_take_ready() != NULL)
+        {
+            (void)iowa_step(s_contextP, 0);
+        }
+    }
+}
+
+static bool prv_check(bool condition,
+                      const char *description)
+{
+    if (condition == false)
+    {
+        fprintf(stderr, "Check failed: %s.\r\n", description);
+    }
+
+    return condition;
+}
+
+/*************************************************************************************
+** Checks
+*************************************************************************************/
+
+static bool prv_checkQueue(void)
+{
+    client_t client;
+    iowa_lwm2m_uri_t uri;
+    uint16_t observeId;
+    pthread_t thread;
+    iowa_notification_queue_stats_t stats;
+    uint32_t i;
+    bool result;
+
+    memset(&client, 0, sizeof(client_t));
+    result = true;
+
+    // Registration and observation
+    client.connP = loopback_connect(&s_iowaMutex, prv_clientReceive, &client);
+    if (client.connP == NULL)
+    {
+        return prv_check(false, "the connection is opened");
+    }
+    prv_clientRegister(&client);
+    loopback_advance(loopback_next_delivery_us());
+    result &= prv_check(iowa_server_new_incoming_connection(s_contextP, IOWA_CONN_DATAGRAM, client.connP, false) == IOWA_COAP_NO_ERROR, "the connection is accepted");
+    prv_exchange();
+    result &= prv_check(client.isRegistered == true, "the Client registers");
+
+    uri.objectId = IOWA_LWM2M_DEVICE_OBJECT_ID;
+    uri.instanceId = 0;
+    uri.resourceId = IOWA_LWM2M_DEVICE_ID_BATTERY_LEVEL;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+    result &= prv_check(iowa_server_observe(s_contextP, s_clientId, 1, &uri, prv_observeCallback, NULL, &observeId) == IOWA_COAP_NO_ERROR, "the observation is started");
+    prv_exchange();
+    result &= prv_check(client.isObserved == true, "the Client is observed");
+    if (result == false)
+    {
+        return false;
+    }
+
+    // The reader thread drains the queue while the Server receives the bursts
+    if (pthread_create(&thread, NULL, prv_readerThread, &s_reader) != 0)
+    {
+        return prv_check(false, "the reader thread is started");
+    }
+    for (i = 0; i < TEST_BURST_COUNT; i++)
+    {
+        prv_clientSendBurst(&client, 1 + i * TEST_BURST_SIZE);
+        prv_exchange();
+    }
+
+    pthread_mutex_lock(&s_reader.mutex);
+    s_reader.isStopped = true;
+    pthread_cond_signal(&s_reader.cond);
+    pthread_mutex_unlock(&s_reader.mutex);
+    pthread_join(thread, NULL);
+
+    iowa_server_get_notification_queue_stats(s_contextP, &stats);
+
+    printf("Notification queue: %u notifications, %u read in %u wake-ups, %u dropped.\r\n", (unsigned int)stats.queuedCount, s_reader.readCount, s_reader.signalCount, (unsigned int)stats.droppedCount);
+
+    result &= prv_check(stats.queuedCount == TEST_NOTIFICATION_COUNT + 1, "all the notifications are queued");
+    result &= prv_check(stats.deliveredCount == s_reader.readCount, "the read notifications are counted");
+    result &= prv_check(stats.queuedCount == stats.deliveredCount + stats.droppedCount && stats.currentCount == 0, "the queue is empty");
+    result &= prv_check(stats.maxCount <= TEST_QUEUE_CAPACITY, "the queue is bounded");
+    result &= prv_check(s_reader.lastNumber == TEST_NOTIFICATION_COUNT, "the last notification is read");
+    result &= prv_check(s_reader.errorCount == 0, "the notifications are read in order with their value");
+    result &= prv_check(client.otherCount == 0, "the Client receives no unexpected message");
+
+    return result;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    static const loopback_link_t link = { 0, 1000, 1000, 0, 0 };
+    pthread_mutexattr_t attributes;
+    bool result;
+
+    (void)argc;
+    (void)argv;
+
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_ERRORCHECK);
+    pthread_mutex_init(&s_iowaMutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    pthread_mutex_init(&s_reader.mutex, NULL);
+    pthread_cond_init(&s_reader.cond, NULL);
+
+    loopback_init(TEST_SEED, &link);
+
+    s_contextP = iowa_init(&s_iowaMutex);
+    if (s_contextP == NULL
+        || iowa_server_configure(s_contextP, prv_monitorCallback, NULL, NULL) != IOWA_COAP_NO_ERROR
+        || iowa_server_configure_notification_queue(s_contextP, TEST_QUEUE_CAPACITY, IOWA_NOTIFICATION_QUEUE_DROP_OLDEST, prv_signalCallback, &s_reader) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create the Server.\r\n");
+        return 1;
+    }
+
+    result = prv_checkQueue();
+    printf("Notification queue read by another thread: %s\r\n", result == true ? "passed" : "FAILED");
+
+    iowa_close(s_contextP);
+    loopback_close();
+
+    pthread_cond_destroy(&s_reader.cond);
+    pthread_mutex_destroy(&s_reader.mutex);
+    pthread_mutex_destroy(&s_iowaMutex);
+
+    return (result == true) ? 0 : 1;
+}
@@ -0,0 +1,491 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This program checks the notification store of a
+ * LwM2M Client over the in-process loopback
+ * transport. The stand-in LwM2M Server goes silent
+ * long enough for the Client registration to fail,
+ * then comes back: the values notified during the
+ * outage must be replayed after the next
+ * Registration and the observation must go on
+ * without being set again.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+#include "iowa_prv_coap_internals.h"
+#include "iowa_prv_data.h"
+
+// Benchmark helpers
+#include "loopback.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SERVER_ID          1
+#define TEST_SERVER_HOST        "lwm2m.store"
+#define TEST_SERVER_PORT        "5683"
+#define TEST_SERVER_URI         "coap://" TEST_SERVER_HOST ":" TEST_SERVER_PORT
+#define TEST_LIFETIME           300
+#define TEST_CHANGE_PERIOD      120                 // seconds between two sensor value changes, longer than a CoAP exchange
+#define TEST_CHANGE_COUNT       24
+#define TEST_OUTAGE_START       630                 // seconds
+#define TEST_OUTAGE_END         1830
+#define TEST_DURATION           (TEST_CHANGE_COUNT * TEST_CHANGE_PERIOD + 60)
+#define TEST_FIRST_VALUE        100
+#define TEST_OBSERVED_PATH      "3303/0/5700"
+#define TEST_OBSERVE_TOKEN      0xAB
+#define TEST_SEED               0x2545F491
+#define TEST_SECOND             1000000ULL
+
+typedef struct
+{
+    // Seen by the Client
+    iowa_context_t  contextP;
+    iowa_sensor_t   sensorId;
+    uint32_t        failedCount;                    // IOWA_EVENT_REG_FAILED events
+    // Seen by the stand-in Server
+    bool            isDown;
+    void           *connP;                          // the connection of the last datagram received
+    uint16_t        messageId;
+    uint32_t        registrationCount;
+    uint32_t        observeCount;
+    uint32_t        notificationCount;
+    uint32_t        sendCount;
+    uint32_t        sendDataCount;
+    uint32_t        errorCount;
+    bool            isReceived[TEST_CHANGE_COUNT + 1]; // the values received, the initial one first
+    bool            isReplayed[TEST_CHANGE_COUNT + 1];
+} test_t;
+
+static test_t s_test;
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+static iowa_lwm2m_data_type_t prv_getResourceType(uint16_t objectID,
+                                                  uint16_t resourceID,
+                                                  void *userDataP)
+{
+    (void)objectID;
+    (void)resourceID;
+    (void)userDataP;
+
+    return IOWA_LWM2M_TYPE_FLOAT;
+}
+
+static void prv_serverSend(iowa_coap_message_t *messageP)
+{
+    uint8_t *bufferP;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0)
+    {
+        s_test.errorCount++;
+        return;
+    }
+    loopback_reply(s_test.connP, bufferP, length);
+    iowa_system_free(bufferP);
+}
+
+static void prv_serverReply(iowa_coap_message_t *requestP,
+                            uint8_t code)
+{
+    iowa_coap_message_t *responseP;
+
+    responseP = iowa_coap_message_prepare_response(requestP, code);
+    if (code == IOWA_COAP_201_CREATED)
+    {
+        iowa_coap_message_add_option(responseP, iowa_coap_path_to_option(IOWA_COAP_OPTION_LOCATION_PATH, "rd/0", '/'));
+    }
+    prv_serverSend(responseP);
+    iowa_coap_message_free(responseP);
+}
+
+static void prv_serverObserve(void)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint8_t token;
+
+    token = TEST_OBSERVE_TOKEN;
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, 1, &token);
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
+    optionP->value.asInteger = 0;
+    iowa_coap_message_add_option(messageP, optionP);
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, TEST_OBSERVED_PATH, '/'));
+    messageP->id = s_test.messageId++;
+
+    prv_serverSend(messageP);
+    s_test.observeCount++;
+
+    iowa_coap_message_free(messageP);
+}
+
+// Mark the sensor values carried by a payload
+static void prv_serverReadValues(iowa_coap_message_t *messageP,
+                                 bool isReplay)
+{
+    iowa_lwm2m_uri_t uri;
+    iowa_coap_option_t *optionP;
+    iowa_content_format_t format;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    size_t i;
+
+    format = IOWA_CONTENT_FORMAT_TEXT;
+    for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        if (optionP->number == IOWA_COAP_OPTION_CONTENT_FORMAT)
+        {
+            format = (iowa_content_format_t)optionP->value.asInteger;
+        }
+    }
+
+    uri.objectId = IOWA_IPSO_TEMPERATURE;
+    uri.instanceId = 0;
+    uri.resourceId = 5700;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+    if (dataLwm2mDeserialize(&uri, messageP->payload.data, messageP->payload.length, format, &dataP, &dataCount, prv_getResourceType, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        s_test.errorCount++;
+        return;
+    }
+
+    for (i = 0; i < dataCount; i++)
+    {
+        int index;
+
+        index = (int)dataP[i].value.asFloat - TEST_FIRST_VALUE;
+        if (dataP[i].resourceID != 5700
+            || index < 0
+            || index > TEST_CHANGE_COUNT)
+        {
+            s_test.errorCount++;
+            continue;
+        }
+        s_test.isReceived[index] = true;
+        if (isReplay == true)
+        {
+            s_test.isReplayed[index] = true;
+            s_test.sendDataCount++;
+        }
+    }
+
+    dataLwm2mFree(dataCount, dataP);
+}
+
+static void prv_serverHandleRequest(iowa_coap_message_t *requestP)
+{
+    iowa_coap_option_t *optionP;
+    size_t pathCount;
+    bool isSend;
+
+    pathCount = 0;
+    isSend = false;
+    for (optionP = requestP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        if (optionP->number == IOWA_COAP_OPTION_URI_PATH)
+        {
+            if (pathCount == 0
+                && optionP->length == 2
+                && memcmp(optionP->value.asBuffer, "dp", 2) == 0)
+            {
+                isSend = true;
+            }
+            pathCount++;
+        }
+    }
+    if (requestP->code != IOWA_COAP_CODE_POST
+        || pathCount == 0
+        || pathCount > 2)
+    {
+        s_test.errorCount++;
+        return;
+    }
+
+    if (isSend == true)
+    {
+        s_test.sendCount++;
+        prv_serverReadValues(requestP, true);
+        prv_serverReply(requestP, IOWA_COAP_204_CHANGED);
+    }
+    else if (pathCount == 1)
+    {
+        s_test.registrationCount++;
+        prv_serverReply(requestP, IOWA_COAP_201_CREATED);
+
+        // The observation is set only once: it must survive the failed registration
+        if (s_test.observeCount == 0)
+        {
+            prv_serverObserve();
+        }
+    }
+    else
+    {
+        prv_serverReply(requestP, IOWA_COAP_204_CHANGED);
+    }
+}
+
+static void prv_serverReceive(void *connP,
+                              const uint8_t *buffer,
+                              size_t length,
+                              void *userDataP)
+{
+    iowa_coap_message_t *messageP;
+
+    (void)userDataP;
+
+    if (s_test.isDown == true)
+    {
+        return;
+    }
+    s_test.connP = connP;
+
+    if (messageDatagramParse((uint8_t *)buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        s_test.errorCount++;
+        return;
+    }
+
+    if (messageP->code == IOWA_COAP_205_CONTENT)
+    {
+        // The response to the Observe or a notification
+        if (messageP->tokenLength != 1
+            || messageP->token[0] != TEST_OBSERVE_TOKEN)
+        {
+            s_test.errorCount++;
+        }
+        else
+        {
+            if (messageP->type != IOWA_COAP_TYPE_ACKNOWLEDGEMENT)
+            {
+                s_test.notificationCount++;
+            }
+            prv_serverReadValues(messageP, false);
+        }
+        if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+        {
+            iowa_coap_message_t *ackP;
+
+            ackP = iowa_coap_message_new(IOWA_COAP_TYPE_ACKNOWLEDGEMENT, IOWA_COAP_CODE_EMPTY, 0, NULL);
+            ackP->id = messageP->id;
+            prv_serverSend(ackP);
+            iowa_coap_message_free(ackP);
+        }
+    }
+    else if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+    {
+        prv_serverHandleRequest(messageP);
+    }
+    else if (messageP->type != IOWA_COAP_TYPE_ACKNOWLEDGEMENT)
+    {
+        s_test.errorCount++;
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+/*************************************************************************************
+** LwM2M Client
+*************************************************************************************/
+
+static void prv_eventCallback(iowa_event_t *eventP,
+                              void *userData,
+                              iowa_context_t contextP)
+{
+    (void)userData;
+    (void)contextP;
+
+    if (eventP->eventType == IOWA_EVENT_REG_FAILED)
+    {
+        s_test.failedCount++;
+    }
+}
+
+static bool prv_start(void)
+{
+    iowa_device_info_t devInfo;
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IOWA";
+    devInfo.modelNumber = "Notification store";
+
+    s_test.contextP = iowa_init(&s_test);
+    if (s_test.contextP == NULL
+        || iowa_client_configure(s_test.contextP, "store", &devInfo, prv_eventCallback) != IOWA_COAP_NO_ERROR
+        || iowa_client_IPSO_add_sensor(s_test.contextP, IOWA_IPSO_TEMPERATURE, TEST_FIRST_VALUE, "Cel", "Stored Temperature", 0.0, 1000.0, &s_test.sensorId) != IOWA_COAP_NO_ERROR
+        || iowa_client_add_server(s_test.contextP, TEST_SERVER_ID, TEST_SERVER_URI, TEST_LIFETIME, 0, IOWA_SEC_NONE) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create the Client.\r\n");
+        return false;
+    }
+
+    return true;
+}
+
+static bool prv_check(bool condition,
+                      const char *description)
+{
+    if (condition == false)
+    {
+        fprintf(stderr, "Check failed: %s.\r\n", description);
+    }
+
+    return condition;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    static const loopback_link_t link = { 0, 20000, 20000, 0, 0 };
+    uint64_t startTime;
+    uint64_t tickTime;
+    uint32_t second;
+    uint32_t changeCount;
+    uint32_t registrationCount;
+    uint32_t notificationCount;
+    uint32_t i;
+    bool result;
+
+    (void)argc;
+    (void)argv;
+
+    memset(&s_test, 0, sizeof(test_t));
+    s_test.messageId = 1;
+
+    loopback_init(TEST_SEED, &link);
+    if (loopback_listen(TEST_SERVER_HOST, TEST_SERVER_PORT, prv_serverReceive, NULL) == false
+        || prv_start() == false)
+    {
+        return 1;
+    }
+
+    startTime = loopback_now_us();
+    tickTime = startTime;
+    second = 0;
+    changeCount = 0;
+    registrationCount = 0;
+    notificationCount = 0;
+    while (second < TEST_DURATION)
+    {
+        uint64_t deliveryTime;
+
+        deliveryTime = loopback_next_delivery_us();
+        if (deliveryTime < tickTime)
+        {
+            loopback_advance(deliveryTime);
+        }
+        else
+        {
+            // The IOWA timers have a resolution of one second: step the Client every second
+            loopback_advance(tickTime);
+
+            if (second == TEST_OUTAGE_START)
+            {
+                s_test.isDown = true;
+                registrationCount = s_test.registrationCount;
+            }
+            else if (second == TEST_OUTAGE_END)
+            {
+                s_test.isDown = false;
+                notificationCount = s_test.notificationCount;
+            }
+
+            if (second % TEST_CHANGE_PERIOD == TEST_CHANGE_PERIOD / 2
+                && changeCount < TEST_CHANGE_COUNT)
+            {
+                changeCount++;
+                (void)iowa_client_IPSO_update_value(s_test.contextP, s_test.sensorId, (float)(TEST_FIRST_VALUE + changeCount));
+            }
+            (void)iowa_step(s_test.contextP, 0);
+
+            tickTime += TEST_SECOND;
+            second++;
+        }
+        while (loopback_take_ready() != NULL)
+        {
+            (void)iowa_step(s_test.contextP, 0);
+        }
+    }
+
+    printf("Outage of %u s: %u failed registrations, %u Registrations, %u notifications and %u values in %u Send operations received.\r\n",
+           TEST_OUTAGE_END - TEST_OUTAGE_START, s_test.failedCount, s_test.registrationCount, s_test.notificationCount, s_test.sendDataCount, s_test.sendCount);
+
+    result = true;
+    result &= prv_check(registrationCount == 1 && s_test.observeCount == 1, "the Client registers and is observed before the outage");
+    result &= prv_check(s_test.failedCount != 0, "the registration fails during the outage");
+    result &= prv_check(s_test.registrationCount > registrationCount, "the Client registers again after the outage");
+    for (i = 0; i <= TEST_CHANGE_COUNT; i++)
+    {
+        uint32_t changeSecond;
+
+        if (s_test.isReceived[i] == false)
+        {
+            fprintf(stderr, "Value %u was not received.\r\n", TEST_FIRST_VALUE + i);
+            result = false;
+            continue;
+        }
+        // The value changed during the outage are only received in the replay
+        changeSecond = (i == 0) ? 0 : (i - 1) * TEST_CHANGE_PERIOD + TEST_CHANGE_PERIOD / 2;
+        if (changeSecond >= TEST_OUTAGE_START
+            && changeSecond < TEST_OUTAGE_END
+            && s_test.isReplayed[i] == false)
+        {
+            fprintf(stderr, "Value %u changed during the outage was not replayed.\r\n", TEST_FIRST_VALUE + i);
+            result = false;
+        }
+    }
+    result &= prv_check(s_test.notificationCount > notificationCount, "the observation goes on after the replay");
+    result &= prv_check(s_test.errorCount == 0, "the Server receives no unexpected message");
+
+    iowa_client_IPSO_remove_sensor(s_test.contextP, s_test.sensorId);
+    iowa_close(s_test.contextP);
+    loopback_close();
+
+    return (result == true) ? 0 : 1;
+}
@@ -0,0 +1,995 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This program checks the OSCORE protection of the
+ * CoAP messages against the test vectors of
+ * RFC 8613 Appendix C, measures a protected
+ * exchange, then registers a LwM2M Client to a
+ * stand-in LwM2M Server over OSCORE through the
+ * in-process loopback transport.
+ *
+ * The HKDF and AEAD functions of the security
+ * layer use the OpenSSL crypto library.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_security.h"
+#include "iowa_prv_core.h"
+#include "iowa_prv_coap_internals.h"
+#include "iowa_prv_oscore_internals.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+#include "loopback.h"
+
+// OpenSSL headers
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SERVER_ID          1
+#define TEST_SERVER_HOST        "lwm2m.oscore"
+#define TEST_SERVER_PORT        "5683"
+#define TEST_SERVER_URI         "coap://" TEST_SERVER_HOST ":" TEST_SERVER_PORT
+#define TEST_LIFETIME           300
+#define TEST_DURATION           20                  // seconds
+#define TEST_REMOVE_SECOND      10
+#define TEST_MANUFACTURER       "IOWA"
+#define TEST_TOKEN_UNPROTECTED  0xA1                // Read of /3/0/0 sent without OSCORE
+#define TEST_TOKEN_OSCORE       0xA2                // Read of the OSCORE Object
+#define TEST_TOKEN_DEVICE       0xA3                // Read of /3/0/0
+#define TEST_REQUEST_COUNT      3
+#define TEST_SEED               0x2545F491
+#define TEST_SECOND             1000000ULL
+
+#define TEST_ROLE_CLIENT        0
+#define TEST_ROLE_SERVER        1
+
+#define CCM_NONCE_LENGTH        13
+#define CCM_TAG_LENGTH          8
+
+typedef struct
+{
+    // Seen by the Client
+    iowa_context_t          clientP;
+    bool                    isRegistered;
+    // Seen by the stand-in Server
+    iowa_context_t          serverP;                // only used for its OSCORE layer
+    oscore_peer_context_t  *peerContextP;
+    void                   *connP;                  // the connection of the last datagram received
+    uint16_t                messageId;
+    uint32_t                registrationCount;
+    uint32_t                protectedCount;         // requests from the Client verified by the Server
+    uint32_t                errorCount;
+    bool                    isPayloadChecked;       // the Registration lists the Device Object but neither the Security nor the OSCORE Object
+    uint8_t                 responseCode[TEST_REQUEST_COUNT];
+    bool                    isResponseProtected[TEST_REQUEST_COUNT];
+    bool                    isDeviceRead;
+} test_t;
+
+static test_t s_test;
+
+static int s_clientRole = TEST_ROLE_CLIENT;
+static int s_serverRole = TEST_ROLE_SERVER;
+
+// RFC 8613 Appendix C.1.1: the Client Sender ID is empty and the Server Sender ID is 0x01
+static uint8_t s_masterSecret[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10 };
+static uint8_t s_masterSalt[] = { 0x9e, 0x7c, 0xa9, 0x22, 0x23, 0x78, 0x63, 0x40 };
+static uint8_t s_serverId[] = { 0x01 };
+static const uint8_t s_clientKey[] = { 0xf0, 0x91, 0x0e, 0xd7, 0x29, 0x5e, 0x6a, 0xd4, 0xb5, 0x4f, 0xc7, 0x93, 0x15, 0x43, 0x02, 0xff };
+static const uint8_t s_serverKey[] = { 0xff, 0xb1, 0x4e, 0x09, 0x3c, 0x94, 0xc9, 0xca, 0xc9, 0x47, 0x16, 0x48, 0xb4, 0xf9, 0x87, 0x10 };
+static const uint8_t s_commonIV[] = { 0x46, 0x22, 0xd4, 0xdd, 0x6d, 0x94, 0x41, 0x68, 0xee, 0xfb, 0x54, 0x98, 0x7c };
+
+// RFC 8613 Appendix C.4: GET coap://localhost/tv1 with the Sender Sequence Number 20
+#define VECTOR_REQUEST_SEQUENCE_NUMBER 20
+static const uint8_t s_requestOption[] = { 0x09, 0x14 };
+static const uint8_t s_requestCiphertext[] = { 0x61, 0x2f, 0x10, 0x92, 0xf1, 0x77, 0x6f, 0x1c, 0x16, 0x68, 0xb3, 0x82, 0x5e };
+
+// RFC 8613 Appendix C.7: 2.05 Content "Hello World!" without Partial IV
+static const uint8_t s_responseCiphertext[] = { 0xdb, 0xaa, 0xd1, 0xe9, 0xa7, 0xe7, 0xb2, 0xa8, 0x13, 0xd3, 0xc3, 0x15, 0x24, 0x37, 0x83, 0x03, 0xcd, 0xaf, 0xae, 0x11, 0x91, 0x06 };
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+iowa_status_t iowa_system_security_data(const uint8_t *peerIdentity,
+                                        size_t peerIdentityLen,
+                                        iowa_security_operation_t securityOp,
+                                        iowa_security_data_t *securityDataP,
+                                        void *userDataP)
+{
+    iowa_oscore_data_t *oscoreDataP;
+
+    if (securityOp != IOWA_SEC_READ)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+    if (securityDataP->securityMode != IOWA_SEC_OSCORE)
+    {
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    oscoreDataP = &(securityDataP->protocol.oscoreData);
+    oscoreDataP->masterSecret = s_masterSecret;
+    oscoreDataP->masterSecretLen = sizeof(s_masterSecret);
+    oscoreDataP->masterSalt = s_masterSalt;
+    oscoreDataP->masterSaltLen = sizeof(s_masterSalt);
+
+    if (*(int *)userDataP == TEST_ROLE_CLIENT)
+    {
+        // The Client looks the keys up by the Server URI: a single Server is used
+        oscoreDataP->senderId = NULL;
+        oscoreDataP->senderIdLen = 0;
+        oscoreDataP->recipientId = s_serverId;
+        oscoreDataP->recipientIdLen = sizeof(s_serverId);
+    }
+    else
+    {
+        // The Server looks the keys up by the kid, the Sender ID of the Client
+        if (peerIdentityLen != 0)
+        {
+            return IOWA_COAP_404_NOT_FOUND;
+        }
+        (void)peerIdentity;
+
+        oscoreDataP->senderId = s_serverId;
+        oscoreDataP->senderIdLen = sizeof(s_serverId);
+        oscoreDataP->recipientId = NULL;
+        oscoreDataP->recipientIdLen = 0;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Security layer
+*************************************************************************************/
+
+// OSCORE does not use secure sessions
+
+iowa_status_t iowa_user_security_create_client_session(iowa_security_session_t securityS)
+{
+    (void)securityS;
+
+    return IOWA_COAP_501_NOT_IMPLEMENTED;
+}
+
+iowa_status_t iowa_user_security_create_server_session(iowa_security_session_t securityS)
+{
+    (void)securityS;
+
+    return IOWA_COAP_501_NOT_IMPLEMENTED;
+}
+
+void iowa_user_security_delete_session(iowa_security_session_t securityS)
+{
+    (void)securityS;
+}
+
+iowa_status_t iowa_user_security_handle_handshake_packet(iowa_security_session_t securityS)
+{
+    (void)securityS;
+
+    return IOWA_COAP_501_NOT_IMPLEMENTED;
+}
+
+iowa_status_t iowa_user_security_step(iowa_security_session_t securityS)
+{
+    (void)securityS;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+int iowa_user_security_send(iowa_security_session_t securityS,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    (void)securityS;
+    (void)buffer;
+    (void)length;
+
+    return -1;
+}
+
+int iowa_user_security_recv(iowa_security_session_t securityS,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    (void)securityS;
+    (void)buffer;
+    (void)length;
+
+    return -1;
+}
+
+void iowa_user_security_disconnect(iowa_security_session_t securityS)
+{
+    (void)securityS;
+}
+
+iowa_status_t iowa_user_security_HKDF(iowa_security_hash_t hash,
+                                      uint8_t *IKM, size_t IKMLength,
+                                      uint8_t *salt, size_t saltLength,
+                                      uint8_t *info, size_t infoLength,
+                                      uint8_t *OKM, size_t OKMLength)
+{
+    EVP_PKEY_CTX *ctxP;
+    size_t length;
+    iowa_status_t result;
+
+    if (hash != SECURITY_HMAC_SHA256)
+    {
+        return IOWA_COAP_501_NOT_IMPLEMENTED;
+    }
+
+    ctxP = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+    if (ctxP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    length = OKMLength;
+    if (EVP_PKEY_derive_init(ctxP) == 1
+        && EVP_PKEY_CTX_set_hkdf_md(ctxP, EVP_sha256()) == 1
+        && EVP_PKEY_CTX_set1_hkdf_salt(ctxP, salt, (int)saltLength) == 1
+        && EVP_PKEY_CTX_set1_hkdf_key(ctxP, IKM, (int)IKMLength) == 1
+        && EVP_PKEY_CTX_add1_hkdf_info(ctxP, info, (int)infoLength) == 1
+        && EVP_PKEY_derive(ctxP, OKM, &length) == 1
+        && length == OKMLength)
+    {
+        result = IOWA_COAP_NO_ERROR;
+    }
+    else
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    EVP_PKEY_CTX_free(ctxP);
+
+    return result;
+}
+
+// AES-CCM-16-64-128: 13-byte nonce, 8-byte tag and 16-byte key
+static EVP_CIPHER_CTX * prv_ccmNew(iowa_security_aead_t aead,
+                                   size_t keyLength,
+                                   size_t nonceLength,
+                                   size_t tagLength,
+                                   bool isEncrypt)
+{
+    EVP_CIPHER_CTX *ctxP;
+
+    if (aead != SECURITY_AEAD_AES_CCM_16_64_128
+        || keyLength != 16
+        || nonceLength != CCM_NONCE_LENGTH
+        || tagLength != CCM_TAG_LENGTH)
+    {
+        return NULL;
+    }
+
+    ctxP = EVP_CIPHER_CTX_new();
+    if (ctxP == NULL)
+    {
+        return NULL;
+    }
+    if (EVP_CipherInit_ex(ctxP, EVP_aes_128_ccm(), NULL, NULL, NULL, isEncrypt ? 1 : 0) != 1
+        || EVP_CIPHER_CTX_ctrl(ctxP, EVP_CTRL_CCM_SET_IVLEN, CCM_NONCE_LENGTH, NULL) != 1)
+    {
+        EVP_CIPHER_CTX_free(ctxP);
+        return NULL;
+    }
+
+    return ctxP;
+}
+
+iowa_status_t iowa_user_security_AEAD_encrypt(iowa_security_aead_t aead,
+                                              uint8_t *key, size_t keyLength,
+                                              uint8_t *nonce, size_t nonceLength,
+                                              uint8_t *aad, size_t aadLength,
+                                              uint8_t *plainData, size_t plainDataLength,
+                                              uint8_t *encryptedData, size_t *encryptedDataLengthP,
+                                              uint8_t *tag, size_t tagLength)
+{
+    EVP_CIPHER_CTX *ctxP;
+    int length;
+    iowa_status_t result;
+
+    if (*encryptedDataLengthP < plainDataLength)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    ctxP = prv_ccmNew(aead, keyLength, nonceLength, tagLength, true);
+    if (ctxP == NULL)
+    {
+        return IOWA_COAP_501_NOT_IMPLEMENTED;
+    }
+
+    if (EVP_CIPHER_CTX_ctrl(ctxP, EVP_CTRL_CCM_SET_TAG, (int)tagLength, NULL) == 1
+        && EVP_EncryptInit_ex(ctxP, NULL, NULL, key, nonce) == 1
+        && EVP_EncryptUpdate(ctxP, NULL, &length, NULL, (int)plainDataLength) == 1
+        && EVP_EncryptUpdate(ctxP, NULL, &length, aad, (int)aadLength) == 1
+        && EVP_EncryptUpdate(ctxP, encryptedData, &length, plainData, (int)plainDataLength) == 1
+        && EVP_EncryptFinal_ex(ctxP, encryptedData + length, &length) == 1
+        && EVP_CIPHER_CTX_ctrl(ctxP, EVP_CTRL_CCM_GET_TAG, (int)tagLength, tag) == 1)
+    {
+        *encryptedDataLengthP = plainDataLength;
+        result = IOWA_COAP_NO_ERROR;
+    }
+    else
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    EVP_CIPHER_CTX_free(ctxP);
+
+    return result;
+}
+
+iowa_status_t iowa_user_security_AEAD_decrypt(iowa_security_aead_t aead,
+                                              uint8_t *key, size_t keyLength,
+                                              uint8_t *nonce, size_t nonceLength,
+                                              uint8_t *aad, size_t aadLength,
+                                              uint8_t *tag, size_t tagLength,
+                                              uint8_t *encryptedData, size_t encryptedDataLength,
+                                              uint8_t *plainData, size_t *plainDataLengthP)
+{
+    EVP_CIPHER_CTX *ctxP;
+    int length;
+    iowa_status_t result;
+
+    if (*plainDataLengthP < encryptedDataLength)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    ctxP = prv_ccmNew(aead, keyLength, nonceLength, tagLength, false);
+    if (ctxP == NULL)
+    {
+        return IOWA_COAP_501_NOT_IMPLEMENTED;
+    }
+
+    // With CCM, the last update fails when the tag does not match
+    if (EVP_CIPHER_CTX_ctrl(ctxP, EVP_CTRL_CCM_SET_TAG, (int)tagLength, tag) == 1
+        && EVP_DecryptInit_ex(ctxP, NULL, NULL, key, nonce) == 1
+        && EVP_DecryptUpdate(ctxP, NULL, &length, NULL, (int)encryptedDataLength) == 1
+        && EVP_DecryptUpdate(ctxP, NULL, &length, aad, (int)aadLength) == 1
+        && EVP_DecryptUpdate(ctxP, plainData, &length, encryptedData, (int)encryptedDataLength) == 1)
+    {
+        *plainDataLengthP = encryptedDataLength;
+        result = IOWA_COAP_NO_ERROR;
+    }
+    else
+    {
+        result = IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    EVP_CIPHER_CTX_free(ctxP);
+
+    return result;
+}
+
+/*************************************************************************************
+** Helpers
+*************************************************************************************/
+
+static bool prv_check(bool condition,
+                      const char *description)
+{
+    if (condition == false)
+    {
+        fprintf(stderr, "Check failed: %s.\r\n", description);
+    }
+
+    return condition;
+}
+
+static bool prv_isEqual(const uint8_t *buffer,
+                        size_t length,
+                        const uint8_t *expected,
+                        size_t expectedLength)
+{
+    return length == expectedLength
+           && memcmp(buffer, expected, length) == 0;
+}
+
+static bool prv_contains(const uint8_t *buffer,
+                         size_t length,
+                         const char *pattern)
+{
+    size_t patternLength;
+    size_t i;
+
+    patternLength = strlen(pattern);
+    for (i = 0; i + patternLength <= length; i++)
+    {
+        if (memcmp(buffer + i, pattern, patternLength) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool prv_hasUriPath(iowa_coap_message_t *messageP,
+                           const char *path)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_URI_PATH);
+
+    return optionP != NULL
+           && prv_isEqual(optionP->value.asBuffer, optionP->length, (const uint8_t *)path, strlen(path));
+}
+
+// Serialize and parse a message, as the network would. The parsed message points to *bufferP.
+static iowa_coap_message_t * prv_transmit(iowa_coap_message_t *messageP,
+                                          uint8_t **bufferP)
+{
+    iowa_coap_message_t *receivedP;
+    size_t length;
+
+    *bufferP = NULL;
+    length = coapMessageSerializeDatagram(messageP, bufferP);
+    if (length == 0)
+    {
+        return NULL;
+    }
+    if (messageDatagramParse(*bufferP, length, &receivedP) != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        return NULL;
+    }
+
+    return receivedP;
+}
+
+// Protect a message, transmit it and verify it on the other side
+static iowa_status_t prv_protectAndVerify(iowa_context_t senderP,
+                                          oscore_peer_context_t *senderContextP,
+                                          iowa_context_t receiverP,
+                                          oscore_peer_context_t *receiverContextP,
+                                          iowa_coap_message_t *messageP,
+                                          iowa_coap_message_t **plainMessagePP)
+{
+    iowa_coap_message_t *protectedP;
+    iowa_coap_message_t *receivedP;
+    uint8_t *bufferP;
+    iowa_status_t result;
+
+    *plainMessagePP = NULL;
+
+    result = oscore_encryptMessage(senderP, senderContextP, messageP, &protectedP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+    if (protectedP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    receivedP = prv_transmit(protectedP, &bufferP);
+    iowa_coap_message_free(protectedP);
+    if (receivedP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    result = oscore_decryptMessage(receiverP, NULL, receiverContextP, receivedP, plainMessagePP);
+
+    iowa_coap_message_free(receivedP);
+    iowa_system_free(bufferP);
+
+    return result;
+}
+
+/*************************************************************************************
+** Test vectors
+*************************************************************************************/
+
+static bool prv_checkVectors(unsigned long iterations)
+{
+    iowa_context_t clientP;
+    iowa_context_t serverP;
+    oscore_peer_context_t *clientContextP;
+    oscore_peer_context_t *serverContextP;
+    iowa_coap_message_t *requestP;
+    iowa_coap_message_t *responseP;
+    iowa_coap_message_t *protectedP;
+    iowa_coap_message_t *receivedP;
+    iowa_coap_message_t *plainP;
+    iowa_coap_option_t *optionP;
+    uint8_t *bufferP;
+    uint8_t token[2];
+    uint64_t startTime;
+    uint64_t duration;
+    unsigned long i;
+    bool result;
+
+    clientP = iowa_init(&s_clientRole);
+    serverP = iowa_init(&s_serverRole);
+    if (clientP == NULL
+        || serverP == NULL)
+    {
+        fprintf(stderr, "Failed to create the contexts.\r\n");
+        return false;
+    }
+
+    result = true;
+    token[0] = 0x4a;
+    token[1] = 0x4b;
+
+    // C.1.1: key derivation
+    clientContextP = oscore_contextCreateFromURI(clientP, "coap://localhost");
+    if (prv_check(clientContextP != NULL, "the Client derives its security context") == false)
+    {
+        iowa_close(clientP);
+        iowa_close(serverP);
+        return false;
+    }
+    result &= prv_check(prv_isEqual(clientContextP->senderKey, PRV_OSCORE_KEY_LENGTH, s_clientKey, sizeof(s_clientKey)), "the Client Sender Key matches C.1.1");
+    result &= prv_check(prv_isEqual(clientContextP->recipientKey, PRV_OSCORE_KEY_LENGTH, s_serverKey, sizeof(s_serverKey)), "the Client Recipient Key matches C.1.1");
+    result &= prv_check(prv_isEqual(clientContextP->commonIV, PRV_OSCORE_NONCE_LENGTH, s_commonIV, sizeof(s_commonIV)), "the Common IV matches C.1.1");
+
+    // C.4: protected request
+    clientContextP->sequenceP->senderSequenceNumber = VECTOR_REQUEST_SEQUENCE_NUMBER;
+    requestP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, 2, token);
+    iowa_coap_message_add_option(requestP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_HOST, "localhost", '/'));
+    iowa_coap_message_add_option(requestP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, "tv1", '/'));
+    requestP->id = 1;
+
+    protectedP = NULL;
+    result &= prv_check(oscore_encryptMessage(clientP, clientContextP, requestP, &protectedP) == IOWA_COAP_NO_ERROR && protectedP != NULL, "the Client protects the request");
+    if (protectedP == NULL)
+    {
+        result = false;
+        goto exit;
+    }
+    optionP = iowa_coap_message_find_option(protectedP, IOWA_COAP_OPTION_OSCORE);
+    result &= prv_check(optionP != NULL && prv_isEqual(optionP->value.asBuffer, optionP->length, s_requestOption, sizeof(s_requestOption)), "the OSCORE option matches C.4");
+    result &= prv_check(prv_isEqual(protectedP->payload.data, protectedP->payload.length, s_requestCiphertext, sizeof(s_requestCiphertext)), "the request ciphertext matches C.4");
+    result &= prv_check(protectedP->code == IOWA_COAP_CODE_POST, "the protected request is a POST");
+    result &= prv_check(iowa_coap_message_find_option(protectedP, IOWA_COAP_OPTION_URI_HOST) != NULL, "the Uri-Host option is not encrypted");
+    result &= prv_check(iowa_coap_message_find_option(protectedP, IOWA_COAP_OPTION_URI_PATH) == NULL, "the Uri-Path option is encrypted");
+
+    // The Server finds its keys from the kid
+    receivedP = prv_transmit(protectedP, &bufferP);
+    iowa_coap_message_free(protectedP);
+    if (receivedP == NULL)
+    {
+        result = prv_check(false, "the protected request is transmitted");
+        goto exit;
+    }
+    serverContextP = NULL;
+    optionP = iowa_coap_message_find_option(receivedP, IOWA_COAP_OPTION_OSCORE);
+    result &= prv_check(oscore_contextCreateFromOption(serverP, optionP, &serverContextP) == IOWA_COAP_NO_ERROR && serverContextP != NULL, "the Server derives its security context");
+    if (serverContextP == NULL)
+    {
+        iowa_coap_message_free(receivedP);
+        iowa_system_free(bufferP);
+        result = false;
+        goto exit;
+    }
+    result &= prv_check(oscore_decryptMessage(serverP, NULL, serverContextP, receivedP, &plainP) == IOWA_COAP_NO_ERROR, "the Server verifies the request");
+    if (plainP != NULL)
+    {
+        result &= prv_check(plainP->code == IOWA_COAP_CODE_GET && prv_hasUriPath(plainP, "tv1"), "the Server reads GET /tv1");
+        iowa_coap_message_free(plainP);
+    }
+    plainP = NULL;
+    result &= prv_check(oscore_decryptMessage(serverP, NULL, serverContextP, receivedP, &plainP) == IOWA_COAP_401_UNAUTHORIZED, "the Server rejects a replayed request");
+    iowa_coap_message_free(plainP);
+    iowa_coap_message_free(receivedP);
+    iowa_system_free(bufferP);
+
+    // C.7: protected response
+    responseP = iowa_coap_message_new(IOWA_COAP_TYPE_ACKNOWLEDGEMENT, IOWA_COAP_205_CONTENT, 2, token);
+    responseP->payload.data = (uint8_t *)"Hello World!";
+    responseP->payload.length = 12;
+    responseP->id = 1;
+
+    protectedP = NULL;
+    result &= prv_check(oscore_encryptMessage(serverP, serverContextP, responseP, &protectedP) == IOWA_COAP_NO_ERROR && protectedP != NULL, "the Server protects the response");
+    if (protectedP != NULL)
+    {
+        result &= prv_check(prv_isEqual(protectedP->payload.data, protectedP->payload.length, s_responseCiphertext, sizeof(s_responseCiphertext)), "the response ciphertext matches C.7");
+        result &= prv_check(protectedP->code == IOWA_COAP_204_CHANGED, "the protected response is a 2.04");
+
+        receivedP = prv_transmit(protectedP, &bufferP);
+        iowa_coap_message_free(protectedP);
+        plainP = NULL;
+        result &= prv_check(receivedP != NULL && oscore_decryptMessage(clientP, NULL, clientContextP, receivedP, &plainP) == IOWA_COAP_NO_ERROR, "the Client verifies the response");
+        if (plainP != NULL)
+        {
+            result &= prv_check(plainP->code == IOWA_COAP_205_CONTENT && prv_isEqual(plainP->payload.data, plainP->payload.length, (const uint8_t *)"Hello World!", 12), "the Client reads 2.05 Hello World!");
+            iowa_coap_message_free(plainP);
+        }
+        if (receivedP != NULL)
+        {
+            iowa_coap_message_free(receivedP);
+            iowa_system_free(bufferP);
+        }
+    }
+
+    // A modified request must not be accepted
+    protectedP = NULL;
+    (void)oscore_encryptMessage(clientP, clientContextP, requestP, &protectedP);
+    receivedP = (protectedP == NULL) ? NULL : prv_transmit(protectedP, &bufferP);
+    iowa_coap_message_free(protectedP);
+    if (prv_check(receivedP != NULL, "the Client protects a second request") == true)
+    {
+        plainP = NULL;
+        receivedP->payload.data[0] ^= 0x01;
+        result &= prv_check(oscore_decryptMessage(serverP, NULL, serverContextP, receivedP, &plainP) == IOWA_COAP_400_BAD_REQUEST, "the Server rejects a modified request");
+        iowa_coap_message_free(plainP);
+        plainP = NULL;
+        receivedP->payload.data[0] ^= 0x01;
+        result &= prv_check(oscore_decryptMessage(serverP, NULL, serverContextP, receivedP, &plainP) == IOWA_COAP_NO_ERROR, "the Server accepts the request once restored");
+        iowa_coap_message_free(plainP);
+        iowa_coap_message_free(receivedP);
+        iowa_system_free(bufferP);
+    }
+    else
+    {
+        result = false;
+    }
+
+    // Measure a protected exchange
+    startTime = bench_now_ns();
+    for (i = 0; i < iterations && result == true; i++)
+    {
+        result &= prv_check(prv_protectAndVerify(clientP, clientContextP, serverP, serverContextP, requestP, &plainP) == IOWA_COAP_NO_ERROR, "the Server verifies a request");
+        iowa_coap_message_free(plainP);
+        result &= prv_check(prv_protectAndVerify(serverP, serverContextP, clientP, clientContextP, responseP, &plainP) == IOWA_COAP_NO_ERROR, "the Client verifies a response");
+        iowa_coap_message_free(plainP);
+    }
+    duration = bench_now_ns() - startTime;
+    if (result == true)
+    {
+        printf("Protected exchange: %.0f ns (protection and verification of a request and its response, CoAP encoding included)\r\n", (double)duration / (double)iterations);
+    }
+
+    iowa_coap_message_free(responseP);
+    oscore_contextDelete(serverContextP);
+
+exit:
+    iowa_coap_message_free(requestP);
+    oscore_contextDelete(clientContextP);
+    iowa_close(clientP);
+    iowa_close(serverP);
+
+    return result;
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Server
+*************************************************************************************/
+
+static void prv_serverSend(iowa_coap_message_t *messageP,
+                           bool isProtected)
+{
+    iowa_coap_message_t *protectedP;
+    uint8_t *bufferP;
+    size_t length;
+
+    protectedP = NULL;
+    if (isProtected == true)
+    {
+        if (oscore_encryptMessage(s_test.serverP, s_test.peerContextP, messageP, &protectedP) != IOWA_COAP_NO_ERROR
+            || protectedP == NULL)
+        {
+            s_test.errorCount++;
+            return;
+        }
+        messageP = protectedP;
+    }
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0)
+    {
+        s_test.errorCount++;
+    }
+    else
+    {
+        loopback_reply(s_test.connP, bufferP, length);
+        iowa_system_free(bufferP);
+    }
+    iowa_coap_message_free(protectedP);
+}
+
+static void prv_serverRead(uint8_t token,
+                           const char *path,
+                           bool isProtected)
+{
+    iowa_coap_message_t *messageP;
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_GET, 1, &token);
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, path, '/'));
+    messageP->id = s_test.messageId++;
+
+    prv_serverSend(messageP, isProtected);
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_serverHandleRequest(iowa_coap_message_t *requestP)
+{
+    iowa_coap_message_t *responseP;
+    uint8_t code;
+
+    if (requestP->code == IOWA_COAP_CODE_POST
+        && prv_hasUriPath(requestP, "rd") == true)
+    {
+        // Registration: the Objects not exposed to the Server must not be listed
+        s_test.registrationCount++;
+        s_test.isPayloadChecked = prv_contains(requestP->payload.data, requestP->payload.length, "</3/0>") == true
+                                  && prv_contains(requestP->payload.data, requestP->payload.length, "</0") == false
+                                  && prv_contains(requestP->payload.data, requestP->payload.length, "</21") == false;
+        code = IOWA_COAP_201_CREATED;
+    }
+    else
+    {
+        code = IOWA_COAP_204_CHANGED;
+    }
+
+    responseP = iowa_coap_message_prepare_response(requestP, code);
+    if (code == IOWA_COAP_201_CREATED)
+    {
+        iowa_coap_message_add_option(responseP, iowa_coap_path_to_option(IOWA_COAP_OPTION_LOCATION_PATH, "rd/0", '/'));
+    }
+    prv_serverSend(responseP, true);
+    iowa_coap_message_free(responseP);
+}
+
+static void prv_serverHandleResponse(iowa_coap_message_t *responseP,
+                                     bool isProtected)
+{
+    size_t index;
+
+    if (responseP->tokenLength != 1
+        || responseP->token[0] < TEST_TOKEN_UNPROTECTED
+        || responseP->token[0] >= TEST_TOKEN_UNPROTECTED + TEST_REQUEST_COUNT)
+    {
+        s_test.errorCount++;
+        return;
+    }
+
+    index = responseP->token[0] - TEST_TOKEN_UNPROTECTED;
+    s_test.responseCode[index] = responseP->code;
+    s_test.isResponseProtected[index] = isProtected;
+    if (responseP->token[0] == TEST_TOKEN_DEVICE
+        && responseP->code == IOWA_COAP_205_CONTENT)
+    {
+        s_test.isDeviceRead = prv_contains(responseP->payload.data, responseP->payload.length, TEST_MANUFACTURER);
+    }
+}
+
+static void prv_serverReceive(void *connP,
+                              const uint8_t *buffer,
+                              size_t length,
+                              void *userDataP)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_message_t *plainP;
+    iowa_coap_option_t *optionP;
+
+    (void)userDataP;
+
+    s_test.connP = connP;
+
+    if (messageDatagramParse((uint8_t *)buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        s_test.errorCount++;
+        return;
+    }
+
+    if (messageP->code == IOWA_COAP_CODE_EMPTY)
+    {
+        iowa_coap_message_free(messageP);
+        return;
+    }
+
+    plainP = NULL;
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OSCORE);
+    if (optionP != NULL)
+    {
+        if (s_test.peerContextP == NULL)
+        {
+            (void)oscore_contextCreateFromOption(s_test.serverP, optionP, &s_test.peerContextP);
+        }
+        if (s_test.peerContextP == NULL
+            || oscore_decryptMessage(s_test.serverP, NULL, s_test.peerContextP, messageP, &plainP) != IOWA_COAP_NO_ERROR)
+        {
+            s_test.errorCount++;
+            iowa_coap_message_free(messageP);
+            return;
+        }
+    }
+
+    if (COAP_IS_REQUEST(messageP->code))
+    {
+        if (plainP == NULL)
+        {
+            // The Client must protect all its requests
+            s_test.errorCount++;
+        }
+        else
+        {
+            s_test.protectedCount++;
+            prv_serverHandleRequest(plainP);
+        }
+    }
+    else
+    {
+        prv_serverHandleResponse(plainP != NULL ? plainP : messageP, plainP != NULL);
+    }
+
+    iowa_coap_message_free(plainP);
+    iowa_coap_message_free(messageP);
+}
+
+/*************************************************************************************
+** LwM2M Client
+*************************************************************************************/
+
+static void prv_eventCallback(iowa_event_t *eventP,
+                              void *userData,
+                              iowa_context_t contextP)
+{
+    (void)userData;
+    (void)contextP;
+
+    if (eventP->eventType == IOWA_EVENT_REG_REGISTERED)
+    {
+        s_test.isRegistered = true;
+    }
+}
+
+static bool prv_hasOscoreInstance(void)
+{
+    return object_find(s_test.clientP, IOWA_LWM2M_OSCORE_OBJECT_ID, 0, IOWA_LWM2M_ID_ALL, NULL, NULL, NULL) == IOWA_COAP_NO_ERROR;
+}
+
+static bool prv_checkClient(void)
+{
+    static const loopback_link_t link = { 0, 20000, 20000, 0, 0 };
+    iowa_device_info_t devInfo;
+    uint64_t tickTime;
+    uint32_t second;
+    bool hasInstance;
+    bool result;
+
+    memset(&s_test, 0, sizeof(test_t));
+    s_test.messageId = 1;
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = TEST_MANUFACTURER;
+    devInfo.modelNumber = "OSCORE";
+
+    loopback_init(TEST_SEED, &link);
+    s_test.clientP = iowa_init(&s_clientRole);
+    s_test.serverP = iowa_init(&s_serverRole);
+    if (loopback_listen(TEST_SERVER_HOST, TEST_SERVER_PORT, prv_serverReceive, NULL) == false
+        || s_test.clientP == NULL
+        || s_test.serverP == NULL
+        || iowa_client_configure(s_test.clientP, "oscore", &devInfo, prv_eventCallback) != IOWA_COAP_NO_ERROR
+        || iowa_client_add_server(s_test.clientP, TEST_SERVER_ID, TEST_SERVER_URI, TEST_LIFETIME, 0, IOWA_SEC_OSCORE) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create the Client.\r\n");
+        return false;
+    }
+
+    hasInstance = prv_hasOscoreInstance();
+
+    tickTime = loopback_now_us();
+    second = 0;
+    while (second < TEST_DURATION)
+    {
+        uint64_t deliveryTime;
+
+        deliveryTime = loopback_next_delivery_us();
+        if (deliveryTime < tickTime)
+        {
+            loopback_advance(deliveryTime);
+        }
+        else
+        {
+            loopback_advance(tickTime);
+
+            if (s_test.isRegistered == true
+                && s_test.messageId == 1)
+            {
+                prv_serverRead(TEST_TOKEN_UNPROTECTED, "3/0/0", false);
+                prv_serverRead(TEST_TOKEN_OSCORE, "21/0", true);
+                prv_serverRead(TEST_TOKEN_DEVICE, "3/0/0", true);
+            }
+            if (second == TEST_REMOVE_SECOND)
+            {
+                (void)iowa_client_remove_server(s_test.clientP, TEST_SERVER_ID);
+            }
+            (void)iowa_step(s_test.clientP, 0);
+
+            tickTime += TEST_SECOND;
+            second++;
+        }
+        while (loopback_take_ready() != NULL)
+        {
+            (void)iowa_step(s_test.clientP, 0);
+        }
+    }
+
+    printf("LwM2M Client over OSCORE: %u Registration and %u protected requests received.\r\n",
+           s_test.registrationCount, s_test.protectedCount);
+
+    result = true;
+    result &= prv_check(hasInstance == true, "the OSCORE Object instance is created with the Server");
+    result &= prv_check(s_test.isRegistered == true && s_test.registrationCount == 1, "the Client registers over OSCORE");
+    result &= prv_check(s_test.isPayloadChecked == true, "the Registration lists neither the Security nor the OSCORE Object");
+    result &= prv_check(s_test.responseCode[0] == IOWA_COAP_401_UNAUTHORIZED && s_test.isResponseProtected[0] == false, "an unprotected request is refused with 4.01");
+    result &= prv_check(s_test.responseCode[1] == IOWA_COAP_401_UNAUTHORIZED && s_test.isResponseProtected[1] == true, "the OSCORE Object cannot be read by the Server");
+    result &= prv_check(s_test.responseCode[2] == IOWA_COAP_205_CONTENT && s_test.isResponseProtected[2] == true && s_test.isDeviceRead == true, "a protected Read is answered with a protected response");
+    result &= prv_check(prv_hasOscoreInstance() == false, "the OSCORE Object instance is removed with the Server");
+    result &= prv_check(s_test.errorCount == 0, "the Server receives no unexpected message");
+
+    oscore_contextDelete(s_test.peerContextP);
+    iowa_close(s_test.clientP);
+    iowa_close(s_test.serverP);
+    loopback_close();
+
+    return result;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    unsigned long iterations;
+    bool result;
+
+    iterations = bench_get_iterations(argc, argv);
+
+    result = prv_checkVectors(iterations);
+    result &= prv_checkClient();
+
+    return (result == true) ? 0 : 1;
+}
@@ -0,0 +1,893 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This program checks the server side of the
+ * secure sessions of a LwM2M Server over the
+ * in-process loopback transport.
+ *
+ * The security layer is a stand-in for DTLS: its
+ * records have the DTLS layout, so that IOWA can
+ * inspect them, but they are only protected by a
+ * one byte checksum keyed per session. The keyed
+ * hash used by IOWA for the DTLS cookies is a
+ * stand-in for HKDF too.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_server.h"
+#include "iowa_security.h"
+#include "iowa_prv_coap_internals.h"
+
+// Benchmark helpers
+#include "loopback.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SEED                   0x2545F491
+#define TEST_DATAGRAM_SIZE          256
+#define TEST_CID_LENGTH             4
+#define TEST_SECOND                 1000000ULL
+
+// Stand-in DTLS records: content type (1 byte), version (2 bytes), epoch (2 bytes), sequence number (6 bytes),
+// Connection ID (TEST_CID_LENGTH bytes, tls12_cid records only), length (2 bytes), payload, checksum (1 byte)
+#define RECORD_HANDSHAKE            22
+#define RECORD_APPLICATION_DATA     23
+#define RECORD_TLS12_CID            25
+#define RECORD_HEADER_SIZE          13
+#define RECORD_CID_HEADER_SIZE      (RECORD_HEADER_SIZE + TEST_CID_LENGTH)
+#define HANDSHAKE_CLIENT_HELLO      1
+#define HANDSHAKE_SERVER_HELLO      2
+#define HANDSHAKE_HELLO_VERIFY      3
+#define HANDSHAKE_HEADER_SIZE       12
+#define CLIENT_HELLO_COOKIE_OFFSET  (2 + 32 + 1)                        // after the version, the random and an empty session ID
+#define CLIENT_HELLO_BODY_SIZE      (2 + 32 + 1 + 1 + 2 + 2 + 1 + 1)   // no session ID, no cookie, one cipher suite, no compression
+#define COOKIE_MAX_LENGTH           32
+
+// The state of the stand-in security layer for a session
+typedef struct
+{
+    uint8_t key;
+    uint8_t connectionId[TEST_CID_LENGTH];
+} session_t;
+
+// A stand-in LwM2M Client, or an attacker knowing the Connection ID of a Client but not its key
+typedef struct
+{
+    const char *name;
+    void       *connP;                  // the connection of the last datagram sent
+    void       *lastReplyConnP;         // the connection of the last datagram received
+    uint8_t     random;                 // the first byte of the ClientHello random
+    uint8_t     cookie[COOKIE_MAX_LENGTH];
+    size_t      cookieLength;
+    uint32_t    helloVerifyCount;
+    uint8_t     key;
+    uint8_t     connectionId[TEST_CID_LENGTH];
+    bool        isConnected;
+    uint16_t    messageId;
+    uint8_t     token;
+    char        path[32];               // the Location-Path of the registration
+    uint32_t    createdCount;
+    uint32_t    changedCount;
+    uint32_t    otherCount;
+} client_t;
+
+static iowa_context_t s_contextP;
+static uint8_t s_nextConnectionId;
+static size_t s_connectionIdLength;
+static uint32_t s_refusedConnectionIdCount;
+static bool s_holdHandshakes;                   // the handshakes make no progress while set
+static iowa_security_session_t s_heldSessionArray[IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES];
+static size_t s_heldCount;
+static uint32_t s_registeredCount;
+static uint32_t s_updatingCount;
+static uint32_t s_failureCount;
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void iowa_system_free(void *pointer)
+{
+    free(pointer);
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+/*************************************************************************************
+** Stand-in security layer
+*************************************************************************************/
+
+static uint8_t prv_checksum(uint8_t key,
+                            const uint8_t *buffer,
+                            size_t length)
+{
+    uint8_t sum;
+    size_t i;
+
+    sum = key;
+    for (i = 0; i < length; i++)
+    {
+        sum = (uint8_t)(sum + buffer[i]);
+    }
+
+    return sum;
+}
+
+// Returned value: the length of the record.
+static size_t prv_writeRecord(uint8_t *record,
+                              uint8_t type,
+                              const uint8_t *connectionId,
+                              uint8_t key,
+                              const uint8_t *payload,
+                              size_t length)
+{
+    size_t headerSize;
+
+    memset(record, 0, RECORD_CID_HEADER_SIZE);
+    record[0] = type;
+    record[1] = 0xFE;
+    record[2] = 0xFD;
+    record[4] = (type == RECORD_HANDSHAKE) ? 0 : 1;
+    headerSize = RECORD_HEADER_SIZE;
+    if (type == RECORD_TLS12_CID)
+    {
+        memcpy(record + RECORD_HEADER_SIZE - 2, connectionId, TEST_CID_LENGTH);
+        headerSize = RECORD_CID_HEADER_SIZE;
+    }
+    record[headerSize - 2] = (uint8_t)((length + 1) >> 8);
+    record[headerSize - 1] = (uint8_t)(length + 1);
+    memcpy(record + headerSize, payload, length);
+    record[headerSize + length] = prv_checksum(key, payload, length);
+
+    return headerSize + length + 1;
+}
+
+// Returned value: the payload length, or -1 if the record is not of this type or fails the checksum.
+static int prv_readRecord(const uint8_t *record,
+                          size_t recordLength,
+                          uint8_t type,
+                          const uint8_t *connectionId,
+                          uint8_t key,
+                          const uint8_t **payloadP)
+{
+    size_t headerSize;
+    size_t length;
+
+    headerSize = (type == RECORD_TLS12_CID) ? RECORD_CID_HEADER_SIZE : RECORD_HEADER_SIZE;
+    if (recordLength < headerSize + 1
+        || record[0] != type)
+    {
+        return -1;
+    }
+    if (type == RECORD_TLS12_CID
+        && memcmp(record + RECORD_HEADER_SIZE - 2, connectionId, TEST_CID_LENGTH) != 0)
+    {
+        return -1;
+    }
+    length = ((size_t)record[headerSize - 2] << 8) | record[headerSize - 1];
+    if (length != recordLength - headerSize
+        || (type != RECORD_HANDSHAKE && record[headerSize + length - 1] != prv_checksum(key, record + headerSize, length - 1)))
+    {
+        return -1;
+    }
+
+    *payloadP = record + headerSize;
+
+    return (int)length - 1;
+}
+
+iowa_status_t iowa_user_security_create_client_session(iowa_security_session_t securityS)
+{
+    (void)securityS;
+
+    return IOWA_COAP_501_NOT_IMPLEMENTED;
+}
+
+iowa_status_t iowa_user_security_create_server_session(iowa_security_session_t securityS)
+{
+    session_t *sessionP;
+
+    sessionP = (session_t *)calloc(1, sizeof(session_t));
+    if (sessionP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    iowa_security_session_set_user_internals(securityS, sessionP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void iowa_user_security_delete_session(iowa_security_session_t securityS)
+{
+    free(iowa_security_session_get_user_internals(securityS));
+}
+
+// A keyed hash standing for HKDF: each output byte depends on the key, on the info and on its position
+iowa_status_t iowa_user_security_HKDF(iowa_security_hash_t hash,
+                                      uint8_t *IKM, size_t IKMLength,
+                                      uint8_t *salt, size_t saltLength,
+                                      uint8_t *info, size_t infoLength,
+                                      uint8_t *OKM, size_t OKMLength)
+{
+    uint32_t state;
+    size_t i;
+    size_t j;
+
+    (void)hash;
+    (void)salt;
+    (void)saltLength;
+
+    for (i = 0; i < OKMLength; i++)
+    {
+        state = 2166136261u ^ (uint32_t)i;
+        for (j = 0; j < IKMLength; j++)
+        {
+            state = (state ^ IKM[j]) * 16777619u;
+        }
+        for (j = 0; j < infoLength; j++)
+        {
+            state = (state ^ info[j]) * 16777619u;
+        }
+        OKM[i] = (uint8_t)(state >> 24);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Answer a ClientHello with a ServerHello carrying the Connection ID and the key of the session
+iowa_status_t iowa_user_security_handle_handshake_packet(iowa_security_session_t securityS)
+{
+    session_t *sessionP;
+    uint8_t record[TEST_DATAGRAM_SIZE];
+    uint8_t hello[HANDSHAKE_HEADER_SIZE + TEST_CID_LENGTH + 1];
+    const uint8_t *payload;
+    int length;
+
+    sessionP = (session_t *)iowa_security_session_get_user_internals(securityS);
+
+    // IOWA already checked the cookie of the ClientHello
+    length = iowa_security_connection_recv(securityS, record, sizeof(record));
+    if (length <= 0
+        || prv_readRecord(record, (size_t)length, RECORD_HANDSHAKE, NULL, 0, &payload) < HANDSHAKE_HEADER_SIZE + CLIENT_HELLO_COOKIE_OFFSET + 1
+        || payload[0] != HANDSHAKE_CLIENT_HELLO
+        || payload[HANDSHAKE_HEADER_SIZE + CLIENT_HELLO_COOKIE_OFFSET] == 0)
+    {
+        iowa_security_session_set_state(securityS, SECURITY_STATE_CONNECTION_FAILED);
+        iowa_security_session_generate_event(securityS, SECURITY_EVENT_DISCONNECTED);
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if (s_holdHandshakes == true
+        && s_heldCount < IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES)
+    {
+        // Like a handshake waiting for the next flight of the peer
+        s_heldSessionArray[s_heldCount] = securityS;
+        s_heldCount++;
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    sessionP->key = (uint8_t)loopback_random();
+    memset(sessionP->connectionId, 0xC1, TEST_CID_LENGTH);
+    sessionP->connectionId[TEST_CID_LENGTH - 1] = s_nextConnectionId++;
+
+    memset(hello, 0, sizeof(hello));
+    hello[0] = HANDSHAKE_SERVER_HELLO;
+    memcpy(hello + HANDSHAKE_HEADER_SIZE, sessionP->connectionId, TEST_CID_LENGTH);
+    hello[HANDSHAKE_HEADER_SIZE + TEST_CID_LENGTH] = sessionP->key;
+    length = (int)prv_writeRecord(record, RECORD_HANDSHAKE, NULL, 0, hello, sizeof(hello));
+    if (iowa_security_connection_send(securityS, record, (size_t)length) != length)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    if (iowa_security_session_set_connection_id(securityS, sessionP->connectionId, s_connectionIdLength) != IOWA_COAP_NO_ERROR)
+    {
+        s_refusedConnectionIdCount++;
+    }
+    iowa_security_session_set_state(securityS, SECURITY_STATE_CONNECTED);
+    iowa_security_session_generate_event(securityS, SECURITY_EVENT_CONNECTED);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_user_security_step(iowa_security_session_t securityS)
+{
+    (void)securityS;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+int iowa_user_security_send(iowa_security_session_t securityS,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    session_t *sessionP;
+    uint8_t record[TEST_DATAGRAM_SIZE];
+    size_t recordLength;
+
+    sessionP = (session_t *)iowa_security_session_get_user_internals(securityS);
+
+    if (length + RECORD_HEADER_SIZE + 1 > sizeof(record))
+    {
+        return -1;
+    }
+    recordLength = prv_writeRecord(record, RECORD_APPLICATION_DATA, NULL, sessionP->key, buffer, length);
+    if (iowa_security_connection_send(securityS, record, recordLength) != (int)recordLength)
+    {
+        return -1;
+    }
+
+    return (int)length;
+}
+
+// The Clients send tls12_cid records. The ones failing the checksum are rejected.
+int iowa_user_security_recv(iowa_security_session_t securityS,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    session_t *sessionP;
+    uint8_t record[TEST_DATAGRAM_SIZE];
+    const uint8_t *payload;
+    int recordLength;
+    int payloadLength;
+
+    sessionP = (session_t *)iowa_security_session_get_user_internals(securityS);
+
+    recordLength = iowa_security_connection_recv(securityS, record, sizeof(record));
+    if (recordLength <= 0)
+    {
+        return recordLength;
+    }
+    payloadLength = prv_readRecord(record, (size_t)recordLength, RECORD_TLS12_CID, sessionP->connectionId, sessionP->key, &payload);
+    if (payloadLength < 0
+        || (size_t)payloadLength > length)
+    {
+        return -1;
+    }
+    memcpy(buffer, payload, (size_t)payloadLength);
+
+    return payloadLength;
+}
+
+void iowa_user_security_disconnect(iowa_security_session_t securityS)
+{
+    (void)securityS;
+}
+
+/*************************************************************************************
+** Stand-in LwM2M Clients
+*************************************************************************************/
+
+static void prv_clientReceive(void *connP,
+                              const uint8_t *buffer,
+                              size_t length,
+                              void *userDataP)
+{
+    client_t *clientP;
+    const uint8_t *payload;
+    int payloadLength;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    clientP = (client_t *)userDataP;
+    clientP->lastReplyConnP = connP;
+
+    if (buffer[0] == RECORD_HANDSHAKE
+        && length > RECORD_HEADER_SIZE + HANDSHAKE_HEADER_SIZE + 3
+        && buffer[RECORD_HEADER_SIZE] == HANDSHAKE_HELLO_VERIFY)
+    {
+        // Sent by IOWA, without the record checksum of the stand-in security layer
+        payload = buffer + RECORD_HEADER_SIZE + HANDSHAKE_HEADER_SIZE;
+        if (buffer[2] != 0xFF
+            || payload[2] > COOKIE_MAX_LENGTH
+            || length != RECORD_HEADER_SIZE + HANDSHAKE_HEADER_SIZE + 3 + (size_t)payload[2])
+        {
+            clientP->otherCount++;
+            return;
+        }
+        memcpy(clientP->cookie, payload + 3, payload[2]);
+        clientP->cookieLength = payload[2];
+        clientP->helloVerifyCount++;
+        return;
+    }
+
+    if (buffer[0] == RECORD_HANDSHAKE)
+    {
+        payloadLength = prv_readRecord(buffer, length, RECORD_HANDSHAKE, NULL, 0, &payload);
+        if (payloadLength != HANDSHAKE_HEADER_SIZE + TEST_CID_LENGTH + 1
+            || payload[0] != HANDSHAKE_SERVER_HELLO)
+        {
+            clientP->otherCount++;
+            return;
+        }
+        memcpy(clientP->connectionId, payload + HANDSHAKE_HEADER_SIZE, TEST_CID_LENGTH);
+        clientP->key = payload[HANDSHAKE_HEADER_SIZE + TEST_CID_LENGTH];
+        clientP->isConnected = true;
+        return;
+    }
+
+    payloadLength = prv_readRecord(buffer, length, RECORD_APPLICATION_DATA, NULL, clientP->key, &payload);
+    if (payloadLength <= 0
+        || messageDatagramParse((uint8_t *)payload, (size_t)payloadLength, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        clientP->otherCount++;
+        return;
+    }
+
+    switch (messageP->code)
+    {
+    case IOWA_COAP_201_CREATED:
+        clientP->createdCount++;
+        clientP->path[0] = 0;
+        for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+        {
+            if (optionP->number == IOWA_COAP_OPTION_LOCATION_PATH
+                && strlen(clientP->path) + optionP->length + 2 <= sizeof(clientP->path))
+            {
+                if (clientP->path[0] != 0)
+                {
+                    strcat(clientP->path, "/");
+                }
+                strncat(clientP->path, (char *)optionP->value.asBuffer, optionP->length);
+            }
+        }
+        break;
+
+    case IOWA_COAP_204_CHANGED:
+        clientP->changedCount++;
+        break;
+
+    default:
+        clientP->otherCount++;
+        break;
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+// Send a ClientHello, with the cookie of the last HelloVerifyRequest if any
+static void prv_clientSendHello(client_t *clientP)
+{
+    uint8_t hello[HANDSHAKE_HEADER_SIZE + CLIENT_HELLO_BODY_SIZE + COOKIE_MAX_LENGTH];
+    uint8_t record[TEST_DATAGRAM_SIZE];
+    size_t bodySize;
+    size_t length;
+
+    bodySize = CLIENT_HELLO_BODY_SIZE + clientP->cookieLength;
+
+    memset(hello, 0, sizeof(hello));
+    hello[0] = HANDSHAKE_CLIENT_HELLO;
+    hello[3] = (uint8_t)bodySize;
+    hello[5] = (clientP->cookieLength == 0) ? 0 : 1;
+    hello[11] = (uint8_t)bodySize;
+    hello[HANDSHAKE_HEADER_SIZE] = 0xFE;
+    hello[HANDSHAKE_HEADER_SIZE + 1] = 0xFD;
+    hello[HANDSHAKE_HEADER_SIZE + 2] = clientP->random;
+    hello[HANDSHAKE_HEADER_SIZE + CLIENT_HELLO_COOKIE_OFFSET] = (uint8_t)clientP->cookieLength;
+    memcpy(hello + HANDSHAKE_HEADER_SIZE + CLIENT_HELLO_COOKIE_OFFSET + 1, clientP->cookie, clientP->cookieLength);
+
+    // The record checksum is not part of the ClientHello
+    length = prv_writeRecord(record, RECORD_HANDSHAKE, NULL, 0, hello, HANDSHAKE_HEADER_SIZE + bodySize) - 1;
+    record[RECORD_HEADER_SIZE - 1]--;
+
+    loopback_reply(clientP->connP, record, length);
+}
+
+static void prv_clientSendRequest(client_t *clientP,
+                                  iowa_coap_message_t *messageP)
+{
+    uint8_t *bufferP;
+    uint8_t record[TEST_DATAGRAM_SIZE];
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0
+        || length + RECORD_CID_HEADER_SIZE + 1 > sizeof(record))
+    {
+        iowa_system_free(bufferP);
+        s_failureCount++;
+        return;
+    }
+    length = prv_writeRecord(record, RECORD_TLS12_CID, clientP->connectionId, clientP->key, bufferP, length);
+    iowa_system_free(bufferP);
+
+    loopback_reply(clientP->connP, record, length);
+}
+
+static iowa_coap_message_t * prv_clientNewRequest(client_t *clientP)
+{
+    iowa_coap_message_t *messageP;
+
+    clientP->token++;
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, 1, &clientP->token);
+    messageP->id = clientP->messageId++;
+
+    return messageP;
+}
+
+static void prv_clientRegister(client_t *clientP)
+{
+    static const char *payload = "</1/0>,</3/0>";
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    char query[64];
+
+    snprintf(query, sizeof(query), "ep=%s&lt=3600&lwm2m=1.1&b=U", clientP->name);
+
+    messageP = prv_clientNewRequest(clientP);
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, "rd", '/'));
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, query, '&'));
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    optionP->value.asInteger = IOWA_CONTENT_FORMAT_CORE_LINK;
+    iowa_coap_message_add_option(messageP, optionP);
+    messageP->payload.data = (uint8_t *)payload;
+    messageP->payload.length = strlen(payload);
+
+    prv_clientSendRequest(clientP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_clientUpdate(client_t *clientP)
+{
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_clientNewRequest(clientP);
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, clientP->path, '/'));
+
+    prv_clientSendRequest(clientP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+// Send a first datagram which cannot start a handshake
+static void prv_clientSendData(client_t *clientP)
+{
+    static const uint8_t payload[] = { 0x40, 0x01, 0x00, 0x01 };
+    uint8_t record[TEST_DATAGRAM_SIZE];
+    size_t length;
+
+    length = prv_writeRecord(record, RECORD_APPLICATION_DATA, NULL, clientP->key, payload, sizeof(payload));
+
+    loopback_reply(clientP->connP, record, length);
+}
+
+/*************************************************************************************
+** Server
+*************************************************************************************/
+
+static void prv_monitorCallback(const iowa_client_t *clientP,
+                                iowa_state_t state,
+                                void *userData,
+                                iowa_context_t contextP)
+{
+    (void)clientP;
+    (void)userData;
+    (void)contextP;
+
+    switch (state)
+    {
+    case IOWA_STATE_REGISTERED:
+        s_registeredCount++;
+        break;
+
+    case IOWA_STATE_UPDATING:
+        s_updatingCount++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Deliver the datagrams in flight and let the Server handle them
+static void prv_exchange(void)
+{
+    // Handles the datagram read by iowa_server_new_incoming_connection()
+    (void)iowa_step(s_contextP, 0);
+
+    while (loopback_next_delivery_us() != UINT64_MAX)
+    {
+        loopback_advance(loopback_next_delivery_us());
+        while (loopback_take_ready() != NULL)
+        {
+            (void)iowa_step(s_contextP, 0);
+        }
+    }
+}
+
+// A stand-in Client sends a datagram on its connection, which the Server does not know yet
+static iowa_status_t prv_offer(client_t *clientP,
+                               void (*sendCallback)(client_t *clientP))
+{
+    iowa_status_t result;
+
+    sendCallback(clientP);
+    loopback_advance(loopback_next_delivery_us());
+
+    result = iowa_server_new_incoming_connection(s_contextP, IOWA_CONN_DATAGRAM, clientP->connP, true);
+
+    if (result == IOWA_COAP_401_UNAUTHORIZED)
+    {
+        // Deliver the HelloVerifyRequest
+        loopback_advance(loopback_next_delivery_us());
+    }
+
+    return result;
+}
+
+// A stand-in Client opens a new connection and sends a datagram on it
+static iowa_status_t prv_connect(client_t *clientP,
+                                 void (*sendCallback)(client_t *clientP))
+{
+    clientP->connP = loopback_connect(&s_contextP, prv_clientReceive, clientP);
+    if (clientP->connP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return prv_offer(clientP, sendCallback);
+}
+
+// A stand-in Client starts a handshake from a new address: its first ClientHello gets a HelloVerifyRequest,
+// the second one carries the cookie.
+static iowa_status_t prv_connectWithCookie(client_t *clientP)
+{
+    iowa_status_t result;
+
+    clientP->cookieLength = 0;
+    result = prv_connect(clientP, prv_clientSendHello);
+    if (result != IOWA_COAP_401_UNAUTHORIZED)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return prv_offer(clientP, prv_clientSendHello);
+}
+
+static bool prv_check(bool condition,
+                      const char *description)
+{
+    if (condition == false)
+    {
+        fprintf(stderr, "Check failed: %s.\r\n", description);
+    }
+
+    return condition;
+}
+
+/*************************************************************************************
+** Checks
+*************************************************************************************/
+
+// A registered Client changes its address: its first record from the new address must be authenticated
+// before the Server moves to it. An attacker reusing the Connection ID from yet another address must not
+// move the Client.
+static bool prv_checkConnectionId(void)
+{
+    client_t client;
+    client_t attacker;
+    client_t other;
+    void *firstConnP;
+    void *secondConnP;
+    bool result;
+
+    memset(&client, 0, sizeof(client_t));
+    client.name = "client";
+    memset(&attacker, 0, sizeof(client_t));
+    attacker.name = "attacker";
+    memset(&other, 0, sizeof(client_t));
+    other.name = "other";
+
+    result = true;
+
+    // Handshake and registration
+    result &= prv_check(prv_connectWithCookie(&client) == IOWA_COAP_NO_ERROR, "the ClientHello is accepted");
+    prv_exchange();
+    result &= prv_check(client.isConnected == true, "the handshake succeeds");
+    prv_clientRegister(&client);
+    prv_exchange();
+    result &= prv_check(client.createdCount == 1 && s_registeredCount == 1, "the Client registers");
+    firstConnP = client.connP;
+
+    // Same Connection ID from a new address
+    result &= prv_check(prv_connect(&client, prv_clientUpdate) == IOWA_COAP_NO_ERROR, "the new address of the Client is accepted");
+    prv_exchange();
+    secondConnP = client.connP;
+    result &= prv_check(client.changedCount == 1 && s_updatingCount == 1, "the Registration Update from the new address is handled");
+    result &= prv_check(client.lastReplyConnP == secondConnP, "the Server answers to the new address");
+    result &= prv_check(loopback_is_open(firstConnP) == false && loopback_is_open(secondConnP) == true, "the previous address of the Client is closed");
+
+    // Same Connection ID with a wrong key from a third address
+    memcpy(attacker.connectionId, client.connectionId, TEST_CID_LENGTH);
+    attacker.key = (uint8_t)(client.key + 1);
+    memcpy(attacker.path, client.path, sizeof(client.path));
+    result &= prv_check(prv_connect(&attacker, prv_clientUpdate) == IOWA_COAP_NO_ERROR, "the address of the attacker is accepted");
+    prv_exchange();
+    result &= prv_check(attacker.changedCount == 0 && attacker.otherCount == 0 && s_updatingCount == 1, "the forged record is dropped");
+    result &= prv_check(loopback_is_open(attacker.connP) == false, "the address of the attacker is closed");
+    result &= prv_check(loopback_is_open(secondConnP) == true, "the address of the Client is kept");
+
+    prv_clientUpdate(&client);
+    prv_exchange();
+    result &= prv_check(client.changedCount == 2 && s_updatingCount == 2 && client.lastReplyConnP == secondConnP, "the Client is still reachable at its address");
+
+    // All the Connection IDs of a context have the same length
+    s_connectionIdLength = TEST_CID_LENGTH - 1;
+    result &= prv_check(prv_connectWithCookie(&other) == IOWA_COAP_NO_ERROR, "the second ClientHello is accepted");
+    prv_exchange();
+    result &= prv_check(s_refusedConnectionIdCount == 1, "a Connection ID of another length is refused");
+    s_connectionIdLength = TEST_CID_LENGTH;
+
+    result &= prv_check(client.otherCount == 0, "the Client receives no unexpected message");
+
+    return result;
+}
+
+// Make a handshake held by the stand-in security layer fail
+static void prv_failHeldHandshake(size_t index)
+{
+    iowa_security_session_set_state(s_heldSessionArray[index], SECURITY_STATE_CONNECTION_FAILED);
+    iowa_security_session_generate_event(s_heldSessionArray[index], SECURITY_EVENT_DISCONNECTED);
+    prv_exchange();
+}
+
+// New peers get a HelloVerifyRequest without any state kept by the Server. Only a ClientHello with a valid cookie starts
+// a handshake, and only IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES handshakes run at the same time.
+static bool prv_checkAdmission(void)
+{
+    client_t scanner;
+    client_t forger;
+    client_t thief;
+    client_t heldArray[IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES];
+    client_t late;
+    iowa_security_handshake_stats_t initialStats;
+    iowa_security_handshake_stats_t stats;
+    size_t i;
+    bool result;
+
+    memset(&scanner, 0, sizeof(client_t));
+    scanner.name = "scanner";
+    memset(&forger, 0, sizeof(client_t));
+    forger.name = "forger";
+    forger.random = 1;
+    memset(&thief, 0, sizeof(client_t));
+    thief.name = "thief";
+    thief.random = 2;
+    memset(heldArray, 0, sizeof(heldArray));
+    memset(&late, 0, sizeof(client_t));
+    late.name = "late";
+    late.random = 3;
+
+    result = true;
+    iowa_security_get_handshake_stats(s_contextP, &initialStats);
+
+    // A datagram which is not a ClientHello
+    result &= prv_check(prv_connect(&scanner, prv_clientSendData) == IOWA_COAP_400_BAD_REQUEST, "a first datagram which is not a ClientHello is refused");
+
+    // A ClientHello without cookie only gets a HelloVerifyRequest
+    result &= prv_check(prv_connect(&forger, prv_clientSendHello) == IOWA_COAP_401_UNAUTHORIZED && forger.helloVerifyCount == 1, "a ClientHello without cookie gets a HelloVerifyRequest");
+    iowa_security_get_handshake_stats(s_contextP, &stats);
+    result &= prv_check(stats.challenged == initialStats.challenged + 1 && stats.admitted == initialStats.admitted && stats.ongoing == 0, "a ClientHello without cookie does not start a handshake");
+
+    // A forged cookie, and a cookie sent from another address
+    forger.cookie[0] ^= 0x01;
+    result &= prv_check(prv_offer(&forger, prv_clientSendHello) == IOWA_COAP_400_BAD_REQUEST, "a forged cookie is refused");
+    forger.cookie[0] ^= 0x01;
+    memcpy(thief.cookie, forger.cookie, forger.cookieLength);
+    thief.cookieLength = forger.cookieLength;
+    thief.random = forger.random;
+    result &= prv_check(prv_connect(&thief, prv_clientSendHello) == IOWA_COAP_400_BAD_REQUEST, "a cookie from another address is refused");
+    iowa_security_get_handshake_stats(s_contextP, &stats);
+    result &= prv_check(stats.rejected == initialStats.rejected + 3 && stats.admitted == initialStats.admitted, "the refused peers are counted");
+
+    // Fill the handshake slots with handshakes which make no progress
+    s_holdHandshakes = true;
+    for (i = 0; i < IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES; i++)
+    {
+        heldArray[i].name = "held";
+        heldArray[i].random = (uint8_t)(4 + i);
+        result &= prv_check(prv_connectWithCookie(&heldArray[i]) == IOWA_COAP_NO_ERROR, "a ClientHello with a valid cookie is accepted");
+        prv_exchange();
+    }
+    iowa_security_get_handshake_stats(s_contextP, &stats);
+    result &= prv_check(s_heldCount == IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES && stats.ongoing == IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES, "the handshake slots are taken");
+
+    // Still challenged while the slots are taken, but deferred once it has a cookie
+    result &= prv_check(prv_connect(&late, prv_clientSendHello) == IOWA_COAP_401_UNAUTHORIZED, "a new peer gets a HelloVerifyRequest while the slots are taken");
+    result &= prv_check(prv_offer(&late, prv_clientSendHello) == IOWA_COAP_503_SERVICE_UNAVAILABLE, "a valid cookie is deferred while the slots are taken");
+    iowa_security_get_handshake_stats(s_contextP, &stats);
+    result &= prv_check(stats.deferred == initialStats.deferred + 1 && stats.ongoing == IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES, "the deferred peer is counted");
+
+    // The peer retransmits its ClientHello once a slot is free
+    prv_failHeldHandshake(0);
+    s_holdHandshakes = false;
+    iowa_security_get_handshake_stats(s_contextP, &stats);
+    result &= prv_check(stats.ongoing == IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES - 1, "a failed handshake frees its slot");
+    result &= prv_check(prv_offer(&late, prv_clientSendHello) == IOWA_COAP_NO_ERROR, "the deferred peer is accepted once a slot is free");
+    prv_exchange();
+    result &= prv_check(late.isConnected == true, "the deferred peer completes its handshake");
+
+    for (i = 1; i < IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES; i++)
+    {
+        prv_failHeldHandshake(i);
+    }
+    s_heldCount = 0;
+    iowa_security_get_handshake_stats(s_contextP, &stats);
+    result &= prv_check(stats.ongoing == 0 && stats.admitted == initialStats.admitted + IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES + 1, "all the slots are free");
+
+    result &= prv_check(scanner.otherCount == 0 && forger.otherCount == 0 && thief.otherCount == 0 && late.otherCount == 0, "the peers receive no unexpected message");
+
+    return result;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    static const loopback_link_t link = { 0, 1000, 1000, 0, 0 };
+    bool result;
+
+    (void)argc;
+    (void)argv;
+
+    loopback_init(TEST_SEED, &link);
+    s_connectionIdLength = TEST_CID_LENGTH;
+
+    s_contextP = iowa_init(&s_contextP);
+    if (s_contextP == NULL
+        || iowa_server_configure(s_contextP, prv_monitorCallback, NULL, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "Failed to create the Server.\r\n");
+        return 1;
+    }
+
+    result = prv_checkConnectionId();
+    printf("Connection ID routing: %s\r\n", result == true ? "passed" : "FAILED");
+
+    if (prv_checkAdmission() == true)
+    {
+        printf("Handshake admission: passed\r\n");
+    }
+    else
+    {
+        printf("Handshake admission: FAILED\r\n");
+        result = false;
+    }
+
+    result &= prv_check(s_failureCount == 0, "all the messages are sent");
+
+    iowa_close(s_contextP);
+    loopback_close();
+
+    return (result == true) ? 0 : 1;
+}
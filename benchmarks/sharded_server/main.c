@@ -0,0 +1,903 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * This benchmark measures how a LwM2M Server
+ * scales with the number of shards. Each shard
+ * is an IOWA context run by its own thread. The
+ * simulated Clients send their datagrams to one
+ * listening socket whose thread steers them to
+ * the shards.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_server.h"
+#include "iowa_prv_coap_internals.h"
+
+// Benchmark helpers
+#include "bench_utils.h"
+
+// Platform specific headers
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_CLIENTS    512
+#define BENCH_UPDATE_COUNT       8
+#define BENCH_READ_COUNT         8
+#define BENCH_MAX_SHARDS         8
+#define BENCH_DATAGRAM_SIZE      256
+#define BENCH_PEER_ID_LENGTH     4
+
+typedef struct _datagram_t
+{
+    struct _datagram_t *nextP;
+    struct _peer_t     *peerP;
+    size_t              length;
+    uint8_t             buffer[BENCH_DATAGRAM_SIZE];
+} datagram_t;
+
+typedef struct
+{
+    datagram_t *headP;
+    datagram_t *tailP;
+} datagram_queue_t;
+
+// A simulated Client. Once its first datagram is received, it is only accessed by the thread of its shard.
+typedef struct _peer_t
+{
+    uint32_t          index;
+    uint8_t           peerId[BENCH_PEER_ID_LENGTH];
+    bool              isKnown;           // the shard called iowa_server_new_incoming_connection()
+    datagram_queue_t  pendingQueue;      // datagrams received by the shard and not yet read by IOWA
+    uint16_t          messageId;
+    uint8_t           token;
+    char              path[32];          // the Location-Path of the registration
+    uint32_t          updateCount;
+    uint32_t          clientId;
+    uint8_t           shard;
+} peer_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    uint32_t        value;
+} counter_t;
+
+typedef struct
+{
+    pthread_t         thread;
+    pthread_mutex_t   mutex;
+    pthread_cond_t    cond;
+    bool              stop;
+    datagram_queue_t  inQueue;           // datagrams steered to this shard
+    uint32_t         *readJobArray;      // Client IDs to read, posted by other threads
+    size_t            readJobCount;
+    size_t            readJobSize;
+    // Accessed only by the shard thread
+    uint8_t           index;
+    uint8_t           shardCount;
+    iowa_context_t    contextP;
+    uint32_t          pendingCount;
+    uint32_t          randomState;
+} shard_t;
+
+typedef struct
+{
+    pthread_t         thread;
+    pthread_mutex_t   mutex;
+    pthread_cond_t    cond;
+    bool              stop;
+    datagram_queue_t  inQueue;
+} listener_t;
+
+static peer_t *s_peerArray;
+static uint32_t s_peerCount;
+static shard_t s_shardArray[BENCH_MAX_SHARDS];
+static uint8_t s_shardCount;
+static listener_t s_listener;
+static counter_t s_updatedCounter;
+static counter_t s_readCounter;
+static counter_t s_errorCounter;
+
+/*************************************************************************************
+** Helpers
+*************************************************************************************/
+
+static void prv_queueAdd(datagram_queue_t *queueP,
+                         datagram_t *datagramP)
+{
+    datagramP->nextP = NULL;
+    if (queueP->tailP == NULL)
+    {
+        queueP->headP = datagramP;
+    }
+    else
+    {
+        queueP->tailP->nextP = datagramP;
+    }
+    queueP->tailP = datagramP;
+}
+
+static datagram_t * prv_queueTake(datagram_queue_t *queueP)
+{
+    datagram_t *datagramP;
+
+    datagramP = queueP->headP;
+    if (datagramP != NULL)
+    {
+        queueP->headP = datagramP->nextP;
+        if (queueP->headP == NULL)
+        {
+            queueP->tailP = NULL;
+        }
+    }
+
+    return datagramP;
+}
+
+static void prv_queueClear(datagram_queue_t *queueP)
+{
+    datagram_t *datagramP;
+
+    while ((datagramP = prv_queueTake(queueP)) != NULL)
+    {
+        free(datagramP);
+    }
+}
+
+static void prv_counterInit(counter_t *counterP)
+{
+    pthread_mutex_init(&counterP->mutex, NULL);
+    pthread_cond_init(&counterP->cond, NULL);
+    counterP->value = 0;
+}
+
+static void prv_counterIncrement(counter_t *counterP)
+{
+    pthread_mutex_lock(&counterP->mutex);
+    counterP->value++;
+    pthread_cond_broadcast(&counterP->cond);
+    pthread_mutex_unlock(&counterP->mutex);
+}
+
+static void prv_counterWait(counter_t *counterP,
+                            uint32_t value)
+{
+    pthread_mutex_lock(&counterP->mutex);
+    while (counterP->value < value)
+    {
+        pthread_cond_wait(&counterP->cond, &counterP->mutex);
+    }
+    pthread_mutex_unlock(&counterP->mutex);
+}
+
+static uint32_t prv_counterGet(counter_t *counterP)
+{
+    uint32_t value;
+
+    pthread_mutex_lock(&counterP->mutex);
+    value = counterP->value;
+    pthread_mutex_unlock(&counterP->mutex);
+
+    return value;
+}
+
+/*************************************************************************************
+** Simulated Clients
+*************************************************************************************/
+
+// Send a datagram from a peer to the listening socket
+static void prv_peerSend(peer_t *peerP,
+                         iowa_coap_message_t *messageP)
+{
+    datagram_t *datagramP;
+    uint8_t *bufferP;
+    size_t length;
+
+    length = coapMessageSerializeDatagram(messageP, &bufferP);
+    if (length == 0
+        || length > BENCH_DATAGRAM_SIZE)
+    {
+        iowa_system_free(bufferP);
+        prv_counterIncrement(&s_errorCounter);
+        return;
+    }
+
+    datagramP = (datagram_t *)malloc(sizeof(datagram_t));
+    datagramP->peerP = peerP;
+    datagramP->length = length;
+    memcpy(datagramP->buffer, bufferP, length);
+    iowa_system_free(bufferP);
+
+    pthread_mutex_lock(&s_listener.mutex);
+    prv_queueAdd(&s_listener.inQueue, datagramP);
+    pthread_cond_signal(&s_listener.cond);
+    pthread_mutex_unlock(&s_listener.mutex);
+}
+
+static iowa_coap_message_t * prv_peerNewRequest(peer_t *peerP)
+{
+    iowa_coap_message_t *messageP;
+
+    peerP->token++;
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, 1, &peerP->token);
+    messageP->id = peerP->messageId++;
+
+    return messageP;
+}
+
+static void prv_peerRegister(peer_t *peerP)
+{
+    static const char *payload = "</1/0>,</3/0>";
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    char query[64];
+
+    snprintf(query, sizeof(query), "ep=bench-%u&lt=3600&lwm2m=1.1&b=U", peerP->index);
+
+    messageP = prv_peerNewRequest(peerP);
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, "rd", '/'));
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, query, '&'));
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    optionP->value.asInteger = IOWA_CONTENT_FORMAT_CORE_LINK;
+    iowa_coap_message_add_option(messageP, optionP);
+    messageP->payload.data = (uint8_t *)payload;
+    messageP->payload.length = strlen(payload);
+
+    prv_peerSend(peerP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_peerUpdate(peer_t *peerP)
+{
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_peerNewRequest(peerP);
+    iowa_coap_message_add_option(messageP, iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, peerP->path, '/'));
+
+    prv_peerSend(peerP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+static void prv_peerReplyRead(peer_t *peerP,
+                              iowa_coap_message_t *requestP)
+{
+    static const char *payload = "[{\"bn\":\"/3/0/9\",\"v\":87}]";
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    messageP = iowa_coap_message_prepare_response(requestP, IOWA_COAP_205_CONTENT);
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+    optionP->value.asInteger = IOWA_CONTENT_FORMAT_SENML_JSON;
+    iowa_coap_message_add_option(messageP, optionP);
+    messageP->payload.data = (uint8_t *)payload;
+    messageP->payload.length = strlen(payload);
+
+    prv_peerSend(peerP, messageP);
+
+    iowa_coap_message_free(messageP);
+}
+
+// Handle a datagram sent by the Server to a peer. Called by the thread of the peer's shard.
+static void prv_peerReceive(peer_t *peerP,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+
+    if (messageDatagramParse(buffer, length, &messageP) != IOWA_COAP_NO_ERROR)
+    {
+        prv_counterIncrement(&s_errorCounter);
+        return;
+    }
+
+    switch (messageP->code)
+    {
+    case IOWA_COAP_201_CREATED:
+        peerP->path[0] = 0;
+        for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
+        {
+            if (optionP->number == IOWA_COAP_OPTION_LOCATION_PATH
+                && strlen(peerP->path) + optionP->length + 2 <= sizeof(peerP->path))
+            {
+                if (peerP->path[0] != 0)
+                {
+                    strcat(peerP->path, "/");
+                }
+                strncat(peerP->path, (char *)optionP->value.asBuffer, optionP->length);
+            }
+        }
+        prv_peerUpdate(peerP);
+        break;
+
+    case IOWA_COAP_204_CHANGED:
+        peerP->updateCount++;
+        if (peerP->updateCount < BENCH_UPDATE_COUNT)
+        {
+            prv_peerUpdate(peerP);
+        }
+        else
+        {
+            prv_counterIncrement(&s_updatedCounter);
+        }
+        break;
+
+    case IOWA_COAP_CODE_GET:
+        prv_peerReplyRead(peerP, messageP);
+        break;
+
+    default:
+        prv_counterIncrement(&s_errorCounter);
+        break;
+    }
+
+    iowa_coap_message_free(messageP);
+}
+
+/*************************************************************************************
+** Platform abstraction
+*************************************************************************************/
+
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    (void)type;
+    (void)hostname;
+    (void)port;
+    (void)userData;
+
+    // The Server only uses incoming connections
+    return NULL;
+}
+
+// The Server sends to a simulated Client
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)userData;
+
+    prv_peerReceive((peer_t *)connP, buffer, length);
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    peer_t *peerP;
+    shard_t *shardP;
+    datagram_t *datagramP;
+    int result;
+
+    peerP = (peer_t *)connP;
+    shardP = (shard_t *)userData;
+
+    datagramP = prv_queueTake(&peerP->pendingQueue);
+    if (datagramP == NULL)
+    {
+        return 0;
+    }
+    shardP->pendingCount--;
+
+    if (datagramP->length > length)
+    {
+        result = -1;
+    }
+    else
+    {
+        memcpy(buffer, datagramP->buffer, datagramP->length);
+        result = (int)datagramP->length;
+    }
+    free(datagramP);
+
+    return result;
+}
+
+// The shard thread waits for datagrams before calling iowa_step() so this function does not block.
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    size_t i;
+    int result;
+
+    (void)timeout;
+    (void)userData;
+
+    result = 0;
+    for (i = 0; i < connCount; i++)
+    {
+        if (((peer_t *)connArray[i])->pendingQueue.headP == NULL)
+        {
+            connArray[i] = NULL;
+        }
+        else
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    (void)userData;
+
+    ((peer_t *)connP)->isKnown = false;
+}
+
+size_t iowa_system_connection_get_peer_identifier(void *connP,
+                                                  uint8_t *addrP,
+                                                  size_t length,
+                                                  void *userData)
+{
+    (void)userData;
+
+    if (length < BENCH_PEER_ID_LENGTH)
+    {
+        return 0;
+    }
+    memcpy(addrP, ((peer_t *)connP)->peerId, BENCH_PEER_ID_LENGTH);
+
+    return BENCH_PEER_ID_LENGTH;
+}
+
+// xorshift32 generator, one per shard as each shard runs in its own thread
+int iowa_system_random_vector_generator(uint8_t *randomBuffer,
+                                        size_t size,
+                                        void *userData)
+{
+    shard_t *shardP;
+    size_t i;
+
+    shardP = (shard_t *)userData;
+
+    for (i = 0; i < size; i++)
+    {
+        shardP->randomState ^= shardP->randomState << 13;
+        shardP->randomState ^= shardP->randomState >> 17;
+        shardP->randomState ^= shardP->randomState << 5;
+        randomBuffer[i] = (uint8_t)shardP->randomState;
+    }
+
+    return 0;
+}
+
+/*************************************************************************************
+** Server callbacks
+*************************************************************************************/
+
+static void prv_monitorCallback(const iowa_client_t *clientP,
+                                iowa_state_t state,
+                                void *userData,
+                                iowa_context_t contextP)
+{
+    shard_t *shardP;
+    unsigned int index;
+
+    (void)contextP;
+
+    shardP = (shard_t *)userData;
+
+    if (state == IOWA_STATE_REGISTERED
+        && sscanf(clientP->name, "bench-%u", &index) == 1
+        && index < s_peerCount)
+    {
+        s_peerArray[index].clientId = clientP->id;
+
+        // The Client must be owned by the shard which received its Registration
+        if (iowa_server_get_client_shard(clientP->id, shardP->shardCount) != shardP->index)
+        {
+            prv_counterIncrement(&s_errorCounter);
+        }
+    }
+}
+
+static void prv_readCallback(uint32_t clientId,
+                             uint8_t operation,
+                             iowa_status_t status,
+                             iowa_response_content_t *contentP,
+                             void *userData,
+                             iowa_context_t contextP)
+{
+    (void)clientId;
+    (void)operation;
+    (void)userData;
+    (void)contextP;
+
+    if (status != IOWA_COAP_205_CONTENT
+        || contentP == NULL
+        || contentP->details.read.dataCount != 1
+        || contentP->details.read.dataP[0].value.asInteger != 87)
+    {
+        prv_counterIncrement(&s_errorCounter);
+    }
+    prv_counterIncrement(&s_readCounter);
+}
+
+/*************************************************************************************
+** Threads
+*************************************************************************************/
+
+// The listening socket: steer each datagram to its shard
+static void * prv_listenerThread(void *argP)
+{
+    (void)argP;
+
+    pthread_mutex_lock(&s_listener.mutex);
+    while (s_listener.stop == false)
+    {
+        datagram_t *datagramP;
+
+        datagramP = prv_queueTake(&s_listener.inQueue);
+        if (datagramP == NULL)
+        {
+            pthread_cond_wait(&s_listener.cond, &s_listener.mutex);
+        }
+        else
+        {
+            shard_t *shardP;
+
+            pthread_mutex_unlock(&s_listener.mutex);
+
+            shardP = s_shardArray + iowa_server_get_datagram_shard(datagramP->buffer, datagramP->length,
+                                                                   datagramP->peerP->peerId, BENCH_PEER_ID_LENGTH,
+                                                                   s_shardCount);
+            pthread_mutex_lock(&shardP->mutex);
+            prv_queueAdd(&shardP->inQueue, datagramP);
+            pthread_cond_signal(&shardP->cond);
+            pthread_mutex_unlock(&shardP->mutex);
+
+            pthread_mutex_lock(&s_listener.mutex);
+        }
+    }
+    pthread_mutex_unlock(&s_listener.mutex);
+
+    return NULL;
+}
+
+static void * prv_shardThread(void *argP)
+{
+    shard_t *shardP;
+    uint32_t *jobArray;
+    size_t jobSize;
+
+    shardP = (shard_t *)argP;
+    jobArray = NULL;
+    jobSize = 0;
+
+    while (true)
+    {
+        datagram_queue_t newQueue;
+        size_t jobCount;
+        size_t i;
+        datagram_t *datagramP;
+
+        pthread_mutex_lock(&shardP->mutex);
+        while (shardP->stop == false
+               && shardP->inQueue.headP == NULL
+               && shardP->readJobCount == 0
+               && shardP->pendingCount == 0)
+        {
+            pthread_cond_wait(&shardP->cond, &shardP->mutex);
+        }
+        if (shardP->stop == true)
+        {
+            pthread_mutex_unlock(&shardP->mutex);
+            break;
+        }
+        newQueue = shardP->inQueue;
+        shardP->inQueue.headP = NULL;
+        shardP->inQueue.tailP = NULL;
+        if (jobSize < shardP->readJobCount)
+        {
+            jobSize = shardP->readJobSize;
+            jobArray = (uint32_t *)realloc(jobArray, jobSize * sizeof(uint32_t));
+        }
+        jobCount = shardP->readJobCount;
+        if (jobCount > 0)
+        {
+            memcpy(jobArray, shardP->readJobArray, jobCount * sizeof(uint32_t));
+        }
+        shardP->readJobCount = 0;
+        pthread_mutex_unlock(&shardP->mutex);
+
+        while ((datagramP = prv_queueTake(&newQueue)) != NULL)
+        {
+            peer_t *peerP;
+
+            peerP = datagramP->peerP;
+            if (peerP->isKnown == false)
+            {
+                peerP->isKnown = true;
+                peerP->shard = shardP->index;
+                if (iowa_server_new_incoming_connection(shardP->contextP, IOWA_CONN_DATAGRAM, peerP, false) != IOWA_COAP_NO_ERROR)
+                {
+                    prv_counterIncrement(&s_errorCounter);
+                }
+            }
+            prv_queueAdd(&peerP->pendingQueue, datagramP);
+            shardP->pendingCount++;
+        }
+
+        // Cross-shard calls posted by other threads are run by the owning shard
+        for (i = 0; i < jobCount; i++)
+        {
+            iowa_lwm2m_uri_t uri;
+
+            uri.objectId = 3;
+            uri.instanceId = 0;
+            uri.resourceId = 9;
+            uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+            if (iowa_server_read(shardP->contextP, jobArray[i], 1, &uri, prv_readCallback, NULL) != IOWA_COAP_NO_ERROR)
+            {
+                prv_counterIncrement(&s_errorCounter);
+                prv_counterIncrement(&s_readCounter);
+            }
+        }
+
+        if (iowa_step(shardP->contextP, 0) != IOWA_COAP_NO_ERROR)
+        {
+            prv_counterIncrement(&s_errorCounter);
+        }
+    }
+
+    free(jobArray);
+
+    return NULL;
+}
+
+// Route a read of a Client to its shard
+static void prv_postRead(uint32_t clientId)
+{
+    shard_t *shardP;
+
+    shardP = s_shardArray + iowa_server_get_client_shard(clientId, s_shardCount);
+
+    pthread_mutex_lock(&shardP->mutex);
+    if (shardP->readJobCount == shardP->readJobSize)
+    {
+        shardP->readJobSize = shardP->readJobSize == 0 ? 64 : 2 * shardP->readJobSize;
+        shardP->readJobArray = (uint32_t *)realloc(shardP->readJobArray, shardP->readJobSize * sizeof(uint32_t));
+    }
+    shardP->readJobArray[shardP->readJobCount] = clientId;
+    shardP->readJobCount++;
+    pthread_cond_signal(&shardP->cond);
+    pthread_mutex_unlock(&shardP->mutex);
+}
+
+/*************************************************************************************
+** Measures
+*************************************************************************************/
+
+typedef struct
+{
+    double   registrationNs;
+    double   readNs;
+    uint32_t errorCount;
+    uint32_t clientsPerShard[BENCH_MAX_SHARDS];
+} result_t;
+
+static bool prv_run(uint8_t shardCount,
+                    uint32_t clientCount,
+                    result_t *resultP)
+{
+    uint64_t start;
+    uint32_t i;
+    uint8_t s;
+
+    memset(resultP, 0, sizeof(result_t));
+
+    s_shardCount = shardCount;
+    s_peerCount = clientCount;
+    s_peerArray = (peer_t *)calloc(clientCount, sizeof(peer_t));
+    for (i = 0; i < clientCount; i++)
+    {
+        uint32_t address;
+
+        s_peerArray[i].index = i;
+        s_peerArray[i].messageId = (uint16_t)(i * 7919);
+        // An IPv4 address in 10.0.0.0/8
+        address = 0x0A000000 + i + 1;
+        s_peerArray[i].peerId[0] = (uint8_t)(address >> 24);
+        s_peerArray[i].peerId[1] = (uint8_t)(address >> 16);
+        s_peerArray[i].peerId[2] = (uint8_t)(address >> 8);
+        s_peerArray[i].peerId[3] = (uint8_t)address;
+    }
+
+    prv_counterInit(&s_updatedCounter);
+    prv_counterInit(&s_readCounter);
+    prv_counterInit(&s_errorCounter);
+
+    memset(&s_listener, 0, sizeof(listener_t));
+    pthread_mutex_init(&s_listener.mutex, NULL);
+    pthread_cond_init(&s_listener.cond, NULL);
+
+    for (s = 0; s < shardCount; s++)
+    {
+        shard_t *shardP;
+
+        shardP = s_shardArray + s;
+        memset(shardP, 0, sizeof(shard_t));
+        pthread_mutex_init(&shardP->mutex, NULL);
+        pthread_cond_init(&shardP->cond, NULL);
+        shardP->index = s;
+        shardP->shardCount = shardCount;
+        shardP->randomState = 0x9E3779B9u + s;
+        shardP->contextP = iowa_init(shardP);
+        if (shardP->contextP == NULL
+            || iowa_server_configure(shardP->contextP, prv_monitorCallback, NULL, shardP) != IOWA_COAP_NO_ERROR
+            || iowa_server_configure_shard(shardP->contextP, s, shardCount) != IOWA_COAP_NO_ERROR)
+        {
+            fprintf(stderr, "Failed to create shard %u.\r\n", s);
+            return false;
+        }
+    }
+
+    pthread_create(&s_listener.thread, NULL, prv_listenerThread, NULL);
+    for (s = 0; s < shardCount; s++)
+    {
+        pthread_create(&s_shardArray[s].thread, NULL, prv_shardThread, s_shardArray + s);
+    }
+
+    // Registrations and Registration Updates
+    start = bench_now_ns();
+    for (i = 0; i < clientCount; i++)
+    {
+        prv_peerRegister(s_peerArray + i);
+    }
+    prv_counterWait(&s_updatedCounter, clientCount);
+    resultP->registrationNs = (double)(bench_now_ns() - start);
+
+    // Reads posted from this thread to the owning shards
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_READ_COUNT; i++)
+    {
+        uint32_t j;
+
+        for (j = 0; j < clientCount; j++)
+        {
+            prv_postRead(s_peerArray[j].clientId);
+        }
+    }
+    prv_counterWait(&s_readCounter, clientCount * BENCH_READ_COUNT);
+    resultP->readNs = (double)(bench_now_ns() - start);
+
+    pthread_mutex_lock(&s_listener.mutex);
+    s_listener.stop = true;
+    pthread_cond_signal(&s_listener.cond);
+    pthread_mutex_unlock(&s_listener.mutex);
+    pthread_join(s_listener.thread, NULL);
+    for (s = 0; s < shardCount; s++)
+    {
+        shard_t *shardP;
+
+        shardP = s_shardArray + s;
+        pthread_mutex_lock(&shardP->mutex);
+        shardP->stop = true;
+        pthread_cond_signal(&shardP->cond);
+        pthread_mutex_unlock(&shardP->mutex);
+        pthread_join(shardP->thread, NULL);
+
+        iowa_close(shardP->contextP);
+        prv_queueClear(&shardP->inQueue);
+        free(shardP->readJobArray);
+        pthread_mutex_destroy(&shardP->mutex);
+        pthread_cond_destroy(&shardP->cond);
+    }
+    prv_queueClear(&s_listener.inQueue);
+    pthread_mutex_destroy(&s_listener.mutex);
+    pthread_cond_destroy(&s_listener.cond);
+
+    for (i = 0; i < clientCount; i++)
+    {
+        prv_queueClear(&s_peerArray[i].pendingQueue);
+        resultP->clientsPerShard[s_peerArray[i].shard]++;
+    }
+    free(s_peerArray);
+    s_peerArray = NULL;
+
+    resultP->errorCount = prv_counterGet(&s_errorCounter);
+
+    return true;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    static const uint8_t shardCountArray[] = { 1, 2, 4, 8 };
+    uint32_t clientCount;
+    double referenceNs;
+    size_t i;
+    int status;
+
+    clientCount = BENCH_DEFAULT_CLIENTS;
+    if (argc > 1)
+    {
+        clientCount = (uint32_t)strtoul(argv[1], NULL, 10);
+        if (clientCount == 0
+            || clientCount > 0xFFFF)
+        {
+            clientCount = BENCH_DEFAULT_CLIENTS;
+        }
+    }
+
+    printf("%u Clients, each one sending a Registration and %u Registration Updates, then %u Reads per Client.\r\n\n", clientCount, BENCH_UPDATE_COUNT, BENCH_READ_COUNT);
+    printf("%-7s | %-19s | %-14s | %-14s | %-9s | %s\r\n", "Shards", "Clients per shard", "Updates/s", "Reads/s", "Speedup", "Errors");
+    printf("--------+---------------------+----------------+----------------+-----------+-------\r\n");
+
+    status = 0;
+    referenceNs = 0;
+    for (i = 0; i < sizeof(shardCountArray); i++)
+    {
+        result_t result;
+        double totalNs;
+        uint32_t minClients;
+        uint32_t maxClients;
+        uint8_t s;
+
+        if (prv_run(shardCountArray[i], clientCount, &result) == false)
+        {
+            return 1;
+        }
+
+        minClients = clientCount;
+        maxClients = 0;
+        for (s = 0; s < shardCountArray[i]; s++)
+        {
+            if (result.clientsPerShard[s] < minClients)
+            {
+                minClients = result.clientsPerShard[s];
+            }
+            if (result.clientsPerShard[s] > maxClients)
+            {
+                maxClients = result.clientsPerShard[s];
+            }
+        }
+
+        totalNs = result.registrationNs + result.readNs;
+        if (referenceNs == 0)
+        {
+            referenceNs = totalNs;
+        }
+
+        printf("%-7u | %8u - %-8u | %14.0f | %14.0f | %8.2fx | %u\r\n",
+               shardCountArray[i], minClients, maxClients,
+               (double)clientCount * (BENCH_UPDATE_COUNT + 1) * 1e9 / result.registrationNs,
+               (double)clientCount * BENCH_READ_COUNT * 1e9 / result.readNs,
+               referenceNs / totalNs,
+               result.errorCount);
+
+        if (result.errorCount != 0)
+        {
+            status = 1;
+        }
+    }
+
+    return status;
+}
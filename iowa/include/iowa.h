@@ -223,10 +223,71 @@ typedef struct
     } details;
 } iowa_response_content_t;
 
+// The number of buckets of the metrics histograms.
+// Bucket i counts the durations lower than 10^(i+1) microseconds which do not fit in bucket i-1.
+// The last bucket counts the durations of 10 seconds or more.
+#define IOWA_METRICS_HISTOGRAM_BUCKET_COUNT 8
+
+typedef struct
+{
+    uint32_t count;                                        // number of recorded durations
+    uint64_t sum;                                          // sum of the recorded durations in microseconds
+    uint32_t max;                                          // longest recorded duration in microseconds
+    uint32_t buckets[IOWA_METRICS_HISTOGRAM_BUCKET_COUNT]; // number of recorded durations per bucket
+} iowa_metrics_histogram_t;
+
+typedef struct
+{
+    uint32_t datagramReceivedCount;             // datagrams received from the peers
+    uint32_t datagramDroppedCount;              // received datagrams which could not be parsed or were rejected
+    uint32_t retransmissionCount;               // retransmissions of Confirmable messages
+    uint32_t transactionTimeoutCount;           // Confirmable messages which were never acknowledged
+    uint32_t notificationSentCount;             // notifications sent to the LwM2M Servers
+    uint32_t notificationSuppressedCount;       // value changes not notified because of the pmin attribute
+    uint32_t registrationCount;                 // successful registrations to a LwM2M Server
+    uint32_t registrationFailureCount;          // failed registrations to a LwM2M Server
+    iowa_metrics_histogram_t requestRtt;        // from the first transmission of a Confirmable message to its acknowledgement
+    iowa_metrics_histogram_t stepDuration;      // processing time of iowa_step() loops, waiting time excluded
+    iowa_metrics_histogram_t handshakeDuration; // from the start of a secure handshake to the connection
+} iowa_metrics_t;
+
+// The phases traced with IOWA_TRACE_SUPPORT.
+typedef enum
+{
+    IOWA_TRACE_PHASE_PARSE = 0,   // parsing of a received datagram
+    IOWA_TRACE_PHASE_DECODE,      // decoding of the URI and of the payload of a request
+    IOWA_TRACE_PHASE_READ,        // reading of the Objects for a Read request or a notification, callbacks included
+    IOWA_TRACE_PHASE_CALLBACK,    // call of an Object data callback of the application
+    IOWA_TRACE_PHASE_ENCODE,      // encoding of the payload of a response or a notification
+    IOWA_TRACE_PHASE_SEND,        // serialization and transmission of a message
+    IOWA_TRACE_PHASE_ACK,         // from the first transmission of a Confirmable message to its acknowledgement
+    IOWA_TRACE_PHASE_MESSAGE,     // whole handling of a received datagram
+    IOWA_TRACE_PHASE_NOTIFICATION // whole handling of a notification, from the reading to the sending
+} iowa_trace_phase_t;
+
+typedef struct
+{
+    uint32_t           traceId;   // identifies the received datagram or the notification the span belongs to
+    iowa_trace_phase_t phase;
+    uint64_t           startTime; // as returned by iowa_system_gettime_us()
+    uint32_t           duration;  // in microseconds
+} iowa_trace_span_t;
+
 /**************************************************************
  * Common Callbacks
  **************************************************************/
 
+// The callback called when a traced phase completes.
+// Returned value: None.
+// Parameters:
+// - spanP: the completed span.
+// - userDataP: as passed to iowa_set_trace_callback().
+// - contextP: the IOWA context on which iowa_set_trace_callback() was called.
+// Note: this callback is called from within the stack. It must return quickly and must not call any IOWA API.
+typedef void(*iowa_trace_callback_t) (const iowa_trace_span_t *spanP,
+                                      void *userDataP,
+                                      iowa_context_t contextP);
+
 /****************************
  * Callback use to get response to handle operation
  */
@@ -255,7 +316,7 @@ typedef void(*iowa_response_callback_t) (uint32_t sourceId,
 // Returned value: None.
 // Parameters:
 // - callbackId: the identifier of the callback.
-// - buffer: the data loaded from the backup. This can be nil.
+// - buffer: the data loaded from the backup. This can be nil. It is only valid during the call and must not be modified.
 // - bufferLength: the length of the buffer in bytes.
 // - userDataP: Pointer to application-specific data.
 typedef void(*iowa_load_callback_t) (uint16_t callbackId,
@@ -369,6 +430,67 @@ void iowa_backup_deregister_callback(iowa_context_t contextP,
 void iowa_connection_closed(iowa_context_t contextP,
                             void *connP);
 
+// Retrieve a snapshot of the metrics collected by the stack.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - metricsP: OUT. the metrics.
+// Note:
+// - The metrics are plain counters updated by iowa_step(). Calling this function from another thread than the one running
+//   iowa_step() requires IOWA_THREAD_SUPPORT: the snapshot is then copied under the IOWA mutex.
+iowa_status_t iowa_get_metrics(iowa_context_t contextP,
+                               iowa_metrics_t *metricsP);
+
+// Reset the metrics collected by the stack.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+iowa_status_t iowa_reset_metrics(iowa_context_t contextP);
+
+// Set the callback receiving the spans traced by the stack.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - samplingPeriod: one received datagram or notification out of samplingPeriod is traced. 0 is the same as 1.
+// - traceCb: the callback to receive the spans. Nil to stop the tracing.
+// - userDataP: passed as parameter to traceCb.
+iowa_status_t iowa_set_trace_callback(iowa_context_t contextP,
+                                      uint32_t samplingPeriod,
+                                      iowa_trace_callback_t traceCb,
+                                      void *userDataP);
+
+// Start capturing the CoAP datagrams exchanged with the peers. A running capture is restarted.
+// The datagrams are captured before encryption and after decryption, with synthetic IPv4 and UDP headers:
+// the device is 10.0.0.1 and each connection gets its own 10.1.x.y address. Both ports are 5683.
+// When the buffer is full, the oldest datagrams are dropped.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - bufferSize: the size in bytes of the capture ring buffer allocated by the stack.
+iowa_status_t iowa_capture_start(iowa_context_t contextP,
+                                 size_t bufferSize);
+
+// Stop the capture and release its buffer. The datagrams not read are lost.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+iowa_status_t iowa_capture_stop(iowa_context_t contextP);
+
+// Read and remove the oldest captured datagrams in the pcap format.
+// The first read after iowa_capture_start() begins with the pcap file header. Only complete records are read.
+// The timestamps are the values of iowa_system_gettime_us().
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - bufferP, bufferLength: the buffer to fill.
+// - readLengthP: OUT. the number of bytes written in bufferP.
+// - droppedCountP: OUT. the number of datagrams dropped since the previous read. This can be nil.
+iowa_status_t iowa_capture_read(iowa_context_t contextP,
+                                uint8_t *bufferP,
+                                size_t bufferLength,
+                                size_t *readLengthP,
+                                uint32_t *droppedCountP);
+
 // The possible size of the data block when "more" is true.
 #define IOWA_DATA_BLOCK_SIZE_16    16
 #define IOWA_DATA_BLOCK_SIZE_32    32
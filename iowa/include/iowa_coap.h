@@ -263,6 +263,37 @@ uint8_t iowa_coap_block_request_block_number(iowa_context_t contextP,
                                              iowa_coap_result_callback_t resultCb,
                                              void *userData);
 
+/**************************************************************
+ * OSCORE Functions
+ **************************************************************/
+
+// Save callback for iowa_backup_register_callback() storing the OSCORE Sender Sequence Numbers and replay windows.
+// Only available when IOWA_COAP_OSCORE_SUPPORT and IOWA_STORAGE_CONTEXT_SUPPORT are defined.
+// Returned value: the length of the data.
+// Parameters:
+// - callbackId: the identifier of the callback.
+// - buffer: a buffer to store the data. This can be nil.
+// - bufferLength: the length of the buffer in bytes.
+// - userDataP: the IOWA context returned by iowa_init().
+size_t iowa_coap_oscore_save_callback(uint16_t callbackId,
+                                      uint8_t *buffer,
+                                      size_t bufferLength,
+                                      void *userDataP);
+
+// Load callback for iowa_backup_register_callback() restoring the OSCORE Sender Sequence Numbers and replay windows.
+// Only available when IOWA_COAP_OSCORE_SUPPORT and IOWA_STORAGE_CONTEXT_SUPPORT are defined.
+// The restored Sender Sequence Numbers are increased by a margin covering the messages sent after the backup.
+// Returned value: none.
+// Parameters:
+// - callbackId: the identifier of the callback.
+// - buffer: the data loaded from the backup. This can be nil.
+// - bufferLength: the length of the buffer in bytes.
+// - userDataP: the IOWA context returned by iowa_init().
+void iowa_coap_oscore_load_callback(uint16_t callbackId,
+                                    uint8_t *buffer,
+                                    size_t bufferLength,
+                                    void *userDataP);
+
 /**************************************************************
  * Helper Functions
  **************************************************************/
@@ -121,6 +121,13 @@ void iowa_log_arg_buffer(uint8_t part,
                          size_t bufferLength,
                          ...);
 
+// Formats and outputs the log records stored in the binary ring buffer when the stack is built with IOWA_LOG_BINARY_SUPPORT.
+// The records are output with iowa_system_trace(). This function can be called from any thread, for instance a low priority one.
+// Returned value: the number of records output.
+// Parameters:
+// - maxCount: maximum number of records to output. 0 to output all the stored records.
+size_t iowa_log_binary_drain(size_t maxCount);
+
 #ifdef __cplusplus
 }
 #endif
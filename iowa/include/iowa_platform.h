@@ -75,6 +75,18 @@ void iowa_system_reboot(void *userData);
 void iowa_system_trace(const char * format,
                        va_list varArgs);
 
+// This function is called to timestamp the logs when the stack is built with IOWA_LOG_BINARY_SUPPORT.
+// It is called for each log, from any thread, and must be fast. A cycle counter or a coarse monotonic clock fits,
+// the order of the records does not depend on the timestamp.
+// Returned value: the current time in a platform-specific unit.
+uint64_t iowa_system_log_timestamp(void);
+
+// This function is called to measure durations when the stack is built with IOWA_METRICS_SUPPORT, IOWA_TRACE_SUPPORT
+// or IOWA_CAPTURE_SUPPORT.
+// The origin does not matter but the clock must be monotonic.
+// Returned value: the number of microseconds elapsed since origin.
+uint64_t iowa_system_gettime_us(void);
+
 
 /*************************************
 * Communication Abstraction Interface
@@ -115,6 +127,9 @@ void * iowa_system_connection_open_server(iowa_connection_type_t type,
 // - connP: the connection as returned by iowa_system_connection_open().
 // - buffer, length: data to send.
 // - userData: the iowa_init() parameter.
+// Note:
+// - With IOWA_SECURITY_STATELESS_COOKIE_SUPPORT, this is also called from iowa_server_new_incoming_connection() to send a
+//   DTLS HelloVerifyRequest.
 int iowa_system_connection_send(void * connP,
                                 uint8_t * buffer,
                                 size_t length,
@@ -127,6 +142,8 @@ int iowa_system_connection_send(void * connP,
 // - buffer: to store the read data.
 // - length: the number of bytes to read.
 // - userData: the iowa_init() parameter.
+// Note:
+// - This is also called from iowa_server_new_incoming_connection() for a secure datagram connection, to read its first datagram.
 int iowa_system_connection_recv(void * connP,
                                 uint8_t * buffer,
                                 size_t length,
@@ -300,11 +317,53 @@ size_t iowa_system_store_context(uint8_t *bufferP,
 
 // This function retrieves an IOWA context.
 // Returned value: the size in bytes of retrieved data or zero if there is nothing or in case of error.
-// - bufferP: buffer containing the retrieved data.
+// - bufferP: buffer containing the retrieved data. It is freed by IOWA using iowa_system_free().
 // - userData: the iowa_init() parameter.
 size_t iowa_system_retrieve_context(uint8_t **bufferP,
                                     void *userData);
 
+// This function appends a record to the journal of the stored IOWA context.
+// The journal must be discarded when iowa_system_store_context() stores a new context.
+// To be implemented by the user if the define IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT is used.
+// Returned value: the number of stored bytes or a zero in case of error.
+// Parameters:
+// - bufferP: the record to append.
+// - length: the length of the record in bytes.
+// - userData: the iowa_init() parameter.
+size_t iowa_system_append_context(uint8_t *bufferP,
+                                  size_t length,
+                                  void *userData);
+
+// This function retrieves the journal appended since the last iowa_system_store_context().
+// When the journal ends with a partial record, iowa_load_context() stores a new context to discard it.
+// To be implemented by the user if the define IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT is used.
+// Returned value: the size in bytes of retrieved data or zero if there is nothing or in case of error.
+// - bufferP: buffer containing the retrieved data. It is freed by IOWA using iowa_system_free().
+// - userData: the iowa_init() parameter.
+size_t iowa_system_retrieve_context_journal(uint8_t **bufferP,
+                                            void *userData);
+
+// This function maps the stored IOWA context as a read-only memory region.
+// The region must stay valid and unchanged until iowa_system_unmap_context() is called. IOWA calls it before
+// iowa_system_store_context() and in iowa_close().
+// To be implemented by the user if the define IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT is used.
+// Returned value: the size in bytes of the mapped region or zero if the context can not be mapped. In this case,
+//                 IOWA calls iowa_system_retrieve_context().
+// - bufferP: OUT. the start of the mapped region.
+// - userData: the iowa_init() parameter.
+size_t iowa_system_map_context(const uint8_t **bufferP,
+                               void *userData);
+
+// This function releases the region returned by iowa_system_map_context().
+// To be implemented by the user if the define IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT is used.
+// Returned value: None.
+// - bufferP: the start of the mapped region.
+// - length: the size in bytes of the mapped region.
+// - userData: the iowa_init() parameter.
+void iowa_system_unmap_context(const uint8_t *bufferP,
+                               size_t length,
+                               void *userData);
+
 /*************************************
 * Security Abstraction Interface
 *
@@ -93,6 +93,10 @@ typedef struct
     size_t   privateKeyLen;
 } iowa_rpk_data_t;
 
+// OSCORE keying material, mapped to the resources of the OSCORE Object (ID: 21).
+// IOWA does not store the Object values: iowa_system_security_data() is called with the Server URI
+// on the client side, or with the received kid on the server side, each time an OSCORE context is created.
+// Only AES-CCM-16-64-128 and HMAC-SHA256 without ID Context are supported.
 typedef struct
 {
     uint8_t *senderId;
@@ -101,6 +105,8 @@ typedef struct
     size_t   recipientIdLen;
     uint8_t *masterSecret;
     size_t   masterSecretLen;
+    uint8_t *masterSalt;
+    size_t   masterSaltLen;
 } iowa_oscore_data_t;
 
 typedef struct
@@ -160,6 +166,16 @@ typedef enum
     SECURITY_AEAD_AES_CCM_64_128_256 = 33
 } iowa_security_aead_t;
 
+// The handshake counters of the server side security sessions.
+typedef struct
+{
+    uint32_t admitted;   // handshakes started with new peers
+    uint32_t deferred;   // new peers refused because IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES handshakes were ongoing
+    uint32_t rejected;   // new peers refused because their first datagram cannot start a handshake or carries an invalid cookie
+    uint32_t challenged; // new peers sent a HelloVerifyRequest, with IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+    uint16_t ongoing;    // handshakes currently in progress
+} iowa_security_handshake_stats_t;
+
 /**************************************************************
 * Security helper functions.
 **************************************************************/
@@ -241,7 +257,8 @@ iowa_security_mode_t iowa_security_session_get_security_mode(iowa_security_sessi
 const char * iowa_security_session_get_uri(iowa_security_session_t securityS);
 
 // Set the delay before the next scheduled operation on a security session.
-// Returned value: the IOWA timeout.
+// The earliest of the delays set since the last step is used.
+// Returned value: none.
 // Parameters:
 // - securityS: a security session.
 // - delay: the time in seconds before iowa_user_security_step() needs to be call again.
@@ -279,6 +296,52 @@ int iowa_security_connection_recv(iowa_security_session_t securityS,
                                   uint8_t *buffer,
                                   size_t length);
 
+// Declare the DTLS Connection ID negotiated for a security session (server side).
+// Records carrying this Connection ID are routed to the security session even when the peer address changed. The first
+// such record is read by iowa_user_security_recv() and the session only moves to the new address if this function returns
+// a positive value, i.e. if the record was authenticated. Otherwise the new connection is closed.
+// All the Connection IDs of an IOWA context must have the same length, set by the first one declared.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - securityS: a security session.
+// - connectionId, length: the Connection ID the peer puts in its records. A zero length removes it.
+iowa_status_t iowa_security_session_set_connection_id(iowa_security_session_t securityS,
+                                                      const uint8_t *connectionId,
+                                                      size_t length);
+
+// Retrieve the handshake counters of the server side security sessions.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - statsP: OUT. the handshake counters.
+void iowa_security_get_handshake_stats(iowa_context_t contextP,
+                                       iowa_security_handshake_stats_t *statsP);
+
+// Store the data allowing to resume the secure session with the peer of a security session (client side).
+// The data are kept after the security session is deleted and until the IOWA context is closed.
+// With IOWA_STORAGE_CONTEXT_SUPPORT, they are part of the context saved by iowa_save_context().
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - securityS: a security session.
+// - buffer, length: the opaque session data. They are copied. A zero length removes the stored data.
+iowa_status_t iowa_security_session_set_resumption_data(iowa_security_session_t securityS,
+                                                        const uint8_t *buffer,
+                                                        size_t length);
+
+// Retrieve the data stored with iowa_security_session_set_resumption_data() for the peer of a security session (client side).
+// Returned value: the length of the session data or zero if none are stored.
+// Parameters:
+// - securityS: a security session.
+// - bufferP: OUT. the session data. Valid until the next call to iowa_security_session_set_resumption_data() or iowa_security_session_clear_resumption_data().
+size_t iowa_security_session_get_resumption_data(iowa_security_session_t securityS,
+                                                 const uint8_t **bufferP);
+
+// Remove the data stored with iowa_security_session_set_resumption_data() for the peer of a security session (client side).
+// Returned value: none.
+// Parameters:
+// - securityS: a security session.
+void iowa_security_session_clear_resumption_data(iowa_security_session_t securityS);
+
 /**************************************************************
 * Security implementation abstraction functions
 * To be implemented by the user
@@ -294,6 +357,10 @@ iowa_status_t iowa_user_security_create_client_session(iowa_security_session_t s
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - securityS: the session to initialize.
+// Note:
+// - With IOWA_SECURITY_STATELESS_COOKIE_SUPPORT, IOWA sends the DTLS HelloVerifyRequest itself and only creates the session
+//   for a ClientHello carrying a valid cookie. This ClientHello is the first packet received by the session. The security
+//   layer must not send another HelloVerifyRequest and must accept this cookie without checking it.
 iowa_status_t iowa_user_security_create_server_session(iowa_security_session_t securityS);
 
 // Delete implementation internals data of a security session.
@@ -309,7 +376,9 @@ void iowa_user_security_delete_session(iowa_security_session_t securityS);
 iowa_status_t iowa_user_security_handle_handshake_packet(iowa_security_session_t securityS);
 
 // Do a security state machine step: handle handshaking, timeout, ...
-// This function should update the IOWA context global timeout.
+// This function is only called when the session has work to do: after iowa_security_session_set_step_delay() delay expired,
+// after a handshake packet was received, or after the session state was set to a handshaking or disconnecting state.
+// It must call iowa_security_session_set_step_delay() to be called again, for instance on retransmission timers.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - securityS: the session to update.
@@ -343,6 +412,8 @@ void iowa_user_security_disconnect(iowa_security_session_t securityS);
 /**************************************************************
 * Security implementation abstraction functions used by OSCORE
 * To be implemented by the user
+* iowa_user_security_HKDF() is also used to compute the DTLS
+* cookies with IOWA_SECURITY_STATELESS_COOKIE_SUPPORT.
 **************************************************************/
 
 // Derive a new key using HMAC-based Extract-and-Expand Key Derivation Function from RFC 5869
@@ -121,12 +121,21 @@ iowa_status_t iowa_server_configure(iowa_context_t contextP,
                                     void *callbackUserData);
 
 // Inform the stack of a new incoming connection.
-// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Returned value: IOWA_COAP_NO_ERROR in case of success, IOWA_COAP_503_SERVICE_UNAVAILABLE if the
+// DTLS handshake is deferred because IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES handshakes are ongoing,
+// IOWA_COAP_400_BAD_REQUEST if the first datagram of a secure connection is not a DTLS ClientHello
+// or carries an invalid cookie, IOWA_COAP_401_UNAUTHORIZED if a HelloVerifyRequest was sent to the
+// peer with IOWA_SECURITY_STATELESS_COOKIE_SUPPORT, or an error status. In these cases, no state is
+// kept for the peer and the connection can be closed: the peer retransmits its ClientHello later.
 // Parameters:
 // - contextP: returned by iowa_init().
 // - type: the type of the connection.
 // - connP: the connection of the same opaque type as returned by iowa_system_connection_open().
 // - isSecure: set to true if the security must be enabled on this connection.
+// Note:
+// - For a secure datagram connection, this function reads the first datagram with iowa_system_connection_recv() to check it
+//   before creating the security session. connP must have a datagram to read. With IOWA_SECURITY_STATELESS_COOKIE_SUPPORT,
+//   it may also send the HelloVerifyRequest with iowa_system_connection_send().
 iowa_status_t iowa_server_new_incoming_connection(iowa_context_t contextP,
                                                   iowa_connection_type_t type,
                                                   void * connP,
@@ -313,6 +322,95 @@ void iowa_server_configure_data_push(iowa_context_t contextP,
                                      iowa_response_callback_t responseCb,
                                      void *userDataP);
 
+/****************************
+ * Notification Queue APIs
+ *
+ * Requires LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT.
+ * When the queue is enabled, the decoded notifications are
+ * stored in a bounded ring buffer instead of being given to
+ * the iowa_server_observe() callback. The application reads
+ * them by batches, typically from another thread.
+ * Reading the queue from another thread than the one running
+ * iowa_step() requires IOWA_THREAD_SUPPORT: the queue is then
+ * protected by iowa_system_mutex_lock().
+ */
+
+typedef enum
+{
+    IOWA_NOTIFICATION_QUEUE_DROP_NEWEST = 0,
+    IOWA_NOTIFICATION_QUEUE_DROP_OLDEST
+} iowa_notification_queue_policy_t;
+
+typedef struct
+{
+    uint32_t                  clientId;
+    iowa_status_t             status;
+    iowa_response_content_t   content;      // as given to the iowa_server_observe() callback
+    iowa_response_callback_t  responseCb;   // the iowa_server_observe() parameter
+    void                     *userDataP;    // the iowa_server_observe() parameter
+} iowa_notification_t;
+
+typedef struct
+{
+    uint32_t queuedCount;       // notifications added to the queue
+    uint32_t deliveredCount;    // notifications read by the application
+    uint32_t droppedCount;      // notifications discarded because the queue was full
+    size_t   currentCount;      // notifications in the queue
+    size_t   maxCount;          // highest number of notifications in the queue
+} iowa_notification_queue_stats_t;
+
+// The callback called when a notification is added to the empty queue.
+// callbackUserData: the iowa_server_configure_notification_queue() parameter.
+// contextP: the IOWA context on which iowa_server_configure_notification_queue() was called.
+// Note:
+// - This is called from the thread running iowa_step(). It is meant to wake up the thread reading the queue.
+// - This is called outside the IOWA mutex. It can call iowa_server_get_notifications().
+typedef void (*iowa_notification_signal_callback_t) (void *callbackUserData,
+                                                     iowa_context_t contextP);
+
+// Enable or disable the notification queue.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - capacity: the maximum number of notifications in the queue. 0 disables the queue and the notifications are given to the iowa_server_observe() callbacks.
+// - policy: the notification to discard when the queue is full.
+// - signalCb: a callback called when a notification is added to the empty queue. This can be nil.
+// - callbackUserData: passed as argument to signalCb.
+// Note:
+// - Notifications still in the queue are discarded.
+iowa_status_t iowa_server_configure_notification_queue(iowa_context_t contextP,
+                                                       size_t capacity,
+                                                       iowa_notification_queue_policy_t policy,
+                                                       iowa_notification_signal_callback_t signalCb,
+                                                       void *callbackUserData);
+
+// Retrieve the oldest notifications from the queue.
+// Returned value: the number of notifications stored in notificationArray.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - notificationArray: OUT. an array to store the notifications.
+// - arraySize: the number of elements of notificationArray.
+// Note:
+// - The notifications must be freed with iowa_server_free_notifications().
+size_t iowa_server_get_notifications(iowa_context_t contextP,
+                                     iowa_notification_t *notificationArray,
+                                     size_t arraySize);
+
+// Free the notifications returned by iowa_server_get_notifications().
+// Returned value: none.
+// Parameters:
+// - notificationArray, notificationCount: the notifications to free.
+void iowa_server_free_notifications(iowa_notification_t *notificationArray,
+                                    size_t notificationCount);
+
+// Retrieve the counters of the notification queue.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - statsP: OUT. the counters.
+void iowa_server_get_notification_queue_stats(iowa_context_t contextP,
+                                              iowa_notification_queue_stats_t *statsP);
+
 
 /**************************************************************
 * Bootstrap Server Role APIs
@@ -335,12 +433,21 @@ typedef void(*iowa_bootstrap_result_callback_t) (iowa_bootstrap_operation_t oper
                                                  iowa_context_t contextP);
 
 // Inform the stack of a new incoming connection.
-// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Returned value: IOWA_COAP_NO_ERROR in case of success, IOWA_COAP_503_SERVICE_UNAVAILABLE if the
+// DTLS handshake is deferred because IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES handshakes are ongoing,
+// IOWA_COAP_400_BAD_REQUEST if the first datagram of a secure connection is not a DTLS ClientHello
+// or carries an invalid cookie, IOWA_COAP_401_UNAUTHORIZED if a HelloVerifyRequest was sent to the
+// peer with IOWA_SECURITY_STATELESS_COOKIE_SUPPORT, or an error status. In these cases, no state is
+// kept for the peer and the connection can be closed: the peer retransmits its ClientHello later.
 // Parameters:
 // - contextP: returned by iowa_init().
 // - type: the type of the connection.
 // - connP: the connection of the same opaque type as returned by iowa_system_connection_open().
 // - isSecure: set to true if the security must be enabled on this connection.
+// Note:
+// - For a secure datagram connection, this function reads the first datagram with iowa_system_connection_recv() to check it
+//   before creating the security session. connP must have a datagram to read. With IOWA_SECURITY_STATELESS_COOKIE_SUPPORT,
+//   it may also send the HelloVerifyRequest with iowa_system_connection_send().
 iowa_status_t iowa_bootstrap_server_new_incoming_connection(iowa_context_t contextP,
                                                             iowa_connection_type_t type,
                                                             void * connP,
@@ -444,6 +551,42 @@ iowa_status_t iowa_bootstrap_server_send_bspack(iowa_context_t contextP,
                                                 uint32_t clientId,
                                                 size_t dataCount, iowa_lwm2m_data_t *dataArray);
 
+/****************************
+ * Bootstrap-Pack templates
+ */
+
+// A Bootstrap-Pack encoded once for a provisioning profile. Only the values of its slots change from one Client to another.
+typedef struct _iowa_bspack_template_t *iowa_bspack_template_t;
+
+// Encode a Bootstrap-Pack template.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataCount, dataArray: the content of the Bootstrap-Pack. The values of the slot Resources only give their type.
+// - slotCount, slotUriArray: the URIs of the Resources whose value is set per Client, e.g. the PSK Identity, the Secret Key or the Short Server ID.
+// - templateP: OUT. the template to release with iowa_bootstrap_server_free_bspack_template().
+// Note: the template does not depend on an IOWA context and can be shared by several contexts.
+iowa_status_t iowa_bootstrap_server_create_bspack_template(size_t dataCount, iowa_lwm2m_data_t *dataArray,
+                                                           size_t slotCount, iowa_lwm2m_uri_t *slotUriArray,
+                                                           iowa_bspack_template_t *templateP);
+
+// Send a Bootstrap-Pack built from a template to a client.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - clientId: the ID of the client to send to.
+// - templateP: the template.
+// - valueCount, valueArray: the values of the template slots, in the order of slotUriArray. Their type must match the template one, their URI is ignored.
+iowa_status_t iowa_bootstrap_server_send_bspack_template(iowa_context_t contextP,
+                                                         uint32_t clientId,
+                                                         iowa_bspack_template_t templateP,
+                                                         size_t valueCount, iowa_lwm2m_data_t *valueArray);
+
+// Release a Bootstrap-Pack template.
+// Returned value: None.
+// Parameters:
+// - templateP: the template returned by iowa_bootstrap_server_create_bspack_template().
+void iowa_bootstrap_server_free_bspack_template(iowa_bspack_template_t templateP);
+
 /****************************
  * Bootstrap high level APIs
  */
@@ -574,6 +717,56 @@ iowa_status_t iowa_server_set_payload_format(iowa_context_t contextP,
 iowa_status_t iowa_server_close_client_connection(iowa_context_t contextP,
                                                   uint32_t clientId);
 
+/**************************************************************
+ * Sharded Server
+ *
+ * The Server load can be split between several IOWA contexts,
+ * the shards, each one running in its own thread. The
+ * application receives the datagrams on one listening socket,
+ * gives each datagram to the shard returned by
+ * iowa_server_get_datagram_shard() and calls the Server APIs
+ * on the shard returned by iowa_server_get_client_shard().
+ * A shard owns the Clients, the security sessions and the
+ * timers created on its context.
+ **************************************************************/
+
+// Make a context one of the shards of a Server.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - shardIndex: the index of this shard, from 0 to shardCount - 1.
+// - shardCount: the number of shards.
+// Note:
+// - This must be called before any Client registers.
+iowa_status_t iowa_server_configure_shard(iowa_context_t contextP,
+                                          uint8_t shardIndex,
+                                          uint8_t shardCount);
+
+// Find the shard handling an incoming datagram.
+// Returned value: the index of the shard.
+// Parameters:
+// - bufferP: the datagram. Can be nil.
+// - bufferLength: the length of the datagram.
+// - peerIdP: the peer identifier, as returned by iowa_system_connection_get_peer_identifier().
+// - peerIdLength: the length of the peer identifier.
+// - shardCount: the number of shards.
+// Note:
+// - A DTLS record with a Connection ID goes to the shard given by the first byte of the Connection ID: the security layer of a shard must
+//   generate Connection IDs starting with the shard index. Other datagrams go to the shard selected by the hash of the peer identifier.
+uint8_t iowa_server_get_datagram_shard(const uint8_t *bufferP,
+                                       size_t bufferLength,
+                                       const uint8_t *peerIdP,
+                                       size_t peerIdLength,
+                                       uint8_t shardCount);
+
+// Find the shard owning a Client.
+// Returned value: the index of the shard.
+// Parameters:
+// - clientId: the ID of the Client.
+// - shardCount: the number of shards.
+uint8_t iowa_server_get_client_shard(uint32_t clientId,
+                                     uint8_t shardCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,94 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2021 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+**********************************************/
+
+/*************************************************************************************
+* IOWA Metrics
+*
+** Description
+*** This vendor LwM2M Object exposes the metrics collected by the stack, as returned by iowa_get_metrics().
+*** The values are not notified when they change: the LwM2M Servers observe them with the pmax attribute.
+*
+** Object Definition
+*** Object Id: IOWA_METRICS_OBJECT_ID (32769 by default)
+*** Instances: Single
+*** Optional
+*
+** Resources
+*** 0-7: the counters of iowa_metrics_t, read-only integers.
+*** 8: Reset, executable. Resets all the metrics.
+*** 10-13: the request round-trip histogram: count, mean and max in microseconds, buckets as multiple resource.
+*** 20-23: the step duration histogram, same layout.
+*** 30-33: the handshake duration histogram, same layout.
+*************************************************************************************/
+
+#ifndef _IOWA_METRICS_INCLUDE_
+#define _IOWA_METRICS_INCLUDE_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "iowa_client.h"
+
+/**************************************************************
+ * Data Structures and Constants
+ **************************************************************/
+
+#define IOWA_METRICS_ID_DATAGRAM_RECEIVED          0
+#define IOWA_METRICS_ID_DATAGRAM_DROPPED           1
+#define IOWA_METRICS_ID_RETRANSMISSION             2
+#define IOWA_METRICS_ID_TRANSACTION_TIMEOUT        3
+#define IOWA_METRICS_ID_NOTIFICATION_SENT          4
+#define IOWA_METRICS_ID_NOTIFICATION_SUPPRESSED    5
+#define IOWA_METRICS_ID_REGISTRATION               6
+#define IOWA_METRICS_ID_REGISTRATION_FAILURE       7
+#define IOWA_METRICS_ID_RESET                      8
+#define IOWA_METRICS_ID_REQUEST_RTT                10
+#define IOWA_METRICS_ID_STEP_DURATION              20
+#define IOWA_METRICS_ID_HANDSHAKE_DURATION         30
+
+// Offsets of the histogram resources from the histogram ID above.
+#define IOWA_METRICS_HISTOGRAM_COUNT   0
+#define IOWA_METRICS_HISTOGRAM_MEAN    1
+#define IOWA_METRICS_HISTOGRAM_MAX     2
+#define IOWA_METRICS_HISTOGRAM_BUCKETS 3
+
+/**************************************************************
+ * API
+ **************************************************************/
+
+// Add the IOWA Metrics object.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+iowa_status_t iowa_client_add_metrics_object(iowa_context_t contextP);
+
+// Remove the IOWA Metrics object created with iowa_client_add_metrics_object().
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+iowa_status_t iowa_client_remove_metrics_object(iowa_context_t contextP);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_IOWA_METRICS_INCLUDE_*/
@@ -69,6 +69,10 @@ void coapClose(iowa_context_t contextP)
         peerP = nextPeerP;
     }
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    oscore_sequenceClear(contextP);
+#endif
+
     iowa_system_free(contextP->coapContextP);
     contextP->coapContextP = NULL;
 
@@ -406,6 +410,47 @@ void coapSendResponse(iowa_context_t contextP,
     }
 }
 
+void coapSendReset(iowa_context_t contextP,
+                   iowa_coap_peer_t *peerP,
+                   iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *resetP;
+
+    switch (coapPeerGetConnectionType(peerP))
+    {
+    case IOWA_CONN_DATAGRAM:
+    case IOWA_CONN_LORAWAN:
+    case IOWA_CONN_SMS:
+        break;
+
+    default:
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "CoAP Reset is not available on peer %p.", peerP);
+        return;
+    }
+
+    if (coapPeerGetConnectionState(peerP) != SECURITY_STATE_CONNECTED)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Peer %p is not connected.", peerP);
+
+        return;
+    }
+
+    resetP = iowa_coap_message_new(IOWA_COAP_TYPE_RESET, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (resetP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP message.");
+        return;
+    }
+#endif
+    resetP->id = messageP->id;
+
+    peerSend(contextP, peerP, resetP, NULL, NULL);
+
+    iowa_coap_message_free(resetP);
+}
+
 /************************************************
 * APIs
 */
@@ -112,9 +112,11 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
 
     case SECURITY_EVENT_DATA_AVAILABLE:
     {
-        static uint8_t buffer[IOWA_BUFFER_SIZE];
+        uint8_t *buffer;
         int bufferLength;
 
+        // Not a static buffer as contexts can run in different threads
+        buffer = contextP->coapContextP->datagramBuffer;
         bufferLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, IOWA_BUFFER_SIZE);
         if (bufferLength > 0)
         {
@@ -122,13 +124,23 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
             uint8_t result;
             size_t maxPayloadSize;
             bool truncated;
+#ifdef IOWA_TRACE_SUPPORT
+            uint64_t traceTime;
+#endif
 
             maxPayloadSize = 0;
 
+            CORE_METRICS_INCREMENT(contextP, datagramReceivedCount);
+
+            CORE_TRACE_START(contextP);
+            CORE_TRACE_TIME(contextP, traceTime);
             result = messageDatagramParse(buffer, (size_t)bufferLength, &messageP);
+            CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_PARSE, traceTime);
             if (result != IOWA_COAP_NO_ERROR)
             {
                 IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                CORE_METRICS_INCREMENT(contextP, datagramDroppedCount);
+                CORE_TRACE_END(contextP, IOWA_TRACE_PHASE_MESSAGE);
                 // ignore message
                 return;
             }
@@ -151,6 +163,8 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
 
                 coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
                 iowa_coap_message_free(messageP);
+                CORE_METRICS_INCREMENT(contextP, datagramDroppedCount);
+                CORE_TRACE_END(contextP, IOWA_TRACE_PHASE_MESSAGE);
                 return;
             }
             else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL) //Server cannot respond to a Block message from the Client when Block is not supported.
@@ -158,12 +172,15 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
                 IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
 
                 iowa_coap_message_free(messageP);
+                CORE_METRICS_INCREMENT(contextP, datagramDroppedCount);
+                CORE_TRACE_END(contextP, IOWA_TRACE_PHASE_MESSAGE);
                 return;
             }
 
             transactionHandleMessage(contextP, peerP, messageP, truncated, maxPayloadSize);
 
             iowa_coap_message_free(messageP);
+            CORE_TRACE_END(contextP, IOWA_TRACE_PHASE_MESSAGE);
             return;
         }
     }
@@ -197,95 +197,137 @@ size_t option_serialize(iowa_coap_option_t *optionList,
     return index;
 }
 
-uint8_t option_parse(uint8_t *buffer,
-                     size_t bufferLength,
-                     iowa_coap_option_t **optionListP,
-                     size_t *lengthP,
-                     coap_option_callback_t isIntegerCallback)
+uint8_t option_parseNext(uint8_t *buffer,
+                         size_t bufferLength,
+                         size_t *indexP,
+                         iowa_coap_option_t *optionP,
+                         coap_option_callback_t isIntegerCallback)
 {
-    uint8_t result;
     size_t index;
-    iowa_coap_option_t *currOptionP;
+    uint16_t delta;
+    uint16_t length;
 
-    index = 0;
-    currOptionP = NULL;
+    index = *indexP;
 
-    while (index < bufferLength
-           && buffer[index] != PRV_MSG_PAYLOAD_MARKER)
+    delta = ((uint8_t)(buffer[index] & PRV_OPT_DELTA_MASK)) >> PRV_OPT_DELTA_SHIFT;
+    length = buffer[index] & PRV_OPT_LENGTH_MASK;
+    index += PRV_OPT_HEADER_LENGTH;
+    if (index > bufferLength)
     {
-        uint16_t delta;
-        uint16_t length;
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are truncated in the received buffer.");
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
 
-        delta = ((uint8_t)(buffer[index] & PRV_OPT_DELTA_MASK)) >> PRV_OPT_DELTA_SHIFT;
-        length = buffer[index] & PRV_OPT_LENGTH_MASK;
-        index += PRV_OPT_HEADER_LENGTH;
-        if (index > bufferLength)
-        {
-            IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are truncated in the received buffer.");
-            result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
-            goto exit_on_error;
-        }
+    switch (delta)
+    {
+    case PRV_OPT_EXTEND_FORBIDDEN:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Delta is 0xF for the option at %u.", index);
+        return IOWA_COAP_400_BAD_REQUEST;
 
-        switch (delta)
-        {
-        case PRV_OPT_EXTEND_FORBIDDEN:
-            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Delta is 0xF for the option at %u.", index);
-            result = IOWA_COAP_400_BAD_REQUEST;
-            goto exit_on_error;
+    case PRV_OPT_EXTEND_1:
+        delta = (uint16_t)(PRV_OPT_LIMIT_1 + buffer[index]);
+        index++;
+        break;
 
-        case PRV_OPT_EXTEND_1:
-            delta = (uint16_t)(PRV_OPT_LIMIT_1 + buffer[index]);
-            index++;
-            break;
+    case PRV_OPT_EXTEND_2:
+        delta = PRV_OPT_LIMIT_2 + ((uint16_t) buffer[index] << 8) + buffer[index + 1];
+        index += 2;
+        break;
 
-        case PRV_OPT_EXTEND_2:
-            delta = PRV_OPT_LIMIT_2 + ((uint16_t) buffer[index] << 8) + buffer[index + 1];
-            index += 2;
-            break;
+    default:
+        break;
+    }
 
-        default:
-            break;
-        }
+    if (index > bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are truncated in the received buffer.");
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
 
-        if (index > bufferLength)
-        {
-            IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are truncated in the received buffer.");
-            result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
-            goto exit_on_error;
-        }
+    switch (length)
+    {
+    case PRV_OPT_EXTEND_FORBIDDEN:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Length is 0xF for the option at %u.", index);
+        return IOWA_COAP_400_BAD_REQUEST;
 
-        switch (length)
-        {
-        case PRV_OPT_EXTEND_FORBIDDEN:
-            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Length is 0xF for the option at %u.", index);
-            result = IOWA_COAP_400_BAD_REQUEST;
-            goto exit_on_error;
+    case PRV_OPT_EXTEND_1:
+        length = (uint16_t)(PRV_OPT_LIMIT_1 + buffer[index]);
+        index++;
+        break;
 
-        case PRV_OPT_EXTEND_1:
-            length = (uint16_t)(PRV_OPT_LIMIT_1 + buffer[index]);
-            index++;
-            break;
+    case PRV_OPT_EXTEND_2:
+        length = PRV_OPT_LIMIT_2 + ((uint16_t) buffer[index] << 8) + buffer[index + 1];
+        index += 2;
+        break;
 
-        case PRV_OPT_EXTEND_2:
-            length = PRV_OPT_LIMIT_2 + ((uint16_t) buffer[index] << 8) + buffer[index + 1];
-            index += 2;
-            break;
+    default:
+        break;
+    }
 
-        default:
-            break;
-        }
+    if (index > bufferLength
+        || index + length > bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are truncated in the received buffer.");
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    optionP->number = (uint16_t)(optionP->number + delta);
+    optionP->length = 0;
+    optionP->value.asBuffer = NULL;
 
-        if (index > bufferLength
-            || index + length > bufferLength)
+    if (length > 0)
+    {
+        if (isIntegerCallback(optionP))
         {
-            IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are truncated in the received buffer.");
-            result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
-            goto exit_on_error;
+            if (length > 4)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Implementation limit reached for the integer option at %u.", bufferLength, index);
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            optionP->value.asInteger = 0;
+            while (length > 0)
+            {
+                optionP->value.asInteger = (optionP->value.asInteger << 8) + buffer[index];
+                index++;
+                length--;
+            }
         }
+        else
+        {
+            optionP->length = length;
+            optionP->value.asBuffer = buffer + index;
+        }
+    }
+    else
+    {
+        optionP->value.asInteger = 0;
+    }
+
+    *indexP = index + length;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t option_parse(uint8_t *buffer,
+                     size_t bufferLength,
+                     iowa_coap_option_t **optionListP,
+                     size_t *lengthP,
+                     coap_option_callback_t isIntegerCallback)
+{
+    uint8_t result;
+    size_t index;
+    iowa_coap_option_t *currOptionP;
 
+    index = 0;
+    currOptionP = NULL;
+
+    while (index < bufferLength
+           && buffer[index] != PRV_MSG_PAYLOAD_MARKER)
+    {
         if (currOptionP != NULL)
         {
-            currOptionP->next = iowa_coap_option_new((uint16_t)(currOptionP->number + delta));
+            // The number of the new option is computed from the previous one
+            currOptionP->next = iowa_coap_option_new(currOptionP->number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (currOptionP->next == NULL)
             {
@@ -298,7 +340,7 @@ uint8_t option_parse(uint8_t *buffer,
         }
         else
         {
-            *optionListP = iowa_coap_option_new(delta);
+            *optionListP = iowa_coap_option_new(0);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (*optionListP == NULL)
             {
@@ -310,30 +352,11 @@ uint8_t option_parse(uint8_t *buffer,
             currOptionP = *optionListP;
         }
 
-        if (length > 0)
+        result = option_parseNext(buffer, bufferLength, &index, currOptionP, isIntegerCallback);
+        if (result != IOWA_COAP_NO_ERROR)
         {
-            if (isIntegerCallback(currOptionP))
-            {
-                if (length > 4)
-                {
-                    IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Implementation limit reached for the integer option at %u.", bufferLength, index);
-                    result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-                    goto exit_on_error;
-                }
-                while (length > 0)
-                {
-                    currOptionP->value.asInteger = (currOptionP->value.asInteger << 8) + buffer[index];
-                    index++;
-                    length--;
-                }
-            }
-            else
-            {
-                currOptionP->length = length;
-                currOptionP->value.asBuffer = buffer + index;
-            }
+            goto exit_on_error;
         }
-        index += length;
     }
 
     *lengthP = index;
@@ -69,6 +69,9 @@ static uint8_t prv_send(iowa_context_t contextP,
 {
     // WARNING: This function is called in a critical section
     uint8_t result;
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    iowa_coap_message_t *protectedMessageP;
+#endif
 
 #if !defined(IOWA_UDP_SUPPORT) && !defined(IOWA_LORAWAN_SUPPORT) && !defined(IOWA_SMS_SUPPORT)
     (void)resultCallback;
@@ -103,6 +106,24 @@ static uint8_t prv_send(iowa_context_t contextP,
 
     COAP_LOG_MESSAGE("Sending", peerP->base.type, messageP);
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    protectedMessageP = NULL;
+    if (peerP->base.oscoreContextP != NULL
+        && messageP->code != IOWA_COAP_CODE_EMPTY)
+    {
+        result = oscore_encryptMessage(contextP, peerP->base.oscoreContextP, messageP, &protectedMessageP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "OSCORE protection failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+            return result;
+        }
+        if (protectedMessageP != NULL)
+        {
+            messageP = protectedMessageP;
+        }
+    }
+#endif
+
     switch (peerP->base.type)
     {
 #ifdef IOWA_UDP_SUPPORT
@@ -123,6 +144,10 @@ static uint8_t prv_send(iowa_context_t contextP,
         result = IOWA_COAP_501_NOT_IMPLEMENTED;
     }
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    iowa_coap_message_free(protectedMessageP);
+#endif
+
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Exiting with result %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
 
     return result;
@@ -183,6 +208,9 @@ static void peer_free(iowa_context_t contextP,
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Freeing peer %p.", peerP);
 
     securityDeleteSession(contextP, peerP->base.securityS);
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    oscore_contextDelete(peerP->base.oscoreContextP);
+#endif
 
     switch (peerP->base.type)
     {
@@ -288,6 +316,17 @@ iowa_coap_peer_t *coapPeerCreate(iowa_context_t contextP,
         return NULL;
     }
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    // OSCORE protects the messages, the transport is secured only when combined with another mode
+    if (securityMode == IOWA_SEC_OSCORE)
+    {
+        transportSecurityMode = IOWA_SEC_NONE;
+    }
+    else
+    {
+        transportSecurityMode = (iowa_security_mode_t)(securityMode & ~IOWA_SEC_OSCORE);
+    }
+#else
 #ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
     if ((securityMode & IOWA_SEC_OSCORE) == IOWA_SEC_OSCORE)
     {
@@ -296,6 +335,7 @@ iowa_coap_peer_t *coapPeerCreate(iowa_context_t contextP,
     }
 #endif
     transportSecurityMode = securityMode;
+#endif
 
     securityS = securityClientNewSession(contextP, uri, transportSecurityMode);
     if (securityS == NULL)
@@ -315,6 +355,20 @@ iowa_coap_peer_t *coapPeerCreate(iowa_context_t contextP,
     peerP->base.securityS = securityS;
     peerP->base.type = type;
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    if ((securityMode & IOWA_SEC_OSCORE) == IOWA_SEC_OSCORE)
+    {
+        peerP->base.oscoreContextP = oscore_contextCreateFromURI(contextP, uri);
+        if (peerP->base.oscoreContextP == NULL)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Cannot create a new OSCORE context.");
+
+            peer_free(contextP, peerP);
+            return NULL;
+        }
+    }
+#endif
+
     switch (peerP->base.type)
     {
 #ifdef IOWA_UDP_SUPPORT
@@ -392,12 +446,23 @@ uint8_t coapPeerNew(iowa_context_t contextP,
 {
     security_event_callback_t securityEventCallback;
     iowa_security_session_t securityS;
+    uint8_t result;
 
-    securityS = securityServerNewSession(contextP, type, connP, isSecure);
-    if (securityS == NULL)
+    result = securityServerNewSession(contextP, type, connP, isSecure, &securityS);
+    switch (result)
     {
+    case IOWA_COAP_NO_ERROR:
+        break;
+
+    case IOWA_COAP_503_SERVICE_UNAVAILABLE:
+    case IOWA_COAP_400_BAD_REQUEST:
+        // Refused by the handshake admission control: too many ongoing handshakes or not a handshake
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "New security session refused: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        return result;
+
+    default:
         IOWA_LOG_ERROR(IOWA_PART_COAP, "Cannot create a new security session.");
-        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        return result;
     }
 
     *peerP = peer_new(type);
@@ -689,6 +754,9 @@ uint8_t peerSend(iowa_context_t contextP,
     coap_exchange_t *exchangeP;
     coap_message_callback_t intermediateCallback;
     void *intermediateUserdata;
+#ifdef IOWA_TRACE_SUPPORT
+    uint64_t traceTime;
+#endif
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Entering with peerP: %p, messageP: %p.", peerP, messageP);
 
@@ -739,7 +807,9 @@ uint8_t peerSend(iowa_context_t contextP,
     }
 #endif
 
+    CORE_TRACE_TIME(contextP, traceTime);
     result = prv_send(contextP, peerP, messageP, intermediateCallback, intermediateUserdata);
+    CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_SEND, traceTime);
 
     if (result == IOWA_COAP_NO_ERROR)
     {
@@ -861,6 +931,11 @@ void peerHandleMessage(iowa_context_t contextP,
 {
     // WARNING: This function is called in a critical section
     uint8_t code;
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    iowa_coap_message_t *plainMessageP;
+
+    plainMessageP = NULL;
+#endif
 
     IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "peerP: %p, truncated: %s, maxPayloadSize: %u.", peerP, truncated ? "true" : "false", maxPayloadSize);
     COAP_LOG_MESSAGE("Handling", peerP->base.type, messageP);
@@ -885,6 +960,67 @@ void peerHandleMessage(iowa_context_t contextP,
         goto exit;
     }
 #endif
+
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    if (truncated == false
+        && code != IOWA_COAP_CODE_EMPTY)
+    {
+        iowa_coap_option_t *oscoreOptionP;
+
+        oscoreOptionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OSCORE);
+        if (oscoreOptionP != NULL)
+        {
+            uint8_t result;
+
+            result = IOWA_COAP_NO_ERROR;
+#ifdef IOWA_COAP_SERVER_MODE
+            if (peerP->base.oscoreContextP == NULL
+                && COAP_IS_REQUEST(code))
+            {
+                result = oscore_contextCreateFromOption(contextP, oscoreOptionP, &(peerP->base.oscoreContextP));
+            }
+#endif
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                if (peerP->base.oscoreContextP != NULL)
+                {
+                    result = oscore_decryptMessage(contextP, peerP, peerP->base.oscoreContextP, messageP, &plainMessageP);
+                }
+                else
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_COAP, "OSCORE protected message received without OSCORE context.");
+                    result = IOWA_COAP_401_UNAUTHORIZED;
+                }
+            }
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "OSCORE verification failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                if (COAP_IS_REQUEST(code))
+                {
+                    coapSendResponse(contextP, peerP, messageP, result);
+                }
+                goto exit;
+            }
+
+            messageP = plainMessageP;
+            code = messageP->code;
+            COAP_LOG_MESSAGE("Unprotected", peerP->base.type, messageP);
+        }
+        else if (peerP->base.oscoreContextP != NULL
+                 && (COAP_IS_REQUEST(code)
+                     || !COAP_IS_ERROR(code)))
+        {
+            // Only error responses may be sent unprotected. See section 8.2 of RFC 8613.
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "Unprotected message received from an OSCORE peer.");
+            if (COAP_IS_REQUEST(code))
+            {
+                coapSendResponse(contextP, peerP, messageP, IOWA_COAP_401_UNAUTHORIZED);
+            }
+            goto exit;
+        }
+    }
+#endif
+
     if (!COAP_IS_REQUEST(messageP->code))
     {
         coap_exchange_t *exchangeP;
@@ -966,6 +1102,9 @@ void peerHandleMessage(iowa_context_t contextP,
 #endif
 
 exit:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    iowa_coap_message_free(plainMessageP);
+#endif
     IOWA_LOG_INFO(IOWA_PART_COAP, "Exiting.");
 }
 
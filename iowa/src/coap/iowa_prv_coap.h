@@ -126,6 +126,7 @@ typedef struct _coap_exchange_t coap_exchange_t;
 typedef struct _block_transfer_t block_transfer_t;
 typedef struct _block_payload_t block_payload_t;
 typedef struct _oscore_peer_context_t oscore_peer_context_t;
+typedef struct _oscore_sequence_t oscore_sequence_t;
 
 typedef struct
 {
@@ -204,6 +205,9 @@ typedef struct _coap_peer_base_t
     coap_exchange_t          *exchangeList;
     void                     *userData;
     iowa_security_session_t   securityS;
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    oscore_peer_context_t    *oscoreContextP;
+#endif
 } coap_peer_base_t;
 
 struct _iowa_coap_peer_t
@@ -215,6 +219,10 @@ struct _iowa_coap_peer_t
 size_t option_getSerializedLength(iowa_coap_option_t * optionP, coap_option_callback_t isIntegerCallback);
 size_t option_serialize(iowa_coap_option_t * optionList, uint8_t * buffer, coap_option_callback_t isIntegerCallback);
 uint8_t option_parse(uint8_t * buffer, size_t bufferLength, iowa_coap_option_t * *optionListP, size_t * lengthP, coap_option_callback_t isIntegerCallback);
+// Parse the option at buffer[*indexP] into optionP without any allocation.
+// optionP->number must contain the number of the previous option, or 0.
+// The value of optionP points to buffer. On success, *indexP is moved after the option.
+uint8_t option_parseNext(uint8_t * buffer, size_t bufferLength, size_t * indexP, iowa_coap_option_t * optionP, coap_option_callback_t isIntegerCallback);
 
 /************************************************
 * APIs
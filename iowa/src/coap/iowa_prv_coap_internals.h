@@ -35,6 +35,10 @@ extern "C" {
 #define IOWA_COAP_CLIENT_MODE
 #endif
 
+#if defined(LWM2M_SERVER_MODE) || defined(LWM2M_BOOTSTRAP_SERVER_MODE)
+#define IOWA_COAP_SERVER_MODE
+#endif
+
 #include "iowa_prv_coap.h"
 #include "iowa_prv_logger.h"
 #include "iowa_prv_misc.h"
@@ -194,6 +198,12 @@ struct _coap_transaction_t
     uint8_t                    *buffer;
     coap_message_callback_t     callback;
     void                       *userData;
+#if defined(IOWA_METRICS_SUPPORT) || defined(IOWA_TRACE_SUPPORT)
+    uint64_t                    sendTime; // first transmission, as returned by iowa_system_gettime_us()
+#endif
+#ifdef IOWA_TRACE_SUPPORT
+    uint32_t                    traceId;  // trace of the message, 0 if not traced
+#endif
 };
 
 struct _coap_ack_t
@@ -260,6 +270,12 @@ typedef struct
 struct _coap_context_t
 {
     iowa_coap_peer_t              *peerList;
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    oscore_sequence_t             *oscoreSequenceList;
+#endif
+#ifdef IOWA_UDP_SUPPORT
+    uint8_t                        datagramBuffer[IOWA_BUFFER_SIZE];   // reception buffer of the datagram peers
+#endif
 };
 
 typedef struct
@@ -390,6 +406,7 @@ uint8_t messageSendSMS(iowa_context_t contextP, iowa_coap_peer_t *peerBaseP, iow
 void smsSecurityEventCb(iowa_security_session_t securityS, iowa_security_event_t event, void *userData, iowa_context_t contextP);
 
 // Implemented in iowa_oscore.c
+#ifdef IOWA_COAP_OSCORE_SUPPORT
 
 // Create an OSCORE peer context from an URI. Used on the client side.
 // Returned value: A new initialized OSCORE peer context or null in case of error.
@@ -418,17 +435,21 @@ void oscore_contextDelete(oscore_peer_context_t *peerContextP);
 // Encrypt a CoAP message.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
+// - contextP: as returned by iowa_init().
 // - peerContextP: Pointer to the OSCORE peer context to use.
 // - plainMessageP: CoAP message to encrypt.
-// - encryptedMessageP: OUT. Encrypted CoAP message.
+// - encryptedMessageP: OUT. Encrypted CoAP message. This is nil when the message is to be sent unprotected,
+//                      i.e. an error response to a request which could not be verified.
 iowa_status_t oscore_encryptMessage(iowa_context_t contextP,
                                     oscore_peer_context_t *peerContextP,
                                     iowa_coap_message_t *plainMessageP,
                                     iowa_coap_message_t **encryptedMessageP);
 
 // Decrypt a CoAP message.
-// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status to return to the peer.
 // Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer which sent the message.
 // - peerContextP: Pointer to the OSCORE peer context to use.
 // - encryptedMessageP: CoAP message to decrypt.
 // - plainMessageP: OUT. Decrypted CoAP message.
@@ -438,6 +459,34 @@ iowa_status_t oscore_decryptMessage(iowa_context_t contextP,
                                     iowa_coap_message_t *encryptedMessageP,
                                     iowa_coap_message_t **plainMessageP);
 
+// Free the sequence number states of the security contexts.
+// Returned value: None.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void oscore_sequenceClear(iowa_context_t contextP);
+
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+// Serialize the sequence number states of the security contexts.
+// Returned value: the length of the serialized data or zero in case of error.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - buffer, length: the buffer to store the data. When nil, only the required length is computed.
+size_t oscore_sequenceBackup(iowa_context_t contextP,
+                             uint8_t *buffer,
+                             size_t length);
+
+// Restore the sequence number states of the security contexts.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - buffer, length: the data returned by oscore_sequenceBackup().
+iowa_status_t oscore_sequenceRestore(iowa_context_t contextP,
+                                     const uint8_t *buffer,
+                                     size_t length);
+#endif // IOWA_STORAGE_CONTEXT_SUPPORT
+
+#endif // IOWA_COAP_OSCORE_SUPPORT
+
 #ifdef __cplusplus
 }
 #endif
@@ -76,6 +76,20 @@ static coap_transaction_t *prv_transactionFind(coap_peer_datagram_t *peerP,
     return NULL;
 }
 
+#ifdef IOWA_METRICS_SUPPORT
+static void prv_transactionRecordRtt(iowa_context_t contextP,
+                                     coap_transaction_t *transacP)
+{
+    // WARNING: This function is called in a critical section
+
+    // After a retransmission, the reply can not be matched to one of the transmissions (Karn's algorithm)
+    if (transacP->retrans_counter == 0)
+    {
+        CORE_METRICS_RECORD_DURATION(contextP, requestRtt, transacP->sendTime);
+    }
+}
+#endif
+
 void transactionFree(coap_transaction_t *transacP)
 {
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Freeing transaction %p.", transacP);
@@ -134,6 +148,12 @@ uint8_t transactionNew(iowa_context_t contextP,
         transacP->buffer = buffer;
         transacP->callback = resultCallback;
         transacP->userData = userData;
+#if defined(IOWA_METRICS_SUPPORT) || defined(IOWA_TRACE_SUPPORT)
+        transacP->sendTime = iowa_system_gettime_us();
+#endif
+#ifdef IOWA_TRACE_SUPPORT
+        transacP->traceId = contextP->trace.currentId;
+#endif
 
         peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_ADD(peerP->transactionList, transacP);
 
@@ -263,6 +283,7 @@ uint8_t transactionStep(iowa_context_t contextP,
                 (void)peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, transacP->buffer, transacP->buffer_len);
 
                 transacP->retrans_counter++;
+                CORE_METRICS_INCREMENT(contextP, retransmissionCount);
 
                 timeout = peerP->ackTimeout << transacP->retrans_counter;
 
@@ -274,6 +295,8 @@ uint8_t transactionStep(iowa_context_t contextP,
             }
             else
             {
+                CORE_METRICS_INCREMENT(contextP, transactionTimeoutCount);
+
                 // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
                 peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
                 if (transacP->callback != NULL)
@@ -345,6 +368,11 @@ void transactionHandleMessage(iowa_context_t contextP,
         transacP = prv_transactionFind(peerP, messageP);
         if (transacP != NULL)
         {
+#ifdef IOWA_METRICS_SUPPORT
+            prv_transactionRecordRtt(contextP, transacP);
+#endif
+            CORE_TRACE_EMIT(contextP, transacP->traceId, IOWA_TRACE_PHASE_ACK, transacP->sendTime);
+
             // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
             peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
             if (transacP->callback != NULL)
@@ -370,6 +398,10 @@ void transactionHandleMessage(iowa_context_t contextP,
         transacP = prv_transactionFind(peerP, messageP);
         if (transacP != NULL)
         {
+#ifdef IOWA_METRICS_SUPPORT
+            prv_transactionRecordRtt(contextP, transacP);
+#endif
+
             // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
             peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
             if (transacP->callback != NULL)
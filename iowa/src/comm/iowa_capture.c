@@ -0,0 +1,396 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_comm.h"
+#include "iowa_prv_logger.h"
+#include "iowa_prv_core.h"
+
+#ifdef IOWA_CAPTURE_SUPPORT
+
+#ifndef IOWA_CAPTURE_SNAPLEN
+#define IOWA_CAPTURE_SNAPLEN IOWA_BUFFER_SIZE // Default value
+#endif
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+#define PRV_PCAP_MAGIC              0xA1B2C3D4 // timestamps in microseconds
+#define PRV_PCAP_VERSION_MAJOR      2
+#define PRV_PCAP_VERSION_MINOR      4
+#define PRV_PCAP_LINKTYPE_RAW       101        // the packets start with an IP header
+#define PRV_PCAP_FILE_HEADER_SIZE   24
+#define PRV_PCAP_RECORD_HEADER_SIZE 16
+
+#define PRV_IPV4_HEADER_SIZE        20
+#define PRV_UDP_HEADER_SIZE         8
+#define PRV_PACKET_HEADER_SIZE      (PRV_IPV4_HEADER_SIZE + PRV_UDP_HEADER_SIZE)
+#define PRV_IPV4_PROTOCOL_UDP       17
+#define PRV_COAP_PORT               5683
+
+static void prv_writeUint16(uint8_t *bufferP,
+                            uint16_t value)
+{
+    // Network byte order
+    bufferP[0] = (uint8_t)(value >> 8);
+    bufferP[1] = (uint8_t)value;
+}
+
+static void prv_setAddress(uint8_t *bufferP,
+                           comm_channel_t *channelP)
+{
+    // The device is 10.0.0.1 and the peers are 10.1.x.y
+    bufferP[0] = 10;
+    if (channelP == NULL)
+    {
+        bufferP[1] = 0;
+        bufferP[2] = 0;
+        bufferP[3] = 1;
+    }
+    else
+    {
+        bufferP[1] = 1;
+        prv_writeUint16(bufferP + 2, channelP->captureId);
+    }
+}
+
+static void prv_ringWrite(comm_capture_t *captureP,
+                          size_t offset,
+                          const uint8_t *bufferP,
+                          size_t length)
+{
+    // WARNING: This function is called in a critical section
+    size_t position;
+    size_t firstLength;
+
+    position = (captureP->start + offset) % captureP->size;
+    firstLength = captureP->size - position;
+    if (firstLength > length)
+    {
+        firstLength = length;
+    }
+
+    memcpy(captureP->bufferP + position, bufferP, firstLength);
+    if (length > firstLength)
+    {
+        memcpy(captureP->bufferP, bufferP + firstLength, length - firstLength);
+    }
+}
+
+static void prv_ringRead(comm_capture_t *captureP,
+                         size_t offset,
+                         uint8_t *bufferP,
+                         size_t length)
+{
+    // WARNING: This function is called in a critical section
+    size_t position;
+    size_t firstLength;
+
+    position = (captureP->start + offset) % captureP->size;
+    firstLength = captureP->size - position;
+    if (firstLength > length)
+    {
+        firstLength = length;
+    }
+
+    memcpy(bufferP, captureP->bufferP + position, firstLength);
+    if (length > firstLength)
+    {
+        memcpy(bufferP + firstLength, captureP->bufferP, length - firstLength);
+    }
+}
+
+static size_t prv_oldestRecordLength(comm_capture_t *captureP)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t header[PRV_PCAP_RECORD_HEADER_SIZE];
+    uint32_t includedLength;
+
+    prv_ringRead(captureP, 0, header, PRV_PCAP_RECORD_HEADER_SIZE);
+    memcpy(&includedLength, header + 8, sizeof(uint32_t));
+
+    return PRV_PCAP_RECORD_HEADER_SIZE + (size_t)includedLength;
+}
+
+static void prv_removeOldestRecord(comm_capture_t *captureP,
+                                   size_t recordLength)
+{
+    // WARNING: This function is called in a critical section
+    captureP->start = (captureP->start + recordLength) % captureP->size;
+    captureP->length -= recordLength;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+void commCaptureRecord(iowa_context_t contextP,
+                       comm_channel_t *channelP,
+                       bool isSent,
+                       const uint8_t *buffer,
+                       size_t length)
+{
+    // WARNING: This function is called in a critical section
+    comm_capture_t *captureP;
+    uint8_t header[PRV_PCAP_RECORD_HEADER_SIZE + PRV_PACKET_HEADER_SIZE];
+    uint8_t *packetP;
+    size_t capturedLength;
+    size_t recordLength;
+    uint64_t currentTime;
+    uint32_t value;
+    uint32_t checksum;
+    size_t i;
+
+    captureP = &(contextP->commContextP->capture);
+    if (captureP->bufferP == NULL)
+    {
+        return;
+    }
+
+    switch (channelP->type)
+    {
+    case IOWA_CONN_DATAGRAM:
+    case IOWA_CONN_LORAWAN:
+    case IOWA_CONN_SMS:
+        break;
+
+    default:
+        // Streams are not made of datagrams
+        return;
+    }
+
+    capturedLength = length;
+    if (capturedLength > IOWA_CAPTURE_SNAPLEN)
+    {
+        capturedLength = IOWA_CAPTURE_SNAPLEN;
+    }
+    recordLength = sizeof(header) + capturedLength;
+    if (recordLength > captureP->size)
+    {
+        captureP->droppedCount++;
+        return;
+    }
+
+    while (captureP->length + recordLength > captureP->size)
+    {
+        prv_removeOldestRecord(captureP, prv_oldestRecordLength(captureP));
+        captureP->droppedCount++;
+    }
+
+    // pcap record header, in host byte order
+    currentTime = iowa_system_gettime_us();
+    value = (uint32_t)(currentTime / 1000000);
+    memcpy(header, &value, sizeof(uint32_t));
+    value = (uint32_t)(currentTime % 1000000);
+    memcpy(header + 4, &value, sizeof(uint32_t));
+    value = (uint32_t)(PRV_PACKET_HEADER_SIZE + capturedLength);
+    memcpy(header + 8, &value, sizeof(uint32_t));
+    value = (uint32_t)(PRV_PACKET_HEADER_SIZE + length);
+    memcpy(header + 12, &value, sizeof(uint32_t));
+
+    // IPv4 header
+    packetP = header + PRV_PCAP_RECORD_HEADER_SIZE;
+    memset(packetP, 0, PRV_PACKET_HEADER_SIZE);
+    packetP[0] = 0x45; // version 4, header of 5 words
+    prv_writeUint16(packetP + 2, (uint16_t)(PRV_PACKET_HEADER_SIZE + length));
+    packetP[8] = 64;   // TTL
+    packetP[9] = PRV_IPV4_PROTOCOL_UDP;
+    if (isSent == true)
+    {
+        prv_setAddress(packetP + 12, NULL);
+        prv_setAddress(packetP + 16, channelP);
+    }
+    else
+    {
+        prv_setAddress(packetP + 12, channelP);
+        prv_setAddress(packetP + 16, NULL);
+    }
+    checksum = 0;
+    for (i = 0; i < PRV_IPV4_HEADER_SIZE; i += 2)
+    {
+        checksum += (uint32_t)((packetP[i] << 8) | packetP[i + 1]);
+    }
+    while ((checksum >> 16) != 0)
+    {
+        checksum = (checksum & 0xFFFF) + (checksum >> 16);
+    }
+    prv_writeUint16(packetP + 10, (uint16_t)~checksum);
+
+    // UDP header, without checksum
+    prv_writeUint16(packetP + PRV_IPV4_HEADER_SIZE, PRV_COAP_PORT);
+    prv_writeUint16(packetP + PRV_IPV4_HEADER_SIZE + 2, PRV_COAP_PORT);
+    prv_writeUint16(packetP + PRV_IPV4_HEADER_SIZE + 4, (uint16_t)(PRV_UDP_HEADER_SIZE + length));
+
+    prv_ringWrite(captureP, captureP->length, header, sizeof(header));
+    prv_ringWrite(captureP, captureP->length + sizeof(header), buffer, capturedLength);
+    captureP->length += recordLength;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_capture_start(iowa_context_t contextP,
+                                 size_t bufferSize)
+{
+    comm_capture_t *captureP;
+    uint8_t *bufferP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Starting the capture with a buffer of %u bytes.", bufferSize);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (bufferSize <= PRV_PCAP_RECORD_HEADER_SIZE + PRV_PACKET_HEADER_SIZE)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COMM, "bufferSize (%u) is too small.", bufferSize);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    bufferP = (uint8_t *)iowa_system_malloc(bufferSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(bufferSize);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+
+    captureP = &(contextP->commContextP->capture);
+    iowa_system_free(captureP->bufferP);
+    captureP->bufferP = bufferP;
+    captureP->size = bufferSize;
+    captureP->start = 0;
+    captureP->length = 0;
+    captureP->droppedCount = 0;
+    captureP->isHeaderPending = true;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_capture_stop(iowa_context_t contextP)
+{
+    comm_capture_t *captureP;
+
+    IOWA_LOG_INFO(IOWA_PART_COMM, "Stopping the capture.");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    captureP = &(contextP->commContextP->capture);
+    iowa_system_free(captureP->bufferP);
+    captureP->bufferP = NULL;
+    captureP->size = 0;
+    captureP->start = 0;
+    captureP->length = 0;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_capture_read(iowa_context_t contextP,
+                                uint8_t *bufferP,
+                                size_t bufferLength,
+                                size_t *readLengthP,
+                                uint32_t *droppedCountP)
+{
+    comm_capture_t *captureP;
+    size_t recordLength;
+    uint32_t value;
+    uint16_t version;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (bufferP == NULL
+        || readLengthP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COMM, "bufferP or readLengthP is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    *readLengthP = 0;
+
+    CRIT_SECTION_ENTER(contextP);
+
+    captureP = &(contextP->commContextP->capture);
+    if (captureP->bufferP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        IOWA_LOG_WARNING(IOWA_PART_COMM, "The capture is not running.");
+        return IOWA_COAP_412_PRECONDITION_FAILED;
+    }
+
+    if (captureP->isHeaderPending == true)
+    {
+        if (bufferLength < PRV_PCAP_FILE_HEADER_SIZE)
+        {
+            CRIT_SECTION_LEAVE(contextP);
+            return IOWA_COAP_NO_ERROR;
+        }
+
+        // pcap file header, in host byte order
+        value = PRV_PCAP_MAGIC;
+        memcpy(bufferP, &value, sizeof(uint32_t));
+        version = PRV_PCAP_VERSION_MAJOR;
+        memcpy(bufferP + 4, &version, sizeof(uint16_t));
+        version = PRV_PCAP_VERSION_MINOR;
+        memcpy(bufferP + 6, &version, sizeof(uint16_t));
+        memset(bufferP + 8, 0, 8); // time zone and accuracy
+        value = PRV_PACKET_HEADER_SIZE + IOWA_CAPTURE_SNAPLEN;
+        memcpy(bufferP + 16, &value, sizeof(uint32_t));
+        value = PRV_PCAP_LINKTYPE_RAW;
+        memcpy(bufferP + 20, &value, sizeof(uint32_t));
+
+        *readLengthP = PRV_PCAP_FILE_HEADER_SIZE;
+        captureP->isHeaderPending = false;
+    }
+
+    while (captureP->length > 0)
+    {
+        recordLength = prv_oldestRecordLength(captureP);
+        if (*readLengthP + recordLength > bufferLength)
+        {
+            break;
+        }
+
+        prv_ringRead(captureP, 0, bufferP + *readLengthP, recordLength);
+        prv_removeOldestRecord(captureP, recordLength);
+        *readLengthP += recordLength;
+    }
+
+    if (droppedCountP != NULL)
+    {
+        *droppedCountP = captureP->droppedCount;
+    }
+    captureP->droppedCount = 0;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Exiting with %u bytes read.", *readLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_CAPTURE_SUPPORT
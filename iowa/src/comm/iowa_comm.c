@@ -63,6 +63,11 @@ static comm_channel_t * prv_channelNew(iowa_context_t contextP,
     memset(channelP, 0, sizeof(comm_channel_t));
     channelP->type = type;
     channelP->connP = connP;
+#ifdef IOWA_CAPTURE_SUPPORT
+    // 10.1.0.0 is not a valid host address
+    contextP->commContextP->capture.nextChannelId++;
+    channelP->captureId = contextP->commContextP->capture.nextChannelId;
+#endif
 
     iowa_system_free(contextP->commContextP->channelArray);
     contextP->commContextP->channelArray = newChannelArray;
@@ -113,10 +118,16 @@ void commClose(iowa_context_t contextP)
         iowa_system_connection_close(commContextP->channelArray[i]->connP, contextP->userData);
         CRIT_SECTION_ENTER(contextP);
 
+#ifdef IOWA_COMM_SERVER_MODE
+        iowa_system_free(commContextP->channelArray[i]->pendingBuffer);
+#endif
         iowa_system_free(commContextP->channelArray[i]);
     }
 
     iowa_system_free(commContextP->channelArray);
+#ifdef IOWA_CAPTURE_SUPPORT
+    iowa_system_free(commContextP->capture.bufferP);
+#endif
     iowa_system_free(commContextP);
 
     IOWA_LOG_TRACE(IOWA_PART_COMM, "Comm closed.");
@@ -178,6 +189,62 @@ uint8_t commChannelNew(iowa_context_t contextP,
     return IOWA_COAP_NO_ERROR;
 }
 
+uint8_t commChannelPushBack(iowa_context_t contextP,
+                            comm_channel_t *channelP,
+                            uint8_t *buffer,
+                            size_t length)
+{
+    // WARNING: This function is called in a critical section
+    (void)contextP;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "channelP: %p, length: %u.", channelP, length);
+
+    iowa_system_free(channelP->pendingBuffer);
+    channelP->pendingLength = 0;
+
+    channelP->pendingBuffer = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (channelP->pendingBuffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memcpy(channelP->pendingBuffer, buffer, length);
+    channelP->pendingLength = length;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void commChannelMove(iowa_context_t contextP,
+                     comm_channel_t *toChannelP,
+                     comm_channel_t *fromChannelP)
+{
+    // WARNING: This function is called in a critical section
+    void *oldConnP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Moving connection %p from channel %p to channel %p.", fromChannelP->connP, fromChannelP, toChannelP);
+
+    oldConnP = toChannelP->connP;
+
+    toChannelP->connP = fromChannelP->connP;
+    iowa_system_free(toChannelP->pendingBuffer);
+    toChannelP->pendingBuffer = fromChannelP->pendingBuffer;
+    toChannelP->pendingLength = fromChannelP->pendingLength;
+
+    fromChannelP->connP = NULL;
+    fromChannelP->pendingBuffer = NULL;
+    fromChannelP->pendingLength = 0;
+    commChannelDelete(contextP, fromChannelP);
+
+    if (oldConnP != NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        iowa_system_connection_close(oldConnP, contextP->userData);
+        CRIT_SECTION_ENTER(contextP);
+    }
+}
+
 #endif // IOWA_COMM_SERVER_MODE
 
 #ifdef IOWA_COMM_CLIENT_MODE
@@ -296,6 +363,9 @@ void commChannelDelete(iowa_context_t contextP,
         CRIT_SECTION_ENTER(contextP);
     }
 
+#ifdef IOWA_COMM_SERVER_MODE
+    iowa_system_free(channelP->pendingBuffer);
+#endif
     iowa_system_free(channelP);
 
     IOWA_LOG_TRACE(IOWA_PART_COMM, "Exiting.");
@@ -353,6 +423,26 @@ int commRecv(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Receiving %u bytes on channelP: %p.", length, channelP);
 
+#ifdef IOWA_COMM_SERVER_MODE
+    if (channelP->pendingBuffer != NULL)
+    {
+        // Return the data pushed back on the channel. Like a datagram, the exceeding part is discarded.
+        if (length > channelP->pendingLength)
+        {
+            length = channelP->pendingLength;
+        }
+        memcpy(buffer, channelP->pendingBuffer, length);
+
+        iowa_system_free(channelP->pendingBuffer);
+        channelP->pendingBuffer = NULL;
+        channelP->pendingLength = 0;
+
+        IOWA_LOG_BUFFER_INFO(IOWA_PART_COMM, "Received", buffer, length);
+
+        return (int)length;
+    }
+#endif
+
     CRIT_SECTION_LEAVE(contextP);
     result = iowa_system_connection_recv(channelP->connP, buffer, length, contextP->userData);
     CRIT_SECTION_ENTER(contextP);
@@ -62,6 +62,19 @@ typedef enum
 ((M) == COMM_EVENT_DATA_AVAILABLE ? "COMM_EVENT_DATA_AVAILABLE" : \
 "Unknown"))))
 
+#ifdef IOWA_CAPTURE_SUPPORT
+typedef struct
+{
+    uint8_t  *bufferP;         // ring buffer of pcap records, nil when the capture is stopped
+    size_t    size;
+    size_t    start;           // offset of the oldest record
+    size_t    length;          // number of bytes stored
+    uint32_t  droppedCount;    // records dropped since the last iowa_capture_read()
+    bool      isHeaderPending; // the pcap file header was not read yet
+    uint16_t  nextChannelId;
+} comm_capture_t;
+#endif
+
 typedef struct _comm_context_t * comm_context_t;
 
 typedef struct _comm_channel_t comm_channel_t;
@@ -86,6 +99,13 @@ struct _comm_channel_t
     void                   *connP;
     comm_event_callback_t   eventCallback;
     void                   *userData;
+#ifdef IOWA_COMM_SERVER_MODE
+    uint8_t                *pendingBuffer; // data already read from connP, returned by the next commRecv()
+    size_t                  pendingLength;
+#endif
+#ifdef IOWA_CAPTURE_SUPPORT
+    uint16_t                captureId;     // gives the address of the peer in the capture
+#endif
 };
 
 struct _comm_context_t
@@ -94,6 +114,9 @@ struct _comm_context_t
     comm_channel_t **channelArray;    // Dynamically-allocated array of created channels
     comm_new_channel_callback_t newChannelCallback;
     void *callbackUserData;
+#ifdef IOWA_CAPTURE_SUPPORT
+    comm_capture_t capture;
+#endif
 };
 
 /************************************************
@@ -137,6 +160,28 @@ uint8_t commChannelNew(iowa_context_t contextP,
                        comm_event_callback_t eventCallback,
                        void *callbackUserData,
                        comm_channel_t **channelP);
+
+// Make the data already read on a channel available to the next commRecv() on this channel.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - contextP: as returned by commInit().
+// - channelP: a Comm channel.
+// - buffer, length: the data. They are copied.
+uint8_t commChannelPushBack(iowa_context_t contextP,
+                            comm_channel_t *channelP,
+                            uint8_t *buffer,
+                            size_t length);
+
+// Move the connection of a channel to another channel, for instance when the peer changed its address.
+// The previous connection of the destination channel is closed and the source channel is deleted.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by commInit().
+// - toChannelP: the channel receiving the connection.
+// - fromChannelP: the channel providing the connection.
+void commChannelMove(iowa_context_t contextP,
+                     comm_channel_t *toChannelP,
+                     comm_channel_t *fromChannelP);
 #endif // IOWA_COMM_SERVER_MODE
 
 #ifdef IOWA_COMM_CLIENT_MODE
@@ -203,6 +248,23 @@ int commRecv(iowa_context_t contextP,
 // - contextP: as returned by iowa_init().
 uint8_t commSelect(iowa_context_t contextP);
 
+#ifdef IOWA_CAPTURE_SUPPORT
+// Implemented in iowa_capture.c
+
+// Add a datagram to the capture, if it is running.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - channelP: the Comm channel on which the datagram is exchanged.
+// - isSent: true if the datagram is sent to the peer, false if it was received from it.
+// - buffer, length: the plaintext datagram.
+void commCaptureRecord(iowa_context_t contextP,
+                       comm_channel_t *channelP,
+                       bool isSent,
+                       const uint8_t *buffer,
+                       size_t length);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -58,6 +58,18 @@ iowa_context_t iowa_init(void *userData)
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_SECURITY_LAYER: IOWA_SECURITY_LAYER_NONE");
 #endif
 
+#ifdef IOWA_METRICS_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_METRICS_SUPPORT");
+#endif
+
+#ifdef IOWA_TRACE_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_TRACE_SUPPORT");
+#endif
+
+#ifdef IOWA_CAPTURE_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_CAPTURE_SUPPORT");
+#endif
+
 #ifdef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK");
 #endif
@@ -238,6 +250,9 @@ void iowa_close(iowa_context_t contextP)
     objectDeviceClose(contextP);
     objectSecurityClose(contextP);
     objectServerClose(contextP);
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    objectOscoreClose(contextP);
+#endif
 #endif // LWM2M_CLIENT_MODE
 
 #if defined(LWM2M_CLIENT_MODE) || defined(LWM2M_SERVER_MODE) || defined(LWM2M_BOOTSTRAP_SERVER_MODE)
@@ -259,6 +274,17 @@ void iowa_close(iowa_context_t contextP)
 
     coreTimerClose(contextP);
 
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+    IOWA_UTILS_LIST_FREE(contextP->backupCallbackList, iowa_system_free);
+#endif
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+    if (contextP->mapping.bufferP != NULL)
+    {
+        // The LwM2M Servers are already freed: nothing points to the mapped context anymore
+        iowa_system_unmap_context(contextP->mapping.bufferP, contextP->mapping.length, contextP->userData);
+    }
+#endif
+
     CRIT_SECTION_LEAVE(contextP);
 
     iowa_system_free(contextP);
@@ -294,11 +320,16 @@ iowa_status_t iowa_step(iowa_context_t contextP,
     do
     {
         int32_t currentTime;
+#ifdef IOWA_METRICS_SUPPORT
+        uint64_t stepStartTime;
+#endif
 
         CRIT_SECTION_ENTER(contextP);
         if (timeout < 0)
         {
+#ifndef IOWA_THREAD_SUPPORT
             IOWA_LOG_WARNING(IOWA_PART_BASE, "WARNING: IOWA_THREAD_SUPPORT is not defined and an \"infinite\" timeout is set.");
+#endif
             contextP->timeout = INT32_MAX;
         }
         else
@@ -330,6 +361,18 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
 #endif // LWM2M_CLIENT_MODE
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+        if ((contextP->action & ACTION_SAVE_CONTEXT) == ACTION_SAVE_CONTEXT)
+        {
+            // Fold the context journal into a new snapshot
+            contextP->action &= (uint16_t)~ACTION_SAVE_CONTEXT;
+            if (core_saveContext(contextP, true) != IOWA_COAP_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_BASE, "Failed to compact the context journal.");
+            }
+        }
+#endif
+
         CRIT_SECTION_LEAVE(contextP);
 
         currentTime = iowa_system_gettime();
@@ -343,6 +386,9 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
         CRIT_SECTION_ENTER(contextP);
 
+#ifdef IOWA_METRICS_SUPPORT
+        stepStartTime = iowa_system_gettime_us();
+#endif
         contextP->currentTime = currentTime;
 
         status = securityStep(contextP);
@@ -373,6 +419,9 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
         coreTimerStep(contextP);
 
+        // The waiting time in commSelect() is not part of the step duration
+        CORE_METRICS_RECORD_DURATION(contextP, stepDuration, stepStartTime);
+
         status = commSelect(contextP);
         CRIT_SECTION_LEAVE(contextP);
 
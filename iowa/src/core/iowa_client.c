@@ -105,6 +105,14 @@ static iowa_status_t prv_checkCoAPUri(const char *uri,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "uri: \"%s\".", uri);
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    // OSCORE does not secure the transport
+    if (securityMode == IOWA_SEC_OSCORE)
+    {
+        securityMode = IOWA_SEC_NONE;
+    }
+#endif
+
     result = iowa_coap_uri_parse(uri, &type, NULL, NULL, NULL, NULL, &isSecured);
     if (result == IOWA_COAP_NO_ERROR)
     {
@@ -174,6 +182,9 @@ static iowa_status_t prv_checkSecurityModeFromParameters(iowa_security_mode_t se
 #endif
 #ifdef IOWA_SECURITY_RAW_PUBLIC_KEY_SUPPORT
     case IOWA_SEC_RAW_PUBLIC_KEY:
+#endif
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    case IOWA_SEC_OSCORE:
 #endif
         return IOWA_COAP_NO_ERROR;
 
@@ -317,6 +328,15 @@ iowa_status_t clientAddServer(iowa_context_t contextP,
                 restart = true;
             }
         }
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+        if ((serverP->securityMode & IOWA_SEC_OSCORE) == IOWA_SEC_OSCORE
+            && (nodeP->securityMode & IOWA_SEC_OSCORE) == IOWA_SEC_OSCORE
+            && serverP->oscObjInstId == nodeP->oscObjInstId)
+        {
+            serverP->oscObjInstId = (uint16_t)(serverP->oscObjInstId + 1);
+            restart = true;
+        }
+#endif
 
         if (restart == true)
         {
@@ -345,6 +365,18 @@ iowa_status_t clientAddServer(iowa_context_t contextP,
         }
     }
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    if ((serverP->securityMode & IOWA_SEC_OSCORE) == IOWA_SEC_OSCORE)
+    {
+        result = objectOscoreCreate(contextP, serverP->oscObjInstId);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to add the object OSCORE.");
+            return result;
+        }
+    }
+#endif
+
     return result;
 }
 
@@ -363,6 +395,18 @@ iowa_status_t clientRemoveServer(iowa_context_t contextP,
         return result;
     }
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    if ((serverP->securityMode & IOWA_SEC_OSCORE) == IOWA_SEC_OSCORE)
+    {
+        result = objectOscoreRemove(contextP, serverP->oscObjInstId);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to remove the object OSCORE.");
+            return result;
+        }
+    }
+#endif
+
 
     {
         result = objectServerRemove(contextP, serverP->srvObjInstId);
@@ -561,6 +605,15 @@ iowa_status_t iowa_client_configure(iowa_context_t contextP,
         goto exit_on_error;
     }
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    result = objectOscoreInit(contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to initialize the OSCORE Object.");
+        goto exit_on_error;
+    }
+#endif
+
 #ifdef LWM2M_ALTPATH_SUPPORT
     result = lwm2m_configure(contextP, identity, msisdn, altPath);
 #else
@@ -583,6 +636,9 @@ exit_on_error:
         objectDeviceClose(contextP);
         objectSecurityClose(contextP);
         objectServerClose(contextP);
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+        objectOscoreClose(contextP);
+#endif
     }
 
     CRIT_SECTION_LEAVE(contextP);
@@ -861,6 +917,9 @@ iowa_status_t iowa_client_add_custom_object(iowa_context_t contextP,
     case IOWA_LWM2M_SECURITY_OBJECT_ID:
     case IOWA_LWM2M_SERVER_OBJECT_ID:
     case IOWA_LWM2M_DEVICE_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
         IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object ID %u is reserved.", objectID);
         return IOWA_COAP_403_FORBIDDEN;
     case IOWA_LWM2M_ID_ALL:
@@ -998,6 +1057,9 @@ iowa_status_t iowa_client_remove_custom_object(iowa_context_t contextP,
     case IOWA_LWM2M_SECURITY_OBJECT_ID:
     case IOWA_LWM2M_SERVER_OBJECT_ID:
     case IOWA_LWM2M_DEVICE_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
         IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object ID %u is reserved.", objectID);
         return IOWA_COAP_403_FORBIDDEN;
 
@@ -1033,6 +1095,9 @@ iowa_status_t iowa_client_object_resource_changed(iowa_context_t contextP,
     case IOWA_LWM2M_SECURITY_OBJECT_ID:
     case IOWA_LWM2M_SERVER_OBJECT_ID:
     case IOWA_LWM2M_DEVICE_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
         IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object ID %u is reserved.", objectID);
         return IOWA_COAP_403_FORBIDDEN;
 
@@ -1067,6 +1132,9 @@ iowa_status_t iowa_client_object_instance_changed(iowa_context_t contextP,
     case IOWA_LWM2M_SECURITY_OBJECT_ID:
     case IOWA_LWM2M_SERVER_OBJECT_ID:
     case IOWA_LWM2M_DEVICE_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
         IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object ID %u is reserved.", objectID);
         return IOWA_COAP_403_FORBIDDEN;
 
@@ -96,6 +96,8 @@
 #define PRV_OBSERVE_TOKEN_KEY                   553
 #define PRV_OBSERVE_LAST_TIME_KEY               554
 #define PRV_OBSERVE_COUNTER_KEY                 555
+#define PRV_OBSERVE_UPDATE_KEY                  556 // only in the journal
+#define PRV_OBSERVE_CANCEL_KEY                  557 // only in the journal
 
 #define PRV_ACL_KEY                             580
 #define PRV_ACL_ACL_INSTANCE_ID_KEY             581
@@ -106,6 +108,8 @@
 #define PRV_ACL_FLAGS_KEY                       586
 #define PRV_ACL_SERVER_ID_KEY                   587
 
+#define PRV_SECURITY_RESUMPTION_KEY             600
+
 #define CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, key, data, dataLength)   \
 {                                                                             \
     optionP = iowa_coap_option_new((key));                                    \
@@ -131,3 +135,1870 @@
     iowa_coap_message_add_option((messageP), (optionP));                      \
 }
 
+
+// Journal records are separated by the CoAP payload marker, which option_parse() stops on
+#define CONTEXT_JOURNAL_RECORD_MARKER 0xFF
+
+// Number of nested options parsed without allocation. Larger records are parsed in allocated options.
+#define PRV_RECORD_OPTION_COUNT 16
+
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static bool prv_isIntegerKey(const iowa_coap_option_t *optionP)
+{
+    switch (optionP->number)
+    {
+    case PRV_SERVER_SHORT_ID_KEY:
+    case PRV_SERVER_SEC_INST_ID_KEY:
+    case PRV_SERVER_SRV_INST_ID_KEY:
+    case PRV_SERVER_LIFETIME_KEY:
+    case PRV_SERVER_BINDING_KEY:
+    case PRV_SERVER_DEFAULT_PMIN_KEY:
+    case PRV_SERVER_DEFAULT_PMAX_KEY:
+    case PRV_SERVER_NOTIF_STORING_KEY:
+    case PRV_SERVER_DISABLE_TIMEOUT_KEY:
+    case PRV_SERVER_SECURITY_MODE_KEY:
+    case PRV_SERVER_LWM2M_VERSION_KEY:
+    case PRV_RUNTIME_STATUS_KEY:
+    case PRV_ATTRIBUTES_MIN_PERIOD_KEY:
+    case PRV_ATTRIBUTES_MAX_PERIOD_KEY:
+    case PRV_OBSERVE_FORMAT_KEY:
+    case PRV_OBSERVE_LAST_TIME_KEY:
+    case PRV_OBSERVE_COUNTER_KEY:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static size_t prv_getSerializedLength(iowa_coap_option_t *optionList)
+{
+    size_t length;
+
+    length = 0;
+    while (optionList != NULL)
+    {
+        length += option_getSerializedLength(optionList, prv_isIntegerKey);
+        optionList = optionList->next;
+    }
+
+    return length;
+}
+
+#ifdef LWM2M_CLIENT_MODE
+// Serialize the options of nestedP as the value of a new option of messageP.
+// The serialized buffer is freed with messageP.
+static iowa_status_t prv_addNestedOption(iowa_coap_message_t *messageP,
+                                         uint16_t key,
+                                         iowa_coap_message_t *nestedP)
+{
+    iowa_status_t result;
+    iowa_linked_buffer_t *bufferP;
+    iowa_coap_option_t *optionP;
+
+    bufferP = (iowa_linked_buffer_t *)iowa_system_malloc(sizeof(iowa_linked_buffer_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_linked_buffer_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(bufferP, 0, sizeof(iowa_linked_buffer_t));
+    messageP->userBufferList = (iowa_linked_buffer_t *)IOWA_UTILS_LIST_ADD(messageP->userBufferList, bufferP);
+
+    bufferP->data = (uint8_t *)iowa_system_malloc(prv_getSerializedLength(nestedP->optionList));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP->data == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(prv_getSerializedLength(nestedP->optionList));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    bufferP->length = option_serialize(nestedP->optionList, bufferP->data, prv_isIntegerKey);
+    if (bufferP->length > UINT16_MAX)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "Record %u is too large: %u bytes.", key, bufferP->length);
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, key, bufferP->data, bufferP->length);
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_on_error:
+    return result;
+}
+
+// Parse the value of a record made of nested options.
+// The options are parsed in storage when they fit, otherwise they are allocated. In both cases,
+// their values point to the record and *optionListP must be freed only if it differs from storage.
+static iowa_status_t prv_parseNestedOption(iowa_coap_option_t *recordP,
+                                           iowa_coap_option_t storage[PRV_RECORD_OPTION_COUNT],
+                                           iowa_coap_option_t **optionListP)
+{
+    iowa_status_t result;
+    size_t index;
+    size_t count;
+
+    *optionListP = NULL;
+
+    index = 0;
+    count = 0;
+    while (index < recordP->length
+           && count < PRV_RECORD_OPTION_COUNT)
+    {
+        if (recordP->value.asBuffer[index] == CONTEXT_JOURNAL_RECORD_MARKER)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Record %u is malformed.", recordP->number);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+
+        storage[count].next = NULL;
+        storage[count].number = (count == 0) ? 0 : storage[count - 1].number;
+        result = option_parseNext(recordP->value.asBuffer, recordP->length, &index, storage + count, prv_isIntegerKey);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+        if (count > 0)
+        {
+            storage[count - 1].next = storage + count;
+        }
+        count++;
+    }
+
+    if (index == recordP->length)
+    {
+        if (count > 0)
+        {
+            *optionListP = storage;
+        }
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    result = option_parse(recordP->value.asBuffer, recordP->length, optionListP, &index, prv_isIntegerKey);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+    if (index != recordP->length)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Record %u is malformed.", recordP->number);
+        iowa_coap_option_free(*optionListP);
+        *optionListP = NULL;
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static void prv_uriToBuffer(iowa_lwm2m_uri_t *uriP,
+                            uint8_t buffer[4 * PRV_LWM2M_URI_SIZE])
+{
+    utilsCopyValue(buffer, &uriP->objectId, PRV_LWM2M_URI_SIZE);
+    utilsCopyValue(buffer + PRV_LWM2M_URI_SIZE, &uriP->instanceId, PRV_LWM2M_URI_SIZE);
+    utilsCopyValue(buffer + 2 * PRV_LWM2M_URI_SIZE, &uriP->resourceId, PRV_LWM2M_URI_SIZE);
+    utilsCopyValue(buffer + 3 * PRV_LWM2M_URI_SIZE, &uriP->resInstanceId, PRV_LWM2M_URI_SIZE);
+}
+
+static bool prv_uriFromOption(iowa_coap_option_t *optionP,
+                              iowa_lwm2m_uri_t *uriP)
+{
+    if (optionP->length != 4 * PRV_LWM2M_URI_SIZE)
+    {
+        return false;
+    }
+
+    utilsCopyValue(&uriP->objectId, optionP->value.asBuffer, PRV_LWM2M_URI_SIZE);
+    utilsCopyValue(&uriP->instanceId, optionP->value.asBuffer + PRV_LWM2M_URI_SIZE, PRV_LWM2M_URI_SIZE);
+    utilsCopyValue(&uriP->resourceId, optionP->value.asBuffer + 2 * PRV_LWM2M_URI_SIZE, PRV_LWM2M_URI_SIZE);
+    utilsCopyValue(&uriP->resInstanceId, optionP->value.asBuffer + 3 * PRV_LWM2M_URI_SIZE, PRV_LWM2M_URI_SIZE);
+
+    return true;
+}
+
+static bool prv_doubleFromOption(iowa_coap_option_t *optionP,
+                                 double *valueP)
+{
+    if (optionP->length != PRV_ATTRIBUTES_NUMERIC_SIZE)
+    {
+        return false;
+    }
+
+    utilsCopyValue(valueP, optionP->value.asBuffer, PRV_ATTRIBUTES_NUMERIC_SIZE);
+
+    return true;
+}
+
+static lwm2m_server_t * prv_findServer(iowa_context_t contextP,
+                                       iowa_coap_option_t *optionList)
+{
+    while (optionList != NULL)
+    {
+        if (optionList->number == PRV_SERVER_SHORT_ID_KEY)
+        {
+            uint16_t shortId;
+
+            shortId = (uint16_t)optionList->value.asInteger;
+            return (lwm2m_server_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->serverList, listFindCallbackBy16bitsId, &shortId);
+        }
+        optionList = optionList->next;
+    }
+
+    return NULL;
+}
+
+static lwm2m_observed_t * prv_findObservation(lwm2m_server_t *serverP,
+                                              iowa_coap_option_t *optionList)
+{
+    while (optionList != NULL)
+    {
+        if (optionList->number == PRV_OBSERVE_TOKEN_KEY)
+        {
+            lwm2m_observed_t *observedP;
+
+            for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+            {
+                if (observedP->tokenLen == optionList->length
+                    && memcmp(observedP->token, optionList->value.asBuffer, optionList->length) == 0)
+                {
+                    return observedP;
+                }
+            }
+            return NULL;
+        }
+        optionList = optionList->next;
+    }
+
+    return NULL;
+}
+
+/**********************
+** Records serialization
+**********************/
+
+static iowa_status_t prv_addServerRecord(iowa_coap_message_t *messageP,
+                                         lwm2m_server_t *serverP)
+{
+    iowa_status_t result;
+    iowa_coap_message_t *nestedP;
+    iowa_coap_option_t *optionP;
+
+    nestedP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (nestedP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SHORT_ID_KEY, serverP->shortId);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SEC_INST_ID_KEY, serverP->secObjInstId);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SRV_INST_ID_KEY, serverP->srvObjInstId);
+    // The terminating zero is stored to let the URI point to a mapped context
+    CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_SERVER_URI_KEY, serverP->uri, strlen(serverP->uri) + 1);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_LIFETIME_KEY, serverP->lifetime);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_BINDING_KEY, serverP->binding);
+#ifdef IOWA_SERVER_SUPPORT_RSC_DEFAULT_PERIODS
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_DEFAULT_PMIN_KEY, serverP->defaultPmin);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_DEFAULT_PMAX_KEY, serverP->defaultPmax);
+#endif
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_NOTIF_STORING_KEY, serverP->notifStoring);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_DISABLE_TIMEOUT_KEY, serverP->disableTimeout);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SECURITY_MODE_KEY, serverP->securityMode);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_LWM2M_VERSION_KEY, serverP->lwm2mVersion);
+
+    result = prv_addNestedOption(messageP, PRV_SERVER_KEY, nestedP);
+
+exit_on_error:
+    iowa_coap_message_free(nestedP);
+    return result;
+}
+
+static iowa_status_t prv_addRuntimeRecord(iowa_coap_message_t *messageP,
+                                          lwm2m_server_t *serverP)
+{
+    iowa_status_t result;
+    iowa_coap_message_t *nestedP;
+    iowa_coap_option_t *optionP;
+
+    nestedP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (nestedP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SHORT_ID_KEY, serverP->shortId);
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_RUNTIME_STATUS_KEY, serverP->runtime.status);
+    if (serverP->runtime.location != NULL)
+    {
+        CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_RUNTIME_LOCATION_KEY, serverP->runtime.location, strlen(serverP->runtime.location));
+    }
+
+    result = prv_addNestedOption(messageP, PRV_RUNTIME_KEY, nestedP);
+
+exit_on_error:
+    iowa_coap_message_free(nestedP);
+    return result;
+}
+
+// The record holds the data allowing to resume the secure sessions, as serialized by the security layer.
+// An empty record means no data are stored.
+// The serialized buffer is freed with messageP.
+static iowa_status_t prv_addResumptionRecord(iowa_context_t contextP,
+                                             iowa_coap_message_t *messageP)
+{
+    iowa_status_t result;
+    iowa_linked_buffer_t *bufferP;
+    iowa_coap_option_t *optionP;
+    size_t length;
+
+    length = securityResumptionBackup(contextP, NULL, 0);
+    if (length > UINT16_MAX)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Session resumption data are too large to be saved: %u bytes.", length);
+        length = 0;
+    }
+    if (length == 0)
+    {
+        CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, PRV_SECURITY_RESUMPTION_KEY, NULL, 0);
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    bufferP = (iowa_linked_buffer_t *)iowa_system_malloc(sizeof(iowa_linked_buffer_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_linked_buffer_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(bufferP, 0, sizeof(iowa_linked_buffer_t));
+    messageP->userBufferList = (iowa_linked_buffer_t *)IOWA_UTILS_LIST_ADD(messageP->userBufferList, bufferP);
+
+    bufferP->data = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP->data == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    bufferP->length = securityResumptionBackup(contextP, bufferP->data, length);
+    if (bufferP->length != length)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, PRV_SECURITY_RESUMPTION_KEY, bufferP->data, bufferP->length);
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_on_error:
+    return result;
+}
+
+// When attributesP is nil, the record only contains the URI and means the attributes were removed.
+static iowa_status_t prv_addAttributesRecord(iowa_coap_message_t *messageP,
+                                             lwm2m_server_t *serverP,
+                                             iowa_lwm2m_uri_t *uriP,
+                                             attributes_t *attributesP)
+{
+    iowa_status_t result;
+    iowa_coap_message_t *nestedP;
+    iowa_coap_option_t *optionP;
+    uint8_t uriBuffer[4 * PRV_LWM2M_URI_SIZE];
+    uint8_t greaterBuffer[PRV_ATTRIBUTES_NUMERIC_SIZE];
+    uint8_t lessBuffer[PRV_ATTRIBUTES_NUMERIC_SIZE];
+    uint8_t stepBuffer[PRV_ATTRIBUTES_NUMERIC_SIZE];
+
+    nestedP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (nestedP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SHORT_ID_KEY, serverP->shortId);
+    prv_uriToBuffer(uriP, uriBuffer);
+    CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_LWM2M_URI_KEY, uriBuffer, sizeof(uriBuffer));
+
+    if (attributesP != NULL)
+    {
+        if ((attributesP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
+        {
+            CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_ATTRIBUTES_MIN_PERIOD_KEY, attributesP->minPeriod);
+        }
+        if ((attributesP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+        {
+            CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_ATTRIBUTES_MAX_PERIOD_KEY, attributesP->maxPeriod);
+        }
+        if ((attributesP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0)
+        {
+            utilsCopyValue(greaterBuffer, &attributesP->greaterThan, PRV_ATTRIBUTES_NUMERIC_SIZE);
+            CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_ATTRIBUTES_GREATER_KEY, greaterBuffer, PRV_ATTRIBUTES_NUMERIC_SIZE);
+        }
+        if ((attributesP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0)
+        {
+            utilsCopyValue(lessBuffer, &attributesP->lessThan, PRV_ATTRIBUTES_NUMERIC_SIZE);
+            CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_ATTRIBUTES_LESS_KEY, lessBuffer, PRV_ATTRIBUTES_NUMERIC_SIZE);
+        }
+        if ((attributesP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
+        {
+            utilsCopyValue(stepBuffer, &attributesP->step, PRV_ATTRIBUTES_NUMERIC_SIZE);
+            CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_ATTRIBUTES_STEP_KEY, stepBuffer, PRV_ATTRIBUTES_NUMERIC_SIZE);
+        }
+    }
+
+    result = prv_addNestedOption(messageP, PRV_ATTRIBUTES_KEY, nestedP);
+
+exit_on_error:
+    iowa_coap_message_free(nestedP);
+    return result;
+}
+
+// The record key is PRV_OBSERVE_KEY for a full observation, PRV_OBSERVE_UPDATE_KEY for its counter,
+// or PRV_OBSERVE_CANCEL_KEY for its cancellation.
+static iowa_status_t prv_addObservationRecord(iowa_context_t contextP,
+                                              iowa_coap_message_t *messageP,
+                                              uint16_t key,
+                                              lwm2m_server_t *serverP,
+                                              lwm2m_observed_t *observedP)
+{
+    iowa_status_t result;
+    iowa_coap_message_t *nestedP;
+    iowa_coap_option_t *optionP;
+    uint8_t *uriBuffer;
+    size_t ind;
+
+    uriBuffer = NULL;
+
+    nestedP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (nestedP == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_SERVER_SHORT_ID_KEY, serverP->shortId);
+    CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_OBSERVE_TOKEN_KEY, observedP->token, observedP->tokenLen);
+
+    if (key != PRV_OBSERVE_CANCEL_KEY)
+    {
+        CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_OBSERVE_LAST_TIME_KEY, (contextP->currentTime - observedP->lastTime));
+        CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_OBSERVE_COUNTER_KEY, observedP->counter);
+    }
+
+    if (key == PRV_OBSERVE_KEY)
+    {
+        uriBuffer = (uint8_t *)iowa_system_malloc(observedP->uriCount * 4 * PRV_LWM2M_URI_SIZE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (uriBuffer == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(observedP->uriCount * 4 * PRV_LWM2M_URI_SIZE);
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto exit_on_error;
+        }
+#endif
+        for (ind = 0; ind < observedP->uriCount; ind++)
+        {
+            prv_uriToBuffer(&observedP->uriInfoP[ind].uri, uriBuffer + ind * 4 * PRV_LWM2M_URI_SIZE);
+            CONTEXT_ADD_BUFFER_OPTION(nestedP, optionP, PRV_OBSERVE_URI_KEY, uriBuffer + ind * 4 * PRV_LWM2M_URI_SIZE, 4 * PRV_LWM2M_URI_SIZE);
+        }
+        CONTEXT_ADD_INTEGER_OPTION(nestedP, optionP, PRV_OBSERVE_FORMAT_KEY, observedP->format);
+    }
+
+    result = prv_addNestedOption(messageP, key, nestedP);
+
+exit_on_error:
+    iowa_coap_message_free(nestedP);
+    iowa_system_free(uriBuffer);
+    return result;
+}
+
+/**********************
+** Records loading
+**********************/
+
+static iowa_status_t prv_loadServerRecord(iowa_context_t contextP,
+                                          iowa_coap_option_t *optionList)
+{
+    iowa_status_t result;
+    lwm2m_server_t *serverP;
+    iowa_coap_option_t *optionP;
+
+    serverP = (lwm2m_server_t *)iowa_system_malloc(sizeof(lwm2m_server_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (serverP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(lwm2m_server_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(serverP, 0, sizeof(lwm2m_server_t));
+
+    serverP->lifetime = LWM2M_DEFAULT_LIFETIME;
+    serverP->coapAckTimeout = PRV_SERVER_COAP_SETTING_UNSET;
+    serverP->coapMaxRetransmit = PRV_SERVER_COAP_SETTING_UNSET;
+    serverP->notifStoring = IOWA_SERVER_RSC_STORING_DEFAULT_VALUE;
+#ifdef IOWA_SERVER_SUPPORT_RSC_DISABLE_TIMEOUT
+    serverP->disableTimeout = IOWA_SERVER_RSC_DISABLE_TIMEOUT_DEFAULT_VALUE;
+#endif
+#ifdef IOWA_SERVER_SUPPORT_RSC_DEFAULT_PERIODS
+    serverP->defaultPmax = PMAX_UNSET_VALUE;
+#endif
+    serverP->lwm2mVersion = IOWA_LWM2M_VERSION_1_0;
+
+    for (optionP = optionList; optionP != NULL; optionP = optionP->next)
+    {
+        switch (optionP->number)
+        {
+        case PRV_SERVER_SHORT_ID_KEY:
+            serverP->shortId = (uint16_t)optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_SEC_INST_ID_KEY:
+            serverP->secObjInstId = (uint16_t)optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_SRV_INST_ID_KEY:
+            serverP->srvObjInstId = (uint16_t)optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_URI_KEY:
+            if (serverP->uri == NULL
+                && optionP->length > 0)
+            {
+                size_t uriLength;
+
+                // Contexts stored by older versions do not include the terminating zero
+                uriLength = optionP->length;
+                if (optionP->value.asBuffer[uriLength - 1] == 0)
+                {
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+                    if (coreContextIsMapped(contextP, optionP->value.asBuffer) == true)
+                    {
+                        // The URI is never modified: it can point to the read-only mapped context
+                        serverP->uri = (char *)optionP->value.asBuffer;
+                        break;
+                    }
+#endif
+                    uriLength--;
+                }
+
+                serverP->uri = (char *)iowa_system_malloc(uriLength + 1);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+                if (serverP->uri == NULL)
+                {
+                    IOWA_LOG_ERROR_MALLOC(uriLength + 1);
+                    result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                    goto exit_on_error;
+                }
+#endif
+                memcpy(serverP->uri, optionP->value.asBuffer, uriLength);
+                serverP->uri[uriLength] = 0;
+            }
+            break;
+
+        case PRV_SERVER_LIFETIME_KEY:
+            serverP->lifetime = (int32_t)optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_BINDING_KEY:
+            serverP->binding = (iowa_lwm2m_binding_t)optionP->value.asInteger;
+            break;
+
+#ifdef IOWA_SERVER_SUPPORT_RSC_DEFAULT_PERIODS
+        case PRV_SERVER_DEFAULT_PMIN_KEY:
+            serverP->defaultPmin = optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_DEFAULT_PMAX_KEY:
+            serverP->defaultPmax = optionP->value.asInteger;
+            break;
+#endif
+
+        case PRV_SERVER_NOTIF_STORING_KEY:
+            serverP->notifStoring = (optionP->value.asInteger != 0);
+            break;
+
+        case PRV_SERVER_DISABLE_TIMEOUT_KEY:
+            serverP->disableTimeout = (int32_t)optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_SECURITY_MODE_KEY:
+            serverP->securityMode = (iowa_security_mode_t)optionP->value.asInteger;
+            break;
+
+        case PRV_SERVER_LWM2M_VERSION_KEY:
+            serverP->lwm2mVersion = (iowa_lwm2m_protocol_version_t)optionP->value.asInteger;
+            break;
+
+        default:
+            IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Ignoring server key %u.", optionP->number);
+            break;
+        }
+    }
+
+    if (serverP->uri == NULL
+        || serverP->shortId == LWM2M_RESERVED_FIRST_ID
+        || IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->serverList, listFindCallbackBy16bitsId, &serverP->shortId) != NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Invalid server record with Short ID %u.", serverP->shortId);
+        result = IOWA_COAP_400_BAD_REQUEST;
+        goto exit_on_error;
+    }
+
+    result = clientAddServer(contextP, serverP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Failed to add the server.");
+        goto exit_on_error;
+    }
+
+    contextP->lwm2mContextP->serverList = (lwm2m_server_t *)IOWA_UTILS_LIST_ADD(contextP->lwm2mContextP->serverList, serverP);
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_on_error:
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+    if (coreContextIsMapped(contextP, serverP->uri) == false)
+#endif
+    {
+        iowa_system_free(serverP->uri);
+    }
+    iowa_system_free(serverP);
+    return result;
+}
+
+static iowa_status_t prv_loadRuntimeRecord(iowa_context_t contextP,
+                                           iowa_coap_option_t *optionList)
+{
+    lwm2m_server_t *serverP;
+    iowa_coap_option_t *optionP;
+    iowa_coap_option_t *locationP;
+    lwm2m_status_t status;
+
+    serverP = prv_findServer(contextP, optionList);
+    if (serverP == NULL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_BASE, "Ignoring runtime record of an unknown server.");
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    status = STATE_DISCONNECTED;
+    locationP = NULL;
+    for (optionP = optionList; optionP != NULL; optionP = optionP->next)
+    {
+        switch (optionP->number)
+        {
+        case PRV_RUNTIME_STATUS_KEY:
+            status = (lwm2m_status_t)optionP->value.asInteger;
+            break;
+
+        case PRV_RUNTIME_LOCATION_KEY:
+            locationP = optionP;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    iowa_system_free(serverP->runtime.location);
+    serverP->runtime.location = NULL;
+
+    if ((status == STATE_REG_REGISTERED
+         || status == STATE_REG_UPDATE_PENDING)
+        && locationP != NULL)
+    {
+        serverP->runtime.location = (char *)iowa_system_malloc(locationP->length + 1);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (serverP->runtime.location == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(locationP->length + 1);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        memcpy(serverP->runtime.location, locationP->value.asBuffer, locationP->length);
+        serverP->runtime.location[locationP->length] = 0;
+
+        // The registration is resumed with a Registration Update
+        serverP->runtime.status = STATE_REG_REGISTERED;
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_UPDATE;
+    }
+    else
+    {
+        // The registration ended: the Server forgot its observations and attributes
+        attributesRemoveFromServer(serverP);
+        observeRemoveFromServer(serverP);
+        serverP->runtime.status = STATE_DISCONNECTED;
+        serverP->runtime.flags &= (uint16_t)~LWM2M_SERVER_FLAG_UPDATE;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static iowa_status_t prv_loadAttributesRecord(iowa_context_t contextP,
+                                              iowa_coap_option_t *optionList)
+{
+    lwm2m_server_t *serverP;
+    iowa_coap_option_t *optionP;
+    attributes_t readAttr;
+    attributes_t *attributesP;
+    bool isUriSet;
+
+    serverP = prv_findServer(contextP, optionList);
+    if (serverP == NULL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_BASE, "Ignoring attributes record of an unknown server.");
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    memset(&readAttr, 0, sizeof(attributes_t));
+    isUriSet = false;
+    for (optionP = optionList; optionP != NULL; optionP = optionP->next)
+    {
+        bool isValid;
+
+        isValid = true;
+        switch (optionP->number)
+        {
+        case PRV_LWM2M_URI_KEY:
+            isValid = prv_uriFromOption(optionP, &readAttr.uri);
+            isUriSet = isValid;
+            break;
+
+        case PRV_ATTRIBUTES_MIN_PERIOD_KEY:
+            readAttr.minPeriod = optionP->value.asInteger;
+            readAttr.flags |= LWM2M_ATTR_FLAG_MIN_PERIOD;
+            break;
+
+        case PRV_ATTRIBUTES_MAX_PERIOD_KEY:
+            readAttr.maxPeriod = optionP->value.asInteger;
+            readAttr.flags |= LWM2M_ATTR_FLAG_MAX_PERIOD;
+            break;
+
+        case PRV_ATTRIBUTES_GREATER_KEY:
+            isValid = prv_doubleFromOption(optionP, &readAttr.greaterThan);
+            readAttr.flags |= LWM2M_ATTR_FLAG_GREATER_THAN;
+            break;
+
+        case PRV_ATTRIBUTES_LESS_KEY:
+            isValid = prv_doubleFromOption(optionP, &readAttr.lessThan);
+            readAttr.flags |= LWM2M_ATTR_FLAG_LESS_THAN;
+            break;
+
+        case PRV_ATTRIBUTES_STEP_KEY:
+            isValid = prv_doubleFromOption(optionP, &readAttr.step);
+            readAttr.flags |= LWM2M_ATTR_FLAG_STEP;
+            break;
+
+        default:
+            break;
+        }
+
+        if (isValid == false)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Invalid attributes key %u.", optionP->number);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+    }
+    if (isUriSet == false)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_BASE, "Attributes record without URI.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    for (attributesP = serverP->runtime.attributesList; attributesP != NULL; attributesP = attributesP->nextP)
+    {
+        if (LWM2M_URI_ARE_EQUAL(&attributesP->uri, &readAttr.uri))
+        {
+            break;
+        }
+    }
+
+    if (readAttr.flags == 0)
+    {
+        if (attributesP != NULL)
+        {
+            serverP->runtime.attributesList = (attributes_t *)IOWA_UTILS_LIST_REMOVE(serverP->runtime.attributesList, attributesP);
+            iowa_system_free(attributesP);
+        }
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if (attributesP == NULL)
+    {
+        attributesP = (attributes_t *)iowa_system_malloc(sizeof(attributes_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (attributesP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(sizeof(attributes_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        memcpy(attributesP, &readAttr, sizeof(attributes_t));
+        serverP->runtime.attributesList = (attributes_t *)IOWA_UTILS_LIST_ADD(serverP->runtime.attributesList, attributesP);
+    }
+    else
+    {
+        readAttr.nextP = attributesP->nextP;
+        memcpy(attributesP, &readAttr, sizeof(attributes_t));
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// In a snapshot, the observations are unique and are not looked up.
+static iowa_status_t prv_loadObservationRecord(iowa_context_t contextP,
+                                               uint16_t key,
+                                               iowa_coap_option_t *optionList,
+                                               bool isSnapshot)
+{
+    lwm2m_server_t *serverP;
+    lwm2m_observed_t *observedP;
+    iowa_coap_option_t *optionP;
+    iowa_coap_option_t *tokenP;
+    size_t uriCount;
+    size_t ind;
+
+    serverP = prv_findServer(contextP, optionList);
+    if (serverP == NULL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_BASE, "Ignoring observation record of an unknown server.");
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if (isSnapshot == true)
+    {
+        observedP = NULL;
+    }
+    else
+    {
+        observedP = prv_findObservation(serverP, optionList);
+    }
+
+    switch (key)
+    {
+    case PRV_OBSERVE_CANCEL_KEY:
+        if (observedP != NULL)
+        {
+            serverP->runtime.observedList = (lwm2m_observed_t *)IOWA_UTILS_LIST_REMOVE(serverP->runtime.observedList, observedP);
+            observe_delete(observedP);
+        }
+        return IOWA_COAP_NO_ERROR;
+
+    case PRV_OBSERVE_UPDATE_KEY:
+        if (observedP == NULL)
+        {
+            IOWA_LOG_INFO(IOWA_PART_BASE, "Ignoring counter record of an unknown observation.");
+            return IOWA_COAP_NO_ERROR;
+        }
+        break;
+
+    default:
+        tokenP = NULL;
+        uriCount = 0;
+        for (optionP = optionList; optionP != NULL; optionP = optionP->next)
+        {
+            if (optionP->number == PRV_OBSERVE_TOKEN_KEY)
+            {
+                tokenP = optionP;
+            }
+            else if (optionP->number == PRV_OBSERVE_URI_KEY)
+            {
+                uriCount++;
+            }
+        }
+        if (tokenP == NULL
+            || tokenP->length == 0
+            || tokenP->length > COAP_MSG_TOKEN_MAX_LEN
+            || uriCount == 0)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_BASE, "Invalid observation record.");
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+
+        if (observedP == NULL)
+        {
+            observedP = (lwm2m_observed_t *)iowa_system_malloc(sizeof(lwm2m_observed_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (observedP == NULL)
+            {
+                IOWA_LOG_ERROR_MALLOC(sizeof(lwm2m_observed_t));
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+#endif
+            memset(observedP, 0, sizeof(lwm2m_observed_t));
+            observedP->tokenLen = (uint8_t)tokenP->length;
+            memcpy(observedP->token, tokenP->value.asBuffer, tokenP->length);
+
+            observedP->next = serverP->runtime.observedList;
+            serverP->runtime.observedList = observedP;
+        }
+        else
+        {
+            for (ind = 0; ind < observedP->uriCount; ind++)
+            {
+                iowa_system_free(observedP->uriInfoP[ind].uriAttrP);
+            }
+            iowa_system_free(observedP->uriInfoP);
+            observedP->uriCount = 0;
+        }
+
+        observedP->uriInfoP = (lwm2m_observed_uri_info_t *)iowa_system_malloc(uriCount * sizeof(lwm2m_observed_uri_info_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (observedP->uriInfoP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(uriCount * sizeof(lwm2m_observed_uri_info_t));
+            serverP->runtime.observedList = (lwm2m_observed_t *)IOWA_UTILS_LIST_REMOVE(serverP->runtime.observedList, observedP);
+            observe_delete(observedP);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        memset(observedP->uriInfoP, 0, uriCount * sizeof(lwm2m_observed_uri_info_t));
+        observedP->uriCount = uriCount;
+        break;
+    }
+
+    ind = 0;
+    for (optionP = optionList; optionP != NULL; optionP = optionP->next)
+    {
+        switch (optionP->number)
+        {
+        case PRV_OBSERVE_URI_KEY:
+            if (key == PRV_OBSERVE_KEY)
+            {
+                if (prv_uriFromOption(optionP, &observedP->uriInfoP[ind].uri) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_BASE, "Invalid observation URI.");
+                    serverP->runtime.observedList = (lwm2m_observed_t *)IOWA_UTILS_LIST_REMOVE(serverP->runtime.observedList, observedP);
+                    observe_delete(observedP);
+                    return IOWA_COAP_400_BAD_REQUEST;
+                }
+                ind++;
+            }
+            break;
+
+        case PRV_OBSERVE_FORMAT_KEY:
+            observedP->format = (iowa_content_format_t)optionP->value.asInteger;
+            break;
+
+        case PRV_OBSERVE_LAST_TIME_KEY:
+            observedP->lastTime = contextP->currentTime - (int32_t)optionP->value.asInteger;
+            break;
+
+        case PRV_OBSERVE_COUNTER_KEY:
+            observedP->counter = optionP->value.asInteger;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Apply a record of the stored context or of its journal.
+static iowa_status_t prv_loadRecord(iowa_context_t contextP,
+                                    iowa_coap_option_t *recordP,
+                                    bool isSnapshot)
+{
+    iowa_status_t result;
+    iowa_coap_option_t storage[PRV_RECORD_OPTION_COUNT];
+    iowa_coap_option_t *optionList;
+
+    switch (recordP->number)
+    {
+    case PRV_SERVER_KEY:
+    case PRV_RUNTIME_KEY:
+    case PRV_ATTRIBUTES_KEY:
+    case PRV_OBSERVE_KEY:
+    case PRV_OBSERVE_UPDATE_KEY:
+    case PRV_OBSERVE_CANCEL_KEY:
+        break;
+
+    case PRV_SECURITY_RESUMPTION_KEY:
+        // Replaces the stored data, this record is not nested
+        return securityResumptionRestore(contextP, recordP->value.asBuffer, recordP->length);
+
+    default:
+        IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Ignoring record %u.", recordP->number);
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    result = prv_parseNestedOption(recordP, storage, &optionList);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    switch (recordP->number)
+    {
+    case PRV_SERVER_KEY:
+        result = prv_loadServerRecord(contextP, optionList);
+        break;
+
+    case PRV_RUNTIME_KEY:
+        result = prv_loadRuntimeRecord(contextP, optionList);
+        break;
+
+    case PRV_ATTRIBUTES_KEY:
+        result = prv_loadAttributesRecord(contextP, optionList);
+        break;
+
+    default:
+        result = prv_loadObservationRecord(contextP, recordP->number, optionList, isSnapshot);
+        break;
+    }
+
+    if (optionList != storage)
+    {
+        iowa_coap_option_free(optionList);
+    }
+
+    return result;
+}
+
+// Rebuild the observation parameters from the loaded attributes.
+static iowa_status_t prv_updateObservations(iowa_context_t contextP)
+{
+    lwm2m_server_t *serverP;
+
+    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    {
+        lwm2m_observed_t *observedP;
+
+        for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+        {
+            iowa_status_t result;
+
+            result = observe_updateObserve(contextP, serverP, observedP);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                return result;
+            }
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif // LWM2M_CLIENT_MODE
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+/**********************
+** Journal
+**********************/
+
+static void prv_journalRequestCompaction(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    contextP->journal.isCompactionPending = true;
+    contextP->action |= ACTION_SAVE_CONTEXT;
+    contextP->timeout = 0;
+}
+
+// Returned value: the message to fill with the record or nil if no record must be appended.
+static iowa_coap_message_t * prv_journalRecordNew(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    if (contextP->journal.isCompactionPending == true)
+    {
+        // The pending snapshot will contain this change
+        prv_journalRequestCompaction(contextP);
+        return NULL;
+    }
+    if (contextP->journal.isActive == false)
+    {
+        return NULL;
+    }
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        prv_journalRequestCompaction(contextP);
+    }
+#endif
+
+    return messageP;
+}
+
+static void prv_journalRecordAppend(iowa_context_t contextP,
+                                    iowa_coap_message_t *messageP,
+                                    iowa_status_t result)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t *bufferP;
+    size_t length;
+
+    bufferP = NULL;
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        bufferP = (uint8_t *)iowa_system_malloc(prv_getSerializedLength(messageP->optionList) + 1);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (bufferP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(prv_getSerializedLength(messageP->optionList) + 1);
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+    }
+
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        length = option_serialize(messageP->optionList, bufferP, prv_isIntegerKey);
+        bufferP[length] = CONTEXT_JOURNAL_RECORD_MARKER;
+        length++;
+
+        if (iowa_system_append_context(bufferP, length, contextP->userData) != length)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_BASE, "Failed to append to the context journal.");
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        else
+        {
+            contextP->journal.recordCount++;
+            if (contextP->journal.recordCount >= IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS)
+            {
+                IOWA_LOG_INFO(IOWA_PART_BASE, "Context journal is full.");
+                prv_journalRequestCompaction(contextP);
+            }
+        }
+    }
+
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        // The change is lost from the journal: save it in a new snapshot
+        prv_journalRequestCompaction(contextP);
+    }
+
+    iowa_system_free(bufferP);
+    iowa_coap_message_free(messageP);
+}
+
+// A truncated last record is ignored: it was not completely appended.
+// isTruncatedP is set to true when bytes were ignored.
+static iowa_status_t prv_loadJournal(iowa_context_t contextP,
+                                     uint8_t *bufferP,
+                                     size_t bufferLength,
+                                     uint16_t *countP,
+                                     bool *isTruncatedP)
+{
+    // WARNING: This function is called in a critical section
+    size_t index;
+
+    *countP = 0;
+    *isTruncatedP = false;
+    index = 0;
+    while (index < bufferLength)
+    {
+        iowa_coap_option_t record;
+        size_t endIndex;
+
+        // Check that the record is complete before applying it
+        memset(&record, 0, sizeof(iowa_coap_option_t));
+        endIndex = index;
+        while (endIndex < bufferLength
+               && bufferP[endIndex] != CONTEXT_JOURNAL_RECORD_MARKER)
+        {
+            if (option_parseNext(bufferP, bufferLength, &endIndex, &record, prv_isIntegerKey) != IOWA_COAP_NO_ERROR)
+            {
+                endIndex = bufferLength;
+            }
+        }
+        if (endIndex >= bufferLength)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Ignoring the %u last bytes of the context journal.", bufferLength - index);
+            *isTruncatedP = true;
+            break;
+        }
+
+        record.number = 0;
+        while (index < endIndex)
+        {
+            iowa_status_t result;
+
+            (void)option_parseNext(bufferP, endIndex, &index, &record, prv_isIntegerKey);
+            result = prv_loadRecord(contextP, &record, false);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_BASE, "Failed to load the journal record %u: %u.%02u.", record.number, (result & 0xFF) >> 5, (result & 0x1F));
+            }
+        }
+
+        index = endIndex + 1;
+        if (*countP < UINT16_MAX)
+        {
+            *countP = (uint16_t)(*countP + 1);
+        }
+    }
+
+    if (*countP == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    return prv_updateObservations(contextP);
+}
+#endif // IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+iowa_status_t core_saveContext(iowa_context_t contextP,
+                               bool isSnapshot)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    iowa_context_callback_t *callbackP;
+    uint8_t *bufferP;
+    size_t length;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Saving the context (snapshot: %s).", isSnapshot == true ? "true" : "false");
+
+    bufferP = NULL;
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_EMPTY, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit_on_error;
+    }
+#endif
+
+    CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, PRV_VERSION_KEY, IOWA_CONTEXT_VERSION, strlen(IOWA_CONTEXT_VERSION));
+
+#ifdef LWM2M_CLIENT_MODE
+    {
+        lwm2m_server_t *serverP;
+
+        for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+        {
+            attributes_t *attributesP;
+            lwm2m_observed_t *observedP;
+
+            result = prv_addServerRecord(messageP, serverP);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                goto exit_on_error;
+            }
+
+            if (isSnapshot == false)
+            {
+                continue;
+            }
+
+            if (serverP->runtime.status == STATE_REG_REGISTERED
+                || serverP->runtime.status == STATE_REG_UPDATE_PENDING)
+            {
+                result = prv_addRuntimeRecord(messageP, serverP);
+                if (result != IOWA_COAP_NO_ERROR)
+                {
+                    goto exit_on_error;
+                }
+            }
+
+            for (attributesP = serverP->runtime.attributesList; attributesP != NULL; attributesP = attributesP->nextP)
+            {
+                result = prv_addAttributesRecord(messageP, serverP, &attributesP->uri, attributesP);
+                if (result != IOWA_COAP_NO_ERROR)
+                {
+                    goto exit_on_error;
+                }
+            }
+
+            for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+            {
+                result = prv_addObservationRecord(contextP, messageP, PRV_OBSERVE_KEY, serverP, observedP);
+                if (result != IOWA_COAP_NO_ERROR)
+                {
+                    goto exit_on_error;
+                }
+            }
+        }
+    }
+
+    if (securityResumptionBackup(contextP, NULL, 0) != 0)
+    {
+        result = prv_addResumptionRecord(contextP, messageP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto exit_on_error;
+        }
+    }
+#else
+    (void)isSnapshot;
+#endif
+
+    for (callbackP = contextP->backupCallbackList; callbackP != NULL; callbackP = callbackP->nextP)
+    {
+        iowa_linked_buffer_t *userBufferP;
+
+        CRIT_SECTION_LEAVE(contextP);
+        length = callbackP->saveCallback(callbackP->callbackId, NULL, 0, callbackP->userData);
+        CRIT_SECTION_ENTER(contextP);
+        if (length == 0)
+        {
+            continue;
+        }
+        if (length > UINT16_MAX)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "Data of the backup callback %u are too large: %u bytes.", callbackP->callbackId, length);
+            result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+            goto exit_on_error;
+        }
+
+        userBufferP = (iowa_linked_buffer_t *)iowa_system_malloc(sizeof(iowa_linked_buffer_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (userBufferP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(sizeof(iowa_linked_buffer_t));
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto exit_on_error;
+        }
+#endif
+        memset(userBufferP, 0, sizeof(iowa_linked_buffer_t));
+        messageP->userBufferList = (iowa_linked_buffer_t *)IOWA_UTILS_LIST_ADD(messageP->userBufferList, userBufferP);
+
+        userBufferP->data = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (userBufferP->data == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(length);
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto exit_on_error;
+        }
+#endif
+        CRIT_SECTION_LEAVE(contextP);
+        userBufferP->length = callbackP->saveCallback(callbackP->callbackId, userBufferP->data, length, callbackP->userData);
+        CRIT_SECTION_ENTER(contextP);
+        if (userBufferP->length == 0
+            || userBufferP->length > length)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "The backup callback %u failed.", callbackP->callbackId);
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto exit_on_error;
+        }
+
+        CONTEXT_ADD_BUFFER_OPTION(messageP, optionP, callbackP->callbackId, userBufferP->data, userBufferP->length);
+    }
+
+    bufferP = (uint8_t *)iowa_system_malloc(prv_getSerializedLength(messageP->optionList));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(prv_getSerializedLength(messageP->optionList));
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit_on_error;
+    }
+#endif
+    length = option_serialize(messageP->optionList, bufferP, prv_isIntegerKey);
+
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+    // The platform may replace the mapped context
+    result = core_unmapContext(contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto exit_on_error;
+    }
+#endif
+
+    if (iowa_system_store_context(bufferP, length, contextP->userData) != length)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Failed to store the context.");
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit_on_error;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Context of %u bytes stored.", length);
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    // The platform discarded the journal of the previous context
+    contextP->journal.isActive = true;
+    contextP->journal.isCompactionPending = false;
+    contextP->journal.recordCount = 0;
+#endif
+
+    result = IOWA_COAP_NO_ERROR;
+
+exit_on_error:
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        // The stored context can not be trusted anymore
+        contextP->journal.isActive = false;
+    }
+#endif
+    iowa_system_free(bufferP);
+    iowa_coap_message_free(messageP);
+
+    return result;
+}
+
+iowa_status_t core_loadContext(iowa_context_t contextP,
+                               uint8_t *bufferP,
+                               size_t bufferLength)
+{
+    // WARNING: This function is called in a critical section
+#ifdef LWM2M_CLIENT_MODE
+    iowa_status_t result;
+#endif
+    iowa_coap_option_t record;
+    iowa_context_callback_t *callbackP;
+    size_t index;
+    size_t userIndex;
+    uint16_t userNumber;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Loading a context of %u bytes.", bufferLength);
+
+#ifdef LWM2M_CLIENT_MODE
+    if (contextP->lwm2mContextP->serverList != NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Servers are already configured.");
+        return IOWA_COAP_412_PRECONDITION_FAILED;
+    }
+#endif
+
+    // The records are parsed one at a time in place: their values point to bufferP
+    memset(&record, 0, sizeof(iowa_coap_option_t));
+    index = 0;
+    if (bufferLength == 0
+        || option_parseNext(bufferP, bufferLength, &index, &record, prv_isIntegerKey) != IOWA_COAP_NO_ERROR
+        || record.number != PRV_VERSION_KEY
+        || record.length != strlen(IOWA_CONTEXT_VERSION)
+        || memcmp(record.value.asBuffer, IOWA_CONTEXT_VERSION, record.length) != 0)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Unsupported context.");
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+    }
+
+    userIndex = bufferLength;
+    userNumber = 0;
+    while (index < bufferLength)
+    {
+        size_t recordIndex;
+        uint16_t previousNumber;
+
+        recordIndex = index;
+        previousNumber = record.number;
+        if (bufferP[index] == CONTEXT_JOURNAL_RECORD_MARKER
+            || option_parseNext(bufferP, bufferLength, &index, &record, prv_isIntegerKey) != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_BASE, "Failed to parse the context.");
+            return IOWA_COAP_406_NOT_ACCEPTABLE;
+        }
+
+        if (record.number >= USER_CALLBACK_MIN_ID)
+        {
+            if (userIndex == bufferLength)
+            {
+                // Remember where the user records start to look for them later
+                userIndex = recordIndex;
+                userNumber = previousNumber;
+            }
+            continue;
+        }
+
+#ifdef LWM2M_CLIENT_MODE
+        result = prv_loadRecord(contextP, &record, true);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "Failed to load the record %u.", record.number);
+            return result;
+        }
+#endif
+    }
+
+#ifdef LWM2M_CLIENT_MODE
+    result = prv_updateObservations(contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+#endif
+
+    for (callbackP = contextP->backupCallbackList; callbackP != NULL; callbackP = callbackP->nextP)
+    {
+        bool isFound;
+
+        // The records are sorted by key
+        isFound = false;
+        index = userIndex;
+        record.number = userNumber;
+        while (index < bufferLength
+               && record.number < callbackP->callbackId)
+        {
+            (void)option_parseNext(bufferP, bufferLength, &index, &record, prv_isIntegerKey);
+            isFound = (record.number == callbackP->callbackId);
+        }
+
+        CRIT_SECTION_LEAVE(contextP);
+        if (isFound == true)
+        {
+            callbackP->loadCallback(callbackP->callbackId, record.value.asBuffer, record.length, callbackP->userData);
+        }
+        else
+        {
+            callbackP->loadCallback(callbackP->callbackId, NULL, 0, callbackP->userData);
+        }
+        CRIT_SECTION_ENTER(contextP);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+iowa_status_t core_unmapContext(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+#ifdef LWM2M_CLIENT_MODE
+    lwm2m_server_t *serverP;
+#endif
+
+    if (contextP->mapping.bufferP == NULL)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+#ifdef LWM2M_CLIENT_MODE
+    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    {
+        if (coreContextIsMapped(contextP, serverP->uri) == true)
+        {
+            char *uri;
+
+            uri = utilsStrdup(serverP->uri);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (uri == NULL)
+            {
+                IOWA_LOG_ERROR_MALLOC(strlen(serverP->uri) + 1);
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+#endif
+            serverP->uri = uri;
+        }
+    }
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Unmapping the context of %u bytes.", contextP->mapping.length);
+
+    iowa_system_unmap_context(contextP->mapping.bufferP, contextP->mapping.length, contextP->userData);
+    contextP->mapping.bufferP = NULL;
+    contextP->mapping.length = 0;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+bool coreContextIsMapped(iowa_context_t contextP,
+                         const void *pointerP)
+{
+    // WARNING: This function is called in a critical section
+    const uint8_t *byteP;
+
+    byteP = (const uint8_t *)pointerP;
+
+    return (contextP->mapping.bufferP != NULL
+            && byteP >= contextP->mapping.bufferP
+            && byteP < contextP->mapping.bufferP + contextP->mapping.length);
+}
+#endif // IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+void coreContextJournalObservation(iowa_context_t contextP,
+                                   lwm2m_server_t *serverP,
+                                   lwm2m_observed_t *observedP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_journalRecordNew(contextP);
+    if (messageP != NULL)
+    {
+        prv_journalRecordAppend(contextP, messageP, prv_addObservationRecord(contextP, messageP, PRV_OBSERVE_KEY, serverP, observedP));
+    }
+}
+
+void coreContextJournalObservationCounter(iowa_context_t contextP,
+                                          lwm2m_server_t *serverP,
+                                          lwm2m_observed_t *observedP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_journalRecordNew(contextP);
+    if (messageP != NULL)
+    {
+        prv_journalRecordAppend(contextP, messageP, prv_addObservationRecord(contextP, messageP, PRV_OBSERVE_UPDATE_KEY, serverP, observedP));
+    }
+}
+
+void coreContextJournalObservationCanceled(iowa_context_t contextP,
+                                           lwm2m_server_t *serverP,
+                                           lwm2m_observed_t *observedP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_journalRecordNew(contextP);
+    if (messageP != NULL)
+    {
+        prv_journalRecordAppend(contextP, messageP, prv_addObservationRecord(contextP, messageP, PRV_OBSERVE_CANCEL_KEY, serverP, observedP));
+    }
+}
+
+void coreContextJournalAttributes(iowa_context_t contextP,
+                                  lwm2m_server_t *serverP,
+                                  iowa_lwm2m_uri_t *uriP,
+                                  attributes_t *attributesP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_journalRecordNew(contextP);
+    if (messageP != NULL)
+    {
+        prv_journalRecordAppend(contextP, messageP, prv_addAttributesRecord(messageP, serverP, uriP, attributesP));
+    }
+}
+
+void coreContextJournalRuntime(iowa_context_t contextP,
+                               lwm2m_server_t *serverP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_journalRecordNew(contextP);
+    if (messageP != NULL)
+    {
+        prv_journalRecordAppend(contextP, messageP, prv_addRuntimeRecord(messageP, serverP));
+    }
+}
+
+void coreContextJournalResumption(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+
+    messageP = prv_journalRecordNew(contextP);
+    if (messageP != NULL)
+    {
+        prv_journalRecordAppend(contextP, messageP, prv_addResumptionRecord(contextP, messageP));
+    }
+}
+#endif // IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_save_context(iowa_context_t contextP)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_INFO(IOWA_PART_BASE, "Saving the context.");
+
+    CRIT_SECTION_ENTER(contextP);
+    result = core_saveContext(contextP, false);
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+iowa_status_t iowa_save_context_snapshot(iowa_context_t contextP)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_INFO(IOWA_PART_BASE, "Saving a snapshot of the context.");
+
+    CRIT_SECTION_ENTER(contextP);
+    result = core_saveContext(contextP, true);
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+iowa_status_t iowa_load_context(iowa_context_t contextP)
+{
+    iowa_status_t result;
+    uint8_t *bufferP;
+    size_t length;
+
+    IOWA_LOG_INFO(IOWA_PART_BASE, "Loading the context.");
+
+    CRIT_SECTION_ENTER(contextP);
+
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+    result = core_unmapContext(contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+
+    {
+        const uint8_t *mappedP;
+
+        mappedP = NULL;
+        length = iowa_system_map_context(&mappedP, contextP->userData);
+        if (length != 0
+            && mappedP != NULL)
+        {
+            // The region stays mapped until the next save or iowa_close() as values point to it. IOWA never writes to it.
+            contextP->mapping.bufferP = mappedP;
+            contextP->mapping.length = length;
+            bufferP = (uint8_t *)mappedP;
+        }
+        else
+        {
+            length = 0;
+        }
+    }
+
+    if (length != 0)
+    {
+        result = core_loadContext(contextP, bufferP, length);
+    }
+    else
+#endif
+    {
+        bufferP = NULL;
+        length = iowa_system_retrieve_context(&bufferP, contextP->userData);
+        if (length == 0
+            || bufferP == NULL)
+        {
+            CRIT_SECTION_LEAVE(contextP);
+            iowa_system_free(bufferP);
+            IOWA_LOG_WARNING(IOWA_PART_BASE, "No context to load.");
+            return IOWA_COAP_404_NOT_FOUND;
+        }
+
+        result = core_loadContext(contextP, bufferP, length);
+        iowa_system_free(bufferP);
+    }
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        uint16_t recordCount;
+        bool isTruncated;
+
+        bufferP = NULL;
+        length = iowa_system_retrieve_context_journal(&bufferP, contextP->userData);
+        result = prv_loadJournal(contextP, bufferP, length, &recordCount, &isTruncated);
+        iowa_system_free(bufferP);
+
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "%u journal records loaded.", recordCount);
+
+            contextP->journal.isActive = true;
+            contextP->journal.isCompactionPending = false;
+            contextP->journal.recordCount = recordCount;
+            if (isTruncated == true)
+            {
+                // New records would follow the partial one: replace the journal with a new snapshot before any append
+                if (core_saveContext(contextP, true) != IOWA_COAP_NO_ERROR)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_BASE, "Failed to replace the truncated context journal.");
+                    prv_journalRequestCompaction(contextP);
+                }
+            }
+            else if (recordCount >= IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS)
+            {
+                prv_journalRequestCompaction(contextP);
+            }
+        }
+    }
+#endif
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+iowa_status_t iowa_backup_register_callback(iowa_context_t contextP,
+                                            uint16_t callbackId,
+                                            iowa_save_callback_t saveCallback,
+                                            iowa_load_callback_t loadCallback,
+                                            void *userDataP)
+{
+    iowa_context_callback_t *callbackP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Registering the backup callbacks %u.", callbackId);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (callbackId < USER_CALLBACK_MIN_ID
+        || saveCallback == NULL
+        || loadCallback == NULL)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "Callback ID must be at least %u and the callbacks can not be nil.", USER_CALLBACK_MIN_ID);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+
+    callbackP = (iowa_context_callback_t *)IOWA_UTILS_LIST_FIND(contextP->backupCallbackList, listFindCallbackBy16bitsId, &callbackId);
+    if (callbackP != NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "Callback ID %u is already used.", callbackId);
+        return IOWA_COAP_403_FORBIDDEN;
+    }
+
+    callbackP = (iowa_context_callback_t *)iowa_system_malloc(sizeof(iowa_context_callback_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (callbackP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_context_callback_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(callbackP, 0, sizeof(iowa_context_callback_t));
+    callbackP->callbackId = callbackId;
+    callbackP->saveCallback = saveCallback;
+    callbackP->loadCallback = loadCallback;
+    callbackP->userData = userDataP;
+
+    contextP->backupCallbackList = (iowa_context_callback_t *)IOWA_UTILS_LIST_ADD(contextP->backupCallbackList, callbackP);
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void iowa_backup_deregister_callback(iowa_context_t contextP,
+                                     uint16_t callbackId)
+{
+    iowa_context_callback_t *callbackP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Deregistering the backup callbacks %u.", callbackId);
+
+    CRIT_SECTION_ENTER(contextP);
+    contextP->backupCallbackList = (iowa_context_callback_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(contextP->backupCallbackList, listFindCallbackBy16bitsId, &callbackId, &callbackP);
+    CRIT_SECTION_LEAVE(contextP);
+
+    iowa_system_free(callbackP);
+}
+
+#endif // IOWA_STORAGE_CONTEXT_SUPPORT
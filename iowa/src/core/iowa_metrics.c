@@ -0,0 +1,106 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2021 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_core_internals.h"
+
+#ifdef IOWA_METRICS_SUPPORT
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+void coreMetricsRecordDuration(iowa_metrics_histogram_t *histogramP,
+                               uint64_t startTime)
+{
+    // WARNING: This function is called in a critical section
+    uint64_t currentTime;
+    uint64_t duration;
+    uint64_t limit;
+    uint8_t bucket;
+
+    currentTime = iowa_system_gettime_us();
+    if (currentTime > startTime)
+    {
+        duration = currentTime - startTime;
+    }
+    else
+    {
+        duration = 0;
+    }
+
+    // Bucket i holds the durations lower than 10^(i+1) microseconds
+    bucket = 0;
+    limit = 10;
+    while (bucket < IOWA_METRICS_HISTOGRAM_BUCKET_COUNT - 1
+           && duration >= limit)
+    {
+        bucket++;
+        limit *= 10;
+    }
+
+    histogramP->count++;
+    histogramP->sum += duration;
+    if (duration > UINT32_MAX)
+    {
+        duration = UINT32_MAX;
+    }
+    if (duration > histogramP->max)
+    {
+        histogramP->max = (uint32_t)duration;
+    }
+    histogramP->buckets[bucket]++;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_get_metrics(iowa_context_t contextP,
+                               iowa_metrics_t *metricsP)
+{
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (metricsP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "metricsP is nil.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+    memcpy(metricsP, &(contextP->metrics), sizeof(iowa_metrics_t));
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_reset_metrics(iowa_context_t contextP)
+{
+    IOWA_LOG_INFO(IOWA_PART_BASE, "Resetting the metrics.");
+
+    CRIT_SECTION_ENTER(contextP);
+    memset(&(contextP->metrics), 0, sizeof(iowa_metrics_t));
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_METRICS_SUPPORT
@@ -51,9 +51,15 @@ extern "C" {
  * Macros
  */
 
+#ifdef IOWA_THREAD_SUPPORT
+#define CRIT_SECTION_ENTER(C) iowa_system_mutex_lock((C)->userData)
+#define CRIT_SECTION_LEAVE(C) iowa_system_mutex_unlock((C)->userData)
+#define INTERRUPT_SELECT(C)   iowa_system_connection_interrupt_select((C)->userData)
+#else
 #define CRIT_SECTION_ENTER(C)
 #define CRIT_SECTION_LEAVE(C)
 #define INTERRUPT_SELECT(C)
+#endif
 
 #define ACTION_REBOOT           (1<<0)
 #define ACTION_EXIT             (1<<1)
@@ -66,6 +72,36 @@ extern "C" {
 #define ACTION_SW_CMP_ACTIVATE  (1<<8)
 #define ACTION_FACTORY_RESET    (1<<9)
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+#ifndef IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS
+#define IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS 64 // Default value
+#endif
+#endif
+
+#ifdef IOWA_METRICS_SUPPORT
+#define CORE_METRICS_INCREMENT(C, F) ((C)->metrics.F)++
+#define CORE_METRICS_RECORD_DURATION(C, H, S) coreMetricsRecordDuration(&((C)->metrics.H), (S))
+#else
+#define CORE_METRICS_INCREMENT(C, F)
+#define CORE_METRICS_RECORD_DURATION(C, H, S)
+#endif
+
+#ifdef IOWA_TRACE_SUPPORT
+#define CORE_TRACE_START(C) coreTraceStart(C)
+#define CORE_TRACE_STOP(C) (C)->trace.currentId = 0
+#define CORE_TRACE_END(C, P) coreTraceEnd((C), (P))
+#define CORE_TRACE_TIME(C, T) (T) = (((C)->trace.currentId != 0) ? iowa_system_gettime_us() : 0)
+#define CORE_TRACE_SPAN(C, P, T) coreTraceEmit((C), (C)->trace.currentId, (P), (T))
+#define CORE_TRACE_EMIT(C, I, P, T) coreTraceEmit((C), (I), (P), (T))
+#else
+#define CORE_TRACE_START(C)
+#define CORE_TRACE_STOP(C)
+#define CORE_TRACE_END(C, P)
+#define CORE_TRACE_TIME(C, T)
+#define CORE_TRACE_SPAN(C, P, T)
+#define CORE_TRACE_EMIT(C, I, P, T)
+#endif
+
 #define PMAX_UNSET_VALUE 0
 
 #define MSISDN_MAX_LENGTH 15
@@ -112,6 +148,36 @@ typedef struct _iowa_context_callback_t
     void                            *userData;
 } iowa_context_callback_t;
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+typedef struct
+{
+    bool     isActive;            // a stored context exists on which records can be appended
+    bool     isCompactionPending; // records are no longer appended until a new snapshot is stored
+    uint16_t recordCount;         // records appended since the last stored context
+} core_context_journal_t;
+#endif
+
+#ifdef IOWA_TRACE_SUPPORT
+typedef struct
+{
+    iowa_trace_callback_t callback;       // nil when the tracing is stopped
+    void                 *userDataP;
+    uint32_t              samplingPeriod;
+    uint32_t              sampleCounter;  // datagrams and notifications since the last traced one
+    uint32_t              lastId;         // ID of the last trace
+    uint32_t              currentId;      // ID of the ongoing trace, 0 when the ongoing handling is not traced
+    uint64_t              startTime;      // start of the ongoing trace
+} core_trace_t;
+#endif
+
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+typedef struct
+{
+    const uint8_t *bufferP; // returned by iowa_system_map_context(), nil when no context is mapped
+    size_t         length;
+} core_context_mapping_t;
+#endif
+
 struct _iowa_context_t
 {
     lwm2m_context_t               *lwm2mContextP;
@@ -121,8 +187,28 @@ struct _iowa_context_t
     int32_t                        currentTime;
     int32_t                        timeout;
     iowa_timer_t                  *timerList;
+    int32_t                        timerNextTime;   // lower bound of the execution times in timerList
 #ifdef LWM2M_CLIENT_MODE
     iowa_event_callback_t          eventCb;
+#endif
+#ifdef LWM2M_SERVER_MODE
+    uint8_t                        shardIndex;      // set by iowa_server_configure_shard()
+    uint8_t                        shardCount;      // 0 when the context is not part of a shard group
+#endif
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+    iowa_context_callback_t       *backupCallbackList;
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    core_context_journal_t         journal;
+#endif
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+    core_context_mapping_t         mapping;
+#endif
+#endif
+#ifdef IOWA_METRICS_SUPPORT
+    iowa_metrics_t                 metrics;
+#endif
+#ifdef IOWA_TRACE_SUPPORT
+    core_trace_t                   trace;
 #endif
     volatile uint16_t             action;
     void                          *userData;
@@ -135,6 +221,105 @@ struct _iowa_context_t
 // Implemented in iowa_client.c
 void clientNotificationLock(iowa_context_t contextP, bool enter);
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+// Implemented in iowa_context.c
+
+// Append to the context journal an observation added or updated by the LwM2M Server.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - serverP: the LwM2M Server owning the observation.
+// - observedP: the observation.
+void coreContextJournalObservation(iowa_context_t contextP, lwm2m_server_t *serverP, lwm2m_observed_t *observedP);
+
+// Append to the context journal the new Observe counter of an observation.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - serverP: the LwM2M Server owning the observation.
+// - observedP: the observation.
+void coreContextJournalObservationCounter(iowa_context_t contextP, lwm2m_server_t *serverP, lwm2m_observed_t *observedP);
+
+// Append to the context journal the cancellation of an observation.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - serverP: the LwM2M Server owning the observation.
+// - observedP: the observation. It is not yet freed.
+void coreContextJournalObservationCanceled(iowa_context_t contextP, lwm2m_server_t *serverP, lwm2m_observed_t *observedP);
+
+// Append to the context journal the attributes written on an URI.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - serverP: the LwM2M Server owning the attributes.
+// - uriP: the URI of the attributes.
+// - attributesP: the new attributes or nil if they were removed.
+void coreContextJournalAttributes(iowa_context_t contextP, lwm2m_server_t *serverP, iowa_lwm2m_uri_t *uriP, attributes_t *attributesP);
+
+// Append to the context journal the registration status of a LwM2M Server.
+// When the Server is not registered, its observations and attributes are considered cleared.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - serverP: the LwM2M Server.
+void coreContextJournalRuntime(iowa_context_t contextP, lwm2m_server_t *serverP);
+
+// Append to the context journal the data allowing to resume the secure sessions.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+void coreContextJournalResumption(iowa_context_t contextP);
+#endif
+
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+// Implemented in iowa_context.c
+
+// Check if a value points to the mapped stored context. Such a value must not be freed.
+// Returned value: true if the value lies in the mapped region.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - pointerP: the value to check. This can be nil.
+bool coreContextIsMapped(iowa_context_t contextP, const void *pointerP);
+#endif
+
+#ifdef IOWA_METRICS_SUPPORT
+// Implemented in iowa_metrics.c
+
+// Record a duration in a metrics histogram.
+// Returned value: None.
+// Parameters:
+// - histogramP: the histogram.
+// - startTime: the start of the duration as returned by iowa_system_gettime_us(). The end is now.
+void coreMetricsRecordDuration(iowa_metrics_histogram_t *histogramP, uint64_t startTime);
+#endif
+
+#ifdef IOWA_TRACE_SUPPORT
+// Implemented in iowa_trace.c
+
+// Start a new trace if it is sampled. The ongoing trace, if any, is discarded.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+void coreTraceStart(iowa_context_t contextP);
+
+// Report the span covering the ongoing trace and stop it.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - phase: the phase of the span.
+void coreTraceEnd(iowa_context_t contextP, iowa_trace_phase_t phase);
+
+// Report a span to the trace callback.
+// Returned value: None.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - traceId: the ID of the trace the span belongs to. Nothing is reported if this is 0.
+// - phase: the phase of the span.
+// - startTime: the start of the span as returned by iowa_system_gettime_us(). The end is now.
+void coreTraceEmit(iowa_context_t contextP, uint32_t traceId, iowa_trace_phase_t phase, uint64_t startTime);
+#endif
+
 // Call event callback set by iowa_client_configure for Register and Bootstrap Events from server connection.
 // Returned value: none.
 // Parameters:
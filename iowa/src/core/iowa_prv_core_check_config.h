@@ -50,11 +50,44 @@ extern "C" {
 * Check IOWA configuration.
 **********************************************/
 
+// Check binary logs support
+#if defined(IOWA_LOG_BINARY_SUPPORT) && (!defined(__STDC_VERSION__) || (__STDC_VERSION__ < 201112L) || defined(__STDC_NO_ATOMICS__))
+#error "IOWA_LOG_BINARY_SUPPORT requires a C11 compiler with atomics support."
+#endif
+
+#if defined(IOWA_LOG_BINARY_RECORD_COUNT) && ((IOWA_LOG_BINARY_RECORD_COUNT < 2) || ((IOWA_LOG_BINARY_RECORD_COUNT & (IOWA_LOG_BINARY_RECORD_COUNT - 1)) != 0))
+#error "IOWA_LOG_BINARY_RECORD_COUNT must be a power of two."
+#endif
+
 // Check storage context support
 #if defined(IOWA_STORAGE_CONTEXT_AUTOMATIC_BACKUP) && !defined(IOWA_STORAGE_CONTEXT_SUPPORT)
 #error "The storage of context feature is not enabled."
 #endif
 
+#if defined(IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT) && !defined(IOWA_STORAGE_CONTEXT_SUPPORT)
+#error "IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT requires IOWA_STORAGE_CONTEXT_SUPPORT."
+#endif
+
+#if defined(IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT) && !defined(LWM2M_CLIENT_MODE)
+#error "IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT must be only used when the LwM2M role is client."
+#endif
+
+#if defined(IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS) && (IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS < 1)
+#error "IOWA_STORAGE_CONTEXT_JOURNAL_MAX_RECORDS must be at least 1."
+#endif
+
+#if defined(IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT) && !defined(IOWA_STORAGE_CONTEXT_SUPPORT)
+#error "IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT requires IOWA_STORAGE_CONTEXT_SUPPORT."
+#endif
+
+#if defined(IOWA_SUPPORT_METRICS_OBJECT) && !defined(IOWA_METRICS_SUPPORT)
+#error "IOWA_SUPPORT_METRICS_OBJECT requires IOWA_METRICS_SUPPORT."
+#endif
+
+#if defined(IOWA_SUPPORT_METRICS_OBJECT) && !defined(LWM2M_CLIENT_MODE)
+#error "IOWA_SUPPORT_METRICS_OBJECT must be only used when the LwM2M role is client."
+#endif
+
 // Check at least one transport is defined
 #if !defined(IOWA_UDP_SUPPORT) && !defined(IOWA_TCP_SUPPORT) && !defined(IOWA_WEBSOCKET_SUPPORT) && !defined(IOWA_LORAWAN_SUPPORT) && !defined(IOWA_SMS_SUPPORT)
 #error "No transport is enabled."
@@ -85,6 +118,27 @@ extern "C" {
 #error "LWM2M_BOOTSTRAP_PACK_SUPPORT requires LWM2M_BOOTSTRAP or LWM2M_BOOTSTRAP_SERVER_MODE"
 #endif
 
+#if defined(LWM2M_BOOTSTRAP_PACK_SUPPORT) && defined(LWM2M_BOOTSTRAP_SERVER_MODE) && !defined(LWM2M_SUPPORT_SENML_CBOR)
+#error "LWM2M_BOOTSTRAP_PACK_SUPPORT requires LWM2M_SUPPORT_SENML_CBOR on the Bootstrap Server"
+#endif
+
+#if defined(LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT) && !defined(LWM2M_SERVER_MODE)
+#error "LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT must be only used when the LwM2M role is server."
+#endif
+
+#if defined(LWM2M_NOTIFICATION_STORE_SUPPORT) && !defined(LWM2M_CLIENT_MODE)
+#error "LWM2M_NOTIFICATION_STORE_SUPPORT must be only used when the LwM2M role is client."
+#endif
+
+#if defined(LWM2M_NOTIFICATION_STORE_SUPPORT) \
+    && (!defined(LWM2M_SUPPORT_TIMESTAMP) || (!defined(LWM2M_SUPPORT_SENML_CBOR) && !defined(LWM2M_SUPPORT_SENML_JSON)))
+#error "LWM2M_NOTIFICATION_STORE_SUPPORT requires LWM2M_SUPPORT_TIMESTAMP and at least one of the following formats: SenML CBOR or SenML JSON."
+#endif
+
+#if defined(IOWA_NOTIFICATION_STORE_BATCH_SIZE) && defined(IOWA_NOTIFICATION_STORE_SIZE) && (IOWA_NOTIFICATION_STORE_BATCH_SIZE > IOWA_NOTIFICATION_STORE_SIZE)
+#error "IOWA_NOTIFICATION_STORE_BATCH_SIZE must not be greater than IOWA_NOTIFICATION_STORE_SIZE."
+#endif
+
 // Check right format support activated for read & observe composite operations
 #if (defined(LWM2M_READ_COMPOSITE_SUPPORT) || defined(LWM2M_OBSERVE_COMPOSITE_SUPPORT)) \
     && (!defined(LWM2M_SUPPORT_SENML_CBOR) && !defined(LWM2M_SUPPORT_SENML_JSON))
@@ -163,6 +217,26 @@ extern "C" {
 #error "tinyDTLS does not support TLS encryption."
 #endif
 
+#if defined(IOWA_COAP_OSCORE_SUPPORT) && (IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_NONE)
+#error "OSCORE requires a security layer providing HKDF and AEAD functions."
+#endif
+
+#if defined(IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES) && (IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES < 1)
+#error "IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES must be at least 1."
+#endif
+
+#if defined(IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_USER)
+#error "IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES requires IOWA_SECURITY_LAYER_USER."
+#endif
+
+#if defined(IOWA_SECURITY_STATELESS_COOKIE_SUPPORT) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_USER)
+#error "IOWA_SECURITY_STATELESS_COOKIE_SUPPORT requires IOWA_SECURITY_LAYER_USER."
+#endif
+
+#if defined(IOWA_SECURITY_STATELESS_COOKIE_SUPPORT) && !defined(IOWA_UDP_SUPPORT)
+#error "IOWA_SECURITY_STATELESS_COOKIE_SUPPORT requires IOWA_UDP_SUPPORT."
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -87,6 +87,14 @@ iowa_status_t core_saveContext(iowa_context_t contextP, bool isSnapshot);
 // - bufferLength: length of the buffer.
 iowa_status_t core_loadContext(iowa_context_t contextP, uint8_t * bufferP, size_t bufferLength);
 
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+// Release the mapped stored context. The values pointing to it are copied first.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+iowa_status_t core_unmapContext(iowa_context_t contextP);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,7 @@ typedef void (*timer_callback_t)(iowa_context_t contextP, void *userData);
 typedef struct _iowa_timer_t
 {
     struct _iowa_timer_t *nextP;
+    struct _iowa_timer_t *prevP;
     int32_t               executionTime;
     timer_callback_t      callback;
     void                 *userData;
@@ -74,6 +75,7 @@ void coreTimerDelete(iowa_context_t contextP, iowa_timer_t *timerP);
 iowa_status_t coreTimerReset(iowa_context_t contextP, iowa_timer_t *timerP, int32_t delay);
 
 // State Machine of iowa timers. Check all timers in the iowa context and call the corresponding callback when timer's delay has expired.
+// The timer list is only walked when the earliest execution time is reached.
 // Parameters:
 // - contextP: as returned by iowa_init().
 void coreTimerStep(iowa_context_t contextP);
@@ -28,18 +28,1511 @@
 
 #define PRV_ID_BUFFER_LEN (size_t)5
 
-#define RES_ID_TO_TYPE(O, R) case IOWA_LWM2M_##O##_ID_##R : return IOWA_LWM2M_##O##_TYPE_##R
-
 #define PRV_LWM2M_UDP_BINDING    "U"
 #define PRV_LWM2M_TCP_BINDING    "T"
 #define PRV_LWM2M_SMS_BINDING    "S"
 #define PRV_LWM2M_NON_IP_BINDING "N"
 
+// A DTLS 1.2 record carrying a Connection ID (RFC 9146) has the content type 25 and the Connection ID starts after the 11 first bytes
+#define PRV_DTLS_CONTENT_TYPE_TLS12_CID 25
+#define PRV_DTLS_CID_OFFSET             11
+
+#define PRV_FNV_OFFSET_BASIS 2166136261u
+#define PRV_FNV_PRIME        16777619u
+
+#ifdef LWM2M_SERVER_MODE
+
+typedef struct
+{
+    uint32_t                  clientId;
+    uint8_t                   operation;
+    iowa_lwm2m_uri_t          uri;
+    iowa_result_callback_t    resultCb;
+    iowa_response_callback_t  responseCb;
+    void                     *userData;
+} prv_operation_t;
+
 /*************************************************************************************
 ** Private functions
 *************************************************************************************/
 
+static lwm2m_client_t * prv_findConnectedClient(iowa_context_t contextP,
+                                                uint32_t clientId,
+                                                iowa_status_t *resultP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_t *clientP;
+
+    clientP = registryFindById(contextP, clientId);
+    if (clientP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Client %u not found.", clientId);
+        *resultP = IOWA_COAP_404_NOT_FOUND;
+        return NULL;
+    }
+    if (clientP->peerP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Client %u is not connected.", clientId);
+        *resultP = IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        return NULL;
+    }
+
+    *resultP = IOWA_COAP_NO_ERROR;
+
+    return clientP;
+}
+
+static iowa_status_t prv_newRequest(lwm2m_client_t *clientP,
+                                    uint8_t code,
+                                    iowa_lwm2m_uri_t *uriP,
+                                    uint8_t uriBuffer[PRV_URI_BUFFER_SIZE],
+                                    iowa_coap_message_t **messageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_coap_option_t *optionP;
+    uint8_t token[COAP_MSG_TOKEN_MAX_LEN];
+    uint8_t tokenLength;
+
+    result = coapPeerGenerateToken(clientP->peerP, &tokenLength, token);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failure to generate a new token.");
+        return result;
+    }
+
+    *messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, code, tokenLength, token);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*messageP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP message.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    // The alternate path is stored with its leading '/'
+    optionP = uri_encode(IOWA_COAP_OPTION_URI_PATH, clientP->altPath != NULL ? clientP->altPath + 1 : NULL, uriP, uriBuffer);
+#else
+    optionP = uri_encode(IOWA_COAP_OPTION_URI_PATH, uriP, uriBuffer);
+#endif
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to encode the URI.");
+        iowa_coap_message_free(*messageP);
+        *messageP = NULL;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+    iowa_coap_message_add_option(*messageP, optionP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static iowa_status_t prv_addIntegerOption(iowa_coap_message_t *messageP,
+                                          uint16_t number,
+                                          uint32_t value)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = iowa_coap_option_new(number);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    optionP->value.asInteger = value;
+    iowa_coap_message_add_option(messageP, optionP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static iowa_status_t prv_addAcceptOption(lwm2m_client_t *clientP,
+                                         iowa_lwm2m_uri_t *uriP,
+                                         iowa_coap_message_t *messageP)
+{
+    iowa_content_format_t format;
+
+    if (LWM2M_URI_IS_SET_RESOURCE(uriP))
+    {
+        format = clientP->singleResourceAcceptFormat;
+    }
+    else
+    {
+        format = clientP->multiResourcesAcceptFormat;
+    }
+
+    if (format == IOWA_CONTENT_FORMAT_UNSET)
+    {
+        // Let the Client choose
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    return prv_addIntegerOption(messageP, IOWA_COAP_OPTION_ACCEPT, format);
+}
+
+static iowa_status_t prv_setPayload(lwm2m_client_t *clientP,
+                                    iowa_coap_message_t *messageP,
+                                    iowa_lwm2m_uri_t *uriP,
+                                    size_t dataCount,
+                                    iowa_lwm2m_data_t *dataArrayP,
+                                    uint8_t **payloadP)
+{
+    iowa_status_t result;
+    iowa_content_format_t format;
+    size_t payloadLength;
+
+    if (LWM2M_URI_IS_SET_RESOURCE(uriP)
+        && dataCount == 1
+        && dataArrayP[0].resInstanceID == IOWA_LWM2M_ID_ALL)
+    {
+        format = clientP->singleResourceFormat;
+    }
+    else
+    {
+        format = clientP->multiResourcesFormat;
+    }
+    if (format == IOWA_CONTENT_FORMAT_UNSET)
+    {
+        format = LWM2M_DEFAULT_CONTENT_FORMAT;
+    }
+
+    result = dataLwm2mSerialize(uriP, dataArrayP, dataCount, &format, payloadP, &payloadLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to serialize the data: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        return result;
+    }
+
+    result = prv_addIntegerOption(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT, format);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(*payloadP);
+        *payloadP = NULL;
+        return result;
+    }
+
+    coreBufferSet(&(messageP->payload), *payloadP, payloadLength);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static void prv_operationResultCallback(iowa_coap_peer_t *fromPeer,
+                                        uint8_t code,
+                                        iowa_coap_message_t *messageP,
+                                        void *userData,
+                                        iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    prv_operation_t *operationP;
+    lwm2m_client_t *clientP;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    iowa_status_t status;
+
+    operationP = (prv_operation_t *)userData;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Client %u operation %u result %u.%02u.", operationP->clientId, operationP->operation, (code & 0xFF) >> 5, (code & 0x1F));
+
+    dataP = NULL;
+    dataCount = 0;
+    status = code;
+
+    switch (operationP->operation)
+    {
+    case IOWA_DM_NOTIFY:
+        clientP = registryFindById(contextP, operationP->clientId);
+        if (clientP != NULL)
+        {
+            if (messageP != NULL)
+            {
+                observe_handleNotify(contextP, clientP, fromPeer, messageP);
+            }
+            else
+            {
+                lwm2m_observation_t *observationP;
+
+                // The observation request failed
+                for (observationP = clientP->observationList; observationP != NULL; observationP = observationP->next)
+                {
+                    if (0 == memcmp(observationP->uriP, &(operationP->uri), sizeof(iowa_lwm2m_uri_t))
+                        && observationP->status == STATE_REG_REGISTERING)
+                    {
+                        break;
+                    }
+                }
+                if (observationP != NULL)
+                {
+                    iowa_response_callback_t responseCb;
+                    void *responseUserData;
+
+                    responseCb = observationP->responseCb;
+                    responseUserData = observationP->userDataP;
+                    observe_remove(observationP);
+
+                    if (responseCb != NULL)
+                    {
+                        CRIT_SECTION_LEAVE(contextP);
+                        responseCb(operationP->clientId, IOWA_DM_NOTIFY, status, NULL, responseUserData, contextP);
+                        CRIT_SECTION_ENTER(contextP);
+                    }
+                }
+            }
+        }
+        iowa_system_free(operationP);
+        return;
+
+    case IOWA_DM_READ:
+        if (messageP != NULL
+            && status == IOWA_COAP_205_CONTENT
+            && messageP->payload.length != 0)
+        {
+            status = dataLwm2mDeserialize(&(operationP->uri),
+                                          messageP->payload.data, messageP->payload.length,
+                                          utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT),
+                                          &dataP, &dataCount,
+                                          utils_getResourceType, contextP);
+            if (status == IOWA_COAP_NO_ERROR)
+            {
+                status = IOWA_COAP_205_CONTENT;
+            }
+        }
+        break;
+
+    case IOWA_DM_DISCOVER:
+        if (messageP != NULL
+            && status == IOWA_COAP_205_CONTENT)
+        {
+            dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (dataP == NULL)
+            {
+                IOWA_LOG_ERROR_MALLOC(sizeof(iowa_lwm2m_data_t));
+                status = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                break;
+            }
+#endif
+            memset(dataP, 0, sizeof(iowa_lwm2m_data_t));
+            dataUtilsSetUri(dataP, &(operationP->uri));
+            dataP->type = IOWA_LWM2M_TYPE_CORE_LINK;
+            dataP->value.asBuffer.length = messageP->payload.length;
+            dataP->value.asBuffer.buffer = messageP->payload.data;
+            dataCount = 1;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    if (operationP->resultCb != NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        operationP->resultCb((iowa_dm_operation_t)operationP->operation,
+                             (uint16_t)operationP->clientId,
+                             operationP->uri.objectId, operationP->uri.instanceId, operationP->uri.resourceId,
+                             status,
+                             dataCount, dataP,
+                             operationP->userData,
+                             contextP);
+        CRIT_SECTION_ENTER(contextP);
+    }
+    else if (operationP->responseCb != NULL)
+    {
+        iowa_response_content_t content;
+
+        content.details.read.dataCount = dataCount;
+        content.details.read.dataP = dataP;
+
+        CRIT_SECTION_LEAVE(contextP);
+        operationP->responseCb(operationP->clientId, operationP->operation, status, &content, operationP->userData, contextP);
+        CRIT_SECTION_ENTER(contextP);
+    }
+
+    if (operationP->operation == IOWA_DM_DISCOVER)
+    {
+        // The Core Link buffer belongs to the CoAP message
+        iowa_system_free(dataP);
+    }
+    else
+    {
+        dataLwm2mFree(dataCount, dataP);
+    }
+    iowa_system_free(operationP);
+}
+
+static iowa_status_t prv_sendRequest(iowa_context_t contextP,
+                                     lwm2m_client_t *clientP,
+                                     iowa_coap_message_t *messageP,
+                                     uint8_t operation,
+                                     iowa_lwm2m_uri_t *uriP,
+                                     iowa_result_callback_t resultCb,
+                                     iowa_response_callback_t responseCb,
+                                     void *userData)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    prv_operation_t *operationP;
+
+    operationP = (prv_operation_t *)iowa_system_malloc(sizeof(prv_operation_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (operationP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(prv_operation_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    operationP->clientId = clientP->internalID;
+    operationP->operation = operation;
+    operationP->uri = *uriP;
+    operationP->resultCb = resultCb;
+    operationP->responseCb = responseCb;
+    operationP->userData = userData;
+
+    result = coapSend(contextP, clientP->peerP, messageP, prv_operationResultCallback, operationP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to send the request: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_system_free(operationP);
+    }
+
+    return result;
+}
+
+static iowa_status_t prv_sendOperation(iowa_context_t contextP,
+                                       uint32_t clientId,
+                                       uint8_t code,
+                                       uint8_t operation,
+                                       iowa_lwm2m_uri_t *uriP,
+                                       size_t dataCount,
+                                       iowa_lwm2m_data_t *dataArrayP,
+                                       iowa_result_callback_t resultCb,
+                                       iowa_response_callback_t responseCb,
+                                       void *userData)
+{
+    iowa_status_t result;
+    lwm2m_client_t *clientP;
+    iowa_coap_message_t *messageP;
+    uint8_t uriBuffer[PRV_URI_BUFFER_SIZE];
+    uint8_t *payload;
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findConnectedClient(contextP, clientId, &result);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+
+    result = prv_newRequest(clientP, code, uriP, uriBuffer, &messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+
+    payload = NULL;
+    switch (operation)
+    {
+    case IOWA_DM_READ:
+        result = prv_addAcceptOption(clientP, uriP, messageP);
+        break;
+
+    case IOWA_DM_DISCOVER:
+        result = prv_addIntegerOption(messageP, IOWA_COAP_OPTION_ACCEPT, IOWA_CONTENT_FORMAT_CORE_LINK);
+        break;
+
+    case IOWA_DM_WRITE:
+    case IOWA_DM_CREATE:
+        result = prv_setPayload(clientP, messageP, uriP, dataCount, dataArrayP, &payload);
+        break;
+
+    default:
+        break;
+    }
+
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_sendRequest(contextP, clientP, messageP, operation, uriP, resultCb, responseCb, userData);
+    }
+
+    iowa_system_free(payload);
+    iowa_coap_message_free(messageP);
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+static lwm2m_client_t * prv_findClient(iowa_context_t contextP,
+                                       uint32_t clientId)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_t *clientP;
+
+    clientP = registryFindById(contextP, clientId);
+    if (clientP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Client %u not found.", clientId);
+    }
+
+    return clientP;
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
 
+iowa_status_t iowa_server_configure(iowa_context_t contextP,
+                                    iowa_monitor_callback_t monitorCb,
+                                    iowa_resource_type_callback_t resTypeCb,
+                                    void *callbackUserData)
+{
+    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Configuring the Server.");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    contextP->lwm2mContextP->monitorCallback = monitorCb;
+    contextP->lwm2mContextP->resTypeCallback = resTypeCb;
+    contextP->lwm2mContextP->monitorUserData = callbackUserData;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_server_new_incoming_connection(iowa_context_t contextP,
+                                                  iowa_connection_type_t type,
+                                                  void *connP,
+                                                  bool isSecure)
+{
+    iowa_status_t result;
+    iowa_coap_peer_t *peerP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "New incoming connection %p of type %d, isSecure: %s.", connP, type, isSecure ? "true" : "false");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    // The peer is bound to a Client when it registers
+    result = coapPeerNew(contextP, type, connP, isSecure, lwm2m_server_handle_request, NULL, NULL, &peerP);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = coapPeerConnect(contextP, peerP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to connect the peer: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+            coapPeerDelete(contextP, peerP);
+        }
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+size_t iowa_server_create_registration_update_trigger_message(uint16_t serverInstanceId,
+                                                              uint8_t **bufferP)
+{
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    iowa_lwm2m_uri_t uri;
+    uint8_t uriBuffer[PRV_URI_BUFFER_SIZE];
+    size_t length;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Creating a Registration Update Trigger message for Server instance %u.", serverInstanceId);
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_CODE_POST, 0, NULL);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP message.");
+        return 0;
+    }
+#endif
+
+    uri.objectId = IOWA_LWM2M_SERVER_OBJECT_ID;
+    uri.instanceId = serverInstanceId;
+    uri.resourceId = IOWA_LWM2M_SERVER_ID_UPDATE;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    optionP = uri_encode(IOWA_COAP_OPTION_URI_PATH, NULL, &uri, uriBuffer);
+#else
+    optionP = uri_encode(IOWA_COAP_OPTION_URI_PATH, &uri, uriBuffer);
+#endif
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to encode the URI.");
+        iowa_coap_message_free(messageP);
+        return 0;
+    }
+    iowa_coap_message_add_option(messageP, optionP);
+
+    length = coapMessageSerializeDatagram(messageP, bufferP);
+
+    iowa_coap_message_free(messageP);
+
+    return length;
+}
+
+iowa_status_t iowa_server_dm_exec(iowa_context_t contextP,
+                                  uint32_t clientID,
+                                  uint16_t objectID, uint16_t instanceID, uint16_t resourceID,
+                                  iowa_result_callback_t resultCb,
+                                  void * resultUserData)
+{
+    iowa_lwm2m_uri_t uri;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Execute on Client %u: /%u/%u/%u.", clientID, objectID, instanceID, resourceID);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (objectID == IOWA_LWM2M_ID_ALL
+        || instanceID == IOWA_LWM2M_ID_ALL
+        || resourceID == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Execute targets a Resource.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    uri.objectId = objectID;
+    uri.instanceId = instanceID;
+    uri.resourceId = resourceID;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+    return prv_sendOperation(contextP, clientID, IOWA_COAP_CODE_POST, IOWA_DM_EXECUTE, &uri, 0, NULL, resultCb, NULL, resultUserData);
+}
+
+iowa_status_t iowa_server_dm_create(iowa_context_t contextP,
+                                    uint32_t clientId,
+                                    uint16_t objectId, uint16_t instanceId,
+                                    size_t dataCount,
+                                    iowa_lwm2m_data_t *dataArrayP,
+                                    iowa_result_callback_t resultCb,
+                                    void *resultUserData)
+{
+    iowa_lwm2m_uri_t uri;
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    size_t index;
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Create on Client %u: /%u/%u with %u data.", clientId, objectId, instanceId, dataCount);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (objectId == IOWA_LWM2M_ID_ALL
+        || dataCount == 0
+        || dataArrayP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Create targets an Object and requires data.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    for (index = 0; index < dataCount; index++)
+    {
+        if (dataArrayP[index].objectID != objectId
+            || dataArrayP[index].instanceID != instanceId)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Data do not belong to the created Object Instance.");
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+    }
+#else
+    (void)instanceId;
+#endif
+
+    // The new instance ID is carried by the data
+    uri.objectId = objectId;
+    uri.instanceId = IOWA_LWM2M_ID_ALL;
+    uri.resourceId = IOWA_LWM2M_ID_ALL;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+    return prv_sendOperation(contextP, clientId, IOWA_COAP_CODE_POST, IOWA_DM_CREATE, &uri, dataCount, dataArrayP, resultCb, NULL, resultUserData);
+}
+
+iowa_status_t iowa_server_dm_delete(iowa_context_t contextP,
+                                    uint32_t clientId,
+                                    uint16_t objectId, uint16_t instanceId,
+                                    iowa_result_callback_t resultCb,
+                                    void *resultUserData)
+{
+    iowa_lwm2m_uri_t uri;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Delete on Client %u: /%u/%u.", clientId, objectId, instanceId);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (objectId == IOWA_LWM2M_ID_ALL
+        || instanceId == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Delete targets an Object Instance.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    uri.objectId = objectId;
+    uri.instanceId = instanceId;
+    uri.resourceId = IOWA_LWM2M_ID_ALL;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+    return prv_sendOperation(contextP, clientId, IOWA_COAP_CODE_DELETE, IOWA_DM_DELETE, &uri, 0, NULL, resultCb, NULL, resultUserData);
+}
+
+iowa_status_t iowa_server_dm_discover(iowa_context_t contextP,
+                                      uint32_t clientID,
+                                      uint16_t objectID, uint16_t instanceID, uint16_t resourceID,
+                                      iowa_result_callback_t resultCb,
+                                      void * resultUserData)
+{
+    iowa_lwm2m_uri_t uri;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Discover on Client %u: /%u/%u/%u.", clientID, objectID, instanceID, resourceID);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (objectID == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Discover targets at least an Object.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    uri.objectId = objectID;
+    uri.instanceId = instanceID;
+    uri.resourceId = resourceID;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+
+    return prv_sendOperation(contextP, clientID, IOWA_COAP_CODE_GET, IOWA_DM_DISCOVER, &uri, 0, NULL, resultCb, NULL, resultUserData);
+}
+
+iowa_status_t iowa_server_read(iowa_context_t contextP,
+                               uint32_t clientId,
+                               size_t uriCount,
+                               iowa_lwm2m_uri_t *uriP,
+                               iowa_response_callback_t responseCb,
+                               void *userDataP)
+{
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Read on Client %u of %u URIs.", clientId, uriCount);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (uriCount == 0
+        || uriP == NULL
+        || responseCb == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Read requires a URI and a callback.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (uriCount != 1)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Read-Composite is not supported.");
+        return IOWA_COAP_501_NOT_IMPLEMENTED;
+    }
+
+    return prv_sendOperation(contextP, clientId, IOWA_COAP_CODE_GET, IOWA_DM_READ, uriP, 0, NULL, NULL, responseCb, userDataP);
+}
+
+iowa_status_t iowa_server_observe(iowa_context_t contextP,
+                                  uint32_t clientId,
+                                  size_t uriCount,
+                                  iowa_lwm2m_uri_t *uriP,
+                                  iowa_response_callback_t responseCb,
+                                  void *userDataP,
+                                  uint16_t *observeIdP)
+{
+    iowa_status_t result;
+    lwm2m_client_t *clientP;
+    lwm2m_observation_t *observationP;
+    iowa_coap_message_t *messageP;
+    uint8_t uriBuffer[PRV_URI_BUFFER_SIZE];
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Observe on Client %u of %u URIs.", clientId, uriCount);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (uriCount == 0
+        || uriP == NULL
+        || responseCb == NULL
+        || observeIdP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Observe requires a URI, a callback and an ID.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (uriCount != 1)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Observe-Composite is not supported.");
+        return IOWA_COAP_501_NOT_IMPLEMENTED;
+    }
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findConnectedClient(contextP, clientId, &result);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+
+    observationP = (lwm2m_observation_t *)iowa_system_malloc(sizeof(lwm2m_observation_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (observationP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(lwm2m_observation_t));
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(observationP, 0, sizeof(lwm2m_observation_t));
+
+    observationP->uriP = (iowa_lwm2m_uri_t *)iowa_system_malloc(sizeof(iowa_lwm2m_uri_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (observationP->uriP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_lwm2m_uri_t));
+        iowa_system_free(observationP);
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    *(observationP->uriP) = *uriP;
+    observationP->uriCount = 1;
+    observationP->clientP = clientP;
+    observationP->status = STATE_REG_REGISTERING;
+    observationP->responseCb = responseCb;
+    observationP->userDataP = userDataP;
+    observationP->id = LIST_NEW_16_BITS_ID(clientP->observationList);
+
+    result = prv_newRequest(clientP, IOWA_COAP_CODE_GET, uriP, uriBuffer, &messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(observationP->uriP);
+        iowa_system_free(observationP);
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+    memcpy(observationP->token, messageP->token, messageP->tokenLength);
+    observationP->tokenLength = messageP->tokenLength;
+
+    result = prv_addIntegerOption(messageP, IOWA_COAP_OPTION_OBSERVE, 0);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_addAcceptOption(clientP, uriP, messageP);
+    }
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        // Added before sending as the answer may come synchronously on some transports
+        clientP->observationList = (lwm2m_observation_t *)IOWA_UTILS_LIST_ADD(clientP->observationList, observationP);
+        *observeIdP = observationP->id;
+
+        result = prv_sendRequest(contextP, clientP, messageP, IOWA_DM_NOTIFY, uriP, NULL, NULL, NULL);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            observe_remove(observationP);
+        }
+    }
+    else
+    {
+        iowa_system_free(observationP->uriP);
+        iowa_system_free(observationP);
+    }
+
+    iowa_coap_message_free(messageP);
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+iowa_status_t iowa_server_observe_cancel(iowa_context_t contextP,
+                                         uint32_t clientId,
+                                         uint16_t observeId)
+{
+    iowa_status_t result;
+    lwm2m_client_t *clientP;
+    lwm2m_observation_t *observationP;
+    iowa_coap_message_t *messageP;
+    uint8_t uriBuffer[PRV_URI_BUFFER_SIZE];
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Cancel observation %u on Client %u.", observeId, clientId);
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findClient(contextP, clientId);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    observationP = (lwm2m_observation_t *)IOWA_UTILS_LIST_FIND(clientP->observationList, listFindCallbackBy16bitsId, &observeId);
+    if (observationP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Observation %u not found.", observeId);
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    result = IOWA_COAP_NO_ERROR;
+    if (clientP->peerP != NULL)
+    {
+        // Active cancellation: a GET with the Observe option set to 1 and the observation token
+        result = prv_newRequest(clientP, IOWA_COAP_CODE_GET, observationP->uriP, uriBuffer, &messageP);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            memcpy(messageP->token, observationP->token, observationP->tokenLength);
+            messageP->tokenLength = observationP->tokenLength;
+
+            result = prv_addIntegerOption(messageP, IOWA_COAP_OPTION_OBSERVE, 1);
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                result = prv_sendRequest(contextP, clientP, messageP, IOWA_DM_CANCEL, observationP->uriP, NULL, NULL, NULL);
+            }
+            iowa_coap_message_free(messageP);
+        }
+    }
+    // else the next notification will be answered by a reset
+
+    observe_remove(observationP);
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+iowa_status_t iowa_server_write(iowa_context_t contextP,
+                                uint32_t clientId,
+                                size_t dataCount,
+                                iowa_lwm2m_data_t *dataArrayP,
+                                iowa_response_callback_t responseCb,
+                                void *userDataP)
+{
+    iowa_lwm2m_uri_t uri;
+    size_t index;
+    uint8_t code;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Write on Client %u of %u data.", clientId, dataCount);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataCount == 0
+        || dataArrayP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Write requires data.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    // Find the deepest URI common to all the data
+    uri.objectId = dataArrayP[0].objectID;
+    uri.instanceId = dataArrayP[0].instanceID;
+    uri.resourceId = dataArrayP[0].resourceID;
+    uri.resInstanceId = IOWA_LWM2M_ID_ALL;
+    for (index = 1; index < dataCount; index++)
+    {
+        if (dataArrayP[index].objectID != uri.objectId
+            || dataArrayP[index].instanceID != uri.instanceId)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Write-Composite is not supported.");
+            return IOWA_COAP_501_NOT_IMPLEMENTED;
+        }
+        if (dataArrayP[index].resourceID != uri.resourceId)
+        {
+            uri.resourceId = IOWA_LWM2M_ID_ALL;
+        }
+    }
+
+    if (uri.objectId == IOWA_LWM2M_ID_ALL
+        || uri.instanceId == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Write targets an Object Instance or a Resource.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    if (uri.resourceId != IOWA_LWM2M_ID_ALL)
+    {
+        // Replace the Resource
+        code = IOWA_COAP_CODE_PUT;
+    }
+    else
+    {
+        // Partial update of the Object Instance
+        code = IOWA_COAP_CODE_POST;
+    }
+
+    return prv_sendOperation(contextP, clientId, code, IOWA_DM_WRITE, &uri, dataCount, dataArrayP, NULL, responseCb, userDataP);
+}
+
+iowa_status_t iowa_server_write_attributes_string(iowa_context_t contextP,
+                                                  uint32_t clientId,
+                                                  iowa_lwm2m_uri_t *uriP,
+                                                  const char *attributesStr,
+                                                  iowa_response_callback_t responseCb,
+                                                  void *userDataP)
+{
+    iowa_status_t result;
+    lwm2m_client_t *clientP;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint8_t uriBuffer[PRV_URI_BUFFER_SIZE];
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Write-Attributes on Client %u: \"%s\".", clientId, attributesStr != NULL ? attributesStr : "");
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (uriP == NULL
+        || attributesStr == NULL
+        || attributesStr[0] == '\0')
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Write-Attributes requires a URI and attributes.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findConnectedClient(contextP, clientId, &result);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+
+    result = prv_newRequest(clientP, IOWA_COAP_CODE_PUT, uriP, uriBuffer, &messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return result;
+    }
+
+    // The option values reference 'attributesStr' which outlives the message
+    optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_QUERY, attributesStr, QUERY_SEPARATOR);
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create the attributes options.");
+        result = IOWA_COAP_400_BAD_REQUEST;
+    }
+    else
+    {
+        iowa_coap_message_add_option(messageP, optionP);
+        result = prv_sendRequest(contextP, clientP, messageP, IOWA_DM_WRITE_ATTRIBUTES, uriP, NULL, responseCb, userDataP);
+    }
+
+    iowa_coap_message_free(messageP);
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+void iowa_server_configure_data_push(iowa_context_t contextP,
+                                     iowa_response_callback_t responseCb,
+                                     void *userDataP)
+{
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Data Push %s.", responseCb != NULL ? "enabled" : "disabled");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    contextP->lwm2mContextP->dataPushCallback = responseCb;
+    contextP->lwm2mContextP->dataPushUserData = userDataP;
+
+    CRIT_SECTION_LEAVE(contextP);
+}
+
+void iowa_server_set_verify_client_callback(iowa_context_t contextP,
+                                            iowa_verify_client_callback_t verifyClientCb,
+                                            void *callbackUserData)
+{
+    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Setting the verify client callback.");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    contextP->lwm2mContextP->verifyClientCallback = verifyClientCb;
+    contextP->lwm2mContextP->verifyClientUserData = callbackUserData;
+
+    CRIT_SECTION_LEAVE(contextP);
+}
+
+iowa_status_t iowa_server_set_response_format(iowa_context_t contextP,
+                                              uint32_t clientID,
+                                              iowa_content_format_t multiResourcesFormat,
+                                              iowa_content_format_t singleResourceFormat)
+{
+    lwm2m_client_t *clientP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client %u response formats: %s, %s.", clientID, STR_MEDIA_TYPE(multiResourcesFormat), STR_MEDIA_TYPE(singleResourceFormat));
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findClient(contextP, clientID);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    clientP->multiResourcesAcceptFormat = multiResourcesFormat;
+    clientP->singleResourceAcceptFormat = singleResourceFormat;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_server_set_payload_format(iowa_context_t contextP,
+                                             uint32_t clientID,
+                                             iowa_content_format_t multiResourcesFormat,
+                                             iowa_content_format_t singleResourceFormat)
+{
+    lwm2m_client_t *clientP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client %u payload formats: %s, %s.", clientID, STR_MEDIA_TYPE(multiResourcesFormat), STR_MEDIA_TYPE(singleResourceFormat));
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findClient(contextP, clientID);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    clientP->multiResourcesFormat = multiResourcesFormat;
+    clientP->singleResourceFormat = singleResourceFormat;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_server_close_client_connection(iowa_context_t contextP,
+                                                  uint32_t clientId)
+{
+    lwm2m_client_t *clientP;
+    iowa_coap_peer_t *peerP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Closing the connection of Client %u.", clientId);
+
+    CRIT_SECTION_ENTER(contextP);
+
+    clientP = prv_findClient(contextP, clientId);
+    if (clientP == NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    // The Client stays registered and is bound again to the connection of its next Registration Update
+    peerP = clientP->peerP;
+    clientP->peerP = NULL;
+    if (peerP != NULL)
+    {
+        coapPeerDelete(contextP, peerP);
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+iowa_status_t iowa_server_configure_notification_queue(iowa_context_t contextP,
+                                                       size_t capacity,
+                                                       iowa_notification_queue_policy_t policy,
+                                                       iowa_notification_signal_callback_t signalCb,
+                                                       void *callbackUserData)
+{
+    lwm2m_notification_queue_t *queueP;
+    iowa_notification_t *notificationArray;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Configuring the notification queue with a capacity of %u, policy: %d.", capacity, policy);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (policy != IOWA_NOTIFICATION_QUEUE_DROP_NEWEST
+        && policy != IOWA_NOTIFICATION_QUEUE_DROP_OLDEST)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Unknown drop policy %d.", policy);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    notificationArray = NULL;
+    if (capacity > 0)
+    {
+        notificationArray = (iowa_notification_t *)iowa_system_malloc(capacity * sizeof(iowa_notification_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (notificationArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(capacity * sizeof(iowa_notification_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+    }
+
+    CRIT_SECTION_ENTER(contextP);
+
+    queueP = &(contextP->lwm2mContextP->notificationQueue);
+
+    observe_clearNotificationQueue(contextP);
+    queueP->notificationArray = notificationArray;
+    queueP->capacity = capacity;
+    queueP->policy = policy;
+    queueP->signalCallback = signalCb;
+    queueP->signalUserData = callbackUserData;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+size_t iowa_server_get_notifications(iowa_context_t contextP,
+                                     iowa_notification_t *notificationArray,
+                                     size_t arraySize)
+{
+    size_t count;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Retrieving up to %u notifications.", arraySize);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (notificationArray == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "notificationArray is nil.");
+        return 0;
+    }
+#endif
+
+    // With IOWA_THREAD_SUPPORT, the IOWA mutex is only held while copying the batch
+    CRIT_SECTION_ENTER(contextP);
+    count = observe_takeNotifications(contextP, notificationArray, arraySize);
+    CRIT_SECTION_LEAVE(contextP);
+
+    return count;
+}
+
+void iowa_server_free_notifications(iowa_notification_t *notificationArray,
+                                    size_t notificationCount)
+{
+    size_t index;
+
+    for (index = 0; index < notificationCount; index++)
+    {
+        dataLwm2mFree(notificationArray[index].content.details.observe.dataCount, notificationArray[index].content.details.observe.dataP);
+        notificationArray[index].content.details.observe.dataCount = 0;
+        notificationArray[index].content.details.observe.dataP = NULL;
+    }
+}
+
+void iowa_server_get_notification_queue_stats(iowa_context_t contextP,
+                                              iowa_notification_queue_stats_t *statsP)
+{
+    CRIT_SECTION_ENTER(contextP);
+    *statsP = contextP->lwm2mContextP->notificationQueue.stats;
+    CRIT_SECTION_LEAVE(contextP);
+}
+#endif // LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+
+iowa_status_t iowa_server_configure_shard(iowa_context_t contextP,
+                                          uint8_t shardIndex,
+                                          uint8_t shardCount)
+{
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Configuring the context as shard %u of %u.", shardIndex, shardCount);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (shardCount == 0
+        || shardIndex >= shardCount)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Invalid shard index %u for %u shards.", shardIndex, shardCount);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+
+    if (contextP->lwm2mContextP->clientRegistry.clientCount != 0)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Clients are already registered.");
+        return IOWA_COAP_412_PRECONDITION_FAILED;
+    }
+
+    contextP->shardIndex = shardIndex;
+    contextP->shardCount = shardCount;
+    contextP->lwm2mContextP->nextClientID = shardIndex;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t iowa_server_get_datagram_shard(const uint8_t *bufferP,
+                                       size_t bufferLength,
+                                       const uint8_t *peerIdP,
+                                       size_t peerIdLength,
+                                       uint8_t shardCount)
+{
+    uint32_t hash;
+    size_t index;
+
+    if (shardCount <= 1)
+    {
+        return 0;
+    }
+
+    // The Connection IDs generated by a shard start with its index. This keeps a DTLS session on its shard when the peer address changes.
+    if (bufferP != NULL
+        && bufferLength > PRV_DTLS_CID_OFFSET
+        && bufferP[0] == PRV_DTLS_CONTENT_TYPE_TLS12_CID)
+    {
+        return (uint8_t)(bufferP[PRV_DTLS_CID_OFFSET] % shardCount);
+    }
+
+    // FNV-1a hash of the peer identifier
+    hash = PRV_FNV_OFFSET_BASIS;
+    for (index = 0; index < peerIdLength; index++)
+    {
+        hash ^= peerIdP[index];
+        hash *= PRV_FNV_PRIME;
+    }
+
+    return (uint8_t)(hash % shardCount);
+}
+
+uint8_t iowa_server_get_client_shard(uint32_t clientId,
+                                     uint8_t shardCount)
+{
+    if (shardCount <= 1)
+    {
+        return 0;
+    }
+
+    return (uint8_t)(clientId % shardCount);
+}
+
+#endif // LWM2M_SERVER_MODE
+
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+
+#ifdef LWM2M_BOOTSTRAP_PACK_SUPPORT
+struct _iowa_bspack_template_t
+{
+    data_template_t content;
+};
+#endif
+
+/*************************************************************************************
+** Bootstrap Server public functions
+*************************************************************************************/
+
+iowa_status_t iowa_bootstrap_server_configure(iowa_context_t contextP,
+                                              iowa_monitor_callback_t monitorCb,
+                                              void *callbackUserData)
+{
+    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Configuring the Bootstrap Server.");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    contextP->lwm2mContextP->bootstrapMonitorCallback = monitorCb;
+    contextP->lwm2mContextP->bootstrapMonitorUserData = callbackUserData;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_bootstrap_server_new_incoming_connection(iowa_context_t contextP,
+                                                            iowa_connection_type_t type,
+                                                            void *connP,
+                                                            bool isSecure)
+{
+    iowa_status_t result;
+    iowa_coap_peer_t *peerP;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "New incoming connection %p of type %d, isSecure: %s.", connP, type, isSecure ? "true" : "false");
+
+    CRIT_SECTION_ENTER(contextP);
+
+    // The peer is bound to a Client when it requests a Bootstrap-Pack
+    result = coapPeerNew(contextP, type, connP, isSecure, lwm2m_bootstrap_server_handle_request, NULL, NULL, &peerP);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = coapPeerConnect(contextP, peerP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to connect the peer: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+            coapPeerDelete(contextP, peerP);
+        }
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return result;
+}
+
+#ifdef LWM2M_BOOTSTRAP_PACK_SUPPORT
+iowa_status_t iowa_bootstrap_server_send_bspack(iowa_context_t contextP,
+                                                uint32_t clientId,
+                                                size_t dataCount,
+                                                iowa_lwm2m_data_t *dataArray)
+{
+    iowa_status_t result;
+    iowa_content_format_t format;
+    uint8_t *payload;
+    size_t payloadLength;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Sending a Bootstrap-Pack of %u data to client %u.", dataCount, clientId);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataCount == 0
+        || dataArray == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "The Bootstrap-Pack is empty.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    // The serialization does not need the context
+    format = IOWA_CONTENT_FORMAT_SENML_CBOR;
+    result = dataLwm2mSerialize(NULL, dataArray, dataCount, &format, &payload, &payloadLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to serialize the Bootstrap-Pack: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        return result;
+    }
+
+    CRIT_SECTION_ENTER(contextP);
+    result = bootstrapServerSendPack(contextP, clientId, payload, payloadLength);
+    CRIT_SECTION_LEAVE(contextP);
+
+    iowa_system_free(payload);
+
+    return result;
+}
+
+iowa_status_t iowa_bootstrap_server_create_bspack_template(size_t dataCount,
+                                                           iowa_lwm2m_data_t *dataArray,
+                                                           size_t slotCount,
+                                                           iowa_lwm2m_uri_t *slotUriArray,
+                                                           iowa_bspack_template_t *templateP)
+{
+    iowa_status_t result;
+    size_t *slotDataIndexArray;
+    size_t i;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Creating a Bootstrap-Pack template of %u data with %u slots.", dataCount, slotCount);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataCount == 0
+        || dataArray == NULL
+        || (slotCount != 0 && slotUriArray == NULL)
+        || templateP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Invalid template parameters.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    *templateP = NULL;
+
+    slotDataIndexArray = NULL;
+    if (slotCount != 0)
+    {
+        slotDataIndexArray = (size_t *)iowa_system_malloc(slotCount * sizeof(size_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (slotDataIndexArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(slotCount * sizeof(size_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+    }
+
+    for (i = 0; i < slotCount; i++)
+    {
+        size_t j;
+
+        for (j = 0; j < dataCount; j++)
+        {
+            if (dataUtilsIsEqualUri(dataArray + j, slotUriArray + i) == true)
+            {
+                break;
+            }
+        }
+        if (j == dataCount)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Slot #%u does not match any data.", i);
+            iowa_system_free(slotDataIndexArray);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        slotDataIndexArray[i] = j;
+    }
+
+    *templateP = (iowa_bspack_template_t)iowa_system_malloc(sizeof(struct _iowa_bspack_template_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*templateP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(struct _iowa_bspack_template_t));
+        iowa_system_free(slotDataIndexArray);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    result = dataTemplateInit(dataArray, dataCount, slotCount, slotDataIndexArray, &((*templateP)->content));
+    iowa_system_free(slotDataIndexArray);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to encode the Bootstrap-Pack template: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        iowa_system_free(*templateP);
+        *templateP = NULL;
+    }
+
+    return result;
+}
+
+iowa_status_t iowa_bootstrap_server_send_bspack_template(iowa_context_t contextP,
+                                                         uint32_t clientId,
+                                                         iowa_bspack_template_t templateP,
+                                                         size_t valueCount,
+                                                         iowa_lwm2m_data_t *valueArray)
+{
+    iowa_status_t result;
+    uint8_t *payload;
+    size_t payloadLength;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Sending a Bootstrap-Pack template to client %u.", clientId);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (templateP == NULL
+        || valueCount != templateP->content.slotCount
+        || (valueCount != 0 && valueArray == NULL))
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "The values do not match the template slots.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    // Only the slot values are encoded, the rest of the Bootstrap-Pack is copied from the template
+    result = dataTemplateSerialize(&(templateP->content), valueArray, &payload, &payloadLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    CRIT_SECTION_ENTER(contextP);
+    result = bootstrapServerSendPack(contextP, clientId, payload, payloadLength);
+    CRIT_SECTION_LEAVE(contextP);
+
+    iowa_system_free(payload);
+
+    return result;
+}
+
+void iowa_bootstrap_server_free_bspack_template(iowa_bspack_template_t templateP)
+{
+    if (templateP == NULL)
+    {
+        return;
+    }
+
+    dataTemplateFree(&(templateP->content));
+    iowa_system_free(templateP);
+}
+#endif // LWM2M_BOOTSTRAP_PACK_SUPPORT
+
+#endif // LWM2M_BOOTSTRAP_SERVER_MODE
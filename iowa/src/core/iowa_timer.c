@@ -23,6 +23,29 @@
 #include "iowa_prv_core_internals.h"
 #include "iowa_prv_lwm2m_internals.h"
 
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static void prv_unlinkTimer(iowa_context_t contextP,
+                            iowa_timer_t *timerP)
+{
+    // WARNING: This function is called in a critical section
+
+    if (timerP->prevP == NULL)
+    {
+        contextP->timerList = timerP->nextP;
+    }
+    else
+    {
+        timerP->prevP->nextP = timerP->nextP;
+    }
+    if (timerP->nextP != NULL)
+    {
+        timerP->nextP->prevP = timerP->prevP;
+    }
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -71,7 +94,17 @@ iowa_timer_t *coreTimerNew(iowa_context_t contextP,
         return NULL;
     }
 
-    contextP->timerList = (iowa_timer_t *)IOWA_UTILS_LIST_ADD(contextP->timerList, timerP);
+    timerP->nextP = contextP->timerList;
+    if (contextP->timerList != NULL)
+    {
+        contextP->timerList->prevP = timerP;
+    }
+    contextP->timerList = timerP;
+
+    if (timerP->executionTime < contextP->timerNextTime)
+    {
+        contextP->timerNextTime = timerP->executionTime;
+    }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with iowa_timer_t: %p, execution time: %ds.", timerP, timerP->executionTime);
 
@@ -85,7 +118,7 @@ void coreTimerDelete(iowa_context_t contextP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with iowa_timer_t %p.", timerP);
 
-    contextP->timerList = (iowa_timer_t *)IOWA_UTILS_LIST_REMOVE(contextP->timerList, timerP);
+    prv_unlinkTimer(contextP, timerP);
 
     iowa_system_free(timerP);
 
@@ -119,6 +152,11 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
 
     timerP->executionTime = targetTime;
 
+    if (targetTime < contextP->timerNextTime)
+    {
+        contextP->timerNextTime = targetTime;
+    }
+
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with execution time: %ds.", timerP->executionTime);
 
     return IOWA_COAP_NO_ERROR;
@@ -128,12 +166,31 @@ void coreTimerStep(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
     iowa_timer_t *timerP;
-    iowa_timer_t *parentTimerP;
+    int32_t delay;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering currentTime: %ds, timeoutP: %ds.", contextP->currentTime, contextP->timeout);
 
+    if (contextP->timerNextTime > contextP->currentTime)
+    {
+        // No timer can have expired yet
+        if (contextP->timerList != NULL)
+        {
+            delay = contextP->timerNextTime - contextP->currentTime;
+            if (delay < contextP->timeout)
+            {
+                IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %ds to %ds.", contextP->timeout, delay);
+                contextP->timeout = delay;
+            }
+        }
+
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with final timeoutP: %ds.", contextP->timeout);
+        return;
+    }
+
+    // Timers created or reset by the callbacks lower this value
+    contextP->timerNextTime = INT32_MAX;
+
     timerP = contextP->timerList;
-    parentTimerP = NULL;
     while (timerP != NULL)
     {
         iowa_timer_t *nextTimerP;
@@ -148,33 +205,28 @@ void coreTimerStep(iowa_context_t contextP)
             timerP->callback(contextP, timerP->userData);
             IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Callback for iowa_timer_t %p returned.", timerP);
 
-            if (parentTimerP == NULL)
-            {
-                contextP->timerList = timerP->nextP;
-            }
-            else
-            {
-                parentTimerP->nextP = timerP->nextP;
-            }
-
+            // The callback may have deleted the following timer
+            nextTimerP = timerP->nextP;
+            prv_unlinkTimer(contextP, timerP);
             iowa_system_free(timerP);
         }
-        else
+        else if (timerP->executionTime < contextP->timerNextTime)
         {
-            int32_t delay;
-
-            delay = timerP->executionTime - contextP->currentTime;
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Execution delay for iowa_timer_t %p is %ds.", timerP, delay);
+            contextP->timerNextTime = timerP->executionTime;
+        }
+        timerP = nextTimerP;
+    }
 
-            if (delay < contextP->timeout)
-            {
-                IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %ds to %ds.", contextP->timeout, delay);
-                contextP->timeout = delay;
-            }
+    if (contextP->timerNextTime != INT32_MAX)
+    {
+        delay = contextP->timerNextTime - contextP->currentTime;
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Next timer execution delay is %ds.", delay);
 
-            parentTimerP = timerP;
+        if (delay < contextP->timeout)
+        {
+            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %ds to %ds.", contextP->timeout, delay);
+            contextP->timeout = delay;
         }
-        timerP = nextTimerP;
     }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with final timeoutP: %ds.", contextP->timeout);
@@ -0,0 +1,131 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2021 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+
+#include "iowa_prv_core_internals.h"
+
+#ifdef IOWA_TRACE_SUPPORT
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+void coreTraceStart(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+
+    contextP->trace.currentId = 0;
+
+    if (contextP->trace.callback == NULL)
+    {
+        return;
+    }
+
+    contextP->trace.sampleCounter++;
+    if (contextP->trace.sampleCounter < contextP->trace.samplingPeriod)
+    {
+        return;
+    }
+    contextP->trace.sampleCounter = 0;
+
+    contextP->trace.lastId++;
+    if (contextP->trace.lastId == 0)
+    {
+        // 0 means not traced
+        contextP->trace.lastId = 1;
+    }
+    contextP->trace.currentId = contextP->trace.lastId;
+    contextP->trace.startTime = iowa_system_gettime_us();
+}
+
+void coreTraceEnd(iowa_context_t contextP,
+                  iowa_trace_phase_t phase)
+{
+    // WARNING: This function is called in a critical section
+
+    coreTraceEmit(contextP, contextP->trace.currentId, phase, contextP->trace.startTime);
+    contextP->trace.currentId = 0;
+}
+
+void coreTraceEmit(iowa_context_t contextP,
+                   uint32_t traceId,
+                   iowa_trace_phase_t phase,
+                   uint64_t startTime)
+{
+    // WARNING: This function is called in a critical section
+    iowa_trace_span_t span;
+    uint64_t currentTime;
+
+    // The callback may have been removed since the start of the trace
+    if (traceId == 0
+        || contextP->trace.callback == NULL)
+    {
+        return;
+    }
+
+    currentTime = iowa_system_gettime_us();
+
+    span.traceId = traceId;
+    span.phase = phase;
+    span.startTime = startTime;
+    if (currentTime <= startTime)
+    {
+        span.duration = 0;
+    }
+    else if (currentTime - startTime > UINT32_MAX)
+    {
+        span.duration = UINT32_MAX;
+    }
+    else
+    {
+        span.duration = (uint32_t)(currentTime - startTime);
+    }
+
+    contextP->trace.callback(&span, contextP->trace.userDataP, contextP);
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_set_trace_callback(iowa_context_t contextP,
+                                      uint32_t samplingPeriod,
+                                      iowa_trace_callback_t traceCb,
+                                      void *userDataP)
+{
+    IOWA_LOG_ARG_INFO(IOWA_PART_BASE, "Setting the trace callback with a sampling period of %u.", samplingPeriod);
+
+    CRIT_SECTION_ENTER(contextP);
+
+    contextP->trace.callback = traceCb;
+    contextP->trace.userDataP = userDataP;
+    contextP->trace.samplingPeriod = samplingPeriod;
+    // Trace the next datagram or notification
+    contextP->trace.sampleCounter = samplingPeriod;
+    contextP->trace.currentId = 0;
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_TRACE_SUPPORT
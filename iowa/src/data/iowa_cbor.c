@@ -26,4 +26,1071 @@
 
 #include "iowa_prv_data_internals.h"
 #include <float.h>
+#include <math.h>
 
+#if defined(LWM2M_SUPPORT_CBOR) || defined(LWM2M_SUPPORT_SENML_CBOR) || defined(LWM2M_SUPPORT_LWM2M_CBOR) || defined(IOWA_COAP_OSCORE_SUPPORT)
+
+#define PRV_CBOR_SIMPLE_VALUE_FALSE     20
+#define PRV_CBOR_SIMPLE_VALUE_TRUE      21
+#define PRV_CBOR_SIMPLE_VALUE_NULL      22
+#define PRV_CBOR_SIMPLE_VALUE_UNDEFINED 23
+
+#define PRV_CBOR_TAG_EPOCH_TIME         1
+
+#define PRV_CBOR_MAX_NESTING_LEVEL      16
+
+#define PRV_OBJECT_LINK_MAX_LENGTH      11 // "65535:65535"
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Write a big endian value of 'size' bytes
+static void prv_writeBigEndian(uint64_t value,
+                               size_t size,
+                               uint8_t *bufferP)
+{
+    while (size > 0)
+    {
+        size--;
+        bufferP[size] = (uint8_t)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+// Read a big endian value of 'size' bytes
+static uint64_t prv_readBigEndian(uint8_t *bufferP,
+                                  size_t size)
+{
+    uint64_t value;
+    size_t i;
+
+    value = 0;
+    for (i = 0; i < size; i++)
+    {
+        value = (value << 8) | bufferP[i];
+    }
+
+    return value;
+}
+
+// Check if a double can be stored in an half float without any loss
+// Returned value: true if the conversion is exact, false otherwise.
+// Parameters:
+// - number: the number to convert.
+// - halfFloatP: OUT. the half float bits.
+static bool prv_doubleToHalfFloat(double number,
+                                  uint16_t *halfFloatP)
+{
+    float singleNumber;
+    uint32_t bits;
+    uint32_t mantissa;
+    uint16_t sign;
+    int32_t exponent;
+
+    if (number != number)
+    {
+        // NaN
+        *halfFloatP = 0x7E00;
+        return true;
+    }
+
+    if (number > FLT_MAX || number < -FLT_MAX)
+    {
+        if (number == (double)INFINITY)
+        {
+            *halfFloatP = 0x7C00;
+            return true;
+        }
+        if (number == -(double)INFINITY)
+        {
+            *halfFloatP = 0xFC00;
+            return true;
+        }
+        return false;
+    }
+
+    singleNumber = (float)number;
+    if ((double)singleNumber != number)
+    {
+        return false;
+    }
+
+    memcpy(&bits, &singleNumber, sizeof(bits));
+    sign = (uint16_t)((bits >> 16) & 0x8000);
+    exponent = (int32_t)((bits >> 23) & 0xFF);
+    mantissa = bits & 0x007FFFFF;
+
+    if (exponent == 0)
+    {
+        if (mantissa != 0)
+        {
+            // Single precision subnormal numbers are too small for half floats
+            return false;
+        }
+        *halfFloatP = sign;
+        return true;
+    }
+
+    exponent -= 127;
+    if (exponent > 15)
+    {
+        return false;
+    }
+    if (exponent >= -14)
+    {
+        if ((mantissa & 0x1FFF) != 0)
+        {
+            return false;
+        }
+        *halfFloatP = (uint16_t)(sign | (uint16_t)((exponent + 15) << 10) | (uint16_t)(mantissa >> 13));
+        return true;
+    }
+    if (exponent >= -24)
+    {
+        uint32_t shift;
+
+        // Half float subnormal number
+        mantissa |= 0x00800000;
+        shift = (uint32_t)(-exponent - 1);
+        if ((mantissa & ((1UL << shift) - 1)) != 0)
+        {
+            return false;
+        }
+        *halfFloatP = (uint16_t)(sign | (uint16_t)(mantissa >> shift));
+        return true;
+    }
+
+    return false;
+}
+
+// Check if a double can be stored in a single precision float without any loss
+static bool prv_isSingleFloat(double number)
+{
+    if (number != number)
+    {
+        return true;
+    }
+    if (number > FLT_MAX || number < -FLT_MAX)
+    {
+        return (number == (double)INFINITY || number == -(double)INFINITY);
+    }
+
+    return ((double)(float)number == number);
+}
+
+// Get the CBOR unsigned argument of an integer and its major type
+static major_type_t prv_integerToArgument(int64_t value,
+                                          uint64_t *argumentP)
+{
+    if (value < 0)
+    {
+        *argumentP = (uint64_t)(-(value + 1));
+        return CBOR_MAJOR_TYPE_NEGATIVE_INTEGER;
+    }
+
+    *argumentP = (uint64_t)value;
+    return CBOR_MAJOR_TYPE_UNSIGNED_INTEGER;
+}
+
+// Skip a CBOR item and all its sub-items
+static int8_t prv_skipItem(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           uint8_t level)
+{
+    major_type_t majorType;
+    uint64_t number;
+    uint64_t i;
+    size_t stringLength;
+
+    if (level > PRV_CBOR_MAX_NESTING_LEVEL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Too many nested items.");
+        return CBOR_ERROR;
+    }
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        return cborGetBufferToStringLength(majorType, number, &stringLength, bufferP, bufferLength, bufferIndexP);
+
+    case CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS:
+    case CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS:
+        if (number == CBOR_NUMBER_MAX)
+        {
+            while (*bufferIndexP < bufferLength
+                   && bufferP[*bufferIndexP] != CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+            {
+                if (prv_skipItem(bufferP, bufferLength, bufferIndexP, (uint8_t)(level + 1)) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+            }
+            if (*bufferIndexP >= bufferLength)
+            {
+                return CBOR_ERROR;
+            }
+            *bufferIndexP += 1;
+
+            return CBOR_NO_ERROR;
+        }
+
+        if (majorType == CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            if (number > (uint64_t)bufferLength)
+            {
+                return CBOR_ERROR;
+            }
+            number *= 2;
+        }
+        for (i = 0; i < number; i++)
+        {
+            if (prv_skipItem(bufferP, bufferLength, bufferIndexP, (uint8_t)(level + 1)) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+        return prv_skipItem(bufferP, bufferLength, bufferIndexP, (uint8_t)(level + 1));
+
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        switch (number)
+        {
+        case CBOR_ADD_INFO_2_BYTES:
+            stringLength = CBOR_BYTE_2_SIZE;
+            break;
+
+        case CBOR_ADD_INFO_4_BYTES:
+            stringLength = CBOR_BYTE_4_SIZE;
+            break;
+
+        case CBOR_ADD_INFO_8_BYTES:
+            stringLength = CBOR_BYTE_8_SIZE;
+            break;
+
+        case CBOR_ADD_INFO_VALUE_BREAK:
+            // A break outside of an indefinite length item
+            return CBOR_ERROR;
+
+        default:
+            stringLength = 0;
+        }
+        if (*bufferIndexP + stringLength > bufferLength)
+        {
+            return CBOR_ERROR;
+        }
+        *bufferIndexP += stringLength;
+        return CBOR_NO_ERROR;
+
+    default:
+        return CBOR_ERROR;
+    }
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+int8_t cborAddStringToBuffer(uint8_t *stringP,
+                             size_t stringSize,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP,
+                             bool isByteString)
+{
+    assert(stringP != NULL || stringSize == 0);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (cborAddNumberToBuffer(isByteString == true ? CBOR_MAJOR_TYPE_BYTE_STRING : CBOR_MAJOR_TYPE_TEXT_STRING, stringSize, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    if (*bufferIndexP + stringSize > bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Buffer is too small.");
+        return CBOR_ERROR;
+    }
+
+    if (stringSize != 0)
+    {
+        memcpy(bufferP + *bufferIndexP, stringP, stringSize);
+        *bufferIndexP += stringSize;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetNumberToBufferLength(uint64_t number)
+{
+    if (number < CBOR_ADD_INFO_1_BYTE)
+    {
+        return 1;
+    }
+    if (number <= UINT8_MAX)
+    {
+        return 1 + CBOR_BYTE_1_SIZE;
+    }
+    if (number <= UINT16_MAX)
+    {
+        return 1 + CBOR_BYTE_2_SIZE;
+    }
+    if (number <= UINT32_MAX)
+    {
+        return 1 + CBOR_BYTE_4_SIZE;
+    }
+    return 1 + CBOR_BYTE_8_SIZE;
+}
+
+int8_t cborAddNumberToBuffer(major_type_t majorType,
+                             uint64_t number,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    size_t length;
+    uint8_t addInfo;
+
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    length = cborGetNumberToBufferLength(number);
+    if (*bufferIndexP + length > bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Buffer is too small.");
+        return CBOR_ERROR;
+    }
+
+    switch (length)
+    {
+    case 1:
+        addInfo = (uint8_t)number;
+        break;
+
+    case 1 + CBOR_BYTE_1_SIZE:
+        addInfo = CBOR_ADD_INFO_1_BYTE;
+        break;
+
+    case 1 + CBOR_BYTE_2_SIZE:
+        addInfo = CBOR_ADD_INFO_2_BYTES;
+        break;
+
+    case 1 + CBOR_BYTE_4_SIZE:
+        addInfo = CBOR_ADD_INFO_4_BYTES;
+        break;
+
+    default:
+        addInfo = CBOR_ADD_INFO_8_BYTES;
+        break;
+    }
+
+    bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, addInfo);
+    prv_writeBigEndian(number, length - 1, bufferP + *bufferIndexP + 1);
+    *bufferIndexP += length;
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetFloatToBufferLength(double number)
+{
+    uint16_t halfFloat;
+
+    // Use the smallest encoding preserving the value
+    if (prv_doubleToHalfFloat(number, &halfFloat) == true)
+    {
+        return 1 + CBOR_BYTE_2_SIZE;
+    }
+    if (prv_isSingleFloat(number) == true)
+    {
+        return 1 + CBOR_BYTE_4_SIZE;
+    }
+    return 1 + CBOR_BYTE_8_SIZE;
+}
+
+int8_t cborAddFloatToBuffer(double number,
+                            uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *bufferIndexP)
+{
+    uint16_t halfFloat;
+    size_t length;
+
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    length = cborGetFloatToBufferLength(number);
+    if (*bufferIndexP + length > bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Buffer is too small.");
+        return CBOR_ERROR;
+    }
+
+    switch (length)
+    {
+    case 1 + CBOR_BYTE_2_SIZE:
+        (void)prv_doubleToHalfFloat(number, &halfFloat);
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_2_BYTES);
+        prv_writeBigEndian(halfFloat, CBOR_BYTE_2_SIZE, bufferP + *bufferIndexP + 1);
+        break;
+
+    case 1 + CBOR_BYTE_4_SIZE:
+    {
+        float singleNumber;
+        uint32_t bits;
+
+        singleNumber = (float)number;
+        memcpy(&bits, &singleNumber, sizeof(bits));
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_4_BYTES);
+        prv_writeBigEndian(bits, CBOR_BYTE_4_SIZE, bufferP + *bufferIndexP + 1);
+        break;
+    }
+
+    default:
+    {
+        uint64_t bits;
+
+        memcpy(&bits, &number, sizeof(bits));
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_8_BYTES);
+        prv_writeBigEndian(bits, CBOR_BYTE_8_SIZE, bufferP + *bufferIndexP + 1);
+        break;
+    }
+    }
+
+    *bufferIndexP += length;
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetDataToBufferLength(iowa_lwm2m_data_t *dataP)
+{
+    uint64_t argument;
+    size_t length;
+
+    assert(dataP != NULL);
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        return cborGetNumberToBufferLength(dataP->value.asBuffer.length) + dataP->value.asBuffer.length;
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        (void)prv_integerToArgument(dataP->value.asInteger, &argument);
+        return cborGetNumberToBufferLength(argument);
+
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        return cborGetNumberToBufferLength((uint64_t)dataP->value.asInteger);
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        return cborGetFloatToBufferLength(dataP->value.asFloat);
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        return 1;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        length = dataUtilsObjectLinkToBufferLength(dataP);
+        return cborGetNumberToBufferLength(length) + length;
+
+    default:
+        return 0;
+    }
+}
+
+int8_t cborAddDataToBuffer(iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    major_type_t majorType;
+    uint64_t argument;
+
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        return cborAddStringToBuffer(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, bufferP, bufferLength, bufferIndexP, false);
+
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        return cborAddStringToBuffer(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, bufferP, bufferLength, bufferIndexP, true);
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        majorType = prv_integerToArgument(dataP->value.asInteger, &argument);
+        return cborAddNumberToBuffer(majorType, argument, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)dataP->value.asInteger, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        return cborAddFloatToBuffer(dataP->value.asFloat, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        if (*bufferIndexP + 1 > bufferLength)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Buffer is too small.");
+            return CBOR_ERROR;
+        }
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, dataP->value.asBoolean == true ? PRV_CBOR_SIMPLE_VALUE_TRUE : PRV_CBOR_SIMPLE_VALUE_FALSE);
+        *bufferIndexP += 1;
+        return CBOR_NO_ERROR;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+    {
+        uint8_t objectLink[PRV_OBJECT_LINK_MAX_LENGTH];
+        size_t length;
+
+        length = dataUtilsObjectLinkToBuffer(dataP, objectLink, PRV_OBJECT_LINK_MAX_LENGTH);
+        if (length == 0)
+        {
+            return CBOR_ERROR;
+        }
+        return cborAddStringToBuffer(objectLink, length, bufferP, bufferLength, bufferIndexP, false);
+    }
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported data type: %s.", STR_LWM2M_TYPE(dataP->type));
+        return CBOR_ERROR;
+    }
+}
+
+int8_t cborSkipItem(uint8_t *bufferP,
+                    size_t bufferLength,
+                    size_t *bufferIndexP)
+{
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    return prv_skipItem(bufferP, bufferLength, bufferIndexP, 0);
+}
+
+major_type_t cborPutBufferToNumber(uint64_t *numberP,
+                                   uint8_t *bufferNumberP,
+                                   size_t bufferLength,
+                                   size_t *bufferIndexP)
+{
+    major_type_t majorType;
+    uint8_t addInfo;
+    size_t length;
+
+    assert(numberP != NULL);
+    assert(bufferNumberP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (*bufferIndexP >= bufferLength)
+    {
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    majorType = (major_type_t)((bufferNumberP[*bufferIndexP] & CBOR_MAJOR_TYPE_MASK) >> CBOR_MAJOR_TYPE_BIT_SHIFT);
+    addInfo = bufferNumberP[*bufferIndexP] & CBOR_ADD_INFO_MASK;
+    *bufferIndexP += 1;
+
+    if (majorType == CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA)
+    {
+        // The floating point values are read by cborGetValueFromFloatMajorType()
+        if (addInfo == CBOR_ADD_INFO_1_BYTE)
+        {
+            if (*bufferIndexP >= bufferLength)
+            {
+                return CBOR_MAJOR_TYPE_NONE;
+            }
+            *numberP = bufferNumberP[*bufferIndexP];
+            *bufferIndexP += 1;
+        }
+        else if (addInfo > CBOR_ADD_INFO_8_BYTES
+                 && addInfo != CBOR_ADD_INFO_VALUE_BREAK)
+        {
+            return CBOR_MAJOR_TYPE_NONE;
+        }
+        else
+        {
+            *numberP = addInfo;
+        }
+
+        return majorType;
+    }
+
+    switch (addInfo)
+    {
+    case CBOR_ADD_INFO_1_BYTE:
+        length = CBOR_BYTE_1_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_2_BYTES:
+        length = CBOR_BYTE_2_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_4_BYTES:
+        length = CBOR_BYTE_4_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_8_BYTES:
+        length = CBOR_BYTE_8_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_VALUE_BREAK:
+        if (majorType < CBOR_MAJOR_TYPE_BYTE_STRING
+            || majorType > CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            return CBOR_MAJOR_TYPE_NONE;
+        }
+        // Indefinite length
+        *numberP = CBOR_NUMBER_MAX;
+        return majorType;
+
+    default:
+        if (addInfo > CBOR_ADD_INFO_8_BYTES)
+        {
+            return CBOR_MAJOR_TYPE_NONE;
+        }
+        *numberP = addInfo;
+        return majorType;
+    }
+
+    if (*bufferIndexP + length > bufferLength)
+    {
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    *numberP = prv_readBigEndian(bufferNumberP + *bufferIndexP, length);
+    *bufferIndexP += length;
+
+    return majorType;
+}
+
+int8_t cborGetBufferToStringLength(major_type_t majorType,
+                                   uint64_t convertResult,
+                                   size_t *stringLengthP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   size_t *bufferIndexP)
+{
+    major_type_t chunkMajorType;
+    uint64_t chunkLength;
+
+    assert(majorType == CBOR_MAJOR_TYPE_BYTE_STRING || majorType == CBOR_MAJOR_TYPE_TEXT_STRING);
+    assert(stringLengthP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (convertResult != CBOR_NUMBER_MAX)
+    {
+        if (convertResult > bufferLength - *bufferIndexP)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "String is longer than the buffer.");
+            return CBOR_ERROR;
+        }
+        *stringLengthP = (size_t)convertResult;
+        *bufferIndexP += *stringLengthP;
+
+        return CBOR_NO_ERROR;
+    }
+
+    // Indefinite length string: a sequence of definite length chunks of the same major type terminated by a break
+    *stringLengthP = 0;
+    while (*bufferIndexP < bufferLength
+           && bufferP[*bufferIndexP] != CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+    {
+        chunkMajorType = cborPutBufferToNumber(&chunkLength, bufferP, bufferLength, bufferIndexP);
+        if (chunkMajorType != majorType
+            || chunkLength == CBOR_NUMBER_MAX
+            || chunkLength > bufferLength - *bufferIndexP)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid string chunk.");
+            return CBOR_ERROR;
+        }
+        *stringLengthP += (size_t)chunkLength;
+        *bufferIndexP += (size_t)chunkLength;
+    }
+    if (*bufferIndexP >= bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Break not found.");
+        return CBOR_ERROR;
+    }
+    *bufferIndexP += 1;
+
+    return CBOR_NO_ERROR_INDEFINITE;
+}
+
+int8_t cborPutBufferToString(major_type_t majorType,
+                             uint64_t convertResult,
+                             uint8_t **stringP,
+                             size_t *stringLengthP,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    int8_t result;
+    size_t endIndex;
+    size_t stringIndex;
+    uint64_t chunkLength;
+
+    assert(stringP != NULL);
+    assert(stringLengthP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    *stringP = NULL;
+
+    endIndex = *bufferIndexP;
+    result = cborGetBufferToStringLength(majorType, convertResult, stringLengthP, bufferP, bufferLength, &endIndex);
+    if (result <= CBOR_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    if (*stringLengthP != 0)
+    {
+        *stringP = (uint8_t *)iowa_system_malloc(*stringLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (*stringP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(*stringLengthP);
+            return CBOR_ERROR;
+        }
+#endif
+
+        if (result == CBOR_NO_ERROR)
+        {
+            memcpy(*stringP, bufferP + *bufferIndexP, *stringLengthP);
+        }
+        else
+        {
+            // Chunks were already checked by cborGetBufferToStringLength()
+            stringIndex = 0;
+            while (stringIndex < *stringLengthP)
+            {
+                (void)cborPutBufferToNumber(&chunkLength, bufferP, bufferLength, bufferIndexP);
+                memcpy(*stringP + stringIndex, bufferP + *bufferIndexP, (size_t)chunkLength);
+                stringIndex += (size_t)chunkLength;
+                *bufferIndexP += (size_t)chunkLength;
+            }
+        }
+    }
+
+    *bufferIndexP = endIndex;
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborGetValueFromFloatMajorType(uint64_t convertResult,
+                                      iowa_lwm2m_data_t *dataP,
+                                      uint8_t *bufferP,
+                                      size_t bufferLength,
+                                      size_t *bufferIndexP)
+{
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    switch (convertResult)
+    {
+    case PRV_CBOR_SIMPLE_VALUE_FALSE:
+    case PRV_CBOR_SIMPLE_VALUE_TRUE:
+        dataP->type = IOWA_LWM2M_TYPE_BOOLEAN;
+        dataP->value.asBoolean = (convertResult == PRV_CBOR_SIMPLE_VALUE_TRUE);
+        break;
+
+    case PRV_CBOR_SIMPLE_VALUE_NULL:
+    case PRV_CBOR_SIMPLE_VALUE_UNDEFINED:
+        dataP->type = IOWA_LWM2M_TYPE_NULL;
+        break;
+
+    case CBOR_ADD_INFO_2_BYTES:
+        if (*bufferIndexP + CBOR_BYTE_2_SIZE > bufferLength)
+        {
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = (double)dataUtilsConvertHalfFloatToFloat((uint16_t)prv_readBigEndian(bufferP + *bufferIndexP, CBOR_BYTE_2_SIZE));
+        *bufferIndexP += CBOR_BYTE_2_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_4_BYTES:
+    {
+        uint32_t bits;
+        float singleNumber;
+
+        if (*bufferIndexP + CBOR_BYTE_4_SIZE > bufferLength)
+        {
+            return CBOR_ERROR;
+        }
+        bits = (uint32_t)prv_readBigEndian(bufferP + *bufferIndexP, CBOR_BYTE_4_SIZE);
+        memcpy(&singleNumber, &bits, sizeof(singleNumber));
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = (double)singleNumber;
+        *bufferIndexP += CBOR_BYTE_4_SIZE;
+        break;
+    }
+
+    case CBOR_ADD_INFO_8_BYTES:
+    {
+        uint64_t bits;
+
+        if (*bufferIndexP + CBOR_BYTE_8_SIZE > bufferLength)
+        {
+            return CBOR_ERROR;
+        }
+        bits = prv_readBigEndian(bufferP + *bufferIndexP, CBOR_BYTE_8_SIZE);
+        memcpy(&(dataP->value.asFloat), &bits, sizeof(bits));
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        *bufferIndexP += CBOR_BYTE_8_SIZE;
+        break;
+    }
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported simple value: %u.", (unsigned int)convertResult);
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborPutBufferToData(major_type_t majorType,
+                           uint64_t convertResult,
+                           iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+        if (convertResult > INT64_MAX)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Integer value is too big.");
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+        dataP->value.asInteger = (int64_t)convertResult;
+        break;
+
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        if (convertResult > INT64_MAX)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Integer value is too small.");
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+        dataP->value.asInteger = -1 - (int64_t)convertResult;
+        break;
+
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        if (cborPutBufferToString(majorType, convertResult, &(dataP->value.asBuffer.buffer), &(dataP->value.asBuffer.length), bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        dataP->type = (majorType == CBOR_MAJOR_TYPE_BYTE_STRING) ? IOWA_LWM2M_TYPE_OPAQUE : IOWA_LWM2M_TYPE_STRING;
+        break;
+
+    case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+    {
+        major_type_t taggedMajorType;
+        uint64_t taggedNumber;
+
+        if (convertResult == CBOR_ADD_INFO_DECIMAL_FRAC)
+        {
+            return cborHandleDecimalFraction(dataP, bufferP, bufferLength, bufferIndexP);
+        }
+
+        // Other tags are only hints on the tagged item
+        taggedMajorType = cborPutBufferToNumber(&taggedNumber, bufferP, bufferLength, bufferIndexP);
+        if (taggedMajorType == CBOR_MAJOR_TYPE_NONE
+            || taggedMajorType == CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC)
+        {
+            return CBOR_ERROR;
+        }
+        if (cborPutBufferToData(taggedMajorType, taggedNumber, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        if (convertResult == PRV_CBOR_TAG_EPOCH_TIME
+            && dataP->type == IOWA_LWM2M_TYPE_INTEGER)
+        {
+            dataP->type = IOWA_LWM2M_TYPE_TIME;
+        }
+        break;
+    }
+
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        return cborGetValueFromFloatMajorType(convertResult, dataP, bufferP, bufferLength, bufferIndexP);
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unexpected major type: %d.", majorType);
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborHandleDecimalFraction(iowa_lwm2m_data_t *dataP,
+                                 uint8_t *bufferP,
+                                 size_t bufferLength,
+                                 size_t *bufferIndexP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    int64_t exponent;
+    int64_t mantissa;
+
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferIndexP != NULL);
+
+    // A decimal fraction is an array [exponent, mantissa] with value = mantissa * 10^exponent
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if (majorType != CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS
+        || number != CBOR_DECIMAL_FRAC_ARRAY_LENGTH)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid decimal fraction.");
+        return CBOR_ERROR;
+    }
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if (cborPutBufferToData(majorType, number, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+        || dataP->type != IOWA_LWM2M_TYPE_INTEGER)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid decimal fraction exponent.");
+        return CBOR_ERROR;
+    }
+    exponent = dataP->value.asInteger;
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if (cborPutBufferToData(majorType, number, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+        || dataP->type != IOWA_LWM2M_TYPE_INTEGER)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid decimal fraction mantissa.");
+        return CBOR_ERROR;
+    }
+    mantissa = dataP->value.asInteger;
+
+    dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+    dataP->value.asFloat = (double)mantissa * dataUtilsPower(10, exponent);
+
+    return CBOR_NO_ERROR;
+}
+
+#endif // LWM2M_SUPPORT_CBOR || LWM2M_SUPPORT_SENML_CBOR || LWM2M_SUPPORT_LWM2M_CBOR || IOWA_COAP_OSCORE_SUPPORT
+
+#ifdef LWM2M_SUPPORT_CBOR
+
+iowa_status_t cborSerialize(iowa_lwm2m_data_t *dataP,
+                            uint8_t **bufferP,
+                            size_t *bufferLengthP)
+{
+    size_t index;
+
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "type: %s", STR_LWM2M_TYPE(dataP->type));
+
+    *bufferP = NULL;
+    *bufferLengthP = cborGetDataToBufferLength(dataP);
+    if (*bufferLengthP == 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported data type: %s.", STR_LWM2M_TYPE(dataP->type));
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(*bufferLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(*bufferLengthP);
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    index = 0;
+    if (cborAddDataToBuffer(dataP, *bufferP, *bufferLengthP, &index) != CBOR_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t cborDeserialize(iowa_lwm2m_uri_t *baseUriP,
+                              uint8_t *bufferP,
+                              size_t bufferLength,
+                              iowa_lwm2m_data_t **dataP,
+                              size_t *dataCountP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    size_t index;
+
+    assert(dataP != NULL);
+    assert(dataCountP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "bufferLength: %u", bufferLength);
+
+    if (baseUriP == NULL
+        || baseUriP->resourceId == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "CBOR payload must target a resource.");
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+    }
+    if (bufferP == NULL
+        || bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Empty payload.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, sizeof(iowa_lwm2m_data_t));
+    dataUtilsSetUri(*dataP, baseUriP);
+
+    index = 0;
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, &index);
+    if (majorType == CBOR_MAJOR_TYPE_NONE
+        || cborPutBufferToData(majorType, number, *dataP, bufferP, bufferLength, &index) != CBOR_NO_ERROR
+        || index != bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid CBOR payload.");
+        dataLwm2mFree(1, *dataP);
+        *dataP = NULL;
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataCountP = 1;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // LWM2M_SUPPORT_CBOR
@@ -60,6 +60,86 @@ static void prv_dataInsertionSortSmallToLarge(size_t dataCount,
     }
 }
 
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+// Compare the URIs of two data
+// Returned value: negative, zero or positive if the URI of the first data is lower, equal or greater than the second one.
+static int prv_dataCompareUri(iowa_lwm2m_data_t *firstP,
+                              iowa_lwm2m_data_t *secondP)
+{
+    if (firstP->objectID != secondP->objectID)
+    {
+        return (int)firstP->objectID - (int)secondP->objectID;
+    }
+    if (firstP->instanceID != secondP->instanceID)
+    {
+        return (int)firstP->instanceID - (int)secondP->instanceID;
+    }
+    if (firstP->resourceID != secondP->resourceID)
+    {
+        return (int)firstP->resourceID - (int)secondP->resourceID;
+    }
+    return (int)firstP->resInstanceID - (int)secondP->resInstanceID;
+}
+
+// Sort the data by URI for the formats encoding the URI tree
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataP, dataCount: data to sort.
+// - sortedDataP: OUT. dataP if already sorted, else a dynamically allocated sorted copy of dataP.
+static iowa_status_t prv_dataSortByUri(iowa_lwm2m_data_t *dataP,
+                                       size_t dataCount,
+                                       iowa_lwm2m_data_t **sortedDataP)
+{
+    size_t indTolook;
+    size_t indToCompare;
+    iowa_lwm2m_data_t dataCurrent;
+
+    *sortedDataP = dataP;
+
+    // Most of the time, the data are read in order
+    for (indTolook = 1; indTolook < dataCount; indTolook++)
+    {
+        if (prv_dataCompareUri(&dataP[indTolook - 1], &dataP[indTolook]) > 0)
+        {
+            break;
+        }
+    }
+    if (indTolook >= dataCount)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    *sortedDataP = (iowa_lwm2m_data_t *)iowa_system_malloc(dataCount * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*sortedDataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(dataCount * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memcpy(*sortedDataP, dataP, dataCount * sizeof(iowa_lwm2m_data_t));
+
+    for (; indTolook < dataCount; indTolook++)
+    {
+        memcpy(&dataCurrent, &(*sortedDataP)[indTolook], sizeof(iowa_lwm2m_data_t));
+
+        for (indToCompare = indTolook; indToCompare > 0; indToCompare--)
+        {
+            if (prv_dataCompareUri(&(*sortedDataP)[indToCompare - 1], &dataCurrent) <= 0)
+            {
+                break;
+            }
+
+            memcpy(&(*sortedDataP)[indToCompare], &(*sortedDataP)[indToCompare - 1], sizeof(iowa_lwm2m_data_t));
+        }
+
+        memcpy(&(*sortedDataP)[indToCompare], &dataCurrent, sizeof(iowa_lwm2m_data_t));
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -98,7 +178,7 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     iowa_lwm2m_data_t *sortedDataP;
     size_t sortedDataCount;
 
-#if !defined(LWM2M_SUPPORT_TLV) && !defined(LWM2M_SUPPORT_JSON)
+#if !defined(LWM2M_SUPPORT_TLV) && !defined(LWM2M_SUPPORT_JSON) && !defined(LWM2M_SUPPORT_LWM2M_CBOR)
     (void)baseUriP;
 #endif
 
@@ -138,12 +218,43 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
         }
         break;
 
+#ifdef LWM2M_SUPPORT_CBOR
+    case IOWA_CONTENT_FORMAT_CBOR:
+        if (dataCount != 1)
+        {
+            *contentFormatP = LWM2M_DEFAULT_CONTENT_FORMAT;
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Single content format cannot be used for multiple resources. New content format: %s.", STR_MEDIA_TYPE(*contentFormatP));
+        }
+        else if (dataP[0].resourceID == IOWA_LWM2M_ID_ALL
+                 || (dataP[0].resInstanceID != IOWA_LWM2M_ID_ALL && baseUriP != NULL && baseUriP->resInstanceId == IOWA_LWM2M_ID_ALL))
+        {
+            *contentFormatP = LWM2M_DEFAULT_CONTENT_FORMAT;
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Requested format is not acceptable. New content format: %s.", STR_MEDIA_TYPE(*contentFormatP));
+        }
+        break;
+#endif
+
 #ifdef LWM2M_SUPPORT_TLV
     case IOWA_CONTENT_FORMAT_TLV_OLD:
     case IOWA_CONTENT_FORMAT_TLV:
         break;
 #endif
 
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    case IOWA_CONTENT_FORMAT_SENML_JSON:
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
+        break;
+#endif
+
     default:
         *contentFormatP = LWM2M_DEFAULT_CONTENT_FORMAT;
         IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "New content format: %s.", STR_MEDIA_TYPE(*contentFormatP));
@@ -152,6 +263,16 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     // Check the data
     sortedDataP = dataP;
     sortedDataCount = dataCount;
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    if (IOWA_CONTENT_FORMAT_LWM2M_CBOR == *contentFormatP)
+    {
+        result = prv_dataSortByUri(dataP, dataCount, &sortedDataP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+    }
+#endif
 
     // Serialize the data
     if (IOWA_CONTENT_FORMAT_TEXT == *contentFormatP)
@@ -162,12 +283,36 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     {
         result = opaqueSerialize(sortedDataP, bufferP, bufferLengthP);
     }
+#ifdef LWM2M_SUPPORT_CBOR
+    else if (IOWA_CONTENT_FORMAT_CBOR == *contentFormatP)
+    {
+        result = cborSerialize(sortedDataP, bufferP, bufferLengthP);
+    }
+#endif
 #ifdef LWM2M_SUPPORT_TLV
     else if (IOWA_CONTENT_FORMAT_TLV_OLD == *contentFormatP
              || IOWA_CONTENT_FORMAT_TLV == *contentFormatP)
     {
         result = tlvSerialize(baseUriP, sortedDataP, sortedDataCount, bufferP, bufferLengthP);
     }
+#endif
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    else if (IOWA_CONTENT_FORMAT_SENML_JSON == *contentFormatP)
+    {
+        result = senmlJsonSerialize(sortedDataP, sortedDataCount, bufferP, bufferLengthP);
+    }
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    else if (IOWA_CONTENT_FORMAT_SENML_CBOR == *contentFormatP)
+    {
+        result = senmlCborSerialize(sortedDataP, sortedDataCount, bufferP, bufferLengthP);
+    }
+#endif
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    else if (IOWA_CONTENT_FORMAT_LWM2M_CBOR == *contentFormatP)
+    {
+        result = lwm2mCborSerialize(baseUriP, sortedDataP, sortedDataCount, bufferP, bufferLengthP);
+    }
 #endif
     else
     {
@@ -175,6 +320,11 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
         result = IOWA_COAP_400_BAD_REQUEST;
     }
 
+    if (sortedDataP != dataP)
+    {
+        iowa_system_free(sortedDataP);
+    }
+
     if (result != IOWA_COAP_NO_ERROR)
     {
         *bufferP = NULL;
@@ -186,6 +336,52 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     return result;
 }
 
+iowa_status_t dataLwm2mSerializeToSink(iowa_lwm2m_uri_t *baseUriP,
+                                       iowa_lwm2m_data_t *dataP,
+                                       size_t dataCount,
+                                       iowa_content_format_t *contentFormatP,
+                                       data_sink_t *sinkP)
+{
+    iowa_status_t result;
+    uint8_t *bufferP;
+    size_t bufferLength;
+
+    assert(contentFormatP != NULL);
+    assert(sinkP != NULL);
+    assert((dataP != NULL && dataCount != 0) || (dataCount == 0));
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Entering: dataP: %p, dataCount: %u, contentFormatP: %s.", dataP, dataCount, STR_MEDIA_TYPE(*contentFormatP));
+
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    if (IOWA_CONTENT_FORMAT_SENML_JSON == *contentFormatP
+        && dataCount != 0)
+    {
+        // Stream the records without building the whole payload
+        result = senmlJsonSerializeToSink(dataP, dataCount, sinkP);
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            result = dataSinkFlush(sinkP);
+        }
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Exiting with result: %u.%02u, totalLength: %zu.", (result & 0xFF) >> 5, (result & 0x1F), sinkP->totalLength);
+
+        return result;
+    }
+#endif
+
+    result = dataLwm2mSerialize(baseUriP, dataP, dataCount, contentFormatP, &bufferP, &bufferLength);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        dataSinkWrite(sinkP, bufferP, bufferLength);
+        iowa_system_free(bufferP);
+        result = dataSinkFlush(sinkP);
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Exiting with result: %u.%02u, totalLength: %zu.", (result & 0xFF) >> 5, (result & 0x1F), sinkP->totalLength);
+
+    return result;
+}
+
 iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
                                    uint8_t *bufferP,
                                    size_t bufferLength,
@@ -215,6 +411,12 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
         result = opaqueDeserialize(baseUriP, bufferP, bufferLength, dataP, dataCountP);
         break;
 
+#ifdef LWM2M_SUPPORT_CBOR
+    case IOWA_CONTENT_FORMAT_CBOR:
+        result = cborDeserialize(baseUriP, bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
 #ifdef LWM2M_SUPPORT_TLV
     case IOWA_CONTENT_FORMAT_TLV_OLD:
     case IOWA_CONTENT_FORMAT_TLV:
@@ -222,6 +424,24 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
         break;
 #endif
 
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    case IOWA_CONTENT_FORMAT_SENML_JSON:
+        result = senmlJsonDeserialize(bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        result = senmlCborDeserialize(bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
+        result = lwm2mCborDeserialize(baseUriP, bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
     default:
         IOWA_LOG_ARG_ERROR(IOWA_PART_DATA, "Content format %s is not supported.", STR_MEDIA_TYPE(contentFormat));
         result = IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
@@ -239,6 +459,165 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
     return result;
 }
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+iowa_status_t dataTemplateInit(iowa_lwm2m_data_t *dataP,
+                               size_t dataCount,
+                               size_t slotCount,
+                               const size_t *slotDataIndexArray,
+                               data_template_t *templateP)
+{
+    iowa_status_t result;
+    size_t *valueIndexArray;
+    data_template_slot_t slot;
+    size_t i;
+    size_t j;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "dataCount: %u, slotCount: %u.", dataCount, slotCount);
+
+    memset(templateP, 0, sizeof(data_template_t));
+
+    for (i = 0; i < slotCount; i++)
+    {
+        if (slotDataIndexArray[i] >= dataCount)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Slot #%u is out of the data.", i);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        if (dataP[slotDataIndexArray[i]].type == IOWA_LWM2M_TYPE_URI_ONLY
+            || dataP[slotDataIndexArray[i]].type == IOWA_LWM2M_TYPE_NULL)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Slot #%u has no value.", i);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+    }
+
+    valueIndexArray = (size_t *)iowa_system_malloc(dataCount * sizeof(size_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (valueIndexArray == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(dataCount * sizeof(size_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    if (slotCount != 0)
+    {
+        templateP->slotArray = (data_template_slot_t *)iowa_system_malloc(slotCount * sizeof(data_template_slot_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (templateP->slotArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(slotCount * sizeof(data_template_slot_t));
+            iowa_system_free(valueIndexArray);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+    }
+
+    result = senmlCborSerializeWithValueIndexes(dataP, dataCount, valueIndexArray, &(templateP->bufferP), &(templateP->bufferLength));
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto exit;
+    }
+
+    // Keep the slots sorted by offset to serialize the template in one pass
+    for (i = 0; i < slotCount; i++)
+    {
+        slot.offset = valueIndexArray[slotDataIndexArray[i]];
+        slot.length = cborGetDataToBufferLength(dataP + slotDataIndexArray[i]);
+        slot.valueIndex = i;
+        slot.type = dataP[slotDataIndexArray[i]].type;
+
+        for (j = i; j > 0 && templateP->slotArray[j - 1].offset >= slot.offset; j--)
+        {
+            if (templateP->slotArray[j - 1].offset == slot.offset)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Slot #%u is a duplicate.", i);
+                result = IOWA_COAP_400_BAD_REQUEST;
+                goto exit;
+            }
+            templateP->slotArray[j] = templateP->slotArray[j - 1];
+        }
+        templateP->slotArray[j] = slot;
+    }
+    templateP->slotCount = slotCount;
+
+exit:
+    iowa_system_free(valueIndexArray);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        dataTemplateFree(templateP);
+    }
+
+    return result;
+}
+
+iowa_status_t dataTemplateSerialize(data_template_t *templateP,
+                                    iowa_lwm2m_data_t *valueArray,
+                                    uint8_t **bufferP,
+                                    size_t *bufferLengthP)
+{
+    size_t length;
+    size_t index;
+    size_t templateIndex;
+    size_t i;
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    length = templateP->bufferLength;
+    for (i = 0; i < templateP->slotCount; i++)
+    {
+        iowa_lwm2m_data_t *valueP;
+
+        valueP = valueArray + templateP->slotArray[i].valueIndex;
+        if (valueP->type != templateP->slotArray[i].type)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Value #%u type is %s instead of %s.", templateP->slotArray[i].valueIndex, STR_LWM2M_TYPE(valueP->type), STR_LWM2M_TYPE(templateP->slotArray[i].type));
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+        length = length - templateP->slotArray[i].length + cborGetDataToBufferLength(valueP);
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    index = 0;
+    templateIndex = 0;
+    for (i = 0; i < templateP->slotCount; i++)
+    {
+        memcpy(*bufferP + index, templateP->bufferP + templateIndex, templateP->slotArray[i].offset - templateIndex);
+        index += templateP->slotArray[i].offset - templateIndex;
+
+        if (cborAddDataToBuffer(valueArray + templateP->slotArray[i].valueIndex, *bufferP, length, &index) != CBOR_NO_ERROR)
+        {
+            iowa_system_free(*bufferP);
+            *bufferP = NULL;
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        templateIndex = templateP->slotArray[i].offset + templateP->slotArray[i].length;
+    }
+    memcpy(*bufferP + index, templateP->bufferP + templateIndex, templateP->bufferLength - templateIndex);
+
+    *bufferLengthP = length;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void dataTemplateFree(data_template_t *templateP)
+{
+    iowa_system_free(templateP->bufferP);
+    iowa_system_free(templateP->slotArray);
+    memset(templateP, 0, sizeof(data_template_t));
+}
+#endif // LWM2M_SUPPORT_SENML_CBOR
+
 iowa_status_t dataLwm2mConsolidate(size_t dataCount,
                                    iowa_lwm2m_data_t *dataArray,
                                    iowa_content_format_t contentFormat,
@@ -535,6 +914,8 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
                 {
                     float value;
 
+                    tmpP = dataArray[i].value.asBuffer.buffer;
+
                     utilsCopyValue(&value, dataArray[i].value.asBuffer.buffer, dataArray[i].value.asBuffer.length);
 
                     dataArray[i].value.asFloat = value;
@@ -543,6 +924,8 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
                 {
                     double value;
 
+                    tmpP = dataArray[i].value.asBuffer.buffer;
+
                     utilsCopyValue(&value, dataArray[i].value.asBuffer.buffer, dataArray[i].value.asBuffer.length);
 
                     dataArray[i].value.asFloat = value;
@@ -677,7 +1060,9 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
         }
         else if (IOWA_LWM2M_TYPE_UNDEFINED == type)
         {
-            if (contentFormat != IOWA_CONTENT_FORMAT_OPAQUE)
+            // Values decoded with their own type (e.g. CBOR integers) can not be turned into a raw buffer
+            if (contentFormat != IOWA_CONTENT_FORMAT_OPAQUE
+                && IOWA_LWM2M_TYPE_STRING == dataArray[i].type)
             {
                 dataArray[i].type = IOWA_LWM2M_TYPE_UNDEFINED;
             }
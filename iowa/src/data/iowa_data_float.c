@@ -0,0 +1,1663 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019-2021 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+/*************************************************************************************
+* This file converts floating point numbers to and from their shortest decimal text.
+*
+* The text is generated with the Grisu3 algorithm from F. Loitsch, "Printing
+* Floating-Point Numbers Quickly and Accurately with Integers". When Grisu3 cannot
+* prove its result, about 1% of random doubles, the digits are generated exactly
+* with big integers. The text is the shortest one reading back to the same double.
+*
+* The text is parsed with a fast path for exactly representable values, then a 64-bit
+* approximation with error tracking. When the approximation is too close to a halfway
+* point, the decimal value is compared exactly to it using big integers.
+*************************************************************************************/
+
+#include "iowa_prv_data_internals.h"
+
+#define PRV_DECIMAL_POINT   '.'
+#define PRV_EXPONENT_MIN    'e'
+#define PRV_EXPONENT_MAX    'E'
+#define PRV_MINUS_SIGN      '-'
+#define PRV_PLUS_SIGN       '+'
+
+// IEEE 754 double precision layout
+#define PRV_SIGN_MASK               0x8000000000000000ULL
+#define PRV_EXPONENT_MASK           0x7FF0000000000000ULL
+#define PRV_SIGNIFICAND_MASK        0x000FFFFFFFFFFFFFULL
+#define PRV_HIDDEN_BIT              0x0010000000000000ULL
+#define PRV_PHYSICAL_SIGNIFICAND    52
+#define PRV_SIGNIFICAND_SIZE        53
+#define PRV_EXPONENT_BIAS           (0x3FF + PRV_PHYSICAL_SIGNIFICAND)
+#define PRV_DENORMAL_EXPONENT       (-PRV_EXPONENT_BIAS + 1)
+#define PRV_MAX_EXPONENT            (0x7FF - PRV_EXPONENT_BIAS)
+
+#define PRV_DIY_FP_SIZE             64
+
+// Grisu3 target range of the binary exponent of the scaled value
+#define PRV_GRISU_ALPHA             (-60)
+#define PRV_GRISU_GAMMA             (-32)
+
+#define PRV_CACHED_POWERS_MIN_DEC_EXP   (-348)
+#define PRV_CACHED_POWERS_DEC_STEP      8
+
+// Generated digits: at most 17 digits are produced
+#define PRV_MAX_DIGIT_COUNT         20
+
+// Values with up to this number of decimals are formatted without Grisu3
+#define PRV_SHORT_DECIMAL_MAX_COUNT 6
+
+// Plain notation is used when the decimal point is in this range, as ECMAScript does
+#define PRV_PLAIN_MIN_POINT         (-5)
+#define PRV_PLAIN_MAX_POINT         21
+
+// Parsing limits
+#define PRV_MAX_MANTISSA_DIGITS     19  // Decimal digits always fitting in an uint64_t
+#define PRV_MAX_EXACT_INTEGER       (1ULL << PRV_SIGNIFICAND_SIZE)
+#define PRV_MAX_EXACT_POWER_OF_TEN  22
+#define PRV_MAX_DECIMAL_POINT       310   // 0.1e310 is above the largest double
+#define PRV_MIN_DECIMAL_POINT       (-324) // 0.9e-324 is below half of the smallest double
+#define PRV_MAX_EXPONENT_VALUE      100000
+#define PRV_ERROR_DENOMINATOR_LOG   3
+#define PRV_ERROR_DENOMINATOR       (1 << PRV_ERROR_DENOMINATOR_LOG)
+
+// Big integers used for the exact comparison: up to PRV_MAX_SIGNIFICANT_DIGITS
+// decimal digits scaled by 2^1075, or the halfway point scaled by 10^1104. The exact
+// formatting needs less.
+#define PRV_MAX_SIGNIFICANT_DIGITS  780
+#define PRV_BIGNUM_CAPACITY         128
+#define PRV_BIGNUM_POW10_STEP       9
+#define PRV_BIGNUM_POW10_STEP_VALUE 1000000000U
+
+typedef struct
+{
+    uint64_t f;
+    int e;
+} prv_diy_fp_t;
+
+typedef struct
+{
+    uint64_t f;
+    int16_t e;
+    int16_t k;
+} prv_cached_power_t;
+
+typedef struct
+{
+    bool isNegative;
+    const uint8_t *digitsP;     // The digits with the decimal point, without sign nor exponent
+    size_t digitsLength;
+    size_t digitCount;          // Count of significant digits
+    uint64_t mantissa;          // The first PRV_MAX_MANTISSA_DIGITS significant digits
+    bool isTruncated;           // Some of the other significant digits are not zero
+    bool roundUp;               // The first truncated digit is 5 or more
+    int64_t decimalPoint;       // The value is 0.d1d2d3... x 10^decimalPoint
+} prv_decimal_t;
+
+typedef struct
+{
+    uint32_t limbs[PRV_BIGNUM_CAPACITY];
+    size_t used;
+} prv_bignum_t;
+
+// Normalized powers of ten from 10^-348 to 10^340, rounded to nearest
+static const prv_cached_power_t s_cachedPowers[] =
+{
+    {0xFA8FD5A0081C0288ULL, -1220, -348},
+    {0xBAAEE17FA23EBF76ULL, -1193, -340},
+    {0x8B16FB203055AC76ULL, -1166, -332},
+    {0xCF42894A5DCE35EAULL, -1140, -324},
+    {0x9A6BB0AA55653B2DULL, -1113, -316},
+    {0xE61ACF033D1A45DFULL, -1087, -308},
+    {0xAB70FE17C79AC6CAULL, -1060, -300},
+    {0xFF77B1FCBEBCDC4FULL, -1034, -292},
+    {0xBE5691EF416BD60CULL, -1007, -284},
+    {0x8DD01FAD907FFC3CULL, -980, -276},
+    {0xD3515C2831559A83ULL, -954, -268},
+    {0x9D71AC8FADA6C9B5ULL, -927, -260},
+    {0xEA9C227723EE8BCBULL, -901, -252},
+    {0xAECC49914078536DULL, -874, -244},
+    {0x823C12795DB6CE57ULL, -847, -236},
+    {0xC21094364DFB5637ULL, -821, -228},
+    {0x9096EA6F3848984FULL, -794, -220},
+    {0xD77485CB25823AC7ULL, -768, -212},
+    {0xA086CFCD97BF97F4ULL, -741, -204},
+    {0xEF340A98172AACE5ULL, -715, -196},
+    {0xB23867FB2A35B28EULL, -688, -188},
+    {0x84C8D4DFD2C63F3BULL, -661, -180},
+    {0xC5DD44271AD3CDBAULL, -635, -172},
+    {0x936B9FCEBB25C996ULL, -608, -164},
+    {0xDBAC6C247D62A584ULL, -582, -156},
+    {0xA3AB66580D5FDAF6ULL, -555, -148},
+    {0xF3E2F893DEC3F126ULL, -529, -140},
+    {0xB5B5ADA8AAFF80B8ULL, -502, -132},
+    {0x87625F056C7C4A8BULL, -475, -124},
+    {0xC9BCFF6034C13053ULL, -449, -116},
+    {0x964E858C91BA2655ULL, -422, -108},
+    {0xDFF9772470297EBDULL, -396, -100},
+    {0xA6DFBD9FB8E5B88FULL, -369, -92},
+    {0xF8A95FCF88747D94ULL, -343, -84},
+    {0xB94470938FA89BCFULL, -316, -76},
+    {0x8A08F0F8BF0F156BULL, -289, -68},
+    {0xCDB02555653131B6ULL, -263, -60},
+    {0x993FE2C6D07B7FACULL, -236, -52},
+    {0xE45C10C42A2B3B06ULL, -210, -44},
+    {0xAA242499697392D3ULL, -183, -36},
+    {0xFD87B5F28300CA0EULL, -157, -28},
+    {0xBCE5086492111AEBULL, -130, -20},
+    {0x8CBCCC096F5088CCULL, -103, -12},
+    {0xD1B71758E219652CULL, -77, -4},
+    {0x9C40000000000000ULL, -50, 4},
+    {0xE8D4A51000000000ULL, -24, 12},
+    {0xAD78EBC5AC620000ULL, 3, 20},
+    {0x813F3978F8940984ULL, 30, 28},
+    {0xC097CE7BC90715B3ULL, 56, 36},
+    {0x8F7E32CE7BEA5C70ULL, 83, 44},
+    {0xD5D238A4ABE98068ULL, 109, 52},
+    {0x9F4F2726179A2245ULL, 136, 60},
+    {0xED63A231D4C4FB27ULL, 162, 68},
+    {0xB0DE65388CC8ADA8ULL, 189, 76},
+    {0x83C7088E1AAB65DBULL, 216, 84},
+    {0xC45D1DF942711D9AULL, 242, 92},
+    {0x924D692CA61BE758ULL, 269, 100},
+    {0xDA01EE641A708DEAULL, 295, 108},
+    {0xA26DA3999AEF774AULL, 322, 116},
+    {0xF209787BB47D6B85ULL, 348, 124},
+    {0xB454E4A179DD1877ULL, 375, 132},
+    {0x865B86925B9BC5C2ULL, 402, 140},
+    {0xC83553C5C8965D3DULL, 428, 148},
+    {0x952AB45CFA97A0B3ULL, 455, 156},
+    {0xDE469FBD99A05FE3ULL, 481, 164},
+    {0xA59BC234DB398C25ULL, 508, 172},
+    {0xF6C69A72A3989F5CULL, 534, 180},
+    {0xB7DCBF5354E9BECEULL, 561, 188},
+    {0x88FCF317F22241E2ULL, 588, 196},
+    {0xCC20CE9BD35C78A5ULL, 614, 204},
+    {0x98165AF37B2153DFULL, 641, 212},
+    {0xE2A0B5DC971F303AULL, 667, 220},
+    {0xA8D9D1535CE3B396ULL, 694, 228},
+    {0xFB9B7CD9A4A7443CULL, 720, 236},
+    {0xBB764C4CA7A44410ULL, 747, 244},
+    {0x8BAB8EEFB6409C1AULL, 774, 252},
+    {0xD01FEF10A657842CULL, 800, 260},
+    {0x9B10A4E5E9913129ULL, 827, 268},
+    {0xE7109BFBA19C0C9DULL, 853, 276},
+    {0xAC2820D9623BF429ULL, 880, 284},
+    {0x80444B5E7AA7CF85ULL, 907, 292},
+    {0xBF21E44003ACDD2DULL, 933, 300},
+    {0x8E679C2F5E44FF8FULL, 960, 308},
+    {0xD433179D9C8CB841ULL, 986, 316},
+    {0x9E19DB92B4E31BA9ULL, 1013, 324},
+    {0xEB96BF6EBADF77D9ULL, 1039, 332},
+    {0xAF87023B9BF0EE6BULL, 1066, 340}
+};
+
+
+// Powers of ten exactly representable as doubles
+static const double s_exactPowersOfTen[PRV_MAX_EXACT_POWER_OF_TEN + 1] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Powers of ten fitting in an uint64_t
+static const uint64_t s_integerPowersOfTen[PRV_MAX_MANTISSA_DIGITS + 1] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+    10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static uint64_t prv_doubleToBits(double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+static double prv_bitsToDouble(uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+// Multiply two extended floating point numbers, rounding the 128-bit product to its upper 64 bits
+static prv_diy_fp_t prv_diyFpMultiply(prv_diy_fp_t x,
+                                      prv_diy_fp_t y)
+{
+    prv_diy_fp_t result;
+    uint64_t xHi;
+    uint64_t xLo;
+    uint64_t yHi;
+    uint64_t yLo;
+    uint64_t p0;
+    uint64_t p1;
+    uint64_t p2;
+    uint64_t p3;
+    uint64_t middle;
+
+    xHi = x.f >> 32;
+    xLo = x.f & 0xFFFFFFFFU;
+    yHi = y.f >> 32;
+    yLo = y.f & 0xFFFFFFFFU;
+
+    p0 = xLo * yLo;
+    p1 = xLo * yHi;
+    p2 = xHi * yLo;
+    p3 = xHi * yHi;
+
+    middle = (p0 >> 32) + (p1 & 0xFFFFFFFFU) + (p2 & 0xFFFFFFFFU);
+    middle += 1U << 31; // Round
+
+    result.f = p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32);
+    result.e = x.e + y.e + PRV_DIY_FP_SIZE;
+
+    return result;
+}
+
+static prv_diy_fp_t prv_diyFpNormalize(prv_diy_fp_t x)
+{
+    assert(x.f != 0);
+
+    while ((x.f & 0xFFC0000000000000ULL) == 0)
+    {
+        x.f <<= 10;
+        x.e -= 10;
+    }
+    while ((x.f & PRV_SIGN_MASK) == 0)
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+
+    return x;
+}
+
+/******************************
+ * Big integers
+ ******************************/
+
+static void prv_bignumSet(prv_bignum_t *numP,
+                          uint64_t value)
+{
+    numP->limbs[0] = (uint32_t)value;
+    numP->limbs[1] = (uint32_t)(value >> 32);
+    numP->used = (numP->limbs[1] != 0) ? 2 : ((numP->limbs[0] != 0) ? 1 : 0);
+}
+
+// Compute num * factor + addend
+// Returned value: false if the capacity is exceeded.
+static bool prv_bignumMultiplyAdd(prv_bignum_t *numP,
+                                  uint32_t factor,
+                                  uint32_t addend)
+{
+    uint64_t carry;
+    size_t i;
+
+    carry = addend;
+    for (i = 0; i < numP->used; i++)
+    {
+        uint64_t product;
+
+        product = (uint64_t)numP->limbs[i] * factor + carry;
+        numP->limbs[i] = (uint32_t)product;
+        carry = product >> 32;
+    }
+    if (carry != 0)
+    {
+        if (numP->used == PRV_BIGNUM_CAPACITY)
+        {
+            return false;
+        }
+        numP->limbs[numP->used] = (uint32_t)carry;
+        numP->used++;
+    }
+
+    return true;
+}
+
+static bool prv_bignumMultiplyPow10(prv_bignum_t *numP,
+                                    unsigned int exponent)
+{
+    while (exponent >= PRV_BIGNUM_POW10_STEP)
+    {
+        if (prv_bignumMultiplyAdd(numP, PRV_BIGNUM_POW10_STEP_VALUE, 0) == false)
+        {
+            return false;
+        }
+        exponent -= PRV_BIGNUM_POW10_STEP;
+    }
+
+    return prv_bignumMultiplyAdd(numP, (uint32_t)s_integerPowersOfTen[exponent], 0);
+}
+
+static bool prv_bignumShiftLeft(prv_bignum_t *numP,
+                                unsigned int shift)
+{
+    size_t limbShift;
+    unsigned int bitShift;
+    size_t i;
+
+    if (numP->used == 0)
+    {
+        return true;
+    }
+
+    limbShift = shift / 32;
+    bitShift = shift % 32;
+    if (numP->used + limbShift + 1 > PRV_BIGNUM_CAPACITY)
+    {
+        return false;
+    }
+
+    numP->limbs[numP->used + limbShift] = 0;
+    for (i = numP->used; i > 0; i--)
+    {
+        uint32_t limb;
+
+        limb = numP->limbs[i - 1];
+        if (bitShift != 0)
+        {
+            numP->limbs[i + limbShift] |= limb >> (32 - bitShift);
+        }
+        numP->limbs[i - 1 + limbShift] = limb << bitShift;
+    }
+    for (i = 0; i < limbShift; i++)
+    {
+        numP->limbs[i] = 0;
+    }
+
+    numP->used += limbShift + 1;
+    if (numP->limbs[numP->used - 1] == 0)
+    {
+        numP->used--;
+    }
+
+    return true;
+}
+
+static int prv_bignumCompare(const prv_bignum_t *aP,
+                             const prv_bignum_t *bP)
+{
+    size_t i;
+
+    if (aP->used != bP->used)
+    {
+        return (aP->used < bP->used) ? -1 : 1;
+    }
+    for (i = aP->used; i > 0; i--)
+    {
+        if (aP->limbs[i - 1] != bP->limbs[i - 1])
+        {
+            return (aP->limbs[i - 1] < bP->limbs[i - 1]) ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+// Compute a + b
+// Returned value: false if the capacity is exceeded.
+static bool prv_bignumAdd(prv_bignum_t *resultP,
+                          const prv_bignum_t *aP,
+                          const prv_bignum_t *bP)
+{
+    uint64_t carry;
+    size_t i;
+
+    if (aP->used < bP->used)
+    {
+        const prv_bignum_t *tmpP;
+
+        tmpP = aP;
+        aP = bP;
+        bP = tmpP;
+    }
+
+    carry = 0;
+    for (i = 0; i < aP->used; i++)
+    {
+        uint64_t sum;
+
+        sum = (uint64_t)aP->limbs[i] + carry;
+        if (i < bP->used)
+        {
+            sum += bP->limbs[i];
+        }
+        resultP->limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    resultP->used = aP->used;
+    if (carry != 0)
+    {
+        if (resultP->used == PRV_BIGNUM_CAPACITY)
+        {
+            return false;
+        }
+        resultP->limbs[resultP->used] = (uint32_t)carry;
+        resultP->used++;
+    }
+
+    return true;
+}
+
+// Compute a - b, b being lower or equal to a
+static void prv_bignumSubtract(prv_bignum_t *aP,
+                               const prv_bignum_t *bP)
+{
+    uint64_t borrow;
+    size_t i;
+
+    borrow = 0;
+    for (i = 0; i < aP->used; i++)
+    {
+        uint64_t subtrahend;
+
+        subtrahend = borrow;
+        if (i < bP->used)
+        {
+            subtrahend += bP->limbs[i];
+        }
+        borrow = ((uint64_t)aP->limbs[i] < subtrahend) ? 1 : 0;
+        aP->limbs[i] = (uint32_t)((uint64_t)aP->limbs[i] - subtrahend);
+    }
+    while (aP->used > 0
+           && aP->limbs[aP->used - 1] == 0)
+    {
+        aP->used--;
+    }
+}
+
+/******************************
+ * Formatting
+ ******************************/
+
+// Get the cached power of ten bringing the binary exponent of the scaled value between alpha and gamma
+static const prv_cached_power_t * prv_getCachedPowerForBinaryExponent(int e)
+{
+    int f;
+    int k;
+    size_t index;
+
+    // k = ceil((alpha - e - 1) * log10(2))
+    f = PRV_GRISU_ALPHA - e - 1;
+    k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+
+    index = (size_t)((k - PRV_CACHED_POWERS_MIN_DEC_EXP + (PRV_CACHED_POWERS_DEC_STEP - 1)) / PRV_CACHED_POWERS_DEC_STEP);
+    assert(index < sizeof(s_cachedPowers) / sizeof(prv_cached_power_t));
+    assert(PRV_GRISU_ALPHA <= s_cachedPowers[index].e + e + PRV_DIY_FP_SIZE);
+    assert(s_cachedPowers[index].e + e + PRV_DIY_FP_SIZE <= PRV_GRISU_GAMMA);
+
+    return s_cachedPowers + index;
+}
+
+// Get the number of decimal digits of an integer lower than 10^19
+static size_t prv_getDigitCount64(uint64_t value)
+{
+    size_t count;
+
+    count = 1;
+    while (count < PRV_MAX_MANTISSA_DIGITS
+           && value >= s_integerPowersOfTen[count])
+    {
+        count++;
+    }
+
+    return count;
+}
+
+// Get the number of bits of a positive integer
+static size_t prv_getBitCount64(uint64_t value)
+{
+    size_t count;
+
+    count = 0;
+    while (value != 0)
+    {
+        value >>= 1;
+        count++;
+    }
+
+    return count;
+}
+
+// Get the largest power of ten lower or equal to n
+// Returned value: the number of digits of n.
+static int prv_findLargestPow10(uint32_t n,
+                                uint32_t *pow10P)
+{
+    size_t count;
+
+    count = prv_getDigitCount64(n);
+    *pow10P = (uint32_t)s_integerPowersOfTen[count - 1];
+
+    return (int)count;
+}
+
+// Move the last digit toward the value, then check that the digits are the shortest and closest ones
+// despite the errors of the scaled values
+// Returned value: true if the digits are proven correct, false otherwise.
+// Parameters:
+// - digits, digitCount: the generated digits.
+// - distTooHighW: the distance between the upper unsafe boundary and the scaled value.
+// - unsafeInterval: the width of the interval containing the rounding interval.
+// - rest: the distance between the upper unsafe boundary and the digits.
+// - tenKappa: the weight of the last digit.
+// - unit: the error of the scaled values.
+static bool prv_grisu3RoundWeed(uint8_t *digits,
+                                size_t digitCount,
+                                uint64_t distTooHighW,
+                                uint64_t unsafeInterval,
+                                uint64_t rest,
+                                uint64_t tenKappa,
+                                uint64_t unit)
+{
+    uint64_t smallDistance;
+    uint64_t bigDistance;
+
+    smallDistance = distTooHighW - unit;
+    bigDistance = distTooHighW + unit;
+
+    // Get as close as possible to the value seen at its farthest from the upper boundary
+    while (rest < smallDistance
+           && unsafeInterval - rest >= tenKappa
+           && (rest + tenKappa < smallDistance
+               || smallDistance - rest >= rest + tenKappa - smallDistance))
+    {
+        digits[digitCount - 1]--;
+        rest += tenKappa;
+    }
+
+    // The value seen at its closest to the upper boundary may need another last digit
+    if (rest < bigDistance
+        && unsafeInterval - rest >= tenKappa
+        && (rest + tenKappa < bigDistance
+            || bigDistance - rest > rest + tenKappa - bigDistance))
+    {
+        return false;
+    }
+
+    // The digits must be in the safe interval
+    return (2 * unit <= rest
+            && rest <= unsafeInterval - 4 * unit);
+}
+
+// Generate the digits of w, stopping as soon as they are in the interval widened by the scaling errors
+// Returned value: true if the digits are proven to be the shortest and closest ones, false otherwise.
+static bool prv_grisu3GenerateDigits(uint8_t *digits,
+                                     size_t *digitCountP,
+                                     int *exponentP,
+                                     prv_diy_fp_t low,
+                                     prv_diy_fp_t w,
+                                     prv_diy_fp_t high)
+{
+    uint64_t unit;
+    uint64_t tooHigh;
+    uint64_t unsafeInterval;
+    uint64_t one;
+    int shift;
+    uint32_t p1;
+    uint64_t p2;
+    uint32_t pow10;
+    int n;
+    int m;
+
+    // The scaled boundaries are off by at most one unit
+    unit = 1;
+    tooHigh = high.f + unit;
+    unsafeInterval = tooHigh - (low.f - unit);
+
+    // Split tooHigh in its integral part p1 and its fractional part p2
+    shift = -w.e;
+    one = 1ULL << shift;
+    p1 = (uint32_t)(tooHigh >> shift);
+    p2 = tooHigh & (one - 1);
+
+    *digitCountP = 0;
+
+    n = prv_findLargestPow10(p1, &pow10);
+    while (n > 0)
+    {
+        uint64_t rest;
+
+        digits[*digitCountP] = (uint8_t)('0' + p1 / pow10);
+        *digitCountP += 1;
+        p1 %= pow10;
+        n--;
+
+        rest = ((uint64_t)p1 << shift) + p2;
+        if (rest < unsafeInterval)
+        {
+            *exponentP += n;
+            return prv_grisu3RoundWeed(digits, *digitCountP, tooHigh - w.f, unsafeInterval, rest, (uint64_t)pow10 << shift, unit);
+        }
+
+        pow10 /= 10;
+    }
+
+    m = 0;
+    do
+    {
+        p2 *= 10;
+        unit *= 10;
+        unsafeInterval *= 10;
+        digits[*digitCountP] = (uint8_t)('0' + (p2 >> shift));
+        *digitCountP += 1;
+        p2 &= one - 1;
+        m++;
+    } while (p2 >= unsafeInterval);
+
+    *exponentP -= m;
+    return prv_grisu3RoundWeed(digits, *digitCountP, (tooHigh - w.f) * unit, unsafeInterval, p2, one, unit);
+}
+
+// Convert a positive finite double into decimal digits
+// Returned value: true if the digits are proven to be the shortest and closest ones, false if the exact
+// conversion must be used.
+// Parameters:
+// - bits: the bits of the double.
+// - digits: OUT. the decimal digits.
+// - digitCountP: OUT. the number of digits.
+// - exponentP: OUT. the decimal exponent: value = digits x 10^exponent.
+static bool prv_grisu3(uint64_t bits,
+                       uint8_t *digits,
+                       size_t *digitCountP,
+                       int *exponentP)
+{
+    prv_diy_fp_t v;
+    prv_diy_fp_t w;
+    prv_diy_fp_t mPlus;
+    prv_diy_fp_t mMinus;
+    prv_diy_fp_t cachedPower;
+    const prv_cached_power_t *cachedP;
+    uint64_t significand;
+    int biasedExponent;
+
+    significand = bits & PRV_SIGNIFICAND_MASK;
+    biasedExponent = (int)((bits & PRV_EXPONENT_MASK) >> PRV_PHYSICAL_SIGNIFICAND);
+
+    if (biasedExponent == 0)
+    {
+        v.f = significand;
+        v.e = PRV_DENORMAL_EXPONENT;
+    }
+    else
+    {
+        v.f = significand + PRV_HIDDEN_BIT;
+        v.e = biasedExponent - PRV_EXPONENT_BIAS;
+    }
+
+    // The boundaries are the middles between v and its neighbours
+    mPlus.f = (v.f << 1) + 1;
+    mPlus.e = v.e - 1;
+    if (significand == 0
+        && biasedExponent > 1)
+    {
+        // The lower neighbour is closer
+        mMinus.f = (v.f << 2) - 1;
+        mMinus.e = v.e - 2;
+    }
+    else
+    {
+        mMinus.f = (v.f << 1) - 1;
+        mMinus.e = v.e - 1;
+    }
+    mPlus = prv_diyFpNormalize(mPlus);
+    mMinus.f <<= mMinus.e - mPlus.e;
+    mMinus.e = mPlus.e;
+    w = prv_diyFpNormalize(v);
+
+    // Scale the values with a cached power of ten
+    cachedP = prv_getCachedPowerForBinaryExponent(mPlus.e);
+    cachedPower.f = cachedP->f;
+    cachedPower.e = cachedP->e;
+
+    w = prv_diyFpMultiply(w, cachedPower);
+    mMinus = prv_diyFpMultiply(mMinus, cachedPower);
+    mPlus = prv_diyFpMultiply(mPlus, cachedPower);
+
+    *exponentP = -cachedP->k;
+    return prv_grisu3GenerateDigits(digits, digitCountP, exponentP, mMinus, w, mPlus);
+}
+
+// Convert a positive finite double into its shortest and closest decimal digits with big integers
+// Parameters:
+// - bits: the bits of the double.
+// - digits: OUT. the decimal digits.
+// - digitCountP: OUT. the number of digits.
+// - exponentP: OUT. the decimal exponent: value = digits x 10^exponent.
+// Note: this is the free-format algorithm from R. G. Burger and R. K. Dybvig, "Printing Floating-Point Numbers
+//       Quickly and Accurately". It is only used in the rare cases Grisu3 cannot decide.
+static void prv_getExactDigits(uint64_t bits,
+                               uint8_t *digits,
+                               size_t *digitCountP,
+                               int *exponentP)
+{
+    prv_bignum_t r;
+    prv_bignum_t s;
+    prv_bignum_t mPlus;
+    prv_bignum_t mMinus;
+    prv_bignum_t high;
+    uint64_t significand;
+    int biasedExponent;
+    int binaryExponent;
+    unsigned int scaleShift;
+    bool isEven;
+    bool isLowReached;
+    bool isHighReached;
+    int orderOfMagnitude;
+    int k;
+    int comparison;
+
+    significand = bits & PRV_SIGNIFICAND_MASK;
+    biasedExponent = (int)((bits & PRV_EXPONENT_MASK) >> PRV_PHYSICAL_SIGNIFICAND);
+
+    // Scale the value so that the boundaries are integers: value = r / s, the lower boundary
+    // is (r - mMinus) / s and the upper one is (r + mPlus) / s
+    scaleShift = 1;
+    if (biasedExponent == 0)
+    {
+        binaryExponent = PRV_DENORMAL_EXPONENT;
+    }
+    else
+    {
+        if (significand == 0
+            && biasedExponent > 1)
+        {
+            // The lower neighbour is closer
+            scaleShift = 2;
+        }
+        significand += PRV_HIDDEN_BIT;
+        binaryExponent = biasedExponent - PRV_EXPONENT_BIAS;
+    }
+    // With ties to even, a boundary reads back to the value when its significand is even
+    isEven = ((significand & 1) == 0);
+
+    prv_bignumSet(&r, significand << scaleShift);
+    prv_bignumSet(&s, 1ULL << scaleShift);
+    prv_bignumSet(&mPlus, scaleShift);
+    prv_bignumSet(&mMinus, 1);
+    if (binaryExponent >= 0)
+    {
+        (void)prv_bignumShiftLeft(&r, (unsigned int)binaryExponent);
+        (void)prv_bignumShiftLeft(&mPlus, (unsigned int)binaryExponent);
+        (void)prv_bignumShiftLeft(&mMinus, (unsigned int)binaryExponent);
+    }
+    else
+    {
+        (void)prv_bignumShiftLeft(&s, (unsigned int)(-binaryExponent));
+    }
+
+    // Estimate k = ceil(log10(value)) from below, then scale the value below 1
+    orderOfMagnitude = binaryExponent + (int)prv_getBitCount64(significand) - 1;
+    k = (orderOfMagnitude * 78913) / (1 << 18) - 1;
+    if (k >= 0)
+    {
+        (void)prv_bignumMultiplyPow10(&s, (unsigned int)k);
+    }
+    else
+    {
+        (void)prv_bignumMultiplyPow10(&r, (unsigned int)(-k));
+        (void)prv_bignumMultiplyPow10(&mPlus, (unsigned int)(-k));
+        (void)prv_bignumMultiplyPow10(&mMinus, (unsigned int)(-k));
+    }
+
+    // Fix the estimate so that the upper boundary is below 10^k
+    for (;;)
+    {
+        (void)prv_bignumAdd(&high, &r, &mPlus);
+        comparison = prv_bignumCompare(&high, &s);
+        if (comparison < 0
+            || (comparison == 0 && isEven == false))
+        {
+            break;
+        }
+        (void)prv_bignumMultiplyAdd(&s, 10, 0);
+        k++;
+    }
+
+    *digitCountP = 0;
+    do
+    {
+        uint8_t digit;
+
+        (void)prv_bignumMultiplyAdd(&r, 10, 0);
+        (void)prv_bignumMultiplyAdd(&mPlus, 10, 0);
+        (void)prv_bignumMultiplyAdd(&mMinus, 10, 0);
+
+        digit = 0;
+        while (prv_bignumCompare(&r, &s) >= 0)
+        {
+            prv_bignumSubtract(&r, &s);
+            digit++;
+        }
+
+        // Stop when the digits or the digits with the last one incremented read back to the value
+        comparison = prv_bignumCompare(&r, &mMinus);
+        isLowReached = (comparison < 0 || (comparison == 0 && isEven == true));
+        (void)prv_bignumAdd(&high, &r, &mPlus);
+        comparison = prv_bignumCompare(&high, &s);
+        isHighReached = (comparison > 0 || (comparison == 0 && isEven == true));
+
+        if (isLowReached == true
+            && isHighReached == true)
+        {
+            // Keep the closest one, the even one on a tie
+            (void)prv_bignumShiftLeft(&r, 1);
+            comparison = prv_bignumCompare(&r, &s);
+            if (comparison > 0
+                || (comparison == 0 && (digit & 1) != 0))
+            {
+                digit++;
+            }
+        }
+        else if (isHighReached == true)
+        {
+            digit++;
+        }
+
+        digits[*digitCountP] = (uint8_t)('0' + digit);
+        *digitCountP += 1;
+    } while (isLowReached == false
+             && isHighReached == false);
+
+    *exponentP = k - (int)*digitCountP;
+}
+
+// Find the shortest text of a value having only a few decimals, like most sensor values
+// Returned value: true if found, false if Grisu3 must be used.
+// Parameters:
+// - value: a positive double.
+// - digits: OUT. the decimal digits.
+// - digitCountP: OUT. the number of digits.
+// - exponentP: OUT. the decimal exponent: value = digits x 10^exponent.
+static bool prv_getShortDecimal(double value,
+                                uint8_t *digits,
+                                size_t *digitCountP,
+                                int *exponentP)
+{
+    int decimalCount;
+    uint64_t mantissa;
+    size_t i;
+
+    if (value * s_exactPowersOfTen[PRV_SHORT_DECIMAL_MAX_COUNT] >= (double)PRV_MAX_EXACT_INTEGER)
+    {
+        return false;
+    }
+
+    // The text reads back to the value if the exact division done by the parser gives the value
+    for (decimalCount = 0; decimalCount <= PRV_SHORT_DECIMAL_MAX_COUNT; decimalCount++)
+    {
+        mantissa = (uint64_t)(value * s_exactPowersOfTen[decimalCount] + 0.5);
+        if (mantissa != 0
+            && (double)mantissa / s_exactPowersOfTen[decimalCount] == value)
+        {
+            break;
+        }
+    }
+    if (decimalCount > PRV_SHORT_DECIMAL_MAX_COUNT)
+    {
+        return false;
+    }
+
+    *exponentP = -decimalCount;
+    while (mantissa % 10 == 0)
+    {
+        mantissa /= 10;
+        *exponentP += 1;
+    }
+
+    *digitCountP = prv_getDigitCount64(mantissa);
+    for (i = *digitCountP; i > 0; i--)
+    {
+        digits[i - 1] = (uint8_t)('0' + mantissa % 10);
+        mantissa /= 10;
+    }
+
+    return true;
+}
+
+// Get the number of decimal digits of a positive integer
+static size_t prv_getDigitCount(unsigned int value)
+{
+    size_t count;
+
+    count = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        count++;
+    }
+
+    return count;
+}
+
+// Write the decimal digits in plain or scientific notation
+// Returned value: the length of the text, 0 if the buffer is too small.
+// Parameters:
+// - isNegative: if the number is negative.
+// - digits, digitCount: the decimal digits.
+// - exponent: the decimal exponent: value = digits x 10^exponent.
+// - withExponent: if the scientific notation can be used when it is shorter.
+// - buffer, length: OUT. the buffer to write to. If nil, only the length is computed.
+static size_t prv_formatDecimal(bool isNegative,
+                                const uint8_t *digits,
+                                size_t digitCount,
+                                int exponent,
+                                bool withExponent,
+                                uint8_t *buffer,
+                                size_t length)
+{
+    int point;
+    int scientificExponent;
+    size_t plainLength;
+    size_t scientificLength;
+    bool isPlain;
+    size_t textLength;
+    size_t index;
+
+    // Position of the decimal point from the first digit
+    point = (int)digitCount + exponent;
+
+    if (point >= (int)digitCount)
+    {
+        plainLength = (size_t)point;
+    }
+    else if (point > 0)
+    {
+        plainLength = digitCount + 1;
+    }
+    else
+    {
+        plainLength = 2 + (size_t)(-point) + digitCount;
+    }
+
+    scientificExponent = point - 1;
+    scientificLength = digitCount + (digitCount > 1 ? 1 : 0) + 1;
+    if (scientificExponent < 0)
+    {
+        scientificLength += 1 + prv_getDigitCount((unsigned int)(-scientificExponent));
+    }
+    else
+    {
+        scientificLength += prv_getDigitCount((unsigned int)scientificExponent);
+    }
+
+    if (withExponent == true)
+    {
+        isPlain = (plainLength <= scientificLength);
+    }
+    else
+    {
+        isPlain = (point >= PRV_PLAIN_MIN_POINT && point <= PRV_PLAIN_MAX_POINT);
+    }
+
+    textLength = (isPlain == true ? plainLength : scientificLength);
+    if (isNegative == true)
+    {
+        textLength++;
+    }
+
+    if (buffer == NULL)
+    {
+        return textLength;
+    }
+    if (textLength > length)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
+        return 0;
+    }
+
+    index = 0;
+    if (isNegative == true)
+    {
+        buffer[index++] = PRV_MINUS_SIGN;
+    }
+
+    if (isPlain == true)
+    {
+        if (point >= (int)digitCount)
+        {
+            memcpy(buffer + index, digits, digitCount);
+            index += digitCount;
+            memset(buffer + index, '0', (size_t)point - digitCount);
+        }
+        else if (point > 0)
+        {
+            memcpy(buffer + index, digits, (size_t)point);
+            index += (size_t)point;
+            buffer[index++] = PRV_DECIMAL_POINT;
+            memcpy(buffer + index, digits + point, digitCount - (size_t)point);
+        }
+        else
+        {
+            buffer[index++] = '0';
+            buffer[index++] = PRV_DECIMAL_POINT;
+            memset(buffer + index, '0', (size_t)(-point));
+            index += (size_t)(-point);
+            memcpy(buffer + index, digits, digitCount);
+        }
+    }
+    else
+    {
+        size_t exponentLength;
+        unsigned int absExponent;
+
+        buffer[index++] = digits[0];
+        if (digitCount > 1)
+        {
+            buffer[index++] = PRV_DECIMAL_POINT;
+            memcpy(buffer + index, digits + 1, digitCount - 1);
+            index += digitCount - 1;
+        }
+        buffer[index++] = PRV_EXPONENT_MIN;
+        if (scientificExponent < 0)
+        {
+            buffer[index++] = PRV_MINUS_SIGN;
+            absExponent = (unsigned int)(-scientificExponent);
+        }
+        else
+        {
+            absExponent = (unsigned int)scientificExponent;
+        }
+        exponentLength = prv_getDigitCount(absExponent);
+        index += exponentLength;
+        do
+        {
+            index--;
+            buffer[index] = (uint8_t)('0' + absExponent % 10);
+            absExponent /= 10;
+        } while (absExponent != 0);
+    }
+
+    return textLength;
+}
+
+// Convert a double to its shortest text
+// Returned value: the length of the text, 0 in case of error.
+// Parameters:
+// - data: the double to convert.
+// - withExponent: if the scientific notation can be used when it is shorter.
+// - buffer, length: OUT. the buffer to write to. If nil, only the length is computed.
+static size_t prv_floatToText(double data,
+                              bool withExponent,
+                              uint8_t *buffer,
+                              size_t length)
+{
+    uint64_t bits;
+    bool isNegative;
+    uint8_t digits[PRV_MAX_DIGIT_COUNT];
+    size_t digitCount;
+    int exponent;
+
+    bits = prv_doubleToBits(data);
+    isNegative = ((bits & PRV_SIGN_MASK) != 0);
+    bits &= ~PRV_SIGN_MASK;
+
+    if ((bits & PRV_EXPONENT_MASK) == PRV_EXPONENT_MASK)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Infinity and NaN have no text representation.");
+        return 0;
+    }
+
+    if (bits == 0)
+    {
+        digits[0] = '0';
+        digitCount = 1;
+        exponent = 0;
+    }
+    else if (prv_getShortDecimal(prv_bitsToDouble(bits), digits, &digitCount, &exponent) == false
+             && prv_grisu3(bits, digits, &digitCount, &exponent) == false)
+    {
+        prv_getExactDigits(bits, digits, &digitCount, &exponent);
+    }
+
+    return prv_formatDecimal(isNegative, digits, digitCount, exponent, withExponent, buffer, length);
+}
+
+/******************************
+ * Parsing
+ ******************************/
+
+// Parse the text of a decimal number
+// Returned value: true if the whole buffer is a number, false otherwise.
+static bool prv_parseDecimal(const uint8_t *buffer,
+                             size_t length,
+                             prv_decimal_t *decimalP)
+{
+    size_t index;
+    size_t start;
+    int64_t exponent;
+    bool isExponentNegative;
+
+    memset(decimalP, 0, sizeof(prv_decimal_t));
+
+    index = 0;
+    if (buffer[index] == PRV_MINUS_SIGN)
+    {
+        decimalP->isNegative = true;
+        index++;
+    }
+    else if (buffer[index] == PRV_PLUS_SIGN)
+    {
+        index++;
+    }
+
+    // Integral part
+    decimalP->digitsP = buffer + index;
+    start = index;
+    while (index < length
+           && '0' <= buffer[index]
+           && buffer[index] <= '9')
+    {
+        if (decimalP->digitCount != 0
+            || buffer[index] != '0')
+        {
+            if (decimalP->digitCount < PRV_MAX_MANTISSA_DIGITS)
+            {
+                decimalP->mantissa = decimalP->mantissa * 10 + (uint64_t)(buffer[index] - '0');
+            }
+            else if (buffer[index] != '0')
+            {
+                if (decimalP->digitCount == PRV_MAX_MANTISSA_DIGITS
+                    && buffer[index] >= '5')
+                {
+                    decimalP->roundUp = true;
+                }
+                decimalP->isTruncated = true;
+            }
+            decimalP->digitCount++;
+            decimalP->decimalPoint++;
+        }
+        index++;
+    }
+    if (index == start)
+    {
+        return false;
+    }
+
+    // Fractional part
+    if (index < length
+        && buffer[index] == PRV_DECIMAL_POINT)
+    {
+        index++;
+        start = index;
+        while (index < length
+               && '0' <= buffer[index]
+               && buffer[index] <= '9')
+        {
+            if (decimalP->digitCount == 0
+                && buffer[index] == '0')
+            {
+                decimalP->decimalPoint--;
+            }
+            else
+            {
+                if (decimalP->digitCount < PRV_MAX_MANTISSA_DIGITS)
+                {
+                    decimalP->mantissa = decimalP->mantissa * 10 + (uint64_t)(buffer[index] - '0');
+                }
+                else if (buffer[index] != '0')
+                {
+                    if (decimalP->digitCount == PRV_MAX_MANTISSA_DIGITS
+                        && buffer[index] >= '5')
+                    {
+                        decimalP->roundUp = true;
+                    }
+                    decimalP->isTruncated = true;
+                }
+                decimalP->digitCount++;
+            }
+            index++;
+        }
+        if (index == start)
+        {
+            return false;
+        }
+    }
+    decimalP->digitsLength = (size_t)(buffer + index - decimalP->digitsP);
+
+    // Exponent
+    if (index < length
+        && (buffer[index] == PRV_EXPONENT_MIN
+            || buffer[index] == PRV_EXPONENT_MAX))
+    {
+        index++;
+        isExponentNegative = false;
+        if (index < length
+            && (buffer[index] == PRV_MINUS_SIGN
+                || buffer[index] == PRV_PLUS_SIGN))
+        {
+            isExponentNegative = (buffer[index] == PRV_MINUS_SIGN);
+            index++;
+        }
+
+        start = index;
+        exponent = 0;
+        while (index < length
+               && '0' <= buffer[index]
+               && buffer[index] <= '9')
+        {
+            if (exponent < PRV_MAX_EXPONENT_VALUE)
+            {
+                exponent = exponent * 10 + (buffer[index] - '0');
+            }
+            index++;
+        }
+        if (index == start)
+        {
+            return false;
+        }
+
+        decimalP->decimalPoint += (isExponentNegative == true ? -exponent : exponent);
+    }
+
+    return (index == length);
+}
+
+// Convert an extended floating point number to the bits of a double, rounding toward zero
+static uint64_t prv_diyFpToBits(prv_diy_fp_t x)
+{
+    uint64_t biasedExponent;
+
+    while (x.f > PRV_HIDDEN_BIT + PRV_SIGNIFICAND_MASK)
+    {
+        x.f >>= 1;
+        x.e++;
+    }
+    if (x.e >= PRV_MAX_EXPONENT)
+    {
+        return PRV_EXPONENT_MASK;
+    }
+    if (x.e < PRV_DENORMAL_EXPONENT)
+    {
+        return 0;
+    }
+    while (x.e > PRV_DENORMAL_EXPONENT
+           && (x.f & PRV_HIDDEN_BIT) == 0)
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+
+    if (x.e == PRV_DENORMAL_EXPONENT
+        && (x.f & PRV_HIDDEN_BIT) == 0)
+    {
+        biasedExponent = 0;
+    }
+    else
+    {
+        biasedExponent = (uint64_t)(x.e + PRV_EXPONENT_BIAS);
+    }
+
+    return (x.f & PRV_SIGNIFICAND_MASK) | (biasedExponent << PRV_PHYSICAL_SIGNIFICAND);
+}
+
+// Get the significand size of a double of this order of magnitude, smaller for the denormals
+static int prv_getSignificandSizeForOrderOfMagnitude(int order)
+{
+    if (order >= PRV_DENORMAL_EXPONENT + PRV_SIGNIFICAND_SIZE)
+    {
+        return PRV_SIGNIFICAND_SIZE;
+    }
+    if (order <= PRV_DENORMAL_EXPONENT)
+    {
+        return 0;
+    }
+    return order - PRV_DENORMAL_EXPONENT;
+}
+
+// Approximate mantissa x 10^exponent with 64-bit arithmetic
+// Returned value: true if the result is correctly rounded, false if it may be one below the correct result.
+// Parameters:
+// - decimalP: the parsed decimal. Its mantissa is not nil.
+// - exponent: the decimal exponent of the mantissa.
+// - bitsP: OUT. the bits of the result.
+static bool prv_diyFpStrtod(prv_decimal_t *decimalP,
+                            int exponent,
+                            uint64_t *bitsP)
+{
+    prv_diy_fp_t input;
+    prv_diy_fp_t cachedPower;
+    const prv_cached_power_t *cachedP;
+    uint64_t error;
+    size_t mantissaDigitCount;
+    int adjustment;
+    int oldExponent;
+    int precisionDigitCount;
+    uint64_t precisionBits;
+    uint64_t halfWay;
+
+    // The error is counted in 1/PRV_ERROR_DENOMINATOR of the last bit
+    input.f = decimalP->mantissa;
+    input.e = 0;
+    error = 0;
+    if (decimalP->isTruncated == true)
+    {
+        if (decimalP->roundUp == true)
+        {
+            input.f++;
+        }
+        error = PRV_ERROR_DENOMINATOR / 2;
+    }
+    mantissaDigitCount = (decimalP->digitCount < PRV_MAX_MANTISSA_DIGITS) ? decimalP->digitCount : PRV_MAX_MANTISSA_DIGITS;
+
+    cachedP = s_cachedPowers + (exponent - PRV_CACHED_POWERS_MIN_DEC_EXP) / PRV_CACHED_POWERS_DEC_STEP;
+    adjustment = exponent - cachedP->k;
+    assert(adjustment >= 0 && adjustment < PRV_CACHED_POWERS_DEC_STEP);
+
+    if (adjustment != 0
+        && mantissaDigitCount + (size_t)adjustment <= PRV_MAX_MANTISSA_DIGITS
+        && decimalP->isTruncated == false)
+    {
+        // The product is an exact integer
+        input.f *= s_integerPowersOfTen[adjustment];
+        adjustment = 0;
+    }
+
+    oldExponent = input.e;
+    input = prv_diyFpNormalize(input);
+    error <<= oldExponent - input.e;
+
+    if (adjustment != 0)
+    {
+        prv_diy_fp_t adjustmentPower;
+
+        adjustmentPower.f = s_integerPowersOfTen[adjustment];
+        adjustmentPower.e = 0;
+        input = prv_diyFpMultiply(input, prv_diyFpNormalize(adjustmentPower));
+        error += PRV_ERROR_DENOMINATOR / 2;
+    }
+
+    cachedPower.f = cachedP->f;
+    cachedPower.e = cachedP->e;
+    input = prv_diyFpMultiply(input, cachedPower);
+
+    // Error of the cached power, of the product of the errors and of the rounding of the multiplication
+    error += PRV_ERROR_DENOMINATOR / 2 + (error == 0 ? 0 : 1) + PRV_ERROR_DENOMINATOR / 2;
+
+    oldExponent = input.e;
+    input = prv_diyFpNormalize(input);
+    error <<= oldExponent - input.e;
+
+    precisionDigitCount = PRV_DIY_FP_SIZE - prv_getSignificandSizeForOrderOfMagnitude(PRV_DIY_FP_SIZE + input.e);
+    if (precisionDigitCount + PRV_ERROR_DENOMINATOR_LOG >= PRV_DIY_FP_SIZE)
+    {
+        int shift;
+
+        // Only for very small denormals: keep the computations in 64 bits
+        shift = precisionDigitCount + PRV_ERROR_DENOMINATOR_LOG - PRV_DIY_FP_SIZE + 1;
+        input.f >>= shift;
+        input.e += shift;
+        error = (error >> shift) + 1 + PRV_ERROR_DENOMINATOR;
+        precisionDigitCount -= shift;
+    }
+
+    precisionBits = (input.f & ((1ULL << precisionDigitCount) - 1)) * PRV_ERROR_DENOMINATOR;
+    halfWay = (1ULL << (precisionDigitCount - 1)) * PRV_ERROR_DENOMINATOR;
+
+    input.f >>= precisionDigitCount;
+    input.e += precisionDigitCount;
+    if (precisionBits >= halfWay + error)
+    {
+        input.f++;
+    }
+
+    *bitsP = prv_diyFpToBits(input);
+
+    return (precisionBits <= halfWay - error
+            || precisionBits >= halfWay + error);
+}
+
+// Compare exactly the decimal to the halfway point between guess and the next double
+// Returned value: the bits of the correctly rounded result.
+static uint64_t prv_bignumStrtod(prv_decimal_t *decimalP,
+                                 uint64_t guess)
+{
+    prv_bignum_t decimal;
+    prv_bignum_t halfWay;
+    size_t i;
+    size_t digitCount;
+    int64_t decimalExponent;
+    int binaryExponent;
+    uint64_t significand;
+    uint32_t chunk;
+    size_t chunkLength;
+    bool isSticky;
+    int comparison;
+
+    // Load the significant digits, the last one marking the truncated non-zero digits
+    decimal.used = 0;
+    digitCount = 0;
+    chunk = 0;
+    chunkLength = 0;
+    isSticky = false;
+    for (i = 0; i < decimalP->digitsLength; i++)
+    {
+        uint8_t c;
+
+        c = decimalP->digitsP[i];
+        if (c == PRV_DECIMAL_POINT
+            || (digitCount == 0 && c == '0'))
+        {
+            continue;
+        }
+        if (digitCount == PRV_MAX_SIGNIFICANT_DIGITS - 1)
+        {
+            if (c != '0')
+            {
+                isSticky = true;
+            }
+            continue;
+        }
+
+        chunk = chunk * 10 + (uint32_t)(c - '0');
+        chunkLength++;
+        digitCount++;
+        if (chunkLength == PRV_BIGNUM_POW10_STEP)
+        {
+            (void)prv_bignumMultiplyAdd(&decimal, PRV_BIGNUM_POW10_STEP_VALUE, chunk);
+            chunk = 0;
+            chunkLength = 0;
+        }
+    }
+    if (isSticky == true)
+    {
+        chunk = chunk * 10 + 1;
+        chunkLength++;
+        digitCount++;
+    }
+    (void)prv_bignumMultiplyAdd(&decimal, (uint32_t)s_integerPowersOfTen[chunkLength], chunk);
+    decimalExponent = decimalP->decimalPoint - (int64_t)digitCount;
+
+    // The halfway point is (2 * significand + 1) x 2^(binaryExponent - 1)
+    significand = guess & PRV_SIGNIFICAND_MASK;
+    if ((guess & PRV_EXPONENT_MASK) == 0)
+    {
+        binaryExponent = PRV_DENORMAL_EXPONENT;
+    }
+    else
+    {
+        significand += PRV_HIDDEN_BIT;
+        binaryExponent = (int)((guess & PRV_EXPONENT_MASK) >> PRV_PHYSICAL_SIGNIFICAND) - PRV_EXPONENT_BIAS;
+    }
+    prv_bignumSet(&halfWay, significand * 2 + 1);
+    binaryExponent--;
+
+    if (decimalExponent >= 0)
+    {
+        (void)prv_bignumMultiplyPow10(&decimal, (unsigned int)decimalExponent);
+    }
+    else
+    {
+        (void)prv_bignumMultiplyPow10(&halfWay, (unsigned int)(-decimalExponent));
+    }
+    if (binaryExponent >= 0)
+    {
+        (void)prv_bignumShiftLeft(&halfWay, (unsigned int)binaryExponent);
+    }
+    else
+    {
+        (void)prv_bignumShiftLeft(&decimal, (unsigned int)(-binaryExponent));
+    }
+
+    comparison = prv_bignumCompare(&decimal, &halfWay);
+    if (comparison > 0
+        || (comparison == 0 && (guess & 1) != 0))
+    {
+        // The next double, ties to even
+        return guess + 1;
+    }
+
+    return guess;
+}
+
+// Convert a parsed decimal into the bits of the nearest double
+// Returned value: false if the number is too large.
+static bool prv_decimalToBits(prv_decimal_t *decimalP,
+                              uint64_t *bitsP)
+{
+    int exponent;
+
+    if (decimalP->digitCount == 0
+        || decimalP->decimalPoint < PRV_MIN_DECIMAL_POINT)
+    {
+        *bitsP = 0;
+        return true;
+    }
+    if (decimalP->decimalPoint > PRV_MAX_DECIMAL_POINT)
+    {
+        return false;
+    }
+
+    exponent = (int)decimalP->decimalPoint - (int)((decimalP->digitCount < PRV_MAX_MANTISSA_DIGITS) ? decimalP->digitCount : PRV_MAX_MANTISSA_DIGITS);
+
+    if (decimalP->isTruncated == false)
+    {
+        uint64_t mantissa;
+        int exactExponent;
+
+        mantissa = decimalP->mantissa;
+        exactExponent = exponent;
+        while (mantissa % 10 == 0)
+        {
+            mantissa /= 10;
+            exactExponent++;
+        }
+
+        // The mantissa and the power of ten are exact doubles: a single rounding is done
+        if (mantissa <= PRV_MAX_EXACT_INTEGER)
+        {
+            if (exactExponent < 0
+                && exactExponent >= -PRV_MAX_EXACT_POWER_OF_TEN)
+            {
+                *bitsP = prv_doubleToBits((double)mantissa / s_exactPowersOfTen[-exactExponent]);
+                return true;
+            }
+            if (exactExponent >= 0
+                && exactExponent <= PRV_MAX_EXACT_POWER_OF_TEN)
+            {
+                *bitsP = prv_doubleToBits((double)mantissa * s_exactPowersOfTen[exactExponent]);
+                return true;
+            }
+            if (exactExponent > PRV_MAX_EXACT_POWER_OF_TEN
+                && exactExponent - PRV_MAX_EXACT_POWER_OF_TEN < PRV_MAX_MANTISSA_DIGITS
+                && mantissa <= PRV_MAX_EXACT_INTEGER / s_integerPowersOfTen[exactExponent - PRV_MAX_EXACT_POWER_OF_TEN])
+            {
+                mantissa *= s_integerPowersOfTen[exactExponent - PRV_MAX_EXACT_POWER_OF_TEN];
+                *bitsP = prv_doubleToBits((double)mantissa * s_exactPowersOfTen[PRV_MAX_EXACT_POWER_OF_TEN]);
+                return true;
+            }
+        }
+    }
+
+    if (prv_diyFpStrtod(decimalP, exponent, bitsP) == false
+        && *bitsP < PRV_EXPONENT_MASK)
+    {
+        *bitsP = prv_bignumStrtod(decimalP, *bitsP);
+    }
+
+    return (*bitsP < PRV_EXPONENT_MASK);
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+size_t dataUtilsBufferToFloat(uint8_t *buffer,
+                              size_t length,
+                              double *dataP)
+{
+    prv_decimal_t decimal;
+    uint64_t bits;
+
+    assert(dataP != NULL);
+    assert((buffer != NULL && length != 0) || length == 0);
+
+    if (0 == length
+        || prv_parseDecimal(buffer, length, &decimal) == false)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
+        return 0;
+    }
+
+    if (prv_decimalToBits(&decimal, &bits) == false)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_DATA, "Number is out of range.");
+        return 0;
+    }
+    if (decimal.isNegative == true)
+    {
+        bits |= PRV_SIGN_MASK;
+    }
+
+    *dataP = prv_bitsToDouble(bits);
+
+    return 1;
+}
+
+size_t dataUtilsFloatToBufferLength(double data,
+                                    bool withExponent)
+{
+    return prv_floatToText(data, withExponent, NULL, 0);
+}
+
+size_t dataUtilsFloatToBuffer(double data,
+                              uint8_t *buffer,
+                              size_t length,
+                              bool withExponent)
+{
+    assert(buffer != NULL && length != 0);
+
+    return prv_floatToText(data, withExponent, buffer, length);
+}
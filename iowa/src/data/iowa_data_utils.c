@@ -24,14 +24,11 @@
 #include <float.h>
 
 #define PRV_OBJECT_LINK_TEXT_SEPARATOR  ':'
-#define PRV_DECIMAL_POINT               '.'
 #define PRV_EXPONENT_MIN                'e'
-#define PRV_EXPONENT_MAX                'E'
 #define PRV_MINUS_SIGN                  '-'
 #define PRV_PLUS_SIGN                   '+'
 
 #define PRV_EXPONENT_INT_MIN_CHAR_COUNT 3
-#define PRV_EXPONENT_DEC_MIN_CHAR_COUNT 4
 
 /*************************************************************************************
 ** Private functions
@@ -96,15 +93,15 @@ static size_t prv_partBufferToInt(uint8_t *buffer,
 
         digit = (uint64_t)(buffer[i] - '0');
 
-        value *= 10;
-        value += digit;
-
-        if (value < digit)
+        if (value > (UINT64_MAX - digit) / 10)
         {
             IOWA_LOG_TRACE(IOWA_PART_DATA, "Overflow.");
             return 0;
         }
 
+        value *= 10;
+        value += digit;
+
         i++;
     }
 
@@ -191,63 +188,6 @@ static int prv_isExponentPossibleForIntPart(int64_t *valueP)
 }
 
 
-// change value and indicate exponent if it is possible for decimal part of value
-// return exponent if possible or 0
-static int prv_isExponentPossibleForDecPart(double *valueP)
-{
-    int cpt;
-    double floatValue;
-    int sign;
-
-    assert(valueP != NULL);
-
-    if ((int64_t)(*valueP) != 0)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "No exponent possible.");
-        return 0;
-    }
-
-    if (*valueP < 0)
-    {
-        floatValue = 0 - (*valueP);
-        sign = -1;
-    }
-    else
-    {
-        floatValue = *valueP;
-        sign = 1;
-    }
-
-    cpt = 0;
-
-    if ((floatValue - (double)FLT_EPSILON) <= 0)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "No exponent possible.");
-        return 0;
-    }
-
-    while ((floatValue - (double)FLT_EPSILON) > 0
-           && floatValue < 1)
-    {
-        floatValue = floatValue * 10;
-        cpt++;
-    }
-    if (cpt >= PRV_EXPONENT_DEC_MIN_CHAR_COUNT)
-    {
-        while (((floatValue - (double)((int64_t)floatValue)) - (double)FLT_EPSILON) > 0)
-        {
-            floatValue = floatValue * 10;
-            cpt++;
-        }
-        IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "exponent found: %d.", cpt);
-        (*valueP) = sign * floatValue;
-        return cpt;
-    }
-
-    IOWA_LOG_TRACE(IOWA_PART_DATA, "No exponent possible.");
-    return 0;
-}
-
 // get the length of the conversion of an integer into a buffer
 // return the length of the conversion
 static size_t prv_intToBufferLength(int64_t data)
@@ -474,335 +414,6 @@ size_t dataUtilsIntToBuffer(int64_t data,
     return result;
 }
 
-size_t dataUtilsBufferToFloat(uint8_t *buffer,
-                              size_t length,
-                              double *dataP)
-{
-    double result;
-    int sign;
-    size_t index;
-    int64_t intPart;
-    size_t intResult;
-
-    assert(dataP != NULL);
-    assert((buffer != NULL && length != 0) || length == 0);
-
-    if (0 == length)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-        return 0;
-    }
-
-    index = 0;
-    sign = prv_getSignFromBufferToNumber(buffer, &index);
-    if (sign == 0)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-        return 0;
-    }
-
-    intResult = prv_partBufferToInt(&buffer[index], length - index, &intPart);
-    index += intResult;
-    if (intResult == 0
-        || index > length)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-        return 0;
-    }
-    result = (double)intPart;
-
-    if (index < length
-        && buffer[index] == PRV_DECIMAL_POINT)
-    {
-        double temp;
-        index++;
-        if (index > length)
-        {
-            IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-            return 0;
-        }
-
-        intResult = prv_partBufferToInt(&buffer[index], length - index, &intPart);
-        index += intResult;
-        if (intResult == 0
-            || index > length)
-        {
-            IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-            return 0;
-        }
-        temp = dataUtilsPower(10, (-1) * (int)(intResult));
-        temp = (double)intPart * temp;
-        result += temp;
-    }
-
-    if (index < length
-        && (buffer[index] == PRV_EXPONENT_MIN
-        || buffer[index] == PRV_EXPONENT_MAX))
-    {
-        int exponentSign;
-
-        index++;
-        if (index > length)
-        {
-            IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-            return 0;
-        }
-        exponentSign = prv_getSignFromBufferToNumber(buffer, &index);
-        if (exponentSign == 0
-            || index > length)
-        {
-            IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-            return 0;
-        }
-
-        intResult = prv_partBufferToInt(&buffer[index], length - index, &intPart);
-        index += intResult;
-        if (intResult == 0
-            || index > length)
-        {
-            IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-            return 0;
-        }
-        intPart *= exponentSign;
-
-        result = result * dataUtilsPower(10, intPart);
-    }
-
-    if (index != length)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "Not a number.");
-        return 0;
-    }
-
-    *dataP = result * sign;
-    return 1;
-}
-
-size_t dataUtilsFloatToBufferLength(double data,
-                                    bool withExponent)
-{
-    if (data > (double)INT64_MAX
-        || data < (double)INT64_MIN)
-    {
-        IOWA_LOG_WARNING(IOWA_PART_DATA, "Number is too large, set IOWA_USE_SNPRINTF to serialize it without error.");
-        return 0;
-    }
-    else
-    {
-        size_t intLength;
-        size_t decLength;
-        int64_t intPart;
-        double decPart;
-        int exponent;
-
-        if (withExponent == true)
-        {
-            exponent = prv_isExponentPossibleForDecPart(&data);
-        }
-        else
-        {
-            exponent = 0;
-        }
-
-        intPart = (int64_t)data;
-        decPart = data - (double)intPart;
-        if (decPart < 0)
-        {
-            decPart = 1 - decPart;
-        }
-        else
-        {
-            decPart = 1 + decPart;
-        }
-
-        if (decPart <= 1 + (double)FLT_EPSILON)
-        {
-            decPart = 0;
-        }
-
-        if (intPart == 0 && data < 0)
-        {
-            // deal with numbers between -1 and 0
-            intLength = 2;
-        }
-        else
-        {
-            bool setExponent;
-
-            if (withExponent == false
-                || decPart >= (double)FLT_EPSILON)
-            {
-                setExponent = false;
-            }
-            else
-            {
-                setExponent = true;
-            }
-            // Call the utils function to take exponent in account
-            intLength = dataUtilsIntToBufferLength(intPart, setExponent);
-        }
-
-        decLength = 0;
-        if (decPart >= (double)FLT_EPSILON)
-        {
-            double noiseFloor;
-
-            noiseFloor = (double)FLT_EPSILON;
-            do
-            {
-                decPart *= 10;
-                noiseFloor *= 10;
-            } while (decPart - (double)((int64_t)decPart) > noiseFloor);  // Compare the integer part of decPart with possible noise
-
-            decLength = prv_intToBufferLength((int64_t)decPart);
-        }
-
-        if (exponent != 0)
-        {
-            if (decLength != 0)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "exponent can not be present if decimal part is.");
-                return 0;
-            }
-            intLength += 2;
-            decLength = prv_intToBufferLength(exponent);
-        }
-
-        return intLength + decLength;
-    }
-}
-
-size_t dataUtilsFloatToBuffer(double data,
-                              uint8_t *buffer,
-                              size_t length,
-                              bool withExponent)
-{
-    assert(buffer != NULL && length != 0);
-
-    if (data > (double)INT64_MAX
-        || data < (double)INT64_MIN)
-    {
-        return 0;
-    }
-    else
-    {
-        size_t intLength;
-        size_t decLength;
-        int64_t intPart;
-        double decPart;
-        int exponent;
-
-        if (withExponent == true)
-        {
-            exponent = prv_isExponentPossibleForDecPart(&data);
-        }
-        else
-        {
-            exponent = 0;
-        }
-
-        intPart = (int64_t)data;
-        decPart = data - (double)intPart;
-        if (decPart < 0)
-        {
-            decPart = 1 - decPart;
-        }
-        else
-        {
-            decPart = 1 + decPart;
-        }
-
-        if (decPart <= 1 + (double)FLT_EPSILON)
-        {
-            decPart = 0;
-        }
-
-        if (intPart == 0 && data < 0)
-        {
-            // deal with numbers between -1 and 0
-            if (length < 4)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
-                return 0;   // "-0.n"
-            }
-            buffer[0] = '-';
-            buffer[1] = '0';
-            intLength = 2;
-        }
-        else
-        {
-            bool setExponent;
-
-            if (withExponent == false
-                || decPart >= (double)FLT_EPSILON)
-            {
-                setExponent = false;
-            }
-            else
-            {
-                setExponent = true;
-            }
-            // Call the utils function to take exponent in account
-            intLength = dataUtilsIntToBuffer(intPart, buffer, length, setExponent);
-
-            if (intLength == 0)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "failed to recover integer part.");
-                return 0;
-            }
-        }
-        decLength = 0;
-        if (decPart >= (double)FLT_EPSILON)
-        {
-            double noiseFloor;
-
-            if (intLength >= length - 1)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
-                return 0;
-            }
-
-            noiseFloor = (double)FLT_EPSILON;
-            do
-            {
-                decPart *= 10;
-                noiseFloor *= 10;
-            } while (decPart - (double)((int64_t)decPart) > noiseFloor); // Compare the integer part of decPart with possible noise
-
-            decLength = prv_intToBuffer((int64_t)decPart, buffer + intLength, length - intLength);
-            if (decLength <= 1)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "failed to recover decimal part.");
-                return 0;
-            }
-
-            // replace the leading 1 with a dot
-            buffer[intLength] = '.';
-        }
-
-        if (exponent != 0)
-        {
-            if (length < intLength + decLength + 2)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
-                return 0;
-            }
-            buffer[intLength] = PRV_EXPONENT_MIN;
-            intLength++;
-            buffer[intLength] = PRV_MINUS_SIGN;
-            intLength++;
-            decLength = prv_intToBuffer(exponent, buffer + intLength, length - intLength);
-            if (decLength == 0)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "Adding exponent not possible.");
-                return 0;
-            }
-        }
-
-        return intLength + decLength;
-    }
-}
-
 size_t dataUtilsBufferToObjectLink(uint8_t *buffer,
                                    size_t bufferLength,
                                    iowa_lwm2m_data_t *dataP)
@@ -896,6 +507,13 @@ size_t dataUtilsObjectLinkToBuffer(iowa_lwm2m_data_t *dataP,
     return resultBufferLength;
 }
 
+size_t dataUtilsObjectLinkToBufferLength(iowa_lwm2m_data_t *dataP)
+{
+    assert(dataP != NULL);
+
+    return prv_intToBufferLength(dataP->value.asObjLink.objectId) + 1 + prv_intToBufferLength(dataP->value.asObjLink.instanceId);
+}
+
 #ifdef LWM2M_ALTPATH_SUPPORT
 size_t dataUtilsBufferToUri(const char *buffer,
                             size_t bufferLength,
@@ -1502,6 +1120,44 @@ void dataUtilsGetUri(iowa_lwm2m_data_t *dataP, iowa_lwm2m_uri_t *uriP)
     uriP->resInstanceId = dataP->resInstanceID;
 }
 
+void dataUtilsSetUri(iowa_lwm2m_data_t *dataP, iowa_lwm2m_uri_t *uriP)
+{
+    assert(dataP != NULL);
+    assert(uriP != NULL);
+
+    dataP->objectID = uriP->objectId;
+    dataP->instanceID = uriP->instanceId;
+    dataP->resourceID = uriP->resourceId;
+    dataP->resInstanceID = uriP->resInstanceId;
+}
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+iowa_status_t dataUtilsGetBaseTime(iowa_lwm2m_data_t *dataP,
+                                   size_t size,
+                                   int32_t *basetimeP)
+{
+    size_t index;
+
+    assert(dataP != NULL && size != 0);
+    assert(basetimeP != NULL);
+
+    // The base time is the oldest non-null timestamp so that the relative times are positive
+    *basetimeP = 0;
+    for (index = 0; index < size; index++)
+    {
+        if (dataP[index].timestamp != 0
+            && (*basetimeP == 0 || dataP[index].timestamp < *basetimeP))
+        {
+            *basetimeP = dataP[index].timestamp;
+        }
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "basetime: %d.", *basetimeP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif
+
 bool dataUtilsCompareFloatingPointNumbers(double num1,
                                           double num2)
 {
@@ -1515,7 +1171,217 @@ bool dataUtilsCompareFloatingPointNumbers(double num1,
             && ((num1-num2) >= -FLT_EPSILON));
 }
 
+size_t dataUtilsSkipBufferSpace(const uint8_t *bufferP,
+                                size_t bufferLength)
+{
+    size_t index;
+
+    assert(bufferP != NULL || bufferLength == 0);
+
+    index = 0;
+    while (index < bufferLength
+           && (bufferP[index] == ' '
+               || bufferP[index] == '\t'
+               || bufferP[index] == '\n'
+               || bufferP[index] == '\r'))
+    {
+        index++;
+    }
+
+    return index;
+}
+
+/**************************************************************
+ * Output sink
+ **************************************************************/
+
+#define PRV_SINK_MIN_DYNAMIC_SIZE 64
+
+void dataSinkInit(data_sink_t *sinkP,
+                  uint8_t *chunkP,
+                  size_t chunkSize,
+                  data_sink_flush_callback_t flushCb,
+                  void *userDataP)
+{
+    assert(sinkP != NULL);
+    assert(chunkP == NULL || chunkSize != 0);
+
+    memset(sinkP, 0, sizeof(data_sink_t));
+    sinkP->result = IOWA_COAP_NO_ERROR;
+
+    if (chunkP != NULL)
+    {
+        sinkP->chunkP = chunkP;
+        sinkP->chunkSize = chunkSize;
+        sinkP->flushCb = flushCb;
+        sinkP->userDataP = userDataP;
+        return;
+    }
+
+    if (chunkSize < PRV_SINK_MIN_DYNAMIC_SIZE)
+    {
+        chunkSize = PRV_SINK_MIN_DYNAMIC_SIZE;
+    }
+    sinkP->isDynamic = true;
+    sinkP->chunkP = (uint8_t *)iowa_system_malloc(chunkSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (sinkP->chunkP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(chunkSize);
+        sinkP->result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        return;
+    }
+#endif
+    sinkP->chunkSize = chunkSize;
+}
+
+void dataSinkWrite(data_sink_t *sinkP,
+                   const uint8_t *bufferP,
+                   size_t length)
+{
+    size_t copyLength;
+
+    assert(sinkP != NULL);
+    assert(bufferP != NULL || length == 0);
+
+    if (sinkP->result != IOWA_COAP_NO_ERROR)
+    {
+        return;
+    }
+
+    if (sinkP->isDynamic == true
+        && length > sinkP->chunkSize - sinkP->chunkLength)
+    {
+        uint8_t *newChunkP;
+        size_t newChunkSize;
+
+        // Double the buffer to keep the copies linear in the payload length
+        newChunkSize = 2 * sinkP->chunkSize;
+        if (newChunkSize < sinkP->chunkLength + length)
+        {
+            newChunkSize = sinkP->chunkLength + length;
+        }
+
+        newChunkP = (uint8_t *)iowa_system_malloc(newChunkSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (newChunkP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(newChunkSize);
+            sinkP->result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            return;
+        }
+#endif
+        memcpy(newChunkP, sinkP->chunkP, sinkP->chunkLength);
+        iowa_system_free(sinkP->chunkP);
+        sinkP->chunkP = newChunkP;
+        sinkP->chunkSize = newChunkSize;
+    }
+
+    while (length > 0)
+    {
+        if (sinkP->chunkLength == sinkP->chunkSize)
+        {
+            if (sinkP->flushCb == NULL)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Output buffer of %u bytes is too small.", sinkP->chunkSize);
+                sinkP->result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                return;
+            }
+
+            sinkP->result = sinkP->flushCb(sinkP->chunkP, sinkP->chunkLength, sinkP->userDataP);
+            if (sinkP->result != IOWA_COAP_NO_ERROR)
+            {
+                return;
+            }
+            sinkP->chunkLength = 0;
+        }
+
+        copyLength = sinkP->chunkSize - sinkP->chunkLength;
+        if (copyLength > length)
+        {
+            copyLength = length;
+        }
+        memcpy(sinkP->chunkP + sinkP->chunkLength, bufferP, copyLength);
+        sinkP->chunkLength += copyLength;
+        sinkP->totalLength += copyLength;
+        bufferP += copyLength;
+        length -= copyLength;
+    }
+}
+
+iowa_status_t dataSinkFlush(data_sink_t *sinkP)
+{
+    assert(sinkP != NULL);
+
+    if (sinkP->result == IOWA_COAP_NO_ERROR
+        && sinkP->flushCb != NULL
+        && sinkP->chunkLength != 0)
+    {
+        sinkP->result = sinkP->flushCb(sinkP->chunkP, sinkP->chunkLength, sinkP->userDataP);
+        sinkP->chunkLength = 0;
+    }
+
+    return sinkP->result;
+}
+
+void dataSinkClose(data_sink_t *sinkP)
+{
+    assert(sinkP != NULL);
+
+    if (sinkP->isDynamic == true)
+    {
+        iowa_system_free(sinkP->chunkP);
+        sinkP->chunkP = NULL;
+        sinkP->chunkSize = 0;
+        sinkP->chunkLength = 0;
+    }
+}
 
 /**************************************************************
  * Half float conversion
  **************************************************************/
+
+float dataUtilsConvertHalfFloatToFloat(uint16_t halfFloat)
+{
+    uint32_t sign;
+    uint32_t exponent;
+    uint32_t mantissa;
+    uint32_t bits;
+    float result;
+
+    sign = ((uint32_t)halfFloat & 0x8000) << 16;
+    exponent = ((uint32_t)halfFloat >> 10) & 0x1F;
+    mantissa = (uint32_t)halfFloat & 0x03FF;
+
+    if (exponent == 0x1F)
+    {
+        // Infinity or NaN
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        // Normalized number: rebias the exponent from 15 to 127
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa != 0)
+    {
+        // Subnormal half float: normalize it as single precision float has a wider exponent range
+        exponent = 113;
+        while ((mantissa & 0x0400) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x03FF) << 13);
+    }
+    else
+    {
+        // Signed zero
+        bits = sign;
+    }
+
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
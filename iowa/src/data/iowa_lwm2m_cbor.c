@@ -28,3 +28,570 @@
 #include "iowa_prv_data_internals.h"
 #include <float.h>
 
+
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+
+// The nested maps are keyed by the Object ID, the Object Instance ID, the Resource ID and the Resource Instance ID
+#define PRV_LWM2M_CBOR_MAX_DEPTH    LWM2M_URI_DEPTH_RESOURCE_INSTANCE
+
+#define PRV_CBOR_SIMPLE_VALUE_NULL  22
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Get the ID of a data at a given level of the URI tree
+// Returned value: the ID, IOWA_LWM2M_ID_ALL if the data URI is not that deep.
+// Parameters:
+// - dataP: the data.
+// - level: the level, from 0 (Object ID) to 3 (Resource Instance ID).
+static uint16_t prv_getId(iowa_lwm2m_data_t *dataP,
+                          size_t level)
+{
+    switch (level)
+    {
+    case 0:
+        return dataP->objectID;
+
+    case 1:
+        return dataP->instanceID;
+
+    case 2:
+        return dataP->resourceID;
+
+    default:
+        return dataP->resInstanceID;
+    }
+}
+
+// Get the depth of the URI of a data
+static size_t prv_getDataDepth(iowa_lwm2m_data_t *dataP)
+{
+    size_t level;
+
+    for (level = 0; level < PRV_LWM2M_CBOR_MAX_DEPTH; level++)
+    {
+        if (prv_getId(dataP, level) == IOWA_LWM2M_ID_ALL)
+        {
+            break;
+        }
+    }
+
+    return level;
+}
+
+// Get the length of a data value, null values included
+// Returned value: the length, 0 if the data type can not be serialized.
+static size_t prv_getValueLength(iowa_lwm2m_data_t *dataP)
+{
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_URI_ONLY:
+    case IOWA_LWM2M_TYPE_NULL:
+        return 1;
+
+    default:
+        return cborGetDataToBufferLength(dataP);
+    }
+}
+
+// Add a data value to the buffer, URI only and null data being encoded as CBOR null
+static int8_t prv_addValue(iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_URI_ONLY:
+    case IOWA_LWM2M_TYPE_NULL:
+        if (*bufferIndexP >= bufferLength)
+        {
+            return CBOR_ERROR;
+        }
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, PRV_CBOR_SIMPLE_VALUE_NULL);
+        *bufferIndexP += 1;
+        return CBOR_NO_ERROR;
+
+    default:
+        return cborAddDataToBuffer(dataP, bufferP, bufferLength, bufferIndexP);
+    }
+}
+
+// Serialize or compute the length of the map of a node of the URI tree
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataP, size: data under the node, sorted by URI.
+// - level: the level of the keys of the map.
+// - bufferP: the buffer to write to. If nil, only the length is computed.
+// - bufferLength: the size of bufferP.
+// - bufferIndexP: IN/OUT. current buffer index.
+// Note: a chain of nodes with a single child is collapsed in one key, encoded as an array of IDs.
+static iowa_status_t prv_serializeMap(iowa_lwm2m_data_t *dataP,
+                                      size_t size,
+                                      size_t level,
+                                      uint8_t *bufferP,
+                                      size_t bufferLength,
+                                      size_t *bufferIndexP)
+{
+    size_t start;
+    size_t end;
+    size_t pairCount;
+    size_t keyLevel;
+    size_t i;
+    iowa_status_t result;
+
+    // As the data are sorted, the children of the node are contiguous
+    pairCount = 1;
+    for (i = 1; i < size; i++)
+    {
+        if (prv_getId(dataP + i, level) != prv_getId(dataP + i - 1, level))
+        {
+            pairCount++;
+        }
+    }
+
+    if (bufferP == NULL)
+    {
+        *bufferIndexP += cborGetNumberToBufferLength(pairCount);
+    }
+    else if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS, pairCount, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    for (start = 0; start < size; start = end)
+    {
+        bool isLeaf;
+
+        end = start + 1;
+        while (end < size
+               && prv_getId(dataP + end, level) == prv_getId(dataP + start, level))
+        {
+            end++;
+        }
+
+        // Extend the key while the child is the only one
+        keyLevel = level + 1;
+        isLeaf = false;
+        while (isLeaf == false
+               && keyLevel < PRV_LWM2M_CBOR_MAX_DEPTH)
+        {
+            for (i = start; i < end; i++)
+            {
+                if (prv_getDataDepth(dataP + i) == keyLevel)
+                {
+                    isLeaf = true;
+                    break;
+                }
+                if (prv_getId(dataP + i, keyLevel) != prv_getId(dataP + start, keyLevel))
+                {
+                    break;
+                }
+            }
+            if (i != end)
+            {
+                break;
+            }
+            keyLevel++;
+        }
+        if (keyLevel == PRV_LWM2M_CBOR_MAX_DEPTH)
+        {
+            isLeaf = true;
+        }
+        if (isLeaf == true
+            && end - start != 1)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "/%u/%u/%u/%u has both a value and children or is duplicated.", dataP[start].objectID, dataP[start].instanceID, dataP[start].resourceID, dataP[start].resInstanceID);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        // Write the key
+        if (bufferP == NULL)
+        {
+            if (keyLevel - level > 1)
+            {
+                *bufferIndexP += cborGetNumberToBufferLength(keyLevel - level);
+            }
+            for (i = level; i < keyLevel; i++)
+            {
+                *bufferIndexP += cborGetNumberToBufferLength(prv_getId(dataP + start, i));
+            }
+        }
+        else
+        {
+            if (keyLevel - level > 1
+                && cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, keyLevel - level, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            for (i = level; i < keyLevel; i++)
+            {
+                if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, prv_getId(dataP + start, i), bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+                {
+                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                }
+            }
+        }
+
+        // Write the value
+        if (isLeaf == false)
+        {
+            result = prv_serializeMap(dataP + start, end - start, keyLevel, bufferP, bufferLength, bufferIndexP);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                return result;
+            }
+        }
+        else if (bufferP == NULL)
+        {
+            size_t valueLength;
+
+            valueLength = prv_getValueLength(dataP + start);
+            if (valueLength == 0)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported data type: %s.", STR_LWM2M_TYPE(dataP[start].type));
+                return IOWA_COAP_406_NOT_ACCEPTABLE;
+            }
+            *bufferIndexP += valueLength;
+        }
+        else if (prv_addValue(dataP + start, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Check if the next item is a break
+static bool prv_isBreak(uint8_t *bufferP,
+                        size_t bufferLength,
+                        size_t index)
+{
+    return (index < bufferLength
+            && bufferP[index] == CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK));
+}
+
+// Read a map key: an ID or an array of IDs
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP, bufferLength, bufferIndexP: the payload and the current index.
+// - idArray: IN/OUT. the IDs of the current path.
+// - levelP: IN/OUT. the length of the current path.
+static int8_t prv_parseKey(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           uint16_t idArray[PRV_LWM2M_CBOR_MAX_DEPTH],
+                           size_t *levelP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    uint64_t idCount;
+    uint64_t i;
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+        idCount = 1;
+        break;
+
+    case CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS:
+        idCount = number;
+        if (idCount == 0
+            || idCount == CBOR_NUMBER_MAX)
+        {
+            return CBOR_ERROR;
+        }
+        majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+        if (majorType != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER)
+        {
+            return CBOR_ERROR;
+        }
+        break;
+
+    default:
+        return CBOR_ERROR;
+    }
+
+    if (idCount > PRV_LWM2M_CBOR_MAX_DEPTH - *levelP)
+    {
+        return CBOR_ERROR;
+    }
+
+    for (i = 0; i < idCount; i++)
+    {
+        if (i != 0)
+        {
+            majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+            if (majorType != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        if (number >= IOWA_LWM2M_ID_ALL)
+        {
+            return CBOR_ERROR;
+        }
+        idArray[*levelP] = (uint16_t)number;
+        *levelP += 1;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+// Decode or count the values of a node of the URI tree
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP, bufferLength, bufferIndexP: the payload and the current index.
+// - idArray: the IDs of the path of the node.
+// - level: the length of the path of the node.
+// - baseUriP, baseUriDepth: the URI targeted by the operation. baseUriP can be nil.
+// - dataArrayP: OUT. the decoded data. If nil, the values are only counted.
+// - countP: IN/OUT. the number of values.
+static int8_t prv_parseMap(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           uint16_t idArray[PRV_LWM2M_CBOR_MAX_DEPTH],
+                           size_t level,
+                           iowa_lwm2m_uri_t *baseUriP,
+                           lwm2m_uri_depth_t baseUriDepth,
+                           iowa_lwm2m_data_t *dataArrayP,
+                           size_t *countP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    uint64_t pairCount;
+    uint64_t pairIndex;
+
+    majorType = cborPutBufferToNumber(&pairCount, bufferP, bufferLength, bufferIndexP);
+    if (majorType != CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Item is not a map.");
+        return CBOR_ERROR;
+    }
+    if (pairCount == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Empty map.");
+        return CBOR_ERROR;
+    }
+
+    for (pairIndex = 0; pairIndex < pairCount; pairIndex++)
+    {
+        size_t keyLevel;
+        iowa_lwm2m_uri_t uri;
+        iowa_lwm2m_data_t uriData;
+
+        if (pairCount == CBOR_NUMBER_MAX
+            && prv_isBreak(bufferP, bufferLength, *bufferIndexP) == true)
+        {
+            *bufferIndexP += 1;
+            break;
+        }
+
+        keyLevel = level;
+        if (prv_parseKey(bufferP, bufferLength, bufferIndexP, idArray, &keyLevel) != CBOR_NO_ERROR)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid key.");
+            return CBOR_ERROR;
+        }
+        if (*bufferIndexP >= bufferLength)
+        {
+            return CBOR_ERROR;
+        }
+
+        if ((bufferP[*bufferIndexP] & CBOR_MAJOR_TYPE_MASK) >> CBOR_MAJOR_TYPE_BIT_SHIFT == CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            if (keyLevel == PRV_LWM2M_CBOR_MAX_DEPTH
+                || prv_parseMap(bufferP, bufferLength, bufferIndexP, idArray, keyLevel, baseUriP, baseUriDepth, dataArrayP, countP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            continue;
+        }
+
+        // This is a value, its URI must be a Resource or a Resource Instance
+        if (keyLevel < LWM2M_URI_DEPTH_RESOURCE)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Value is not at the resource level.");
+            return CBOR_ERROR;
+        }
+        uri.objectId = idArray[0];
+        uri.instanceId = idArray[1];
+        uri.resourceId = idArray[2];
+        uri.resInstanceId = (keyLevel == LWM2M_URI_DEPTH_RESOURCE_INSTANCE) ? idArray[3] : IOWA_LWM2M_ID_ALL;
+
+        if (dataArrayP == NULL)
+        {
+            if (baseUriP != NULL)
+            {
+                dataUtilsSetUri(&uriData, &uri);
+                if (dataUtilsIsInBaseUri(&uriData, baseUriP, baseUriDepth) == false)
+                {
+                    IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "/%u/%u/%u/%u is not under the targeted URI.", uri.objectId, uri.instanceId, uri.resourceId, uri.resInstanceId);
+                    return CBOR_ERROR;
+                }
+            }
+            if (cborSkipItem(bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        else
+        {
+            iowa_lwm2m_data_t *dataP;
+
+            dataP = dataArrayP + *countP;
+            majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+            if (majorType == CBOR_MAJOR_TYPE_NONE
+                || cborPutBufferToData(majorType, number, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid value.");
+                return CBOR_ERROR;
+            }
+            dataUtilsSetUri(dataP, &uri);
+        }
+        *countP += 1;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t lwm2mCborSerialize(iowa_lwm2m_uri_t *baseUriP,
+                                 iowa_lwm2m_data_t *dataP,
+                                 size_t size,
+                                 uint8_t **bufferP,
+                                 size_t *bufferLengthP)
+{
+    // Warning: 'dataP' must be sorted by URI
+    iowa_status_t result;
+    size_t index;
+    size_t i;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %d", size);
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        if (dataP[i].objectID == IOWA_LWM2M_ID_ALL)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Data #%u has no Object ID.", i);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        if (baseUriP != NULL
+            && dataUtilsIsInBaseUri(dataP + i, baseUriP, dataUtilsGetUriDepth(baseUriP)) == false)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Data #%u is not under the targeted URI.", i);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+    }
+
+    index = 0;
+    result = prv_serializeMap(dataP, size, 0, NULL, 0, &index);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Failed to retrieve the length");
+        return result;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(index);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(index);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    *bufferLengthP = index;
+
+    index = 0;
+    result = prv_serializeMap(dataP, size, 0, *bufferP, *bufferLengthP, &index);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        *bufferLengthP = 0;
+        return result;
+    }
+
+    IOWA_LOG_ARG_BUFFER_TRACE(IOWA_PART_DATA, "LwM2M CBOR payload:", *bufferP, *bufferLengthP, "length: %u", *bufferLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t lwm2mCborDeserialize(iowa_lwm2m_uri_t *baseUriP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   iowa_lwm2m_data_t **dataP,
+                                   size_t *dataCountP)
+{
+    uint16_t idArray[PRV_LWM2M_CBOR_MAX_DEPTH];
+    lwm2m_uri_depth_t baseUriDepth;
+    size_t index;
+    size_t count;
+
+    assert(dataP != NULL);
+    assert(dataCountP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "bufferLength: %u", bufferLength);
+
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    if (bufferP == NULL
+        || bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Empty payload.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    baseUriDepth = (baseUriP == NULL) ? LWM2M_URI_DEPTH_ROOT : dataUtilsGetUriDepth(baseUriP);
+
+    // First pass: check the payload and count the values
+    index = 0;
+    count = 0;
+    if (prv_parseMap(bufferP, bufferLength, &index, idArray, 0, baseUriP, baseUriDepth, NULL, &count) != CBOR_NO_ERROR
+        || index != bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid LwM2M CBOR payload.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(count * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(count * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, count * sizeof(iowa_lwm2m_data_t));
+
+    // Second pass: decode the values
+    index = 0;
+    *dataCountP = 0;
+    if (prv_parseMap(bufferP, bufferLength, &index, idArray, 0, baseUriP, baseUriDepth, *dataP, dataCountP) != CBOR_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid LwM2M CBOR value.");
+        dataLwm2mFree(count, *dataP);
+        *dataP = NULL;
+        *dataCountP = 0;
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // LWM2M_SUPPORT_LWM2M_CBOR
@@ -54,6 +54,49 @@ typedef struct _lwm2m_data_list_t
     iowa_lwm2m_data_t dataArray[];
 } lwm2m_data_list_t;
 
+// Maximum length of a float converted by dataUtilsFloatToBuffer()
+#define DATA_FLOAT_STRING_MAX_LENGTH 64
+
+// The chunk flush callback of an output sink. Called each time the chunk is full and at the end of the serialization.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status stopping the serialization.
+// chunkP, chunkLength: the serialized bytes.
+// userDataP: as set in dataSinkInit().
+typedef iowa_status_t(*data_sink_flush_callback_t) (uint8_t *chunkP,
+                                                    size_t chunkLength,
+                                                    void *userDataP);
+
+typedef struct
+{
+    uint8_t *chunkP;
+    size_t chunkSize;
+    size_t chunkLength;
+    size_t totalLength;
+    data_sink_flush_callback_t flushCb;
+    void *userDataP;
+    bool isDynamic;
+    iowa_status_t result;
+} data_sink_t;
+
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+// A value of a payload template replaced at each serialization
+typedef struct
+{
+    size_t                 offset;      // position of the value in the template buffer
+    size_t                 length;      // length of the value encoded in the template buffer
+    size_t                 valueIndex;  // index of the value given to dataTemplateSerialize()
+    iowa_lwm2m_data_type_t type;
+} data_template_slot_t;
+
+// A SenML CBOR payload encoded once and serialized many times with different slot values
+typedef struct
+{
+    uint8_t              *bufferP;
+    size_t                bufferLength;
+    size_t                slotCount;
+    data_template_slot_t *slotArray;    // sorted by offset
+} data_template_t;
+#endif
+
 /**************************************************************
  * Callbacks
  **************************************************************/
@@ -107,6 +150,16 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP,
 // Note: free each allocation made in data array and the data array itself.
 void dataLwm2mFree(size_t dataCount, iowa_lwm2m_data_t *dataArrayP);
 
+// Serialize LwM2M data in an output sink.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - baseUriP: IN. the base URI of the serialized data. This can be nil.
+// - dataP, dataCount: IN. data to serialize.
+// - contentFormatP: IN/OUT. required content format to serialize to. It can be changed as in dataLwm2mSerialize().
+// - sinkP: IN/OUT. the initialized output sink. It is flushed on success.
+// Note: SenML JSON is streamed in the sink, the other formats are serialized in a buffer first.
+iowa_status_t dataLwm2mSerializeToSink(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t dataCount, iowa_content_format_t *contentFormatP, data_sink_t *sinkP);
+
 // Allocate a new lwm2m_data_list_t
 // Returned value: A pointer to a new lwm2m_data_list_t or NULL in case of error.
 // Parameters:
@@ -126,6 +179,32 @@ void dataListFree(lwm2m_data_list_t *dataListP);
 // - dataP, dataCount: OUT. dynamically allocated data.
 iowa_status_t dataListFlatten(lwm2m_data_list_t *dataListP, iowa_lwm2m_data_t **dataP, size_t *dataCountP);
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+// Encode a SenML CBOR payload template.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataP, dataCount: IN. data to serialize. The values of the slot data only give their type.
+// - slotCount: IN. number of slots.
+// - slotDataIndexArray: IN. index in dataP of the data of each slot.
+// - templateP: OUT. the template to release with dataTemplateFree().
+iowa_status_t dataTemplateInit(iowa_lwm2m_data_t *dataP, size_t dataCount, size_t slotCount, const size_t *slotDataIndexArray, data_template_t *templateP);
+
+// Serialize a payload template with new slot values.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - templateP: IN. the template.
+// - valueArray: IN. the slot values in the order of dataTemplateInit() slotDataIndexArray. Their types must match the template ones.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// Note: only the value of the slots is encoded, the rest of the payload is copied from the template.
+iowa_status_t dataTemplateSerialize(data_template_t *templateP, iowa_lwm2m_data_t *valueArray, uint8_t **bufferP, size_t *bufferLengthP);
+
+// Release a payload template
+// Returned value: None.
+// Parameters:
+// - templateP: IN. the template.
+void dataTemplateFree(data_template_t *templateP);
+#endif
+
 /**************************************************************
  * Function which give an access to the data
  * Defined in iowa_data_utils.c
@@ -163,30 +242,6 @@ size_t dataUtilsIntToBufferLength(int64_t data, bool withExponent);
 // - withExponent: boolean to use the exponent form.
 size_t dataUtilsIntToBuffer(int64_t data, uint8_t *buffer, size_t length, bool withExponent);
 
-// Convert a buffer to a float
-// Returned value: '1' if the buffer has been converted, '0' otherwise
-// Parameters:
-// - buffer: the buffer to convert.
-// - length: the length of the buffer.
-// - dataP: OUT. the resulted float number.
-size_t dataUtilsBufferToFloat(uint8_t *buffer, size_t length, double *dataP);
-
-// Get the buffer length of a float number
-// Returned value: the length of the buffer
-// Parameters:
-// - data: the float to convert.
-// - withExponent: boolean to use the exponent form.
-size_t dataUtilsFloatToBufferLength(double data, bool withExponent);
-
-// Convert a float to a buffer
-// Returned value: the length of the buffer
-// Parameters:
-// - data: the float to convert.
-// - buffer: the buffer.
-// - length: the length of the buffer.
-// - withExponent: boolean to use the exponent form
-size_t dataUtilsFloatToBuffer(double data, uint8_t *buffer, size_t length, bool withExponent);
-
 // Convert a buffer to a LwM2M data with object link type
 // Returned value: '1' if the buffer has been converted, '0' otherwise
 // Parameters:
@@ -322,12 +377,73 @@ size_t dataUtilsSkipBufferSpace(const uint8_t *bufferP, size_t bufferLength);
 // - num2: the second floating point number to compare.
 bool dataUtilsCompareFloatingPointNumbers(double num1, double num2);
 
+// Initialize an output sink
+// Returned value: None.
+// Parameters:
+// - sinkP: OUT. the output sink.
+// - chunkP, chunkSize: the chunk buffer. If chunkP is nil, the sink writes in a dynamically allocated buffer growing as needed.
+// - flushCb: called when the chunk is full. Ignored if chunkP is nil. If nil, writing more than chunkSize bytes is an error.
+// - userDataP: passed to flushCb. This can be nil.
+// Note: with a dynamic buffer, the caller owns sinkP->chunkP after dataSinkFlush(), sinkP->chunkLength being the serialized length.
+void dataSinkInit(data_sink_t *sinkP, uint8_t *chunkP, size_t chunkSize, data_sink_flush_callback_t flushCb, void *userDataP);
+
+// Write bytes in an output sink
+// Returned value: None. Errors are reported by dataSinkFlush().
+// Parameters:
+// - sinkP: the output sink.
+// - bufferP, length: the bytes to write.
+void dataSinkWrite(data_sink_t *sinkP, const uint8_t *bufferP, size_t length);
+
+// Write the last bytes of an output sink
+// Returned value: IOWA_COAP_NO_ERROR in case of success or the first error which occurred on the sink.
+// Parameters:
+// - sinkP: the output sink.
+iowa_status_t dataSinkFlush(data_sink_t *sinkP);
+
+// Release the dynamically allocated buffer of an output sink, if any
+// Returned value: None.
+// Parameters:
+// - sinkP: the output sink.
+void dataSinkClose(data_sink_t *sinkP);
+
 // Convert half float data into float data
 // Returned value: float conversion
 // Parameters:
 // - halfFloat: 16bits of an half float data.
 float dataUtilsConvertHalfFloatToFloat(uint16_t halfFloat);
 
+/**************************************************************
+ * Floating point number conversions
+ * Defined in iowa_data_float.c
+ **************************************************************/
+
+// Convert a buffer to a float
+// Returned value: '1' if the buffer has been converted, '0' otherwise
+// Parameters:
+// - buffer: the buffer to convert.
+// - length: the length of the buffer.
+// - dataP: OUT. the resulted float number.
+// Note: the result is the double nearest to the decimal value. Values beyond the double range are rejected.
+size_t dataUtilsBufferToFloat(uint8_t *buffer, size_t length, double *dataP);
+
+// Get the buffer length of a float number
+// Returned value: the length of the buffer, 0 for infinity and NaN
+// Parameters:
+// - data: the float to convert.
+// - withExponent: boolean to use the exponent form when it is shorter.
+size_t dataUtilsFloatToBufferLength(double data, bool withExponent);
+
+// Convert a float to a buffer
+// Returned value: the length of the buffer, 0 in case of error
+// Parameters:
+// - data: the float to convert.
+// - buffer: the buffer.
+// - length: the length of the buffer. DATA_FLOAT_STRING_MAX_LENGTH is always enough.
+// - withExponent: boolean to use the exponent form when it is shorter.
+// Note: the text is the shortest one reading back to the same double. Without withExponent, the exponent form is only used
+//       below 1e-6 and from 1e21.
+size_t dataUtilsFloatToBuffer(double data, uint8_t *buffer, size_t length, bool withExponent);
+
 #ifdef __cplusplus
 }
 #endif
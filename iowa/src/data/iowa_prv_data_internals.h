@@ -153,6 +153,14 @@ int8_t cborAddDataToBuffer(iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bu
 * Used for CBOR and SenML CBOR deserialization
 */
 
+// Skip a cbor item, including its nested items.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the buffer containing the item.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: current buffer index.
+int8_t cborSkipItem(uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+
 // Put cbor buffer to number.
 // Returned value: major type of the number in case of success else CBOR_MAJOR_TYPE_NONE if any error.
 // Parameters:
@@ -317,6 +325,16 @@ iowa_status_t cborDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP, size
 // - Support timestamp, URI only
 iowa_status_t senmlJsonSerialize(iowa_lwm2m_data_t *dataP, size_t size, uint8_t **bufferP, size_t *bufferLengthP);
 
+// Stream LwM2M data as SenML JSON in an output sink.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataP, size: data to serialize.
+// - sinkP: IN/OUT. the output sink. It is not flushed.
+// Note:
+// - The data types are checked before writing anything in the sink
+// - The base name and the base time factor the common part of the names and timestamps
+iowa_status_t senmlJsonSerializeToSink(iowa_lwm2m_data_t *dataP, size_t size, data_sink_t *sinkP);
+
 // Convert SenML JSON buffer into LwM2M data.
 // The LwM2M data type is set to the SenML data type.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
@@ -345,6 +363,14 @@ iowa_status_t senmlJsonDeserialize(uint8_t *buffer, size_t bufferLength, iowa_lw
 // - Support timestamp, URI only
 iowa_status_t senmlCborSerialize(iowa_lwm2m_data_t *dataP, size_t size, uint8_t **bufferP, size_t *bufferLengthP);
 
+// Convert LwM2M data into SenML CBOR buffer and locate the value of each record.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataP, size: data to serialize.
+// - valueIndexArray: OUT. array of size elements receiving the index of each record value in the buffer. For a record without value, this is the index of the record end.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+iowa_status_t senmlCborSerializeWithValueIndexes(iowa_lwm2m_data_t *dataP, size_t size, size_t *valueIndexArray, uint8_t **bufferP, size_t *bufferLengthP);
+
 // Convert SenML CBOR buffer into LwM2M data.
 // The LwM2M data type is set to the SenML data type.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
@@ -365,16 +391,18 @@ iowa_status_t senmlCborDeserialize(uint8_t *buffer, size_t bufferLength, iowa_lw
 // Convert LwM2M data into LwM2M CBOR buffer.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
-// - baseUriP: URI targeted by the operation
-// - dataP, size: data to serialize.
+// - baseUriP: URI targeted by the operation. Can be nil.
+// - dataP, size: data to serialize, sorted by URI.
 // - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// Note:
+// - The nested maps with a single entry are collapsed in one key, as an array of IDs.
 iowa_status_t lwm2mCborSerialize(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t size, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert LwM2M CBOR buffer into LwM2M data.
 // The LwM2M data type is set to the CBOR data type.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
-// - baseUriP: URI targeted by the operation
+// - baseUriP: URI targeted by the operation. Can be nil.
 // - bufferP, bufferLength: payload to deserialize.
 // - dataP, dataCount: OUT. data deserialized, dynamically allocated.
 iowa_status_t lwm2mCborDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP, size_t bufferLength, iowa_lwm2m_data_t **dataP, size_t *dataCountP);
@@ -27,3 +27,891 @@
 #include "iowa_prv_data_internals.h"
 #include <float.h>
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+
+// SenML labels as defined in RFC 8428 and LwM2M 1.1
+#define PRV_SENML_CBOR_LABEL_BASE_NAME      -2
+#define PRV_SENML_CBOR_LABEL_BASE_TIME      -3
+#define PRV_SENML_CBOR_LABEL_NAME           0
+#define PRV_SENML_CBOR_LABEL_VALUE          2
+#define PRV_SENML_CBOR_LABEL_STRING_VALUE   3
+#define PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE  4
+#define PRV_SENML_CBOR_LABEL_TIME           6
+#define PRV_SENML_CBOR_LABEL_DATA_VALUE     8
+#define PRV_SENML_CBOR_LABEL_OBJLNK_VALUE   (INT8_MAX - 1) // Text label, see below
+#define PRV_SENML_CBOR_LABEL_NONE           INT8_MAX
+
+#define PRV_SENML_CBOR_OBJLNK_TEXT_LABEL        "vlo"
+#define PRV_SENML_CBOR_OBJLNK_TEXT_LABEL_LENGTH 3
+
+#define PRV_NAME_BUFFER_SIZE                64
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Get the SenML label of the value of a data
+// Returned value: the label, PRV_SENML_CBOR_LABEL_NONE if the data has no value.
+// Parameters:
+// - dataP: the data.
+// - isSupportedP: OUT. false if the data type can not be serialized.
+static int8_t prv_getValueLabel(iowa_lwm2m_data_t *dataP,
+                                bool *isSupportedP)
+{
+    *isSupportedP = true;
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        return PRV_SENML_CBOR_LABEL_STRING_VALUE;
+
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        return PRV_SENML_CBOR_LABEL_DATA_VALUE;
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+    case IOWA_LWM2M_TYPE_FLOAT:
+        return PRV_SENML_CBOR_LABEL_VALUE;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        return PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        return PRV_SENML_CBOR_LABEL_OBJLNK_VALUE;
+
+    case IOWA_LWM2M_TYPE_URI_ONLY:
+    case IOWA_LWM2M_TYPE_NULL:
+        return PRV_SENML_CBOR_LABEL_NONE;
+
+    default:
+        *isSupportedP = false;
+        return PRV_SENML_CBOR_LABEL_NONE;
+    }
+}
+
+// Get the length of a label
+static size_t prv_getLabelLength(int8_t label)
+{
+    if (label == PRV_SENML_CBOR_LABEL_OBJLNK_VALUE)
+    {
+        return 1 + PRV_SENML_CBOR_OBJLNK_TEXT_LABEL_LENGTH;
+    }
+
+    // All the integer labels are encoded in the initial byte
+    return 1;
+}
+
+// Add a label to the buffer
+static int8_t prv_addLabel(int8_t label,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    if (label == PRV_SENML_CBOR_LABEL_OBJLNK_VALUE)
+    {
+        return cborAddStringToBuffer((uint8_t *)PRV_SENML_CBOR_OBJLNK_TEXT_LABEL, PRV_SENML_CBOR_OBJLNK_TEXT_LABEL_LENGTH, bufferP, bufferLength, bufferIndexP, false);
+    }
+    if (label < 0)
+    {
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_NEGATIVE_INTEGER, (uint64_t)(-1 - label), bufferP, bufferLength, bufferIndexP);
+    }
+    return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)label, bufferP, bufferLength, bufferIndexP);
+}
+
+// Get the length of a CBOR signed integer
+static size_t prv_getIntegerLength(int64_t value)
+{
+    if (value < 0)
+    {
+        return cborGetNumberToBufferLength((uint64_t)(-(value + 1)));
+    }
+    return cborGetNumberToBufferLength((uint64_t)value);
+}
+
+// Add a CBOR signed integer to the buffer
+static int8_t prv_addInteger(int64_t value,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    if (value < 0)
+    {
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_NEGATIVE_INTEGER, (uint64_t)(-(value + 1)), bufferP, bufferLength, bufferIndexP);
+    }
+    return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)value, bufferP, bufferLength, bufferIndexP);
+}
+
+// Build the name of a record
+// Returned value: the length of the name, 0 in case of error.
+// Parameters:
+// - dataP: the data.
+// - nameBuffer: OUT. the name of the record. If nil, only the length is computed.
+static size_t prv_getRecordName(iowa_lwm2m_data_t *dataP,
+                                uint8_t *nameBuffer)
+{
+    iowa_lwm2m_uri_t uri;
+
+    dataUtilsGetUri(dataP, &uri);
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    if (nameBuffer == NULL)
+    {
+        return dataUtilsUriToBufferLength(&uri, NULL);
+    }
+    return dataUtilsUriToBuffer(&uri, NULL, nameBuffer, PRV_NAME_BUFFER_SIZE);
+#else
+    if (nameBuffer == NULL)
+    {
+        return dataUtilsUriToBufferLength(&uri);
+    }
+    return dataUtilsUriToBuffer(&uri, nameBuffer, PRV_NAME_BUFFER_SIZE);
+#endif
+}
+
+// Serialize or compute the length of the SenML CBOR records
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - dataP, size: data to serialize.
+// - baseName, baseNameLength: the base name common to all the records.
+// - baseTime: the base time of the records.
+// - bufferP: the buffer to write to. If nil, only the length is computed.
+// - bufferLength: the size of bufferP.
+// - bufferIndexP: IN/OUT. current buffer index.
+// - valueIndexArray: OUT. the index of the value of each record in bufferP. This can be nil.
+static iowa_status_t prv_serializeRecords(iowa_lwm2m_data_t *dataP,
+                                          size_t size,
+                                          uint8_t *baseName,
+                                          size_t baseNameLength,
+                                          int32_t baseTime,
+                                          uint8_t *bufferP,
+                                          size_t bufferLength,
+                                          size_t *bufferIndexP,
+                                          size_t *valueIndexArray)
+{
+    size_t i;
+    uint8_t nameBuffer[PRV_NAME_BUFFER_SIZE];
+    size_t nameLength;
+    int8_t valueLabel;
+    bool isSupported;
+    size_t pairCount;
+    int64_t relativeTime;
+
+#ifndef LWM2M_SUPPORT_TIMESTAMP
+    (void)baseTime;
+#endif
+
+    if (bufferP == NULL)
+    {
+        *bufferIndexP += cborGetNumberToBufferLength(size);
+    }
+    else if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, size, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        valueLabel = prv_getValueLabel(dataP + i, &isSupported);
+        if (isSupported == false)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported data type: %s.", STR_LWM2M_TYPE(dataP[i].type));
+            return IOWA_COAP_406_NOT_ACCEPTABLE;
+        }
+
+        // The length pass does not need the name itself
+        nameLength = prv_getRecordName(dataP + i, (bufferP == NULL) ? NULL : nameBuffer);
+        if (nameLength < baseNameLength)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        nameLength -= baseNameLength;
+
+        relativeTime = 0;
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+        relativeTime = (int64_t)dataP[i].timestamp - baseTime;
+#endif
+
+        pairCount = 0;
+        if (i == 0)
+        {
+            if (baseNameLength != 0)
+            {
+                pairCount++;
+            }
+            if (baseTime != 0)
+            {
+                pairCount++;
+            }
+        }
+        if (nameLength != 0)
+        {
+            pairCount++;
+        }
+        if (relativeTime != 0)
+        {
+            pairCount++;
+        }
+        if (valueLabel != PRV_SENML_CBOR_LABEL_NONE)
+        {
+            pairCount++;
+        }
+
+        if (bufferP == NULL)
+        {
+            *bufferIndexP += cborGetNumberToBufferLength(pairCount);
+            if (i == 0)
+            {
+                if (baseNameLength != 0)
+                {
+                    *bufferIndexP += prv_getLabelLength(PRV_SENML_CBOR_LABEL_BASE_NAME) + cborGetNumberToBufferLength(baseNameLength) + baseNameLength;
+                }
+                if (baseTime != 0)
+                {
+                    *bufferIndexP += prv_getLabelLength(PRV_SENML_CBOR_LABEL_BASE_TIME) + prv_getIntegerLength(baseTime);
+                }
+            }
+            if (nameLength != 0)
+            {
+                *bufferIndexP += prv_getLabelLength(PRV_SENML_CBOR_LABEL_NAME) + cborGetNumberToBufferLength(nameLength) + nameLength;
+            }
+            if (relativeTime != 0)
+            {
+                *bufferIndexP += prv_getLabelLength(PRV_SENML_CBOR_LABEL_TIME) + prv_getIntegerLength(relativeTime);
+            }
+            if (valueLabel != PRV_SENML_CBOR_LABEL_NONE)
+            {
+                *bufferIndexP += prv_getLabelLength(valueLabel) + cborGetDataToBufferLength(dataP + i);
+            }
+            continue;
+        }
+
+        if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS, pairCount, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        if (i == 0)
+        {
+            if (baseNameLength != 0)
+            {
+                if (prv_addLabel(PRV_SENML_CBOR_LABEL_BASE_NAME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                    || cborAddStringToBuffer(baseName, baseNameLength, bufferP, bufferLength, bufferIndexP, false) != CBOR_NO_ERROR)
+                {
+                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                }
+            }
+            if (baseTime != 0)
+            {
+                if (prv_addLabel(PRV_SENML_CBOR_LABEL_BASE_TIME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                    || prv_addInteger(baseTime, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+                {
+                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                }
+            }
+        }
+        if (nameLength != 0)
+        {
+            if (prv_addLabel(PRV_SENML_CBOR_LABEL_NAME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                || cborAddStringToBuffer(nameBuffer + baseNameLength, nameLength, bufferP, bufferLength, bufferIndexP, false) != CBOR_NO_ERROR)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+        if (relativeTime != 0)
+        {
+            if (prv_addLabel(PRV_SENML_CBOR_LABEL_TIME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                || prv_addInteger(relativeTime, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+        if (valueLabel != PRV_SENML_CBOR_LABEL_NONE)
+        {
+            if (prv_addLabel(valueLabel, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            if (valueIndexArray != NULL)
+            {
+                valueIndexArray[i] = *bufferIndexP;
+            }
+            if (cborAddDataToBuffer(dataP + i, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+        else if (valueIndexArray != NULL)
+        {
+            valueIndexArray[i] = *bufferIndexP;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Read a text string in a fixed size buffer
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+static int8_t prv_getText(uint64_t convertResult,
+                          uint8_t *bufferP,
+                          size_t bufferLength,
+                          size_t *bufferIndexP,
+                          uint8_t *textP,
+                          size_t textSize,
+                          size_t *textLengthP)
+{
+    uint8_t *stringP;
+    size_t stringLength;
+
+    if (convertResult != CBOR_NUMBER_MAX)
+    {
+        // Avoid an allocation for definite length strings
+        if (convertResult > textSize
+            || convertResult > bufferLength - *bufferIndexP)
+        {
+            return CBOR_ERROR;
+        }
+        memcpy(textP, bufferP + *bufferIndexP, (size_t)convertResult);
+        *textLengthP = (size_t)convertResult;
+        *bufferIndexP += *textLengthP;
+
+        return CBOR_NO_ERROR;
+    }
+
+    if (cborPutBufferToString(CBOR_MAJOR_TYPE_TEXT_STRING, convertResult, &stringP, &stringLength, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+    if (stringLength > textSize)
+    {
+        iowa_system_free(stringP);
+        return CBOR_ERROR;
+    }
+    if (stringLength != 0)
+    {
+        memcpy(textP, stringP, stringLength);
+    }
+    *textLengthP = stringLength;
+    iowa_system_free(stringP);
+
+    return CBOR_NO_ERROR;
+}
+
+// Read a numeric item (integer, float or decimal fraction) as a double
+static int8_t prv_getNumber(uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *bufferIndexP,
+                            double *valueP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    iowa_lwm2m_data_t data;
+
+    majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+    if (majorType != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER
+        && majorType != CBOR_MAJOR_TYPE_NEGATIVE_INTEGER
+        && majorType != CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC
+        && majorType != CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA)
+    {
+        return CBOR_ERROR;
+    }
+
+    memset(&data, 0, sizeof(iowa_lwm2m_data_t));
+    if (cborPutBufferToData(majorType, number, &data, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    switch (data.type)
+    {
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        *valueP = (double)data.value.asInteger;
+        break;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        *valueP = data.value.asFloat;
+        break;
+
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        iowa_system_free(data.value.asBuffer.buffer);
+        return CBOR_ERROR;
+
+    default:
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+// Count the records of a SenML CBOR pack
+static int8_t prv_getRecordCount(uint64_t convertResult,
+                                 uint8_t *bufferP,
+                                 size_t bufferLength,
+                                 size_t index,
+                                 size_t *countP)
+{
+    if (convertResult != CBOR_NUMBER_MAX)
+    {
+        // Each record takes at least one byte
+        if (convertResult > bufferLength - index)
+        {
+            return CBOR_ERROR;
+        }
+        *countP = (size_t)convertResult;
+
+        return CBOR_NO_ERROR;
+    }
+
+    *countP = 0;
+    while (index < bufferLength
+           && bufferP[index] != CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+    {
+        if (cborSkipItem(bufferP, bufferLength, &index) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        *countP += 1;
+    }
+    if (index >= bufferLength)
+    {
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR_INDEFINITE;
+}
+
+// Decode one SenML CBOR record
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP, bufferLength, bufferIndexP: the payload and the current index.
+// - baseName, baseNameLengthP: IN/OUT. the current base name.
+// - baseTimeP: IN/OUT. the current base time.
+// - dataP: OUT. the decoded data.
+static int8_t prv_parseRecord(uint8_t *bufferP,
+                              size_t bufferLength,
+                              size_t *bufferIndexP,
+                              uint8_t baseName[PRV_NAME_BUFFER_SIZE],
+                              size_t *baseNameLengthP,
+                              double *baseTimeP,
+                              iowa_lwm2m_data_t *dataP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    uint64_t pairCount;
+    uint64_t pairIndex;
+    uint8_t name[PRV_NAME_BUFFER_SIZE];
+    size_t nameLength;
+    double time;
+    bool hasValue;
+    iowa_lwm2m_uri_t uri;
+    size_t res;
+
+    majorType = cborPutBufferToNumber(&pairCount, bufferP, bufferLength, bufferIndexP);
+    if (majorType != CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Record is not a map.");
+        return CBOR_ERROR;
+    }
+
+    nameLength = 0;
+    time = 0;
+    hasValue = false;
+    dataP->type = IOWA_LWM2M_TYPE_URI_ONLY;
+
+    for (pairIndex = 0; pairIndex < pairCount; pairIndex++)
+    {
+        int64_t label;
+
+        if (pairCount == CBOR_NUMBER_MAX)
+        {
+            if (*bufferIndexP >= bufferLength)
+            {
+                return CBOR_ERROR;
+            }
+            if (bufferP[*bufferIndexP] == CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+            {
+                *bufferIndexP += 1;
+                break;
+            }
+        }
+
+        majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+        switch (majorType)
+        {
+        case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+            label = (number >= PRV_SENML_CBOR_LABEL_OBJLNK_VALUE) ? PRV_SENML_CBOR_LABEL_NONE : (int64_t)number;
+            break;
+
+        case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+            label = (number > INT8_MAX) ? PRV_SENML_CBOR_LABEL_NONE : -1 - (int64_t)number;
+            break;
+
+        case CBOR_MAJOR_TYPE_TEXT_STRING:
+        {
+            uint8_t textLabel[PRV_SENML_CBOR_OBJLNK_TEXT_LABEL_LENGTH];
+            size_t textLabelLength;
+
+            if (number == PRV_SENML_CBOR_OBJLNK_TEXT_LABEL_LENGTH)
+            {
+                if (prv_getText(number, bufferP, bufferLength, bufferIndexP, textLabel, sizeof(textLabel), &textLabelLength) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                label = (memcmp(textLabel, PRV_SENML_CBOR_OBJLNK_TEXT_LABEL, PRV_SENML_CBOR_OBJLNK_TEXT_LABEL_LENGTH) == 0) ? PRV_SENML_CBOR_LABEL_OBJLNK_VALUE : PRV_SENML_CBOR_LABEL_NONE;
+            }
+            else
+            {
+                if (cborGetBufferToStringLength(majorType, number, &textLabelLength, bufferP, bufferLength, bufferIndexP) <= CBOR_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                label = PRV_SENML_CBOR_LABEL_NONE;
+            }
+            break;
+        }
+
+        default:
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid label.");
+            return CBOR_ERROR;
+        }
+
+        switch (label)
+        {
+        case PRV_SENML_CBOR_LABEL_BASE_NAME:
+            majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+            if (majorType != CBOR_MAJOR_TYPE_TEXT_STRING
+                || prv_getText(number, bufferP, bufferLength, bufferIndexP, baseName, PRV_NAME_BUFFER_SIZE, baseNameLengthP) != CBOR_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid base name.");
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_CBOR_LABEL_NAME:
+            majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+            if (majorType != CBOR_MAJOR_TYPE_TEXT_STRING
+                || prv_getText(number, bufferP, bufferLength, bufferIndexP, name, PRV_NAME_BUFFER_SIZE, &nameLength) != CBOR_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid name.");
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_CBOR_LABEL_BASE_TIME:
+            if (prv_getNumber(bufferP, bufferLength, bufferIndexP, baseTimeP) != CBOR_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid base time.");
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_CBOR_LABEL_TIME:
+            if (prv_getNumber(bufferP, bufferLength, bufferIndexP, &time) != CBOR_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid time.");
+                return CBOR_ERROR;
+            }
+            break;
+
+        case PRV_SENML_CBOR_LABEL_VALUE:
+        case PRV_SENML_CBOR_LABEL_STRING_VALUE:
+        case PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE:
+        case PRV_SENML_CBOR_LABEL_DATA_VALUE:
+        case PRV_SENML_CBOR_LABEL_OBJLNK_VALUE:
+            if (hasValue == true)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Record has several values.");
+                return CBOR_ERROR;
+            }
+            hasValue = true;
+
+            majorType = cborPutBufferToNumber(&number, bufferP, bufferLength, bufferIndexP);
+            if (majorType == CBOR_MAJOR_TYPE_NONE
+                || cborPutBufferToData(majorType, number, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid value.");
+                return CBOR_ERROR;
+            }
+
+            switch (label)
+            {
+            case PRV_SENML_CBOR_LABEL_VALUE:
+                res = (dataP->type == IOWA_LWM2M_TYPE_INTEGER || dataP->type == IOWA_LWM2M_TYPE_TIME || dataP->type == IOWA_LWM2M_TYPE_FLOAT);
+                break;
+
+            case PRV_SENML_CBOR_LABEL_STRING_VALUE:
+                res = (dataP->type == IOWA_LWM2M_TYPE_STRING);
+                break;
+
+            case PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE:
+                res = (dataP->type == IOWA_LWM2M_TYPE_BOOLEAN);
+                break;
+
+            case PRV_SENML_CBOR_LABEL_DATA_VALUE:
+                // Some implementations send the data value Base64 encoded
+                res = (dataP->type == IOWA_LWM2M_TYPE_OPAQUE || dataP->type == IOWA_LWM2M_TYPE_STRING);
+                break;
+
+            default:
+                res = 0;
+                if (dataP->type == IOWA_LWM2M_TYPE_STRING)
+                {
+                    uint8_t *objectLinkP;
+
+                    objectLinkP = dataP->value.asBuffer.buffer;
+                    res = dataUtilsBufferToObjectLink(objectLinkP, dataP->value.asBuffer.length, dataP);
+                    if (res != 0)
+                    {
+                        iowa_system_free(objectLinkP);
+                    }
+                }
+                break;
+            }
+            if (res == 0)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Value type %s does not match the label.", STR_LWM2M_TYPE(dataP->type));
+                return CBOR_ERROR;
+            }
+            break;
+
+        default:
+            // Unsupported labels (units, sums, version...) are ignored
+            if (cborSkipItem(bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            break;
+        }
+    }
+
+    // Resolve the name
+    if (*baseNameLengthP + nameLength == 0
+        || *baseNameLengthP + nameLength > PRV_NAME_BUFFER_SIZE)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid record name.");
+        return CBOR_ERROR;
+    }
+    memmove(name + *baseNameLengthP, name, nameLength);
+    memcpy(name, baseName, *baseNameLengthP);
+    nameLength += *baseNameLengthP;
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    res = dataUtilsBufferToUri((const char *)name, nameLength, &uri, NULL);
+#else
+    res = dataUtilsBufferToUri((const char *)name, nameLength, &uri);
+#endif
+    if (res == 0
+        || uri.objectId == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Invalid record name \"%.*s\".", nameLength, name);
+        return CBOR_ERROR;
+    }
+    dataUtilsSetUri(dataP, &uri);
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    dataP->timestamp = (int32_t)(*baseTimeP + time);
+#else
+    (void)time;
+#endif
+
+    return CBOR_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t senmlCborSerialize(iowa_lwm2m_data_t *dataP,
+                                 size_t size,
+                                 uint8_t **bufferP,
+                                 size_t *bufferLengthP)
+{
+    return senmlCborSerializeWithValueIndexes(dataP, size, NULL, bufferP, bufferLengthP);
+}
+
+iowa_status_t senmlCborSerializeWithValueIndexes(iowa_lwm2m_data_t *dataP,
+                                                 size_t size,
+                                                 size_t *valueIndexArray,
+                                                 uint8_t **bufferP,
+                                                 size_t *bufferLengthP)
+{
+    iowa_status_t result;
+    iowa_lwm2m_uri_t baseUri;
+    lwm2m_uri_depth_t uriDepth;
+    uint8_t baseName[PRV_NAME_BUFFER_SIZE];
+    size_t baseNameLength;
+    int32_t baseTime;
+    size_t index;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %d", size);
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    // The base name factors the common part of the names
+    baseNameLength = 0;
+    if (size > 1)
+    {
+        bool isDeeper;
+
+        isDeeper = dataUtilsGetBaseUri(dataP, size, &baseUri, &uriDepth);
+        if (uriDepth != LWM2M_URI_DEPTH_ROOT)
+        {
+#ifdef LWM2M_ALTPATH_SUPPORT
+            baseNameLength = dataUtilsUriToBuffer(&baseUri, NULL, baseName, PRV_NAME_BUFFER_SIZE);
+#else
+            baseNameLength = dataUtilsUriToBuffer(&baseUri, baseName, PRV_NAME_BUFFER_SIZE);
+#endif
+            if (baseNameLength == 0)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            if (isDeeper == true)
+            {
+                baseName[baseNameLength] = '/';
+                baseNameLength++;
+            }
+        }
+    }
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    result = dataUtilsGetBaseTime(dataP, size, &baseTime);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+#else
+    baseTime = 0;
+#endif
+
+    index = 0;
+    result = prv_serializeRecords(dataP, size, baseName, baseNameLength, baseTime, NULL, 0, &index, NULL);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Failed to retrieve the length");
+        return result;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(index);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(index);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    *bufferLengthP = index;
+
+    index = 0;
+    result = prv_serializeRecords(dataP, size, baseName, baseNameLength, baseTime, *bufferP, *bufferLengthP, &index, valueIndexArray);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        *bufferLengthP = 0;
+        return result;
+    }
+
+    IOWA_LOG_ARG_BUFFER_TRACE(IOWA_PART_DATA, "SenML CBOR payload:", *bufferP, *bufferLengthP, "length: %u", *bufferLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t senmlCborDeserialize(uint8_t *buffer,
+                                   size_t bufferLength,
+                                   iowa_lwm2m_data_t **dataP,
+                                   size_t *dataCountP)
+{
+    major_type_t majorType;
+    uint64_t number;
+    size_t index;
+    size_t count;
+    size_t i;
+    int8_t isIndefinite;
+    uint8_t baseName[PRV_NAME_BUFFER_SIZE];
+    size_t baseNameLength;
+    double baseTime;
+
+    assert(dataP != NULL);
+    assert(dataCountP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "bufferLength: %u", bufferLength);
+
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    if (buffer == NULL
+        || bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Empty payload.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    index = 0;
+    majorType = cborPutBufferToNumber(&number, buffer, bufferLength, &index);
+    if (majorType != CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Payload is not a SenML pack.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    isIndefinite = prv_getRecordCount(number, buffer, bufferLength, index, &count);
+    if (isIndefinite <= CBOR_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid SenML pack.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    if (count == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(count * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(count * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, count * sizeof(iowa_lwm2m_data_t));
+
+    baseNameLength = 0;
+    baseTime = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (prv_parseRecord(buffer, bufferLength, &index, baseName, &baseNameLength, &baseTime, *dataP + i) != CBOR_NO_ERROR)
+        {
+            goto error;
+        }
+    }
+    if (isIndefinite == CBOR_NO_ERROR_INDEFINITE)
+    {
+        // Skip the break
+        index++;
+    }
+    if (index != bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Trailing bytes after the SenML pack.");
+        goto error;
+    }
+
+    *dataCountP = count;
+
+    return IOWA_COAP_NO_ERROR;
+
+error:
+    dataLwm2mFree(count, *dataP);
+    *dataP = NULL;
+
+    return IOWA_COAP_400_BAD_REQUEST;
+}
+
+#endif // LWM2M_SUPPORT_SENML_CBOR
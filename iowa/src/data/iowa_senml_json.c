@@ -23,3 +23,1317 @@
 #include "iowa_prv_data_internals.h"
 #include <math.h>
 
+
+#ifdef LWM2M_SUPPORT_SENML_JSON
+
+#define PRV_NAME_BUFFER_SIZE        64
+#define PRV_LABEL_BUFFER_SIZE       4
+#define PRV_STR_LENGTH              32
+#define PRV_BASE64_SLICE_LENGTH     48 // Multiple of 3 so that no padding is inserted inside the value
+#define PRV_OBJECT_LINK_MAX_LENGTH  11 // 65535:65535
+#define PRV_DYNAMIC_RECORD_SIZE     32 // Estimated size of a record, used for the first allocation
+#define PRV_MAX_NESTING_LEVEL       16
+
+#define PRV_WRITE_LITERAL(S, L) dataSinkWrite((S), (const uint8_t *)(L), sizeof(L) - 1)
+
+typedef enum
+{
+    PRV_LABEL_UNKNOWN = 0,
+    PRV_LABEL_BASE_NAME,
+    PRV_LABEL_BASE_TIME,
+    PRV_LABEL_NAME,
+    PRV_LABEL_TIME,
+    PRV_LABEL_VALUE,
+    PRV_LABEL_STRING_VALUE,
+    PRV_LABEL_BOOLEAN_VALUE,
+    PRV_LABEL_DATA_VALUE,
+    PRV_LABEL_OBJLNK_VALUE
+} prv_label_t;
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Write a JSON string, escaping the characters as needed
+static void prv_writeString(data_sink_t *sinkP,
+                            const uint8_t *stringP,
+                            size_t length)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    size_t start;
+    size_t i;
+
+    PRV_WRITE_LITERAL(sinkP, "\"");
+
+    start = 0;
+    for (i = 0; i < length; i++)
+    {
+        uint8_t escape[6];
+        size_t escapeLength;
+
+        if (stringP[i] != '"'
+            && stringP[i] != '\\'
+            && stringP[i] >= 0x20)
+        {
+            continue;
+        }
+
+        // Write the characters not needing escape at once
+        dataSinkWrite(sinkP, stringP + start, i - start);
+        start = i + 1;
+
+        escape[0] = '\\';
+        escapeLength = 2;
+        switch (stringP[i])
+        {
+        case '"':
+        case '\\':
+            escape[1] = stringP[i];
+            break;
+
+        case '\b':
+            escape[1] = 'b';
+            break;
+
+        case '\f':
+            escape[1] = 'f';
+            break;
+
+        case '\n':
+            escape[1] = 'n';
+            break;
+
+        case '\r':
+            escape[1] = 'r';
+            break;
+
+        case '\t':
+            escape[1] = 't';
+            break;
+
+        default:
+            escape[1] = 'u';
+            escape[2] = '0';
+            escape[3] = '0';
+            escape[4] = (uint8_t)hexDigits[stringP[i] >> 4];
+            escape[5] = (uint8_t)hexDigits[stringP[i] & 0x0F];
+            escapeLength = 6;
+            break;
+        }
+        dataSinkWrite(sinkP, escape, escapeLength);
+    }
+    dataSinkWrite(sinkP, stringP + start, length - start);
+
+    PRV_WRITE_LITERAL(sinkP, "\"");
+}
+
+// Write a label, preceded by a comma if it is not the first one of the record
+static void prv_writeLabel(data_sink_t *sinkP,
+                           const char *labelP,
+                           size_t labelLength,
+                           bool *isFirstP)
+{
+    if (*isFirstP == true)
+    {
+        *isFirstP = false;
+    }
+    else
+    {
+        PRV_WRITE_LITERAL(sinkP, ",");
+    }
+    PRV_WRITE_LITERAL(sinkP, "\"");
+    dataSinkWrite(sinkP, (const uint8_t *)labelP, labelLength);
+    PRV_WRITE_LITERAL(sinkP, "\":");
+}
+
+#define PRV_WRITE_LABEL(S, L, F) prv_writeLabel((S), (L), sizeof(L) - 1, (F))
+
+// Write an integer
+static void prv_writeInteger(data_sink_t *sinkP,
+                             int64_t value)
+{
+    uint8_t intString[PRV_STR_LENGTH];
+    size_t length;
+
+    length = dataUtilsIntToBuffer(value, intString, PRV_STR_LENGTH, false);
+    if (length == 0)
+    {
+        sinkP->result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        return;
+    }
+    dataSinkWrite(sinkP, intString, length);
+}
+
+// Write an opaque value as a Base64 URL-safe string without padding
+static void prv_writeBase64(data_sink_t *sinkP,
+                            uint8_t *bufferP,
+                            size_t length)
+{
+    uint8_t base64[(PRV_BASE64_SLICE_LENGTH / 3) * 4];
+    size_t base64Length;
+    size_t sliceLength;
+
+    PRV_WRITE_LITERAL(sinkP, "\"");
+    while (length > 0)
+    {
+        sliceLength = (length > PRV_BASE64_SLICE_LENGTH) ? PRV_BASE64_SLICE_LENGTH : length;
+        utils_b64Encode(bufferP, sliceLength, base64, &base64Length, BASE64_MODE_URI_SAFE);
+        dataSinkWrite(sinkP, base64, base64Length);
+        bufferP += sliceLength;
+        length -= sliceLength;
+    }
+    PRV_WRITE_LITERAL(sinkP, "\"");
+}
+
+// Write the value of a data with its label
+static void prv_writeValue(data_sink_t *sinkP,
+                           iowa_lwm2m_data_t *dataP,
+                           bool *isFirstP)
+{
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        PRV_WRITE_LABEL(sinkP, "vs", isFirstP);
+        prv_writeString(sinkP, dataP->value.asBuffer.buffer, dataP->value.asBuffer.length);
+        break;
+
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        PRV_WRITE_LABEL(sinkP, "vd", isFirstP);
+        prv_writeBase64(sinkP, dataP->value.asBuffer.buffer, dataP->value.asBuffer.length);
+        break;
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        PRV_WRITE_LABEL(sinkP, "v", isFirstP);
+        prv_writeInteger(sinkP, dataP->value.asInteger);
+        break;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+    {
+        uint8_t floatString[DATA_FLOAT_STRING_MAX_LENGTH];
+        size_t length;
+
+        PRV_WRITE_LABEL(sinkP, "v", isFirstP);
+        length = dataUtilsFloatToBuffer(dataP->value.asFloat, floatString, DATA_FLOAT_STRING_MAX_LENGTH, false);
+        if (length == 0)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Float to text conversion failed");
+            sinkP->result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            return;
+        }
+        dataSinkWrite(sinkP, floatString, length);
+        break;
+    }
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        PRV_WRITE_LABEL(sinkP, "vb", isFirstP);
+        if (dataP->value.asBoolean == true)
+        {
+            PRV_WRITE_LITERAL(sinkP, "true");
+        }
+        else
+        {
+            PRV_WRITE_LITERAL(sinkP, "false");
+        }
+        break;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+    {
+        uint8_t objectLink[PRV_OBJECT_LINK_MAX_LENGTH];
+        size_t length;
+
+        PRV_WRITE_LABEL(sinkP, "vlo", isFirstP);
+        length = dataUtilsObjectLinkToBuffer(dataP, objectLink, PRV_OBJECT_LINK_MAX_LENGTH);
+        if (length == 0)
+        {
+            sinkP->result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            return;
+        }
+        prv_writeString(sinkP, objectLink, length);
+        break;
+    }
+
+    default:
+        // URI only and null data have no value
+        break;
+    }
+}
+
+// Build the name of a record
+// Returned value: the length of the name, 0 in case of error.
+static size_t prv_getRecordName(iowa_lwm2m_data_t *dataP,
+                                uint8_t *nameBuffer)
+{
+    iowa_lwm2m_uri_t uri;
+
+    dataUtilsGetUri(dataP, &uri);
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    return dataUtilsUriToBuffer(&uri, NULL, nameBuffer, PRV_NAME_BUFFER_SIZE);
+#else
+    return dataUtilsUriToBuffer(&uri, nameBuffer, PRV_NAME_BUFFER_SIZE);
+#endif
+}
+
+// Skip the spaces
+static void prv_skipSpaces(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *indexP)
+{
+    *indexP += dataUtilsSkipBufferSpace(bufferP + *indexP, bufferLength - *indexP);
+}
+
+// Check the next character, after the spaces, and skip it if it matches
+static bool prv_checkChar(uint8_t *bufferP,
+                          size_t bufferLength,
+                          size_t *indexP,
+                          uint8_t c)
+{
+    prv_skipSpaces(bufferP, bufferLength, indexP);
+    if (*indexP < bufferLength
+        && bufferP[*indexP] == c)
+    {
+        *indexP += 1;
+        return true;
+    }
+    return false;
+}
+
+// Get the value of an hexadecimal digit
+// Returned value: the value, -1 if the character is not an hexadecimal digit.
+static int prv_hexValue(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Read the four hexadecimal digits of a \u escape
+static bool prv_parseUnicodeEscape(uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   size_t index,
+                                   uint32_t *codePointP)
+{
+    size_t i;
+
+    if (bufferLength - index < 4)
+    {
+        return false;
+    }
+
+    *codePointP = 0;
+    for (i = 0; i < 4; i++)
+    {
+        int digit;
+
+        digit = prv_hexValue(bufferP[index + i]);
+        if (digit < 0)
+        {
+            return false;
+        }
+        *codePointP = (*codePointP << 4) | (uint32_t)digit;
+    }
+
+    return true;
+}
+
+// Read a JSON string, the index pointing to the opening quote
+// Returned value: true in case of success, false otherwise.
+// Parameters:
+// - bufferP, bufferLength, indexP: the payload and the current index.
+// - stringP: OUT. the unescaped string. If nil, the string is only checked and measured.
+// - stringSize: the size of stringP.
+// - stringLengthP: OUT. the length of the unescaped string.
+static bool prv_parseString(uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *indexP,
+                            uint8_t *stringP,
+                            size_t stringSize,
+                            size_t *stringLengthP)
+{
+    size_t index;
+    size_t length;
+
+    index = *indexP;
+    if (index >= bufferLength
+        || bufferP[index] != '"')
+    {
+        return false;
+    }
+    index++;
+
+    length = 0;
+    while (index < bufferLength
+           && bufferP[index] != '"')
+    {
+        uint8_t utf8[4];
+        size_t utf8Length;
+
+        if (bufferP[index] < 0x20)
+        {
+            return false;
+        }
+
+        if (bufferP[index] != '\\')
+        {
+            utf8[0] = bufferP[index];
+            utf8Length = 1;
+            index++;
+        }
+        else
+        {
+            index++;
+            if (index >= bufferLength)
+            {
+                return false;
+            }
+            utf8Length = 1;
+            switch (bufferP[index])
+            {
+            case '"':
+            case '\\':
+            case '/':
+                utf8[0] = bufferP[index];
+                break;
+
+            case 'b':
+                utf8[0] = '\b';
+                break;
+
+            case 'f':
+                utf8[0] = '\f';
+                break;
+
+            case 'n':
+                utf8[0] = '\n';
+                break;
+
+            case 'r':
+                utf8[0] = '\r';
+                break;
+
+            case 't':
+                utf8[0] = '\t';
+                break;
+
+            case 'u':
+            {
+                uint32_t codePoint;
+
+                if (prv_parseUnicodeEscape(bufferP, bufferLength, index + 1, &codePoint) == false)
+                {
+                    return false;
+                }
+                index += 4;
+
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+                {
+                    uint32_t lowSurrogate;
+
+                    // A high surrogate must be followed by a low surrogate
+                    if (bufferLength - index < 7
+                        || bufferP[index + 1] != '\\'
+                        || bufferP[index + 2] != 'u'
+                        || prv_parseUnicodeEscape(bufferP, bufferLength, index + 3, &lowSurrogate) == false
+                        || lowSurrogate < 0xDC00
+                        || lowSurrogate > 0xDFFF)
+                    {
+                        return false;
+                    }
+                    index += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                }
+                else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+                {
+                    return false;
+                }
+
+                if (codePoint < 0x80)
+                {
+                    utf8[0] = (uint8_t)codePoint;
+                }
+                else if (codePoint < 0x800)
+                {
+                    utf8[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+                    utf8[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+                    utf8Length = 2;
+                }
+                else if (codePoint < 0x10000)
+                {
+                    utf8[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+                    utf8[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+                    utf8[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+                    utf8Length = 3;
+                }
+                else
+                {
+                    utf8[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+                    utf8[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+                    utf8[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+                    utf8[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+                    utf8Length = 4;
+                }
+                break;
+            }
+
+            default:
+                return false;
+            }
+            index++;
+        }
+
+        if (stringP != NULL)
+        {
+            if (utf8Length > stringSize - length)
+            {
+                return false;
+            }
+            memcpy(stringP + length, utf8, utf8Length);
+        }
+        length += utf8Length;
+    }
+    if (index >= bufferLength)
+    {
+        return false;
+    }
+
+    *indexP = index + 1;
+    *stringLengthP = length;
+
+    return true;
+}
+
+// Read a JSON string in a dynamically allocated buffer
+static bool prv_parseAllocatedString(uint8_t *bufferP,
+                                     size_t bufferLength,
+                                     size_t *indexP,
+                                     uint8_t **stringP,
+                                     size_t *stringLengthP)
+{
+    size_t index;
+
+    *stringP = NULL;
+
+    index = *indexP;
+    if (prv_parseString(bufferP, bufferLength, &index, NULL, 0, stringLengthP) == false)
+    {
+        return false;
+    }
+    if (*stringLengthP == 0)
+    {
+        *indexP = index;
+        return true;
+    }
+
+    *stringP = (uint8_t *)iowa_system_malloc(*stringLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*stringP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(*stringLengthP);
+        return false;
+    }
+#endif
+
+    return prv_parseString(bufferP, bufferLength, indexP, *stringP, *stringLengthP, stringLengthP);
+}
+
+// Read a JSON number
+// Returned value: true in case of success, false otherwise.
+// Parameters:
+// - bufferP, bufferLength, indexP: the payload and the current index.
+// - dataP: OUT. an integer or a float data. This can be nil.
+// - valueP: OUT. the number as a double. This can be nil.
+static bool prv_parseNumber(uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *indexP,
+                            iowa_lwm2m_data_t *dataP,
+                            double *valueP)
+{
+    size_t start;
+    bool isInteger;
+    double value;
+
+    start = *indexP;
+    isInteger = true;
+    while (*indexP < bufferLength)
+    {
+        uint8_t c;
+
+        c = bufferP[*indexP];
+        if (c == '.' || c == 'e' || c == 'E')
+        {
+            isInteger = false;
+        }
+        else if ((c < '0' || c > '9') && c != '-' && c != '+')
+        {
+            break;
+        }
+        *indexP += 1;
+    }
+    if (*indexP == start)
+    {
+        return false;
+    }
+
+    if (isInteger == true)
+    {
+        int64_t intValue;
+
+        if (dataUtilsBufferToInt(bufferP + start, *indexP - start, &intValue) != 0)
+        {
+            if (dataP != NULL)
+            {
+                dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+                dataP->value.asInteger = intValue;
+            }
+            if (valueP != NULL)
+            {
+                *valueP = (double)intValue;
+            }
+            return true;
+        }
+        // The value may be too large for an integer
+    }
+
+    if (dataUtilsBufferToFloat(bufferP + start, *indexP - start, &value) == 0)
+    {
+        return false;
+    }
+    if (dataP != NULL)
+    {
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = value;
+    }
+    if (valueP != NULL)
+    {
+        *valueP = value;
+    }
+
+    return true;
+}
+
+// Check a literal (true, false or null)
+static bool prv_parseLiteral(uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *indexP,
+                             const char *literal,
+                             size_t literalLength)
+{
+    if (bufferLength - *indexP < literalLength
+        || memcmp(bufferP + *indexP, literal, literalLength) != 0)
+    {
+        return false;
+    }
+    *indexP += literalLength;
+
+    return true;
+}
+
+#define PRV_PARSE_LITERAL(B, L, I, S) prv_parseLiteral((B), (L), (I), (S), sizeof(S) - 1)
+
+// Skip a JSON value, including the nested ones
+static bool prv_skipValue(uint8_t *bufferP,
+                          size_t bufferLength,
+                          size_t *indexP,
+                          size_t level)
+{
+    size_t length;
+    uint8_t closingChar;
+
+    prv_skipSpaces(bufferP, bufferLength, indexP);
+    if (*indexP >= bufferLength)
+    {
+        return false;
+    }
+
+    switch (bufferP[*indexP])
+    {
+    case '"':
+        return prv_parseString(bufferP, bufferLength, indexP, NULL, 0, &length);
+
+    case 't':
+        return PRV_PARSE_LITERAL(bufferP, bufferLength, indexP, "true");
+
+    case 'f':
+        return PRV_PARSE_LITERAL(bufferP, bufferLength, indexP, "false");
+
+    case 'n':
+        return PRV_PARSE_LITERAL(bufferP, bufferLength, indexP, "null");
+
+    case '{':
+        closingChar = '}';
+        break;
+
+    case '[':
+        closingChar = ']';
+        break;
+
+    default:
+        return prv_parseNumber(bufferP, bufferLength, indexP, NULL, NULL);
+    }
+
+    if (level >= PRV_MAX_NESTING_LEVEL)
+    {
+        return false;
+    }
+
+    *indexP += 1;
+    if (prv_checkChar(bufferP, bufferLength, indexP, closingChar) == true)
+    {
+        return true;
+    }
+    do
+    {
+        if (closingChar == '}')
+        {
+            prv_skipSpaces(bufferP, bufferLength, indexP);
+            if (prv_parseString(bufferP, bufferLength, indexP, NULL, 0, &length) == false
+                || prv_checkChar(bufferP, bufferLength, indexP, ':') == false)
+            {
+                return false;
+            }
+        }
+        if (prv_skipValue(bufferP, bufferLength, indexP, level + 1) == false)
+        {
+            return false;
+        }
+    } while (prv_checkChar(bufferP, bufferLength, indexP, ',') == true);
+
+    return prv_checkChar(bufferP, bufferLength, indexP, closingChar);
+}
+
+// Read a record label
+static bool prv_parseLabel(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *indexP,
+                           prv_label_t *labelP)
+{
+    uint8_t label[PRV_LABEL_BUFFER_SIZE];
+    size_t labelLength;
+    size_t index;
+
+    *labelP = PRV_LABEL_UNKNOWN;
+
+    index = *indexP;
+    if (prv_parseString(bufferP, bufferLength, indexP, NULL, 0, &labelLength) == false)
+    {
+        return false;
+    }
+    if (labelLength > PRV_LABEL_BUFFER_SIZE)
+    {
+        // Not a label we know
+        return true;
+    }
+    (void)prv_parseString(bufferP, bufferLength, &index, label, PRV_LABEL_BUFFER_SIZE, &labelLength);
+
+    switch (labelLength)
+    {
+    case 1:
+        if (label[0] == 'n')
+        {
+            *labelP = PRV_LABEL_NAME;
+        }
+        else if (label[0] == 't')
+        {
+            *labelP = PRV_LABEL_TIME;
+        }
+        else if (label[0] == 'v')
+        {
+            *labelP = PRV_LABEL_VALUE;
+        }
+        break;
+
+    case 2:
+        if (memcmp(label, "bn", 2) == 0)
+        {
+            *labelP = PRV_LABEL_BASE_NAME;
+        }
+        else if (memcmp(label, "bt", 2) == 0)
+        {
+            *labelP = PRV_LABEL_BASE_TIME;
+        }
+        else if (memcmp(label, "vs", 2) == 0)
+        {
+            *labelP = PRV_LABEL_STRING_VALUE;
+        }
+        else if (memcmp(label, "vb", 2) == 0)
+        {
+            *labelP = PRV_LABEL_BOOLEAN_VALUE;
+        }
+        else if (memcmp(label, "vd", 2) == 0)
+        {
+            *labelP = PRV_LABEL_DATA_VALUE;
+        }
+        break;
+
+    case 3:
+        if (memcmp(label, "vlo", 3) == 0)
+        {
+            *labelP = PRV_LABEL_OBJLNK_VALUE;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+// Decode a Base64 URL-safe string in an opaque data
+static bool prv_parseBase64(uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *indexP,
+                            iowa_lwm2m_data_t *dataP)
+{
+    uint8_t *base64P;
+    size_t base64Length;
+    size_t decodedLength;
+
+    if (prv_parseAllocatedString(bufferP, bufferLength, indexP, &base64P, &base64Length) == false)
+    {
+        return false;
+    }
+
+    // Tolerate the padding
+    while (base64Length > 0
+           && base64P[base64Length - 1] == '=')
+    {
+        base64Length--;
+    }
+
+    dataP->type = IOWA_LWM2M_TYPE_OPAQUE;
+    dataP->value.asBuffer.buffer = NULL;
+    dataP->value.asBuffer.length = 0;
+    if (base64Length == 0)
+    {
+        iowa_system_free(base64P);
+        return true;
+    }
+
+    decodedLength = utils_b64GetDecodedSize(base64P, base64Length, false);
+    if (decodedLength == 0)
+    {
+        iowa_system_free(base64P);
+        return false;
+    }
+
+    dataP->value.asBuffer.buffer = (uint8_t *)iowa_system_malloc(decodedLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (dataP->value.asBuffer.buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(decodedLength);
+        iowa_system_free(base64P);
+        return false;
+    }
+#endif
+    dataP->value.asBuffer.length = utils_b64Decode(base64P, base64Length, dataP->value.asBuffer.buffer, BASE64_MODE_URI_SAFE);
+    iowa_system_free(base64P);
+
+    return (dataP->value.asBuffer.length == decodedLength);
+}
+
+// Read the value of a record
+static bool prv_parseValue(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *indexP,
+                           prv_label_t label,
+                           iowa_lwm2m_data_t *dataP)
+{
+    prv_skipSpaces(bufferP, bufferLength, indexP);
+    if (*indexP >= bufferLength)
+    {
+        return false;
+    }
+
+    switch (label)
+    {
+    case PRV_LABEL_VALUE:
+        return prv_parseNumber(bufferP, bufferLength, indexP, dataP, NULL);
+
+    case PRV_LABEL_STRING_VALUE:
+        dataP->type = IOWA_LWM2M_TYPE_STRING;
+        return prv_parseAllocatedString(bufferP, bufferLength, indexP, &dataP->value.asBuffer.buffer, &dataP->value.asBuffer.length);
+
+    case PRV_LABEL_BOOLEAN_VALUE:
+        dataP->type = IOWA_LWM2M_TYPE_BOOLEAN;
+        if (PRV_PARSE_LITERAL(bufferP, bufferLength, indexP, "true") == true)
+        {
+            dataP->value.asBoolean = true;
+            return true;
+        }
+        dataP->value.asBoolean = false;
+        return PRV_PARSE_LITERAL(bufferP, bufferLength, indexP, "false");
+
+    case PRV_LABEL_DATA_VALUE:
+        return prv_parseBase64(bufferP, bufferLength, indexP, dataP);
+
+    case PRV_LABEL_OBJLNK_VALUE:
+    {
+        uint8_t objectLink[PRV_OBJECT_LINK_MAX_LENGTH];
+        size_t objectLinkLength;
+
+        if (prv_parseString(bufferP, bufferLength, indexP, objectLink, PRV_OBJECT_LINK_MAX_LENGTH, &objectLinkLength) == false)
+        {
+            return false;
+        }
+        return (dataUtilsBufferToObjectLink(objectLink, objectLinkLength, dataP) != 0);
+    }
+
+    default:
+        return false;
+    }
+}
+
+// Count the records of a SenML JSON pack, the index pointing after the opening bracket
+static bool prv_getRecordCount(uint8_t *bufferP,
+                               size_t bufferLength,
+                               size_t index,
+                               size_t *countP)
+{
+    *countP = 0;
+
+    if (prv_checkChar(bufferP, bufferLength, &index, ']') == true)
+    {
+        return true;
+    }
+    do
+    {
+        prv_skipSpaces(bufferP, bufferLength, &index);
+        if (index >= bufferLength
+            || bufferP[index] != '{'
+            || prv_skipValue(bufferP, bufferLength, &index, 1) == false)
+        {
+            return false;
+        }
+        *countP += 1;
+    } while (prv_checkChar(bufferP, bufferLength, &index, ',') == true);
+
+    return prv_checkChar(bufferP, bufferLength, &index, ']');
+}
+
+// Decode one SenML JSON record
+// Returned value: true in case of success, false otherwise.
+// Parameters:
+// - bufferP, bufferLength, indexP: the payload and the current index.
+// - baseName, baseNameLengthP: IN/OUT. the current base name.
+// - baseTimeP: IN/OUT. the current base time.
+// - dataP: OUT. the decoded data.
+static bool prv_parseRecord(uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *indexP,
+                            uint8_t baseName[PRV_NAME_BUFFER_SIZE],
+                            size_t *baseNameLengthP,
+                            double *baseTimeP,
+                            iowa_lwm2m_data_t *dataP)
+{
+    uint8_t name[PRV_NAME_BUFFER_SIZE];
+    size_t nameLength;
+    double time;
+    bool hasValue;
+    iowa_lwm2m_uri_t uri;
+    size_t res;
+
+    if (prv_checkChar(bufferP, bufferLength, indexP, '{') == false)
+    {
+        return false;
+    }
+
+    nameLength = 0;
+    time = 0;
+    hasValue = false;
+    dataP->type = IOWA_LWM2M_TYPE_URI_ONLY;
+
+    if (prv_checkChar(bufferP, bufferLength, indexP, '}') == false)
+    {
+        do
+        {
+            prv_label_t label;
+
+            prv_skipSpaces(bufferP, bufferLength, indexP);
+            if (prv_parseLabel(bufferP, bufferLength, indexP, &label) == false
+                || prv_checkChar(bufferP, bufferLength, indexP, ':') == false)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid label.");
+                return false;
+            }
+            prv_skipSpaces(bufferP, bufferLength, indexP);
+
+            switch (label)
+            {
+            case PRV_LABEL_BASE_NAME:
+                if (prv_parseString(bufferP, bufferLength, indexP, baseName, PRV_NAME_BUFFER_SIZE, baseNameLengthP) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid base name.");
+                    return false;
+                }
+                break;
+
+            case PRV_LABEL_NAME:
+                if (prv_parseString(bufferP, bufferLength, indexP, name, PRV_NAME_BUFFER_SIZE, &nameLength) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid name.");
+                    return false;
+                }
+                break;
+
+            case PRV_LABEL_BASE_TIME:
+                if (prv_parseNumber(bufferP, bufferLength, indexP, NULL, baseTimeP) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid base time.");
+                    return false;
+                }
+                break;
+
+            case PRV_LABEL_TIME:
+                if (prv_parseNumber(bufferP, bufferLength, indexP, NULL, &time) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid time.");
+                    return false;
+                }
+                break;
+
+            case PRV_LABEL_UNKNOWN:
+                // Unsupported labels (units, sums, version...) are ignored
+                if (prv_skipValue(bufferP, bufferLength, indexP, 1) == false)
+                {
+                    return false;
+                }
+                break;
+
+            default:
+                if (hasValue == true)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_DATA, "Record has several values.");
+                    return false;
+                }
+                hasValue = true;
+
+                if (prv_parseValue(bufferP, bufferLength, indexP, label, dataP) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid value.");
+                    return false;
+                }
+                break;
+            }
+        } while (prv_checkChar(bufferP, bufferLength, indexP, ',') == true);
+
+        if (prv_checkChar(bufferP, bufferLength, indexP, '}') == false)
+        {
+            return false;
+        }
+    }
+
+    // Resolve the name
+    if (*baseNameLengthP + nameLength == 0
+        || *baseNameLengthP + nameLength > PRV_NAME_BUFFER_SIZE)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid record name.");
+        return false;
+    }
+    memmove(name + *baseNameLengthP, name, nameLength);
+    memcpy(name, baseName, *baseNameLengthP);
+    nameLength += *baseNameLengthP;
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    res = dataUtilsBufferToUri((const char *)name, nameLength, &uri, NULL);
+#else
+    res = dataUtilsBufferToUri((const char *)name, nameLength, &uri);
+#endif
+    if (res == 0
+        || uri.objectId == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Invalid record name \"%.*s\".", nameLength, name);
+        return false;
+    }
+    dataUtilsSetUri(dataP, &uri);
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    dataP->timestamp = (int32_t)(*baseTimeP + time);
+#else
+    (void)time;
+#endif
+
+    return true;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t senmlJsonSerializeToSink(iowa_lwm2m_data_t *dataP,
+                                       size_t size,
+                                       data_sink_t *sinkP)
+{
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    iowa_status_t result;
+#endif
+    iowa_lwm2m_uri_t baseUri;
+    lwm2m_uri_depth_t uriDepth;
+    uint8_t baseName[PRV_NAME_BUFFER_SIZE];
+    size_t baseNameLength;
+    uint8_t nameBuffer[PRV_NAME_BUFFER_SIZE];
+    size_t nameLength;
+    int32_t baseTime;
+    size_t i;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(sinkP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %d", size);
+
+    // Check the data before streaming anything
+    for (i = 0; i < size; i++)
+    {
+        switch (dataP[i].type)
+        {
+        case IOWA_LWM2M_TYPE_STRING:
+        case IOWA_LWM2M_TYPE_CORE_LINK:
+        case IOWA_LWM2M_TYPE_OPAQUE:
+        case IOWA_LWM2M_TYPE_INTEGER:
+        case IOWA_LWM2M_TYPE_TIME:
+        case IOWA_LWM2M_TYPE_FLOAT:
+        case IOWA_LWM2M_TYPE_BOOLEAN:
+        case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        case IOWA_LWM2M_TYPE_URI_ONLY:
+        case IOWA_LWM2M_TYPE_NULL:
+            break;
+
+        case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+            if (dataP[i].value.asInteger < 0)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsigned integer value has a negative value: %d", dataP[i].value.asInteger);
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            break;
+
+        default:
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported data type: %s.", STR_LWM2M_TYPE(dataP[i].type));
+            return IOWA_COAP_406_NOT_ACCEPTABLE;
+        }
+    }
+
+    // The base name factors the common part of the names
+    baseNameLength = 0;
+    if (size > 1)
+    {
+        bool isDeeper;
+
+        isDeeper = dataUtilsGetBaseUri(dataP, size, &baseUri, &uriDepth);
+        if (uriDepth != LWM2M_URI_DEPTH_ROOT)
+        {
+#ifdef LWM2M_ALTPATH_SUPPORT
+            baseNameLength = dataUtilsUriToBuffer(&baseUri, NULL, baseName, PRV_NAME_BUFFER_SIZE);
+#else
+            baseNameLength = dataUtilsUriToBuffer(&baseUri, baseName, PRV_NAME_BUFFER_SIZE);
+#endif
+            if (baseNameLength == 0)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+            if (isDeeper == true)
+            {
+                baseName[baseNameLength] = '/';
+                baseNameLength++;
+            }
+        }
+    }
+
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+    result = dataUtilsGetBaseTime(dataP, size, &baseTime);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+#else
+    baseTime = 0;
+#endif
+
+    PRV_WRITE_LITERAL(sinkP, "[");
+    for (i = 0; i < size && sinkP->result == IOWA_COAP_NO_ERROR; i++)
+    {
+        bool isFirst;
+
+        nameLength = prv_getRecordName(dataP + i, nameBuffer);
+        if (nameLength < baseNameLength)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
+        if (i != 0)
+        {
+            PRV_WRITE_LITERAL(sinkP, ",");
+        }
+        PRV_WRITE_LITERAL(sinkP, "{");
+        isFirst = true;
+
+        if (i == 0)
+        {
+            if (baseNameLength != 0)
+            {
+                PRV_WRITE_LABEL(sinkP, "bn", &isFirst);
+                prv_writeString(sinkP, baseName, baseNameLength);
+            }
+            if (baseTime != 0)
+            {
+                PRV_WRITE_LABEL(sinkP, "bt", &isFirst);
+                prv_writeInteger(sinkP, baseTime);
+            }
+        }
+        if (nameLength != baseNameLength)
+        {
+            PRV_WRITE_LABEL(sinkP, "n", &isFirst);
+            prv_writeString(sinkP, nameBuffer + baseNameLength, nameLength - baseNameLength);
+        }
+#ifdef LWM2M_SUPPORT_TIMESTAMP
+        if (dataP[i].timestamp != baseTime)
+        {
+            PRV_WRITE_LABEL(sinkP, "t", &isFirst);
+            prv_writeInteger(sinkP, (int64_t)dataP[i].timestamp - baseTime);
+        }
+#endif
+        prv_writeValue(sinkP, dataP + i, &isFirst);
+
+        PRV_WRITE_LITERAL(sinkP, "}");
+    }
+    PRV_WRITE_LITERAL(sinkP, "]");
+
+    return sinkP->result;
+}
+
+iowa_status_t senmlJsonSerialize(iowa_lwm2m_data_t *dataP,
+                                 size_t size,
+                                 uint8_t **bufferP,
+                                 size_t *bufferLengthP)
+{
+    iowa_status_t result;
+    data_sink_t sink;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    // Stream in a growing buffer rather than serializing twice to know the length
+    dataSinkInit(&sink, NULL, size * PRV_DYNAMIC_RECORD_SIZE, NULL, NULL);
+    result = senmlJsonSerializeToSink(dataP, size, &sink);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = dataSinkFlush(&sink);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        dataSinkClose(&sink);
+        return result;
+    }
+
+    *bufferP = sink.chunkP;
+    *bufferLengthP = sink.chunkLength;
+
+    IOWA_LOG_ARG_BUFFER_TRACE(IOWA_PART_DATA, "SenML JSON payload:", *bufferP, *bufferLengthP, "length: %u", *bufferLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t senmlJsonDeserialize(uint8_t *buffer,
+                                   size_t bufferLength,
+                                   iowa_lwm2m_data_t **dataP,
+                                   size_t *dataCountP)
+{
+    size_t index;
+    size_t count;
+    size_t i;
+    uint8_t baseName[PRV_NAME_BUFFER_SIZE];
+    size_t baseNameLength;
+    double baseTime;
+
+    assert(dataP != NULL);
+    assert(dataCountP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "bufferLength: %u", bufferLength);
+
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    if (buffer == NULL
+        || bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Empty payload.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    index = 0;
+    if (prv_checkChar(buffer, bufferLength, &index, '[') == false
+        || prv_getRecordCount(buffer, bufferLength, index, &count) == false)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Invalid SenML pack.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+    if (count == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(count * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(count * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, count * sizeof(iowa_lwm2m_data_t));
+
+    baseNameLength = 0;
+    baseTime = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (i != 0
+            && prv_checkChar(buffer, bufferLength, &index, ',') == false)
+        {
+            goto error;
+        }
+        if (prv_parseRecord(buffer, bufferLength, &index, baseName, &baseNameLength, &baseTime, *dataP + i) == false)
+        {
+            goto error;
+        }
+    }
+    if (prv_checkChar(buffer, bufferLength, &index, ']') == false)
+    {
+        goto error;
+    }
+    prv_skipSpaces(buffer, bufferLength, &index);
+    if (index != bufferLength)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Trailing bytes after the SenML pack.");
+        goto error;
+    }
+
+    *dataCountP = count;
+
+    return IOWA_COAP_NO_ERROR;
+
+error:
+    dataLwm2mFree(count, *dataP);
+    *dataP = NULL;
+
+    return IOWA_COAP_400_BAD_REQUEST;
+}
+
+#endif // LWM2M_SUPPORT_SENML_JSON
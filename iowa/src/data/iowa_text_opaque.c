@@ -131,9 +131,9 @@ iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
 
     case IOWA_LWM2M_TYPE_FLOAT:
     {
-        uint8_t floatString[PRV_STR_LENGTH * 2];
+        uint8_t floatString[DATA_FLOAT_STRING_MAX_LENGTH];
 
-        *bufferLengthP = dataUtilsFloatToBuffer(dataP->value.asFloat, floatString, PRV_STR_LENGTH * 2, false);
+        *bufferLengthP = dataUtilsFloatToBuffer(dataP->value.asFloat, floatString, DATA_FLOAT_STRING_MAX_LENGTH, false);
         if (*bufferLengthP == 0)
         {
             IOWA_LOG_WARNING(IOWA_PART_DATA, "Float to text conversion failed");
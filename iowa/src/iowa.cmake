@@ -38,7 +38,9 @@ set(BASE_SOURCES
     ${BASE_DIR}/iowa_base.c
     ${BASE_DIR}/iowa_buffer.c
     ${BASE_DIR}/iowa_context.c
-    ${BASE_DIR}/iowa_timer.c)
+    ${BASE_DIR}/iowa_metrics.c
+    ${BASE_DIR}/iowa_timer.c
+    ${BASE_DIR}/iowa_trace.c)
 
 set(BASE_CLIENT_SOURCES
     ${BASE_DIR}/iowa_client.c)
@@ -56,6 +58,7 @@ set(COMM_HEADERS
     ${COMM_DIR}/iowa_prv_comm.h)
 
 set(COMM_SOURCES
+    ${COMM_DIR}/iowa_capture.c
     ${COMM_DIR}/iowa_comm.c)
 
 SOURCE_GROUP(Iowa\\Comm FILES ${COMM_HEADERS} ${COMM_SOURCES})
@@ -100,7 +103,8 @@ set(DATA_SOURCES
     ${DATA_DIR}/iowa_lwm2m_cbor.c
     ${DATA_DIR}/iowa_text_opaque.c
     ${DATA_DIR}/iowa_tlv.c
-    ${DATA_DIR}/iowa_data_utils.c)
+    ${DATA_DIR}/iowa_data_utils.c
+    ${DATA_DIR}/iowa_data_float.c)
 
 SOURCE_GROUP(Iowa\\Data FILES ${DATA_HEADERS} ${DATA_SOURCES})
 
@@ -135,6 +139,7 @@ set(LWM2M_SOURCES
     ${LWM2M_DIR}/iowa_observe.c
     ${LWM2M_DIR}/iowa_packet.c
     ${LWM2M_DIR}/iowa_registration.c
+    ${LWM2M_DIR}/iowa_registry.c
     ${LWM2M_DIR}/iowa_send.c
     ${LWM2M_DIR}/iowa_uri.c
     ${LWM2M_DIR}/iowa_lwm2m_utils.c
@@ -183,6 +188,7 @@ set(OBJECTS_SOURCES
     ${OBJECTS_DIR}/iowa_object_light_control.c
     ${OBJECTS_DIR}/iowa_object_location.c
     ${OBJECTS_DIR}/iowa_object_magnetometer.c
+    ${OBJECTS_DIR}/iowa_object_metrics.c
     ${OBJECTS_DIR}/iowa_object_mqtt_broker.c
     ${OBJECTS_DIR}/iowa_object_mqtt_publication.c
     ${OBJECTS_DIR}/iowa_object_oscore.c
@@ -267,6 +273,7 @@ set(IOWA_COMMON_OBJECT_HEADERS
     ${IOWA_OBJECT_HEADERS_DIR}/iowa_light_control.h
     ${IOWA_OBJECT_HEADERS_DIR}/iowa_location.h
     ${IOWA_OBJECT_HEADERS_DIR}/iowa_magnetometer.h
+    ${IOWA_OBJECT_HEADERS_DIR}/iowa_metrics.h
     ${IOWA_OBJECT_HEADERS_DIR}/iowa_software_component.h
     ${IOWA_OBJECT_HEADERS_DIR}/iowa_software_management.h)
 
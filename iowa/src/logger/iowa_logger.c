@@ -59,24 +59,11 @@ static void prv_printf(const char *format, ...)
 
 #define PRV_HEX(n) ((n) < 10 ? ('0' + (n)) : ('A' + ((n)-10)))
 
-static void prv_logBuffer(const uint8_t *buffer,
-                          size_t bufferLength)
+static void prv_logBufferLines(const uint8_t *buffer,
+                               size_t bufferLength)
 {
     size_t i;
 
-#ifdef IOWA_LOG_BUFFER_LIMIT
-    if (IOWA_LOG_BUFFER_LIMIT < bufferLength)
-    {
-        prv_printf("%d bytes (truncated)\r\n", bufferLength);
-        bufferLength = IOWA_LOG_BUFFER_LIMIT;
-    }
-    else
-#else
-    {
-        prv_printf("%d bytes\r\n", bufferLength);
-    }
-#endif
-
     for (i = 0; i < bufferLength; i += 16)
     {
         size_t j;
@@ -142,6 +129,800 @@ static void prv_logBuffer(const uint8_t *buffer,
     }
 }
 
+#ifndef IOWA_LOG_BINARY_SUPPORT
+static void prv_logBuffer(const uint8_t *buffer,
+                          size_t bufferLength)
+{
+#ifdef IOWA_LOG_BUFFER_LIMIT
+    if (IOWA_LOG_BUFFER_LIMIT < bufferLength)
+    {
+        prv_printf("%d bytes (truncated)\r\n", bufferLength);
+        bufferLength = IOWA_LOG_BUFFER_LIMIT;
+    }
+    else
+#else
+    {
+        prv_printf("%d bytes\r\n", bufferLength);
+    }
+#endif
+
+    prv_logBufferLines(buffer, bufferLength);
+}
+
+#else
+
+// Size of the area storing the arguments and the start of the buffer of a record,
+// chosen so that a ring buffer slot fills 128 bytes on 64-bit platforms.
+#define PRV_BINARY_ARGS_SIZE 76
+
+#define PRV_BINARY_FLAG_FORMAT    0x01
+#define PRV_BINARY_FLAG_BUFFER    0x02
+#define PRV_BINARY_FLAG_TRUNCATED 0x04
+
+#define PRV_BINARY_INDEX_MASK (IOWA_LOG_BINARY_RECORD_COUNT - 1)
+
+#define PRV_BINARY_SPEC_SIZE 32
+
+typedef enum
+{
+    PRV_ARG_NONE,
+    PRV_ARG_SIGNED,
+    PRV_ARG_UNSIGNED,
+    PRV_ARG_CHAR,
+    PRV_ARG_DOUBLE,
+    PRV_ARG_STRING,
+    PRV_ARG_POINTER,
+    PRV_ARG_INVALID
+} prv_arg_type_t;
+
+// A conversion specification of a format string
+typedef struct
+{
+    const char *modifierP; // position of the length modifier
+    char length;           // length modifier: 'H' for "hh" and 'q' for "ll"
+    char conversion;
+    uint8_t starCount;     // number of '*' in the width and the precision
+    prv_arg_type_t type;
+} prv_binary_spec_t;
+
+// The message and the function name are not copied: their addresses identify these static strings.
+// The arguments are stored in the order of the format: integers on 64 bits, doubles, pointers, nil-terminated strings.
+// The first bytes of the buffer follow the arguments.
+typedef struct
+{
+    uint64_t timestamp;
+    const char *functionName;
+    const char *message;
+    size_t bufferLength;
+    unsigned int line;
+    uint8_t part;
+    uint8_t level;
+    uint8_t flags;
+    uint8_t argLength;
+    uint8_t dumpLength;
+    uint8_t args[PRV_BINARY_ARGS_SIZE];
+} prv_binary_record_t;
+
+// The sequence tells if the slot is free or written. It is stored minus the slot index
+// so that the zero-initialized ring buffer is ready to use.
+typedef struct
+{
+    atomic_size_t sequence;
+    prv_binary_record_t record;
+} prv_binary_slot_t;
+
+static prv_binary_slot_t s_binarySlots[IOWA_LOG_BINARY_RECORD_COUNT];
+static atomic_size_t s_binaryWritePosition;
+static atomic_size_t s_binaryReadPosition;
+static atomic_uint_least32_t s_binaryDropCount;
+
+// Parse a conversion specification.
+// Returned value: the position following the specification.
+// Parameters:
+// - formatP: the position following the '%'.
+// - specP: OUT. the parsed specification.
+static const char * prv_binaryParseSpec(const char *formatP,
+                                        prv_binary_spec_t *specP)
+{
+    specP->starCount = 0;
+    specP->length = 0;
+
+    while (*formatP == '-' || *formatP == '+' || *formatP == ' ' || *formatP == '#' || *formatP == '0')
+    {
+        formatP++;
+    }
+
+    if (*formatP == '*')
+    {
+        specP->starCount++;
+        formatP++;
+    }
+    else
+    {
+        while (isdigit((unsigned char)*formatP))
+        {
+            formatP++;
+        }
+    }
+
+    if (*formatP == '.')
+    {
+        formatP++;
+        if (*formatP == '*')
+        {
+            specP->starCount++;
+            formatP++;
+        }
+        else
+        {
+            while (isdigit((unsigned char)*formatP))
+            {
+                formatP++;
+            }
+        }
+    }
+
+    specP->modifierP = formatP;
+    switch (*formatP)
+    {
+    case 'h':
+    case 'l':
+        specP->length = *formatP;
+        formatP++;
+        if (*formatP == specP->length)
+        {
+            specP->length = (specP->length == 'h') ? 'H' : 'q';
+            formatP++;
+        }
+        break;
+
+    case 'z':
+    case 'j':
+    case 't':
+    case 'L':
+        specP->length = *formatP;
+        formatP++;
+        break;
+
+    default:
+        break;
+    }
+
+    specP->conversion = *formatP;
+    switch (*formatP)
+    {
+    case 'd':
+    case 'i':
+        specP->type = PRV_ARG_SIGNED;
+        break;
+
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        specP->type = PRV_ARG_UNSIGNED;
+        break;
+
+    case 'c':
+        specP->type = PRV_ARG_CHAR;
+        break;
+
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        specP->type = PRV_ARG_DOUBLE;
+        break;
+
+    case 's':
+        specP->type = PRV_ARG_STRING;
+        break;
+
+    case 'p':
+        specP->type = PRV_ARG_POINTER;
+        break;
+
+    case '%':
+        specP->type = PRV_ARG_NONE;
+        break;
+
+    default:
+        // Including '\0' and "%n"
+        specP->type = PRV_ARG_INVALID;
+        return formatP;
+    }
+
+    return formatP + 1;
+}
+
+// Reserve the next free slot of the ring buffer.
+// Returned value: the record to fill or NULL if the ring buffer is full.
+// Parameters:
+// - positionP: OUT. the position of the slot to give to prv_binaryCommit().
+static prv_binary_record_t * prv_binaryAcquire(size_t *positionP)
+{
+    size_t position;
+
+    position = atomic_load_explicit(&s_binaryWritePosition, memory_order_relaxed);
+    while (1)
+    {
+        prv_binary_slot_t *slotP;
+        size_t index;
+        intptr_t diff;
+
+        index = position & PRV_BINARY_INDEX_MASK;
+        slotP = s_binarySlots + index;
+        diff = (intptr_t)(atomic_load_explicit(&slotP->sequence, memory_order_acquire) + index - position);
+        if (diff == 0)
+        {
+            // On failure, position is updated with the current value
+            if (atomic_compare_exchange_weak_explicit(&s_binaryWritePosition, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                *positionP = position;
+                return &slotP->record;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The slot was not read yet
+            atomic_fetch_add_explicit(&s_binaryDropCount, 1, memory_order_relaxed);
+            return NULL;
+        }
+        else
+        {
+            position = atomic_load_explicit(&s_binaryWritePosition, memory_order_relaxed);
+        }
+    }
+}
+
+// Make a filled record available to iowa_log_binary_drain().
+static void prv_binaryCommit(size_t position)
+{
+    size_t index;
+
+    index = position & PRV_BINARY_INDEX_MASK;
+    atomic_store_explicit(&s_binarySlots[index].sequence, position + 1 - index, memory_order_release);
+}
+
+// Copy the oldest record of the ring buffer and free its slot.
+// Returned value: false if the ring buffer is empty.
+static bool prv_binaryRead(prv_binary_record_t *recordP)
+{
+    size_t position;
+
+    position = atomic_load_explicit(&s_binaryReadPosition, memory_order_relaxed);
+    while (1)
+    {
+        prv_binary_slot_t *slotP;
+        size_t index;
+        intptr_t diff;
+
+        index = position & PRV_BINARY_INDEX_MASK;
+        slotP = s_binarySlots + index;
+        diff = (intptr_t)(atomic_load_explicit(&slotP->sequence, memory_order_acquire) + index - (position + 1));
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&s_binaryReadPosition, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                *recordP = slotP->record;
+                atomic_store_explicit(&slotP->sequence, position + IOWA_LOG_BINARY_RECORD_COUNT - index, memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = atomic_load_explicit(&s_binaryReadPosition, memory_order_relaxed);
+        }
+    }
+}
+
+static bool prv_binaryPut(prv_binary_record_t *recordP,
+                          const void *valueP,
+                          size_t length)
+{
+    if (recordP->argLength + length > PRV_BINARY_ARGS_SIZE)
+    {
+        recordP->flags |= PRV_BINARY_FLAG_TRUNCATED;
+        return false;
+    }
+
+    memcpy(recordP->args + recordP->argLength, valueP, length);
+    recordP->argLength = (uint8_t)(recordP->argLength + length);
+
+    return true;
+}
+
+// Store the arguments of the format in the record.
+// When the record is full, the remaining arguments are dropped.
+static void prv_binaryStoreArgs(prv_binary_record_t *recordP,
+                                va_list args)
+{
+    const char *formatP;
+
+    recordP->flags |= PRV_BINARY_FLAG_FORMAT;
+
+    formatP = strchr(recordP->message, '%');
+    while (formatP != NULL)
+    {
+        prv_binary_spec_t spec;
+        uint8_t i;
+
+        formatP = prv_binaryParseSpec(formatP + 1, &spec);
+
+        for (i = 0; i < spec.starCount; i++)
+        {
+            int star;
+
+            star = va_arg(args, int);
+            if (prv_binaryPut(recordP, &star, sizeof(int)) == false)
+            {
+                return;
+            }
+        }
+
+        switch (spec.type)
+        {
+        case PRV_ARG_NONE:
+            break;
+
+        case PRV_ARG_SIGNED:
+        case PRV_ARG_CHAR:
+        {
+            int64_t value;
+
+            switch (spec.length)
+            {
+            case 'l':
+                value = va_arg(args, long);
+                break;
+            case 'q':
+                value = va_arg(args, long long);
+                break;
+            case 'z':
+                value = (int64_t)va_arg(args, size_t);
+                break;
+            case 'j':
+                value = va_arg(args, intmax_t);
+                break;
+            case 't':
+                value = va_arg(args, ptrdiff_t);
+                break;
+            case 'h':
+                value = (short)va_arg(args, int);
+                break;
+            case 'H':
+                value = (signed char)va_arg(args, int);
+                break;
+            default:
+                value = va_arg(args, int);
+                break;
+            }
+            if (prv_binaryPut(recordP, &value, sizeof(int64_t)) == false)
+            {
+                return;
+            }
+            break;
+        }
+
+        case PRV_ARG_UNSIGNED:
+        {
+            uint64_t value;
+
+            switch (spec.length)
+            {
+            case 'l':
+                value = va_arg(args, unsigned long);
+                break;
+            case 'q':
+                value = va_arg(args, unsigned long long);
+                break;
+            case 'z':
+                value = va_arg(args, size_t);
+                break;
+            case 'j':
+                value = va_arg(args, uintmax_t);
+                break;
+            case 't':
+                value = (uint64_t)va_arg(args, ptrdiff_t);
+                break;
+            case 'h':
+                value = (unsigned short)va_arg(args, unsigned int);
+                break;
+            case 'H':
+                value = (unsigned char)va_arg(args, unsigned int);
+                break;
+            default:
+                value = va_arg(args, unsigned int);
+                break;
+            }
+            if (prv_binaryPut(recordP, &value, sizeof(uint64_t)) == false)
+            {
+                return;
+            }
+            break;
+        }
+
+        case PRV_ARG_DOUBLE:
+        {
+            double value;
+
+            if (spec.length == 'L')
+            {
+                value = (double)va_arg(args, long double);
+            }
+            else
+            {
+                value = va_arg(args, double);
+            }
+            if (prv_binaryPut(recordP, &value, sizeof(double)) == false)
+            {
+                return;
+            }
+            break;
+        }
+
+        case PRV_ARG_POINTER:
+        {
+            void *value;
+
+            value = va_arg(args, void *);
+            if (prv_binaryPut(recordP, &value, sizeof(void *)) == false)
+            {
+                return;
+            }
+            break;
+        }
+
+        case PRV_ARG_STRING:
+        {
+            const char *value;
+            size_t length;
+
+            value = va_arg(args, const char *);
+            if (value == NULL)
+            {
+                value = "(null)";
+            }
+            length = strlen(value);
+            if (recordP->argLength + length + 1 > PRV_BINARY_ARGS_SIZE)
+            {
+                if (recordP->argLength + 1 >= PRV_BINARY_ARGS_SIZE)
+                {
+                    recordP->flags |= PRV_BINARY_FLAG_TRUNCATED;
+                    return;
+                }
+                length = PRV_BINARY_ARGS_SIZE - recordP->argLength - 1;
+                recordP->flags |= PRV_BINARY_FLAG_TRUNCATED;
+            }
+            memcpy(recordP->args + recordP->argLength, value, length);
+            recordP->args[recordP->argLength + length] = '\0';
+            recordP->argLength = (uint8_t)(recordP->argLength + length + 1);
+            break;
+        }
+
+        default:
+            return;
+        }
+
+        formatP = strchr(formatP, '%');
+    }
+}
+
+// Store the start of the buffer after the arguments.
+static void prv_binaryStoreBuffer(prv_binary_record_t *recordP,
+                                  const uint8_t *buffer,
+                                  size_t bufferLength)
+{
+    size_t length;
+
+    recordP->flags |= PRV_BINARY_FLAG_BUFFER;
+    recordP->bufferLength = bufferLength;
+
+    length = PRV_BINARY_ARGS_SIZE - recordP->argLength;
+    if (bufferLength < length)
+    {
+        length = bufferLength;
+    }
+    if (buffer != NULL)
+    {
+        memcpy(recordP->args + recordP->argLength, buffer, length);
+    }
+    else
+    {
+        length = 0;
+    }
+    recordP->dumpLength = (uint8_t)length;
+}
+
+static prv_binary_record_t * prv_binaryStart(uint8_t part,
+                                             uint8_t level,
+                                             const char *functionName,
+                                             unsigned int line,
+                                             const char *message,
+                                             size_t *positionP)
+{
+    prv_binary_record_t *recordP;
+
+    recordP = prv_binaryAcquire(positionP);
+    if (recordP == NULL)
+    {
+        return NULL;
+    }
+
+    recordP->timestamp = iowa_system_log_timestamp();
+    recordP->functionName = functionName;
+    recordP->message = message;
+    recordP->bufferLength = 0;
+    recordP->line = line;
+    recordP->part = part;
+    recordP->level = level;
+    recordP->flags = 0;
+    recordP->argLength = 0;
+    recordP->dumpLength = 0;
+
+    return recordP;
+}
+
+// Write the integer in decimal in the specification being built.
+// Returned value: the new length of the specification or 0 if it does not fit.
+static size_t prv_binaryAppendInt(char *specP,
+                                  size_t specLength,
+                                  int value)
+{
+    char digits[12];
+    size_t digitCount;
+    unsigned int absValue;
+
+    if (value < 0)
+    {
+        specP[specLength++] = '-';
+        absValue = 0U - (unsigned int)value;
+    }
+    else
+    {
+        absValue = (unsigned int)value;
+    }
+
+    digitCount = 0;
+    do
+    {
+        digits[digitCount++] = (char)('0' + absValue % 10);
+        absValue /= 10;
+    } while (absValue != 0);
+
+    if (specLength + digitCount >= PRV_BINARY_SPEC_SIZE - 4)
+    {
+        return 0;
+    }
+
+    while (digitCount > 0)
+    {
+        specP[specLength++] = digits[--digitCount];
+    }
+
+    return specLength;
+}
+
+// Output the message of the record with its stored arguments.
+static void prv_binaryOutputMessage(const prv_binary_record_t *recordP)
+{
+    const char *formatP;
+    const uint8_t *argP;
+    const uint8_t *argEndP;
+
+    formatP = recordP->message;
+    argP = recordP->args;
+    argEndP = recordP->args + recordP->argLength;
+
+    while (*formatP != '\0')
+    {
+        const char *startP;
+        prv_binary_spec_t spec;
+        char specBuffer[PRV_BINARY_SPEC_SIZE];
+        size_t specLength;
+        size_t valueSize;
+
+        startP = formatP;
+        while (*formatP != '\0' && *formatP != '%')
+        {
+            formatP++;
+        }
+        if (formatP != startP)
+        {
+            prv_printf("%.*s", (int)(formatP - startP), startP);
+        }
+        if (*formatP == '\0')
+        {
+            break;
+        }
+
+        startP = formatP;
+        formatP = prv_binaryParseSpec(formatP + 1, &spec);
+        if (spec.type == PRV_ARG_NONE)
+        {
+            prv_printf("%%");
+            continue;
+        }
+        if (spec.type == PRV_ARG_INVALID)
+        {
+            break;
+        }
+
+        // Rebuild the specification with the stored widths and precisions
+        specLength = 0;
+        for (; startP != spec.modifierP; startP++)
+        {
+            if (*startP == '*')
+            {
+                int star;
+
+                if (argP + sizeof(int) > argEndP)
+                {
+                    prv_printf("...");
+                    return;
+                }
+                memcpy(&star, argP, sizeof(int));
+                argP += sizeof(int);
+
+                if (star < 0 && specLength > 0 && specBuffer[specLength - 1] == '.')
+                {
+                    // A negative precision is taken as if it was omitted
+                    specLength--;
+                    continue;
+                }
+                specLength = prv_binaryAppendInt(specBuffer, specLength, star);
+            }
+            else if (specLength < PRV_BINARY_SPEC_SIZE - 4)
+            {
+                specBuffer[specLength++] = *startP;
+            }
+            else
+            {
+                specLength = 0;
+            }
+
+            if (specLength == 0)
+            {
+                prv_printf("...");
+                return;
+            }
+        }
+
+        switch (spec.type)
+        {
+        case PRV_ARG_SIGNED:
+        case PRV_ARG_UNSIGNED:
+        case PRV_ARG_CHAR:
+            valueSize = sizeof(int64_t);
+            break;
+        case PRV_ARG_DOUBLE:
+            valueSize = sizeof(double);
+            break;
+        case PRV_ARG_POINTER:
+            valueSize = sizeof(void *);
+            break;
+        default:
+            // PRV_ARG_STRING, at least the terminating nil
+            valueSize = 1;
+            break;
+        }
+        if (argP + valueSize > argEndP)
+        {
+            prv_printf("...");
+            return;
+        }
+
+        if (spec.type == PRV_ARG_SIGNED
+            || spec.type == PRV_ARG_UNSIGNED)
+        {
+            specBuffer[specLength++] = 'l';
+            specBuffer[specLength++] = 'l';
+        }
+        specBuffer[specLength++] = spec.conversion;
+        specBuffer[specLength] = '\0';
+
+        switch (spec.type)
+        {
+        case PRV_ARG_SIGNED:
+        {
+            int64_t value;
+
+            memcpy(&value, argP, sizeof(int64_t));
+            prv_printf(specBuffer, (long long)value);
+            break;
+        }
+
+        case PRV_ARG_UNSIGNED:
+        {
+            uint64_t value;
+
+            memcpy(&value, argP, sizeof(uint64_t));
+            prv_printf(specBuffer, (unsigned long long)value);
+            break;
+        }
+
+        case PRV_ARG_CHAR:
+        {
+            int64_t value;
+
+            memcpy(&value, argP, sizeof(int64_t));
+            prv_printf(specBuffer, (int)value);
+            break;
+        }
+
+        case PRV_ARG_DOUBLE:
+        {
+            double value;
+
+            memcpy(&value, argP, sizeof(double));
+            prv_printf(specBuffer, value);
+            break;
+        }
+
+        case PRV_ARG_POINTER:
+        {
+            void *value;
+
+            memcpy(&value, argP, sizeof(void *));
+            prv_printf(specBuffer, value);
+            break;
+        }
+
+        default:
+            prv_printf(specBuffer, (const char *)argP);
+            valueSize = strlen((const char *)argP) + 1;
+            break;
+        }
+        argP += valueSize;
+    }
+
+    if ((recordP->flags & PRV_BINARY_FLAG_TRUNCATED) != 0)
+    {
+        prv_printf("...");
+    }
+}
+
+static void prv_binaryOutput(const prv_binary_record_t *recordP)
+{
+    prv_printf("%llu [%s:%s:%s:%u] ", (unsigned long long)recordP->timestamp, PRV_STR_LEVEL(recordP->level), PRV_STR_PART(recordP->part), recordP->functionName, recordP->line);
+
+    if ((recordP->flags & PRV_BINARY_FLAG_FORMAT) != 0)
+    {
+        prv_binaryOutputMessage(recordP);
+    }
+    else
+    {
+        prv_printf("%s", recordP->message);
+    }
+
+    if ((recordP->flags & PRV_BINARY_FLAG_BUFFER) != 0)
+    {
+        if (recordP->dumpLength < recordP->bufferLength)
+        {
+            prv_printf(" %u bytes (truncated)\r\n", (unsigned int)recordP->bufferLength);
+        }
+        else
+        {
+            prv_printf(" %u bytes\r\n", (unsigned int)recordP->bufferLength);
+        }
+        prv_logBufferLines(recordP->args + recordP->argLength, recordP->dumpLength);
+    }
+    else
+    {
+        prv_printf("\r\n");
+    }
+}
+
+#endif // IOWA_LOG_BINARY_SUPPORT
+
 /*************************************************************************************
 ** Internal functions
 *************************************************************************************/
@@ -154,7 +935,18 @@ void iowa_log(uint8_t part,
 {
     if ((IOWA_LOG_PART) & part)
     {
+#ifdef IOWA_LOG_BINARY_SUPPORT
+        prv_binary_record_t *recordP;
+        size_t position;
+
+        recordP = prv_binaryStart(part, level, functionName, line, message, &position);
+        if (recordP != NULL)
+        {
+            prv_binaryCommit(position);
+        }
+#else
         prv_printf("[%s:%s:%s:%d] %s\r\n", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line, message);
+#endif
     }
 }
 
@@ -168,7 +960,20 @@ void iowa_log_arg(uint8_t part,
     if ((IOWA_LOG_PART) & part)
     {
         va_list args;
+#ifdef IOWA_LOG_BINARY_SUPPORT
+        prv_binary_record_t *recordP;
+        size_t position;
 
+        recordP = prv_binaryStart(part, level, functionName, line, message, &position);
+        if (recordP != NULL)
+        {
+            va_start(args, message);
+            prv_binaryStoreArgs(recordP, args);
+            va_end(args);
+
+            prv_binaryCommit(position);
+        }
+#else
         prv_printf("[%s:%s:%s:%d] ", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line);
 
         va_start(args, message);
@@ -176,6 +981,7 @@ void iowa_log_arg(uint8_t part,
         va_end(args);
 
         prv_printf("\r\n");
+#endif
     }
 }
 
@@ -189,8 +995,20 @@ void iowa_log_buffer(uint8_t part,
 {
     if ((IOWA_LOG_PART) & part)
     {
+#ifdef IOWA_LOG_BINARY_SUPPORT
+        prv_binary_record_t *recordP;
+        size_t position;
+
+        recordP = prv_binaryStart(part, level, functionName, line, message, &position);
+        if (recordP != NULL)
+        {
+            prv_binaryStoreBuffer(recordP, buffer, bufferLength);
+            prv_binaryCommit(position);
+        }
+#else
         prv_printf("[%s:%s:%s:%d] %s ", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line, message);
         prv_logBuffer(buffer, bufferLength);
+#endif
     }
 }
 
@@ -206,7 +1024,21 @@ void iowa_log_arg_buffer(uint8_t part,
     if ((IOWA_LOG_PART) & part)
     {
         va_list args;
+#ifdef IOWA_LOG_BINARY_SUPPORT
+        prv_binary_record_t *recordP;
+        size_t position;
 
+        recordP = prv_binaryStart(part, level, functionName, line, message, &position);
+        if (recordP != NULL)
+        {
+            va_start(args, bufferLength);
+            prv_binaryStoreArgs(recordP, args);
+            va_end(args);
+
+            prv_binaryStoreBuffer(recordP, buffer, bufferLength);
+            prv_binaryCommit(position);
+        }
+#else
         prv_printf("[%s:%s:%s:%d] ", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line);
 
         va_start(args, bufferLength);
@@ -215,6 +1047,32 @@ void iowa_log_arg_buffer(uint8_t part,
 
         prv_printf(" ");
         prv_logBuffer(buffer, bufferLength);
+#endif
     }
 }
 
+#ifdef IOWA_LOG_BINARY_SUPPORT
+size_t iowa_log_binary_drain(size_t maxCount)
+{
+    size_t count;
+    uint32_t dropCount;
+    prv_binary_record_t record;
+
+    count = 0;
+    while ((maxCount == 0 || count < maxCount)
+           && prv_binaryRead(&record) == true)
+    {
+        prv_binaryOutput(&record);
+        count++;
+    }
+
+    dropCount = (uint32_t)atomic_exchange_explicit(&s_binaryDropCount, 0, memory_order_relaxed);
+    if (dropCount != 0)
+    {
+        prv_printf("[%s:%s:%s:%d] %u records dropped.\r\n", PRV_STR_LEVEL(IOWA_LOG_LEVEL_WARNING), PRV_STR_PART(IOWA_PART_SYSTEM), __func__, __LINE__, dropCount);
+    }
+
+    return count;
+}
+#endif
+
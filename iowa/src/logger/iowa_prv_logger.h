@@ -32,6 +32,11 @@ extern "C" {
 
 #include <ctype.h>
 
+#ifdef IOWA_LOG_BINARY_SUPPORT
+#include <stdatomic.h>
+#include <string.h>
+#endif
+
 /**************************************************************
  * Defines
  **************************************************************/
@@ -44,6 +49,10 @@ extern "C" {
 #define IOWA_LOG_PART IOWA_PART_ALL
 #endif
 
+#ifndef IOWA_LOG_BINARY_RECORD_COUNT
+#define IOWA_LOG_BINARY_RECORD_COUNT 256
+#endif
+
 #if (IOWA_LOG_LEVEL >= IOWA_LOG_LEVEL_ERROR)
 #define IOWA_LOG_ERROR(PART, STR)                           iowa_log(PART, IOWA_LOG_LEVEL_ERROR, __func__, __LINE__, STR)
 #define IOWA_LOG_ARG_ERROR(PART, STR, ...)                  iowa_log_arg(PART, IOWA_LOG_LEVEL_ERROR, __func__, __LINE__, STR, __VA_ARGS__)
@@ -293,6 +293,9 @@ iowa_status_t attributesWrite(iowa_context_t contextP,
             // Remove the attributes if it's empty
             serverP->runtime.attributesList = (attributes_t *)IOWA_UTILS_LIST_REMOVE(serverP->runtime.attributesList, attributesP);
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+            coreContextJournalAttributes(contextP, serverP, &attributesP->uri, NULL);
+#endif
             iowa_system_free(attributesP);
             return IOWA_COAP_NO_ERROR;
         }
@@ -384,6 +387,10 @@ iowa_status_t attributesWrite(iowa_context_t contextP,
         {
             attributesP->step = readAttr.step;
         }
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+        coreContextJournalAttributes(contextP, serverP, &attributesP->uri, attributesP);
+#endif
     }
     else
     {
@@ -406,6 +413,10 @@ iowa_status_t attributesWrite(iowa_context_t contextP,
 
         // Add the attributes
         serverP->runtime.attributesList = (attributes_t *)IOWA_UTILS_LIST_ADD(serverP->runtime.attributesList, newAttributesP);
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+        coreContextJournalAttributes(contextP, serverP, &newAttributesP->uri, newAttributesP);
+#endif
     }
 
     return IOWA_COAP_NO_ERROR;
@@ -44,11 +44,468 @@
 
 #define PRV_BS_REQUEST_PAYLOAD_DUMMY_DATA_LENGTH 4 // '</>;'
 
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+
+#define PRV_CLIENT_ID_MAX 0xFFFEU
+
 /*************************************************************************************
 ** Private functions
 *************************************************************************************/
 
+static void prv_callMonitorCallback(iowa_context_t contextP,
+                                    lwm2m_bootstrap_client_t *clientP,
+                                    iowa_state_t state)
+{
+    // WARNING: This function is called in a critical section
+    iowa_client_t userClient;
+
+    if (contextP->lwm2mContextP->bootstrapMonitorCallback == NULL)
+    {
+        return;
+    }
+
+    memset(&userClient, 0, sizeof(iowa_client_t));
+    userClient.name = clientP->name;
+    userClient.id = (uint16_t)clientP->internalID;
+    if (clientP->peerP != NULL)
+    {
+        userClient.connectionType = coapPeerGetConnectionType(clientP->peerP);
+        userClient.secureConnection = securityGetIsSecure(contextP, coapPeerGetSecuritySession(clientP->peerP));
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+    contextP->lwm2mContextP->bootstrapMonitorCallback(&userClient, state, contextP->lwm2mContextP->bootstrapMonitorUserData, contextP);
+    CRIT_SECTION_ENTER(contextP);
+}
+
+static lwm2m_bootstrap_client_t * prv_findClientByName(iowa_context_t contextP,
+                                                       const char *name)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+
+    for (clientP = contextP->lwm2mContextP->bootstrapClientList; clientP != NULL; clientP = clientP->next)
+    {
+        if (0 == strcmp(clientP->name, name))
+        {
+            break;
+        }
+    }
+
+    return clientP;
+}
+
+static lwm2m_bootstrap_client_t * prv_findClientByPeer(iowa_context_t contextP,
+                                                       iowa_coap_peer_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+
+    for (clientP = contextP->lwm2mContextP->bootstrapClientList; clientP != NULL; clientP = clientP->next)
+    {
+        if (clientP->peerP == peerP)
+        {
+            break;
+        }
+    }
+
+    return clientP;
+}
+
+static lwm2m_bootstrap_client_t * prv_findClientById(iowa_context_t contextP,
+                                                     uint32_t clientId)
+{
+    // WARNING: This function is called in a critical section
+    return (lwm2m_bootstrap_client_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->bootstrapClientList, listFindCallbackBy32bitsId, &clientId);
+}
+
+static iowa_status_t prv_newClientId(iowa_context_t contextP,
+                                     uint32_t *idP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_context_t *lwm2mContextP;
+    uint32_t count;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    for (count = 0; count <= PRV_CLIENT_ID_MAX; count++)
+    {
+        uint32_t id;
+
+        id = lwm2mContextP->nextBootstrapClientID;
+        if (lwm2mContextP->nextBootstrapClientID == PRV_CLIENT_ID_MAX)
+        {
+            lwm2mContextP->nextBootstrapClientID = 0;
+        }
+        else
+        {
+            lwm2mContextP->nextBootstrapClientID++;
+        }
+
+        if (prv_findClientById(contextP, id) == NULL)
+        {
+            *idP = id;
+            return IOWA_COAP_NO_ERROR;
+        }
+    }
+
+    IOWA_LOG_ERROR(IOWA_PART_LWM2M, "No more Client ID available.");
+
+    return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+}
+
+static void prv_freeClient(iowa_context_t contextP,
+                           lwm2m_bootstrap_client_t *clientP)
+{
+    // WARNING: This function is called in a critical section
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Freeing bootstrap client %u.", clientP->internalID);
+
+    contextP->lwm2mContextP->bootstrapClientList = (lwm2m_bootstrap_client_t *)IOWA_UTILS_LIST_REMOVE(contextP->lwm2mContextP->bootstrapClientList, clientP);
+
+    if (clientP->timerP != NULL)
+    {
+        coreTimerDelete(contextP, clientP->timerP);
+    }
+
+    // Deleting the peer calls the callback of a pending Bootstrap-Pack which does not find the Client anymore
+    if (clientP->peerP != NULL)
+    {
+        coapPeerDelete(contextP, clientP->peerP);
+    }
+
+    iowa_system_free(clientP->name);
+    iowa_system_free(clientP);
+}
+
+static void prv_clientTimerCallback(iowa_context_t contextP,
+                                    void *userData)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+
+    clientP = (lwm2m_bootstrap_client_t *)userData;
+
+    // The timer is freed by coreTimerStep()
+    clientP->timerP = NULL;
+
+    if (clientP->state == BS_CLIENT_STATE_PACK_REQUESTED
+        || clientP->state == BS_CLIENT_STATE_PACK_SENT)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Bootstrap of client %u timed out.", clientP->internalID);
+
+        clientP->state = BS_CLIENT_STATE_FAILED;
+        prv_callMonitorCallback(contextP, clientP, IOWA_STATE_BOOTSTRAP_FAILED);
+    }
+
+    prv_freeClient(contextP, clientP);
+}
+
+static void prv_endBootstrap(iowa_context_t contextP,
+                             lwm2m_bootstrap_client_t *clientP,
+                             lwm2m_bootstrap_client_state_t state)
+{
+    // WARNING: This function is called in a critical section
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Bootstrap of client %u %s.", clientP->internalID, (state == BS_CLIENT_STATE_FINISHED) ? "finished" : "failed");
+
+    clientP->state = state;
+
+    // The peer can not be deleted from its own callbacks, the Client is freed by bootstrapServerStep()
+    contextP->timeout = 0;
+
+    prv_callMonitorCallback(contextP, clientP, (state == BS_CLIENT_STATE_FINISHED) ? IOWA_STATE_BOOTSTRAP_FINISHED : IOWA_STATE_BOOTSTRAP_FAILED);
+}
+
+static void prv_packResultCallback(iowa_coap_peer_t *fromPeer,
+                                   uint8_t code,
+                                   iowa_coap_message_t *messageP,
+                                   void *userData,
+                                   iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+
+    (void)code;
+    (void)userData;
+
+    // The connection may have been handed over to another Client since the Bootstrap-Pack was sent
+    clientP = prv_findClientByPeer(contextP, fromPeer);
+    if (clientP == NULL
+        || clientP->state != BS_CLIENT_STATE_PACK_SENT)
+    {
+        // The Client is being freed or sent a new Bootstrap-Pack-Request
+        return;
+    }
+
+    if (messageP != NULL
+        && messageP->type == IOWA_COAP_TYPE_ACKNOWLEDGEMENT)
+    {
+        prv_endBootstrap(contextP, clientP, BS_CLIENT_STATE_FINISHED);
+    }
+    else
+    {
+        prv_endBootstrap(contextP, clientP, BS_CLIENT_STATE_FAILED);
+    }
+}
+
+static char * prv_getEndpointName(iowa_coap_message_t *messageP)
+{
+    iowa_coap_option_t *optionP;
+
+    for (optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_URI_QUERY);
+         optionP != NULL && optionP->number == IOWA_COAP_OPTION_URI_QUERY;
+         optionP = optionP->next)
+    {
+        if (optionP->length > QUERY_NAME_LEN
+            && 0 == memcmp(optionP->value.asBuffer, QUERY_NAME, QUERY_NAME_LEN))
+        {
+            return utilsBufferToString(optionP->value.asBuffer + QUERY_NAME_LEN, optionP->length - QUERY_NAME_LEN);
+        }
+    }
+
+    return NULL;
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
 
+#ifdef LWM2M_BOOTSTRAP_PACK_SUPPORT
+void bootstrapServerHandlePackRequest(iowa_context_t contextP,
+                                      lwm2m_bootstrap_client_t *boundClientP,
+                                      iowa_coap_peer_t *fromPeer,
+                                      iowa_coap_message_t *requestP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_option_t *optionP;
+    lwm2m_bootstrap_client_t *clientP;
+    char *name;
+    iowa_status_t result;
+
+    if (requestP->code != IOWA_COAP_CODE_GET)
+    {
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_405_METHOD_NOT_ALLOWED);
+        return;
+    }
+
+    // The Bootstrap-Pack is only encoded in SenML CBOR
+    optionP = iowa_coap_message_find_option(requestP, IOWA_COAP_OPTION_ACCEPT);
+    if (optionP != NULL
+        && optionP->value.asInteger != IOWA_CONTENT_FORMAT_SENML_CBOR)
+    {
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_406_NOT_ACCEPTABLE);
+        return;
+    }
+
+    name = prv_getEndpointName(requestP);
+    if (name == NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Bootstrap-Pack-Request without Endpoint Name.");
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_400_BAD_REQUEST);
+        return;
+    }
+
+    clientP = prv_findClientByName(contextP, name);
+    if (clientP != NULL
+        && clientP->peerP != fromPeer)
+    {
+        // The Client restarted its bootstrap through a new connection
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Bootstrap client \"%s\" changed connection.", name);
+        prv_freeClient(contextP, clientP);
+        clientP = NULL;
+    }
+
+    if (clientP != NULL)
+    {
+        iowa_system_free(name);
+        result = coreTimerReset(contextP, clientP->timerP, coapPeerGetExchangeLifetime(fromPeer));
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            coapSendResponse(contextP, fromPeer, requestP, result);
+            return;
+        }
+    }
+    else
+    {
+        clientP = (lwm2m_bootstrap_client_t *)iowa_system_malloc(sizeof(lwm2m_bootstrap_client_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (clientP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(sizeof(lwm2m_bootstrap_client_t));
+            iowa_system_free(name);
+            coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_500_INTERNAL_SERVER_ERROR);
+            return;
+        }
+#endif
+        memset(clientP, 0, sizeof(lwm2m_bootstrap_client_t));
+        clientP->name = name;
+
+        result = prv_newClientId(contextP, &(clientP->internalID));
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            // Past the exchange lifetime, the Client does not wait for the Bootstrap-Pack anymore
+            clientP->timerP = coreTimerNew(contextP, coapPeerGetExchangeLifetime(fromPeer), prv_clientTimerCallback, clientP);
+            if (clientP->timerP == NULL)
+            {
+                IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create the timer.");
+                result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            iowa_system_free(clientP->name);
+            iowa_system_free(clientP);
+            coapSendResponse(contextP, fromPeer, requestP, result);
+            return;
+        }
+
+        if (boundClientP != NULL)
+        {
+            // The connection was used by another Client which is not bootstrapped
+            boundClientP->peerP = NULL;
+            if (boundClientP->state == BS_CLIENT_STATE_PACK_REQUESTED
+                || boundClientP->state == BS_CLIENT_STATE_PACK_SENT)
+            {
+                prv_endBootstrap(contextP, boundClientP, BS_CLIENT_STATE_FAILED);
+            }
+        }
+        clientP->peerP = fromPeer;
+        coapPeerSetCallbacks(fromPeer, lwm2m_bootstrap_server_handle_request, NULL, clientP);
+
+        contextP->lwm2mContextP->bootstrapClientList = (lwm2m_bootstrap_client_t *)IOWA_UTILS_LIST_ADD(contextP->lwm2mContextP->bootstrapClientList, clientP);
+    }
+
+    clientP->state = BS_CLIENT_STATE_PACK_REQUESTED;
+    clientP->tokenLength = requestP->tokenLength;
+    memcpy(clientP->token, requestP->token, requestP->tokenLength);
+
+    switch (coapPeerGetConnectionType(fromPeer))
+    {
+    case IOWA_CONN_DATAGRAM:
+    case IOWA_CONN_LORAWAN:
+    case IOWA_CONN_SMS:
+        clientP->isConfirmable = (requestP->type == IOWA_COAP_TYPE_CONFIRMABLE);
+        if (clientP->isConfirmable == true)
+        {
+            // The Bootstrap-Pack is sent later in a separate response
+            coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_CODE_EMPTY);
+        }
+        break;
+
+    default:
+        clientP->isConfirmable = false;
+        break;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client \"%s\" requests a Bootstrap-Pack with ID %u.", clientP->name, clientP->internalID);
+
+    prv_callMonitorCallback(contextP, clientP, IOWA_STATE_BOOTSTRAP_PACK_REQUIRED);
+}
+
+iowa_status_t bootstrapServerSendPack(iowa_context_t contextP,
+                                      uint32_t clientId,
+                                      uint8_t *payload,
+                                      size_t payloadLength)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    iowa_status_t result;
+
+    clientP = prv_findClientById(contextP, clientId);
+    if (clientP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Bootstrap client %u not found.", clientId);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+    if (clientP->state != BS_CLIENT_STATE_PACK_REQUESTED)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Bootstrap client %u is not waiting for a Bootstrap-Pack.", clientId);
+        return IOWA_COAP_412_PRECONDITION_FAILED;
+    }
+    if (clientP->peerP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Bootstrap client %u is not connected.", clientId);
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    messageP = iowa_coap_message_new(clientP->isConfirmable ? IOWA_COAP_TYPE_CONFIRMABLE : IOWA_COAP_TYPE_NON_CONFIRMABLE, IOWA_COAP_205_CONTENT, clientP->tokenLength, clientP->token);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP message.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
+        iowa_coap_message_free(messageP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    optionP->value.asInteger = IOWA_CONTENT_FORMAT_SENML_CBOR;
+    iowa_coap_message_add_option(messageP, optionP);
+
+    coreBufferSet(&(messageP->payload), payload, payloadLength);
+
+    result = coapSend(contextP, clientP->peerP, messageP, clientP->isConfirmable ? prv_packResultCallback : NULL, NULL);
+    iowa_coap_message_free(messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to send the Bootstrap-Pack: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        return result;
+    }
+
+    if (clientP->isConfirmable == true)
+    {
+        clientP->state = BS_CLIENT_STATE_PACK_SENT;
+    }
+    else
+    {
+        // No acknowledgement is expected
+        prv_endBootstrap(contextP, clientP, BS_CLIENT_STATE_FINISHED);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif // LWM2M_BOOTSTRAP_PACK_SUPPORT
+
+void bootstrapServerStep(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+    lwm2m_bootstrap_client_t *nextP;
+
+    clientP = contextP->lwm2mContextP->bootstrapClientList;
+    while (clientP != NULL)
+    {
+        nextP = clientP->next;
+
+        if (clientP->state == BS_CLIENT_STATE_FINISHED
+            || clientP->state == BS_CLIENT_STATE_FAILED)
+        {
+            prv_freeClient(contextP, clientP);
+        }
+
+        clientP = nextP;
+    }
+}
+
+void bootstrapServerClose(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+
+    while (contextP->lwm2mContextP->bootstrapClientList != NULL)
+    {
+        prv_freeClient(contextP, contextP->lwm2mContextP->bootstrapClientList);
+    }
+}
+
+#endif // LWM2M_BOOTSTRAP_SERVER_MODE
+
@@ -120,6 +120,7 @@ void lwm2m_close(iowa_context_t contextP)
 
         customObjectDelete(objectP);
     }
+    iowa_system_free(contextP->lwm2mContextP->regPayload);
 
     iowa_system_free(contextP->lwm2mContextP->endpointName);
 #ifdef LWM2M_ALTPATH_SUPPORT
@@ -127,6 +128,17 @@ void lwm2m_close(iowa_context_t contextP)
 #endif
 #endif // LWM2M_CLIENT_MODE
 
+#ifdef LWM2M_SERVER_MODE
+    registryClose(contextP);
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+    observe_clearNotificationQueue(contextP);
+#endif
+#endif
+
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+    bootstrapServerClose(contextP);
+#endif
+
     iowa_system_free(contextP->lwm2mContextP);
     contextP->lwm2mContextP = NULL;
 
@@ -219,8 +231,16 @@ void lwm2m_server_close(iowa_context_t contextP,
     }
 
     utilsDisconnectServer(contextP, serverP);
-    attributesRemoveFromServer(serverP);
-    observeRemoveFromServer(serverP);
+
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    // After a registration failure, the observations are kept along the notification store so that the notifications
+    // resume after the next registration. They are removed with the Server in utilsFreeServer().
+    if (sendDeregistration == true)
+#endif
+    {
+        attributesRemoveFromServer(serverP);
+        observeRemoveFromServer(serverP);
+    }
 }
 #endif // LWM2M_CLIENT_MODE
 
@@ -279,6 +299,10 @@ iowa_status_t lwm2m_step(iowa_context_t contextP)
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Final state: %s.", LWM2M_STR_STATE(contextP->lwm2mContextP->state));
 #endif
 
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+    bootstrapServerStep(contextP);
+#endif
+
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Exiting with result: %u.%02u, timeout: %u.", (result & 0xFF) >> 5, (result & 0x1F), contextP->timeout);
 
     return result;
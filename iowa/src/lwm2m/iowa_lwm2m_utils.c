@@ -178,6 +178,18 @@ iowa_content_format_t utils_getMediaType(iowa_coap_message_t *messageP,
 #ifdef LWM2M_SUPPORT_TLV
     case IOWA_CONTENT_FORMAT_TLV_OLD:
     case IOWA_CONTENT_FORMAT_TLV:
+#endif
+#ifdef LWM2M_SUPPORT_CBOR
+    case IOWA_CONTENT_FORMAT_CBOR:
+#endif
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    case IOWA_CONTENT_FORMAT_SENML_JSON:
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+#endif
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
 #endif
         break;
 
@@ -293,12 +305,250 @@ void utilsFreeServer(iowa_context_t contextP,
     // WARNING: This function is called in a critical section
 
     iowa_system_free(serverP->runtime.location);
-    iowa_system_free(serverP->uri);
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    attributesRemoveFromServer(serverP);
+    observeRemoveFromServer(serverP);
+#endif
+#ifdef IOWA_STORAGE_CONTEXT_MAPPED_SUPPORT
+    if (coreContextIsMapped(contextP, serverP->uri) == false)
+#endif
+    {
+        iowa_system_free(serverP->uri);
+    }
     iowa_system_free(serverP);
 }
 
 #endif // LWM2M_CLIENT_MODE
 
+#ifdef LWM2M_SERVER_MODE
+#define RES_ID_TO_TYPE(O, R) case IOWA_LWM2M_##O##_ID_##R : return IOWA_LWM2M_##O##_TYPE_##R
+
+static iowa_lwm2m_data_type_t prv_getDefaultResourceType(uint16_t objectID,
+                                                         uint16_t resourceID)
+{
+    switch (objectID)
+    {
+    case IOWA_LWM2M_SERVER_OBJECT_ID:
+        switch (resourceID)
+        {
+        RES_ID_TO_TYPE(SERVER, SHORT_ID);
+        RES_ID_TO_TYPE(SERVER, LIFETIME);
+        RES_ID_TO_TYPE(SERVER, MIN_PERIOD);
+        RES_ID_TO_TYPE(SERVER, MAX_PERIOD);
+        RES_ID_TO_TYPE(SERVER, TIMEOUT);
+        RES_ID_TO_TYPE(SERVER, STORING);
+        RES_ID_TO_TYPE(SERVER, BINDING);
+        RES_ID_TO_TYPE(SERVER, APN_LINK);
+        RES_ID_TO_TYPE(SERVER, TLS_DTLS_ALERT);
+        RES_ID_TO_TYPE(SERVER, LAST_BOOTSTRAP);
+        RES_ID_TO_TYPE(SERVER, PRIORITY);
+        RES_ID_TO_TYPE(SERVER, INITIAL_DELAY);
+        RES_ID_TO_TYPE(SERVER, REG_FAIL_BLOCK);
+        RES_ID_TO_TYPE(SERVER, BOOTSTRAP_REG_FAIL);
+        RES_ID_TO_TYPE(SERVER, COMM_RETRY_COUNT);
+        RES_ID_TO_TYPE(SERVER, COMM_RETRY_TIMER);
+        RES_ID_TO_TYPE(SERVER, COMM_SEQUENCE_DELAY);
+        RES_ID_TO_TYPE(SERVER, COMM_SEQUENCE_COUNT);
+        RES_ID_TO_TYPE(SERVER, TRIGGER);
+        RES_ID_TO_TYPE(SERVER, PREF_TRANSPORT);
+        RES_ID_TO_TYPE(SERVER, MUTE_SEND);
+        default:
+            break;
+        }
+        break;
+
+    case IOWA_LWM2M_DEVICE_OBJECT_ID:
+        switch (resourceID)
+        {
+        RES_ID_TO_TYPE(DEVICE, MANUFACTURER);
+        RES_ID_TO_TYPE(DEVICE, MODEL_NUMBER);
+        RES_ID_TO_TYPE(DEVICE, SERIAL_NUMBER);
+        RES_ID_TO_TYPE(DEVICE, FIRMWARE_VERSION);
+        RES_ID_TO_TYPE(DEVICE, AVAILABLE_POWER_SRC);
+        RES_ID_TO_TYPE(DEVICE, POWER_SRC_VOLTAGE);
+        RES_ID_TO_TYPE(DEVICE, POWER_SRC_CURRENT);
+        RES_ID_TO_TYPE(DEVICE, BATTERY_LEVEL);
+        RES_ID_TO_TYPE(DEVICE, MEMORY_FREE);
+        RES_ID_TO_TYPE(DEVICE, ERROR_CODE);
+        RES_ID_TO_TYPE(DEVICE, CURRENT_TIME);
+        RES_ID_TO_TYPE(DEVICE, UTC_OFFSET);
+        RES_ID_TO_TYPE(DEVICE, TIME_ZONE);
+        RES_ID_TO_TYPE(DEVICE, BINDING);
+        RES_ID_TO_TYPE(DEVICE, TYPE);
+        RES_ID_TO_TYPE(DEVICE, HARDWARE_VERSION);
+        RES_ID_TO_TYPE(DEVICE, SOFTWARE_VERSION);
+        RES_ID_TO_TYPE(DEVICE, BATTERY_STATUS);
+        RES_ID_TO_TYPE(DEVICE, MEMORY_TOTAL);
+        RES_ID_TO_TYPE(DEVICE, EXT_DEV_INFO);
+        default:
+            break;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return IOWA_LWM2M_TYPE_UNDEFINED;
+}
+
+iowa_lwm2m_data_type_t utils_getResourceType(uint16_t objectID,
+                                             uint16_t resourceID,
+                                             void *userData)
+{
+    // WARNING: This function is called in a critical section
+    iowa_context_t contextP;
+    iowa_lwm2m_data_type_t type;
+
+    contextP = (iowa_context_t)userData;
+
+    type = IOWA_LWM2M_TYPE_UNDEFINED;
+    if (contextP->lwm2mContextP->resTypeCallback != NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        type = contextP->lwm2mContextP->resTypeCallback(objectID, resourceID, contextP->lwm2mContextP->monitorUserData);
+        CRIT_SECTION_ENTER(contextP);
+    }
+    if (type == IOWA_LWM2M_TYPE_UNDEFINED)
+    {
+        type = prv_getDefaultResourceType(objectID, resourceID);
+    }
+
+    return type;
+}
+
+size_t utils_stringToBinding(uint8_t *strBinding,
+                             size_t strBindingLen,
+                             iowa_lwm2m_binding_t *bindingP)
+{
+    size_t index;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Entering with strBindingLen: %u.", strBindingLen);
+
+    if (strBindingLen == 0)
+    {
+        return 0;
+    }
+
+    *bindingP = 0;
+
+    for (index = 0; index < strBindingLen; index++)
+    {
+        switch (strBinding[index])
+        {
+        case QUERY_BINDING_UDP:
+            *bindingP |= IOWA_LWM2M_BINDING_UDP;
+            break;
+
+        case QUERY_BINDING_TCP:
+            *bindingP |= IOWA_LWM2M_BINDING_TCP;
+            break;
+
+        case QUERY_BINDING_SMS:
+            *bindingP |= IOWA_LWM2M_BINDING_SMS;
+            break;
+
+        case QUERY_BINDING_NON_IP:
+            *bindingP |= IOWA_LWM2M_BINDING_NON_IP;
+            break;
+
+        case QUERY_BINDING_QUEUE_MODE:
+            *bindingP |= BINDING_Q;
+            break;
+
+        default:
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Unknown binding character: '%c'.", strBinding[index]);
+            return 0;
+        }
+    }
+
+    return strBindingLen;
+}
+
+void utils_freeClient(iowa_context_t contextP,
+                      lwm2m_client_t *clientP)
+{
+    // WARNING: This function is called in a critical section
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Freeing client %u.", clientP->internalID);
+
+    if (clientP->timerP != NULL)
+    {
+        coreTimerDelete(contextP, clientP->timerP);
+    }
+
+    while (clientP->observationList != NULL)
+    {
+        lwm2m_observation_t *observationP;
+
+        observationP = clientP->observationList;
+        clientP->observationList = observationP->next;
+
+        iowa_system_free(observationP->uriP);
+        iowa_system_free(observationP);
+    }
+
+    if (clientP->peerP != NULL)
+    {
+        coapPeerDelete(contextP, clientP->peerP);
+    }
+
+    iowa_system_free(clientP->name);
+    iowa_system_free(clientP->msisdn);
+    iowa_system_free(clientP->altPath);
+    iowa_system_free(clientP->objectLinkArray);
+    iowa_system_free(clientP);
+}
+
+void convertLwm2mClientToUserClient(iowa_context_t contextP,
+                                    lwm2m_client_t *lwm2mClientP,
+                                    iowa_client_t *userClientP,
+                                    bool duplicate)
+{
+    // WARNING: This function is called in a critical section
+
+    memset(userClientP, 0, sizeof(iowa_client_t));
+
+    userClientP->id = (uint16_t)lwm2mClientP->internalID;
+    userClientP->queueMode = ((lwm2mClientP->binding & BINDING_Q) != 0);
+    userClientP->supportedFormats = lwm2mClientP->supportedFormats;
+    userClientP->lifetime = lwm2mClientP->lifetime;
+    userClientP->lwm2mVersion = lwm2mClientP->lwm2mVersion;
+    userClientP->objectLinkCount = lwm2mClientP->objectLinkCount;
+
+    if (lwm2mClientP->peerP != NULL)
+    {
+        userClientP->connectionType = coapPeerGetConnectionType(lwm2mClientP->peerP);
+        userClientP->secureConnection = securityGetIsSecure(contextP, coapPeerGetSecuritySession(lwm2mClientP->peerP));
+    }
+
+    if (duplicate == false)
+    {
+        userClientP->name = lwm2mClientP->name;
+        userClientP->msisdn = lwm2mClientP->msisdn;
+        userClientP->objectLinkArray = lwm2mClientP->objectLinkArray;
+        return;
+    }
+
+    // On allocation failure, the matching field is left nil
+    userClientP->name = utilsStrdup(lwm2mClientP->name);
+    userClientP->msisdn = utilsStrdup(lwm2mClientP->msisdn);
+    if (lwm2mClientP->objectLinkCount != 0)
+    {
+        userClientP->objectLinkArray = (iowa_lwm2m_object_link_t *)iowa_system_malloc(lwm2mClientP->objectLinkCount * sizeof(iowa_lwm2m_object_link_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (userClientP->objectLinkArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(lwm2mClientP->objectLinkCount * sizeof(iowa_lwm2m_object_link_t));
+            userClientP->objectLinkCount = 0;
+            return;
+        }
+#endif
+        memcpy(userClientP->objectLinkArray, lwm2mClientP->objectLinkArray, lwm2mClientP->objectLinkCount * sizeof(iowa_lwm2m_object_link_t));
+    }
+}
+#endif // LWM2M_SERVER_MODE
+
 bool utilsListFindCallbackServer(void *nodeP,
                                  void *criteriaP)
 {
@@ -90,6 +90,9 @@ void dm_handleRequest(iowa_context_t contextP,
 #if defined(LWM2M_SUPPORT_TLV) || defined(LWM2M_SUPPORT_JSON)
     uint8_t uriBufferP[PRV_URI_BUFFER_SIZE];
 #endif
+#ifdef IOWA_TRACE_SUPPORT
+    uint64_t traceTime;
+#endif
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Code: %u.%02u, server status: %s", messageP->code >> 5, messageP->code & 0x1F, LWM2M_SERVER_STR_STATUS(serverP->runtime.status));
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "URI: /%u/%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId, uriP->resInstanceId);
@@ -97,6 +100,9 @@ void dm_handleRequest(iowa_context_t contextP,
     switch (uriP->objectId)
     {
     case IOWA_LWM2M_SECURITY_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
         IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Rejecting DM operation on the Object: %u", uriP->objectId);
         coapSendResponse(contextP, serverP->runtime.peerP, messageP, IOWA_COAP_401_UNAUTHORIZED);
         return;
@@ -157,7 +163,9 @@ void dm_handleRequest(iowa_context_t contextP,
 
     default:
         {
+            CORE_TRACE_TIME(contextP, traceTime);
             result = dataLwm2mDeserialize(uriP, messageP->payload.data, messageP->payload.length, requestFormat, &dataP, &dataCount, object_getResourceType, contextP);
+            CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_DECODE, traceTime);
             if (result != IOWA_COAP_NO_ERROR)
             {
                 IOWA_LOG_INFO(IOWA_PART_LWM2M, "Parsing received data failed.");
@@ -215,7 +223,9 @@ void dm_handleRequest(iowa_context_t contextP,
         {
             {
                 {
+                    CORE_TRACE_TIME(contextP, traceTime);
                     result = object_read(contextP, uriP, serverP->shortId, &dataCount, &dataP);
+                    CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_READ, traceTime);
                 }
                 if (IOWA_COAP_205_CONTENT == result)
                 {
@@ -223,7 +233,9 @@ void dm_handleRequest(iowa_context_t contextP,
                         uint8_t *bufferP;
                         size_t bufferLengthP;
 
+                        CORE_TRACE_TIME(contextP, traceTime);
                         result = dataLwm2mSerialize(uriP, dataP, dataCount, &responseFormat, &bufferP, &bufferLengthP);
+                        CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_ENCODE, traceTime);
                         if (result == IOWA_COAP_NO_ERROR)
                         {
                             coreBufferSet(&(responseP->payload), bufferP, bufferLengthP);
@@ -458,6 +470,9 @@ error:
 
                     // Memorize previous observe
                     observedP = serverP->runtime.observedList->next;
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+                    coreContextJournalObservationCanceled(contextP, serverP, serverP->runtime.observedList);
+#endif
                     // Delete last observe
                     observe_delete(serverP->runtime.observedList);
                     serverP->runtime.observedList = observedP;
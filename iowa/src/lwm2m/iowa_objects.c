@@ -95,10 +95,15 @@ static iowa_status_t prv_callDataCb(iowa_context_t contextP,
                                     iowa_lwm2m_data_t *dataP)
 {
     iowa_status_t result;
+#ifdef IOWA_TRACE_SUPPORT
+    uint64_t traceTime;
+#endif
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Calling dataCb() for %s on %u resources.", STR_DM_OPERATION(op), dataCount);
+    CORE_TRACE_TIME(contextP, traceTime);
     CRIT_SECTION_LEAVE(contextP);
     result = objectP->dataCb(op, dataP, dataCount, objectP->userData, contextP);
     CRIT_SECTION_ENTER(contextP);
+    CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_CALLBACK, traceTime);
     return result;
 }
 
@@ -1006,6 +1011,11 @@ static iowa_status_t prv_create(iowa_context_t contextP,
         {
             result = prv_addInstance(objectP, dataP[0].instanceID, 0, NULL);
         }
+
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            lwm2mObjectTreeChanged(contextP);
+        }
     }
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Exiting with code %u.%02u", (result & 0xFF) >> 5, (result & 0x1F));
@@ -1086,6 +1096,7 @@ static iowa_status_t prv_deleteObjectInstance(iowa_context_t contextP,
     }
 
     (void)prv_removeInstance(objectP, uriP->instanceId);
+    lwm2mObjectTreeChanged(contextP);
     observe_clear(contextP, uriP);
 
     return IOWA_COAP_202_DELETED;
@@ -2358,6 +2369,7 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
         break;
     }
     contextP->lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_ADD(contextP->lwm2mContextP->objectList, objectP);
+    lwm2mObjectTreeChanged(contextP);
 
     if (contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2407,6 +2419,7 @@ iowa_status_t customObjectRemove(iowa_context_t contextP,
     }
 
     customObjectDelete(objectP);
+    lwm2mObjectTreeChanged(contextP);
 
     if (contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2490,6 +2503,11 @@ iowa_status_t objectAddInstance(iowa_context_t contextP,
         result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        lwm2mObjectTreeChanged(contextP);
+    }
+
     if (result == IOWA_COAP_NO_ERROR
         && contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2522,6 +2540,10 @@ iowa_status_t objectRemoveInstance(iowa_context_t contextP,
     }
 
     result = prv_removeInstance(objectP, instanceID);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        lwm2mObjectTreeChanged(contextP);
+    }
 
     if (result == IOWA_COAP_NO_ERROR
         && contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
@@ -2529,6 +2551,9 @@ iowa_status_t objectRemoveInstance(iowa_context_t contextP,
         switch (objectID)
         {
         case IOWA_LWM2M_SECURITY_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+        case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
             // No need to update registration for objects not exposed to the Server
             break;
 
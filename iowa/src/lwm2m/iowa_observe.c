@@ -280,6 +280,10 @@ void observeRemoveFromServer(lwm2m_server_t *serverP)
         observe_delete(serverP->runtime.observedList);
         serverP->runtime.observedList = observedP;
     }
+
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    valueDeleteNotificationStore(serverP);
+#endif
 }
 
 // Update observe according with its attributes.
@@ -432,6 +436,10 @@ static void prv_observeRemove(iowa_context_t contextP,
 
     serverP->runtime.observedList = (lwm2m_observed_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(serverP->runtime.observedList, prv_observeFind, observedP, NULL);
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    coreContextJournalObservationCanceled(contextP, serverP, observedP);
+#endif
+
     prv_callObservationEventCallback(contextP, observedP, IOWA_EVENT_OBSERVATION_CANCELED, NULL);
 
     observe_delete(observedP);
@@ -656,6 +664,10 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
             serverP->runtime.observedList = observedP;
         }
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+        coreContextJournalObservation(contextP, serverP, observedP);
+#endif
+
         if (eventRequired == true)
         {
             prv_callObservationEventCallback(contextP, observedP, IOWA_EVENT_OBSERVATION_STARTED, NULL);
@@ -725,6 +737,9 @@ void observe_clear(iowa_context_t contextP,
                 nextP = observedP->next;
 
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Delete observation: %p.", observedP);
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+                coreContextJournalObservationCanceled(contextP, serverP, observedP);
+#endif
                 observe_delete(observedP);
                 if (parentP == NULL)
                 {
@@ -813,6 +828,9 @@ static void prv_notificationCallback(iowa_coap_peer_t *fromPeer,
     // WARNING: This function is called in a critical section
     lwm2m_value_t *valueP;
     lwm2m_server_t *serverP;
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    lwm2m_observed_t *observedP;
+#endif
 
     (void)status;
 
@@ -867,6 +885,24 @@ static void prv_notificationCallback(iowa_coap_peer_t *fromPeer,
         prv_callObservationEventCallback(contextP, NULL, IOWA_EVENT_OBSERVATION_NOTIFICATION_FAILED, valueP);
 
         serverP->runtime.flags &= (uint16_t)(~LWM2M_SERVER_FLAG_AVAILABLE);
+
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+        // The Server is unreachable: keep this notification and the next ones until the next successful registration
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+        for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+        {
+            if (valueP->tokenLen == observedP->tokenLen
+                && memcmp(valueP->token, observedP->token, valueP->tokenLen) == 0)
+            {
+                // The record is only built now that the payload was not acknowledged
+                if (valueEncodeNotificationPayload(contextP, observedP, valueP) == IOWA_COAP_NO_ERROR)
+                {
+                    valueStoreNotification(serverP, valueP, false);
+                }
+                break;
+            }
+        }
+#endif
     }
 
     valueFree(valueP);
@@ -930,6 +966,13 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
     uint8_t *bufferP;
     size_t bufferLength;
     lwm2m_value_t *valueP;
+    iowa_lwm2m_uri_t *baseUriP;
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    bool isStoring;
+#endif
+#ifdef IOWA_TRACE_SUPPORT
+    uint64_t traceTime;
+#endif
 
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
 
@@ -969,16 +1012,47 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
         }
     }
 
-    result = dataLwm2mSerialize(&observedP->uriInfoP[0].uri, dataP, dataCount, &(observedP->format), &bufferP, &bufferLength);
-    if (result != IOWA_COAP_NO_ERROR)
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    // Until the Server is reachable, the notifications are only kept in the store
+    isStoring = (serverP->runtime.status != STATE_REG_REGISTERED
+                 && serverP->runtime.status != STATE_REG_UPDATE_PENDING)
+                || (serverP->runtime.flags & LWM2M_SERVER_FLAG_NOTIFICATION_STORING) != 0;
+#endif
+
+    // Composite observations have no common base URI, the data carry their full path
+    if (observedP->uriCount == 1)
     {
-        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "dataLwm2mSerialize() failed with code %d.", result);
-        return;
+        baseUriP = &observedP->uriInfoP[0].uri;
+    }
+    else
+    {
+        baseUriP = NULL;
+    }
+
+    bufferP = NULL;
+    bufferLength = 0;
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    if (isStoring == false)
+#endif
+    {
+        CORE_TRACE_TIME(contextP, traceTime);
+        result = dataLwm2mSerialize(baseUriP, dataP, dataCount, &(observedP->format), &bufferP, &bufferLength);
+        CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_ENCODE, traceTime);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "dataLwm2mSerialize() failed with code %d.", result);
+            return;
+        }
     }
 
     observedP->lastTime = contextP->currentTime;
 
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    if (serverP->notifStoring == true
+        || isStoring == true)
+#else
     if (serverP->notifStoring == true)
+#endif
     {
         valueP = (lwm2m_value_t *)iowa_system_malloc(sizeof(lwm2m_value_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
@@ -995,12 +1069,27 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
         valueP->counter = observedP->counter;
         memcpy(valueP->token, observedP->token, observedP->tokenLen);
         valueP->tokenLen = observedP->tokenLen;
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+        valueP->time = contextP->currentTime;
+#endif
     }
     else
     {
         valueP = NULL;
     }
 
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    if (isStoring == true)
+    {
+        // When the Server does not want the notifications to be stored, only the latest value of the observation is kept
+        if (valueEncodeNotification(observedP, dataP, dataCount, valueP) == IOWA_COAP_NO_ERROR)
+        {
+            valueStoreNotification(serverP, valueP, serverP->notifStoring == false);
+        }
+        valueFree(valueP);
+    }
+    else
+#endif
     {
         if (serverP->runtime.status == STATE_REG_REGISTERED
             || serverP->runtime.status == STATE_REG_UPDATE_PENDING)
@@ -1059,18 +1148,42 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
 
             coreBufferSet(&(messageP->payload),bufferP, bufferLength);
 
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+            if (valueP != NULL)
+            {
+                // The payload is kept along the confirmable notification. It is only turned into a record of the
+                // notification store if the Server does not acknowledge it.
+                valueP->format = observedP->format;
+                valueP->buffer = bufferP;
+                valueP->bufferLength = bufferLength;
+                bufferP = NULL;
+            }
+#endif
+
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Send notification number %d.", observedP->counter);
-            (void)coapSend(contextP, serverP->runtime.peerP, messageP, callbackP, valueP);
+            if (coapSend(contextP, serverP->runtime.peerP, messageP, callbackP, valueP) == IOWA_COAP_NO_ERROR)
+            {
+                CORE_METRICS_INCREMENT(contextP, notificationSentCount);
+            }
 
             prv_addMID(observedP, messageP->id);
 
             iowa_coap_message_free(messageP);
             iowa_system_free(bufferP);
         }
+        else
+        {
+            valueFree(valueP);
+            iowa_system_free(bufferP);
+        }
     }
 
     observedP->counter++;
     observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    coreContextJournalObservationCounter(contextP, serverP, observedP);
+#endif
 }
 
 void observe_step(iowa_context_t contextP)
@@ -1092,6 +1205,9 @@ void observe_step(iowa_context_t contextP)
             size_t ind;
             bool sendNotif;
             bool nextObs;
+#ifdef IOWA_TRACE_SUPPORT
+            uint64_t traceTime;
+#endif
             dataP = NULL;
             dataCount = 0;
             sendNotif = false;
@@ -1111,20 +1227,25 @@ void observe_step(iowa_context_t contextP)
                         {
                             // pmin is set and did not elapsed. Ignore this notification.
                             observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
+                            CORE_METRICS_INCREMENT(contextP, notificationSuppressedCount);
                             nextObs = true;
                         }
                     }
                 }
                 if (nextObs == false)
                 {
+                    CORE_TRACE_START(contextP);
                     for (ind = 0; ind < observedP->uriCount; ind++)
                     {
                         //Get value to send
+                        CORE_TRACE_TIME(contextP, traceTime);
                         result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+                        CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_READ, traceTime);
                         {
                             if (result != IOWA_COAP_205_CONTENT)
                             {
                                 IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                                CORE_TRACE_STOP(contextP);
                                 return;
                             }
                         }
@@ -1215,11 +1336,14 @@ void observe_step(iowa_context_t contextP)
                     if (sendNotif == true)
                     {
                         prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+                        CORE_TRACE_END(contextP, IOWA_TRACE_PHASE_NOTIFICATION);
                     }
                     {
                         object_free(contextP, dataCount, dataP);
                         iowa_system_free(dataP);
                     }
+                    // No notification was sent when the value did not cross the thresholds
+                    CORE_TRACE_STOP(contextP);
                     observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
                 }
             }
@@ -1240,19 +1364,24 @@ void observe_step(iowa_context_t contextP)
                             {
                                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Notify on elapsed maximal period (%d s).", observedP->timeAttrP->maxPeriod);
 
+                                CORE_TRACE_START(contextP);
                                 for (ind = 0; ind < observedP->uriCount; ind++)
                                 {
                                     //Get value to send
+                                    CORE_TRACE_TIME(contextP, traceTime);
                                     result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+                                    CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_READ, traceTime);
                                     {
                                         if (result != IOWA_COAP_205_CONTENT)
                                         {
                                             IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                                            CORE_TRACE_STOP(contextP);
                                             return;
                                         }
                                     }
                                 }
                                 prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+                                CORE_TRACE_END(contextP, IOWA_TRACE_PHASE_NOTIFICATION);
                                 object_free(contextP, dataCount, dataP);
                                 iowa_system_free(dataP);
                             }
@@ -1284,3 +1413,257 @@ void observe_step(iowa_context_t contextP)
 }
 #endif // LWM2M_CLIENT_MODE
 
+
+#ifdef LWM2M_SERVER_MODE
+
+static lwm2m_observation_t * prv_findObservationByToken(lwm2m_client_t *clientP,
+                                                        iowa_coap_message_t *messageP)
+{
+    lwm2m_observation_t *observationP;
+
+    for (observationP = clientP->observationList; observationP != NULL; observationP = observationP->next)
+    {
+        if (observationP->tokenLength == messageP->tokenLength
+            && 0 == memcmp(observationP->token, messageP->token, messageP->tokenLength))
+        {
+            break;
+        }
+    }
+
+    return observationP;
+}
+
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+// Add a notification to the queue. The queue takes the ownership of the notification data.
+// Returned value: true if the queue was empty.
+static bool prv_queueNotification(lwm2m_notification_queue_t *queueP,
+                                  uint32_t clientId,
+                                  iowa_status_t status,
+                                  iowa_response_content_t *contentP,
+                                  iowa_response_callback_t responseCb,
+                                  void *userDataP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_notification_t *notificationP;
+    bool wasEmpty;
+
+    if (queueP->count == queueP->capacity)
+    {
+        queueP->stats.droppedCount++;
+
+        if (queueP->policy == IOWA_NOTIFICATION_QUEUE_DROP_NEWEST)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Notification queue full. Dropping the notification from Client %u.", clientId);
+            dataLwm2mFree(contentP->details.observe.dataCount, contentP->details.observe.dataP);
+            return false;
+        }
+
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Notification queue full. Dropping the oldest notification, from Client %u.", queueP->notificationArray[queueP->first].clientId);
+        notificationP = queueP->notificationArray + queueP->first;
+        dataLwm2mFree(notificationP->content.details.observe.dataCount, notificationP->content.details.observe.dataP);
+        queueP->first = (queueP->first + 1) % queueP->capacity;
+        queueP->count--;
+    }
+
+    wasEmpty = (queueP->count == 0);
+
+    notificationP = queueP->notificationArray + (queueP->first + queueP->count) % queueP->capacity;
+    notificationP->clientId = clientId;
+    notificationP->status = status;
+    notificationP->content = *contentP;
+    notificationP->responseCb = responseCb;
+    notificationP->userDataP = userDataP;
+    queueP->count++;
+
+    queueP->stats.queuedCount++;
+    queueP->stats.currentCount = queueP->count;
+    if (queueP->count > queueP->stats.maxCount)
+    {
+        queueP->stats.maxCount = queueP->count;
+    }
+
+    return wasEmpty;
+}
+
+void observe_clearNotificationQueue(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_notification_queue_t *queueP;
+
+    queueP = &(contextP->lwm2mContextP->notificationQueue);
+
+    while (queueP->count > 0)
+    {
+        iowa_notification_t *notificationP;
+
+        notificationP = queueP->notificationArray + queueP->first;
+        dataLwm2mFree(notificationP->content.details.observe.dataCount, notificationP->content.details.observe.dataP);
+        queueP->first = (queueP->first + 1) % queueP->capacity;
+        queueP->count--;
+        queueP->stats.droppedCount++;
+    }
+
+    iowa_system_free(queueP->notificationArray);
+    queueP->notificationArray = NULL;
+    queueP->capacity = 0;
+    queueP->first = 0;
+    queueP->stats.currentCount = 0;
+}
+
+size_t observe_takeNotifications(iowa_context_t contextP,
+                                 iowa_notification_t *notificationArray,
+                                 size_t arraySize)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_notification_queue_t *queueP;
+    size_t count;
+    size_t firstPart;
+
+    queueP = &(contextP->lwm2mContextP->notificationQueue);
+
+    count = queueP->count < arraySize ? queueP->count : arraySize;
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // The notifications may wrap around the end of the ring
+    firstPart = queueP->capacity - queueP->first;
+    if (firstPart > count)
+    {
+        firstPart = count;
+    }
+    memcpy(notificationArray, queueP->notificationArray + queueP->first, firstPart * sizeof(iowa_notification_t));
+    if (firstPart < count)
+    {
+        memcpy(notificationArray + firstPart, queueP->notificationArray, (count - firstPart) * sizeof(iowa_notification_t));
+    }
+
+    queueP->first = (queueP->first + count) % queueP->capacity;
+    queueP->count -= count;
+    queueP->stats.deliveredCount += (uint32_t)count;
+    queueP->stats.currentCount = queueP->count;
+
+    return count;
+}
+#endif // LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+
+void observe_remove(lwm2m_observation_t *observationP)
+{
+    // WARNING: This function is called in a critical section
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Removing observation %u.", observationP->id);
+
+    observationP->clientP->observationList = (lwm2m_observation_t *)IOWA_UTILS_LIST_REMOVE(observationP->clientP->observationList, observationP);
+    iowa_system_free(observationP->uriP);
+    iowa_system_free(observationP);
+}
+
+void observe_handleNotify(iowa_context_t contextP,
+                          lwm2m_client_t *clientP,
+                          iowa_coap_peer_t *fromPeer,
+                          iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_observation_t *observationP;
+    iowa_coap_option_t *optionP;
+    iowa_response_content_t content;
+    iowa_response_callback_t responseCb;
+    void *userDataP;
+    iowa_status_t status;
+    iowa_content_format_t format;
+    uint32_t clientId;
+    bool isObserved;
+
+    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+
+    observationP = prv_findObservationByToken(clientP, messageP);
+    if (observationP == NULL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_LWM2M, "No matching observation.");
+        if (messageP->type != IOWA_COAP_TYPE_ACKNOWLEDGEMENT)
+        {
+            coapSendReset(contextP, fromPeer, messageP);
+        }
+        return;
+    }
+
+    memset(&content, 0, sizeof(iowa_response_content_t));
+    status = messageP->code;
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE);
+    isObserved = (status == IOWA_COAP_205_CONTENT && optionP != NULL);
+
+    if (status == IOWA_COAP_205_CONTENT)
+    {
+        if (optionP != NULL)
+        {
+            content.details.observe.notificationNumber = (uint32_t)optionP->value.asInteger;
+        }
+
+        if (messageP->payload.length != 0)
+        {
+            format = utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT);
+            status = dataLwm2mDeserialize(observationP->uriCount == 1 ? observationP->uriP : NULL,
+                                          messageP->payload.data, messageP->payload.length,
+                                          format,
+                                          &(content.details.observe.dataP), &(content.details.observe.dataCount),
+                                          utils_getResourceType, contextP);
+            if (status != IOWA_COAP_NO_ERROR)
+            {
+                IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Failed to deserialize the notification: %u.%02u.", (status & 0xFF) >> 5, (status & 0x1F));
+            }
+            else
+            {
+                status = IOWA_COAP_205_CONTENT;
+            }
+        }
+    }
+
+    // The application may cancel the observation or close the Client in its callback
+    clientId = clientP->internalID;
+    responseCb = observationP->responseCb;
+    userDataP = observationP->userDataP;
+    if (isObserved == false)
+    {
+        observe_remove(observationP);
+    }
+    else
+    {
+        observationP->status = STATE_REG_REGISTERED;
+    }
+
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+    if (contextP->lwm2mContextP->notificationQueue.notificationArray != NULL)
+    {
+        lwm2m_notification_queue_t *queueP;
+
+        // The application reads the queue at its own pace instead of being called from the network loop
+        queueP = &(contextP->lwm2mContextP->notificationQueue);
+        if (prv_queueNotification(queueP, clientId, status, &content, responseCb, userDataP) == true
+            && queueP->signalCallback != NULL)
+        {
+            iowa_notification_signal_callback_t signalCb;
+            void *signalUserData;
+
+            signalCb = queueP->signalCallback;
+            signalUserData = queueP->signalUserData;
+
+            CRIT_SECTION_LEAVE(contextP);
+            signalCb(signalUserData, contextP);
+            CRIT_SECTION_ENTER(contextP);
+        }
+        return;
+    }
+#endif
+
+    if (responseCb != NULL)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        responseCb(clientId, IOWA_DM_NOTIFY, status, &content, userDataP, contextP);
+        CRIT_SECTION_ENTER(contextP);
+    }
+
+    dataLwm2mFree(content.details.observe.dataCount, content.details.observe.dataP);
+}
+
+#endif // LWM2M_SERVER_MODE
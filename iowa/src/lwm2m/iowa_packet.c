@@ -120,6 +120,9 @@ void lwm2m_client_handle_request(iowa_coap_peer_t *fromPeer,
     lwm2m_server_t *serverP;
     iowa_lwm2m_uri_t uri;
     lwm2m_uri_type_t type;
+#ifdef IOWA_TRACE_SUPPORT
+    uint64_t traceTime;
+#endif
 
     (void)code;
 
@@ -146,11 +149,13 @@ void lwm2m_client_handle_request(iowa_coap_peer_t *fromPeer,
         return;
     }
 
+    CORE_TRACE_TIME(contextP, traceTime);
 #ifdef LWM2M_ALTPATH_SUPPORT
     type = uri_decode(contextP->lwm2mContextP->altPath, requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
 #else
     type = uri_decode(requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
 #endif
+    CORE_TRACE_SPAN(contextP, IOWA_TRACE_PHASE_DECODE, traceTime);
 
     switch (type)
     {
@@ -166,3 +171,154 @@ void lwm2m_client_handle_request(iowa_coap_peer_t *fromPeer,
 }
 #endif
 
+
+#ifdef LWM2M_SERVER_MODE
+
+void lwm2m_server_handle_request(iowa_coap_peer_t *fromPeer,
+                                 uint8_t code,
+                                 iowa_coap_message_t *requestP,
+                                 void *userData,
+                                 iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_t *clientP;
+    iowa_coap_option_t *optionP;
+    iowa_lwm2m_uri_t uri;
+    lwm2m_uri_type_t type;
+
+    (void)code;
+
+    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+
+    clientP = (lwm2m_client_t *)userData;
+
+    if (requestP->type == IOWA_COAP_TYPE_RESET)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Received a reset CoAP packet.");
+        return;
+    }
+
+    if (requestP->code == IOWA_COAP_CODE_EMPTY)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Received an empty CoAP packet.");
+        return;
+    }
+
+    if (!COAP_IS_REQUEST(requestP->code))
+    {
+        // Responses without a matching exchange are notifications
+        if (clientP != NULL)
+        {
+            observe_handleNotify(contextP, clientP, fromPeer, requestP);
+        }
+        else
+        {
+            IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Received an unexpected response from an unknown Client.");
+            coapSendReset(contextP, fromPeer, requestP);
+        }
+        return;
+    }
+
+    optionP = iowa_coap_message_find_option(requestP, IOWA_COAP_OPTION_URI_PATH);
+    if (optionP != NULL
+        && optionP->length == URI_SEND_SEGMENT_LEN
+        && 0 == memcmp(optionP->value.asBuffer, URI_SEND_SEGMENT, URI_SEND_SEGMENT_LEN))
+    {
+        send_handleRequest(contextP, clientP, fromPeer, requestP);
+        return;
+    }
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    type = uri_decode(NULL, requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
+#else
+    type = uri_decode(requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
+#endif
+
+    switch (type)
+    {
+    case LWM2M_URI_TYPE_REGISTRATION:
+        registration_handleRequest(contextP, clientP, fromPeer, requestP);
+        break;
+
+    case LWM2M_URI_TYPE_DM:
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_404_NOT_FOUND);
+        break;
+
+    default:
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_400_BAD_REQUEST);
+    }
+}
+#endif
+
+
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+
+void lwm2m_bootstrap_server_handle_request(iowa_coap_peer_t *fromPeer,
+                                           uint8_t code,
+                                           iowa_coap_message_t *requestP,
+                                           void *userData,
+                                           iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_bootstrap_client_t *clientP;
+    iowa_lwm2m_uri_t uri;
+    lwm2m_uri_type_t type;
+
+    (void)code;
+
+    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+
+    clientP = (lwm2m_bootstrap_client_t *)userData;
+
+    if (requestP->type == IOWA_COAP_TYPE_RESET)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Received a reset CoAP packet.");
+        return;
+    }
+
+    if (requestP->code == IOWA_COAP_CODE_EMPTY)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Received an empty CoAP packet.");
+        return;
+    }
+
+    if (!COAP_IS_REQUEST(requestP->code))
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Received an unexpected response.");
+        coapSendReset(contextP, fromPeer, requestP);
+        return;
+    }
+
+#ifdef LWM2M_ALTPATH_SUPPORT
+    type = uri_decode(NULL, requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
+#else
+    type = uri_decode(requestP, IOWA_COAP_OPTION_URI_PATH, &uri);
+#endif
+
+    switch (type)
+    {
+    case LWM2M_URI_TYPE_BOOTSTRAP:
+        // Only the Bootstrap-Pack is supported to provision the Clients
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Bootstrap-Request is not supported.");
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_501_NOT_IMPLEMENTED);
+        break;
+
+#ifdef LWM2M_BOOTSTRAP_PACK_SUPPORT
+    case LWM2M_URI_TYPE_BOOTSTRAP_PACK:
+        bootstrapServerHandlePackRequest(contextP, clientP, fromPeer, requestP);
+        break;
+#endif
+
+    case LWM2M_URI_TYPE_DM:
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_404_NOT_FOUND);
+        break;
+
+    default:
+        coapSendResponse(contextP, fromPeer, requestP, IOWA_COAP_400_BAD_REQUEST);
+    }
+
+#ifndef LWM2M_BOOTSTRAP_PACK_SUPPORT
+    (void)clientP;
+#endif
+}
+#endif
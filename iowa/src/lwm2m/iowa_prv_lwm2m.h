@@ -120,6 +120,14 @@ extern "C" {
 #define IOWA_PEER_IDENTIFIER_SIZE 32 // Default value
 #endif
 
+#ifndef IOWA_NOTIFICATION_STORE_SIZE
+#define IOWA_NOTIFICATION_STORE_SIZE 2048 // Default value
+#endif
+
+#ifndef IOWA_NOTIFICATION_STORE_BATCH_SIZE
+#define IOWA_NOTIFICATION_STORE_BATCH_SIZE 256 // Default value
+#endif
+
 // TLV must be support LwM2M version 1.0 is not removed
 #ifndef LWM2M_SUPPORT_TLV
 #define LWM2M_SUPPORT_TLV
@@ -226,6 +234,8 @@ typedef struct _lwm2m_observation_
     lwm2m_status_t               status;
     iowa_response_callback_t     responseCb;
     void                        *userDataP;
+    uint8_t                      token[COAP_MSG_TOKEN_MAX_LEN];
+    uint8_t                      tokenLength;
 } lwm2m_observation_t;
 
 /*
@@ -257,12 +267,21 @@ typedef struct _attributes_t
 
 /*
  * LWM2M Clients
+ *
+ * On the Server side, a Client is indexed by its internal ID, its Endpoint Name and its registration location.
+ * 'next' chains the Clients of the same internal ID bucket, 'nextByName' and 'nextByLocation' the ones of
+ * the same Endpoint Name and location buckets.
  */
 
+#define LWM2M_CLIENT_LOCATION_LENGTH 8
+
 typedef struct _lwm2m_client_
 {
     struct _lwm2m_client_         *next;       // matches lwm2m_list_t::next
     uint32_t                       internalID; // matches lwm2m_list_t::id
+    struct _lwm2m_client_         *nextByName;
+    struct _lwm2m_client_         *nextByLocation;
+    char                           location[LWM2M_CLIENT_LOCATION_LENGTH + 1];
     char                          *name;
     iowa_lwm2m_binding_t           binding;
     char                          *msisdn;
@@ -282,6 +301,68 @@ typedef struct _lwm2m_client_
     uint8_t                        flags;
 } lwm2m_client_t;
 
+/*
+ * LWM2M Client registry
+ *
+ * Hash tables of Clients sharing the same bucket count, a power of two.
+ */
+
+typedef struct
+{
+    lwm2m_client_t **idTable;
+    lwm2m_client_t **nameTable;
+    lwm2m_client_t **locationTable;
+    size_t           bucketCount;
+    size_t           clientCount;
+} lwm2m_client_registry_t;
+
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+/*
+ * Ring buffer of the notifications received by the Server
+ */
+
+typedef struct
+{
+    iowa_notification_t                 *notificationArray;   // nil when the queue is disabled
+    size_t                               capacity;
+    size_t                               first;               // index of the oldest notification
+    size_t                               count;
+    iowa_notification_queue_policy_t     policy;
+    iowa_notification_signal_callback_t  signalCallback;
+    void                                *signalUserData;
+    iowa_notification_queue_stats_t      stats;
+} lwm2m_notification_queue_t;
+#endif
+
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+/*
+ * Clients of the Bootstrap Server
+ *
+ * A Client is kept from its Bootstrap-Pack-Request until the Bootstrap-Pack is acknowledged or fails.
+ */
+
+typedef enum
+{
+    BS_CLIENT_STATE_PACK_REQUESTED,
+    BS_CLIENT_STATE_PACK_SENT,
+    BS_CLIENT_STATE_FINISHED,
+    BS_CLIENT_STATE_FAILED
+} lwm2m_bootstrap_client_state_t;
+
+typedef struct _lwm2m_bootstrap_client_t
+{
+    struct _lwm2m_bootstrap_client_t *next;         // matches lwm2m_list_t::next
+    uint32_t                          internalID;   // matches lwm2m_list_t::id
+    char                             *name;
+    iowa_coap_peer_t                 *peerP;
+    iowa_timer_t                     *timerP;
+    lwm2m_bootstrap_client_state_t    state;
+    bool                              isConfirmable;  // the Bootstrap-Pack waits for an acknowledgement
+    uint8_t                           tokenLength;
+    uint8_t                           token[COAP_MSG_TOKEN_MAX_LEN];  // token of the Bootstrap-Pack-Request
+} lwm2m_bootstrap_client_t;
+#endif
+
 /*
  * LWM2M data array
  */
@@ -390,9 +471,24 @@ typedef struct
 #define LWM2M_SERVER_FLAG_INITIAL_TIMER_WAIT               0x0100U
 #define LWM2M_SERVER_FLAG_LORAWAN_FALLBACK                 0x0200U
 #define LWM2M_SERVER_FLAG_OBSERVE_SENDING                  0x0400U
+#define LWM2M_SERVER_FLAG_NOTIFICATION_STORING             0x0800U
 
 #define PRV_SERVER_COAP_SETTING_UNSET 0xFF
 
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+/*
+ * Notifications kept while a Server is unreachable
+ */
+
+typedef struct
+{
+    uint8_t  *bufferP;       // compact records, the oldest first. Nil when the store is empty
+    size_t    length;
+    size_t    pendingLength; // length of the first records carried by the ongoing Send
+    uint32_t  droppedCount;  // records dropped because the store was full
+} lwm2m_notification_store_t;
+#endif
+
 typedef struct
 {
     uint16_t                 flags;
@@ -404,6 +500,10 @@ typedef struct
     attributes_t            *attributesList;
     iowa_timer_t            *updateTimerP;
     iowa_timer_t            *lifetimeTimerP;
+    uint32_t                 regPayloadVersion; // version of the Object list last acknowledged by the Server
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    lwm2m_notification_store_t notificationStore;
+#endif
 } lwm2m_server_runtime_t;
 
 typedef struct _lwm2m_server_
@@ -412,6 +512,9 @@ typedef struct _lwm2m_server_
     uint16_t                      shortId;      // matches lwm2m_list_t::id
     uint16_t                      secObjInstId;
     uint16_t                      srvObjInstId;
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+    uint16_t                      oscObjInstId;
+#endif
     char                         *uri;
     iowa_lwm2m_protocol_version_t lwm2mVersion;
     int32_t                       lifetime;     // lifetime of the registration in sec or 0 if default value (86400 sec), also used as hold off time for bootstrap servers
@@ -521,7 +624,30 @@ struct _lwm2m_context_t
     lwm2m_server_t       *serverList;
     lwm2m_object_t       *objectList;
     uint8_t               internalFlag;
+    uint8_t              *regPayload;           // cached CoRE Link Format Object list sent in registrations
+    size_t                regPayloadLength;
+    uint32_t              regPayloadVersion;    // incremented each time the Object list changes
 #endif // LWM2M_CLIENT_MODE
+#ifdef LWM2M_SERVER_MODE
+    lwm2m_client_registry_t        clientRegistry;
+    uint32_t                       nextClientID;
+    iowa_monitor_callback_t        monitorCallback;
+    iowa_resource_type_callback_t  resTypeCallback;
+    void                          *monitorUserData;
+    iowa_verify_client_callback_t  verifyClientCallback;
+    void                          *verifyClientUserData;
+    iowa_response_callback_t       dataPushCallback;
+    void                          *dataPushUserData;
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+    lwm2m_notification_queue_t     notificationQueue;
+#endif
+#endif // LWM2M_SERVER_MODE
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+    lwm2m_bootstrap_client_t      *bootstrapClientList;
+    uint32_t                       nextBootstrapClientID;
+    iowa_monitor_callback_t        bootstrapMonitorCallback;
+    void                          *bootstrapMonitorUserData;
+#endif
     void                 *userData;
 };
 
@@ -571,6 +697,10 @@ iowa_status_t lwm2m_configure(iowa_context_t contextP, const char * endpointName
 // - serverP : pointer of the server.
 // - update : an unsigned integer as the update flag.
 void lwm2mUpdateRegistration(iowa_context_t contextP, lwm2m_server_t *serverP, uint8_t update);
+// Invalidate the cached registration payload after an Object or an Object Instance was added or removed.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void lwm2mObjectTreeChanged(iowa_context_t contextP);
 // Update the observe flag of the matched uris.
 // Parameters:
 // - contextP: as returned by iowa_init().
@@ -599,7 +729,8 @@ void lwm2m_bootstrap_server_close(iowa_context_t contextP, lwm2m_server_t *serve
 // Parameters:
 // - contextP: as returned by iowa_init().
 // - contextP: a pointer to a server.
-// - contextP: boolean to enable sending deregistration message.
+// - contextP: boolean to enable sending deregistration message. With LWM2M_NOTIFICATION_STORE_SUPPORT, the observations
+//             and the notification store are only removed when true.
 void lwm2m_server_close(iowa_context_t contextP, lwm2m_server_t *serverP, bool sendDeregistration);
 
 // Add an instance
@@ -812,6 +943,14 @@ void lwm2m_clockReset(iowa_context_t contextP);
 // Note: only if LWM2M_BOOTSTRAP_SERVER_MODE or LWM2M_SERVER_MODE is defined
 void utils_freeClient(iowa_context_t contextP, lwm2m_client_t *clientP);
 
+// Get the data type of a resource, from the application callback or from the well-known Objects.
+// Returned value: the type of the resource or IOWA_LWM2M_TYPE_UNDEFINED.
+// Parameters:
+// - objectID, resourceID: the resource.
+// - userData: the IOWA context.
+// Note: only if LWM2M_SERVER_MODE is defined. It matches data_resource_type_callback_t.
+iowa_lwm2m_data_type_t utils_getResourceType(uint16_t objectID, uint16_t resourceID, void *userData);
+
 // Get binding from string.
 // Returned value: strBindingLen is succeed or 0 if any error.
 // Parameters:
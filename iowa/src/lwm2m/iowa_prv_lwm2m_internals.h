@@ -229,11 +229,13 @@ typedef enum
     LWM2M_URI_TYPE_UNKNOWN,
     LWM2M_URI_TYPE_DM,
     LWM2M_URI_TYPE_REGISTRATION,
-    LWM2M_URI_TYPE_BOOTSTRAP
+    LWM2M_URI_TYPE_BOOTSTRAP,
+    LWM2M_URI_TYPE_BOOTSTRAP_PACK
 } lwm2m_uri_type_t;
 
 #define CONTEXT_FLAG_INSIDE_CALLBACK (uint8_t)0x01
 #define CONTEXT_FLAG_NOTIFY_REQUIRED (uint8_t)0x02
+#define CONTEXT_FLAG_OBJECT_TREE_CHANGED (uint8_t)0x04 // the Object list sent in registrations must be rebuilt
 
 #define LWM2M_OBSERVE_FLAG_UPDATE     (uint8_t)0x01 // indicates if observe's value has been updated, used in lwm2m_observed_t and lwm2m_observed_uri_info_t
 #define LWM2M_OBSERVE_FLAG_INTEGER    (uint8_t)0x02 // indicates if observe's value is an integer, used in lwm2m_observed_uri_info_t
@@ -277,6 +279,9 @@ typedef struct
     uint8_t                tokenLen;
     size_t                 bufferLength;
     uint8_t               *buffer;
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+    int32_t                time;        // when the notification was built
+#endif
 } lwm2m_value_t;
 
 // defined in acl.c
@@ -353,6 +358,95 @@ void lwm2m_client_handle_request(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_
 void lwm2m_server_handle_request(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *requestP, void *userData, iowa_context_t contextP);
 void lwm2m_bootstrap_server_handle_request(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *requestP, void *userData, iowa_context_t contextP);
 
+#ifdef LWM2M_SERVER_MODE
+// defined in iowa_registry.c
+
+// Add a Client to the registry.
+// Returned value: IOWA_COAP_NO_ERROR or an error.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - clientP: the Client to add. Its internal ID, name and location must be set and must not change while it is in the registry.
+iowa_status_t registryAdd(iowa_context_t contextP, lwm2m_client_t *clientP);
+
+// Remove a Client from the registry. The Client is not freed.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - clientP: the Client to remove.
+void registryRemove(iowa_context_t contextP, lwm2m_client_t *clientP);
+
+// Find a registered Client by its internal ID.
+// Returned value: the Client or NULL if not found.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - id: the internal ID of the Client.
+lwm2m_client_t * registryFindById(iowa_context_t contextP, uint32_t id);
+
+// Find a registered Client by its Endpoint Name.
+// Returned value: the Client or NULL if not found.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - name: the nil-terminated Endpoint Name.
+lwm2m_client_t * registryFindByName(iowa_context_t contextP, const char *name);
+
+// Find a registered Client by its registration location.
+// Returned value: the Client or NULL if not found.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - location, length: the location as found in the Uri-Path option.
+lwm2m_client_t * registryFindByLocation(iowa_context_t contextP, const uint8_t *location, size_t length);
+
+// Allocate an unused internal ID. In a shard group, the ID is one of the shard.
+// Returned value: IOWA_COAP_NO_ERROR or IOWA_COAP_503_SERVICE_UNAVAILABLE if all the IDs are used.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - idP: OUT. the internal ID.
+iowa_status_t registryNewClientId(iowa_context_t contextP, uint32_t *idP);
+
+// Generate an unused registration location for a Client.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - clientP: the Client whose location is set.
+// Note: This function leaves the critical section to call iowa_system_random_vector_generator().
+void registryNewLocation(iowa_context_t contextP, lwm2m_client_t *clientP);
+
+// Free all the registered Clients and the registry tables.
+// Parameters:
+// - contextP: returned by iowa_init().
+void registryClose(iowa_context_t contextP);
+#endif // LWM2M_SERVER_MODE
+
+#ifdef LWM2M_BOOTSTRAP_SERVER_MODE
+// defined in iowa_bootstrap.c
+
+#ifdef LWM2M_BOOTSTRAP_PACK_SUPPORT
+// Handle a Bootstrap-Pack-Request. The Bootstrap-Pack is sent later by bootstrapServerSendPack().
+// Parameters:
+// - contextP: returned by iowa_init().
+// - boundClientP: the Client bound to the peer. This can be nil.
+// - fromPeer: the peer the request comes from.
+// - requestP: the Bootstrap-Pack-Request.
+void bootstrapServerHandlePackRequest(iowa_context_t contextP, lwm2m_bootstrap_client_t *boundClientP, iowa_coap_peer_t *fromPeer, iowa_coap_message_t *requestP);
+
+// Send a Bootstrap-Pack in response to the Bootstrap-Pack-Request of a Client.
+// Returned value: IOWA_COAP_NO_ERROR or an error.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - clientId: the internal ID of the Client.
+// - payload, payloadLength: the Bootstrap-Pack encoded in SenML CBOR.
+iowa_status_t bootstrapServerSendPack(iowa_context_t contextP, uint32_t clientId, uint8_t *payload, size_t payloadLength);
+#endif
+
+// Free the Clients of the Bootstrap Server whose bootstrap ended and close their connections.
+// Parameters:
+// - contextP: returned by iowa_init().
+void bootstrapServerStep(iowa_context_t contextP);
+
+// Free all the Clients of the Bootstrap Server and close their connections.
+// Parameters:
+// - contextP: returned by iowa_init().
+void bootstrapServerClose(iowa_context_t contextP);
+#endif // LWM2M_BOOTSTRAP_SERVER_MODE
+
 // defined in iowa_uri.c
 
 // Get URI from CoAP message
@@ -561,6 +655,20 @@ void observe_remove(lwm2m_observation_t * observationP);
 void observe_step(iowa_context_t contextP);
 void observe_clear(iowa_context_t contextP, iowa_lwm2m_uri_t * uriP);
 void observe_handleNotify(iowa_context_t contextP, lwm2m_client_t *clientP, iowa_coap_peer_t *fromPeer, iowa_coap_message_t * messageP);
+#ifdef LWM2M_SERVER_NOTIFICATION_QUEUE_SUPPORT
+// Discard the notifications of the queue and release it.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+void observe_clearNotificationQueue(iowa_context_t contextP);
+
+// Move the oldest notifications of the queue to an array.
+// Returned value: the number of notifications moved.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - notificationArray, arraySize: the destination array.
+size_t observe_takeNotifications(iowa_context_t contextP, iowa_notification_t *notificationArray, size_t arraySize);
+#endif
 iowa_status_t observe_updateObserve(iowa_context_t contextP, lwm2m_server_t *serverP, lwm2m_observed_t *observedP);
 
 // defined in registration.c
@@ -570,6 +678,17 @@ void registration_resetServersStatus(iowa_context_t contextP);
 iowa_status_t registration_step(iowa_context_t contextP);
 void registration_removeObservation(iowa_context_t contextP, lwm2m_client_t *clientP);
 
+// defined in send.c
+
+// Handle a Data Push request received from a Client.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - clientP: the registered Client bound to the peer. This can be nil.
+// - fromPeer: the peer which sent the request.
+// - messageP: the received request.
+void send_handleRequest(iowa_context_t contextP, lwm2m_client_t *clientP, iowa_coap_peer_t *fromPeer, iowa_coap_message_t *messageP);
+
 // defined in bootstrap.c
 iowa_status_t bootstrap_step(iowa_context_t contextP);
 void bootstrap_handle_command(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP, lwm2m_server_t *serverP, iowa_coap_message_t *messageP);
@@ -621,6 +740,45 @@ void valueRemoveFromStorageQueue(iowa_context_t contextP, lwm2m_server_t *server
 // - valueP: the value to free.
 void valueFree(lwm2m_value_t *valueP);
 
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+// Encode a notification in a record of the notification store.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - observedP: the observation the notification belongs to.
+// - dataP, dataCount: the notified data.
+// - valueP: IN/OUT. the value receiving the record in its buffer. Its time is used for the data without timestamp.
+iowa_status_t valueEncodeNotification(lwm2m_observed_t *observedP, iowa_lwm2m_data_t *dataP, size_t dataCount, lwm2m_value_t *valueP);
+
+// Replace the payload of a notification by a record of the notification store.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - observedP: the observation the notification belongs to.
+// - valueP: IN/OUT. the value holding the payload in its buffer, encoded in its format.
+iowa_status_t valueEncodeNotificationPayload(iowa_context_t contextP, lwm2m_observed_t *observedP, lwm2m_value_t *valueP);
+
+// Add a record to the notification store of a Server. The oldest records are dropped when the store is full.
+// Returned value: none.
+// Parameters:
+// - serverP: the Server the notification is for.
+// - valueP: the value holding the record in its buffer.
+// - latestOnly: if true, the stored record of the same observation is replaced.
+void valueStoreNotification(lwm2m_server_t *serverP, lwm2m_value_t *valueP, bool latestOnly);
+
+// Replay the notification store of a Server in Send operations and resume the sending of the notifications.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - serverP: the Server to replay the notifications to.
+void valueReplayNotificationStore(iowa_context_t contextP, lwm2m_server_t *serverP);
+
+// Delete the notification store of a Server.
+// Returned value: none.
+// Parameters:
+// - serverP: the Server which the notification store has to be deleted.
+void valueDeleteNotificationStore(lwm2m_server_t *serverP);
+#endif
+
 // Get content format from CoAP message.
 // Returned value: content format found or IOWA_CONTENT_FORMAT_UNSET
 // Parameters:
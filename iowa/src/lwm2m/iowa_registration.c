@@ -93,12 +93,22 @@
 
 #define PRV_DEFAULT_MAX_REGISTRATION_DELAY 93
 
+#ifdef LWM2M_CLIENT_MODE
+// Registration update in flight
+typedef struct
+{
+    uint8_t  updateFlags;           // The registration update flags sent
+    uint32_t regPayloadVersion;     // The version of the registration payload sent
+} prv_update_info_t;
+#endif // LWM2M_CLIENT_MODE
+
 /*************************************************************************************
 ** Private functions
 *************************************************************************************/
 
 #ifdef LWM2M_CLIENT_MODE
 static iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP, lwm2m_server_t *serverP, size_t *lengthP, char **bufferP);
+static iowa_status_t prv_buildRegistrationPayload(iowa_context_t contextP, uint8_t **payloadP, size_t *payloadLengthP);
 static iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP, uint8_t **payloadP, size_t *payloadLengthP);
 static int32_t prv_getUpdateDelay(lwm2m_server_t *serverP);
 static void prv_serverRegistrationFailing(iowa_context_t contextP, lwm2m_server_t *serverP, bool isInternal, uint8_t code);
@@ -255,9 +265,9 @@ exit_on_error:
     return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
 }
 
-iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
-                                         uint8_t **payloadP,
-                                         size_t *payloadLengthP)
+iowa_status_t prv_buildRegistrationPayload(iowa_context_t contextP,
+                                           uint8_t **payloadP,
+                                           size_t *payloadLengthP)
 {
     iowa_status_t result;
     link_t *linkP;
@@ -299,6 +309,9 @@ iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
             break;
 
         case IOWA_LWM2M_SECURITY_OBJECT_ID:
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+        case IOWA_LWM2M_OSCORE_OBJECT_ID:
+#endif
             nbLink--;
             memmove(linkP + linkIndex, linkP + linkIndex + 1, (nbLink - linkIndex) * sizeof(link_t));
             break;
@@ -317,6 +330,55 @@ iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
     return result;
 }
 
+// The returned payload is owned by the LwM2M context and must not be freed.
+iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
+                                         uint8_t **payloadP,
+                                         size_t *payloadLengthP)
+{
+    lwm2m_context_t *lwm2mContextP;
+    iowa_status_t result;
+    uint8_t *newPayload;
+    size_t newPayloadLength;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    if (lwm2mContextP->regPayload == NULL
+        || (lwm2mContextP->internalFlag & CONTEXT_FLAG_OBJECT_TREE_CHANGED) != 0)
+    {
+        newPayload = NULL;
+        newPayloadLength = 0;
+
+        result = prv_buildRegistrationPayload(contextP, &newPayload, &newPayloadLength);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+        lwm2mContextP->internalFlag &= (uint8_t)(~CONTEXT_FLAG_OBJECT_TREE_CHANGED);
+
+        // An instance created then deleted leaves the Object tree unchanged: keep the current version
+        if (lwm2mContextP->regPayload != NULL
+            && newPayloadLength == lwm2mContextP->regPayloadLength
+            && memcmp(newPayload, lwm2mContextP->regPayload, newPayloadLength) == 0)
+        {
+            iowa_system_free(newPayload);
+        }
+        else
+        {
+            IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Registration payload changed.");
+
+            iowa_system_free(lwm2mContextP->regPayload);
+            lwm2mContextP->regPayload = newPayload;
+            lwm2mContextP->regPayloadLength = newPayloadLength;
+            lwm2mContextP->regPayloadVersion++;
+        }
+    }
+
+    *payloadP = lwm2mContextP->regPayload;
+    *payloadLengthP = lwm2mContextP->regPayloadLength;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
 int32_t prv_getUpdateDelay(lwm2m_server_t *serverP)
 {
     int32_t coapMaxTransmitWait;
@@ -352,12 +414,17 @@ void prv_serverRegistrationFailing(iowa_context_t contextP,
 {
     // WARNING: This function is called in a critical section
     IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Registration or Registration Update to Server %d failed.", serverP->shortId);
+    CORE_METRICS_INCREMENT(contextP, registrationFailureCount);
 
     lwm2m_server_close(contextP, serverP, false);
     {
         serverP->runtime.status = STATE_REG_FAILED;
     }
 
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    coreContextJournalRuntime(contextP, serverP);
+#endif
+
     contextP->timeout = 0;
 
     // After the server event callback, don't try to access 'serverP' pointer since the application callback could have removed it
@@ -372,18 +439,18 @@ void prv_handleRegistrationUpdateReply(iowa_coap_peer_t *fromPeerP,
 {
     // WARNING: This function is called in a critical section
     lwm2m_server_t *serverP;
-    uint8_t *updateFlagsP;
+    prv_update_info_t *updateInfoP;
 
 
     (void)status;
 
-    updateFlagsP = (uint8_t *)userDataP; // The user data contains the registration flags to remove
+    updateInfoP = (prv_update_info_t *)userDataP; // The user data contains the registration flags to remove
 
     // Find the Server from the CoAP peer
     serverP = (lwm2m_server_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->serverList, utilsListFindCallbackServerByPeer, fromPeerP);
     if (serverP == NULL)
     {
-        iowa_system_free(updateFlagsP);
+        iowa_system_free(updateInfoP);
         return;
     }
 
@@ -448,8 +515,18 @@ void prv_handleRegistrationUpdateReply(iowa_coap_peer_t *fromPeerP,
                     }
                 }
 
+                if (updateInfoP != NULL
+                    && (updateInfoP->updateFlags & LWM2M_UPDATE_FLAG_OBJECTS) != 0)
+                {
+                    serverP->runtime.regPayloadVersion = updateInfoP->regPayloadVersion;
+                }
+
                 serverP->runtime.status = STATE_REG_REGISTERED;
 
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+                valueReplayNotificationStore(contextP, serverP);
+#endif
+
                 // After the server event callback, don't try to access 'serverP' pointer since the application callback could have removed it
                 coreServerEventCallback(contextP, serverP, IOWA_EVENT_REG_REGISTERED, false, IOWA_COAP_NO_ERROR);
 
@@ -465,10 +542,10 @@ void prv_handleRegistrationUpdateReply(iowa_coap_peer_t *fromPeerP,
         {
             IOWA_LOG_INFO(IOWA_PART_LWM2M, "No response received to the Registration update.");
 
-            if (updateFlagsP != NULL)
+            if (updateInfoP != NULL)
             {
                 // Set back the registration update flags since the Server didn't receive the update
-                serverP->runtime.update |= *updateFlagsP;
+                serverP->runtime.update |= updateInfoP->updateFlags;
             }
             serverP->runtime.status = STATE_REG_REGISTERED; // Fallback to registered state since the registration update mechanism is finished.
 
@@ -483,7 +560,7 @@ void prv_handleRegistrationUpdateReply(iowa_coap_peer_t *fromPeerP,
     }
 
 exit:
-    iowa_system_free(updateFlagsP);
+    iowa_system_free(updateInfoP);
 }
 
 void prv_updateRegistration(iowa_context_t contextP,
@@ -492,16 +569,36 @@ void prv_updateRegistration(iowa_context_t contextP,
     // WARNING: This function is called in a critical section
     iowa_coap_message_t *messageP;
     iowa_coap_option_t *optionP;
-    uint8_t *payload;
     char *bufferP;
     size_t length;
     iowa_status_t result;
     uint8_t token[COAP_MSG_TOKEN_MAX_LEN];
     uint8_t tokenLength;
-    uint8_t *updateFlagsP;
+    prv_update_info_t *updateInfoP;
+    uint8_t *payload;
+    size_t payloadLength;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Server ID: %u, with update: 0x%02X.", serverP->shortId, serverP->runtime.update);
 
+    payload = NULL;
+    payloadLength = 0;
+
+    if (serverP->runtime.update & LWM2M_UPDATE_FLAG_OBJECTS)
+    {
+        result = prv_getRegistrationPayload(contextP, &payload, &payloadLength);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to get the registration payload.");
+            return;
+        }
+
+        if (serverP->runtime.regPayloadVersion == contextP->lwm2mContextP->regPayloadVersion)
+        {
+            IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Object list unchanged since the last registration update.");
+            serverP->runtime.update &= (uint8_t)(~LWM2M_UPDATE_FLAG_OBJECTS);
+        }
+    }
+
     result = coapPeerGenerateToken(serverP->runtime.peerP, &tokenLength, token);
     if (result != IOWA_COAP_NO_ERROR)
     {
@@ -626,28 +723,16 @@ void prv_updateRegistration(iowa_context_t contextP,
         iowa_coap_message_add_option(messageP, optionP);
     }
 
-    payload = NULL;
-
     if (serverP->runtime.update & LWM2M_UPDATE_FLAG_OBJECTS)
     {
-        size_t payloadLength;
-
-        IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Updating Object list.", serverP->lifetime);
-
-        result = prv_getRegistrationPayload(contextP, &payload, &payloadLength);
-        if (result != IOWA_COAP_NO_ERROR)
-        {
-            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to get the registration payload.");
-            iowa_coap_message_free(messageP);
-            return;
-        }
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Updating Object list.");
 
         optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (optionP == NULL)
         {
             IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
-            iowa_system_free(payload);
+            iowa_system_free(bufferP);
             iowa_coap_message_free(messageP);
             return;
         }
@@ -661,24 +746,25 @@ void prv_updateRegistration(iowa_context_t contextP,
     // Keep the value of the registration update flags
     if (serverP->runtime.update != LWM2M_UPDATE_FLAG_NONE)
     {
-        updateFlagsP = (uint8_t *)iowa_system_malloc(sizeof(uint8_t));
+        updateInfoP = (prv_update_info_t *)iowa_system_malloc(sizeof(prv_update_info_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-        if (updateFlagsP == NULL)
+        if (updateInfoP == NULL)
         {
-            IOWA_LOG_ERROR_MALLOC(sizeof(uint8_t));
-            iowa_system_free(payload);
+            IOWA_LOG_ERROR_MALLOC(sizeof(prv_update_info_t));
+            iowa_system_free(bufferP);
             iowa_coap_message_free(messageP);
             return;
         }
 #endif
-        *updateFlagsP = serverP->runtime.update;
+        updateInfoP->updateFlags = serverP->runtime.update;
+        updateInfoP->regPayloadVersion = contextP->lwm2mContextP->regPayloadVersion;
     }
     else
     {
-        updateFlagsP = NULL;
+        updateInfoP = NULL;
     }
 
-    result = coapSend(contextP, serverP->runtime.peerP, messageP, prv_handleRegistrationUpdateReply, updateFlagsP);
+    result = coapSend(contextP, serverP->runtime.peerP, messageP, prv_handleRegistrationUpdateReply, updateInfoP);
     if (result == IOWA_COAP_NO_ERROR)
     {
         serverP->runtime.status = STATE_REG_UPDATE_PENDING;
@@ -689,13 +775,12 @@ void prv_updateRegistration(iowa_context_t contextP,
     }
     else
     {
-        iowa_system_free(updateFlagsP);
+        iowa_system_free(updateInfoP);
 
         // After the server event callback, don't try to access 'serverP' pointer since the application callback could have removed it
         coreServerEventCallback(contextP, serverP, IOWA_EVENT_REG_UPDATE_FAILED, true, result);
     }
 
-    iowa_system_free(payload);
     iowa_system_free(bufferP);
     iowa_coap_message_free(messageP);
 
@@ -779,11 +864,13 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
     // WARNING: This function is called in a critical section
     lwm2m_server_t *serverP;
 
+    (void)userDataP;
+
     serverP = (lwm2m_server_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->serverList, prv_getServerByPeer, fromPeer);
     if (serverP == NULL)
     {
         IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Server has not been found.");
-        goto exit;
+        return;
     }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Entering with Server state: %s.", LWM2M_SERVER_STR_STATUS(serverP->runtime.status));
@@ -814,7 +901,7 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
                 {
                     IOWA_LOG_WARNING(IOWA_PART_LWM2M, "No Location-Path option found.");
                     prv_serverRegistrationFailing(contextP, serverP, true, IOWA_COAP_406_NOT_ACCEPTABLE);
-                    goto exit;
+                    return;
                 }
 
                 serverP->runtime.lifetimeTimerP = coreTimerNew(contextP, serverP->lifetime, prv_handleClientLifetimeTimer, serverP);
@@ -822,7 +909,7 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
                 {
                     IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create the timer.");
                     prv_serverRegistrationFailing(contextP, serverP, true, IOWA_COAP_500_INTERNAL_SERVER_ERROR);
-                    goto exit;
+                    return;
                 }
 
                 serverP->runtime.updateTimerP = coreTimerNew(contextP, prv_getUpdateDelay(serverP), prv_handleClientUpdateTimer, serverP);
@@ -830,7 +917,7 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
                 {
                     IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create the timer.");
                     prv_serverRegistrationFailing(contextP, serverP, true, IOWA_COAP_500_INTERNAL_SERVER_ERROR);
-                    goto exit;
+                    return;
                 }
 
                 startP = optionP;
@@ -849,7 +936,7 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
                 {
                     IOWA_LOG_ERROR_MALLOC(length + 1);
                     prv_serverRegistrationFailing(contextP, serverP, true, IOWA_COAP_500_INTERNAL_SERVER_ERROR);
-                    goto exit;
+                    return;
                 }
 #endif
 
@@ -869,6 +956,15 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
                 serverP->runtime.status = STATE_REG_REGISTERED;
 
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Registration successful at \"%s\".", serverP->runtime.location);
+                CORE_METRICS_INCREMENT(contextP, registrationCount);
+
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+                coreContextJournalRuntime(contextP, serverP);
+#endif
+
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+                valueReplayNotificationStore(contextP, serverP);
+#endif
 
                 // After the server event callback, don't try to access 'serverP' pointer since the application callback could have removed it
                 coreServerEventCallback(contextP, serverP, IOWA_EVENT_REG_REGISTERED, false, IOWA_COAP_NO_ERROR);
@@ -890,8 +986,6 @@ void prv_handleRegistrationReply(iowa_coap_peer_t *fromPeer,
         // Do nothing
         break;
     }
-exit:
-    iowa_system_free(userDataP);
 }
 
 // send the registration for a single server
@@ -1039,7 +1133,12 @@ iowa_status_t prv_register(iowa_context_t contextP,
         goto premature_exit;
     }
 
-    result = coapSend(contextP, serverP->runtime.peerP, messageP, prv_handleRegistrationReply, (void *)payload);
+    result = coapSend(contextP, serverP->runtime.peerP, messageP, prv_handleRegistrationReply, NULL);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        // A new registration carries the full Object list
+        serverP->runtime.regPayloadVersion = contextP->lwm2mContextP->regPayloadVersion;
+    }
 
 premature_exit:
     iowa_coap_message_free(messageP);
@@ -1049,7 +1148,6 @@ premature_exit:
 
     if (result != IOWA_COAP_NO_ERROR)
     {
-        iowa_system_free(payload);
         coapPeerDelete(contextP, serverP->runtime.peerP);
         serverP->runtime.peerP = NULL;
     }
@@ -1211,6 +1309,12 @@ void lwm2mUpdateRegistration(iowa_context_t contextP,
     }
 }
 
+void lwm2mObjectTreeChanged(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    contextP->lwm2mContextP->internalFlag |= CONTEXT_FLAG_OBJECT_TREE_CHANGED;
+}
+
 void registration_deregister(iowa_context_t contextP,
                              lwm2m_server_t *serverP)
 {
@@ -1346,6 +1450,9 @@ iowa_status_t registration_step(iowa_context_t contextP)
                 serverResult = IOWA_COAP_NO_ERROR;
 
                 lwm2m_server_close(contextP, serverP, true);
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+                coreContextJournalRuntime(contextP, serverP);
+#endif
 
                 if (serverP->disableTimeout >= 0)
                 {
@@ -1391,3 +1498,838 @@ iowa_status_t registration_step(iowa_context_t contextP)
 }
 #endif // LWM2M_CLIENT_MODE
 
+
+#ifdef LWM2M_SERVER_MODE
+
+/*************************************************************************************
+** Server side
+*************************************************************************************/
+
+#define PRV_LINK_START         '<'
+#define PRV_LINK_END           '>'
+#define PRV_LINK_SEPARATOR     ','
+#define PRV_ATTR_SEPARATOR     ';'
+#define PRV_ATTR_VALUE_START   '='
+#define PRV_QUOTE              '"'
+#define PRV_FORMAT_SEPARATOR   ' '
+#define PRV_ATTR_RESOURCE_TYPE "rt"
+#define PRV_ATTR_CONTENT_TYPE  "ct"
+#define PRV_ATTR_VERSION       "ver"
+
+// Parameters of a Register or Update request
+typedef struct
+{
+    char                          *name;
+    char                          *msisdn;
+    uint32_t                       lifetime;   // 0 if not present
+    iowa_lwm2m_binding_t           binding;    // 0 if not present
+    iowa_lwm2m_protocol_version_t  lwm2mVersion;
+} prv_registration_query_t;
+
+static void prv_handleRegistrationLifetimeTimer(iowa_context_t contextP, void *userData);
+
+static void prv_callMonitorCallback(iowa_context_t contextP,
+                                    lwm2m_client_t *clientP,
+                                    iowa_state_t state)
+{
+    // WARNING: This function is called in a critical section
+    iowa_client_t userClient;
+
+    if (contextP->lwm2mContextP->monitorCallback == NULL)
+    {
+        return;
+    }
+
+    convertLwm2mClientToUserClient(contextP, clientP, &userClient, false);
+
+    CRIT_SECTION_LEAVE(contextP);
+    contextP->lwm2mContextP->monitorCallback(&userClient, state, contextP->lwm2mContextP->monitorUserData, contextP);
+    CRIT_SECTION_ENTER(contextP);
+}
+
+static iowa_status_t prv_callVerifyClientCallback(iowa_context_t contextP,
+                                                  lwm2m_client_t *clientP,
+                                                  iowa_state_t state)
+{
+    // WARNING: This function is called in a critical section
+    iowa_client_t userClient;
+    iowa_status_t result;
+
+    if (contextP->lwm2mContextP->verifyClientCallback == NULL)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    convertLwm2mClientToUserClient(contextP, clientP, &userClient, false);
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = contextP->lwm2mContextP->verifyClientCallback(&userClient, state, contextP->lwm2mContextP->verifyClientUserData, contextP);
+    CRIT_SECTION_ENTER(contextP);
+
+    return result;
+}
+
+static iowa_status_t prv_parseRegistrationQuery(iowa_coap_message_t *messageP,
+                                                prv_registration_query_t *queryP)
+{
+    iowa_coap_option_t *optionP;
+    int64_t value;
+
+    memset(queryP, 0, sizeof(prv_registration_query_t));
+
+    for (optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_URI_QUERY);
+         optionP != NULL && optionP->number == IOWA_COAP_OPTION_URI_QUERY;
+         optionP = optionP->next)
+    {
+        if (optionP->length > QUERY_NAME_LEN
+            && 0 == memcmp(optionP->value.asBuffer, QUERY_NAME, QUERY_NAME_LEN))
+        {
+            iowa_system_free(queryP->name);
+            queryP->name = utilsBufferToString(optionP->value.asBuffer + QUERY_NAME_LEN, optionP->length - QUERY_NAME_LEN);
+            if (queryP->name == NULL)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+        else if (optionP->length > QUERY_SMS_LEN
+                 && 0 == memcmp(optionP->value.asBuffer, QUERY_SMS, QUERY_SMS_LEN))
+        {
+            iowa_system_free(queryP->msisdn);
+            queryP->msisdn = utilsBufferToString(optionP->value.asBuffer + QUERY_SMS_LEN, optionP->length - QUERY_SMS_LEN);
+            if (queryP->msisdn == NULL)
+            {
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+        }
+        else if (optionP->length > QUERY_LIFETIME_LEN
+                 && 0 == memcmp(optionP->value.asBuffer, QUERY_LIFETIME, QUERY_LIFETIME_LEN))
+        {
+            if (0 == dataUtilsBufferToInt(optionP->value.asBuffer + QUERY_LIFETIME_LEN, optionP->length - QUERY_LIFETIME_LEN, &value)
+                || value <= 0)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Invalid lifetime.");
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            // Timers are limited to INT32_MAX seconds
+            queryP->lifetime = (value > INT32_MAX) ? INT32_MAX : (uint32_t)value;
+        }
+        else if (optionP->length == QUERY_VERSION_LEN + LWM2M_VERSION_LEN
+                 && 0 == memcmp(optionP->value.asBuffer, QUERY_VERSION, QUERY_VERSION_LEN))
+        {
+            if (0 == memcmp(optionP->value.asBuffer + QUERY_VERSION_LEN, LWM2M_VERSION_1_0, LWM2M_VERSION_LEN))
+            {
+                queryP->lwm2mVersion = IOWA_LWM2M_VERSION_1_0;
+            }
+            else if (0 == memcmp(optionP->value.asBuffer + QUERY_VERSION_LEN, LWM2M_VERSION_1_1, LWM2M_VERSION_LEN))
+            {
+                queryP->lwm2mVersion = IOWA_LWM2M_VERSION_1_1;
+            }
+            else
+            {
+                IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Unsupported LwM2M version.");
+                return IOWA_COAP_412_PRECONDITION_FAILED;
+            }
+        }
+        else if (optionP->length > QUERY_VERSION_LEN
+                 && 0 == memcmp(optionP->value.asBuffer, QUERY_VERSION, QUERY_VERSION_LEN))
+        {
+            IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Unsupported LwM2M version.");
+            return IOWA_COAP_412_PRECONDITION_FAILED;
+        }
+        else if (optionP->length > QUERY_BINDING_LEN
+                 && 0 == memcmp(optionP->value.asBuffer, QUERY_BINDING, QUERY_BINDING_LEN))
+        {
+            iowa_lwm2m_binding_t binding;
+
+            if (0 == utils_stringToBinding(optionP->value.asBuffer + QUERY_BINDING_LEN, optionP->length - QUERY_BINDING_LEN, &binding))
+            {
+                IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Invalid binding.");
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            queryP->binding |= binding;
+        }
+        else if (optionP->length == QUERY_QUEUE_MODE_LEN
+                 && 0 == memcmp(optionP->value.asBuffer, QUERY_QUEUE_MODE, QUERY_QUEUE_MODE_LEN))
+        {
+            // LwM2M 1.1 queue mode parameter
+            queryP->binding |= BINDING_Q;
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Ignoring unknown query parameter \"%.*s\".", optionP->length, optionP->value.asBuffer);
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static iowa_supported_format_t prv_contentFormatToSupportedFormat(int64_t format)
+{
+    switch (format)
+    {
+    case IOWA_CONTENT_FORMAT_TLV:
+        return IOWA_SUPPORTED_FORMAT_TLV;
+
+    case IOWA_CONTENT_FORMAT_JSON:
+        return IOWA_SUPPORTED_FORMAT_JSON;
+
+    case IOWA_CONTENT_FORMAT_TLV_OLD:
+        return IOWA_SUPPORTED_FORMAT_OLD_TLV;
+
+    case IOWA_CONTENT_FORMAT_JSON_OLD:
+        return IOWA_SUPPORTED_FORMAT_OLD_JSON;
+
+    case IOWA_CONTENT_FORMAT_CBOR:
+        return IOWA_SUPPORTED_FORMAT_CBOR;
+
+    case IOWA_CONTENT_FORMAT_SENML_JSON:
+        return IOWA_SUPPORTED_FORMAT_SENML_JSON;
+
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        return IOWA_SUPPORTED_FORMAT_SENML_CBOR;
+
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
+        return IOWA_SUPPORTED_FORMAT_LWM2M_CBOR;
+
+    default:
+        return IOWA_SUPPORTED_FORMAT_UNKNOWN;
+    }
+}
+
+static bool prv_parseObjectVersion(uint8_t *buffer,
+                                   size_t length,
+                                   iowa_object_version_t *versionP)
+{
+    size_t index;
+    int64_t major;
+    int64_t minor;
+
+    for (index = 0; index < length && buffer[index] != PRV_DECIMAL_POINT; index++)
+    {
+        // Looking for the decimal point
+    }
+    if (index == length
+        || 0 == dataUtilsBufferToInt(buffer, index, &major)
+        || 0 == dataUtilsBufferToInt(buffer + index + 1, length - index - 1, &minor)
+        || major < 0 || major > UINT8_MAX
+        || minor < 0 || minor > UINT8_MAX)
+    {
+        return false;
+    }
+
+    versionP->major = (uint8_t)major;
+    versionP->minor = (uint8_t)minor;
+
+    return true;
+}
+
+// Parse the CoRE Link payload of a Register or Update request.
+// Links to Objects and Object Instances fill objectLinkArray. The link tagged with rt="oma.lwm2m" carries the
+// alternate path and the supported content formats.
+static iowa_status_t prv_parseRegistrationPayload(lwm2m_client_t *clientP,
+                                                  uint8_t *payload,
+                                                  size_t length)
+{
+    size_t index;
+    size_t linkCount;
+    iowa_lwm2m_object_link_t *linkArray;
+    iowa_supported_format_t supportedFormats;
+    char *altPath;
+
+    linkCount = 0;
+    for (index = 0; index < length; index++)
+    {
+        if (payload[index] == PRV_LINK_START)
+        {
+            linkCount++;
+        }
+    }
+    if (linkCount == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Registration payload without links.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    linkArray = (iowa_lwm2m_object_link_t *)iowa_system_malloc(linkCount * sizeof(iowa_lwm2m_object_link_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (linkArray == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(linkCount * sizeof(iowa_lwm2m_object_link_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    linkCount = 0;
+    supportedFormats = IOWA_SUPPORTED_FORMAT_UNKNOWN;
+    altPath = NULL;
+    index = 0;
+
+    while (index < length)
+    {
+        size_t pathStart;
+        size_t pathEnd;
+        bool isLwm2mRoot;
+        size_t ctStart;
+        size_t ctEnd;
+        iowa_lwm2m_object_link_t link;
+
+        if (payload[index] != PRV_LINK_START)
+        {
+            goto error;
+        }
+        pathStart = index + 1;
+        while (index < length
+               && payload[index] != PRV_LINK_END)
+        {
+            index++;
+        }
+        if (index == length
+            || pathStart == index
+            || payload[pathStart] != REG_PATH_DELIMITER)
+        {
+            goto error;
+        }
+        pathEnd = index;
+        index++;
+
+        isLwm2mRoot = false;
+        ctStart = 0;
+        ctEnd = 0;
+        link.objectId = IOWA_LWM2M_ID_ALL;
+        link.instanceId = IOWA_LWM2M_ID_ALL;
+        link.version.major = PRV_DEFAULT_MAJOR_OBJECT_VERSION;
+        link.version.minor = PRV_DEFAULT_MINOR_OBJECT_VERSION;
+
+        // Link attributes
+        while (index < length
+               && payload[index] == PRV_ATTR_SEPARATOR)
+        {
+            size_t nameStart;
+            size_t nameEnd;
+            size_t valueStart;
+            size_t valueEnd;
+
+            index++;
+            nameStart = index;
+            while (index < length
+                   && payload[index] != PRV_ATTR_VALUE_START
+                   && payload[index] != PRV_ATTR_SEPARATOR
+                   && payload[index] != PRV_LINK_SEPARATOR)
+            {
+                index++;
+            }
+            nameEnd = index;
+            valueStart = index;
+            valueEnd = index;
+            if (index < length
+                && payload[index] == PRV_ATTR_VALUE_START)
+            {
+                bool inQuote;
+
+                index++;
+                valueStart = index;
+                inQuote = false;
+                while (index < length
+                       && (inQuote == true
+                           || (payload[index] != PRV_ATTR_SEPARATOR
+                               && payload[index] != PRV_LINK_SEPARATOR)))
+                {
+                    if (payload[index] == PRV_QUOTE)
+                    {
+                        inQuote = !inQuote;
+                    }
+                    index++;
+                }
+                if (inQuote == true)
+                {
+                    goto error;
+                }
+                valueEnd = index;
+            }
+
+            if (utilsCmpBufferWithString(payload + nameStart, nameEnd - nameStart, PRV_ATTR_RESOURCE_TYPE) == true)
+            {
+                isLwm2mRoot = utilsCmpBufferWithString(payload + valueStart, valueEnd - valueStart, REG_RESOURCE_TYPE);
+            }
+            else if (utilsCmpBufferWithString(payload + nameStart, nameEnd - nameStart, PRV_ATTR_CONTENT_TYPE) == true)
+            {
+                ctStart = valueStart;
+                ctEnd = valueEnd;
+            }
+            else if (utilsCmpBufferWithString(payload + nameStart, nameEnd - nameStart, PRV_ATTR_VERSION) == true)
+            {
+                if (valueEnd - valueStart >= 2
+                    && payload[valueStart] == PRV_QUOTE)
+                {
+                    valueStart++;
+                    valueEnd--;
+                }
+                if (prv_parseObjectVersion(payload + valueStart, valueEnd - valueStart, &link.version) == false)
+                {
+                    goto error;
+                }
+            }
+        }
+
+        if (index < length)
+        {
+            if (payload[index] != PRV_LINK_SEPARATOR)
+            {
+                goto error;
+            }
+            index++;
+        }
+
+        if (isLwm2mRoot == true)
+        {
+            // Supported content formats, e.g. ct=110 or ct="60 110"
+            while (ctStart < ctEnd)
+            {
+                size_t formatEnd;
+                int64_t format;
+
+                if (payload[ctStart] == PRV_QUOTE
+                    || payload[ctStart] == PRV_FORMAT_SEPARATOR)
+                {
+                    ctStart++;
+                    continue;
+                }
+                formatEnd = ctStart;
+                while (formatEnd < ctEnd
+                       && payload[formatEnd] != PRV_QUOTE
+                       && payload[formatEnd] != PRV_FORMAT_SEPARATOR)
+                {
+                    formatEnd++;
+                }
+                if (0 != dataUtilsBufferToInt(payload + ctStart, formatEnd - ctStart, &format))
+                {
+                    supportedFormats |= prv_contentFormatToSupportedFormat(format);
+                }
+                ctStart = formatEnd;
+            }
+
+            if (pathEnd - pathStart > 1)
+            {
+                iowa_system_free(altPath);
+                altPath = utilsBufferToString(payload + pathStart, pathEnd - pathStart);
+                if (altPath == NULL)
+                {
+                    iowa_system_free(linkArray);
+                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                }
+            }
+            continue;
+        }
+
+        // Object or Object Instance link, possibly prefixed by the alternate path
+        if (altPath != NULL
+            && pathEnd - pathStart > strlen(altPath)
+            && 0 == memcmp(payload + pathStart, altPath, strlen(altPath)))
+        {
+            pathStart += strlen(altPath);
+        }
+        {
+            size_t segmentStart;
+            size_t segmentEnd;
+            int64_t value;
+
+            segmentStart = pathStart + 1;
+            segmentEnd = segmentStart;
+            while (segmentEnd < pathEnd
+                   && payload[segmentEnd] != REG_PATH_DELIMITER)
+            {
+                segmentEnd++;
+            }
+            if (0 == dataUtilsBufferToInt(payload + segmentStart, segmentEnd - segmentStart, &value)
+                || value < 0
+                || value >= IOWA_LWM2M_ID_ALL)
+            {
+                // Not an Object link
+                continue;
+            }
+            link.objectId = (uint16_t)value;
+
+            if (segmentEnd < pathEnd)
+            {
+                segmentStart = segmentEnd + 1;
+                if (0 == dataUtilsBufferToInt(payload + segmentStart, pathEnd - segmentStart, &value)
+                    || value < 0
+                    || value >= IOWA_LWM2M_ID_ALL)
+                {
+                    goto error;
+                }
+                link.instanceId = (uint16_t)value;
+            }
+        }
+
+        linkArray[linkCount] = link;
+        linkCount++;
+    }
+
+    iowa_system_free(clientP->objectLinkArray);
+    clientP->objectLinkArray = linkArray;
+    clientP->objectLinkCount = linkCount;
+    clientP->supportedFormats = supportedFormats;
+    iowa_system_free(clientP->altPath);
+    clientP->altPath = altPath;
+
+    return IOWA_COAP_NO_ERROR;
+
+error:
+    IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Malformed registration payload at index %u.", index);
+    iowa_system_free(linkArray);
+    iowa_system_free(altPath);
+    return IOWA_COAP_400_BAD_REQUEST;
+}
+
+static iowa_status_t prv_applyRegistrationPayload(lwm2m_client_t *clientP,
+                                                  iowa_coap_message_t *messageP)
+{
+    iowa_content_format_t format;
+
+    if (messageP->payload.length == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    format = utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT);
+    if (format != IOWA_CONTENT_FORMAT_UNSET
+        && format != IOWA_CONTENT_FORMAT_CORE_LINK)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Registration payload is not in CoRE Link format.");
+        return IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
+    }
+
+    return prv_parseRegistrationPayload(clientP, messageP->payload.data, messageP->payload.length);
+}
+
+static void prv_handleRegistrationLifetimeTimer(iowa_context_t contextP,
+                                                void *userData)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_t *clientP;
+
+    clientP = (lwm2m_client_t *)userData;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Registration of client %u expired.", clientP->internalID);
+
+    // The timer is freed by coreTimerStep()
+    clientP->timerP = NULL;
+
+    registryRemove(contextP, clientP);
+    prv_callMonitorCallback(contextP, clientP, IOWA_STATE_UNREGISTERED);
+    utils_freeClient(contextP, clientP);
+}
+
+static void prv_handleRegister(iowa_context_t contextP,
+                               lwm2m_client_t *boundClientP,
+                               iowa_coap_peer_t *fromPeer,
+                               iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    prv_registration_query_t query;
+    lwm2m_client_t *clientP;
+    lwm2m_client_t *oldClientP;
+    iowa_coap_message_t *responseP;
+    iowa_coap_option_t *optionP;
+    char locationPath[URI_REGISTRATION_SEGMENT_LEN + 1 + LWM2M_CLIENT_LOCATION_LENGTH + 1];
+    iowa_status_t result;
+
+    clientP = NULL;
+
+    result = prv_parseRegistrationQuery(messageP, &query);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto exit;
+    }
+    if (query.name == NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Registration without Endpoint Name.");
+        result = IOWA_COAP_400_BAD_REQUEST;
+        goto exit;
+    }
+
+    clientP = (lwm2m_client_t *)iowa_system_malloc(sizeof(lwm2m_client_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (clientP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(lwm2m_client_t));
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit;
+    }
+#endif
+    memset(clientP, 0, sizeof(lwm2m_client_t));
+
+    clientP->name = query.name;
+    query.name = NULL;
+    clientP->msisdn = query.msisdn;
+    query.msisdn = NULL;
+    clientP->lifetime = (query.lifetime != 0) ? query.lifetime : LWM2M_DEFAULT_LIFETIME;
+    clientP->binding = (query.binding != 0) ? query.binding : IOWA_LWM2M_BINDING_UDP;
+    clientP->lwm2mVersion = (query.lwm2mVersion != IOWA_LWM2M_VERSION_UNDEFINED) ? query.lwm2mVersion : IOWA_LWM2M_VERSION_1_0;
+    clientP->multiResourcesFormat = IOWA_CONTENT_FORMAT_UNSET;
+    clientP->singleResourceFormat = IOWA_CONTENT_FORMAT_UNSET;
+    clientP->multiResourcesAcceptFormat = IOWA_CONTENT_FORMAT_UNSET;
+    clientP->singleResourceAcceptFormat = IOWA_CONTENT_FORMAT_UNSET;
+
+    result = prv_applyRegistrationPayload(clientP, messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto exit;
+    }
+
+    // Allow the verify callback to read the connection information
+    clientP->peerP = fromPeer;
+    result = prv_callVerifyClientCallback(contextP, clientP, IOWA_STATE_REGISTERING);
+    clientP->peerP = NULL;
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Client \"%s\" refused by the application.", clientP->name);
+        result = IOWA_COAP_403_FORBIDDEN;
+        goto exit;
+    }
+
+    oldClientP = registryFindByName(contextP, clientP->name);
+    if (oldClientP != NULL)
+    {
+        // A returning Client keeps its internal ID
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client \"%s\" registers again.", clientP->name);
+
+        clientP->internalID = oldClientP->internalID;
+        registryRemove(contextP, oldClientP);
+        if (oldClientP->peerP == fromPeer)
+        {
+            oldClientP->peerP = NULL;
+        }
+        if (oldClientP == boundClientP)
+        {
+            boundClientP = NULL;
+        }
+        utils_freeClient(contextP, oldClientP);
+    }
+    else
+    {
+        result = registryNewClientId(contextP, &(clientP->internalID));
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto exit;
+        }
+    }
+
+    registryNewLocation(contextP, clientP);
+
+    clientP->timerP = coreTimerNew(contextP, (int32_t)clientP->lifetime, prv_handleRegistrationLifetimeTimer, clientP);
+    if (clientP->timerP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create the timer.");
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit;
+    }
+
+    result = registryAdd(contextP, clientP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto exit;
+    }
+
+    if (boundClientP != NULL)
+    {
+        // The connection was used by another Client
+        boundClientP->peerP = NULL;
+    }
+    clientP->peerP = fromPeer;
+    coapPeerSetCallbacks(fromPeer, lwm2m_server_handle_request, NULL, clientP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client \"%s\" registered with ID %u at \"/%s/%s\".", clientP->name, clientP->internalID, URI_REGISTRATION_SEGMENT, clientP->location);
+
+    responseP = iowa_coap_message_prepare_response(messageP, IOWA_COAP_201_CREATED);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (responseP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create response packet.");
+    }
+    else
+#endif
+    {
+        memcpy(locationPath, URI_REGISTRATION_SEGMENT, URI_REGISTRATION_SEGMENT_LEN);
+        locationPath[URI_REGISTRATION_SEGMENT_LEN] = REG_PATH_DELIMITER;
+        memcpy(locationPath + URI_REGISTRATION_SEGMENT_LEN + 1, clientP->location, LWM2M_CLIENT_LOCATION_LENGTH + 1);
+
+        optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_LOCATION_PATH, locationPath, REG_PATH_DELIMITER);
+        if (optionP != NULL)
+        {
+            iowa_coap_message_add_option(responseP, optionP);
+            (void)coapSend(contextP, fromPeer, responseP, NULL, NULL);
+        }
+        iowa_coap_message_free(responseP);
+    }
+
+    // After the monitor callback, 'clientP' and 'fromPeer' may have been freed
+    prv_callMonitorCallback(contextP, clientP, IOWA_STATE_REGISTERED);
+    return;
+
+exit:
+    iowa_system_free(query.name);
+    iowa_system_free(query.msisdn);
+    if (clientP != NULL)
+    {
+        utils_freeClient(contextP, clientP);
+    }
+    coapSendResponse(contextP, fromPeer, messageP, result);
+}
+
+static void prv_handleUpdate(iowa_context_t contextP,
+                             lwm2m_client_t *clientP,
+                             lwm2m_client_t *boundClientP,
+                             iowa_coap_peer_t *fromPeer,
+                             iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    prv_registration_query_t query;
+    iowa_status_t result;
+
+    result = prv_parseRegistrationQuery(messageP, &query);
+    if (result != IOWA_COAP_NO_ERROR
+        || query.name != NULL)
+    {
+        iowa_system_free(query.name);
+        iowa_system_free(query.msisdn);
+        coapSendResponse(contextP, fromPeer, messageP, (result != IOWA_COAP_NO_ERROR) ? result : IOWA_COAP_400_BAD_REQUEST);
+        return;
+    }
+
+    result = prv_applyRegistrationPayload(clientP, messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        iowa_system_free(query.msisdn);
+        coapSendResponse(contextP, fromPeer, messageP, result);
+        return;
+    }
+
+    if (query.lifetime != 0)
+    {
+        clientP->lifetime = query.lifetime;
+    }
+    if (query.binding != 0)
+    {
+        clientP->binding = query.binding;
+    }
+    if (query.msisdn != NULL)
+    {
+        iowa_system_free(clientP->msisdn);
+        clientP->msisdn = query.msisdn;
+    }
+
+    if (clientP->peerP != fromPeer)
+    {
+        // The Client reaches us through a new connection
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client %u changed connection.", clientP->internalID);
+
+        if (clientP->peerP != NULL)
+        {
+            coapPeerDelete(contextP, clientP->peerP);
+        }
+        if (boundClientP != NULL)
+        {
+            boundClientP->peerP = NULL;
+        }
+        clientP->peerP = fromPeer;
+        coapPeerSetCallbacks(fromPeer, lwm2m_server_handle_request, NULL, clientP);
+    }
+
+    result = prv_callVerifyClientCallback(contextP, clientP, IOWA_STATE_UPDATING);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Client %u update refused by the application.", clientP->internalID);
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_403_FORBIDDEN);
+        return;
+    }
+
+    result = coreTimerReset(contextP, clientP->timerP, (int32_t)clientP->lifetime);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        coapSendResponse(contextP, fromPeer, messageP, result);
+        return;
+    }
+
+    coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_204_CHANGED);
+
+    prv_callMonitorCallback(contextP, clientP, IOWA_STATE_UPDATING);
+}
+
+static void prv_handleDeregister(iowa_context_t contextP,
+                                 lwm2m_client_t *clientP,
+                                 iowa_coap_peer_t *fromPeer,
+                                 iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Client %u deregisters.", clientP->internalID);
+
+    coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_202_DELETED);
+
+    registryRemove(contextP, clientP);
+    prv_callMonitorCallback(contextP, clientP, IOWA_STATE_UNREGISTERED);
+
+    // This closes the connection with the Client
+    utils_freeClient(contextP, clientP);
+}
+
+void registration_handleRequest(iowa_context_t contextP,
+                                lwm2m_client_t *clientP,
+                                iowa_coap_peer_t *fromPeer,
+                                iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_option_t *optionP;
+    lwm2m_client_t *targetP;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Entering with code: %u.%02u.", (messageP->code & 0xFF) >> 5, (messageP->code & 0x1F));
+
+    // First segment is "rd"
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_URI_PATH);
+    optionP = optionP->next;
+
+    if (optionP == NULL
+        || optionP->number != IOWA_COAP_OPTION_URI_PATH)
+    {
+        if (messageP->code == IOWA_COAP_CODE_POST)
+        {
+            prv_handleRegister(contextP, clientP, fromPeer, messageP);
+        }
+        else
+        {
+            coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_405_METHOD_NOT_ALLOWED);
+        }
+        return;
+    }
+
+    targetP = NULL;
+    if (optionP->next == NULL
+        || optionP->next->number != IOWA_COAP_OPTION_URI_PATH)
+    {
+        targetP = registryFindByLocation(contextP, optionP->value.asBuffer, optionP->length);
+    }
+    if (targetP == NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Unknown registration location.");
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_404_NOT_FOUND);
+        return;
+    }
+
+    switch (messageP->code)
+    {
+    case IOWA_COAP_CODE_POST:
+        prv_handleUpdate(contextP, targetP, clientP, fromPeer, messageP);
+        break;
+
+    case IOWA_COAP_CODE_DELETE:
+        prv_handleDeregister(contextP, targetP, fromPeer, messageP);
+        break;
+
+    default:
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_405_METHOD_NOT_ALLOWED);
+        break;
+    }
+}
+#endif // LWM2M_SERVER_MODE
@@ -0,0 +1,416 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019-2021 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+**********************************************/
+
+/*************************************************************************************
+* This file indexes the Clients registered to the Server.
+*
+* Three hash tables share the same bucket count: by internal ID, by Endpoint Name and
+* by registration location. The tables double when the number of Clients reaches the
+* bucket count so lookups, insertions and removals stay in constant time on average.
+*************************************************************************************/
+
+#include "iowa_prv_lwm2m_internals.h"
+
+#ifdef LWM2M_SERVER_MODE
+
+#define PRV_REGISTRY_INITIAL_BUCKET_COUNT (size_t)64
+
+// FNV-1a
+#define PRV_HASH_OFFSET_BASIS 2166136261U
+#define PRV_HASH_PRIME        16777619U
+
+// Odd step walking all the 32-bit values when looking for a free location
+#define PRV_LOCATION_STEP 2654435761U
+
+#define PRV_HEX_DIGITS "0123456789abcdef"
+
+// Internal IDs are exposed as 16-bit values in iowa_client_t
+#define PRV_CLIENT_ID_MAX 0xFFFEU
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static uint32_t prv_hashBuffer(const uint8_t *buffer,
+                               size_t length)
+{
+    uint32_t hash;
+    size_t i;
+
+    hash = PRV_HASH_OFFSET_BASIS;
+    for (i = 0; i < length; i++)
+    {
+        hash ^= buffer[i];
+        hash *= PRV_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+static size_t prv_idBucket(lwm2m_client_registry_t *registryP,
+                           uint32_t id)
+{
+    // Internal IDs are allocated sequentially so their low bits are already well spread
+    return (size_t)id & (registryP->bucketCount - 1);
+}
+
+static size_t prv_nameBucket(lwm2m_client_registry_t *registryP,
+                             const char *name)
+{
+    return (size_t)prv_hashBuffer((const uint8_t *)name, strlen(name)) & (registryP->bucketCount - 1);
+}
+
+static size_t prv_locationBucket(lwm2m_client_registry_t *registryP,
+                                 const uint8_t *location,
+                                 size_t length)
+{
+    return (size_t)prv_hashBuffer(location, length) & (registryP->bucketCount - 1);
+}
+
+static void prv_link(lwm2m_client_registry_t *registryP,
+                     lwm2m_client_t *clientP)
+{
+    size_t bucket;
+
+    bucket = prv_idBucket(registryP, clientP->internalID);
+    clientP->next = registryP->idTable[bucket];
+    registryP->idTable[bucket] = clientP;
+
+    bucket = prv_nameBucket(registryP, clientP->name);
+    clientP->nextByName = registryP->nameTable[bucket];
+    registryP->nameTable[bucket] = clientP;
+
+    bucket = prv_locationBucket(registryP, (const uint8_t *)clientP->location, LWM2M_CLIENT_LOCATION_LENGTH);
+    clientP->nextByLocation = registryP->locationTable[bucket];
+    registryP->locationTable[bucket] = clientP;
+}
+
+static iowa_status_t prv_resize(lwm2m_client_registry_t *registryP,
+                                size_t bucketCount)
+{
+    lwm2m_client_registry_t newRegistry;
+    size_t i;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resizing the registry from %u to %u buckets.", registryP->bucketCount, bucketCount);
+
+    newRegistry.idTable = (lwm2m_client_t **)iowa_system_malloc(bucketCount * sizeof(lwm2m_client_t *));
+    newRegistry.nameTable = (lwm2m_client_t **)iowa_system_malloc(bucketCount * sizeof(lwm2m_client_t *));
+    newRegistry.locationTable = (lwm2m_client_t **)iowa_system_malloc(bucketCount * sizeof(lwm2m_client_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (newRegistry.idTable == NULL
+        || newRegistry.nameTable == NULL
+        || newRegistry.locationTable == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(3 * bucketCount * sizeof(lwm2m_client_t *));
+        iowa_system_free(newRegistry.idTable);
+        iowa_system_free(newRegistry.nameTable);
+        iowa_system_free(newRegistry.locationTable);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(newRegistry.idTable, 0, bucketCount * sizeof(lwm2m_client_t *));
+    memset(newRegistry.nameTable, 0, bucketCount * sizeof(lwm2m_client_t *));
+    memset(newRegistry.locationTable, 0, bucketCount * sizeof(lwm2m_client_t *));
+    newRegistry.bucketCount = bucketCount;
+    newRegistry.clientCount = registryP->clientCount;
+
+    // Every Client appears exactly once in the ID table
+    for (i = 0; i < registryP->bucketCount; i++)
+    {
+        while (registryP->idTable[i] != NULL)
+        {
+            lwm2m_client_t *clientP;
+
+            clientP = registryP->idTable[i];
+            registryP->idTable[i] = clientP->next;
+
+            prv_link(&newRegistry, clientP);
+        }
+    }
+
+    iowa_system_free(registryP->idTable);
+    iowa_system_free(registryP->nameTable);
+    iowa_system_free(registryP->locationTable);
+
+    *registryP = newRegistry;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t registryAdd(iowa_context_t contextP,
+                          lwm2m_client_t *clientP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_registry_t *registryP;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Adding Client %u \"%s\" at \"%s\".", clientP->internalID, clientP->name, clientP->location);
+
+    registryP = &(contextP->lwm2mContextP->clientRegistry);
+
+    if (registryP->clientCount >= registryP->bucketCount)
+    {
+        if (prv_resize(registryP, registryP->bucketCount == 0 ? PRV_REGISTRY_INITIAL_BUCKET_COUNT : registryP->bucketCount * 2) != IOWA_COAP_NO_ERROR
+            && registryP->bucketCount == 0)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        // else the current tables are still usable, only with longer chains
+    }
+
+    prv_link(registryP, clientP);
+    registryP->clientCount++;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void registryRemove(iowa_context_t contextP,
+                    lwm2m_client_t *clientP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_registry_t *registryP;
+    lwm2m_client_t **nodePP;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Removing Client %u.", clientP->internalID);
+
+    registryP = &(contextP->lwm2mContextP->clientRegistry);
+    if (registryP->bucketCount == 0)
+    {
+        return;
+    }
+
+    nodePP = &(registryP->idTable[prv_idBucket(registryP, clientP->internalID)]);
+    while (*nodePP != NULL
+           && *nodePP != clientP)
+    {
+        nodePP = &((*nodePP)->next);
+    }
+    if (*nodePP == NULL)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Client %u is not registered.", clientP->internalID);
+        return;
+    }
+    *nodePP = clientP->next;
+
+    nodePP = &(registryP->nameTable[prv_nameBucket(registryP, clientP->name)]);
+    while (*nodePP != clientP)
+    {
+        nodePP = &((*nodePP)->nextByName);
+    }
+    *nodePP = clientP->nextByName;
+
+    nodePP = &(registryP->locationTable[prv_locationBucket(registryP, (const uint8_t *)clientP->location, LWM2M_CLIENT_LOCATION_LENGTH)]);
+    while (*nodePP != clientP)
+    {
+        nodePP = &((*nodePP)->nextByLocation);
+    }
+    *nodePP = clientP->nextByLocation;
+
+    clientP->next = NULL;
+    clientP->nextByName = NULL;
+    clientP->nextByLocation = NULL;
+    registryP->clientCount--;
+}
+
+lwm2m_client_t * registryFindById(iowa_context_t contextP,
+                                  uint32_t id)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_registry_t *registryP;
+    lwm2m_client_t *clientP;
+
+    registryP = &(contextP->lwm2mContextP->clientRegistry);
+    if (registryP->bucketCount == 0)
+    {
+        return NULL;
+    }
+
+    clientP = registryP->idTable[prv_idBucket(registryP, id)];
+    while (clientP != NULL
+           && clientP->internalID != id)
+    {
+        clientP = clientP->next;
+    }
+
+    return clientP;
+}
+
+lwm2m_client_t * registryFindByName(iowa_context_t contextP,
+                                    const char *name)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_registry_t *registryP;
+    lwm2m_client_t *clientP;
+
+    registryP = &(contextP->lwm2mContextP->clientRegistry);
+    if (registryP->bucketCount == 0)
+    {
+        return NULL;
+    }
+
+    clientP = registryP->nameTable[prv_nameBucket(registryP, name)];
+    while (clientP != NULL
+           && strcmp(clientP->name, name) != 0)
+    {
+        clientP = clientP->nextByName;
+    }
+
+    return clientP;
+}
+
+lwm2m_client_t * registryFindByLocation(iowa_context_t contextP,
+                                        const uint8_t *location,
+                                        size_t length)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_registry_t *registryP;
+    lwm2m_client_t *clientP;
+
+    registryP = &(contextP->lwm2mContextP->clientRegistry);
+    if (registryP->bucketCount == 0
+        || length != LWM2M_CLIENT_LOCATION_LENGTH)
+    {
+        return NULL;
+    }
+
+    clientP = registryP->locationTable[prv_locationBucket(registryP, location, length)];
+    while (clientP != NULL
+           && memcmp(clientP->location, location, length) != 0)
+    {
+        clientP = clientP->nextByLocation;
+    }
+
+    return clientP;
+}
+
+iowa_status_t registryNewClientId(iowa_context_t contextP,
+                                  uint32_t *idP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_context_t *lwm2mContextP;
+    uint32_t step;
+    uint32_t count;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    // In a shard group, the IDs of a shard are the ones equal to its index modulo the shard count
+    if (contextP->shardCount > 1)
+    {
+        step = contextP->shardCount;
+    }
+    else
+    {
+        step = 1;
+    }
+
+    for (count = 0; count <= PRV_CLIENT_ID_MAX / step; count++)
+    {
+        uint32_t id;
+
+        id = lwm2mContextP->nextClientID;
+        if (lwm2mContextP->nextClientID + step > PRV_CLIENT_ID_MAX)
+        {
+            lwm2mContextP->nextClientID = contextP->shardIndex;
+        }
+        else
+        {
+            lwm2mContextP->nextClientID += step;
+        }
+
+        if (registryFindById(contextP, id) == NULL)
+        {
+            *idP = id;
+            return IOWA_COAP_NO_ERROR;
+        }
+    }
+
+    IOWA_LOG_WARNING(IOWA_PART_LWM2M, "No more Client IDs available.");
+
+    return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+}
+
+void registryNewLocation(iowa_context_t contextP,
+                         lwm2m_client_t *clientP)
+{
+    // WARNING: This function is called in a critical section
+    uint32_t value;
+    int result;
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_random_vector_generator((uint8_t *)&value, sizeof(value), contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    if (result != 0)
+    {
+        IOWA_LOG_INFO(IOWA_PART_LWM2M, "iowa_system_random_vector_generator() failed or is not implemented. Deriving the location from the Client ID.");
+        value = clientP->internalID * PRV_LOCATION_STEP;
+    }
+
+    do
+    {
+        uint32_t digits;
+        size_t i;
+
+        digits = value;
+        for (i = LWM2M_CLIENT_LOCATION_LENGTH; i > 0; i--)
+        {
+            clientP->location[i - 1] = PRV_HEX_DIGITS[digits & 0x0F];
+            digits >>= 4;
+        }
+        clientP->location[LWM2M_CLIENT_LOCATION_LENGTH] = 0;
+
+        value += PRV_LOCATION_STEP;
+    } while (registryFindByLocation(contextP, (const uint8_t *)clientP->location, LWM2M_CLIENT_LOCATION_LENGTH) != NULL);
+}
+
+void registryClose(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_client_registry_t *registryP;
+    size_t i;
+
+    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+
+    registryP = &(contextP->lwm2mContextP->clientRegistry);
+
+    for (i = 0; i < registryP->bucketCount; i++)
+    {
+        while (registryP->idTable[i] != NULL)
+        {
+            lwm2m_client_t *clientP;
+
+            clientP = registryP->idTable[i];
+            registryP->idTable[i] = clientP->next;
+
+            utils_freeClient(contextP, clientP);
+        }
+    }
+
+    iowa_system_free(registryP->idTable);
+    iowa_system_free(registryP->nameTable);
+    iowa_system_free(registryP->locationTable);
+    memset(registryP, 0, sizeof(lwm2m_client_registry_t));
+}
+
+#endif // LWM2M_SERVER_MODE
@@ -21,3 +21,84 @@
 #include "iowa_prv_lwm2m_internals.h"
 #include "iowa_prv_objects_internals.h"
 
+
+#ifdef LWM2M_SERVER_MODE
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+void send_handleRequest(iowa_context_t contextP,
+                        lwm2m_client_t *clientP,
+                        iowa_coap_peer_t *fromPeer,
+                        iowa_coap_message_t *messageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_content_format_t format;
+    iowa_response_content_t content;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    uint16_t clientId;
+
+    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+
+    if (clientP == NULL
+        || contextP->lwm2mContextP->dataPushCallback == NULL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Data Push is not accepted.");
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_404_NOT_FOUND);
+        return;
+    }
+
+    if (messageP->code != IOWA_COAP_CODE_POST)
+    {
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_405_METHOD_NOT_ALLOWED);
+        return;
+    }
+
+    format = utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT);
+    switch (format)
+    {
+#ifdef LWM2M_SUPPORT_SENML_JSON
+    case IOWA_CONTENT_FORMAT_SENML_JSON:
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+#endif
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
+#endif
+        break;
+
+    default:
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Unsupported Data Push format %u.", format);
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT);
+        return;
+    }
+
+    dataP = NULL;
+    dataCount = 0;
+    result = dataLwm2mDeserialize(NULL, messageP->payload.data, messageP->payload.length, format, &dataP, &dataCount, utils_getResourceType, contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Failed to deserialize the Data Push payload: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_400_BAD_REQUEST);
+        return;
+    }
+
+    // The application may close the connection in its callback
+    clientId = (uint16_t)clientP->internalID;
+    coapSendResponse(contextP, fromPeer, messageP, IOWA_COAP_204_CHANGED);
+
+    content.details.dataPush.dataCount = dataCount;
+    content.details.dataPush.dataP = dataP;
+
+    CRIT_SECTION_LEAVE(contextP);
+    contextP->lwm2mContextP->dataPushCallback(clientId, IOWA_DM_DATA_PUSH, IOWA_COAP_NO_ERROR, &content, contextP->lwm2mContextP->dataPushUserData, contextP);
+    CRIT_SECTION_ENTER(contextP);
+
+    dataLwm2mFree(dataCount, dataP);
+}
+
+#endif // LWM2M_SERVER_MODE
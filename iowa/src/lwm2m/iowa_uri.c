@@ -114,6 +114,12 @@ lwm2m_uri_type_t uri_decode(iowa_coap_message_t *messageP,
         return LWM2M_URI_TYPE_BOOTSTRAP;
     }
 
+    if (URI_BOOTSTRAP_PACK_SEGMENT_LEN == optionP->length
+        && 0 == strncmp(URI_BOOTSTRAP_PACK_SEGMENT, (char *)optionP->value.asBuffer, optionP->length))
+    {
+        return LWM2M_URI_TYPE_BOOTSTRAP_PACK;
+    }
+
 #ifdef LWM2M_ALTPATH_SUPPORT
     if (altPath != NULL)
     {
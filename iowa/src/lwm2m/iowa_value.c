@@ -30,3 +30,617 @@ void valueFree(lwm2m_value_t *valueP)
         iowa_system_free(valueP);
     }
 }
+
+#ifdef LWM2M_NOTIFICATION_STORE_SUPPORT
+
+/*************************************************************************************
+** Notification store
+**
+** A record is:
+**   - its length (uint16_t),
+**   - the length of the observation token (uint8_t) and the token,
+**   - the number of data (uint16_t),
+**   - for each data: the URI (4 x uint16_t), the type (uint8_t), the timestamp (int32_t) and the value.
+** The values use the native representation of the platform as the store never leaves the device.
+*************************************************************************************/
+
+#define PRV_RECORD_LENGTH_SIZE   2
+#define PRV_RECORD_HEADER_SIZE   (PRV_RECORD_LENGTH_SIZE + 1)
+#define PRV_RECORD_DATA_SIZE     (4 * sizeof(uint16_t) + 1 + sizeof(int32_t))
+
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+#define PRV_REPLAY_CONTENT_FORMAT IOWA_CONTENT_FORMAT_SENML_CBOR
+#else
+#define PRV_REPLAY_CONTENT_FORMAT IOWA_CONTENT_FORMAT_SENML_JSON
+#endif
+
+static uint16_t prv_getRecordLength(const uint8_t *recordP)
+{
+    uint16_t length;
+
+    memcpy(&length, recordP, sizeof(uint16_t));
+
+    return length;
+}
+
+// Get the size of the value of a data in a record.
+// Returned value: false if the data can not be stored.
+static bool prv_getValueSize(iowa_lwm2m_data_t *dataP,
+                             size_t *sizeP)
+{
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_UNDEFINED:
+    case IOWA_LWM2M_TYPE_URI_ONLY:
+    case IOWA_LWM2M_TYPE_NULL:
+        *sizeP = 0;
+        break;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        *sizeP = sizeof(uint8_t);
+        break;
+
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        *sizeP = sizeof(int64_t);
+        break;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        *sizeP = sizeof(double);
+        break;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        *sizeP = sizeof(iowa_lwm2m_object_link_t);
+        break;
+
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_OPAQUE:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        if (dataP->value.asBuffer.length > UINT16_MAX)
+        {
+            return false;
+        }
+        *sizeP = sizeof(uint16_t) + dataP->value.asBuffer.length;
+        break;
+
+    default:
+        // Block values are never notified
+        return false;
+    }
+
+    return true;
+}
+
+// Remove a record from the store.
+static void prv_removeRecord(lwm2m_notification_store_t *storeP,
+                             size_t offset)
+{
+    uint16_t recordLength;
+
+    recordLength = prv_getRecordLength(storeP->bufferP + offset);
+    memmove(storeP->bufferP + offset, storeP->bufferP + offset + recordLength, storeP->length - offset - recordLength);
+    storeP->length -= recordLength;
+}
+
+// Remove the records carried by the last Send and release the store when empty.
+static void prv_removePendingRecords(lwm2m_notification_store_t *storeP)
+{
+    memmove(storeP->bufferP, storeP->bufferP + storeP->pendingLength, storeP->length - storeP->pendingLength);
+    storeP->length -= storeP->pendingLength;
+    storeP->pendingLength = 0;
+
+    if (storeP->length == 0)
+    {
+        iowa_system_free(storeP->bufferP);
+        storeP->bufferP = NULL;
+    }
+}
+
+// Decode the data of a record. The buffers of the data point to the record.
+// Returned value: the number of decoded data.
+static size_t prv_decodeRecord(const uint8_t *recordP,
+                               iowa_lwm2m_data_t *dataP)
+{
+    size_t index;
+    uint16_t dataCount;
+    uint16_t i;
+
+    index = PRV_RECORD_LENGTH_SIZE;
+    index += 1 + (size_t)recordP[index];
+    memcpy(&dataCount, recordP + index, sizeof(uint16_t));
+    index += sizeof(uint16_t);
+
+    for (i = 0; i < dataCount; i++)
+    {
+        memset(dataP + i, 0, sizeof(iowa_lwm2m_data_t));
+
+        memcpy(&dataP[i].objectID, recordP + index, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        memcpy(&dataP[i].instanceID, recordP + index, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        memcpy(&dataP[i].resourceID, recordP + index, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        memcpy(&dataP[i].resInstanceID, recordP + index, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        dataP[i].type = recordP[index];
+        index++;
+        memcpy(&dataP[i].timestamp, recordP + index, sizeof(int32_t));
+        index += sizeof(int32_t);
+
+        switch (dataP[i].type)
+        {
+        case IOWA_LWM2M_TYPE_BOOLEAN:
+            dataP[i].value.asBoolean = (recordP[index] != 0);
+            index++;
+            break;
+
+        case IOWA_LWM2M_TYPE_INTEGER:
+        case IOWA_LWM2M_TYPE_TIME:
+        case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+            memcpy(&dataP[i].value.asInteger, recordP + index, sizeof(int64_t));
+            index += sizeof(int64_t);
+            break;
+
+        case IOWA_LWM2M_TYPE_FLOAT:
+            memcpy(&dataP[i].value.asFloat, recordP + index, sizeof(double));
+            index += sizeof(double);
+            break;
+
+        case IOWA_LWM2M_TYPE_OBJECT_LINK:
+            memcpy(&dataP[i].value.asObjLink, recordP + index, sizeof(iowa_lwm2m_object_link_t));
+            index += sizeof(iowa_lwm2m_object_link_t);
+            break;
+
+        case IOWA_LWM2M_TYPE_STRING:
+        case IOWA_LWM2M_TYPE_OPAQUE:
+        case IOWA_LWM2M_TYPE_CORE_LINK:
+        {
+            uint16_t length;
+
+            memcpy(&length, recordP + index, sizeof(uint16_t));
+            index += sizeof(uint16_t);
+            dataP[i].value.asBuffer.length = length;
+            dataP[i].value.asBuffer.buffer = (length != 0) ? (uint8_t *)recordP + index : NULL;
+            index += length;
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    return dataCount;
+}
+
+static void prv_replayCallback(iowa_coap_peer_t *fromPeer,
+                               uint8_t status,
+                               iowa_coap_message_t *responseP,
+                               void *userData,
+                               iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_server_t *serverP;
+    lwm2m_notification_store_t *storeP;
+
+    (void)status;
+    (void)userData;
+
+    serverP = (lwm2m_server_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->serverList, utilsListFindCallbackServerByPeer, fromPeer);
+    if (serverP == NULL)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "No server found from the peer: %p.", fromPeer);
+        return;
+    }
+    storeP = &(serverP->runtime.notificationStore);
+
+    if (storeP->pendingLength == 0)
+    {
+        // The store was deleted in the meantime
+        return;
+    }
+
+    if (responseP == NULL)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Server %u did not acknowledge the stored notifications. Keeping them.", serverP->shortId);
+        storeP->pendingLength = 0;
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+        return;
+    }
+
+    if (!COAP_IS_SUCCESS(responseP->code))
+    {
+        // Sending the same records again would fail the same way
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Server %u rejected the stored notifications with code %u.%02u. Dropping them.", serverP->shortId, (responseP->code & 0xFF) >> 5, (responseP->code & 0x1F));
+        valueDeleteNotificationStore(serverP);
+        return;
+    }
+
+    prv_removePendingRecords(storeP);
+
+    valueReplayNotificationStore(contextP, serverP);
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+iowa_status_t valueEncodeNotification(lwm2m_observed_t *observedP,
+                                      iowa_lwm2m_data_t *dataP,
+                                      size_t dataCount,
+                                      lwm2m_value_t *valueP)
+{
+    size_t length;
+    size_t index;
+    size_t i;
+    uint16_t count;
+
+    // Compute the record length
+    length = PRV_RECORD_HEADER_SIZE + observedP->tokenLen + sizeof(uint16_t);
+    for (i = 0; i < dataCount; i++)
+    {
+        size_t valueSize;
+
+        if (prv_getValueSize(dataP + i, &valueSize) == false)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Data of type %s can not be stored.", STR_LWM2M_TYPE(dataP[i].type));
+            return IOWA_COAP_501_NOT_IMPLEMENTED;
+        }
+        length += PRV_RECORD_DATA_SIZE + valueSize;
+    }
+    if (length > UINT16_MAX
+        || dataCount > UINT16_MAX)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Notification of %u bytes is too large to be stored.", length);
+        return IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+    }
+
+    valueP->buffer = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (valueP->buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    valueP->bufferLength = length;
+
+    count = (uint16_t)length;
+    memcpy(valueP->buffer, &count, sizeof(uint16_t));
+    index = PRV_RECORD_LENGTH_SIZE;
+    valueP->buffer[index] = observedP->tokenLen;
+    index++;
+    memcpy(valueP->buffer + index, observedP->token, observedP->tokenLen);
+    index += observedP->tokenLen;
+    count = (uint16_t)dataCount;
+    memcpy(valueP->buffer + index, &count, sizeof(uint16_t));
+    index += sizeof(uint16_t);
+
+    for (i = 0; i < dataCount; i++)
+    {
+        int32_t timestamp;
+
+        memcpy(valueP->buffer + index, &dataP[i].objectID, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        memcpy(valueP->buffer + index, &dataP[i].instanceID, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        memcpy(valueP->buffer + index, &dataP[i].resourceID, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        memcpy(valueP->buffer + index, &dataP[i].resInstanceID, sizeof(uint16_t));
+        index += sizeof(uint16_t);
+        valueP->buffer[index] = dataP[i].type;
+        index++;
+
+        // The replay tells the Server when the value was notified
+        timestamp = (dataP[i].timestamp != 0) ? dataP[i].timestamp : valueP->time;
+        memcpy(valueP->buffer + index, &timestamp, sizeof(int32_t));
+        index += sizeof(int32_t);
+
+        switch (dataP[i].type)
+        {
+        case IOWA_LWM2M_TYPE_BOOLEAN:
+            valueP->buffer[index] = (dataP[i].value.asBoolean == true) ? 1 : 0;
+            index++;
+            break;
+
+        case IOWA_LWM2M_TYPE_INTEGER:
+        case IOWA_LWM2M_TYPE_TIME:
+        case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+            memcpy(valueP->buffer + index, &dataP[i].value.asInteger, sizeof(int64_t));
+            index += sizeof(int64_t);
+            break;
+
+        case IOWA_LWM2M_TYPE_FLOAT:
+            memcpy(valueP->buffer + index, &dataP[i].value.asFloat, sizeof(double));
+            index += sizeof(double);
+            break;
+
+        case IOWA_LWM2M_TYPE_OBJECT_LINK:
+            memcpy(valueP->buffer + index, &dataP[i].value.asObjLink, sizeof(iowa_lwm2m_object_link_t));
+            index += sizeof(iowa_lwm2m_object_link_t);
+            break;
+
+        case IOWA_LWM2M_TYPE_STRING:
+        case IOWA_LWM2M_TYPE_OPAQUE:
+        case IOWA_LWM2M_TYPE_CORE_LINK:
+            count = (uint16_t)dataP[i].value.asBuffer.length;
+            memcpy(valueP->buffer + index, &count, sizeof(uint16_t));
+            index += sizeof(uint16_t);
+            if (count != 0)
+            {
+                memcpy(valueP->buffer + index, dataP[i].value.asBuffer.buffer, count);
+                index += count;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t valueEncodeNotificationPayload(iowa_context_t contextP,
+                                             lwm2m_observed_t *observedP,
+                                             lwm2m_value_t *valueP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    uint8_t *payloadP;
+    size_t payloadLength;
+
+    // The data may point to the payload
+    payloadP = valueP->buffer;
+    payloadLength = valueP->bufferLength;
+    valueP->buffer = NULL;
+    valueP->bufferLength = 0;
+
+    result = dataLwm2mDeserialize(observedP->uriCount == 1 ? &observedP->uriInfoP[0].uri : NULL,
+                                  payloadP, payloadLength, valueP->format,
+                                  &dataP, &dataCount,
+                                  object_getResourceType, contextP);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = valueEncodeNotification(observedP, dataP, dataCount, valueP);
+        dataLwm2mFree(dataCount, dataP);
+    }
+    else
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Failed to decode the notification payload with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+    }
+    iowa_system_free(payloadP);
+
+    return result;
+}
+
+void valueStoreNotification(lwm2m_server_t *serverP,
+                            lwm2m_value_t *valueP,
+                            bool latestOnly)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_notification_store_t *storeP;
+    size_t offset;
+    uint32_t droppedCount;
+
+    if (valueP->buffer == NULL)
+    {
+        return;
+    }
+
+    storeP = &(serverP->runtime.notificationStore);
+
+    if (valueP->bufferLength > IOWA_NOTIFICATION_STORE_SIZE - storeP->pendingLength)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "No room to store a notification of %u bytes for Server %u.", valueP->bufferLength, serverP->shortId);
+        storeP->droppedCount++;
+        return;
+    }
+
+    if (storeP->bufferP == NULL)
+    {
+        storeP->bufferP = (uint8_t *)iowa_system_malloc(IOWA_NOTIFICATION_STORE_SIZE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (storeP->bufferP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(IOWA_NOTIFICATION_STORE_SIZE);
+            storeP->droppedCount++;
+            return;
+        }
+#endif
+        storeP->length = 0;
+    }
+
+    // The records being replayed are left untouched
+    if (latestOnly == true)
+    {
+        offset = storeP->pendingLength;
+        while (offset < storeP->length)
+        {
+            uint8_t *recordP;
+
+            recordP = storeP->bufferP + offset;
+            if (recordP[PRV_RECORD_LENGTH_SIZE] == valueP->tokenLen
+                && memcmp(recordP + PRV_RECORD_HEADER_SIZE, valueP->token, valueP->tokenLen) == 0)
+            {
+                // There is at most one record per observation in this mode
+                prv_removeRecord(storeP, offset);
+                break;
+            }
+            offset += prv_getRecordLength(recordP);
+        }
+    }
+
+    // The oldest records make room for the new one
+    droppedCount = 0;
+    while (storeP->length + valueP->bufferLength > IOWA_NOTIFICATION_STORE_SIZE)
+    {
+        prv_removeRecord(storeP, storeP->pendingLength);
+        droppedCount++;
+    }
+    if (droppedCount != 0)
+    {
+        storeP->droppedCount += droppedCount;
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Store of Server %u is full. Dropped %u old notifications.", serverP->shortId, droppedCount);
+    }
+
+    memcpy(storeP->bufferP + storeP->length, valueP->buffer, valueP->bufferLength);
+    storeP->length += valueP->bufferLength;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Stored a notification of %u bytes for Server %u. Store length: %u.", valueP->bufferLength, serverP->shortId, storeP->length);
+}
+
+void valueReplayNotificationStore(iowa_context_t contextP,
+                                  lwm2m_server_t *serverP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_notification_store_t *storeP;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    size_t batchLength;
+    iowa_content_format_t format;
+    uint8_t *payloadP;
+    size_t payloadLength;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *optionP;
+    uint8_t token[COAP_MSG_TOKEN_MAX_LEN];
+    uint8_t tokenLength;
+    iowa_status_t result;
+
+    storeP = &(serverP->runtime.notificationStore);
+
+    serverP->runtime.flags &= (uint16_t)(~LWM2M_SERVER_FLAG_NOTIFICATION_STORING);
+
+    if (storeP->length == 0
+        || storeP->pendingLength != 0)
+    {
+        // Nothing to replay or a Send is already ongoing
+        return;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Replaying %u bytes of stored notifications to Server %u.", storeP->length, serverP->shortId);
+
+    // A batch takes the oldest records up to IOWA_NOTIFICATION_STORE_BATCH_SIZE bytes, and at least one record
+    batchLength = 0;
+    dataCount = 0;
+    do
+    {
+        uint16_t recordDataCount;
+        const uint8_t *recordP;
+
+        recordP = storeP->bufferP + batchLength;
+        memcpy(&recordDataCount, recordP + PRV_RECORD_HEADER_SIZE + recordP[PRV_RECORD_LENGTH_SIZE], sizeof(uint16_t));
+        dataCount += recordDataCount;
+        batchLength += prv_getRecordLength(recordP);
+    } while (batchLength < storeP->length
+             && batchLength + prv_getRecordLength(storeP->bufferP + batchLength) <= IOWA_NOTIFICATION_STORE_BATCH_SIZE);
+
+    dataP = NULL;
+    if (dataCount != 0)
+    {
+        size_t offset;
+        size_t index;
+
+        dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(dataCount * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (dataP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(dataCount * sizeof(iowa_lwm2m_data_t));
+            serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+            return;
+        }
+#endif
+        index = 0;
+        for (offset = 0; offset < batchLength; offset += prv_getRecordLength(storeP->bufferP + offset))
+        {
+            index += prv_decodeRecord(storeP->bufferP + offset, dataP + index);
+        }
+    }
+
+    format = PRV_REPLAY_CONTENT_FORMAT;
+    payloadP = NULL;
+    payloadLength = 0;
+    result = dataLwm2mSerialize(NULL, dataP, dataCount, &format, &payloadP, &payloadLength);
+    iowa_system_free(dataP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "dataLwm2mSerialize() failed with code %u.%02u. Dropping the batch of stored notifications.", (result & 0xFF) >> 5, (result & 0x1F));
+        storeP->pendingLength = batchLength;
+        prv_removePendingRecords(storeP);
+        return;
+    }
+
+    result = coapPeerGenerateToken(serverP->runtime.peerP, &tokenLength, token);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failure to generate a new token.");
+        iowa_system_free(payloadP);
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+        return;
+    }
+
+    messageP = iowa_coap_message_new(IOWA_COAP_TYPE_CONFIRMABLE, IOWA_COAP_CODE_POST, tokenLength, token);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP message.");
+        iowa_system_free(payloadP);
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+        return;
+    }
+#endif
+
+    optionP = iowa_coap_path_to_option(IOWA_COAP_OPTION_URI_PATH, URI_SEND_SEGMENT, '/');
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
+        iowa_coap_message_free(messageP);
+        iowa_system_free(payloadP);
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+        return;
+    }
+    iowa_coap_message_add_option(messageP, optionP);
+
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
+        iowa_coap_message_free(messageP);
+        iowa_system_free(payloadP);
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+        return;
+    }
+#endif
+    optionP->value.asInteger = format;
+    iowa_coap_message_add_option(messageP, optionP);
+
+    coreBufferSet(&(messageP->payload), payloadP, payloadLength);
+
+    storeP->pendingLength = batchLength;
+    if (coapSend(contextP, serverP->runtime.peerP, messageP, prv_replayCallback, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Failed to replay the stored notifications to Server %u.", serverP->shortId);
+        storeP->pendingLength = 0;
+        serverP->runtime.flags |= LWM2M_SERVER_FLAG_NOTIFICATION_STORING;
+    }
+    else
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Replaying %u data from %u bytes of stored notifications to Server %u.", dataCount, batchLength, serverP->shortId);
+    }
+
+    iowa_coap_message_free(messageP);
+    iowa_system_free(payloadP);
+}
+
+void valueDeleteNotificationStore(lwm2m_server_t *serverP)
+{
+    iowa_system_free(serverP->runtime.notificationStore.bufferP);
+    memset(&(serverP->runtime.notificationStore), 0, sizeof(lwm2m_notification_store_t));
+    serverP->runtime.flags &= (uint16_t)(~LWM2M_SERVER_FLAG_NOTIFICATION_STORING);
+}
+
+#endif // LWM2M_NOTIFICATION_STORE_SUPPORT
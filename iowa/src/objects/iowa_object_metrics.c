@@ -0,0 +1,254 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2016-2021 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+**********************************************/
+
+#include "iowa_prv_objects_internals.h"
+
+#ifdef IOWA_SUPPORT_METRICS_OBJECT
+
+#ifndef IOWA_METRICS_OBJECT_ID
+#define IOWA_METRICS_OBJECT_ID 32769 // Default value
+#endif
+
+#define PRV_COUNTER_DESC(ID) { (ID), IOWA_LWM2M_TYPE_INTEGER, IOWA_OPERATION_READ, IOWA_RESOURCE_FLAG_MANDATORY }
+
+#define PRV_HISTOGRAM_DESC(ID)                                                                                                              \
+    PRV_COUNTER_DESC((ID) + IOWA_METRICS_HISTOGRAM_COUNT),                                                                                  \
+    PRV_COUNTER_DESC((ID) + IOWA_METRICS_HISTOGRAM_MEAN),                                                                                   \
+    PRV_COUNTER_DESC((ID) + IOWA_METRICS_HISTOGRAM_MAX),                                                                                    \
+    { (ID) + IOWA_METRICS_HISTOGRAM_BUCKETS, IOWA_LWM2M_TYPE_INTEGER, IOWA_OPERATION_READ, IOWA_RESOURCE_FLAG_MULTIPLE | IOWA_RESOURCE_FLAG_MANDATORY }
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static void prv_readHistogram(iowa_metrics_histogram_t *histogramP,
+                              uint16_t offset,
+                              iowa_lwm2m_data_t *dataP)
+{
+    switch (offset)
+    {
+    case IOWA_METRICS_HISTOGRAM_COUNT:
+        dataP->value.asInteger = histogramP->count;
+        break;
+
+    case IOWA_METRICS_HISTOGRAM_MEAN:
+        if (histogramP->count != 0)
+        {
+            dataP->value.asInteger = (int64_t)(histogramP->sum / histogramP->count);
+        }
+        else
+        {
+            dataP->value.asInteger = 0;
+        }
+        break;
+
+    case IOWA_METRICS_HISTOGRAM_MAX:
+        dataP->value.asInteger = histogramP->max;
+        break;
+
+    default:
+        if (dataP->resInstanceID < IOWA_METRICS_HISTOGRAM_BUCKET_COUNT)
+        {
+            dataP->value.asInteger = histogramP->buckets[dataP->resInstanceID];
+        }
+        break;
+    }
+}
+
+static iowa_status_t prv_metricsObjectCallback(iowa_dm_operation_t operation,
+                                               iowa_lwm2m_data_t *dataP,
+                                               size_t numData,
+                                               void *userData,
+                                               iowa_context_t contextP)
+{
+    iowa_metrics_t *metricsP;
+    size_t i;
+
+    (void)userData;
+
+    CRIT_SECTION_ENTER(contextP);
+
+    metricsP = &(contextP->metrics);
+
+    switch (operation)
+    {
+    case IOWA_DM_READ:
+        for (i = 0; i < numData; i++)
+        {
+            switch (dataP[i].resourceID)
+            {
+            case IOWA_METRICS_ID_DATAGRAM_RECEIVED:
+                dataP[i].value.asInteger = metricsP->datagramReceivedCount;
+                break;
+
+            case IOWA_METRICS_ID_DATAGRAM_DROPPED:
+                dataP[i].value.asInteger = metricsP->datagramDroppedCount;
+                break;
+
+            case IOWA_METRICS_ID_RETRANSMISSION:
+                dataP[i].value.asInteger = metricsP->retransmissionCount;
+                break;
+
+            case IOWA_METRICS_ID_TRANSACTION_TIMEOUT:
+                dataP[i].value.asInteger = metricsP->transactionTimeoutCount;
+                break;
+
+            case IOWA_METRICS_ID_NOTIFICATION_SENT:
+                dataP[i].value.asInteger = metricsP->notificationSentCount;
+                break;
+
+            case IOWA_METRICS_ID_NOTIFICATION_SUPPRESSED:
+                dataP[i].value.asInteger = metricsP->notificationSuppressedCount;
+                break;
+
+            case IOWA_METRICS_ID_REGISTRATION:
+                dataP[i].value.asInteger = metricsP->registrationCount;
+                break;
+
+            case IOWA_METRICS_ID_REGISTRATION_FAILURE:
+                dataP[i].value.asInteger = metricsP->registrationFailureCount;
+                break;
+
+            default:
+                if (dataP[i].resourceID >= IOWA_METRICS_ID_HANDSHAKE_DURATION)
+                {
+                    prv_readHistogram(&(metricsP->handshakeDuration), (uint16_t)(dataP[i].resourceID - IOWA_METRICS_ID_HANDSHAKE_DURATION), dataP + i);
+                }
+                else if (dataP[i].resourceID >= IOWA_METRICS_ID_STEP_DURATION)
+                {
+                    prv_readHistogram(&(metricsP->stepDuration), (uint16_t)(dataP[i].resourceID - IOWA_METRICS_ID_STEP_DURATION), dataP + i);
+                }
+                else
+                {
+                    prv_readHistogram(&(metricsP->requestRtt), (uint16_t)(dataP[i].resourceID - IOWA_METRICS_ID_REQUEST_RTT), dataP + i);
+                }
+                break;
+            }
+        }
+        break;
+
+    case IOWA_DM_EXECUTE:
+        // Reset is the only executable resource
+        IOWA_LOG_INFO(IOWA_PART_OBJECT, "Resetting the metrics.");
+        memset(metricsP, 0, sizeof(iowa_metrics_t));
+        break;
+
+    default:
+        break;
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static iowa_status_t prv_metricsResInstanceCallback(uint16_t objectID,
+                                                    uint16_t instanceID,
+                                                    uint16_t resourceID,
+                                                    uint16_t *nbResInstanceP,
+                                                    uint16_t **resInstanceArrayP,
+                                                    void *userData,
+                                                    iowa_context_t contextP)
+{
+    uint16_t i;
+
+    (void)objectID;
+    (void)instanceID;
+    (void)resourceID;
+    (void)userData;
+    (void)contextP;
+
+    // Only the buckets of the histograms are multiple resources
+    *nbResInstanceP = IOWA_METRICS_HISTOGRAM_BUCKET_COUNT;
+
+    *resInstanceArrayP = (uint16_t *)iowa_system_malloc(*nbResInstanceP * sizeof(uint16_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*resInstanceArrayP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(*nbResInstanceP * sizeof(uint16_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    for (i = 0; i < *nbResInstanceP; i++)
+    {
+        (*resInstanceArrayP)[i] = i;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_client_add_metrics_object(iowa_context_t contextP)
+{
+    iowa_status_t result;
+    iowa_lwm2m_resource_desc_t resources[] =
+    {
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_DATAGRAM_RECEIVED),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_DATAGRAM_DROPPED),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_RETRANSMISSION),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_TRANSACTION_TIMEOUT),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_NOTIFICATION_SENT),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_NOTIFICATION_SUPPRESSED),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_REGISTRATION),
+        PRV_COUNTER_DESC(IOWA_METRICS_ID_REGISTRATION_FAILURE),
+        { IOWA_METRICS_ID_RESET, IOWA_LWM2M_TYPE_UNDEFINED, IOWA_OPERATION_EXECUTE, IOWA_RESOURCE_FLAG_OPTIONAL },
+        PRV_HISTOGRAM_DESC(IOWA_METRICS_ID_REQUEST_RTT),
+        PRV_HISTOGRAM_DESC(IOWA_METRICS_ID_STEP_DURATION),
+        PRV_HISTOGRAM_DESC(IOWA_METRICS_ID_HANDSHAKE_DURATION)
+    };
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Adding the metrics object %u.", IOWA_METRICS_OBJECT_ID);
+
+    CRIT_SECTION_ENTER(contextP);
+    result = customObjectAdd(contextP,
+                             IOWA_METRICS_OBJECT_ID,
+                             OBJECT_SINGLE,
+                             0, NULL,
+                             (uint16_t)(sizeof(resources) / sizeof(iowa_lwm2m_resource_desc_t)), resources,
+                             prv_metricsObjectCallback, NULL, prv_metricsResInstanceCallback,
+                             NULL);
+    CRIT_SECTION_LEAVE(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+iowa_status_t iowa_client_remove_metrics_object(iowa_context_t contextP)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_INFO(IOWA_PART_OBJECT, "Removing the metrics object.");
+
+    CRIT_SECTION_ENTER(contextP);
+    result = customObjectRemove(contextP, IOWA_METRICS_OBJECT_ID);
+    CRIT_SECTION_LEAVE(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+#endif // IOWA_SUPPORT_METRICS_OBJECT
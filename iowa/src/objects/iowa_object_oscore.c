@@ -21,3 +21,104 @@
 
 #include "iowa_prv_objects_internals.h"
 
+
+#if defined(LWM2M_CLIENT_MODE) && defined(IOWA_COAP_OSCORE_SUPPORT)
+
+#define PRV_RSC_NUMBER 7
+
+// Like the Security Object, the OSCORE Object only describes the resources. The
+// values are never stored by IOWA: the OSCORE context of a Server is derived from
+// the iowa_oscore_data_t returned by iowa_system_security_data() for its URI.
+// Provisioning these resources through a Bootstrap Write is not supported.
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+iowa_status_t objectOscoreInit(iowa_context_t contextP)
+{
+    iowa_status_t result;
+    iowa_lwm2m_resource_desc_t resources[PRV_RSC_NUMBER];
+    int currentPt;
+
+    IOWA_LOG_INFO(IOWA_PART_OBJECT, "Init OSCORE object.");
+
+    // Get the resources list
+    currentPt = 0;
+
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, MASTER_SECRET, resources, currentPt);
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, SENDER_ID, resources, currentPt);
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, RECIPIENT_ID, resources, currentPt);
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, AEAD_ALGORITHM, resources, currentPt);
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, HMAC_ALGORITHM, resources, currentPt);
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, MASTER_SALT, resources, currentPt);
+    SET_LWM2M_DESC_T_TO_OBJECT_RSC(IOWA_LWM2M_OSCORE, ID_CONTEXT, resources, currentPt);
+
+    // Inform the stack
+    result = customObjectAdd(contextP,
+                             IOWA_LWM2M_OSCORE_OBJECT_ID,
+                             OBJECT_MULTIPLE,
+                             0, NULL,
+                             PRV_RSC_NUMBER, resources,
+                             NULL,
+                             NULL,
+                             NULL,
+                             NULL);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+iowa_status_t objectOscoreCreate(iowa_context_t contextP,
+                                 uint16_t id)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_INFO(IOWA_PART_OBJECT, "Adding new OSCORE object.");
+
+    result = objectAddInstance(contextP,
+                               IOWA_LWM2M_OSCORE_OBJECT_ID,
+                               id,
+                               0, NULL);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+iowa_status_t objectOscoreRemove(iowa_context_t contextP,
+                                 uint16_t id)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Removing OSCORE object (instance: %d).", id);
+
+    result = objectRemoveInstance(contextP,
+                                  IOWA_LWM2M_OSCORE_OBJECT_ID,
+                                  id);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+iowa_status_t objectOscoreClose(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+
+    IOWA_LOG_INFO(IOWA_PART_OBJECT, "Closing OSCORE object.");
+
+    result = customObjectRemove(contextP, IOWA_LWM2M_OSCORE_OBJECT_ID);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+    return result;
+}
+
+#endif
@@ -41,6 +41,7 @@ extern "C" {
 #include "iowa_ipso.h"
 #include "iowa_light_control.h"
 #include "iowa_firmware_update.h"
+#include "iowa_metrics.h"
 #include "iowa_mqtt_objects.h"
 #include "iowa_software_component.h"
 
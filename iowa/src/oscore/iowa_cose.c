@@ -19,6 +19,245 @@
 *
 **********************************************/
 
+
 #include "iowa_prv_oscore_internals.h"
 #include "iowa_prv_data_internals.h"
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+
+#define PRV_COSE_ENCRYPT0_CONTEXT "Encrypt0"
+#define PRV_COSE_HKDF_TYPE_KEY    "Key"
+#define PRV_COSE_HKDF_TYPE_IV     "IV"
+
+#define PRV_CBOR_SIMPLE_VALUE_NULL 22
+
+// [id, id_context, alg_aead, type, L] of section 3.2.1 of RFC 8613 with the largest id.
+#define PRV_COSE_HKDF_INFO_MAX_LENGTH 24
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Serialize the external_aad of section 5.4 of RFC 8613.
+static size_t prv_computeExternalAAD(const uint8_t *requestKid,
+                                     size_t requestKidLength,
+                                     uint64_t requestPartialIV,
+                                     uint8_t *buffer,
+                                     size_t bufferLength)
+{
+    uint8_t partialIV[PRV_OSCORE_PARTIAL_IV_MAX_LENGTH];
+    size_t partialIVLength;
+    size_t index;
+
+    partialIVLength = oscore_coseEncodePartialIV(requestPartialIV, partialIV);
+
+    index = 0;
+    if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, 5, buffer, bufferLength, &index) != CBOR_NO_ERROR
+        || cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, PRV_OSCORE_VERSION, buffer, bufferLength, &index) != CBOR_NO_ERROR
+        || cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, 1, buffer, bufferLength, &index) != CBOR_NO_ERROR
+        || cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, PRV_OSCORE_AEAD_ALGORITHM, buffer, bufferLength, &index) != CBOR_NO_ERROR
+        || cborAddStringToBuffer((uint8_t *)requestKid, requestKidLength, buffer, bufferLength, &index, true) != CBOR_NO_ERROR
+        || cborAddStringToBuffer(partialIV, partialIVLength, buffer, bufferLength, &index, true) != CBOR_NO_ERROR
+        || cborAddStringToBuffer(NULL, 0, buffer, bufferLength, &index, true) != CBOR_NO_ERROR)
+    {
+        return 0;
+    }
+
+    return index;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+size_t oscore_coseEncodePartialIV(uint64_t partialIV,
+                                  uint8_t *buffer)
+{
+    size_t length;
+    size_t i;
+
+    length = 1;
+    while (length < PRV_OSCORE_PARTIAL_IV_MAX_LENGTH
+           && (partialIV >> (8 * length)) != 0)
+    {
+        length++;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        buffer[length - 1 - i] = (uint8_t)(partialIV >> (8 * i));
+    }
+
+    return length;
+}
+
+void oscore_coseComputeNonce(const uint8_t *id,
+                             size_t idLength,
+                             uint64_t partialIV,
+                             const uint8_t *commonIV,
+                             uint8_t *nonce)
+{
+    size_t i;
+
+    // Size of the ID, ID left-padded to (nonce length - 6) bytes and Partial IV left-padded to 5 bytes
+    memset(nonce, 0, PRV_OSCORE_NONCE_LENGTH);
+    nonce[0] = (uint8_t)idLength;
+    if (idLength != 0)
+    {
+        memcpy(nonce + 1 + OSCORE_MAX_ID_LENGTH - idLength, id, idLength);
+    }
+    for (i = 0; i < PRV_OSCORE_PARTIAL_IV_MAX_LENGTH; i++)
+    {
+        nonce[PRV_OSCORE_NONCE_LENGTH - 1 - i] = (uint8_t)(partialIV >> (8 * i));
+    }
+
+    for (i = 0; i < PRV_OSCORE_NONCE_LENGTH; i++)
+    {
+        nonce[i] ^= commonIV[i];
+    }
+}
+
+size_t oscore_coseComputeAAD(const uint8_t *requestKid,
+                             size_t requestKidLength,
+                             uint64_t requestPartialIV,
+                             uint8_t *aad)
+{
+    uint8_t externalAAD[PRV_OSCORE_AAD_MAX_LENGTH];
+    size_t externalAADLength;
+    size_t index;
+
+    externalAADLength = prv_computeExternalAAD(requestKid, requestKidLength, requestPartialIV, externalAAD, sizeof(externalAAD));
+    if (externalAADLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Failed to serialize the external AAD.");
+        return 0;
+    }
+
+    // Enc_structure = ["Encrypt0", empty protected header, external_aad]
+    index = 0;
+    if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, 3, aad, PRV_OSCORE_AAD_MAX_LENGTH, &index) != CBOR_NO_ERROR
+        || cborAddStringToBuffer((uint8_t *)PRV_COSE_ENCRYPT0_CONTEXT, sizeof(PRV_COSE_ENCRYPT0_CONTEXT) - 1, aad, PRV_OSCORE_AAD_MAX_LENGTH, &index, false) != CBOR_NO_ERROR
+        || cborAddStringToBuffer(NULL, 0, aad, PRV_OSCORE_AAD_MAX_LENGTH, &index, true) != CBOR_NO_ERROR
+        || cborAddStringToBuffer(externalAAD, externalAADLength, aad, PRV_OSCORE_AAD_MAX_LENGTH, &index, true) != CBOR_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Failed to serialize the AAD.");
+        return 0;
+    }
+
+    return index;
+}
+
+iowa_status_t oscore_coseDeriveKey(const uint8_t *masterSecret,
+                                   size_t masterSecretLength,
+                                   const uint8_t *masterSalt,
+                                   size_t masterSaltLength,
+                                   uint8_t type,
+                                   const uint8_t *id,
+                                   size_t idLength,
+                                   uint8_t *output,
+                                   size_t outputLength)
+{
+    uint8_t info[PRV_COSE_HKDF_INFO_MAX_LENGTH];
+    size_t index;
+    const char *typeString;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Deriving %s of %u bytes.", type == COSE_HKDF_TYPE_KEY ? "key" : "IV", outputLength);
+
+    switch (type)
+    {
+    case COSE_HKDF_TYPE_KEY:
+        typeString = PRV_COSE_HKDF_TYPE_KEY;
+        break;
+
+    case COSE_HKDF_TYPE_IV:
+        typeString = PRV_COSE_HKDF_TYPE_IV;
+        break;
+
+    default:
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    // info = [id, id_context, alg_aead, type, L]. The ID Context is not used.
+    index = 0;
+    if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, 5, info, sizeof(info), &index) != CBOR_NO_ERROR
+        || cborAddStringToBuffer((uint8_t *)id, idLength, info, sizeof(info), &index, true) != CBOR_NO_ERROR
+        || cborAddNumberToBuffer(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, PRV_CBOR_SIMPLE_VALUE_NULL, info, sizeof(info), &index) != CBOR_NO_ERROR
+        || cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, PRV_OSCORE_AEAD_ALGORITHM, info, sizeof(info), &index) != CBOR_NO_ERROR
+        || cborAddStringToBuffer((uint8_t *)typeString, strlen(typeString), info, sizeof(info), &index, false) != CBOR_NO_ERROR
+        || cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, outputLength, info, sizeof(info), &index) != CBOR_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Failed to serialize the HKDF info.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return iowa_user_security_HKDF(PRV_OSCORE_HKDF_ALGORITHM,
+                                   (uint8_t *)masterSecret, masterSecretLength,
+                                   (uint8_t *)masterSalt, masterSaltLength,
+                                   info, index,
+                                   output, outputLength);
+}
+
+iowa_status_t oscore_coseEncrypt(const uint8_t *key,
+                                 const uint8_t *nonce,
+                                 const uint8_t *aad,
+                                 size_t aadLength,
+                                 const uint8_t *plainBuffer,
+                                 size_t plainLength,
+                                 uint8_t *encryptedBuffer)
+{
+    size_t encryptedLength;
+    iowa_status_t result;
+
+    encryptedLength = plainLength;
+    result = iowa_user_security_AEAD_encrypt(PRV_OSCORE_AEAD_ALGORITHM,
+                                             (uint8_t *)key, PRV_OSCORE_KEY_LENGTH,
+                                             (uint8_t *)nonce, PRV_OSCORE_NONCE_LENGTH,
+                                             (uint8_t *)aad, aadLength,
+                                             (uint8_t *)plainBuffer, plainLength,
+                                             encryptedBuffer, &encryptedLength,
+                                             encryptedBuffer + plainLength, PRV_OSCORE_TAG_LENGTH);
+    if (result == IOWA_COAP_NO_ERROR
+        && encryptedLength != plainLength)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "AEAD encryption returned %u bytes instead of %u.", encryptedLength, plainLength);
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return result;
+}
+
+iowa_status_t oscore_coseDecrypt(const uint8_t *key,
+                                 const uint8_t *nonce,
+                                 const uint8_t *aad,
+                                 size_t aadLength,
+                                 const uint8_t *encryptedBuffer,
+                                 size_t encryptedLength,
+                                 uint8_t *plainBuffer)
+{
+    size_t plainLength;
+    iowa_status_t result;
+
+    if (encryptedLength < PRV_OSCORE_TAG_LENGTH)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    plainLength = encryptedLength - PRV_OSCORE_TAG_LENGTH;
+    result = iowa_user_security_AEAD_decrypt(PRV_OSCORE_AEAD_ALGORITHM,
+                                             (uint8_t *)key, PRV_OSCORE_KEY_LENGTH,
+                                             (uint8_t *)nonce, PRV_OSCORE_NONCE_LENGTH,
+                                             (uint8_t *)aad, aadLength,
+                                             (uint8_t *)encryptedBuffer + plainLength, PRV_OSCORE_TAG_LENGTH,
+                                             (uint8_t *)encryptedBuffer, plainLength,
+                                             plainBuffer, &plainLength);
+    if (result == IOWA_COAP_NO_ERROR
+        && plainLength != encryptedLength - PRV_OSCORE_TAG_LENGTH)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "AEAD decryption returned %u bytes instead of %u.", plainLength, encryptedLength - PRV_OSCORE_TAG_LENGTH);
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return result;
+}
+
+#endif // IOWA_COAP_OSCORE_SUPPORT
@@ -19,7 +19,1182 @@
 *
 **********************************************/
 
+
 #include "iowa_prv_oscore_internals.h"
 #include "iowa_utils.h"
 #include "iowa_prv_coap.h"
 
+#ifdef IOWA_COAP_OSCORE_SUPPORT
+
+// Length of a backed up sequence number state: identifiers, Common IV, Sender Sequence Number, highest received Partial IV and replay window
+#define PRV_SEQUENCE_BACKUP_LENGTH(S, R) (2 + (size_t)(S) + (size_t)(R) + PRV_OSCORE_NONCE_LENGTH + 8 + 8 + 4)
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Options which are not protected. See section 4.1 of RFC 8613.
+// The Observe option is both protected and not protected.
+static bool prv_isOuterOption(uint16_t number)
+{
+    switch (number)
+    {
+    case IOWA_COAP_OPTION_URI_HOST:
+    case IOWA_COAP_OPTION_OBSERVE:
+    case IOWA_COAP_OPTION_URI_PORT:
+    case IOWA_COAP_OPTION_OSCORE:
+    case IOWA_COAP_OPTION_PROXY_URI:
+    case IOWA_COAP_OPTION_PROXY_SCHEME:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static bool prv_isInnerOption(uint16_t number)
+{
+    switch (number)
+    {
+    case IOWA_COAP_OPTION_OBSERVE:
+        return true;
+
+    default:
+        return !prv_isOuterOption(number);
+    }
+}
+
+static bool prv_isObserveRegistration(iowa_coap_message_t *messageP)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE);
+
+    return (optionP != NULL && optionP->value.asInteger == 0);
+}
+
+// Duplicate an option. The value of the copy points to the value of the original.
+static iowa_coap_option_t * prv_optionCopy(iowa_coap_option_t *optionP)
+{
+    iowa_coap_option_t *copyP;
+
+    copyP = iowa_coap_option_new(optionP->number);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (copyP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+        return NULL;
+    }
+#endif
+    copyP->length = optionP->length;
+    copyP->value = optionP->value;
+
+    return copyP;
+}
+
+static iowa_linked_buffer_t * prv_bufferNew(size_t length)
+{
+    iowa_linked_buffer_t *bufferP;
+
+    bufferP = (iowa_linked_buffer_t *)iowa_system_malloc(sizeof(iowa_linked_buffer_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_linked_buffer_t));
+        return NULL;
+    }
+#endif
+    bufferP->next = NULL;
+    bufferP->length = length;
+    bufferP->data = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP->data == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        iowa_system_free(bufferP);
+        return NULL;
+    }
+#endif
+
+    return bufferP;
+}
+
+// Parse the value of an OSCORE option. See section 6.1 of RFC 8613.
+static iowa_status_t prv_optionParse(iowa_coap_option_t *optionP,
+                                     bool *hasPartialIVP,
+                                     uint64_t *partialIVP,
+                                     bool *hasKidP,
+                                     const uint8_t **kidP,
+                                     size_t *kidLengthP)
+{
+    size_t index;
+    size_t partialIVLength;
+    size_t i;
+
+    *hasPartialIVP = false;
+    *partialIVP = 0;
+    *hasKidP = false;
+    *kidP = NULL;
+    *kidLengthP = 0;
+
+    if (optionP->length == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    if ((optionP->value.asBuffer[0] & PRV_OSCORE_FLAG_RESERVED_MASK) != 0)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Reserved bits are set in the OSCORE option flags (0x%02X).", optionP->value.asBuffer[0]);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    partialIVLength = optionP->value.asBuffer[0] & PRV_OSCORE_FLAG_PARTIAL_IV_MASK;
+    if (partialIVLength > PRV_OSCORE_PARTIAL_IV_MAX_LENGTH
+        || 1 + partialIVLength > optionP->length)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Invalid Partial IV length %u in the OSCORE option.", partialIVLength);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+    for (i = 0; i < partialIVLength; i++)
+    {
+        *partialIVP = (*partialIVP << 8) | optionP->value.asBuffer[1 + i];
+    }
+    *hasPartialIVP = (partialIVLength != 0);
+    index = 1 + partialIVLength;
+
+    if ((optionP->value.asBuffer[0] & PRV_OSCORE_FLAG_KID_CONTEXT) != 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "OSCORE ID Contexts are not supported.");
+        return IOWA_COAP_401_UNAUTHORIZED;
+    }
+
+    if ((optionP->value.asBuffer[0] & PRV_OSCORE_FLAG_KID) != 0)
+    {
+        *hasKidP = true;
+        *kidP = optionP->value.asBuffer + index;
+        *kidLengthP = optionP->length - index;
+    }
+    else if (index != optionP->length)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Trailing bytes in the OSCORE option.");
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static oscore_sequence_t * prv_sequenceFind(iowa_context_t contextP,
+                                            const uint8_t *senderId,
+                                            size_t senderIdLength,
+                                            const uint8_t *recipientId,
+                                            size_t recipientIdLength,
+                                            const uint8_t *commonIV)
+{
+    oscore_sequence_t *sequenceP;
+
+    for (sequenceP = contextP->coapContextP->oscoreSequenceList; sequenceP != NULL; sequenceP = sequenceP->next)
+    {
+        if (sequenceP->senderIdLength == senderIdLength
+            && sequenceP->recipientIdLength == recipientIdLength
+            && memcmp(sequenceP->senderId, senderId, senderIdLength) == 0
+            && memcmp(sequenceP->recipientId, recipientId, recipientIdLength) == 0
+            && memcmp(sequenceP->commonIV, commonIV, PRV_OSCORE_NONCE_LENGTH) == 0)
+        {
+            break;
+        }
+    }
+
+    return sequenceP;
+}
+
+static oscore_sequence_t * prv_sequenceGet(iowa_context_t contextP,
+                                           const uint8_t *senderId,
+                                           size_t senderIdLength,
+                                           const uint8_t *recipientId,
+                                           size_t recipientIdLength,
+                                           const uint8_t *commonIV)
+{
+    oscore_sequence_t *sequenceP;
+
+    sequenceP = prv_sequenceFind(contextP, senderId, senderIdLength, recipientId, recipientIdLength, commonIV);
+    if (sequenceP != NULL)
+    {
+        return sequenceP;
+    }
+
+    sequenceP = (oscore_sequence_t *)iowa_system_malloc(sizeof(oscore_sequence_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (sequenceP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(oscore_sequence_t));
+        return NULL;
+    }
+#endif
+    memset(sequenceP, 0, sizeof(oscore_sequence_t));
+
+    memcpy(sequenceP->senderId, senderId, senderIdLength);
+    sequenceP->senderIdLength = (uint8_t)senderIdLength;
+    memcpy(sequenceP->recipientId, recipientId, recipientIdLength);
+    sequenceP->recipientIdLength = (uint8_t)recipientIdLength;
+    memcpy(sequenceP->commonIV, commonIV, PRV_OSCORE_NONCE_LENGTH);
+
+    contextP->coapContextP->oscoreSequenceList = (oscore_sequence_t *)IOWA_UTILS_LIST_ADD(contextP->coapContextP->oscoreSequenceList, sequenceP);
+
+    return sequenceP;
+}
+
+// Check a received Partial IV against the replay window. See section 7.4 of RFC 8613.
+static bool prv_replayCheck(oscore_sequence_t *sequenceP,
+                            uint64_t partialIV)
+{
+    uint64_t offset;
+
+    if (partialIV > sequenceP->replayHighest)
+    {
+        return true;
+    }
+
+    offset = sequenceP->replayHighest - partialIV;
+    if (offset >= PRV_OSCORE_REPLAY_WINDOW_SIZE)
+    {
+        return false;
+    }
+
+    return (sequenceP->replayWindow & ((uint32_t)1 << offset)) == 0;
+}
+
+// Mark a verified Partial IV as received.
+static void prv_replayUpdate(oscore_sequence_t *sequenceP,
+                             uint64_t partialIV)
+{
+    uint64_t offset;
+
+    if (partialIV > sequenceP->replayHighest)
+    {
+        offset = partialIV - sequenceP->replayHighest;
+        if (offset >= PRV_OSCORE_REPLAY_WINDOW_SIZE)
+        {
+            sequenceP->replayWindow = 0;
+        }
+        else
+        {
+            sequenceP->replayWindow <<= offset;
+        }
+        sequenceP->replayHighest = partialIV;
+        sequenceP->replayWindow |= 1;
+    }
+    else
+    {
+        sequenceP->replayWindow |= (uint32_t)1 << (sequenceP->replayHighest - partialIV);
+    }
+}
+
+static request_IV_t * prv_requestFind(oscore_peer_context_t *peerContextP,
+                                      bool way,
+                                      uint8_t tokenLength,
+                                      const uint8_t *token)
+{
+    request_IV_t *requestP;
+
+    for (requestP = peerContextP->requestList; requestP != NULL; requestP = requestP->next)
+    {
+        if (requestP->way == way
+            && requestP->tokenLength == tokenLength
+            && memcmp(requestP->token, token, tokenLength) == 0)
+        {
+            break;
+        }
+    }
+
+    return requestP;
+}
+
+static void prv_requestRemove(oscore_peer_context_t *peerContextP,
+                              request_IV_t *requestP)
+{
+    peerContextP->requestList = (request_IV_t *)IOWA_UTILS_LIST_REMOVE(peerContextP->requestList, requestP);
+    iowa_system_free(requestP);
+}
+
+static iowa_status_t prv_requestAdd(oscore_peer_context_t *peerContextP,
+                                    bool way,
+                                    uint64_t partialIV,
+                                    iowa_coap_message_t *requestMessageP)
+{
+    request_IV_t *requestP;
+
+    requestP = prv_requestFind(peerContextP, way, requestMessageP->tokenLength, requestMessageP->token);
+    if (requestP == NULL)
+    {
+        request_IV_t *nodeP;
+        request_IV_t *oldestP;
+        size_t count;
+
+        // Requests left without response would otherwise accumulate. The list is ordered from the newest to the oldest.
+        count = 0;
+        oldestP = NULL;
+        for (nodeP = peerContextP->requestList; nodeP != NULL; nodeP = nodeP->next)
+        {
+            count++;
+            if (nodeP->keep == false
+                || oldestP == NULL
+                || oldestP->keep == true)
+            {
+                oldestP = nodeP;
+            }
+        }
+        if (count >= PRV_OSCORE_MAX_REQUEST_IV)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Dropping the Partial IV %u of an unanswered request.", (uint32_t)oldestP->partialIV);
+            prv_requestRemove(peerContextP, oldestP);
+        }
+
+        requestP = (request_IV_t *)iowa_system_malloc(sizeof(request_IV_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (requestP == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(sizeof(request_IV_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        memset(requestP, 0, sizeof(request_IV_t));
+        requestP->way = way;
+        requestP->tokenLength = requestMessageP->tokenLength;
+        memcpy(requestP->token, requestMessageP->token, requestMessageP->tokenLength);
+
+        peerContextP->requestList = (request_IV_t *)IOWA_UTILS_LIST_ADD(peerContextP->requestList, requestP);
+    }
+
+    requestP->partialIV = partialIV;
+    requestP->keep = prv_isObserveRegistration(requestMessageP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static oscore_peer_context_t * prv_contextNew(iowa_context_t contextP,
+                                              iowa_oscore_data_t *dataP)
+{
+    oscore_peer_context_t *peerContextP;
+
+    if (dataP->senderIdLen > OSCORE_MAX_ID_LENGTH
+        || dataP->recipientIdLen > OSCORE_MAX_ID_LENGTH
+        || (dataP->senderId == NULL && dataP->senderIdLen != 0)
+        || (dataP->recipientId == NULL && dataP->recipientIdLen != 0)
+        || dataP->masterSecret == NULL
+        || dataP->masterSecretLen == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Invalid OSCORE security data.");
+        return NULL;
+    }
+
+    peerContextP = (oscore_peer_context_t *)iowa_system_malloc(sizeof(oscore_peer_context_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (peerContextP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(oscore_peer_context_t));
+        return NULL;
+    }
+#endif
+    memset(peerContextP, 0, sizeof(oscore_peer_context_t));
+
+    if (dataP->senderIdLen != 0)
+    {
+        memcpy(peerContextP->senderId, dataP->senderId, dataP->senderIdLen);
+    }
+    peerContextP->senderIdLength = (uint8_t)dataP->senderIdLen;
+    if (dataP->recipientIdLen != 0)
+    {
+        memcpy(peerContextP->recipientId, dataP->recipientId, dataP->recipientIdLen);
+    }
+    peerContextP->recipientIdLength = (uint8_t)dataP->recipientIdLen;
+
+    // The keys are derived once and kept for the lifetime of the peer.
+    if (oscore_coseDeriveKey(dataP->masterSecret, dataP->masterSecretLen, dataP->masterSalt, dataP->masterSaltLen,
+                             COSE_HKDF_TYPE_KEY, peerContextP->senderId, peerContextP->senderIdLength,
+                             peerContextP->senderKey, PRV_OSCORE_KEY_LENGTH) != IOWA_COAP_NO_ERROR
+        || oscore_coseDeriveKey(dataP->masterSecret, dataP->masterSecretLen, dataP->masterSalt, dataP->masterSaltLen,
+                                COSE_HKDF_TYPE_KEY, peerContextP->recipientId, peerContextP->recipientIdLength,
+                                peerContextP->recipientKey, PRV_OSCORE_KEY_LENGTH) != IOWA_COAP_NO_ERROR
+        || oscore_coseDeriveKey(dataP->masterSecret, dataP->masterSecretLen, dataP->masterSalt, dataP->masterSaltLen,
+                                COSE_HKDF_TYPE_IV, NULL, 0,
+                                peerContextP->commonIV, PRV_OSCORE_NONCE_LENGTH) != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Failed to derive the OSCORE security context.");
+        oscore_contextDelete(peerContextP);
+        return NULL;
+    }
+
+    peerContextP->sequenceP = prv_sequenceGet(contextP,
+                                              peerContextP->senderId, peerContextP->senderIdLength,
+                                              peerContextP->recipientId, peerContextP->recipientIdLength,
+                                              peerContextP->commonIV);
+    if (peerContextP->sequenceP == NULL)
+    {
+        oscore_contextDelete(peerContextP);
+        return NULL;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "New OSCORE context %p, Sender Sequence Number: %u.", peerContextP, (uint32_t)peerContextP->sequenceP->senderSequenceNumber);
+
+    return peerContextP;
+}
+
+static iowa_status_t prv_nextSequenceNumber(oscore_peer_context_t *peerContextP,
+                                            uint64_t *partialIVP)
+{
+    if (peerContextP->sequenceP->senderSequenceNumber > PRV_OSCORE_SEQUENCE_NUMBER_MAX)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "OSCORE Sender Sequence Number is exhausted. New keys are required.");
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    *partialIVP = peerContextP->sequenceP->senderSequenceNumber;
+    peerContextP->sequenceP->senderSequenceNumber++;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+oscore_peer_context_t *oscore_contextCreateFromURI(iowa_context_t contextP,
+                                                   const char *uri)
+{
+    // WARNING: This function is called in a critical section
+    iowa_security_data_t securityData;
+    oscore_peer_context_t *peerContextP;
+    iowa_status_t result;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "uri: \"%s\".", uri);
+
+    memset(&securityData, 0, sizeof(iowa_security_data_t));
+    securityData.securityMode = IOWA_SEC_OSCORE;
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_security_data((const uint8_t *)uri, strlen(uri), IOWA_SEC_READ, &securityData, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_COAP, "Failed to retrieve the OSCORE security data (%u.%02u)", (result & 0xFF) >> 5, (result & 0x1F));
+        return NULL;
+    }
+
+    peerContextP = prv_contextNew(contextP, &(securityData.protocol.oscoreData));
+
+    CRIT_SECTION_LEAVE(contextP);
+    (void)iowa_system_security_data((const uint8_t *)uri, strlen(uri), IOWA_SEC_FREE, &securityData, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    return peerContextP;
+}
+
+iowa_status_t oscore_contextCreateFromOption(iowa_context_t contextP,
+                                             iowa_coap_option_t *optionP,
+                                             oscore_peer_context_t **peerContextPP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_security_data_t securityData;
+    iowa_status_t result;
+    bool hasPartialIV;
+    uint64_t partialIV;
+    bool hasKid;
+    const uint8_t *kid;
+    size_t kidLength;
+
+    *peerContextPP = NULL;
+
+    result = prv_optionParse(optionP, &hasPartialIV, &partialIV, &hasKid, &kid, &kidLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+    if (hasKid == false
+        || kidLength > OSCORE_MAX_ID_LENGTH)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "No valid kid in the OSCORE option.");
+        return IOWA_COAP_401_UNAUTHORIZED;
+    }
+
+    // The kid of the peer is our Recipient ID
+    memset(&securityData, 0, sizeof(iowa_security_data_t));
+    securityData.securityMode = IOWA_SEC_OSCORE;
+    securityData.protocol.oscoreData.recipientId = (uint8_t *)kid;
+    securityData.protocol.oscoreData.recipientIdLen = kidLength;
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_security_data(kid, kidLength, IOWA_SEC_READ, &securityData, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No OSCORE security context found for the kid (%u.%02u)", (result & 0xFF) >> 5, (result & 0x1F));
+        return IOWA_COAP_401_UNAUTHORIZED;
+    }
+
+    if (securityData.protocol.oscoreData.recipientIdLen == kidLength
+        && (kidLength == 0 || memcmp(securityData.protocol.oscoreData.recipientId, kid, kidLength) == 0))
+    {
+        *peerContextPP = prv_contextNew(contextP, &(securityData.protocol.oscoreData));
+    }
+    else
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "The OSCORE security data do not match the kid.");
+    }
+
+    CRIT_SECTION_LEAVE(contextP);
+    (void)iowa_system_security_data(kid, kidLength, IOWA_SEC_FREE, &securityData, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    if (*peerContextPP == NULL)
+    {
+        return IOWA_COAP_401_UNAUTHORIZED;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void oscore_contextDelete(oscore_peer_context_t *peerContextP)
+{
+    if (peerContextP == NULL)
+    {
+        return;
+    }
+
+    IOWA_UTILS_LIST_FREE(peerContextP->requestList, iowa_system_free);
+
+    // Do not leave the keys in the heap
+    memset(peerContextP, 0, sizeof(oscore_peer_context_t));
+    iowa_system_free(peerContextP);
+}
+
+iowa_status_t oscore_encryptMessage(iowa_context_t contextP,
+                                    oscore_peer_context_t *peerContextP,
+                                    iowa_coap_message_t *plainMessageP,
+                                    iowa_coap_message_t **encryptedMessageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    request_IV_t *requestP;
+    uint64_t requestPartialIV;
+    const uint8_t *requestKid;
+    size_t requestKidLength;
+    uint64_t partialIV;
+    bool hasPartialIV;
+    bool isRequest;
+    bool isObserve;
+    iowa_coap_message_t *messageP;
+    iowa_coap_option_t *innerListP;
+    iowa_coap_option_t *innerTailP;
+    iowa_coap_option_t *optionP;
+    iowa_linked_buffer_t *bufferP;
+    size_t plainLength;
+    uint8_t *plainBuffer;
+    uint8_t *optionBuffer;
+    uint8_t nonce[PRV_OSCORE_NONCE_LENGTH];
+    uint8_t aad[PRV_OSCORE_AAD_MAX_LENGTH];
+    size_t aadLength;
+
+    (void)contextP;
+
+    *encryptedMessageP = NULL;
+
+    isRequest = COAP_IS_REQUEST(plainMessageP->code);
+    isObserve = (iowa_coap_message_find_option(plainMessageP, IOWA_COAP_OPTION_OBSERVE) != NULL);
+
+    // Select the Partial IV used in the nonce and the request parameters used in the AAD
+    if (isRequest == true)
+    {
+        result = prv_nextSequenceNumber(peerContextP, &partialIV);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+        hasPartialIV = true;
+        requestP = NULL;
+        requestPartialIV = partialIV;
+        requestKid = peerContextP->senderId;
+        requestKidLength = peerContextP->senderIdLength;
+        oscore_coseComputeNonce(peerContextP->senderId, peerContextP->senderIdLength, partialIV, peerContextP->commonIV, nonce);
+    }
+    else
+    {
+        requestP = prv_requestFind(peerContextP, PRV_INCOMING, plainMessageP->tokenLength, plainMessageP->token);
+        if (requestP == NULL)
+        {
+            IOWA_LOG_INFO(IOWA_PART_COAP, "Response to an unverified request. Sending it unprotected.");
+            return IOWA_COAP_NO_ERROR;
+        }
+        requestPartialIV = requestP->partialIV;
+        requestKid = peerContextP->recipientId;
+        requestKidLength = peerContextP->recipientIdLength;
+
+        if (isObserve == true)
+        {
+            // Notifications use their own Partial IV. See section 4.1.3.5.2 of RFC 8613.
+            result = prv_nextSequenceNumber(peerContextP, &partialIV);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                return result;
+            }
+            hasPartialIV = true;
+            oscore_coseComputeNonce(peerContextP->senderId, peerContextP->senderIdLength, partialIV, peerContextP->commonIV, nonce);
+        }
+        else
+        {
+            partialIV = 0;
+            hasPartialIV = false;
+            oscore_coseComputeNonce(peerContextP->recipientId, peerContextP->recipientIdLength, requestPartialIV, peerContextP->commonIV, nonce);
+        }
+    }
+
+    aadLength = oscore_coseComputeAAD(requestKid, requestKidLength, requestPartialIV, aad);
+    if (aadLength == 0)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    // The outer message. See section 4.2 of RFC 8613.
+    if (isRequest == true)
+    {
+        messageP = iowa_coap_message_new(plainMessageP->type, isObserve ? IOWA_COAP_CODE_FETCH : IOWA_COAP_CODE_POST, plainMessageP->tokenLength, plainMessageP->token);
+    }
+    else
+    {
+        messageP = iowa_coap_message_new(plainMessageP->type, isObserve ? IOWA_COAP_205_CONTENT : IOWA_COAP_204_CHANGED, plainMessageP->tokenLength, plainMessageP->token);
+    }
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP message.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    messageP->id = plainMessageP->id;
+
+    // Split the options
+    innerListP = NULL;
+    innerTailP = NULL;
+    plainLength = 1;
+    for (optionP = plainMessageP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        if (prv_isOuterOption(optionP->number))
+        {
+            iowa_coap_option_t *copyP;
+
+            if (optionP->number == IOWA_COAP_OPTION_OSCORE)
+            {
+                continue;
+            }
+
+            copyP = prv_optionCopy(optionP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (copyP == NULL)
+            {
+                result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                goto exit_on_error;
+            }
+#endif
+            iowa_coap_message_add_option(messageP, copyP);
+        }
+        if (prv_isInnerOption(optionP->number))
+        {
+            iowa_coap_option_t *copyP;
+
+            copyP = prv_optionCopy(optionP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (copyP == NULL)
+            {
+                result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+                goto exit_on_error;
+            }
+#endif
+            if (innerTailP == NULL)
+            {
+                innerListP = copyP;
+            }
+            else
+            {
+                innerTailP->next = copyP;
+            }
+            innerTailP = copyP;
+
+            plainLength += option_getSerializedLength(copyP, iowa_coap_option_is_integer);
+        }
+    }
+    if (plainMessageP->payload.length != 0)
+    {
+        plainLength += 1 + plainMessageP->payload.length;
+    }
+
+    // One buffer holds the ciphertext with the tag, the OSCORE option value and the plaintext
+    bufferP = prv_bufferNew(plainLength + PRV_OSCORE_TAG_LENGTH + PRV_OSCORE_OPTION_MAX_LENGTH + plainLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit_on_error;
+    }
+#endif
+    messageP->userBufferList = bufferP;
+    optionBuffer = bufferP->data + plainLength + PRV_OSCORE_TAG_LENGTH;
+    plainBuffer = optionBuffer + PRV_OSCORE_OPTION_MAX_LENGTH;
+
+    // The plaintext: code, Class E options and payload. See section 5.3 of RFC 8613.
+    plainBuffer[0] = plainMessageP->code;
+    plainLength = 1 + option_serialize(innerListP, plainBuffer + 1, iowa_coap_option_is_integer);
+    if (plainMessageP->payload.length != 0)
+    {
+        plainBuffer[plainLength] = PRV_MSG_PAYLOAD_MARKER;
+        memcpy(plainBuffer + plainLength + 1, plainMessageP->payload.data, plainMessageP->payload.length);
+        plainLength += 1 + plainMessageP->payload.length;
+    }
+
+    result = oscore_coseEncrypt(peerContextP->senderKey, nonce, aad, aadLength, plainBuffer, plainLength, bufferP->data);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "OSCORE encryption failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        goto exit_on_error;
+    }
+    messageP->payload.data = bufferP->data;
+    messageP->payload.length = plainLength + PRV_OSCORE_TAG_LENGTH;
+
+    // The OSCORE option. See section 6.1 of RFC 8613.
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OSCORE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit_on_error;
+    }
+#endif
+    if (hasPartialIV == true)
+    {
+        size_t partialIVLength;
+
+        partialIVLength = oscore_coseEncodePartialIV(partialIV, optionBuffer + 1);
+        optionBuffer[0] = (uint8_t)partialIVLength;
+        optionP->length = (uint16_t)(1 + partialIVLength);
+        if (isRequest == true)
+        {
+            optionBuffer[0] |= PRV_OSCORE_FLAG_KID;
+            if (peerContextP->senderIdLength != 0)
+            {
+                memcpy(optionBuffer + optionP->length, peerContextP->senderId, peerContextP->senderIdLength);
+            }
+            optionP->length = (uint16_t)(optionP->length + peerContextP->senderIdLength);
+        }
+        optionP->value.asBuffer = optionBuffer;
+    }
+    iowa_coap_message_add_option(messageP, optionP);
+
+    // Keep the request parameters for its responses
+    if (isRequest == true)
+    {
+        result = prv_requestAdd(peerContextP, PRV_OUTGOING, partialIV, plainMessageP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto exit_on_error;
+        }
+    }
+    else if (requestP->keep == false)
+    {
+        prv_requestRemove(peerContextP, requestP);
+    }
+
+    iowa_coap_option_free(innerListP);
+    *encryptedMessageP = messageP;
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_on_error:
+    iowa_coap_option_free(innerListP);
+    iowa_coap_message_free(messageP);
+
+    return result;
+}
+
+iowa_status_t oscore_decryptMessage(iowa_context_t contextP,
+                                    iowa_coap_peer_t *peerP,
+                                    oscore_peer_context_t *peerContextP,
+                                    iowa_coap_message_t *encryptedMessageP,
+                                    iowa_coap_message_t **plainMessageP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_coap_option_t *optionP;
+    bool hasPartialIV;
+    uint64_t partialIV;
+    bool hasKid;
+    const uint8_t *kid;
+    size_t kidLength;
+    bool isRequest;
+    request_IV_t *requestP;
+    uint64_t requestPartialIV;
+    const uint8_t *requestKid;
+    size_t requestKidLength;
+    uint8_t nonce[PRV_OSCORE_NONCE_LENGTH];
+    uint8_t aad[PRV_OSCORE_AAD_MAX_LENGTH];
+    size_t aadLength;
+    iowa_coap_message_t *messageP;
+    iowa_linked_buffer_t *bufferP;
+    size_t index;
+
+    (void)contextP;
+    (void)peerP;
+
+    *plainMessageP = NULL;
+
+    optionP = iowa_coap_message_find_option(encryptedMessageP, IOWA_COAP_OPTION_OSCORE);
+    if (optionP == NULL)
+    {
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+    result = prv_optionParse(optionP, &hasPartialIV, &partialIV, &hasKid, &kid, &kidLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    isRequest = COAP_IS_REQUEST(encryptedMessageP->code);
+    if (isRequest == true)
+    {
+        if (hasPartialIV == false
+            || hasKid == false)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "OSCORE request without Partial IV or kid.");
+            return IOWA_COAP_402_BAD_OPTION;
+        }
+        if (kidLength != peerContextP->recipientIdLength
+            || memcmp(kid, peerContextP->recipientId, kidLength) != 0)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "OSCORE security context not found.");
+            return IOWA_COAP_401_UNAUTHORIZED;
+        }
+        requestP = NULL;
+        requestPartialIV = partialIV;
+        requestKid = peerContextP->recipientId;
+        requestKidLength = peerContextP->recipientIdLength;
+    }
+    else
+    {
+        requestP = prv_requestFind(peerContextP, PRV_OUTGOING, encryptedMessageP->tokenLength, encryptedMessageP->token);
+        if (requestP == NULL)
+        {
+            IOWA_LOG_INFO(IOWA_PART_COAP, "OSCORE response to an unknown request.");
+            return IOWA_COAP_404_NOT_FOUND;
+        }
+        requestPartialIV = requestP->partialIV;
+        requestKid = peerContextP->senderId;
+        requestKidLength = peerContextP->senderIdLength;
+    }
+
+    if (hasPartialIV == true)
+    {
+        if (prv_replayCheck(peerContextP->sequenceP, partialIV) == false)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "OSCORE replay detected (Partial IV: %u).", (uint32_t)partialIV);
+            return IOWA_COAP_401_UNAUTHORIZED;
+        }
+        oscore_coseComputeNonce(peerContextP->recipientId, peerContextP->recipientIdLength, partialIV, peerContextP->commonIV, nonce);
+    }
+    else
+    {
+        oscore_coseComputeNonce(requestKid, requestKidLength, requestPartialIV, peerContextP->commonIV, nonce);
+    }
+
+    aadLength = oscore_coseComputeAAD(requestKid, requestKidLength, requestPartialIV, aad);
+    if (aadLength == 0)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    if (encryptedMessageP->payload.length <= PRV_OSCORE_TAG_LENGTH)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "OSCORE message is too short.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    messageP = iowa_coap_message_new(encryptedMessageP->type, IOWA_COAP_CODE_EMPTY, encryptedMessageP->tokenLength, encryptedMessageP->token);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (messageP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP message.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    messageP->id = encryptedMessageP->id;
+
+    // The options of the plain message point in this buffer
+    bufferP = prv_bufferNew(encryptedMessageP->payload.length - PRV_OSCORE_TAG_LENGTH);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (bufferP == NULL)
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit_on_error;
+    }
+#endif
+    messageP->userBufferList = bufferP;
+
+    result = oscore_coseDecrypt(peerContextP->recipientKey,
+                                nonce, aad, aadLength,
+                                encryptedMessageP->payload.data, encryptedMessageP->payload.length,
+                                bufferP->data);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "OSCORE decryption failed.");
+        result = IOWA_COAP_400_BAD_REQUEST;
+        goto exit_on_error;
+    }
+
+    // Only verified messages move the replay window
+    if (hasPartialIV == true)
+    {
+        prv_replayUpdate(peerContextP->sequenceP, partialIV);
+    }
+
+    // The plaintext: code, Class E options and payload
+    messageP->code = bufferP->data[0];
+    result = option_parse(bufferP->data + 1, bufferP->length - 1, &(messageP->optionList), &index, iowa_coap_option_is_integer);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Parsing of the OSCORE protected options failed.");
+        result = IOWA_COAP_402_BAD_OPTION;
+        goto exit_on_error;
+    }
+    index += 1;
+    if (index < bufferP->length)
+    {
+        if (bufferP->data[index] != PRV_MSG_PAYLOAD_MARKER)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "Expected payload marker not found in the OSCORE plaintext.");
+            result = IOWA_COAP_400_BAD_REQUEST;
+            goto exit_on_error;
+        }
+        messageP->payload.data = bufferP->data + index + 1;
+        messageP->payload.length = bufferP->length - index - 1;
+    }
+
+    // Add the unprotected options. The outer Observe option replaces the inner one.
+    for (optionP = encryptedMessageP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        iowa_coap_option_t *copyP;
+
+        if (optionP->number == IOWA_COAP_OPTION_OSCORE
+            || prv_isOuterOption(optionP->number) == false)
+        {
+            continue;
+        }
+        if (optionP->number == IOWA_COAP_OPTION_OBSERVE)
+        {
+            iowa_coap_option_t *innerP;
+
+            innerP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE);
+            if (innerP != NULL)
+            {
+                innerP->value.asInteger = optionP->value.asInteger;
+                continue;
+            }
+        }
+        copyP = prv_optionCopy(optionP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (copyP == NULL)
+        {
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto exit_on_error;
+        }
+#endif
+        iowa_coap_message_add_option(messageP, copyP);
+    }
+
+    // Keep the request parameters for its responses, or forget them once the exchange is over
+    if (isRequest == true)
+    {
+        result = prv_requestAdd(peerContextP, PRV_INCOMING, partialIV, messageP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            goto exit_on_error;
+        }
+    }
+    else if (requestP->keep == false
+             || iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE) == NULL)
+    {
+        prv_requestRemove(peerContextP, requestP);
+    }
+
+    *plainMessageP = messageP;
+
+    return IOWA_COAP_NO_ERROR;
+
+exit_on_error:
+    iowa_coap_message_free(messageP);
+
+    return result;
+}
+
+void oscore_sequenceClear(iowa_context_t contextP)
+{
+    IOWA_UTILS_LIST_FREE(contextP->coapContextP->oscoreSequenceList, iowa_system_free);
+    contextP->coapContextP->oscoreSequenceList = NULL;
+}
+
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+size_t oscore_sequenceBackup(iowa_context_t contextP,
+                             uint8_t *buffer,
+                             size_t length)
+{
+    // WARNING: This function is called in a critical section
+    oscore_sequence_t *sequenceP;
+    size_t index;
+
+    index = 0;
+    for (sequenceP = contextP->coapContextP->oscoreSequenceList; sequenceP != NULL; sequenceP = sequenceP->next)
+    {
+        size_t entryLength;
+
+        entryLength = PRV_SEQUENCE_BACKUP_LENGTH(sequenceP->senderIdLength, sequenceP->recipientIdLength);
+
+        if (buffer != NULL)
+        {
+            uint64_t senderSequenceNumber;
+
+            if (index + entryLength > length)
+            {
+                IOWA_LOG_ERROR(IOWA_PART_COAP, "Buffer is too small.");
+                return 0;
+            }
+
+            // Numbers consumed after this backup are skipped on restoration. See Appendix B.1.1 of RFC 8613.
+            senderSequenceNumber = sequenceP->senderSequenceNumber + PRV_OSCORE_SEQUENCE_NUMBER_BACKUP_MARGIN;
+
+            buffer[index] = sequenceP->senderIdLength;
+            memcpy(buffer + index + 1, sequenceP->senderId, sequenceP->senderIdLength);
+            buffer[index + 1 + sequenceP->senderIdLength] = sequenceP->recipientIdLength;
+            memcpy(buffer + index + 2 + sequenceP->senderIdLength, sequenceP->recipientId, sequenceP->recipientIdLength);
+            memcpy(buffer + index + 2 + sequenceP->senderIdLength + sequenceP->recipientIdLength, sequenceP->commonIV, PRV_OSCORE_NONCE_LENGTH);
+            utilsCopyValue(buffer + index + entryLength - 20, &senderSequenceNumber, 8);
+            utilsCopyValue(buffer + index + entryLength - 12, &(sequenceP->replayHighest), 8);
+            utilsCopyValue(buffer + index + entryLength - 4, &(sequenceP->replayWindow), 4);
+        }
+
+        index += entryLength;
+    }
+
+    return index;
+}
+
+iowa_status_t oscore_sequenceRestore(iowa_context_t contextP,
+                                     const uint8_t *buffer,
+                                     size_t length)
+{
+    // WARNING: This function is called in a critical section
+    size_t index;
+
+    index = 0;
+    while (index < length)
+    {
+        const uint8_t *senderId;
+        size_t senderIdLength;
+        const uint8_t *recipientId;
+        size_t recipientIdLength;
+        const uint8_t *commonIV;
+        uint64_t senderSequenceNumber;
+        uint64_t replayHighest;
+        oscore_sequence_t *sequenceP;
+
+        senderIdLength = buffer[index];
+        if (senderIdLength > OSCORE_MAX_ID_LENGTH
+            || index + 1 + senderIdLength + 1 > length)
+        {
+            break;
+        }
+        senderId = buffer + index + 1;
+        index += 1 + senderIdLength;
+
+        recipientIdLength = buffer[index];
+        if (recipientIdLength > OSCORE_MAX_ID_LENGTH
+            || index + 1 + recipientIdLength + PRV_OSCORE_NONCE_LENGTH + 20 > length)
+        {
+            break;
+        }
+        recipientId = buffer + index + 1;
+        index += 1 + recipientIdLength;
+
+        commonIV = buffer + index;
+        index += PRV_OSCORE_NONCE_LENGTH;
+        utilsCopyValue(&senderSequenceNumber, buffer + index, 8);
+        utilsCopyValue(&replayHighest, buffer + index + 8, 8);
+        index += 20;
+
+        sequenceP = prv_sequenceGet(contextP, senderId, senderIdLength, recipientId, recipientIdLength, commonIV);
+        if (sequenceP == NULL)
+        {
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        if (senderSequenceNumber > sequenceP->senderSequenceNumber)
+        {
+            sequenceP->senderSequenceNumber = senderSequenceNumber;
+        }
+        // Messages received after the backup are unknown: only accept Partial IVs above the highest saved one.
+        if (replayHighest >= sequenceP->replayHighest)
+        {
+            sequenceP->replayHighest = replayHighest;
+            sequenceP->replayWindow = UINT32_MAX;
+        }
+    }
+
+    if (index != length)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Malformed OSCORE sequence number backup.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+size_t iowa_coap_oscore_save_callback(uint16_t callbackId,
+                                      uint8_t *buffer,
+                                      size_t bufferLength,
+                                      void *userDataP)
+{
+    iowa_context_t contextP;
+    size_t length;
+
+    (void)callbackId;
+
+    contextP = (iowa_context_t)userDataP;
+
+    CRIT_SECTION_ENTER(contextP);
+    length = oscore_sequenceBackup(contextP, buffer, bufferLength);
+    CRIT_SECTION_LEAVE(contextP);
+
+    return length;
+}
+
+void iowa_coap_oscore_load_callback(uint16_t callbackId,
+                                    uint8_t *buffer,
+                                    size_t bufferLength,
+                                    void *userDataP)
+{
+    iowa_context_t contextP;
+
+    (void)callbackId;
+
+    if (buffer == NULL)
+    {
+        return;
+    }
+
+    contextP = (iowa_context_t)userDataP;
+
+    CRIT_SECTION_ENTER(contextP);
+    (void)oscore_sequenceRestore(contextP, buffer, bufferLength);
+    CRIT_SECTION_LEAVE(contextP);
+}
+#endif // IOWA_STORAGE_CONTEXT_SUPPORT
+
+#endif // IOWA_COAP_OSCORE_SUPPORT
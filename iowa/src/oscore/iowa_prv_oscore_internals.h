@@ -42,64 +42,86 @@ extern "C" {
 
 #define PRV_OSCORE_VERSION 1
 
-#define PRV_OSCORE_ID_CONTEXT_LENGTH 8
+// Algorithms of the security contexts. See section 3.2 of RFC 8613.
+#define PRV_OSCORE_AEAD_ALGORITHM SECURITY_AEAD_AES_CCM_16_64_128
+#define PRV_OSCORE_HKDF_ALGORITHM SECURITY_HMAC_SHA256
 
-#define PRV_STATE_NEW_CLIENT       0
-#define PRV_STATE_NEW_SERVER       1
-#define PRV_STATE_CHALLENGE_CLIENT 2
-#define PRV_STATE_CHALLENGE_SERVER 3
-#define PRV_STATE_VALID            4
-
-#define COSE_AEAD_ALG_AES_CCM_16_64_128 10
+#define PRV_OSCORE_KEY_LENGTH    16
+#define PRV_OSCORE_NONCE_LENGTH  13
+#define PRV_OSCORE_TAG_LENGTH    8
+#define OSCORE_MAX_ID_LENGTH     (PRV_OSCORE_NONCE_LENGTH - 6)
 
 #define COSE_HKDF_TYPE_KEY 1
 #define COSE_HKDF_TYPE_IV  2
 
-#define PRV_INFO_LENGTH_KEY 16
-#define PRV_OSCORE_NONCE_LENGTH  13
-#define OSCORE_MAX_ID_LENGTH  7
+// The Partial IV is at most 5 bytes long.
+#define PRV_OSCORE_PARTIAL_IV_MAX_LENGTH 5
+#define PRV_OSCORE_SEQUENCE_NUMBER_MAX   0xFFFFFFFFFFU
 
-#define PRV_INCOMING false
-#define PRV_OUTGOING true
+// The largest OSCORE option value: flag byte, Partial IV and kid.
+#define PRV_OSCORE_OPTION_MAX_LENGTH (1 + PRV_OSCORE_PARTIAL_IV_MAX_LENGTH + OSCORE_MAX_ID_LENGTH)
 
-/************************************************
- * Macros
- */
+// Flag bits of the OSCORE option. See section 6.1 of RFC 8613.
+#define PRV_OSCORE_FLAG_PARTIAL_IV_MASK 0x07
+#define PRV_OSCORE_FLAG_KID             0x08
+#define PRV_OSCORE_FLAG_KID_CONTEXT     0x10
+#define PRV_OSCORE_FLAG_RESERVED_MASK   0xE0
 
+// Enc_structure with the external_aad of the largest identifiers.
+#define PRV_OSCORE_AAD_MAX_LENGTH 48
 
-/************************************************
- * Datatypes
- */
+// Number of Partial IVs tracked by the replay window.
+#define PRV_OSCORE_REPLAY_WINDOW_SIZE 32
 
-typedef struct
-{
-    iowa_coap_message_t *messageP;
-    iowa_buffer_t        payload;
-} challenge_data_t;
+// Sender Sequence Numbers possibly consumed after the last backup. Added to the restored value. See Appendix B.1.1 of RFC 8613.
+#define PRV_OSCORE_SEQUENCE_NUMBER_BACKUP_MARGIN 64
+
+// Number of request Partial IVs kept per peer. The oldest non-observe one is dropped when the limit is reached.
+#define PRV_OSCORE_MAX_REQUEST_IV 8
+
+#define PRV_INCOMING false
+#define PRV_OUTGOING true
 
+/************************************************
+* Datatypes
+*/
+
+// The Partial IV of a request, needed to protect or verify its responses.
 typedef struct _request_IV_t
 {
     struct _request_IV_t *next;
     uint64_t partialIV;
     bool     way;
-    bool     keep;
+    bool     keep;  // the request registered an observation
     uint8_t  tokenLength;
     uint8_t  token[COAP_MSG_TOKEN_MAX_LEN];
 } request_IV_t;
 
+// The mutable part of a security context. Kept in the CoAP context to outlive the peers and to be saved in the context backup.
+struct _oscore_sequence_t
+{
+    struct _oscore_sequence_t *next;
+    uint8_t  senderId[OSCORE_MAX_ID_LENGTH];
+    uint8_t  senderIdLength;
+    uint8_t  recipientId[OSCORE_MAX_ID_LENGTH];
+    uint8_t  recipientIdLength;
+    uint8_t  commonIV[PRV_OSCORE_NONCE_LENGTH]; // identifies the key material
+    uint64_t senderSequenceNumber;
+    uint64_t replayHighest;                     // the highest Partial IV received from the peer
+    uint32_t replayWindow;                      // bit i is set when Partial IV (replayHighest - i) was received
+};
+
 struct _oscore_peer_context_t
 {
-    uint8_t           state;
-    iowa_buffer_t     masterSecret;
-    iowa_buffer_t     senderId;
-    iowa_buffer_t     senderKey;
-    iowa_buffer_t     recipientId;
-    iowa_buffer_t     recipientKey;
-    iowa_buffer_t     idContext;
-    iowa_buffer_t     commonIV;
-    uint64_t          senderSequenceNumber;
-    request_IV_t     *requestList;
-    challenge_data_t *challengeDataP;
+    uint8_t            senderId[OSCORE_MAX_ID_LENGTH];
+    uint8_t            senderIdLength;
+    uint8_t            recipientId[OSCORE_MAX_ID_LENGTH];
+    uint8_t            recipientIdLength;
+    uint8_t            senderKey[PRV_OSCORE_KEY_LENGTH];
+    uint8_t            recipientKey[PRV_OSCORE_KEY_LENGTH];
+    uint8_t            commonIV[PRV_OSCORE_NONCE_LENGTH];
+    oscore_sequence_t *sequenceP;
+    request_IV_t      *requestList;
 };
 
 /************************************************
@@ -108,70 +130,87 @@ struct _oscore_peer_context_t
 
 // Implemented in iowa_cose.c
 
-// Compute a Nonce according to section 5.2 of RFC 8613.
-// Returned value: The nonce.
+// Encode a Partial IV with the minimal number of bytes. Zero is encoded as one byte.
+// Returned value: The length of the encoded Partial IV.
 // Parameters:
-// - id: The ID linked to the partial IV.
 // - partialIV: The partial IV.
-// - commonIV: The common IV.
-iowa_buffer_t oscore_coseComputeNonce(iowa_buffer_t id,
-                                      uint64_t partialIV,
-                                      iowa_buffer_t commonIV);
+// - buffer: OUT. A buffer of PRV_OSCORE_PARTIAL_IV_MAX_LENGTH bytes to store the encoded partial IV.
+size_t oscore_coseEncodePartialIV(uint64_t partialIV,
+                                  uint8_t *buffer);
 
-// Compute an AAD according to section 5.4 of RFC 8613.
-// Returned value: The AAD.
+// Compute a Nonce according to section 5.2 of RFC 8613.
+// Returned value: None.
 // Parameters:
-// - id: The ID linked to the partial IV.
+// - id, idLength: The ID linked to the partial IV.
 // - partialIV: The partial IV.
-// - options: The serialized Class I CoAP options IV.
-iowa_buffer_t oscore_coseComputeAAD(iowa_buffer_t id,
-                                    uint64_t partialIV,
-                                    iowa_buffer_t options);
-
-// Use HKDF to derive a key.
+// - commonIV: The common IV.
+// - nonce: OUT. A buffer of PRV_OSCORE_NONCE_LENGTH bytes to store the nonce.
+void oscore_coseComputeNonce(const uint8_t *id,
+                             size_t idLength,
+                             uint64_t partialIV,
+                             const uint8_t *commonIV,
+                             uint8_t *nonce);
+
+// Compute an AAD according to section 5.4 of RFC 8613. The Class I options are always empty.
+// Returned value: The length of the AAD or zero in case of error.
+// Parameters:
+// - requestKid, requestKidLength: The kid of the request.
+// - requestPartialIV: The partial IV of the request.
+// - aad: OUT. A buffer of PRV_OSCORE_AAD_MAX_LENGTH bytes to store the AAD.
+size_t oscore_coseComputeAAD(const uint8_t *requestKid,
+                             size_t requestKidLength,
+                             uint64_t requestPartialIV,
+                             uint8_t *aad);
+
+// Use HKDF to derive a key or the common IV according to section 3.2.1 of RFC 8613.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
-// - ikm: The Input Keying Material.
-// - context: The ID Context to use.
-// - type: The type of key to derive.
-// - id: The id to derive a key for.
-// - keyP: OUT. The derived key.
-// - aadP: OUT. The generated Additional Authenticated Data.
-iowa_status_t oscore_coseDeriveKey(iowa_buffer_t ikm,
-                                   iowa_buffer_t context,
+// - masterSecret, masterSecretLength: The Master Secret.
+// - masterSalt, masterSaltLength: The Master Salt. This can be nil.
+// - type: The type of key to derive (COSE_HKDF_TYPE_KEY or COSE_HKDF_TYPE_IV).
+// - id, idLength: The id to derive a key for. This is empty for the common IV.
+// - output, outputLength: OUT. The derived key.
+iowa_status_t oscore_coseDeriveKey(const uint8_t *masterSecret,
+                                   size_t masterSecretLength,
+                                   const uint8_t *masterSalt,
+                                   size_t masterSaltLength,
                                    uint8_t type,
-                                   iowa_buffer_t id,
-                                   iowa_buffer_t *keyP,
-                                   iowa_buffer_t *aadP);
+                                   const uint8_t *id,
+                                   size_t idLength,
+                                   uint8_t *output,
+                                   size_t outputLength);
 
-// Encrypt a buffer.
+// Encrypt a buffer. The ciphertext and the tag are produced by a single AEAD operation.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - key: The key to use to encrypt.
 // - nonce: The nonce to use to encrypt.
-// - aad: The Additional Authenticated Data to use to encrypt.
-// - plainBuffer: The data to encrypt.
-// - encryptedBufferP: To store the encrypted data.
-iowa_status_t oscore_coseEncrypt(iowa_buffer_t key,
-                                 iowa_buffer_t nonce,
-                                 iowa_buffer_t aad,
-                                 iowa_buffer_t plainBuffer,
-                                 iowa_buffer_t *encryptedBufferP);
+// - aad, aadLength: The Additional Authenticated Data to use to encrypt.
+// - plainBuffer, plainLength: The data to encrypt.
+// - encryptedBuffer: OUT. A buffer of plainLength + PRV_OSCORE_TAG_LENGTH bytes to store the ciphertext followed by the tag.
+iowa_status_t oscore_coseEncrypt(const uint8_t *key,
+                                 const uint8_t *nonce,
+                                 const uint8_t *aad,
+                                 size_t aadLength,
+                                 const uint8_t *plainBuffer,
+                                 size_t plainLength,
+                                 uint8_t *encryptedBuffer);
 
 // Decrypt a buffer.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - key: The key to use to decrypt.
 // - nonce: The nonce to use to decrypt.
-// - aad: The Additional Authenticated Data to use to encrypt.
-// - encryptedBuffer: The data to decrypt.
-// - plainBufferP: To store the decrypted data.
-iowa_status_t oscore_coseDecrypt(iowa_buffer_t key,
-                                 iowa_buffer_t nonce,
-                                 iowa_buffer_t aad,
-                                 iowa_buffer_t encryptedBuffer,
-                                 iowa_buffer_t *plainBufferP);
-
+// - aad, aadLength: The Additional Authenticated Data to use to decrypt.
+// - encryptedBuffer, encryptedLength: The ciphertext followed by the tag.
+// - plainBuffer: OUT. A buffer of encryptedLength - PRV_OSCORE_TAG_LENGTH bytes to store the decrypted data.
+iowa_status_t oscore_coseDecrypt(const uint8_t *key,
+                                 const uint8_t *nonce,
+                                 const uint8_t *aad,
+                                 size_t aadLength,
+                                 const uint8_t *encryptedBuffer,
+                                 size_t encryptedLength,
+                                 uint8_t *plainBuffer);
 
 #ifdef __cplusplus
 }
@@ -233,7 +233,7 @@ static int prv_tinydtlsVerifyRpkCallback(struct dtls_context_t *dtlsContext,
 static void prv_connectionFailing(iowa_security_session_t securityS)
 {
     tinydtlsDisconnect(securityS);
-    securityS->contextP->timeout = 0;
+    securityScheduleStep(securityS, 0);
     securityS->state = SECURITY_STATE_CONNECTION_FAILED;
     SESSION_CALL_EVENT_CALLBACK(securityS, SECURITY_EVENT_DISCONNECTED);
 }
@@ -422,7 +422,7 @@ iowa_status_t tinydtlsStep(iowa_security_session_t securityS)
             }
 
             securityS->state = SECURITY_STATE_HANDSHAKING;
-            securityS->contextP->timeout = 0;
+            securityScheduleStep(securityS, 0);
         }
         break;
     }
@@ -455,7 +455,7 @@ iowa_status_t tinydtlsStep(iowa_security_session_t securityS)
 
         case DTLS_STATE_CONNECTED:
             IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Handshake done.");
-            securityS->contextP->timeout = 0;
+            securityScheduleStep(securityS, 0);
             securityS->state = SECURITY_STATE_CONNECTED;
             SESSION_CALL_EVENT_CALLBACK(securityS, SECURITY_EVENT_CONNECTED);
             break;
@@ -476,10 +476,7 @@ iowa_status_t tinydtlsStep(iowa_security_session_t securityS)
                 currentTime = iowa_system_gettime();
                 delay = nextTime - currentTime;
 
-                if (delay < securityS->contextP->timeout)
-                {
-                    securityS->contextP->timeout = delay;
-                }
+                securityScheduleStep(securityS, delay);
             }
         }
         }
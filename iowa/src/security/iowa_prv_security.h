@@ -124,16 +124,20 @@ iowa_security_session_t securityClientNewSession(iowa_context_t contextP,
                                                  iowa_security_mode_t securityMode);
 
 // Initialize a new security session (server side).
-// Returned value: A new initialized security session or null in case of error.
+// Returned value: IOWA_COAP_NO_ERROR in case of success, IOWA_COAP_503_SERVICE_UNAVAILABLE if the
+// handshake is deferred by the admission control, IOWA_COAP_400_BAD_REQUEST if the first datagram
+// is not a DTLS ClientHello, or an error status.
 // Parameters:
 // - contextP: returned by iowa_init().
 // - type: the connection type.
 // - connP: the connection as returned by iowa_system_connection_open().
 // - isSecure: inform if the connection is secure.
-iowa_security_session_t securityServerNewSession(iowa_context_t contextP,
-                                                 iowa_connection_type_t type,
-                                                 void *connP,
-                                                 bool isSecure);
+// - securitySP: OUT. the new initialized security session.
+iowa_status_t securityServerNewSession(iowa_context_t contextP,
+                                       iowa_connection_type_t type,
+                                       void *connP,
+                                       bool isSecure,
+                                       iowa_security_session_t *securitySP);
 
 // Close a security session.
 // Parameters:
@@ -211,6 +215,16 @@ size_t securityGetIdentity(iowa_context_t contextP,
                            uint8_t *buffer,
                            size_t length);
 
+// Set the DTLS Connection ID the peer of a secure connection puts in its records (server side).
+// A datagram carrying this Connection ID is routed to this session even if it comes from a new address.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - securityS: the secure connection.
+// - connectionId, length: the Connection ID. A zero length removes it.
+iowa_status_t securitySetConnectionId(iowa_security_session_t securityS,
+                                      const uint8_t *connectionId,
+                                      size_t length);
+
 // Get the connection platform of a Security session.
 // Returned value: the connP.
 // Parameters:
@@ -242,6 +256,55 @@ iowa_status_t securityAddKey(iowa_context_t contextP,
 iowa_status_t securityRemoveKey(iowa_context_t contextP,
                                 const char *uri);
 
+// Store the data allowing to resume the secure session with a peer (client side).
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - uri: the URI of the peer.
+// - buffer, length: the session data. They are copied.
+iowa_status_t securityResumptionSet(iowa_context_t contextP,
+                                    const char *uri,
+                                    const uint8_t *buffer,
+                                    size_t length);
+
+// Retrieve the data allowing to resume the secure session with a peer (client side).
+// Returned value: the length of the session data or zero if none is stored.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - uri: the URI of the peer.
+// - bufferP: OUT. the session data. Valid until the next call to securityResumptionSet() or securityResumptionClear().
+size_t securityResumptionGet(iowa_context_t contextP,
+                             const char *uri,
+                             const uint8_t **bufferP);
+
+// Remove the data allowing to resume the secure session with a peer (client side).
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - uri: the URI of the peer.
+void securityResumptionClear(iowa_context_t contextP,
+                             const char *uri);
+
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+// Serialize all the stored session resumption data.
+// Returned value: the length of the serialized data or zero in case of error.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - buffer, length: the buffer to store the data. When nil, only the required length is computed.
+size_t securityResumptionBackup(iowa_context_t contextP,
+                                uint8_t *buffer,
+                                size_t length);
+
+// Replace the stored session resumption data with data serialized by securityResumptionBackup().
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - buffer, length: the serialized data.
+iowa_status_t securityResumptionRestore(iowa_context_t contextP,
+                                        const uint8_t *buffer,
+                                        size_t length);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -88,21 +88,69 @@ extern "C" {
 ((M) == MBEDTLS_SSL_SERVER_HELLO_VERIFY_REQUEST_SENT ? "MBEDTLS_SSL_SERVER_HELLO_VERIFY_REQUEST_SENT" : \
 "Unknown")))))))))))))))))))
 
+#ifdef IOWA_METRICS_SUPPORT
+#define SESSION_RECORD_HANDSHAKE_DURATION(S, E)                                                      \
+    if ((E) == SECURITY_EVENT_CONNECTED                                                              \
+        && (S)->handshakeStartTime != 0)                                                             \
+    {                                                                                                \
+        CORE_METRICS_RECORD_DURATION((S)->contextP, handshakeDuration, (S)->handshakeStartTime);     \
+        (S)->handshakeStartTime = 0;                                                                 \
+    }
+#else
+#define SESSION_RECORD_HANDSHAKE_DURATION(S, E)
+#endif
+
 #define SESSION_CALL_EVENT_CALLBACK(S, E)                       \
     if ((S)->eventCb != NULL)                                   \
     {                                                           \
+        SESSION_RECORD_HANDSHAKE_DURATION((S), (E));            \
         (S)->eventCb((S), (E), (S)->userDataCb, (S)->contextP); \
     }
 
+// Value of the step times when no call to the security layer step is scheduled
+#define SECURITY_STEP_TIME_NONE -1
+
 #define MBEDTLS_CONN_ID_LENGTH 8
 
+// Maximum length of the DTLS Connection ID a security session can be found by
+#define SECURITY_CONNECTION_ID_MAX_LENGTH 32
+
+#ifdef IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+// Length of the DTLS cookies sent in the HelloVerifyRequests and of the key they are computed with
+#define SECURITY_COOKIE_LENGTH        16
+#define SECURITY_COOKIE_SECRET_LENGTH 32
+#endif
+
 /**************************************************************
 * Structures
 */
 
+#ifdef IOWA_SECURITY_CLIENT_MODE
+// The data allowing to resume the secure session with a peer without a full handshake
+typedef struct _security_resumption_t
+{
+    struct _security_resumption_t *nextP;
+    char                          *uri;
+    uint8_t                       *data;
+    size_t                         dataLength;
+} security_resumption_t;
+#endif
+
 struct _iowa_security_context_t
 {
     iowa_security_session_t sessionList;
+    int32_t                 nextStepTime; // the earliest step time of the sessions, or SECURITY_STEP_TIME_NONE
+#ifdef IOWA_SECURITY_CLIENT_MODE
+    security_resumption_t  *resumptionList;
+#endif
+#ifdef IOWA_SECURITY_SERVER_MODE
+    iowa_security_handshake_stats_t handshakeStats;
+    uint8_t                 connectionIdLength; // the length of all the DTLS Connection IDs, 0 until one is set
+#ifdef IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+    bool                    isCookieSecretSet;
+    uint8_t                 cookieSecret[SECURITY_COOKIE_SECRET_LENGTH]; // drawn when the first cookie is computed
+#endif
+#endif
 };
 
 struct _iowa_security_session_t
@@ -117,9 +165,20 @@ struct _iowa_security_session_t
     bool                            isSecure;
     iowa_security_state_t           state;
     uint16_t                        shortServerID;
+    int32_t                         stepTime; // when the security layer step must be called, or SECURITY_STEP_TIME_NONE
+#ifdef IOWA_METRICS_SUPPORT
+    uint64_t                        handshakeStartTime; // as returned by iowa_system_gettime_us(), 0 when no handshake is ongoing
+#endif
 #ifdef IOWA_SECURITY_CLIENT_MODE
     iowa_security_mode_t            securityMode;
 #endif
+#ifdef IOWA_SECURITY_SERVER_MODE
+    uint8_t                         connectionId[SECURITY_CONNECTION_ID_MAX_LENGTH]; // DTLS Connection ID the peer uses to reach us
+    uint8_t                         connectionIdLength;
+    comm_channel_t                 *migrationChannelP; // new address of the peer, adopted once a record received on it is authenticated
+    bool                            handshakeSlot;    // the session counts in the ongoing handshakes
+    bool                            handshakePending; // a handshake packet waits for the next step
+#endif
 #if (IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_MBEDTLS) || (IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_MBEDTLS_PSK_ONLY)
     // Common
     mbedtls_ssl_context      sslContext;
@@ -151,6 +210,26 @@ struct _iowa_security_session_t
 #endif // IOWA_SECURITY_LAYER
 };
 
+/**************************************************************
+* Security sessions scheduling
+**************************************************************/
+
+// Schedule a call to the security layer step for a session. The earliest scheduled time is kept.
+// Returned value: none.
+// Parameters:
+// - securityS: a security session.
+// - delay: the time in seconds before the step. Negative values are ignored.
+void securityScheduleStep(iowa_security_session_t securityS,
+                          int32_t delay);
+
+#ifdef IOWA_SECURITY_SERVER_MODE
+// Stop counting a session in the ongoing handshakes. Called when the session leaves the handshake states.
+// Returned value: none.
+// Parameters:
+// - securityS: a security session.
+void securityReleaseHandshakeSlot(iowa_security_session_t securityS);
+#endif
+
 /**************************************************************
 * Security layers API
 **************************************************************/
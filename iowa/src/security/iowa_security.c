@@ -25,6 +25,485 @@
 ** Private functions
 *************************************************************************************/
 
+#if defined(IOWA_SECURITY_SERVER_MODE) && defined(IOWA_UDP_SUPPORT) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE)
+// A DTLS 1.2 record carrying a Connection ID (RFC 9146) starts with:
+// content type (1 byte), version (2 bytes), epoch (2 bytes), sequence number (6 bytes), Connection ID (variable), length (2 bytes)
+#define PRV_DTLS_CONTENT_TYPE_TLS12_CID 25
+#define PRV_DTLS_CID_OFFSET             11
+#define PRV_DTLS_LENGTH_SIZE            2
+// Room for the DTLS record header, the Connection ID, the IV, the MAC and the padding around a IOWA_BUFFER_SIZE payload
+#define PRV_DTLS_RECORD_MAX_OVERHEAD    128
+
+// Find the connected session a tls12_cid record is for. All the Connection IDs of a context have the same length.
+static iowa_security_session_t prv_findSessionByConnectionId(iowa_context_t contextP,
+                                                             iowa_security_session_t fromSessionP,
+                                                             uint8_t *buffer,
+                                                             size_t length)
+{
+    iowa_security_session_t securityS;
+    size_t connectionIdLength;
+    size_t recordLength;
+
+    connectionIdLength = contextP->securityContextP->connectionIdLength;
+
+    if (connectionIdLength == 0
+        || length < PRV_DTLS_CID_OFFSET + connectionIdLength + PRV_DTLS_LENGTH_SIZE
+        || buffer[0] != PRV_DTLS_CONTENT_TYPE_TLS12_CID)
+    {
+        return NULL;
+    }
+
+    recordLength = ((size_t)buffer[PRV_DTLS_CID_OFFSET + connectionIdLength] << 8) | buffer[PRV_DTLS_CID_OFFSET + connectionIdLength + 1];
+    if (recordLength == 0
+        || recordLength > length - (PRV_DTLS_CID_OFFSET + connectionIdLength + PRV_DTLS_LENGTH_SIZE))
+    {
+        return NULL;
+    }
+
+    securityS = contextP->securityContextP->sessionList;
+    while (securityS != NULL)
+    {
+        if (securityS != fromSessionP
+            && securityS->connectionIdLength == connectionIdLength
+            && securityS->type == IOWA_CONN_DATAGRAM
+            && securityS->state == SECURITY_STATE_CONNECTED
+            && securityS->migrationChannelP == NULL
+            && memcmp(buffer + PRV_DTLS_CID_OFFSET, securityS->connectionId, connectionIdLength) == 0)
+        {
+            break;
+        }
+        securityS = securityS->nextP;
+    }
+
+    return securityS;
+}
+
+// Adopt or drop the new address of a peer once the record received on it went through the security layer.
+// Parameters:
+// - securityS: a session with a migrationChannelP.
+// - isAuthenticated: if the security layer accepted the record.
+static void prv_endMigration(iowa_context_t contextP,
+                             iowa_security_session_t securityS,
+                             bool isAuthenticated)
+{
+    // WARNING: This function is called in a critical section
+    comm_channel_t *channelP;
+
+    channelP = securityS->migrationChannelP;
+    securityS->migrationChannelP = NULL;
+
+    if (isAuthenticated == true)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Session %p authenticated a record from a new address. Moving the peer to it.", securityS);
+
+        // Update the existing channel in place with the new connection
+        commChannelMove(contextP, securityS->channelP, channelP);
+    }
+    else
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_SECURITY, "Session %p rejected a record with its Connection ID from a new address. Keeping the previous address.", securityS);
+
+        commChannelDelete(contextP, channelP);
+    }
+}
+
+// Check if the first datagram of a new session belongs to an existing session whose peer changed its address.
+// The datagram is given to the existing session, which moves to the new address only if its security layer authenticates the record.
+// Returned value: true if the datagram was given to the existing session. In this case, the new session is disconnected and must not be accessed anymore.
+static bool prv_routeByConnectionId(iowa_context_t contextP,
+                                    iowa_security_session_t securityS)
+{
+    // WARNING: This function is called in a critical section
+    iowa_security_session_t targetS;
+    comm_channel_t *channelP;
+    uint8_t *buffer;
+    int length;
+
+    // Only read the datagram if a session can be found by its Connection ID
+    if (securityS->type != IOWA_CONN_DATAGRAM
+        || securityS->isSecure == false
+        || securityS->channelP == NULL
+        || contextP->securityContextP->connectionIdLength == 0)
+    {
+        return false;
+    }
+
+    buffer = (uint8_t *)iowa_system_malloc(IOWA_BUFFER_SIZE + PRV_DTLS_RECORD_MAX_OVERHEAD);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(IOWA_BUFFER_SIZE + PRV_DTLS_RECORD_MAX_OVERHEAD);
+        return false;
+    }
+#endif
+
+    length = commRecv(contextP, securityS->channelP, buffer, IOWA_BUFFER_SIZE + PRV_DTLS_RECORD_MAX_OVERHEAD);
+    if (length <= 0)
+    {
+        iowa_system_free(buffer);
+        return false;
+    }
+
+    targetS = prv_findSessionByConnectionId(contextP, securityS, buffer, (size_t)length);
+
+    // Either way, the datagram is read again by the security layer
+    if (commChannelPushBack(contextP, securityS->channelP, buffer, (size_t)length) != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_SECURITY, "Failed to keep the received datagram. Dropping it.");
+        iowa_system_free(buffer);
+        return false;
+    }
+    iowa_system_free(buffer);
+
+    if (targetS == NULL)
+    {
+        return false;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Session %p received the Connection ID of session %p. Handing the record to it.", securityS, targetS);
+
+    // The new connection is kept aside while the existing session reads the record through its security layer
+    channelP = securityS->channelP;
+    securityS->channelP = NULL;
+    securityS->state = SECURITY_STATE_DISCONNECTED;
+    securityReleaseHandshakeSlot(securityS);
+
+    channelP->userData = targetS;
+    targetS->migrationChannelP = channelP;
+
+    targetS->channelP->eventCallback(targetS->channelP, COMM_EVENT_DATA_AVAILABLE, targetS->channelP->userData, contextP);
+
+    // The session may not have read the record. Don't use 'targetS' as the callback could have removed it.
+    targetS = contextP->securityContextP->sessionList;
+    while (targetS != NULL
+           && targetS->migrationChannelP != channelP)
+    {
+        targetS = targetS->nextP;
+    }
+    if (targetS != NULL)
+    {
+        prv_endMigration(contextP, targetS, false);
+    }
+
+    // After the session event callback, don't try to access 'securityS' pointer since the callback could have removed it.
+    SESSION_CALL_EVENT_CALLBACK(securityS, SECURITY_EVENT_DISCONNECTED);
+
+    return true;
+}
+
+// A DTLS ClientHello starts with:
+// record header: content type (1 byte), version (2 bytes), epoch (2 bytes), sequence number (6 bytes), length (2 bytes)
+// handshake header: message type (1 byte), length (3 bytes), message sequence (2 bytes), fragment offset (3 bytes), fragment length (3 bytes)
+// body: version (2 bytes), random (32 bytes), session ID (1 + up to 32 bytes), cookie (1 + up to 255 bytes), ...
+#define PRV_DTLS_CONTENT_TYPE_HANDSHAKE   22
+#define PRV_DTLS_VERSION_MAJOR            0xFE
+#define PRV_DTLS_VERSION_1_0_MINOR        0xFF
+#define PRV_DTLS_RECORD_HEADER_SIZE       13
+#define PRV_DTLS_HANDSHAKE_HEADER_SIZE    12
+#define PRV_DTLS_HANDSHAKE_CLIENT_HELLO   1
+#define PRV_DTLS_CLIENT_HELLO_RANDOM_END  34
+#define PRV_DTLS_SESSION_ID_MAX_LENGTH    32
+
+// Stateless check that a datagram can start a DTLS handshake. The cookie is only checked to be well-formed here.
+// Returned value: true if the datagram carries the first fragment of a ClientHello in epoch 0.
+// Parameters:
+// - buffer, length: the datagram.
+// - cookieOffsetP: OUT. the offset in buffer of the cookie length byte.
+static bool prv_parseClientHello(const uint8_t *buffer,
+                                 size_t length,
+                                 size_t *cookieOffsetP)
+{
+    size_t recordLength;
+    size_t fragmentLength;
+    size_t offset;
+
+    if (length < PRV_DTLS_RECORD_HEADER_SIZE + PRV_DTLS_HANDSHAKE_HEADER_SIZE + PRV_DTLS_CLIENT_HELLO_RANDOM_END + 2
+        || buffer[0] != PRV_DTLS_CONTENT_TYPE_HANDSHAKE
+        || buffer[1] != PRV_DTLS_VERSION_MAJOR
+        || buffer[3] != 0
+        || buffer[4] != 0)
+    {
+        return false;
+    }
+
+    recordLength = ((size_t)buffer[11] << 8) | buffer[12];
+    if (recordLength > length - PRV_DTLS_RECORD_HEADER_SIZE)
+    {
+        return false;
+    }
+    buffer += PRV_DTLS_RECORD_HEADER_SIZE;
+
+    fragmentLength = ((size_t)buffer[9] << 16) | ((size_t)buffer[10] << 8) | buffer[11];
+    if (buffer[0] != PRV_DTLS_HANDSHAKE_CLIENT_HELLO
+        || buffer[6] != 0
+        || buffer[7] != 0
+        || buffer[8] != 0
+        || fragmentLength > recordLength - PRV_DTLS_HANDSHAKE_HEADER_SIZE)
+    {
+        return false;
+    }
+    buffer += PRV_DTLS_HANDSHAKE_HEADER_SIZE;
+
+    // Session ID and cookie must fit in the fragment
+    offset = PRV_DTLS_CLIENT_HELLO_RANDOM_END;
+    if (offset + 1 > fragmentLength
+        || buffer[offset] > PRV_DTLS_SESSION_ID_MAX_LENGTH)
+    {
+        return false;
+    }
+    offset += 1 + (size_t)buffer[offset];
+    if (offset + 1 > fragmentLength)
+    {
+        return false;
+    }
+    *cookieOffsetP = PRV_DTLS_RECORD_HEADER_SIZE + PRV_DTLS_HANDSHAKE_HEADER_SIZE + offset;
+    offset += 1 + (size_t)buffer[offset];
+
+    return offset <= fragmentLength;
+}
+
+#ifdef IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+// A DTLS HelloVerifyRequest carries: server version (2 bytes), cookie length (1 byte), cookie
+#define PRV_DTLS_HANDSHAKE_HELLO_VERIFY_REQUEST 3
+#define PRV_DTLS_HELLO_VERIFY_REQUEST_SIZE      (PRV_DTLS_RECORD_HEADER_SIZE + PRV_DTLS_HANDSHAKE_HEADER_SIZE + 3 + SECURITY_COOKIE_LENGTH)
+#define PRV_DTLS_PEER_IDENTIFIER_MAX_LENGTH     64
+
+// Compute the cookie of a ClientHello: a keyed hash of the peer identifier and of the ClientHello body without its cookie (RFC 6347 section 4.2.1).
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - connP: the connection the ClientHello was received on.
+// - buffer, length: the datagram checked by prv_parseClientHello().
+// - cookieOffset: returned by prv_parseClientHello().
+// - cookie: OUT. a buffer of SECURITY_COOKIE_LENGTH bytes.
+static iowa_status_t prv_computeCookie(iowa_context_t contextP,
+                                       void *connP,
+                                       const uint8_t *buffer,
+                                       size_t length,
+                                       size_t cookieOffset,
+                                       uint8_t *cookie)
+{
+    // WARNING: This function is called in a critical section
+    iowa_security_context_t securityContextP;
+    uint8_t *infoP;
+    size_t infoLength;
+    size_t bodyOffset;
+    size_t fragmentEnd;
+    size_t cookieEnd;
+    iowa_status_t result;
+
+    securityContextP = contextP->securityContextP;
+
+    if (securityContextP->isCookieSecretSet == false)
+    {
+        CRIT_SECTION_LEAVE(contextP);
+        result = (iowa_system_random_vector_generator(securityContextP->cookieSecret, SECURITY_COOKIE_SECRET_LENGTH, contextP->userData) == 0) ? IOWA_COAP_NO_ERROR : IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        CRIT_SECTION_ENTER(contextP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "iowa_system_random_vector_generator() failed. Cannot generate the cookie secret.");
+            return result;
+        }
+        securityContextP->isCookieSecretSet = true;
+    }
+
+    bodyOffset = PRV_DTLS_RECORD_HEADER_SIZE + PRV_DTLS_HANDSHAKE_HEADER_SIZE;
+    fragmentEnd = bodyOffset + (((size_t)buffer[PRV_DTLS_RECORD_HEADER_SIZE + 9] << 16) | ((size_t)buffer[PRV_DTLS_RECORD_HEADER_SIZE + 10] << 8) | buffer[PRV_DTLS_RECORD_HEADER_SIZE + 11]);
+    cookieEnd = cookieOffset + 1 + buffer[cookieOffset];
+
+    infoP = (uint8_t *)iowa_system_malloc(PRV_DTLS_PEER_IDENTIFIER_MAX_LENGTH + length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (infoP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(PRV_DTLS_PEER_IDENTIFIER_MAX_LENGTH + length);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    CRIT_SECTION_LEAVE(contextP);
+    infoLength = iowa_system_connection_get_peer_identifier(connP, infoP, PRV_DTLS_PEER_IDENTIFIER_MAX_LENGTH, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+    if (infoLength == 0
+        || infoLength > PRV_DTLS_PEER_IDENTIFIER_MAX_LENGTH)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Cannot retrieve the peer identifier of the connection.");
+        iowa_system_free(infoP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    memcpy(infoP + infoLength, buffer + bodyOffset, cookieOffset - bodyOffset);
+    infoLength += cookieOffset - bodyOffset;
+    memcpy(infoP + infoLength, buffer + cookieEnd, fragmentEnd - cookieEnd);
+    infoLength += fragmentEnd - cookieEnd;
+
+    result = iowa_user_security_HKDF(SECURITY_HMAC_SHA256,
+                                     securityContextP->cookieSecret, SECURITY_COOKIE_SECRET_LENGTH,
+                                     NULL, 0,
+                                     infoP, infoLength,
+                                     cookie, SECURITY_COOKIE_LENGTH);
+    iowa_system_free(infoP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SECURITY, "iowa_user_security_HKDF() failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+    }
+
+    return result;
+}
+
+// Answer a ClientHello without cookie with a HelloVerifyRequest, without creating any state for the peer.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - connP: the connection the ClientHello was received on.
+// - clientHello: the ClientHello datagram checked by prv_parseClientHello().
+// - cookie: the cookie computed by prv_computeCookie().
+static iowa_status_t prv_sendHelloVerifyRequest(iowa_context_t contextP,
+                                                void *connP,
+                                                const uint8_t *clientHello,
+                                                const uint8_t *cookie)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t buffer[PRV_DTLS_HELLO_VERIFY_REQUEST_SIZE];
+    uint8_t *handshakeP;
+    int result;
+
+    // The record sequence number and the message sequence are the ones of the ClientHello (RFC 6347 section 4.2.1).
+    // The version is DTLS 1.0 whatever the version negotiated later.
+    memcpy(buffer, clientHello, PRV_DTLS_RECORD_HEADER_SIZE);
+    buffer[1] = PRV_DTLS_VERSION_MAJOR;
+    buffer[2] = PRV_DTLS_VERSION_1_0_MINOR;
+    buffer[11] = 0;
+    buffer[12] = PRV_DTLS_HANDSHAKE_HEADER_SIZE + 3 + SECURITY_COOKIE_LENGTH;
+
+    handshakeP = buffer + PRV_DTLS_RECORD_HEADER_SIZE;
+    handshakeP[0] = PRV_DTLS_HANDSHAKE_HELLO_VERIFY_REQUEST;
+    handshakeP[1] = 0;
+    handshakeP[2] = 0;
+    handshakeP[3] = 3 + SECURITY_COOKIE_LENGTH;
+    handshakeP[4] = clientHello[PRV_DTLS_RECORD_HEADER_SIZE + 4];
+    handshakeP[5] = clientHello[PRV_DTLS_RECORD_HEADER_SIZE + 5];
+    memset(handshakeP + 6, 0, 3);
+    memcpy(handshakeP + 9, handshakeP + 1, 3);
+
+    handshakeP += PRV_DTLS_HANDSHAKE_HEADER_SIZE;
+    handshakeP[0] = PRV_DTLS_VERSION_MAJOR;
+    handshakeP[1] = PRV_DTLS_VERSION_1_0_MINOR;
+    handshakeP[2] = SECURITY_COOKIE_LENGTH;
+    memcpy(handshakeP + 3, cookie, SECURITY_COOKIE_LENGTH);
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_send(connP, buffer, sizeof(buffer), contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "iowa_system_connection_send() returned %d.", result);
+
+    return (result == (int)sizeof(buffer)) ? IOWA_COAP_NO_ERROR : IOWA_COAP_503_SERVICE_UNAVAILABLE;
+}
+
+// Check the cookie of a ClientHello in constant time.
+// Returned value: IOWA_COAP_NO_ERROR if the cookie is the one sent in the HelloVerifyRequest, IOWA_COAP_400_BAD_REQUEST if not, or an error status.
+static iowa_status_t prv_checkCookie(iowa_context_t contextP,
+                                     void *connP,
+                                     const uint8_t *buffer,
+                                     size_t length,
+                                     size_t cookieOffset)
+{
+    // WARNING: This function is called in a critical section
+    uint8_t cookie[SECURITY_COOKIE_LENGTH];
+    uint8_t difference;
+    size_t i;
+    iowa_status_t result;
+
+    if (buffer[cookieOffset] != SECURITY_COOKIE_LENGTH)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    result = prv_computeCookie(contextP, connP, buffer, length, cookieOffset, cookie);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    difference = 0;
+    for (i = 0; i < SECURITY_COOKIE_LENGTH; i++)
+    {
+        difference |= (uint8_t)(cookie[i] ^ buffer[cookieOffset + 1 + i]);
+    }
+
+    return (difference == 0) ? IOWA_COAP_NO_ERROR : IOWA_COAP_400_BAD_REQUEST;
+}
+#endif // IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+
+// Read the first datagram of a new connection.
+// Returned value: the datagram length. If positive, bufferP must be freed by the caller.
+static int prv_readFirstDatagram(iowa_context_t contextP,
+                                 void *connP,
+                                 uint8_t **bufferP)
+{
+    // WARNING: This function is called in a critical section
+    int length;
+
+    *bufferP = (uint8_t *)iowa_system_malloc(IOWA_BUFFER_SIZE + PRV_DTLS_RECORD_MAX_OVERHEAD);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(IOWA_BUFFER_SIZE + PRV_DTLS_RECORD_MAX_OVERHEAD);
+        return -1;
+    }
+#endif
+
+    CRIT_SECTION_LEAVE(contextP);
+    length = iowa_system_connection_recv(connP, *bufferP, IOWA_BUFFER_SIZE + PRV_DTLS_RECORD_MAX_OVERHEAD, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "iowa_system_connection_recv() returned %d.", length);
+
+    if (length <= 0)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+    }
+
+    return length;
+}
+#endif
+
+#if IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE
+static void prv_handleHandshakePacket(iowa_context_t contextP,
+                                      iowa_security_session_t securityS)
+{
+    (void)contextP;
+
+    switch (securityS->state)
+    {
+#ifdef IOWA_SECURITY_SERVER_MODE
+    case SECURITY_STATE_INIT_HANDSHAKE:
+#ifdef IOWA_UDP_SUPPORT
+        if (prv_routeByConnectionId(contextP, securityS) == true)
+        {
+            break;
+        }
+#endif
+        securityS->state = SECURITY_STATE_HANDSHAKING;
+        // Fall through
+#endif
+    case SECURITY_STATE_HANDSHAKING:
+        // Security mode cannot be none on Handshaking
+        // The handshake may progress with this packet. Scheduled before as the session could be removed by the layer.
+        securityScheduleStep(securityS, 0);
+#if IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_USER
+        (void)iowa_user_security_handle_handshake_packet(securityS);
+#endif
+        break;
+
+    default:
+        // Do nothing
+        break;
+    }
+}
+#endif
+
 static void prv_commEventCb(comm_channel_t *fromChannel,
                             comm_event_t event,
                             void *userData,
@@ -51,14 +530,18 @@ static void prv_commEventCb(comm_channel_t *fromChannel,
         {
 #ifdef IOWA_SECURITY_SERVER_MODE
         case SECURITY_STATE_INIT_HANDSHAKE:
-            securityS->state = SECURITY_STATE_HANDSHAKING;
-            // Fall through
 #endif
         case SECURITY_STATE_HANDSHAKING:
-            // Security mode cannot be none on Handshaking
-#if IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_USER
-            (void)iowa_user_security_handle_handshake_packet(securityS);
+#ifdef IOWA_SECURITY_SERVER_MODE
+            if (securityS->handshakeSlot == true)
+            {
+                // Handled by securityStep() once the established sessions are served
+                securityS->handshakePending = true;
+                securityScheduleStep(securityS, 0);
+                break;
+            }
 #endif
+            prv_handleHandshakePacket(contextP, securityS);
             break;
 
         case SECURITY_STATE_CONNECTED:
@@ -80,6 +563,114 @@ static void prv_commEventCb(comm_channel_t *fromChannel,
     }
 }
 
+static void prv_mergeStepTime(iowa_context_t contextP,
+                              int32_t stepTime)
+{
+    int32_t delay;
+
+    if (contextP->securityContextP->nextStepTime == SECURITY_STEP_TIME_NONE
+        || stepTime < contextP->securityContextP->nextStepTime)
+    {
+        contextP->securityContextP->nextStepTime = stepTime;
+    }
+
+    delay = stepTime - contextP->currentTime;
+    if (delay < 0)
+    {
+        delay = 0;
+    }
+    if (delay < contextP->timeout)
+    {
+        contextP->timeout = delay;
+    }
+}
+
+#ifdef IOWA_SECURITY_CLIENT_MODE
+static security_resumption_t * prv_findResumption(iowa_security_context_t securityContextP,
+                                                  const char *uri)
+{
+    security_resumption_t *resumptionP;
+
+    resumptionP = securityContextP->resumptionList;
+    while (resumptionP != NULL
+           && strcmp(resumptionP->uri, uri) != 0)
+    {
+        resumptionP = resumptionP->nextP;
+    }
+
+    return resumptionP;
+}
+
+static void prv_freeResumption(void *nodeP)
+{
+    security_resumption_t *resumptionP;
+
+    resumptionP = (security_resumption_t *)nodeP;
+
+    iowa_system_free(resumptionP->uri);
+    iowa_system_free(resumptionP->data);
+    iowa_system_free(resumptionP);
+}
+
+// Returned value: true if data were stored for the peer.
+static bool prv_removeResumption(iowa_security_context_t securityContextP,
+                                 const char *uri)
+{
+    security_resumption_t *resumptionP;
+
+    resumptionP = prv_findResumption(securityContextP, uri);
+    if (resumptionP == NULL)
+    {
+        return false;
+    }
+
+    securityContextP->resumptionList = (security_resumption_t *)IOWA_UTILS_LIST_REMOVE(securityContextP->resumptionList, resumptionP);
+    prv_freeResumption(resumptionP);
+
+    return true;
+}
+
+static iowa_status_t prv_addResumption(iowa_security_context_t securityContextP,
+                                       const uint8_t *uri,
+                                       size_t uriLength,
+                                       const uint8_t *buffer,
+                                       size_t length)
+{
+    security_resumption_t *resumptionP;
+
+    resumptionP = (security_resumption_t *)iowa_system_malloc(sizeof(security_resumption_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (resumptionP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(security_resumption_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(resumptionP, 0, sizeof(security_resumption_t));
+
+    resumptionP->uri = utilsBufferToString(uri, uriLength);
+    resumptionP->data = (uint8_t *)iowa_system_malloc(length);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (resumptionP->uri == NULL
+        || resumptionP->data == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(length);
+        prv_freeResumption(resumptionP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memcpy(resumptionP->data, buffer, length);
+    resumptionP->dataLength = length;
+
+    // Only the latest session is kept for a peer
+    (void)prv_removeResumption(securityContextP, resumptionP->uri);
+
+    securityContextP->resumptionList = (security_resumption_t *)IOWA_UTILS_LIST_ADD(securityContextP->resumptionList, resumptionP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif // IOWA_SECURITY_CLIENT_MODE
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -97,6 +688,7 @@ iowa_status_t securityInit(iowa_context_t contextP)
     }
 #endif
     memset(contextP->securityContextP, 0, sizeof(struct _iowa_security_context_t));
+    contextP->securityContextP->nextStepTime = SECURITY_STEP_TIME_NONE;
 
     IOWA_LOG_INFO(IOWA_PART_SECURITY, "Security layer init done");
 
@@ -108,49 +700,171 @@ void securityClose(iowa_context_t contextP)
     // WARNING: This function is called in a critical section
     IOWA_LOG_INFO(IOWA_PART_SECURITY, "Closing security layer");
 
+#ifdef IOWA_SECURITY_CLIENT_MODE
+    IOWA_UTILS_LIST_FREE(contextP->securityContextP->resumptionList, prv_freeResumption);
+#endif
     iowa_system_free(contextP->securityContextP);
     contextP->securityContextP = NULL;
 
     IOWA_LOG_INFO(IOWA_PART_SECURITY, "Security layer closed");
 }
 
-iowa_status_t securityStep(iowa_context_t contextP)
+// Step the sessions whose step time is reached.
+// Parameters:
+// - handshakes: if true, only the server sessions counted in the ongoing handshakes are handled, otherwise only the other ones.
+// - resultP: OUT. the result of the last security layer step.
+static void prv_stepSessions(iowa_context_t contextP,
+                             bool handshakes,
+                             iowa_status_t *resultP)
 {
-    iowa_status_t result;
     iowa_security_session_t securityS;
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Entering currentTime: %u, timeoutP: %u.", contextP->currentTime, contextP->timeout);
-
-    result = IOWA_COAP_NO_ERROR;
     securityS = contextP->securityContextP->sessionList;
 
     while (securityS != NULL)
     {
         iowa_security_session_t nextSecurityS;
 
-        IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Entering with Security state: %s for securityS: %p.", STR_SECURITY_STATE(securityS->state), securityS);
-
         // Save the next Security session since the step could delete it
         nextSecurityS = (iowa_security_session_t)securityS->nextP;
 
-        if (securityS->isSecure == true)
+#ifdef IOWA_SECURITY_SERVER_MODE
+        if (securityS->handshakeSlot != handshakes)
         {
+            securityS = nextSecurityS;
+            continue;
+        }
+
+#if IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE
+        if (securityS->handshakePending == true)
+        {
+            if (securityS->state == SECURITY_STATE_DISCONNECTED)
+            {
+                // Handled once the session is connected
+                securityS = nextSecurityS;
+                continue;
+            }
+
+            securityS->handshakePending = false;
+            if (securityS->state == SECURITY_STATE_INIT_HANDSHAKE
+                || securityS->state == SECURITY_STATE_HANDSHAKING)
+            {
+                // This schedules the step of the session
+                prv_handleHandshakePacket(contextP, securityS);
+                securityS = nextSecurityS;
+                continue;
+            }
+        }
+#endif
+#else
+        (void)handshakes;
+#endif
+
+        if (securityS->stepTime != SECURITY_STEP_TIME_NONE)
+        {
+            if (securityS->stepTime <= contextP->currentTime)
+            {
+                IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Stepping with Security state: %s for securityS: %p.", STR_SECURITY_STATE(securityS->state), securityS);
+
+                securityS->stepTime = SECURITY_STEP_TIME_NONE;
+
+                if (securityS->isSecure == true)
+                {
 #if IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_USER
-            result = iowa_user_security_step(securityS);
+                    *resultP = iowa_user_security_step(securityS);
 #else
-            // Should not happen
-            result = IOWA_COAP_501_NOT_IMPLEMENTED;
+                    // Should not happen
+                    *resultP = IOWA_COAP_501_NOT_IMPLEMENTED;
 #endif
+                }
+            }
+            else
+            {
+                prv_mergeStepTime(contextP, securityS->stepTime);
+            }
         }
 
         securityS = nextSecurityS;
     }
+}
+
+iowa_status_t securityStep(iowa_context_t contextP)
+{
+    iowa_status_t result;
+    int32_t nextStepTime;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Entering currentTime: %u, timeoutP: %u.", contextP->currentTime, contextP->timeout);
+
+    result = IOWA_COAP_NO_ERROR;
+
+    // Idle sessions are not walked through
+    nextStepTime = contextP->securityContextP->nextStepTime;
+    if (nextStepTime == SECURITY_STEP_TIME_NONE)
+    {
+        IOWA_LOG_INFO(IOWA_PART_SECURITY, "Exiting. No session step is scheduled.");
+        return result;
+    }
+    if (nextStepTime > contextP->currentTime)
+    {
+        prv_mergeStepTime(contextP, nextStepTime);
+        IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Exiting. Next session step in %us.", nextStepTime - contextP->currentTime);
+        return result;
+    }
+
+    // Rebuilt from the sessions not stepped and from the ones rescheduled by their step
+    contextP->securityContextP->nextStepTime = SECURITY_STEP_TIME_NONE;
+
+    prv_stepSessions(contextP, false, &result);
+#ifdef IOWA_SECURITY_SERVER_MODE
+    // Handshakes with new peers come after the established sessions
+    prv_stepSessions(contextP, true, &result);
+#endif
 
     IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
 
     return result;
 }
 
+void securityScheduleStep(iowa_security_session_t securityS,
+                          int32_t delay)
+{
+    int32_t stepTime;
+
+    if (delay < 0)
+    {
+        return;
+    }
+
+    if (delay > INT32_MAX - securityS->contextP->currentTime)
+    {
+        stepTime = INT32_MAX;
+    }
+    else
+    {
+        stepTime = securityS->contextP->currentTime + delay;
+    }
+
+    if (securityS->stepTime == SECURITY_STEP_TIME_NONE
+        || stepTime < securityS->stepTime)
+    {
+        securityS->stepTime = stepTime;
+    }
+
+    prv_mergeStepTime(securityS->contextP, stepTime);
+}
+
+#ifdef IOWA_SECURITY_SERVER_MODE
+void securityReleaseHandshakeSlot(iowa_security_session_t securityS)
+{
+    if (securityS->handshakeSlot == true)
+    {
+        securityS->handshakeSlot = false;
+        securityS->handshakePending = false;
+        securityS->contextP->securityContextP->handshakeStats.ongoing--;
+    }
+}
+#endif
+
 #ifdef IOWA_SECURITY_CLIENT_MODE
 iowa_security_session_t securityClientNewSession(iowa_context_t contextP,
                                                  const char *uri,
@@ -238,6 +952,7 @@ iowa_security_session_t securityClientNewSession(iowa_context_t contextP,
     securityS->isSecure = isSecure;
     securityS->type = type;
     securityS->shortServerID = IOWA_LWM2M_ID_ALL;
+    securityS->stepTime = SECURITY_STEP_TIME_NONE;
 
     if (securityS->isSecure == true)
     {
@@ -305,6 +1020,9 @@ void securityDeleteSession(iowa_context_t contextP,
 
     // Remove the session from the list
     contextP->securityContextP->sessionList = (iowa_security_session_t)IOWA_UTILS_LIST_REMOVE(contextP->securityContextP->sessionList, securityS);
+#ifdef IOWA_SECURITY_SERVER_MODE
+    securityReleaseHandshakeSlot(securityS);
+#endif
 
     if (securityS->isSecure == true)
     {
@@ -369,7 +1087,10 @@ iowa_status_t securityConnect(iowa_context_t contextP,
         else
         {
             securityS->state = SECURITY_STATE_INIT_HANDSHAKE;
-            contextP->timeout = 0;
+#ifdef IOWA_METRICS_SUPPORT
+            securityS->handshakeStartTime = iowa_system_gettime_us();
+#endif
+            securityScheduleStep(securityS, 0);
         }
         break;
 
@@ -391,6 +1112,14 @@ void securityDisconnect(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Disconnecting session %p.", securityS);
 
+#if defined(IOWA_SECURITY_SERVER_MODE) && defined(IOWA_UDP_SUPPORT) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE)
+    if (securityS->migrationChannelP != NULL)
+    {
+        commChannelDelete(contextP, securityS->migrationChannelP);
+        securityS->migrationChannelP = NULL;
+    }
+#endif
+
     switch (securityS->state)
     {
     case SECURITY_STATE_CONNECTED:
@@ -404,6 +1133,9 @@ void securityDisconnect(iowa_context_t contextP,
         commChannelDelete(contextP, securityS->channelP);
         securityS->channelP = NULL;
         securityS->state = SECURITY_STATE_DISCONNECTED;
+#ifdef IOWA_SECURITY_SERVER_MODE
+        securityReleaseHandshakeSlot(securityS);
+#endif
 
         SESSION_CALL_EVENT_CALLBACK(securityS, SECURITY_EVENT_DISCONNECTED);
         break;
@@ -412,6 +1144,9 @@ void securityDisconnect(iowa_context_t contextP,
         commChannelDelete(contextP, securityS->channelP);
         securityS->channelP = NULL;
         securityS->state = SECURITY_STATE_DISCONNECTED;
+#ifdef IOWA_SECURITY_SERVER_MODE
+        securityReleaseHandshakeSlot(securityS);
+#endif
     }
 
     IOWA_LOG_INFO(IOWA_PART_SECURITY, "Exiting.");
@@ -441,6 +1176,13 @@ int securitySend(iowa_context_t contextP,
 #endif
     }
 
+#ifdef IOWA_CAPTURE_SUPPORT
+    if (bufferSend > 0)
+    {
+        commCaptureRecord(contextP, securityS->channelP, true, buffer, length);
+    }
+#endif
+
     return bufferSend;
 }
 
@@ -466,32 +1208,142 @@ int securityRecv(iowa_context_t contextP,
         // Should not happen
         bufferReceived = 0;
 #endif
+
+#if defined(IOWA_SECURITY_SERVER_MODE) && defined(IOWA_UDP_SUPPORT) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE)
+        if (securityS->migrationChannelP != NULL)
+        {
+            // The record came from a new address of the peer, see prv_routeByConnectionId()
+            prv_endMigration(contextP, securityS, bufferReceived > 0);
+        }
+#endif
     }
 
+#ifdef IOWA_CAPTURE_SUPPORT
+    if (bufferReceived > 0)
+    {
+        commCaptureRecord(contextP, securityS->channelP, false, buffer, (size_t)bufferReceived);
+    }
+#endif
+
     IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Exiting with: %d.", bufferReceived);
 
     return bufferReceived;
 }
 
 #ifdef IOWA_SECURITY_SERVER_MODE
-iowa_security_session_t securityServerNewSession(iowa_context_t contextP,
-                                                 iowa_connection_type_t type,
-                                                 void *connP,
-                                                 bool isSecure)
+iowa_status_t securityServerNewSession(iowa_context_t contextP,
+                                       iowa_connection_type_t type,
+                                       void *connP,
+                                       bool isSecure,
+                                       iowa_security_session_t *securitySP)
 {
     iowa_security_session_t securityS;
     iowa_status_t result;
     comm_channel_t *channelP;
+    uint8_t *datagramP;
+    int datagramLength;
+    bool isHandshake;
+#if defined(IOWA_UDP_SUPPORT) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE)
+    size_t cookieOffset;
+#endif
 
     IOWA_LOG_INFO(IOWA_PART_SECURITY, "Creating server security session.");
 
+    *securitySP = NULL;
+    datagramP = NULL;
+    datagramLength = 0;
+    isHandshake = false;
+
+    // Admission control before allocating anything for the peer
+    if (isSecure == true)
+    {
+        isHandshake = true;
+
+#if defined(IOWA_UDP_SUPPORT) && (IOWA_SECURITY_LAYER != IOWA_SECURITY_LAYER_NONE)
+        if (type == IOWA_CONN_DATAGRAM)
+        {
+            datagramLength = prv_readFirstDatagram(contextP, connP, &datagramP);
+            if (datagramLength > 0)
+            {
+                if (datagramP[0] == PRV_DTLS_CONTENT_TYPE_TLS12_CID)
+                {
+                    // Likely a known peer which changed its address
+                    isHandshake = false;
+                }
+                else if (prv_parseClientHello(datagramP, (size_t)datagramLength, &cookieOffset) == false)
+                {
+                    IOWA_LOG_WARNING(IOWA_PART_SECURITY, "First datagram is not a DTLS ClientHello. Rejecting the connection.");
+                    contextP->securityContextP->handshakeStats.rejected++;
+                    iowa_system_free(datagramP);
+                    return IOWA_COAP_400_BAD_REQUEST;
+                }
+#ifdef IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+                else if (datagramP[cookieOffset] == 0)
+                {
+                    uint8_t cookie[SECURITY_COOKIE_LENGTH];
+
+                    // The peer must prove it receives the datagrams sent to its address before getting any state
+                    result = prv_computeCookie(contextP, connP, datagramP, (size_t)datagramLength, cookieOffset, cookie);
+                    if (result == IOWA_COAP_NO_ERROR)
+                    {
+                        result = prv_sendHelloVerifyRequest(contextP, connP, datagramP, cookie);
+                    }
+                    iowa_system_free(datagramP);
+                    if (result != IOWA_COAP_NO_ERROR)
+                    {
+                        return result;
+                    }
+                    IOWA_LOG_INFO(IOWA_PART_SECURITY, "HelloVerifyRequest sent to the new peer.");
+                    contextP->securityContextP->handshakeStats.challenged++;
+                    return IOWA_COAP_401_UNAUTHORIZED;
+                }
+                else
+                {
+                    result = prv_checkCookie(contextP, connP, datagramP, (size_t)datagramLength, cookieOffset);
+                    if (result != IOWA_COAP_NO_ERROR)
+                    {
+                        IOWA_LOG_WARNING(IOWA_PART_SECURITY, "Invalid cookie in the DTLS ClientHello. Rejecting the connection.");
+                        if (result == IOWA_COAP_400_BAD_REQUEST)
+                        {
+                            contextP->securityContextP->handshakeStats.rejected++;
+                        }
+                        iowa_system_free(datagramP);
+                        return result;
+                    }
+                }
+#endif
+            }
+#ifdef IOWA_SECURITY_STATELESS_COOKIE_SUPPORT
+            else
+            {
+                IOWA_LOG_WARNING(IOWA_PART_SECURITY, "No DTLS ClientHello to verify. Rejecting the connection.");
+                contextP->securityContextP->handshakeStats.rejected++;
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+#endif
+        }
+#endif
+
+#ifdef IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES
+        if (isHandshake == true
+            && contextP->securityContextP->handshakeStats.ongoing >= IOWA_SECURITY_MAX_CONCURRENT_HANDSHAKES)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_SECURITY, "%u handshakes are ongoing. Deferring the connection.", contextP->securityContextP->handshakeStats.ongoing);
+            contextP->securityContextP->handshakeStats.deferred++;
+            iowa_system_free(datagramP);
+            return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        }
+#endif
+    }
+
     // Create the security session
     securityS = (struct _iowa_security_session_t *)iowa_system_malloc(sizeof(struct _iowa_security_session_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (securityS == NULL)
     {
         IOWA_LOG_ERROR_MALLOC(sizeof(struct _iowa_security_session_t));
-        return NULL;
+        iowa_system_free(datagramP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 #endif
     memset(securityS, 0, sizeof(struct _iowa_security_session_t));
@@ -500,14 +1352,16 @@ iowa_security_session_t securityServerNewSession(iowa_context_t contextP,
     result = commChannelNew(contextP, type, connP, prv_commEventCb, (void *)securityS, &channelP);
     if (result != IOWA_COAP_NO_ERROR)
     {
+        iowa_system_free(datagramP);
         iowa_system_free(securityS);
-        return NULL;
+        return result;
     }
 
     securityS->isSecure = isSecure;
     securityS->contextP = contextP;
     securityS->channelP = channelP;
     securityS->type = type;
+    securityS->stepTime = SECURITY_STEP_TIME_NONE;
 
     if (securityS->isSecure == false)
     {
@@ -528,17 +1382,41 @@ iowa_security_session_t securityServerNewSession(iowa_context_t contextP,
         IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Failed to create the security session.");
 
         commChannelDelete(contextP, channelP);
+        iowa_system_free(datagramP);
         iowa_system_free(securityS);
 
-        return NULL;
+        return result;
     }
 
     // Add the security session to the list
     contextP->securityContextP->sessionList = (iowa_security_session_t)IOWA_UTILS_LIST_ADD(contextP->securityContextP->sessionList, securityS);
 
+    if (isHandshake == true)
+    {
+        securityS->handshakeSlot = true;
+        contextP->securityContextP->handshakeStats.ongoing++;
+        contextP->securityContextP->handshakeStats.admitted++;
+#ifdef IOWA_METRICS_SUPPORT
+        securityS->handshakeStartTime = iowa_system_gettime_us();
+#endif
+    }
+
+    if (datagramP != NULL)
+    {
+        // The datagram read by the admission control is handled at the next step
+        if (commChannelPushBack(contextP, channelP, datagramP, (size_t)datagramLength) == IOWA_COAP_NO_ERROR)
+        {
+            securityS->handshakePending = true;
+            securityScheduleStep(securityS, 0);
+        }
+        iowa_system_free(datagramP);
+    }
+
     IOWA_LOG_ARG_INFO(IOWA_PART_SECURITY, "Server security session created: %p.", securityS);
 
-    return securityS;
+    *securitySP = securityS;
+
+    return IOWA_COAP_NO_ERROR;
 }
 
 size_t securityGetIdentity(iowa_context_t contextP,
@@ -579,6 +1457,36 @@ size_t securityGetIdentity(iowa_context_t contextP,
     return identifierLength;
 }
 
+iowa_status_t securitySetConnectionId(iowa_security_session_t securityS,
+                                      const uint8_t *connectionId,
+                                      size_t length)
+{
+    IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Session %p, Connection ID length: %u.", securityS, length);
+
+    if (length > SECURITY_CONNECTION_ID_MAX_LENGTH)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SECURITY, "Connection ID is too long (%u bytes).", length);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    if (length != 0)
+    {
+        // The Connection IDs are found in the records without knowing the session, so they must all have the same length
+        if (securityS->contextP->securityContextP->connectionIdLength != 0
+            && securityS->contextP->securityContextP->connectionIdLength != length)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_SECURITY, "Connection ID length is %u bytes instead of %u.", length, securityS->contextP->securityContextP->connectionIdLength);
+            return IOWA_COAP_400_BAD_REQUEST;
+        }
+
+        memcpy(securityS->connectionId, connectionId, length);
+        securityS->contextP->securityContextP->connectionIdLength = (uint8_t)length;
+    }
+    securityS->connectionIdLength = (uint8_t)length;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
 bool securityGetIsSecure(iowa_context_t contextP,
                          iowa_security_session_t securityS)
 {
@@ -598,3 +1506,164 @@ void * securityGetConnP(iowa_security_session_t securityS)
     }
     return securityS->channelP->connP;
 }
+
+#ifdef IOWA_SECURITY_CLIENT_MODE
+iowa_status_t securityResumptionSet(iowa_context_t contextP,
+                                    const char *uri,
+                                    const uint8_t *buffer,
+                                    size_t length)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Storing %u bytes of session data for \"%s\".", length, uri);
+
+    if (length == 0)
+    {
+        securityResumptionClear(contextP, uri);
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    result = prv_addResumption(contextP->securityContextP, (const uint8_t *)uri, strlen(uri), buffer, length);
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        coreContextJournalResumption(contextP);
+    }
+#endif
+
+    return result;
+}
+
+size_t securityResumptionGet(iowa_context_t contextP,
+                             const char *uri,
+                             const uint8_t **bufferP)
+{
+    // WARNING: This function is called in a critical section
+    security_resumption_t *resumptionP;
+
+    resumptionP = prv_findResumption(contextP->securityContextP, uri);
+    if (resumptionP == NULL)
+    {
+        *bufferP = NULL;
+        return 0;
+    }
+
+    *bufferP = resumptionP->data;
+
+    return resumptionP->dataLength;
+}
+
+void securityResumptionClear(iowa_context_t contextP,
+                             const char *uri)
+{
+    // WARNING: This function is called in a critical section
+    IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Removing session data for \"%s\".", uri);
+
+    if (prv_removeResumption(contextP->securityContextP, uri) == true)
+    {
+#ifdef IOWA_STORAGE_CONTEXT_JOURNAL_SUPPORT
+        coreContextJournalResumption(contextP);
+#endif
+    }
+}
+
+#ifdef IOWA_STORAGE_CONTEXT_SUPPORT
+// Each entry is serialized as: URI length (2 bytes), URI, data length (2 bytes), data.
+size_t securityResumptionBackup(iowa_context_t contextP,
+                                uint8_t *buffer,
+                                size_t length)
+{
+    // WARNING: This function is called in a critical section
+    security_resumption_t *resumptionP;
+    size_t index;
+
+    index = 0;
+    for (resumptionP = contextP->securityContextP->resumptionList; resumptionP != NULL; resumptionP = resumptionP->nextP)
+    {
+        uint16_t uriLength;
+        uint16_t dataLength;
+
+        if (strlen(resumptionP->uri) > UINT16_MAX
+            || resumptionP->dataLength > UINT16_MAX)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_SECURITY, "Session data for \"%s\" are too large to be saved.", resumptionP->uri);
+            continue;
+        }
+        uriLength = (uint16_t)strlen(resumptionP->uri);
+        dataLength = (uint16_t)resumptionP->dataLength;
+
+        if (buffer != NULL)
+        {
+            if (index + 4 + uriLength + dataLength > length)
+            {
+                IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Buffer is too small.");
+                return 0;
+            }
+
+            utilsCopyValue(buffer + index, &uriLength, 2);
+            memcpy(buffer + index + 2, resumptionP->uri, uriLength);
+            utilsCopyValue(buffer + index + 2 + uriLength, &dataLength, 2);
+            memcpy(buffer + index + 4 + uriLength, resumptionP->data, dataLength);
+        }
+        index += 4 + (size_t)uriLength + (size_t)dataLength;
+    }
+
+    return index;
+}
+
+iowa_status_t securityResumptionRestore(iowa_context_t contextP,
+                                        const uint8_t *buffer,
+                                        size_t length)
+{
+    // WARNING: This function is called in a critical section
+    size_t index;
+
+    IOWA_UTILS_LIST_FREE(contextP->securityContextP->resumptionList, prv_freeResumption);
+    contextP->securityContextP->resumptionList = NULL;
+
+    index = 0;
+    while (index < length)
+    {
+        uint16_t uriLength;
+        uint16_t dataLength;
+        iowa_status_t result;
+
+        if (index + 2 > length)
+        {
+            break;
+        }
+        utilsCopyValue(&uriLength, buffer + index, 2);
+        if (index + 2 + uriLength + 2 > length)
+        {
+            break;
+        }
+        utilsCopyValue(&dataLength, buffer + index + 2 + uriLength, 2);
+        if (index + 4 + uriLength + dataLength > length)
+        {
+            break;
+        }
+
+        if (uriLength != 0
+            && dataLength != 0)
+        {
+            result = prv_addResumption(contextP->securityContextP, buffer + index + 2, uriLength, buffer + index + 4 + uriLength, dataLength);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                return result;
+            }
+        }
+
+        index += 4 + (size_t)uriLength + (size_t)dataLength;
+    }
+
+    if (index != length)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_SECURITY, "Malformed session data backup.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif // IOWA_STORAGE_CONTEXT_SUPPORT
+#endif // IOWA_SECURITY_CLIENT_MODE
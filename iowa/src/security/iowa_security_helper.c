@@ -82,6 +82,29 @@ void iowa_security_session_set_state(iowa_security_session_t securityS,
                                      iowa_security_state_t state)
 {
     securityS->state = state;
+
+    switch (state)
+    {
+    case SECURITY_STATE_INIT_HANDSHAKE:
+    case SECURITY_STATE_HANDSHAKING:
+        // The security layer step handles these states
+        securityScheduleStep(securityS, 0);
+        break;
+
+    case SECURITY_STATE_DISCONNECTING:
+    case SECURITY_STATE_HANDSHAKE_DONE:
+#ifdef IOWA_SECURITY_SERVER_MODE
+        securityReleaseHandshakeSlot(securityS);
+#endif
+        securityScheduleStep(securityS, 0);
+        break;
+
+    default:
+#ifdef IOWA_SECURITY_SERVER_MODE
+        securityReleaseHandshakeSlot(securityS);
+#endif
+        break;
+    }
 }
 
 void iowa_security_session_generate_event(iowa_security_session_t securityS,
@@ -113,11 +136,7 @@ const char *iowa_security_session_get_uri(iowa_security_session_t securityS)
 void iowa_security_session_set_step_delay(iowa_security_session_t securityS,
                                           int32_t delay)
 {
-    if (delay >= 0
-        && delay < securityS->contextP->timeout)
-    {
-        securityS->contextP->timeout = delay;
-    }
+    securityScheduleStep(securityS, delay);
 }
 
 iowa_context_t iowa_security_session_get_context(iowa_security_session_t securityS)
@@ -151,7 +170,56 @@ int iowa_security_connection_recv(iowa_security_session_t securityS,
         return -1;
     }
 
+#ifdef IOWA_SECURITY_SERVER_MODE
+    if (securityS->migrationChannelP != NULL)
+    {
+        // A record from a new address of the peer, adopted if authenticated
+        return commRecv(securityS->contextP, securityS->migrationChannelP, buffer, length);
+    }
+#endif
+
     return commRecv(securityS->contextP, securityS->channelP, buffer, length);
 }
 
+#ifdef IOWA_SECURITY_SERVER_MODE
+iowa_status_t iowa_security_session_set_connection_id(iowa_security_session_t securityS,
+                                                      const uint8_t *connectionId,
+                                                      size_t length)
+{
+    return securitySetConnectionId(securityS, connectionId, length);
+}
+#endif
+
 #endif // IOWA_SECURITY_LAYER == IOWA_SECURITY_LAYER_USER
+
+#ifdef IOWA_SECURITY_SERVER_MODE
+void iowa_security_get_handshake_stats(iowa_context_t contextP,
+                                       iowa_security_handshake_stats_t *statsP)
+{
+    CRIT_SECTION_ENTER(contextP);
+    *statsP = contextP->securityContextP->handshakeStats;
+    CRIT_SECTION_LEAVE(contextP);
+}
+#endif
+
+#ifdef IOWA_SECURITY_CLIENT_MODE
+
+iowa_status_t iowa_security_session_set_resumption_data(iowa_security_session_t securityS,
+                                                        const uint8_t *buffer,
+                                                        size_t length)
+{
+    return securityResumptionSet(securityS->contextP, securityS->uri, buffer, length);
+}
+
+size_t iowa_security_session_get_resumption_data(iowa_security_session_t securityS,
+                                                 const uint8_t **bufferP)
+{
+    return securityResumptionGet(securityS->contextP, securityS->uri, bufferP);
+}
+
+void iowa_security_session_clear_resumption_data(iowa_security_session_t securityS)
+{
+    securityResumptionClear(securityS->contextP, securityS->uri);
+}
+
+#endif // IOWA_SECURITY_CLIENT_MODE
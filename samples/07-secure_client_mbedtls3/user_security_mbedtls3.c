@@ -23,8 +23,8 @@
 #include "mbedtls/debug.h"
 #include "mbedtls/error.h"
 #include "mbedtls/platform.h"
+#include "mbedtls/sha256.h"
 #include "mbedtls/ssl.h"
-#include "mbedtls/ssl_cache.h"
 #include "mbedtls/timing.h"
 
 #ifdef SECURITY_CERTIFICATE_SUPPORT
@@ -57,23 +57,45 @@
 #define PRV_PRINT_MBEDTLS_ERROR(funcName, res)
 #endif
 
-// Internal structure holding the security data
-typedef struct
+#define PRV_FINGERPRINT_LENGTH 32
+
+// Maximum number of configurations kept in the cache, including the ones not used by any session
+#define PRV_CONFIG_CACHE_SIZE 4
+
+// Mbed TLS configuration and parsed credentials shared by the sessions with the same
+// IOWA context, transport, security mode and Server URI.
+// The fingerprint of the security data is checked at each session creation so that
+// a configuration built from outdated credentials is never reused.
+typedef struct _user_security_config_t
 {
+    struct _user_security_config_t *nextP;
+    uint16_t                    refCount;
+    bool                        isOutdated;
+    // Key
+    void                        *contextUserDataP;
+    int                         transport;
+    iowa_security_mode_t        securityMode;
+    char                        *uri;
+    uint8_t                     fingerprint[PRV_FINGERPRINT_LENGTH];
     // Common
-    mbedtls_ssl_context         sslContext;
     mbedtls_ssl_config          sslConfig;
-    mbedtls_ssl_cache_context   sslCache;
     int                         *ciphersuites;
-    int32_t                     startTime;
-    uint32_t                    timeout;
-    bool                        handshakeDataAvailable;
 #ifdef SECURITY_CERTIFICATE_SUPPORT
     // Certificate
     mbedtls_x509_crt            *caCert;
     mbedtls_x509_crt            *cert;
     mbedtls_pk_context          *privateKey;
 #endif
+} user_security_config_t;
+
+// Internal structure holding the security data
+typedef struct
+{
+    mbedtls_ssl_context         sslContext;
+    user_security_config_t      *configP;
+    int32_t                     startTime;
+    uint32_t                    timeout;
+    bool                        handshakeDataAvailable;
 } user_security_internal_t;
 
 #define PRV_STR_MBEDTLS_STATE(M)                                                                        \
@@ -158,6 +180,13 @@ typedef struct
 ((M) == MBEDTLS_ERR_SSL_CRYPTO_IN_PROGRESS ? "MBEDTLS_ERR_SSL_CRYPTO_IN_PROGRESS":    \
 "Unknown")))))))))))))))))))))))))))))))))))))))))))))))))))))))))
 
+/*************************************************************************************
+** Private variables
+*************************************************************************************/
+
+// The security callbacks are called with the IOWA context locked. If several IOWA contexts
+// run in different threads, the accesses to this list must be serialized by the application.
+static user_security_config_t *s_configListP = NULL;
 
 /*************************************************************************************
 ** Private functions
@@ -167,37 +196,84 @@ typedef struct
 ** Security Application Private functions
 *******************************/
 
-// Used to free the allocated user_security_internal_t
-static void prv_internalsFree(user_security_internal_t *internalsP)
+// Used to free an allocated user_security_config_t
+static void prv_configFree(user_security_config_t *configP)
 {
     IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Entering.");
 
 #ifdef SECURITY_CERTIFICATE_SUPPORT
-    if (internalsP->caCert != NULL)
+    if (configP->caCert != NULL)
     {
-        mbedtls_x509_crt_free(internalsP->caCert);
-        iowa_system_free(internalsP->caCert);
+        mbedtls_x509_crt_free(configP->caCert);
+        iowa_system_free(configP->caCert);
     }
 
-    if (internalsP->cert != NULL)
+    if (configP->cert != NULL)
     {
-        mbedtls_x509_crt_free(internalsP->cert);
-        iowa_system_free(internalsP->cert);
+        mbedtls_x509_crt_free(configP->cert);
+        iowa_system_free(configP->cert);
     }
 
-    if (internalsP->privateKey != NULL)
+    if (configP->privateKey != NULL)
     {
-        mbedtls_pk_free(internalsP->privateKey);
-        iowa_system_free(internalsP->privateKey);
+        mbedtls_pk_free(configP->privateKey);
+        iowa_system_free(configP->privateKey);
     }
 #endif
 
+    mbedtls_ssl_config_free(&configP->sslConfig);
+
+    if (configP->ciphersuites != NULL)
+    {
+        iowa_system_free(configP->ciphersuites);
+    }
+    if (configP->uri != NULL)
+    {
+        iowa_system_free(configP->uri);
+    }
+    iowa_system_free(configP);
+}
+
+// Remove a configuration from the cache and free it
+static void prv_configRemove(user_security_config_t *configP)
+{
+    user_security_config_t **configPP;
+
+    for (configPP = &s_configListP; *configPP != NULL; configPP = &(*configPP)->nextP)
+    {
+        if (*configPP == configP)
+        {
+            *configPP = configP->nextP;
+            break;
+        }
+    }
+
+    prv_configFree(configP);
+}
+
+// Release a session reference on a configuration.
+// Unused configurations are kept in the cache for the next connections, unless they are outdated.
+static void prv_configRelease(user_security_config_t *configP)
+{
+    configP->refCount--;
+
+    if (configP->refCount == 0
+        && configP->isOutdated == true)
+    {
+        prv_configRemove(configP);
+    }
+}
+
+// Used to free the allocated user_security_internal_t
+static void prv_internalsFree(user_security_internal_t *internalsP)
+{
+    IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Entering.");
+
     mbedtls_ssl_free(&internalsP->sslContext);
-    mbedtls_ssl_config_free(&internalsP->sslConfig);
 
-    if (internalsP->ciphersuites != NULL)
+    if (internalsP->configP != NULL)
     {
-        iowa_system_free(internalsP->ciphersuites);
+        prv_configRelease(internalsP->configP);
     }
     iowa_system_free(internalsP);
 }
@@ -306,16 +382,10 @@ static int prv_mbedtlsRandomVectorGenerator(void *userDataP,
                                             uint8_t *randomBuffer,
                                             size_t size)
 {
-    int res;
-    iowa_security_session_t securityS;
-
+    // userDataP is the IOWA context user data, as the configuration is shared between sessions
     IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Entering.");
 
-    securityS = (iowa_security_session_t)userDataP;
-
-    res = iowa_system_random_vector_generator(randomBuffer, size, iowa_security_session_get_context_user_data(securityS));
-
-    return res;
+    return iowa_system_random_vector_generator(randomBuffer, size, userDataP);
 }
 
 static void prv_mbedtlsSetDelay(void *userDataP,
@@ -384,140 +454,111 @@ static int prv_mbedtlsGetDelay(void *userDataP)
 }
 
 #ifdef SECURITY_CERTIFICATE_SUPPORT
-static iowa_status_t prv_initCertificate(iowa_security_session_t securityS)
+static iowa_status_t prv_initCertificate(user_security_config_t *configP,
+                                         iowa_security_data_t *securityDataP)
 {
     int res;
-    iowa_security_data_t securityData;
-    user_security_internal_t *internalsP;
-    iowa_status_t iowaRes;
-    uint8_t *peerIdentity;
-    size_t peerIdentityLen;
-    const char *uriP;
 
     IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Entering.");
 
-    internalsP = (user_security_internal_t *)iowa_security_session_get_user_internals(securityS);
-
-    // Retrieve the certificate structure
-    memset(&securityData, 0, sizeof(iowa_security_data_t));
-    securityData.securityMode = IOWA_SEC_CERTIFICATE;
-
-    uriP = iowa_security_session_get_uri(securityS);
-    peerIdentity = (uint8_t *)uriP;
-    peerIdentityLen = strlen(uriP);
-
-    iowaRes = iowa_system_security_data(peerIdentity, peerIdentityLen, IOWA_SEC_READ, &securityData, iowa_security_session_get_context_user_data(securityS));
-    if (iowaRes != IOWA_COAP_NO_ERROR)
-    {
-        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Failed to retrieve the certificate (%u.%02u)", (iowaRes & 0xFF) >> 5, (iowaRes & 0x1F));
-        return iowaRes;
-    }
-
     // Only verify certificate on client side
     // Client need to check if it's connecting to the right server
-    if (securityData.protocol.certData.caCertificateLen != 0
-        && securityData.protocol.certData.caCertificate != NULL)
+    if (securityDataP->protocol.certData.caCertificateLen != 0
+        && securityDataP->protocol.certData.caCertificate != NULL)
     {
-        mbedtls_ssl_conf_authmode(&internalsP->sslConfig, MBEDTLS_SSL_VERIFY_REQUIRED);
+        mbedtls_ssl_conf_authmode(&configP->sslConfig, MBEDTLS_SSL_VERIFY_REQUIRED);
     }
     else
     {
-        mbedtls_ssl_conf_authmode(&internalsP->sslConfig, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_authmode(&configP->sslConfig, MBEDTLS_SSL_VERIFY_NONE);
     }
 
     // Configure and parse the certificate
-    internalsP->cert = (mbedtls_x509_crt *)iowa_system_malloc(sizeof(mbedtls_x509_crt));
+    configP->cert = (mbedtls_x509_crt *)iowa_system_malloc(sizeof(mbedtls_x509_crt));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-    if (internalsP->cert == NULL)
+    if (configP->cert == NULL)
     {
         IOWA_LOG_ERROR_MALLOC(sizeof(mbedtls_x509_crt));
-        goto error;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 #endif
-    mbedtls_x509_crt_init(internalsP->cert);
+    mbedtls_x509_crt_init(configP->cert);
 
     // MbedTLS is already checking the certificate buffer. No need to do it here.
-    res = mbedtls_x509_crt_parse(internalsP->cert,
-                                 securityData.protocol.certData.certificate,
-                                 securityData.protocol.certData.certificateLen);
+    res = mbedtls_x509_crt_parse(configP->cert,
+                                 securityDataP->protocol.certData.certificate,
+                                 securityDataP->protocol.certData.certificateLen);
     if (res != PRV_MBEDTLS_SUCCESSFUL)
     {
         PRV_PRINT_MBEDTLS_ERROR("mbedtls_x509_crt_parse", res);
-        goto error;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 
     // Configure and parse the private key
-    internalsP->privateKey = (mbedtls_pk_context *)iowa_system_malloc(sizeof(mbedtls_pk_context));
+    configP->privateKey = (mbedtls_pk_context *)iowa_system_malloc(sizeof(mbedtls_pk_context));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-    if (internalsP->privateKey == NULL)
+    if (configP->privateKey == NULL)
     {
         IOWA_LOG_ERROR_MALLOC(sizeof(mbedtls_pk_context));
-        goto error;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 #endif
-    mbedtls_pk_init(internalsP->privateKey);
+    mbedtls_pk_init(configP->privateKey);
 
     // MbedTLS is already checking the private key buffer. No need to do it here.
-    res = mbedtls_pk_parse_key(internalsP->privateKey,
-                               securityData.protocol.certData.privateKey,  securityData.protocol.certData.privateKeyLen,
+    res = mbedtls_pk_parse_key(configP->privateKey,
+                               securityDataP->protocol.certData.privateKey,  securityDataP->protocol.certData.privateKeyLen,
                                NULL, 0,
-                               prv_mbedtlsRandomVectorGenerator, NULL);
+                               prv_mbedtlsRandomVectorGenerator, configP->contextUserDataP);
     if (res != PRV_MBEDTLS_SUCCESSFUL)
     {
         PRV_PRINT_MBEDTLS_ERROR("mbedtls_pk_parse_key", res);
-        goto error;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 
-    res = mbedtls_ssl_conf_own_cert(&internalsP->sslConfig,
-                                    internalsP->cert,
-                                    internalsP->privateKey);
+    res = mbedtls_ssl_conf_own_cert(&configP->sslConfig,
+                                    configP->cert,
+                                    configP->privateKey);
 
     if (res != PRV_MBEDTLS_SUCCESSFUL)
     {
         PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_conf_own_cert", res);
-        goto error;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 
     // Check if a CA certificate has been provided
-    if (securityData.protocol.certData.caCertificateLen != 0
-        && securityData.protocol.certData.caCertificate != NULL)
+    if (securityDataP->protocol.certData.caCertificateLen != 0
+        && securityDataP->protocol.certData.caCertificate != NULL)
     {
-        internalsP->caCert = (mbedtls_x509_crt *)iowa_system_malloc(sizeof(mbedtls_x509_crt));
+        configP->caCert = (mbedtls_x509_crt *)iowa_system_malloc(sizeof(mbedtls_x509_crt));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-        if (internalsP->caCert == NULL)
+        if (configP->caCert == NULL)
         {
             IOWA_LOG_ERROR_MALLOC(sizeof(mbedtls_x509_crt));
-            goto error;
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        mbedtls_x509_crt_init(internalsP->caCert);
+        mbedtls_x509_crt_init(configP->caCert);
 
-        res = mbedtls_x509_crt_parse(internalsP->caCert,
-                                     securityData.protocol.certData.caCertificate,
-                                     securityData.protocol.certData.caCertificateLen);
+        res = mbedtls_x509_crt_parse(configP->caCert,
+                                     securityDataP->protocol.certData.caCertificate,
+                                     securityDataP->protocol.certData.caCertificateLen);
         if (res != PRV_MBEDTLS_SUCCESSFUL)
         {
             PRV_PRINT_MBEDTLS_ERROR("mbedtls_x509_crt_parse", res);
-            goto error;
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 
         // MbedTLS is already checking the CA certificate buffer. No need to do it here.
         IOWA_LOG_TRACE(IOWA_PART_SECURITY, "\r\nset CA certificate.\r\n");
-        mbedtls_ssl_conf_ca_chain(&internalsP->sslConfig, internalsP->caCert, NULL);
+        mbedtls_ssl_conf_ca_chain(&configP->sslConfig, configP->caCert, NULL);
     }
 
-error:
-    iowaRes = iowa_system_security_data(peerIdentity, peerIdentityLen, IOWA_SEC_FREE, &securityData, iowa_security_session_get_context_user_data(securityS));
-    if (iowaRes != IOWA_COAP_NO_ERROR)
-    {
-        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Failed to free the certificate (%u.%02u)", (iowaRes & 0xFF) >> 5, (iowaRes & 0x1F));
-    }
-
-    return iowaRes;
+    return IOWA_COAP_NO_ERROR;
 }
 #endif
 
-static iowa_status_t prv_addCiphersuites(user_security_internal_t *internalsP,
+static iowa_status_t prv_addCiphersuites(user_security_config_t *configP,
                                          bool certificate,
                                          bool psk)
 {
@@ -537,9 +578,9 @@ static iowa_status_t prv_addCiphersuites(user_security_internal_t *internalsP,
         ciphersuitesArrayLength += 2;
     }
 
-    internalsP->ciphersuites = (int *)iowa_system_malloc(ciphersuitesArrayLength*sizeof(int));
+    configP->ciphersuites = (int *)iowa_system_malloc(ciphersuitesArrayLength*sizeof(int));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-    if (internalsP->ciphersuites == NULL)
+    if (configP->ciphersuites == NULL)
     {
         IOWA_LOG_ERROR_MALLOC(ciphersuitesArrayLength*sizeof(int));
         return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
@@ -553,25 +594,364 @@ static iowa_status_t prv_addCiphersuites(user_security_internal_t *internalsP,
 
         // MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256 should not be used due to security concern.
         // Instead, MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8 must be used whenever possible. (from LwM2M 1.1 specification)
-        PRV_ADD_CIPHERSUITE(internalsP->ciphersuites, pos, MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8);
-        PRV_ADD_CIPHERSUITE(internalsP->ciphersuites, pos, MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256);
+        PRV_ADD_CIPHERSUITE(configP->ciphersuites, pos, MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8);
+        PRV_ADD_CIPHERSUITE(configP->ciphersuites, pos, MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256);
     }
 
     if (psk == true)
     {
         IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Adding pre-shared key ciphersuites");
 
-        PRV_ADD_CIPHERSUITE(internalsP->ciphersuites, pos, MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8);
-        PRV_ADD_CIPHERSUITE(internalsP->ciphersuites, pos, MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256);
+        PRV_ADD_CIPHERSUITE(configP->ciphersuites, pos, MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8);
+        PRV_ADD_CIPHERSUITE(configP->ciphersuites, pos, MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256);
     }
 
-    PRV_ADD_CIPHERSUITE(internalsP->ciphersuites, pos, 0);
+    PRV_ADD_CIPHERSUITE(configP->ciphersuites, pos, 0);
 
-    mbedtls_ssl_conf_ciphersuites(&internalsP->sslConfig, internalsP->ciphersuites);
+    mbedtls_ssl_conf_ciphersuites(&configP->sslConfig, configP->ciphersuites);
 
     return IOWA_COAP_NO_ERROR;
 }
 
+// Compute the SHA-256 of the credentials a configuration is built from.
+static int prv_computeFingerprint(iowa_security_data_t *securityDataP,
+                                  uint8_t *fingerprint)
+{
+    mbedtls_sha256_context sha256Context;
+    const uint8_t *fieldP[3];
+    size_t fieldLength[3];
+    size_t fieldNumber;
+    size_t i;
+    int res;
+
+    switch (securityDataP->securityMode)
+    {
+    case IOWA_SEC_PRE_SHARED_KEY:
+        fieldP[0] = securityDataP->protocol.pskData.identity;
+        fieldLength[0] = securityDataP->protocol.pskData.identityLen;
+        fieldP[1] = securityDataP->protocol.pskData.privateKey;
+        fieldLength[1] = securityDataP->protocol.pskData.privateKeyLen;
+        fieldNumber = 2;
+        break;
+
+#ifdef SECURITY_CERTIFICATE_SUPPORT
+    case IOWA_SEC_CERTIFICATE:
+        fieldP[0] = securityDataP->protocol.certData.caCertificate;
+        fieldLength[0] = securityDataP->protocol.certData.caCertificateLen;
+        fieldP[1] = securityDataP->protocol.certData.certificate;
+        fieldLength[1] = securityDataP->protocol.certData.certificateLen;
+        fieldP[2] = securityDataP->protocol.certData.privateKey;
+        fieldLength[2] = securityDataP->protocol.certData.privateKeyLen;
+        fieldNumber = 3;
+        break;
+#endif
+
+    default:
+        fieldNumber = 0;
+    }
+
+    mbedtls_sha256_init(&sha256Context);
+
+    res = mbedtls_sha256_starts(&sha256Context, 0);
+    for (i = 0; i < fieldNumber && res == PRV_MBEDTLS_SUCCESSFUL; i++)
+    {
+        // Hash the length first so that the field boundaries are part of the fingerprint
+        res = mbedtls_sha256_update(&sha256Context, (const unsigned char *)&fieldLength[i], sizeof(size_t));
+        if (res == PRV_MBEDTLS_SUCCESSFUL)
+        {
+            res = mbedtls_sha256_update(&sha256Context, fieldP[i], fieldLength[i]);
+        }
+    }
+    if (res == PRV_MBEDTLS_SUCCESSFUL)
+    {
+        res = mbedtls_sha256_finish(&sha256Context, fingerprint);
+    }
+
+    mbedtls_sha256_free(&sha256Context);
+
+    return res;
+}
+
+// Build a new configuration from the security data.
+// Returned value: the configuration, or NULL in case of error.
+static user_security_config_t * prv_configNew(void *contextUserDataP,
+                                              int transport,
+                                              const char *uriP,
+                                              iowa_security_data_t *securityDataP,
+                                              const uint8_t *fingerprint)
+{
+    user_security_config_t *configP;
+    int res;
+    uint8_t maxFragmentLengthCode;
+
+    configP = (user_security_config_t *)iowa_system_malloc(sizeof(user_security_config_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (configP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(user_security_config_t));
+        return NULL;
+    }
+#endif
+    memset(configP, 0, sizeof(user_security_config_t));
+
+    mbedtls_ssl_config_init(&configP->sslConfig);
+
+    configP->contextUserDataP = contextUserDataP;
+    configP->transport = transport;
+    configP->securityMode = securityDataP->securityMode;
+    memcpy(configP->fingerprint, fingerprint, PRV_FINGERPRINT_LENGTH);
+    configP->uri = utilsStrdup(uriP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (configP->uri == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(strlen(uriP) + 1);
+        goto error;
+    }
+#endif
+
+    res = mbedtls_ssl_config_defaults(&configP->sslConfig,
+                                      MBEDTLS_SSL_IS_CLIENT,
+                                      transport,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+
+    if (res != PRV_MBEDTLS_SUCCESSFUL)
+    {
+        PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_config_defaults", res);
+        goto error;
+    }
+
+#if (IOWA_LOG_LEVEL == IOWA_LOG_LEVEL_TRACE)
+    // Debug levels for MbedTLS (from the doc):
+    // 0: No debug
+    // 1: Error
+    // 2: State change
+    // 3: Informational
+    // 4: Verbose
+    mbedtls_debug_set_threshold(4);
+    mbedtls_ssl_conf_dbg(&configP->sslConfig, prv_debug, NULL);
+#endif
+
+    // Set the random vector generator function to use
+    mbedtls_ssl_conf_rng(&configP->sslConfig, prv_mbedtlsRandomVectorGenerator, contextUserDataP);
+
+    // Set the Maximum Fragment Length extension
+    if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 512)
+    {
+        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_512;
+    }
+    else if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 1024)
+    {
+        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+    }
+    else if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 2048)
+    {
+        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+    }
+    else if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 4096)
+    {
+        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+    }
+    else
+    {
+        // Do not set the maximum fragment length
+        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+    }
+
+    (void)mbedtls_ssl_conf_max_frag_len(&configP->sslConfig, maxFragmentLengthCode);
+
+    // Set up based on the security mode: here we support PSK and Certificate mode
+    switch (securityDataP->securityMode)
+    {
+    case IOWA_SEC_PRE_SHARED_KEY:
+        if (prv_addCiphersuites(configP, false, true) != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Failed to add the ciphersuites");
+            goto error;
+        }
+
+        // MbedTLS is already checking the PSK identity/key buffer. No need to do it here.
+        res = mbedtls_ssl_conf_psk(&configP->sslConfig, securityDataP->protocol.pskData.privateKey, securityDataP->protocol.pskData.privateKeyLen,
+                                   securityDataP->protocol.pskData.identity, securityDataP->protocol.pskData.identityLen);
+        if (res != PRV_MBEDTLS_SUCCESSFUL)
+        {
+            PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_conf_psk", res);
+            goto error;
+        }
+        break;
+
+#ifdef SECURITY_CERTIFICATE_SUPPORT
+    case IOWA_SEC_CERTIFICATE:
+        if (prv_addCiphersuites(configP, true, false) != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Failed to add the ciphersuites");
+            goto error;
+        }
+
+        if (prv_initCertificate(configP, securityDataP) != IOWA_COAP_NO_ERROR)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Certificate configuration failed");
+            goto error;
+        }
+        break;
+#endif
+
+    default:
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SECURITY, "Unhandled security mode: %d", securityDataP->securityMode);
+        goto error;
+    }
+
+    return configP;
+
+error:
+    prv_configFree(configP);
+
+    return NULL;
+}
+
+// Add a configuration at the end of the cache, after freeing the oldest unused ones if the cache is full.
+static void prv_configAdd(user_security_config_t *configP)
+{
+    user_security_config_t **configPP;
+    size_t count;
+
+    count = 0;
+    for (configPP = &s_configListP; *configPP != NULL; configPP = &(*configPP)->nextP)
+    {
+        count++;
+    }
+
+    configPP = &s_configListP;
+    while (count >= PRV_CONFIG_CACHE_SIZE
+           && *configPP != NULL)
+    {
+        if ((*configPP)->refCount == 0)
+        {
+            user_security_config_t *unusedConfigP;
+
+            unusedConfigP = *configPP;
+            *configPP = unusedConfigP->nextP;
+            prv_configFree(unusedConfigP);
+            count--;
+        }
+        else
+        {
+            configPP = &(*configPP)->nextP;
+        }
+    }
+
+    while (*configPP != NULL)
+    {
+        configPP = &(*configPP)->nextP;
+    }
+    *configPP = configP;
+}
+
+// Get the configuration of a security session, reusing the cached one when the security data did not change.
+// Returned value: the configuration with its reference count incremented, or NULL in case of error.
+static user_security_config_t * prv_configGet(iowa_security_session_t securityS,
+                                              int transport)
+{
+    user_security_config_t *configP;
+    iowa_security_data_t securityData;
+    uint8_t fingerprint[PRV_FINGERPRINT_LENGTH];
+    void *contextUserDataP;
+    const char *uriP;
+    iowa_status_t iowaRes;
+    int res;
+
+    contextUserDataP = iowa_security_session_get_context_user_data(securityS);
+    uriP = iowa_security_session_get_uri(securityS);
+
+    memset(&securityData, 0, sizeof(iowa_security_data_t));
+    securityData.securityMode = iowa_security_session_get_security_mode(securityS);
+
+    switch (securityData.securityMode)
+    {
+    case IOWA_SEC_PRE_SHARED_KEY:
+#ifdef SECURITY_CERTIFICATE_SUPPORT
+    case IOWA_SEC_CERTIFICATE:
+#endif
+        break;
+
+    default:
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SECURITY, "Unhandled security mode: %d", securityData.securityMode);
+        return NULL;
+    }
+
+    // The security data is read at each session creation to detect credential changes
+    iowaRes = iowa_system_security_data((uint8_t *)uriP, strlen(uriP), IOWA_SEC_READ, &securityData, contextUserDataP);
+    if (iowaRes != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Failed to retrieve the security data (%u.%02u)", (iowaRes & 0xFF) >> 5, (iowaRes & 0x1F));
+        return NULL;
+    }
+
+    configP = NULL;
+
+    res = prv_computeFingerprint(&securityData, fingerprint);
+    if (res != PRV_MBEDTLS_SUCCESSFUL)
+    {
+        PRV_PRINT_MBEDTLS_ERROR("mbedtls_sha256", res);
+        goto exit;
+    }
+
+    for (configP = s_configListP; configP != NULL; configP = configP->nextP)
+    {
+        if (configP->isOutdated == false
+            && configP->contextUserDataP == contextUserDataP
+            && configP->transport == transport
+            && configP->securityMode == securityData.securityMode
+            && strcmp(configP->uri, uriP) == 0)
+        {
+            break;
+        }
+    }
+
+    if (configP != NULL
+        && memcmp(configP->fingerprint, fingerprint, PRV_FINGERPRINT_LENGTH) != 0)
+    {
+        IOWA_LOG_INFO(IOWA_PART_SECURITY, "Security data changed, the cached configuration is discarded.");
+
+        // Sessions still using the configuration keep it until they are deleted
+        if (configP->refCount == 0)
+        {
+            prv_configRemove(configP);
+        }
+        else
+        {
+            configP->isOutdated = true;
+        }
+        configP = NULL;
+    }
+
+    if (configP == NULL)
+    {
+        configP = prv_configNew(contextUserDataP, transport, uriP, &securityData, fingerprint);
+        if (configP != NULL)
+        {
+            prv_configAdd(configP);
+        }
+    }
+    else
+    {
+        IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Reusing the cached configuration.");
+    }
+
+    if (configP != NULL)
+    {
+        configP->refCount++;
+    }
+
+exit:
+    iowaRes = iowa_system_security_data((uint8_t *)uriP, strlen(uriP), IOWA_SEC_FREE, &securityData, contextUserDataP);
+    if (iowaRes != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "Failed to free the security data (%u.%02u)", (iowaRes & 0xFF) >> 5, (iowaRes & 0x1F));
+    }
+
+    return configP;
+}
+
 static iowa_status_t prv_mbedtlsConnect(user_security_internal_t *internalsP,
                                         iowa_security_session_t securityS)
 {
@@ -638,9 +1018,96 @@ static void prv_mbedtlsDisconnect(user_security_internal_t *internalsP,
     mbedtls_ssl_session_reset(&internalsP->sslContext);
 }
 
+// Store the negotiated session to resume it on the next connection with an abbreviated handshake.
+static void prv_saveSession(user_security_internal_t *internalsP,
+                            iowa_security_session_t securityS)
+{
+    mbedtls_ssl_session session;
+    uint8_t *buffer;
+    size_t length;
+    int res;
+
+    mbedtls_ssl_session_init(&session);
+
+    res = mbedtls_ssl_get_session(&internalsP->sslContext, &session);
+    if (res != PRV_MBEDTLS_SUCCESSFUL)
+    {
+        PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_get_session", res);
+        goto exit;
+    }
+
+    // First call to retrieve the serialized length
+    res = mbedtls_ssl_session_save(&session, NULL, 0, &length);
+    if (res != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL)
+    {
+        PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_session_save", res);
+        goto exit;
+    }
+
+    buffer = (uint8_t *)iowa_system_malloc(length);
+    if (buffer == NULL)
+    {
+        goto exit;
+    }
+
+    res = mbedtls_ssl_session_save(&session, buffer, length, &length);
+    if (res == PRV_MBEDTLS_SUCCESSFUL)
+    {
+        (void)iowa_security_session_set_resumption_data(securityS, buffer, length);
+    }
+    else
+    {
+        PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_session_save", res);
+    }
+
+    iowa_system_free(buffer);
+
+exit:
+    mbedtls_ssl_session_free(&session);
+}
+
+// Offer the previously stored session to the Server, if any.
+static void prv_loadSession(user_security_internal_t *internalsP,
+                            iowa_security_session_t securityS)
+{
+    mbedtls_ssl_session session;
+    const uint8_t *buffer;
+    size_t length;
+    int res;
+
+    length = iowa_security_session_get_resumption_data(securityS, &buffer);
+    if (length == 0)
+    {
+        return;
+    }
+
+    mbedtls_ssl_session_init(&session);
+
+    res = mbedtls_ssl_session_load(&session, buffer, length);
+    if (res == PRV_MBEDTLS_SUCCESSFUL)
+    {
+        res = mbedtls_ssl_set_session(&internalsP->sslContext, &session);
+    }
+
+    if (res == PRV_MBEDTLS_SUCCESSFUL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_SECURITY, "Trying to resume the previous session.");
+    }
+    else
+    {
+        PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_set_session", res);
+        // The stored session is unusable: perform a full handshake
+        iowa_security_session_clear_resumption_data(securityS);
+    }
+
+    mbedtls_ssl_session_free(&session);
+}
+
 static void prv_connectionFailing(user_security_internal_t *internalsP, iowa_security_session_t securityS)
 {
     prv_mbedtlsDisconnect(internalsP, securityS);
+    // Do not try to resume a session the Server may have rejected
+    iowa_security_session_clear_resumption_data(securityS);
     iowa_security_session_set_step_delay(securityS, 0);
     iowa_security_session_set_state(securityS, SECURITY_STATE_CONNECTION_FAILED);
     iowa_security_session_generate_event(securityS, SECURITY_EVENT_DISCONNECTED);
@@ -656,7 +1123,6 @@ iowa_status_t iowa_user_security_create_client_session(iowa_security_session_t s
     user_security_internal_t *internalsP;
     int res;
     int transport;
-    uint8_t maxFragmentLengthCode;
 
     internalsP = (user_security_internal_t *)iowa_system_malloc(sizeof(user_security_internal_t));
     if (internalsP == NULL)
@@ -669,8 +1135,6 @@ iowa_status_t iowa_user_security_create_client_session(iowa_security_session_t s
     iowa_security_session_set_user_internals(securityS, internalsP);
 
     mbedtls_ssl_init(&internalsP->sslContext);
-    mbedtls_ssl_config_init(&internalsP->sslConfig);
-    mbedtls_ssl_cache_init(&internalsP->sslCache);
 
     switch (iowa_security_session_get_connection_type(securityS))
     {
@@ -681,128 +1145,17 @@ iowa_status_t iowa_user_security_create_client_session(iowa_security_session_t s
     default:
         transport = MBEDTLS_SSL_TRANSPORT_DATAGRAM;
     }
-    res = mbedtls_ssl_config_defaults(&internalsP->sslConfig,
-                                      MBEDTLS_SSL_IS_CLIENT,
-                                      transport,
-                                      MBEDTLS_SSL_PRESET_DEFAULT);
 
-    if (res != PRV_MBEDTLS_SUCCESSFUL)
+    // The configuration and the parsed credentials are shared with the other sessions to the same Server
+    internalsP->configP = prv_configGet(securityS, transport);
+    if (internalsP->configP == NULL)
     {
-        PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_config_defaults", res);
-        goto error;
-    }
-
-#if (IOWA_LOG_LEVEL == IOWA_LOG_LEVEL_TRACE)
-    // Debug levels for MbedTLS (from the doc):
-    // 0: No debug
-    // 1: Error
-    // 2: State change
-    // 3: Informational
-    // 4: Verbose
-    mbedtls_debug_set_threshold(4);
-    mbedtls_ssl_conf_dbg(&internalsP->sslConfig, prv_debug, NULL);
-#endif
-
-    // Set the random vector generator function to use
-    mbedtls_ssl_conf_rng(&internalsP->sslConfig, prv_mbedtlsRandomVectorGenerator, securityS);
-
-    // Set the Maximum Fragment Length extension
-    if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 512)
-    {
-        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_512;
-    }
-    else if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 1024)
-    {
-        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_1024;
-    }
-    else if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 2048)
-    {
-        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_2048;
-    }
-    else if (MBEDTLS_SSL_OUT_CONTENT_LEN <= 4096)
-    {
-        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
-    }
-    else
-    {
-        // Do not set the maximum fragment length
-        maxFragmentLengthCode = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
-    }
-
-    (void)mbedtls_ssl_conf_max_frag_len(&internalsP->sslConfig, maxFragmentLengthCode);
-
-
-    // Set up based on the security mode: here we support PSK and Certificate mode
-    switch (iowa_security_session_get_security_mode(securityS))
-    {
-    case IOWA_SEC_PRE_SHARED_KEY:
-    {
-        iowa_security_data_t securityData;
-        const char *uriP;
-
-        if (prv_addCiphersuites(internalsP, false, true) != IOWA_COAP_NO_ERROR)
-        {
-            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Failed to add the ciphersuites");
-            goto error;
-        }
-
-        memset(&securityData, 0, sizeof(iowa_security_data_t));
-        securityData.securityMode = IOWA_SEC_PRE_SHARED_KEY;
-
-        uriP = iowa_security_session_get_uri(securityS);
-        res = iowa_system_security_data((uint8_t *)uriP, strlen(uriP), IOWA_SEC_READ, &securityData, iowa_security_session_get_context_user_data(securityS));
-        if (res != IOWA_COAP_NO_ERROR)
-        {
-            IOWA_LOG_ERROR(IOWA_PART_SYSTEM, "No PSK key-identity pair found");
-            goto error;
-        }
-
-        // MbedTLS is already checking the PSK identity/key buffer. No need to do it here.
-        (void)mbedtls_ssl_conf_psk(&internalsP->sslConfig, securityData.protocol.pskData.privateKey, securityData.protocol.pskData.privateKeyLen,
-                                    securityData.protocol.pskData.identity, securityData.protocol.pskData.identityLen);
-
-        res = iowa_system_security_data((uint8_t *)uriP, strlen(uriP), IOWA_SEC_FREE, &securityData, iowa_security_session_get_context_user_data(securityS));
-        if (res != IOWA_COAP_NO_ERROR)
-        {
-            IOWA_LOG_ERROR(IOWA_PART_SYSTEM, "Failed to free the PSK key-identity pair");
-            goto error;
-        }
-
-        // Check previous 'mbedtls_ssl_conf_psk' res here since the security data is now free
-        if (res != PRV_MBEDTLS_SUCCESSFUL)
-        {
-            PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_conf_psk", res);
-            goto error;
-        }
-        break;
-    }
-
-#ifdef SECURITY_CERTIFICATE_SUPPORT
-    case IOWA_SEC_CERTIFICATE:
-    {
-        if (prv_addCiphersuites(internalsP, true, false) != IOWA_COAP_NO_ERROR)
-        {
-            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Failed to add the ciphersuites");
-            goto error;
-        }
-
-        if (prv_initCertificate(securityS) != IOWA_COAP_NO_ERROR)
-        {
-            IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Certificate configuration failed");
-            goto error;
-        }
-
-        break;
-    }
-#endif
-
-    default:
-        IOWA_LOG_ARG_ERROR(IOWA_PART_SECURITY, "Unhandled security mode: %d", iowa_security_session_get_security_mode(securityS));
+        IOWA_LOG_ERROR(IOWA_PART_SECURITY, "Failed to get the Mbed TLS configuration");
         goto error;
     }
 
     // Save config in context
-    res = mbedtls_ssl_setup(&internalsP->sslContext, &internalsP->sslConfig);
+    res = mbedtls_ssl_setup(&internalsP->sslContext, &internalsP->configP->sslConfig);
     if (res != PRV_MBEDTLS_SUCCESSFUL)
     {
         PRV_PRINT_MBEDTLS_ERROR("mbedtls_ssl_setup", res);
@@ -926,6 +1279,8 @@ iowa_status_t iowa_user_security_step(iowa_security_session_t securityS)
             return IOWA_COAP_412_PRECONDITION_FAILED;
         }
 
+        prv_loadSession(internalsP, securityS);
+
         res = prv_mbedtlsConnect(internalsP, securityS);
         if (res != IOWA_COAP_NO_ERROR)
         {
@@ -951,6 +1306,7 @@ iowa_status_t iowa_user_security_step(iowa_security_session_t securityS)
 
     case SECURITY_STATE_HANDSHAKE_DONE:
         IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Connected.");
+        prv_saveSession(internalsP, securityS);
         iowa_security_session_set_state(securityS, SECURITY_STATE_CONNECTED);
         iowa_security_session_generate_event(securityS, SECURITY_EVENT_CONNECTED);
         break;